@@ -96,11 +96,20 @@ pub fn build(b: *std.Build) void {
     const kernel_step = b.step("kernel-rv64", "Build Grain RISC-V kernel image");
     kernel_step.dependOn(&kernel_install.step);
 
+    // Basin Kernel build options.
+    // Why: Syscall counters compile out entirely unless asked for, like VM tracing.
+    const kernel_stats = b.option(bool, "kernel-stats", "Count syscalls, errors and latency histograms in the Basin kernel") orelse false;
+    const kernel_options = b.addOptions();
+    kernel_options.addOption(bool, "syscall_stats_enabled", kernel_stats);
+
     // Basin Kernel module (syscall interface and kernel structures).
     const basin_kernel_module = b.addModule("basin_kernel", .{
         .root_source_file = b.path("src/kernel/basin_kernel.zig"),
         .target = target,
         .optimize = optimize,
+        .imports = &.{
+            .{ .name = "kernel_options", .module = kernel_options.createModule() },
+        },
     });
 
     // RISC-V SBI module (platform runtime services).
@@ -111,6 +120,14 @@ pub fn build(b: *std.Build) void {
         .optimize = optimize,
     });
 
+    // RISC-V VM build options.
+    // Why: Tracing and profiling are compile-time selected so release builds carry no such code.
+    const vm_trace = b.option(bool, "vm-trace", "Record RISC-V VM events into the in-memory trace ring") orelse false;
+    const vm_profile = b.option(bool, "vm-profile", "Sample guest PCs, opcode counts and call stacks in the RISC-V VM") orelse false;
+    const vm_options = b.addOptions();
+    vm_options.addOption(bool, "trace_enabled", vm_trace);
+    vm_options.addOption(bool, "profile_enabled", vm_profile);
+
     // RISC-V VM module for kernel virtualization.
     const kernel_vm_module = b.addModule("kernel_vm", .{
         .root_source_file = b.path("src/kernel_vm/kernel_vm.zig"),
@@ -119,6 +136,17 @@ pub fn build(b: *std.Build) void {
         .imports = &.{
             .{ .name = "sbi", .module = sbi_module },
             .{ .name = "basin_kernel", .module = basin_kernel_module },
+            .{ .name = "vm_options", .module = vm_options.createModule() },
+        },
+    });
+
+    // Reference decoder (test and benchmark only: the VM itself carries only the decode table).
+    const decode_reference_module = b.createModule(.{
+        .root_source_file = b.path("src/kernel_vm/decode_reference.zig"),
+        .target = target,
+        .optimize = optimize,
+        .imports = &.{
+            .{ .name = "kernel_vm", .module = kernel_vm_module },
         },
     });
 
@@ -132,6 +160,7 @@ pub fn build(b: *std.Build) void {
             .imports = &.{
                 .{ .name = "kernel_vm", .module = kernel_vm_module },
                 .{ .name = "basin_kernel", .module = basin_kernel_module },
+                .{ .name = "decode_reference", .module = decode_reference_module },
             },
         }),
     });
@@ -328,6 +357,14 @@ pub fn build(b: *std.Build) void {
         }),
     });
 
+    const timer_wheel_tests = b.addTest(.{
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("src/kernel/timer_wheel.zig"),
+            .target = target,
+            .optimize = optimize,
+        }),
+    });
+
     const graindaemon_cli = b.addExecutable(.{
         .name = "graindaemon",
         .root_module = b.createModule(.{
@@ -460,6 +497,8 @@ pub fn build(b: *std.Build) void {
     test_step.dependOn(&run_riscv_tests.step);
     const run_outputs_tests = b.addRunArtifact(outputs_tests);
     test_step.dependOn(&run_outputs_tests.step);
+    const run_timer_wheel_tests = b.addRunArtifact(timer_wheel_tests);
+    test_step.dependOn(&run_timer_wheel_tests.step);
 
     const fuzz_004_tests = b.addTest(.{
         .root_module = b.createModule(.{
@@ -602,6 +641,144 @@ pub fn build(b: *std.Build) void {
     // Make hello-world-test depend on hello-world being built first.
     hello_world_tests_step.dependOn(&hello_world_install.step);
 
+    // Decoder dispatch microbenchmark (switch reference vs comptime table) on Hello World ELF.
+    const bench_dispatch_exe = b.addExecutable(.{
+        .name = "bench_dispatch",
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("tools/bench_dispatch.zig"),
+            .target = target,
+            .optimize = .ReleaseFast,
+            .imports = &.{
+                .{ .name = "kernel_vm", .module = kernel_vm_module },
+                .{ .name = "decode_reference", .module = decode_reference_module },
+            },
+        }),
+    });
+    const run_bench_dispatch = b.addRunArtifact(bench_dispatch_exe);
+    run_bench_dispatch.addArtifactArg(hello_world_exe);
+    const bench_dispatch_step = b.step("bench-dispatch", "Benchmark VM decoder dispatch (switch vs table)");
+    bench_dispatch_step.dependOn(&run_bench_dispatch.step);
+
+    // VM benchmark suite (guest workloads x engines, JSON on stdout for diffing across commits).
+    const bench_vm_exe = b.addExecutable(.{
+        .name = "bench_vm",
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("tools/bench_vm.zig"),
+            .target = target,
+            .optimize = .ReleaseFast,
+            .imports = &.{
+                .{ .name = "kernel_vm", .module = kernel_vm_module },
+            },
+        }),
+    });
+    const run_bench_vm = b.addRunArtifact(bench_vm_exe);
+    const bench_vm_step = b.step("bench-vm", "Benchmark VM workloads (MIPS, ns/instruction, syscall latency) as JSON");
+    bench_vm_step.dependOn(&run_bench_vm.step);
+
+    // Mapping-churn microbenchmark (map/unmap latency vs live mapping count).
+    const bench_map_exe = b.addExecutable(.{
+        .name = "bench_map",
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("tools/bench_map.zig"),
+            .target = target,
+            .optimize = .ReleaseFast,
+            .imports = &.{
+                .{ .name = "basin_kernel", .module = basin_kernel_module },
+            },
+        }),
+    });
+    const run_bench_map = b.addRunArtifact(bench_map_exe);
+    const bench_map_step = b.step("bench-map", "Benchmark kernel map/unmap churn against live mapping count");
+    bench_map_step.dependOn(&run_bench_map.step);
+
+    // Channel ping-pong benchmark (messages/s and round-trip latency, inline vs page transfer).
+    const bench_channel_exe = b.addExecutable(.{
+        .name = "bench_channel",
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("tools/bench_channel.zig"),
+            .target = target,
+            .optimize = .ReleaseFast,
+            .imports = &.{
+                .{ .name = "kernel_vm", .module = kernel_vm_module },
+                .{ .name = "basin_kernel", .module = basin_kernel_module },
+            },
+        }),
+    });
+    const run_bench_channel = b.addRunArtifact(bench_channel_exe);
+    const bench_channel_step = b.step("bench-channel", "Benchmark channel ping-pong (messages/s, round-trip latency)");
+    bench_channel_step.dependOn(&run_bench_channel.step);
+
+    // Scheduler benchmark (context-switch latency, timer-wheel cost per tick vs sleepers).
+    const bench_sched_exe = b.addExecutable(.{
+        .name = "bench_sched",
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("tools/bench_sched.zig"),
+            .target = target,
+            .optimize = .ReleaseFast,
+            .imports = &.{
+                .{ .name = "kernel_vm", .module = kernel_vm_module },
+                .{ .name = "basin_kernel", .module = basin_kernel_module },
+            },
+        }),
+    });
+    const run_bench_sched = b.addRunArtifact(bench_sched_exe);
+    const bench_sched_step = b.step("bench-sched", "Benchmark context switches and timer-wheel ticks");
+    bench_sched_step.dependOn(&run_bench_sched.step);
+
+    // io_ring benchmark (one ecall per syscall vs batched submission).
+    const bench_io_ring_exe = b.addExecutable(.{
+        .name = "bench_io_ring",
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("tools/bench_io_ring.zig"),
+            .target = target,
+            .optimize = .ReleaseFast,
+            .imports = &.{
+                .{ .name = "kernel_vm", .module = kernel_vm_module },
+                .{ .name = "basin_kernel", .module = basin_kernel_module },
+            },
+        }),
+    });
+    const run_bench_io_ring = b.addRunArtifact(bench_io_ring_exe);
+    const bench_io_ring_step = b.step("bench-io-ring", "Benchmark batched syscalls through an io_ring");
+    bench_io_ring_step.dependOn(&run_bench_io_ring.step);
+
+    // Parallel coverage-guided fuzz farm (VM + Basin kernel, interpreter vs JIT oracle).
+    // Why: ReleaseSafe keeps checked arithmetic and assertions (the crash oracle) at speed.
+    const fuzz_farm_exe = b.addExecutable(.{
+        .name = "fuzz_farm",
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("tools/fuzz_farm.zig"),
+            .target = target,
+            .optimize = .ReleaseSafe,
+            .imports = &.{
+                .{ .name = "kernel_vm", .module = kernel_vm_module },
+                .{ .name = "basin_kernel", .module = basin_kernel_module },
+            },
+        }),
+    });
+    const install_fuzz_farm = b.addInstallArtifact(fuzz_farm_exe, .{});
+    const run_fuzz_farm = b.addRunArtifact(fuzz_farm_exe);
+    if (b.args) |args| run_fuzz_farm.addArgs(args);
+    const fuzz_farm_step = b.step("fuzz-farm", "Fuzz VM + Basin kernel on every core (coverage-guided, minimizes crashes)");
+    fuzz_farm_step.dependOn(&install_fuzz_farm.step);
+    fuzz_farm_step.dependOn(&run_fuzz_farm.step);
+
+    // Fuzz farm smoke tests: minimizer with a deterministic oracle, interpreter vs JIT check.
+    const fuzz_farm_tests = b.addTest(.{
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("tools/fuzz_farm.zig"),
+            .target = target,
+            .optimize = optimize,
+            .imports = &.{
+                .{ .name = "kernel_vm", .module = kernel_vm_module },
+                .{ .name = "basin_kernel", .module = basin_kernel_module },
+            },
+        }),
+    });
+    const run_fuzz_farm_tests = b.addRunArtifact(fuzz_farm_tests);
+    const fuzz_farm_test_step = b.step("fuzz-farm-test", "Smoke-test the fuzz farm minimizer and engine oracle");
+    fuzz_farm_test_step.dependOn(&run_fuzz_farm_tests.step);
+
     // RISC-V Logo Display Program
     const riscv_logo_exe = b.addExecutable(.{
         .name = "riscv_logo",
@@ -0,0 +1,374 @@
+//! Address-space index for Basin kernel memory mappings.
+//!
+//! Live mappings are disjoint [start, end) spans; unmapped space is a set of disjoint free
+//! ranges, coalesced with their neighbours on unmap. Both sets live in array-backed treaps
+//! ordered by start, so lookups, inserts and removes are O(log n) expected and never shift
+//! arrays. Each free-range node also records the longest range in its subtree, so
+//! kernel-chosen mappings find the lowest range that fits (first fit) in O(log n) as well.
+
+const std = @import("std");
+
+/// No node (empty subtree).
+const NIL: u32 = std.math.maxInt(u32);
+
+/// Index of at most capacity mappings in [base, 2^64).
+/// Grain Style: Static allocation (capacity is comptime), array-backed nodes.
+/// Contract: Ranges are page-aligned; callers check them against guest memory size.
+/// Note: Free ranges never exceed mappings + 1, so capacity + 1 free-range nodes suffice.
+pub fn AddressSpace(comptime capacity: u32, comptime base: u64) type {
+    comptime {
+        std.debug.assert(capacity > 0);
+        std.debug.assert(base % 4096 == 0);
+    }
+    const END: u64 = std.math.maxInt(u64);
+    const Holes = RangeTree(capacity + 1);
+
+    return struct {
+        /// Live mappings (node slot: the caller's table slot).
+        spans: RangeTree(capacity) = .{},
+        /// Free ranges; adjacent ranges are always coalesced.
+        holes: Holes = Holes.single(base, END),
+
+        const Self = @This();
+
+        /// Number of live mappings.
+        pub fn count(self: *const Self) u32 {
+            return self.spans.count();
+        }
+
+        /// Slot of the mapping starting exactly at start.
+        pub fn find(self: *const Self, start: u64) ?u32 {
+            const at = self.spans.floor(start);
+            if (at != NIL and self.spans.nodes[at].start == start) return self.spans.nodes[at].slot;
+            return null;
+        }
+
+        /// Slot of the mapping containing addr.
+        /// Why: Permission lookups by arbitrary guest address.
+        pub fn containing(self: *const Self, addr: u64) ?u32 {
+            const at = self.spans.floor(addr);
+            if (at != NIL and self.spans.nodes[at].end > addr) return self.spans.nodes[at].slot;
+            return null;
+        }
+
+        /// Whether [start, end) intersects any mapping.
+        pub fn overlaps(self: *const Self, start: u64, end: u64) bool {
+            std.debug.assert(start < end);
+            // Spans are disjoint: only the last one starting below end can reach start.
+            const at = self.spans.floor(end - 1);
+            return at != NIL and self.spans.nodes[at].end > start;
+        }
+
+        /// Lowest free address with size bytes free below limit (first fit).
+        /// Returns: null if no free range is large enough.
+        /// Note: Every range before the leftmost one of length >= size is too short even
+        /// untruncated, and at most one range crosses limit, so one descent decides.
+        pub fn find_free(self: *const Self, size: u64, limit: u64) ?u64 {
+            std.debug.assert(size > 0);
+            const at = self.holes.first_fit(size);
+            if (at == NIL) return null;
+            const hole = self.holes.nodes[at];
+            if (hole.start >= limit or @min(hole.end, limit) - hole.start < size) return null;
+            return hole.start;
+        }
+
+        /// Record mapping [start, end) for slot, carving it out of its free range.
+        /// Contract: the range is free (overlaps() is false), start >= base, table not full.
+        pub fn insert(self: *Self, start: u64, end: u64, slot: u32) void {
+            std.debug.assert(start >= base and start < end);
+            std.debug.assert(self.spans.count() < capacity);
+            std.debug.assert(!self.overlaps(start, end));
+
+            self.spans.insert(start, end, slot);
+
+            // The free range holding [start, end) shrinks, vanishes or splits in two.
+            const at = self.holes.floor(start);
+            std.debug.assert(at != NIL);
+            const hole = self.holes.nodes[at];
+            std.debug.assert(hole.start <= start and end <= hole.end);
+            if (hole.start == start and hole.end == end) {
+                self.holes.remove(hole.start);
+            } else if (hole.start == start) {
+                self.holes.resize(hole.start, end, hole.end);
+            } else if (hole.end == end) {
+                self.holes.resize(hole.start, hole.start, start);
+            } else {
+                self.holes.resize(hole.start, hole.start, start);
+                self.holes.insert(end, hole.end, 0);
+            }
+
+            // Assert: the mapping must be findable and no longer free.
+            std.debug.assert(self.find(start) == slot);
+            std.debug.assert(self.holes.count() <= self.spans.count() + 1);
+        }
+
+        /// Remove the mapping starting at start, returning its range to the free list.
+        /// Returns: The mapping's slot, or null if no mapping starts at start.
+        pub fn remove(self: *Self, start: u64) ?u32 {
+            const at = self.spans.floor(start);
+            if (at == NIL or self.spans.nodes[at].start != start) return null;
+            const span = self.spans.nodes[at];
+            self.spans.remove(start);
+
+            // Coalesce with the free ranges directly below and above.
+            const prev = self.holes.floor(span.start);
+            const next = self.holes.ceil(span.end);
+            const joins_prev = prev != NIL and self.holes.nodes[prev].end == span.start;
+            const joins_next = next != NIL and self.holes.nodes[next].start == span.end;
+            if (joins_prev and joins_next) {
+                const below = self.holes.nodes[prev];
+                const above = self.holes.nodes[next];
+                self.holes.remove(above.start);
+                self.holes.resize(below.start, below.start, above.end);
+            } else if (joins_prev) {
+                const below = self.holes.nodes[prev];
+                self.holes.resize(below.start, below.start, span.end);
+            } else if (joins_next) {
+                const above = self.holes.nodes[next];
+                self.holes.resize(above.start, span.start, above.end);
+            } else {
+                self.holes.insert(span.start, span.end, 0);
+            }
+
+            // Assert: the range must be free again.
+            std.debug.assert(self.find(start) == null);
+            std.debug.assert(self.holes.count() <= self.spans.count() + 1);
+            return span.slot;
+        }
+    };
+}
+
+/// Treap of at most capacity disjoint ranges ordered by start, nodes in a fixed array.
+/// Why: Sorted arrays made every insert and remove shift up to capacity entries.
+/// Grain Style: Static allocation; node indices come from a free stack in O(1).
+/// Note: Priorities are a fixed hash of the node index, so layouts are reproducible.
+fn RangeTree(comptime capacity: u32) type {
+    comptime {
+        std.debug.assert(capacity > 0);
+        std.debug.assert(capacity < NIL);
+    }
+
+    return struct {
+        nodes: [capacity]Node = undefined,
+        /// Stack of free node indices (top at free_count - 1, lowest index on top).
+        free: [capacity]u32 = initial_free(),
+        free_count: u32 = capacity,
+        root: u32 = NIL,
+
+        const Self = @This();
+
+        const Node = struct {
+            start: u64,
+            end: u64,
+            slot: u32,
+            priority: u32,
+            left: u32,
+            right: u32,
+            /// Longest end - start in this subtree.
+            longest: u64,
+        };
+
+        fn initial_free() [capacity]u32 {
+            @setEvalBranchQuota(capacity * 4 + 1000);
+            var free: [capacity]u32 = undefined;
+            for (&free, 0..) |*slot, i| {
+                slot.* = capacity - 1 - @as(u32, @intCast(i));
+            }
+            return free;
+        }
+
+        /// Tree holding only [start, end) (usable as a comptime default).
+        fn single(start: u64, end: u64) Self {
+            var tree = Self{};
+            tree.insert(start, end, 0);
+            return tree;
+        }
+
+        fn count(self: *const Self) u32 {
+            return capacity - self.free_count;
+        }
+
+        /// Node with the greatest start <= key (NIL if none).
+        fn floor(self: *const Self, key: u64) u32 {
+            var best: u32 = NIL;
+            var at = self.root;
+            while (at != NIL) {
+                if (self.nodes[at].start <= key) {
+                    best = at;
+                    at = self.nodes[at].right;
+                } else {
+                    at = self.nodes[at].left;
+                }
+            }
+            return best;
+        }
+
+        /// Node with the least start >= key (NIL if none).
+        fn ceil(self: *const Self, key: u64) u32 {
+            var best: u32 = NIL;
+            var at = self.root;
+            while (at != NIL) {
+                if (self.nodes[at].start >= key) {
+                    best = at;
+                    at = self.nodes[at].left;
+                } else {
+                    at = self.nodes[at].right;
+                }
+            }
+            return best;
+        }
+
+        /// Leftmost node with end - start >= size (NIL if none).
+        fn first_fit(self: *const Self, size: u64) u32 {
+            var at = self.root;
+            if (at == NIL or self.nodes[at].longest < size) return NIL;
+            while (true) {
+                const node = self.nodes[at];
+                if (node.left != NIL and self.nodes[node.left].longest >= size) {
+                    at = node.left;
+                } else if (node.end - node.start >= size) {
+                    return at;
+                } else {
+                    // Assert: the subtree's longest range must be on the right.
+                    std.debug.assert(node.right != NIL and self.nodes[node.right].longest >= size);
+                    at = node.right;
+                }
+            }
+        }
+
+        /// Add [start, end) with slot.
+        /// Contract: not full; start is not already a key.
+        fn insert(self: *Self, start: u64, end: u64, slot: u32) void {
+            std.debug.assert(self.free_count > 0);
+            std.debug.assert(start < end);
+            self.free_count -= 1;
+            const node = self.free[self.free_count];
+            self.nodes[node] = .{
+                .start = start,
+                .end = end,
+                .slot = slot,
+                .priority = priority_of(node),
+                .left = NIL,
+                .right = NIL,
+                .longest = end - start,
+            };
+            self.root = self.insert_at(self.root, node);
+        }
+
+        /// Remove the node starting at start.
+        /// Contract: such a node exists.
+        fn remove(self: *Self, start: u64) void {
+            const node = self.floor(start);
+            std.debug.assert(node != NIL and self.nodes[node].start == start);
+            std.debug.assert(self.free_count < capacity);
+            self.root = self.remove_at(self.root, start);
+            self.free[self.free_count] = node;
+            self.free_count += 1;
+        }
+
+        /// Change the node keyed key to [start, end).
+        /// Contract: the node exists and no other node's start lies between key and start.
+        fn resize(self: *Self, key: u64, start: u64, end: u64) void {
+            std.debug.assert(start < end);
+            self.resize_at(self.root, key, start, end);
+        }
+
+        fn insert_at(self: *Self, at: u32, node: u32) u32 {
+            if (at == NIL) return node;
+            if (self.nodes[node].start < self.nodes[at].start) {
+                const left = self.insert_at(self.nodes[at].left, node);
+                self.nodes[at].left = left;
+                if (self.nodes[left].priority > self.nodes[at].priority) return self.rotate_right(at);
+            } else {
+                std.debug.assert(self.nodes[node].start > self.nodes[at].start);
+                const right = self.insert_at(self.nodes[at].right, node);
+                self.nodes[at].right = right;
+                if (self.nodes[right].priority > self.nodes[at].priority) return self.rotate_left(at);
+            }
+            self.update(at);
+            return at;
+        }
+
+        fn remove_at(self: *Self, at: u32, start: u64) u32 {
+            std.debug.assert(at != NIL);
+            if (start < self.nodes[at].start) {
+                const left = self.remove_at(self.nodes[at].left, start);
+                self.nodes[at].left = left;
+            } else if (start > self.nodes[at].start) {
+                const right = self.remove_at(self.nodes[at].right, start);
+                self.nodes[at].right = right;
+            } else {
+                return self.merge(self.nodes[at].left, self.nodes[at].right);
+            }
+            self.update(at);
+            return at;
+        }
+
+        fn resize_at(self: *Self, at: u32, key: u64, start: u64, end: u64) void {
+            std.debug.assert(at != NIL);
+            if (key < self.nodes[at].start) {
+                self.resize_at(self.nodes[at].left, key, start, end);
+            } else if (key > self.nodes[at].start) {
+                self.resize_at(self.nodes[at].right, key, start, end);
+            } else {
+                self.nodes[at].start = start;
+                self.nodes[at].end = end;
+            }
+            self.update(at);
+        }
+
+        /// Join two subtrees whose keys are all ordered (every key of a below every key of b).
+        fn merge(self: *Self, a: u32, b: u32) u32 {
+            if (a == NIL) return b;
+            if (b == NIL) return a;
+            if (self.nodes[a].priority > self.nodes[b].priority) {
+                const right = self.merge(self.nodes[a].right, b);
+                self.nodes[a].right = right;
+                self.update(a);
+                return a;
+            }
+            const left = self.merge(a, self.nodes[b].left);
+            self.nodes[b].left = left;
+            self.update(b);
+            return b;
+        }
+
+        fn rotate_right(self: *Self, at: u32) u32 {
+            const left = self.nodes[at].left;
+            self.nodes[at].left = self.nodes[left].right;
+            self.nodes[left].right = at;
+            self.update(at);
+            self.update(left);
+            return left;
+        }
+
+        fn rotate_left(self: *Self, at: u32) u32 {
+            const right = self.nodes[at].right;
+            self.nodes[at].right = self.nodes[right].left;
+            self.nodes[right].left = at;
+            self.update(at);
+            self.update(right);
+            return right;
+        }
+
+        /// Recompute the subtree's longest range from its children.
+        fn update(self: *Self, at: u32) void {
+            const node = &self.nodes[at];
+            var longest = node.end - node.start;
+            if (node.left != NIL) longest = @max(longest, self.nodes[node.left].longest);
+            if (node.right != NIL) longest = @max(longest, self.nodes[node.right].longest);
+            node.longest = longest;
+        }
+
+        /// Fixed pseudo-random priority of a node index (murmur3 finalizer).
+        fn priority_of(node: u32) u32 {
+            var x = node +% 0x9E3779B9;
+            x ^= x >> 16;
+            x *%= 0x85EBCA6B;
+            x ^= x >> 13;
+            x *%= 0xC2B2AE35;
+            x ^= x >> 16;
+            return x;
+        }
+    };
+}
@@ -16,16 +16,23 @@
 //! **Development**: macOS Tahoe IDE with RISC-V VM for testing
 
 const std = @import("std");
+const SlotMap = @import("slot_map.zig").SlotMap;
+const AddressSpace = @import("address_space.zig").AddressSpace;
+pub const channel_ring = @import("channel.zig");
+pub const io_ring = @import("io_ring.zig");
+pub const time_page = @import("time_page.zig");
+pub const page_cache = @import("page_cache.zig");
+const PageCache = page_cache.PageCache;
+pub const scheduler = @import("scheduler.zig");
+const Context = scheduler.Context;
+const RunQueue = scheduler.RunQueue;
+pub const timer_wheel = @import("timer_wheel.zig");
+const TimerWheel = timer_wheel.TimerWheel;
+pub const syscall_stats = @import("syscall_stats.zig");
 
 /// Basin Kernel syscall numbers.
 /// Why: Explicit syscall enumeration for type safety and clarity.
 pub const Syscall = enum(u32) {
-    // Process & Thread Management
-    spawn = 1,
-    exit = 2,
-    yield = 3,
-    wait = 4,
-    
     // Memory Management
     map = 10,
     unmap = 11,
@@ -54,8 +61,27 @@ pub const Syscall = enum(u32) {
     
     // System Information
     sysinfo = 50,
+    
+    // Vectored I/O (scatter-gather read/write)
+    readv = 60,
+    writev = 61,
+    
+    // Batched I/O (submission/completion rings)
+    io_ring_setup = 62,
+    io_ring_enter = 63,
+    
+    // Process & Thread Management
+    // Note: Numbers below 10 are SBI extension IDs on the guest ECALL path, so process
+    // calls live above the other kernel syscalls where guests can reach them.
+    spawn = 70,
+    exit = 71,
+    yield = 72,
+    wait = 73,
 };
 
+/// Highest syscall number (handle_syscall rejects anything above).
+pub const SYSCALL_MAX: u32 = @intFromEnum(Syscall.wait);
+
 /// Memory mapping flags.
 /// Why: Explicit flags instead of POSIX-style bitmasks for type safety.
 pub const MapFlags = packed struct {
@@ -294,8 +320,38 @@ pub const SyscallResult = union(enum) {
     pub fn fail(err: BasinError) SyscallResult {
         return SyscallResult{ .err = err };
     }
+    
+    /// Guest ABI word for a syscall outcome (the a0 value, or an io_ring completion).
+    /// Why: RISC-V convention: non-negative = success value, negative = error code.
+    pub fn to_word(outcome: BasinError!SyscallResult) u64 {
+        const result = outcome catch |err| return @bitCast(error_code(err));
+        return switch (result) {
+            .success => |value| value,
+            .err => |err| @bitCast(error_code(err)),
+        };
+    }
 };
 
+/// Negative guest error code for err (-1 = invalid_handle, -2 = invalid_argument, ...).
+/// Note: Guests match on these values; append new errors, never renumber.
+pub fn error_code(err: BasinError) i64 {
+    return switch (err) {
+        BasinError.invalid_handle => -1,
+        BasinError.invalid_argument => -2,
+        BasinError.permission_denied => -3,
+        BasinError.not_found => -4,
+        BasinError.out_of_memory => -5,
+        BasinError.would_block => -6,
+        BasinError.interrupted => -7,
+        BasinError.invalid_syscall => -8,
+        BasinError.invalid_address => -9,
+        BasinError.unaligned_access => -10,
+        BasinError.out_of_bounds => -11,
+        BasinError.user_not_found => -12,
+        BasinError.invalid_user => -13,
+    };
+}
+
 /// Memory mapping entry.
 /// Why: Track memory mappings for map/unmap/protect syscalls.
 /// Grain Style: Static allocation, explicit state tracking.
@@ -306,6 +362,8 @@ const MemoryMapping = struct {
     size: u64,
     /// Mapping flags (permissions).
     flags: MapFlags,
+    /// Who holds the mapping (unmap/protect only apply to owned mappings).
+    state: MappingState,
     /// Whether this entry is allocated (in use).
     allocated: bool,
     
@@ -316,6 +374,7 @@ const MemoryMapping = struct {
             .address = 0,
             .size = 0,
             .flags = MapFlags.init(.{}),
+            .state = .owned,
             .allocated = false,
         };
     }
@@ -331,29 +390,125 @@ const MemoryMapping = struct {
     }
 };
 
+/// Memory mapping holder.
+/// Why: Channel and io rings and pages queued in a channel must not be unmapped under the kernel.
+const MappingState = enum(u8) {
+    /// Owned by the process (map/unmap/protect apply).
+    owned,
+    /// Backs a channel ring (pinned while the channel exists).
+    channel_ring,
+    /// Queued in a channel; ownership passes to whoever receives it.
+    in_transit,
+    /// Stack of a spawned process (pinned until the process exits).
+    process_stack,
+    /// Backs an io_ring (pinned while the ring exists).
+    io_ring,
+};
+
 /// Memory mapping table.
 /// Why: Track all memory mappings for kernel memory management.
 /// Grain Style: Static allocation, max 256 entries (sufficient for 4MB VM).
 const MAX_MAPPINGS: u32 = 256;
 
-/// File handle entry.
+/// Every mapping slot, lowest index on top of the free stack.
+fn initial_free_mappings() [MAX_MAPPINGS]u32 {
+    @setEvalBranchQuota(MAX_MAPPINGS * 4 + 1000);
+    var free: [MAX_MAPPINGS]u32 = undefined;
+    for (&free, 0..) |*slot, i| {
+        slot.* = MAX_MAPPINGS - 1 - @as(u32, @intCast(i));
+    }
+    return free;
+}
+
+/// Lowest user mapping address (kernel space is the first 1MB).
+const MAPPING_BASE: u64 = 0x100000;
+
+comptime {
+    // The shared time page is the last kernel-space page (never mapped by processes).
+    std.debug.assert(time_page.ADDRESS + time_page.PAGE_BYTES == MAPPING_BASE);
+}
+
+/// IPC channel entry.
+/// Why: Track channels for channel_create/send/recv syscalls.
+/// Grain Style: Static allocation; messages live in the channel's guest ring, not here.
+const Channel = struct {
+    /// Channel ID (non-zero if allocated).
+    id: u64,
+    /// Guest address of the ring (channel_ring.RING_BYTES, pinned mapping).
+    ring: u64,
+    /// Whether this entry is allocated (in use).
+    allocated: bool,
+    
+    /// Initialize empty channel entry.
+    /// Why: Explicit initialization, clear state.
+    pub fn init() Channel {
+        return Channel{
+            .id = 0,
+            .ring = 0,
+            .allocated = false,
+        };
+    }
+};
+
+/// Channel table.
+/// Why: Track all channels (each pins one ring mapping).
+/// Grain Style: Static allocation, max 16 entries.
+pub const MAX_CHANNELS: u32 = 16;
+
+/// Batched syscall ring entry.
+/// Why: Track rings for io_ring_setup/enter and kernel-side polling.
+/// Grain Style: Static allocation; entries live in the ring's guest pages, not here.
+const IoRing = struct {
+    /// Ring ID (non-zero if allocated).
+    id: u64,
+    /// Guest address of the ring (io_ring.RING_BYTES, pinned mapping).
+    ring: u64,
+    /// Drained at scheduling points as well as on io_ring_enter (io_ring.SETUP_POLL).
+    poll: bool,
+    /// Next submission to consume (authoritative; the guest's copy is only published).
+    sq_head: u32,
+    /// Next completion slot to fill (authoritative, like sq_head).
+    cq_tail: u32,
+    /// Whether this entry is allocated (in use).
+    allocated: bool,
+    
+    /// Initialize empty ring entry.
+    /// Why: Explicit initialization, clear state.
+    pub fn init() IoRing {
+        return IoRing{
+            .id = 0,
+            .ring = 0,
+            .poll = false,
+            .sq_head = 0,
+            .cq_tail = 0,
+            .allocated = false,
+        };
+    }
+};
+
+/// Batched syscall ring table.
+/// Why: Track all io_rings (each pins one ring mapping).
+/// Grain Style: Static allocation, max 8 entries.
+pub const MAX_IO_RINGS: u32 = 8;
+
+/// Guest time between kernel drains of polled io_rings.
+/// Why: Short enough that a polling guest sees completions without an ecall, long
+/// enough that idle rings cost little.
+pub const IO_POLL_INTERVAL: u64 = 4096;
+
+/// File handle entry: a cursor onto an inode.
 /// Why: Track file handles for open/read/write/close syscalls.
-/// Grain Style: Static allocation, explicit state tracking.
+/// Grain Style: Static allocation, explicit state tracking; file data lives in the
+/// shared page cache, so handles on one path see each other's writes.
 const FileHandle = struct {
     /// Handle ID (non-zero if allocated).
     id: u64,
-    /// File path (null-terminated, max 256 bytes).
-    path: [256]u8,
-    /// Path length (bytes, excluding null terminator).
-    path_len: u32,
+    /// Inode slot this handle reads and writes (valid while allocated).
+    inode: u32,
     /// Open flags (permissions).
     flags: OpenFlags,
     /// Current read/write position (bytes from start).
     position: u64,
-    /// File buffer (in-memory file data, max 64KB).
-    buffer: [64 * 1024]u8,
-    /// Buffer size (actual data length, bytes).
-    buffer_size: u32,
     /// Whether this entry is allocated (in use).
     allocated: bool,
     
@@ -362,17 +517,66 @@ const FileHandle = struct {
     pub fn init() FileHandle {
         return FileHandle{
             .id = 0,
-            .path = [_]u8{0} ** 256,
-            .path_len = 0,
+            .inode = 0,
             .flags = OpenFlags.init(.{}),
             .position = 0,
-            .buffer = [_]u8{0} ** (64 * 1024),
-            .buffer_size = 0,
             .allocated = false,
         };
     }
 };
 
+/// File inode: name and size (data pages live in the shared page cache).
+/// Why: Handles on the same path share one inode, so reads are coherent across handles.
+/// Grain Style: Static allocation, explicit state tracking.
+const Inode = struct {
+    /// Inode ID (non-zero if allocated).
+    id: u64,
+    /// File path (max 255 bytes).
+    path: [256]u8,
+    /// Path length (bytes).
+    path_len: u32,
+    /// File size (bytes).
+    size: u64,
+    /// Open file handles on this inode.
+    open_count: u32,
+    /// Whether a path names this inode (false after unlink; freed at last close).
+    linked: bool,
+    /// Whether this entry is allocated (in use).
+    allocated: bool,
+    
+    /// Initialize empty inode entry.
+    /// Why: Explicit initialization, clear state.
+    pub fn init() Inode {
+        return Inode{
+            .id = 0,
+            .path = [_]u8{0} ** 256,
+            .path_len = 0,
+            .size = 0,
+            .open_count = 0,
+            .linked = false,
+            .allocated = false,
+        };
+    }
+    
+    fn name(self: *const Inode) []const u8 {
+        return self.path[0..self.path_len];
+    }
+};
+
+/// Inode table.
+/// Why: Track every file (open or not) by path.
+/// Grain Style: Static allocation, max 256 entries.
+pub const MAX_INODES: u32 = 256;
+
+/// Page cache capacity (4KB pages shared by all files: 4MB).
+/// Why: Replaces a private 64KB buffer per handle (4MB for 64 handles) at the same static
+/// size, so file data without a backing store still fits as much as before; the runtime
+/// budget (page_cache.set_budget) may lower it, a backing store lets files exceed it.
+pub const PAGE_CACHE_PAGES: u32 = 1024;
+
+/// Largest file size (page indices are u32).
+pub const MAX_FILE_SIZE: u64 = @as(u64, std.math.maxInt(u32)) * page_cache.PAGE_SIZE;
+
 /// Directory handle entry.
 /// Why: Track directory handles for opendir/readdir/closedir syscalls.
 /// Grain Style: Static allocation, explicit state tracking.
@@ -403,21 +607,31 @@ const DirectoryHandle = struct {
 
 /// File handle table.
 /// Why: Track all file handles for kernel file system management.
-/// Grain Style: Static allocation, max 64 entries.
-const MAX_HANDLES: u32 = 64;
+/// Grain Style: Static allocation, max 64 entries (SlotMap capacity: raising it
+/// costs memory, not lookup time).
+pub const MAX_HANDLES: u32 = 64;
 
 /// Directory handle table.
 /// Why: Track all directory handles for kernel directory operations.
-/// Grain Style: Static allocation, max 32 entries.
-const MAX_DIR_HANDLES: u32 = 32;
+/// Grain Style: Static allocation, max 32 entries (SlotMap capacity).
+pub const MAX_DIR_HANDLES: u32 = 32;
 
 /// Process state enumeration.
 /// Why: Explicit process states for type safety.
 pub const ProcessState = enum(u8) {
-    /// Process is running (active).
+    /// Process is on the CPU.
     running,
+    /// Process is in the run queue.
+    ready,
+    /// Process is in sleep_until (armed in the timer wheel).
+    sleeping,
+    /// Process is in wait for another process to exit.
+    blocked,
     /// Process has exited (terminated).
     exited,
+    /// Process has exited and a waiter collected its status while it was still on the
+    /// CPU; the next scheduling point releases it once it is switched out.
+    zombie,
     /// Process slot is free (not allocated).
     free,
 };
@@ -428,14 +642,22 @@ pub const ProcessState = enum(u8) {
 const Process = struct {
     /// Process ID (non-zero if allocated).
     id: u64,
-    /// Process state (running, exited, free).
+    /// Process state (running, ready, sleeping, blocked, exited, free).
     state: ProcessState,
     /// Exit status (valid only when state == exited).
     exit_status: u32,
-    /// Executable pointer (for tracking, not used for execution yet).
+    /// Executable pointer (ELF image already loaded in guest RAM).
     executable_ptr: u64,
     /// Executable length (bytes).
     executable_len: u64,
+    /// Run-queue priority (0 is the most urgent).
+    priority: u8,
+    /// Saved registers (valid while the process is off the CPU).
+    context: Context,
+    /// Stack mapping (0: none, e.g. the boot process).
+    stack: u64,
+    /// Process ID waited for (valid only when state == blocked).
+    waiting_for: u64,
     /// Whether this entry is allocated (in use).
     allocated: bool,
     
@@ -448,15 +670,50 @@ const Process = struct {
             .exit_status = 0,
             .executable_ptr = 0,
             .executable_len = 0,
+            .priority = scheduler.DEFAULT_PRIORITY,
+            .context = .{},
+            .stack = 0,
+            .waiting_for = 0,
             .allocated = false,
         };
     }
+    
+    /// Reset a freshly allocated entry (keeps the slot map's id and allocated fields).
+    fn reset(self: *Process) void {
+        std.debug.assert(self.allocated);
+        const id = self.id;
+        self.* = Process.init();
+        self.id = id;
+        self.allocated = true;
+    }
 };
 
 /// Process table.
 /// Why: Track all processes for kernel process management.
-/// Grain Style: Static allocation, max 16 entries.
-const MAX_PROCESSES: u32 = 16;
+/// Grain Style: Static allocation, max 16 entries (SlotMap capacity).
+pub const MAX_PROCESSES: u32 = 16;
+
+/// Guest time (mtime ticks: one per instruction) a process runs before another process
+/// of its priority gets the CPU.
+pub const TIME_SLICE: u64 = 10_000;
+
+/// Guest time per timer-wheel tick, log2 (sleep_until wakes on the first tick at or
+/// after its deadline).
+pub const TIMER_TICK_SHIFT: u6 = 8;
+
+/// Stack mapped for each spawned process (sp starts at its top).
+pub const PROCESS_STACK_BYTES: u64 = 16 * 1024;
+
+/// No process on the CPU (none adopted yet, or idle).
+const NO_PROCESS: u32 = std.math.maxInt(u32);
+
+/// Guest timebase frequency when the host does not say (the VM's 10MHz mtime).
+pub const DEFAULT_TICKS_PER_SECOND: u64 = 10_000_000;
+
+/// Guest seconds between load average samples (as Linux: 5s, decay 1884/2048 per sample).
+const LOAD_SAMPLE_SECONDS: u64 = 5;
+const LOAD_DECAY: u64 = 1884;
+const LOAD_FIXED_ONE: u64 = 2048;
 
 // Compile-time assertions for handle table size.
 comptime {
@@ -472,42 +729,156 @@ comptime {
 /// Grain Style: Static array, max 256 users
 const MAX_USERS: u32 = 256;
 
+/// Default guest RAM size for syscall pointer validation (matches kernel_vm default).
+pub const DEFAULT_USER_MEMORY_SIZE: u64 = 4 * 1024 * 1024;
+
+/// Most bytes one read/write/readv/writev call moves.
+pub const MAX_IO_BYTES: u64 = 1024 * 1024;
+
+/// Most iovec entries one readv/writev call accepts.
+pub const MAX_IOVECS: u32 = 64;
+
+/// Scatter-gather entry for readv/writev.
+/// Why: One ecall moves many user buffers (guest layout: base u64, len u64, little-endian).
+pub const IoVec = extern struct {
+    base: u64,
+    len: u64,
+};
+
+/// Guest RAM as the kernel sees it (read/write copy through it).
+/// Why: The host owns guest RAM and must hear about every kernel store (dirty pages
+/// for snapshots, cached decodes, record/replay); stores are reported via on_write.
+/// Grain Style: Explicit callback, no host types in the kernel.
+pub const UserMemory = struct {
+    /// Guest RAM (bytes.len is the guest RAM size).
+    bytes: []u8,
+    /// Host context passed to on_write (e.g. the VM).
+    context: ?*anyopaque = null,
+    /// Called after the kernel stored len bytes at guest address addr.
+    on_write: ?*const fn (context: ?*anyopaque, addr: u64, len: u64) void = null,
+};
+
+/// Guest clock the scheduler reads (the guest's mtime, not host time).
+/// Why: sleep_until deadlines and time slices are guest time, so runs stay deterministic.
+pub const GuestClock = struct {
+    /// Host context passed to now (e.g. the VM).
+    context: ?*anyopaque = null,
+    /// Current guest time.
+    now: *const fn (context: ?*anyopaque) u64,
+    /// Guest time units per second (clock_gettime and the time page convert with it).
+    ticks_per_second: u64 = DEFAULT_TICKS_PER_SECOND,
+};
+
+/// What the host runs after a scheduling point (see BasinKernel.schedule).
+pub const Dispatch = union(enum) {
+    /// Run the registers now in cpu.
+    run,
+    /// Nothing is ready: advance guest time to this value, then schedule again.
+    idle_until: u64,
+    /// No process can run again (all exited, or waiting with no sleeper left to wake).
+    halt,
+};
+
 pub const BasinKernel = struct {
     /// Memory mapping table (static allocation).
     /// Why: Track memory mappings for map/unmap/protect syscalls.
     /// Grain Style: Static allocation, max 256 entries.
     mappings: [MAX_MAPPINGS]MemoryMapping = [_]MemoryMapping{MemoryMapping.init()} ** MAX_MAPPINGS,
     
-    /// Next address for kernel-chosen allocations (simple allocator).
-    /// Why: Track allocation position for kernel-chosen addresses.
-    next_alloc_addr: u64 = 0x100000, // Start after kernel space (1MB)
+    /// Stack of unallocated mapping slots (top at free_mapping_count - 1).
+    /// Why: map takes a slot in O(1) instead of scanning the table.
+    free_mappings: [MAX_MAPPINGS]u32 = initial_free_mappings(),
+    free_mapping_count: u32 = MAX_MAPPINGS,
+    
+    /// Ordered index of live mappings plus the free ranges between them.
+    /// Why: O(log n) overlap and address lookups, inserts and removes; unmapped space is
+    /// coalesced and reused by kernel-chosen mappings (first fit, also O(log n)) instead
+    /// of a bump pointer that only grows.
+    address_space: AddressSpace(MAX_MAPPINGS, MAPPING_BASE) = .{},
+    
+    /// Channel table (static allocation).
+    /// Why: Track channels for channel_create/send/recv syscalls.
+    /// Grain Style: Static allocation, max 16 entries, generation-indexed IDs.
+    channels: SlotMap(Channel, MAX_CHANNELS) = .{},
+    
+    /// Batched syscall ring table (static allocation).
+    /// Why: Track rings for io_ring_setup/enter syscalls.
+    /// Grain Style: Static allocation, max 8 entries, generation-indexed IDs.
+    io_rings: SlotMap(IoRing, MAX_IO_RINGS) = .{},
+    
+    /// Rings set up with io_ring.SETUP_POLL.
+    io_ring_pollers: u32 = 0,
+    
+    /// Guest time polled rings are next drained by (see next_preemption).
+    io_poll_at: u64 = 0,
     
     /// File handle table (static allocation).
     /// Why: Track file handles for open/read/write/close syscalls.
-    /// Grain Style: Static allocation, max 64 entries.
-    handles: [MAX_HANDLES]FileHandle = [_]FileHandle{FileHandle.init()} ** MAX_HANDLES,
+    /// Grain Style: Static allocation, max 64 entries; IDs are generation-indexed
+    /// (see SlotMap), so lookups are O(1) and stale handles fail cheaply.
+    handles: SlotMap(FileHandle, MAX_HANDLES) = .{},
+    
+    /// Inode table (static allocation).
+    /// Why: Files outlive their handles; handles on one path share an inode.
+    /// Grain Style: Static allocation, max 256 entries, generation-indexed IDs.
+    inodes: SlotMap(Inode, MAX_INODES) = .{},
     
-    /// Next handle ID (simple allocator, starts at 1).
-    /// Why: Track handle ID allocation (1-based, 0 is invalid).
-    next_handle_id: u64 = 1,
+    /// Shared page cache holding every file's data (keyed by inode slot + 1).
+    /// Why: Files grow page by page instead of living in fixed per-handle buffers.
+    /// Note: Host may set page_cache.backing (write-back store) and page_cache budget.
+    page_cache: PageCache(PAGE_CACHE_PAGES) = .{},
     
     /// Directory handle table (static allocation).
     /// Why: Track directory handles for opendir/readdir/closedir syscalls.
-    /// Grain Style: Static allocation, max 32 entries.
-    dir_handles: [MAX_DIR_HANDLES]DirectoryHandle = [_]DirectoryHandle{DirectoryHandle.init()} ** MAX_DIR_HANDLES,
-    
-    /// Next directory handle ID (simple allocator, starts at 1).
-    /// Why: Track directory handle ID allocation (1-based, 0 is invalid).
-    next_dir_handle_id: u64 = 1,
+    /// Grain Style: Static allocation, max 32 entries, generation-indexed IDs.
+    dir_handles: SlotMap(DirectoryHandle, MAX_DIR_HANDLES) = .{},
     
     /// Process table (static allocation).
     /// Why: Track processes for spawn/wait/exit syscalls.
-    /// Grain Style: Static allocation, max 16 entries.
-    processes: [MAX_PROCESSES]Process = [_]Process{Process.init()} ** MAX_PROCESSES,
+    /// Grain Style: Static allocation, max 16 entries, generation-indexed IDs.
+    processes: SlotMap(Process, MAX_PROCESSES) = .{},
+    
+    /// Ready processes by priority (keyed by process slot).
+    run_queue: RunQueue(MAX_PROCESSES) = .{},
+    
+    /// Sleeping processes by wake tick (keyed by process slot).
+    /// Why: Wakeups cost O(1) per tick however many processes sleep.
+    sleepers: TimerWheel(MAX_PROCESSES) = .{},
+    
+    /// Slot of the process on the CPU (NO_PROCESS: none adopted yet, or idle).
+    /// Note: Stays set while a syscall blocks it, until the next schedule saves it.
+    current: u32 = NO_PROCESS,
+    
+    /// Guest time the current process's slice ends.
+    slice_end: u64 = 0,
+    
+    /// Current process gave up the CPU in a syscall (yield, sleep_until, wait, exit).
+    need_resched: bool = false,
+    
+    /// Guest clock (null: guest time stays 0).
+    /// Contract: Host sets this with attach_clock; snapshots copy the attachment.
+    clock: ?GuestClock = null,
+    
+    /// Realtime at guest time 0 (nanoseconds since the Unix epoch; see set_realtime).
+    /// Why: 0 by default, so guest-visible time stays deterministic unless the host opts in.
+    realtime_base_ns: u64 = 0,
+    
+    /// Bytes covered by live mappings (available memory on the time page).
+    mapped_bytes: u64 = 0,
+    
+    /// One-minute load average (runnable processes, scaled by 1000).
+    load_avg: u32 = 0,
+    
+    /// Guest time of the next load average sample.
+    load_sample_at: u64 = 0,
     
-    /// Next process ID (simple allocator, starts at 1).
-    /// Why: Track process ID allocation (1-based, 0 is invalid).
-    next_process_id: u64 = 1,
+    /// Time page contents last written to guest RAM (magic 0: not yet written).
+    /// Why: The page is rewritten only when a field changes, not at every scheduling point.
+    time_page_shadow: time_page.Page = std.mem.zeroes(time_page.Page),
+    
+    /// Per-syscall counters and latency histograms, indexed by syscall number.
+    /// Note: Zero-sized unless built with -Dkernel-stats=true.
+    syscall_stats: syscall_stats.Stats(SYSCALL_MAX + 1, MAX_PROCESSES) = .{},
     
     /// User table (static allocation).
     /// Why: Track users for permission checks and user management.
@@ -528,6 +899,16 @@ pub const BasinKernel = struct {
         .egid = 0,
     },
     
+    /// Guest RAM size user pointers are validated against.
+    /// Why: Match the host VM's runtime-sized RAM instead of a duplicated constant.
+    /// Contract: Host sets this from VM.memory_size before dispatching syscalls.
+    user_memory_size: u64 = DEFAULT_USER_MEMORY_SIZE,
+    
+    /// Guest RAM user buffers are copied through (null: pointers are validated, no bytes move).
+    /// Why: read/write/readv/writev move bytes between file pages and the guest.
+    /// Contract: Host sets this with attach_user_memory; snapshots copy the attachment.
+    user_memory: ?UserMemory = null,
+    
     /// Initialize Basin Kernel.
     /// Why: Explicit initialization, validate kernel state.
     pub fn init() BasinKernel {
@@ -541,17 +922,18 @@ pub const BasinKernel = struct {
             std.debug.assert(!mapping.allocated);
         }
         
-        // Assert: Next allocation address must be page-aligned.
-        std.debug.assert(kernel.next_alloc_addr % 4096 == 0);
+        // Assert: All user address space must be free initially.
+        std.debug.assert(kernel.address_space.count() == 0);
+        std.debug.assert(kernel.address_space.find_free(4096, kernel.user_memory_size) == MAPPING_BASE);
         
         // Assert: All handles must be unallocated initially.
-        for (kernel.handles) |handle| {
+        for (kernel.handles.entries) |handle| {
             std.debug.assert(!handle.allocated);
             std.debug.assert(handle.id == 0);
         }
-        
-        // Assert: Next handle ID must be non-zero (1-based).
-        std.debug.assert(kernel.next_handle_id != 0);
+        std.debug.assert(kernel.handles.count() == 0);
+        std.debug.assert(kernel.dir_handles.count() == 0);
+        std.debug.assert(kernel.processes.count() == 0);
         
         // Assert: Root user must exist.
         std.debug.assert(kernel.user_count >= 1);
@@ -560,6 +942,360 @@ pub const BasinKernel = struct {
         return kernel;
     }
     
+    /// Make self equal to source: every table, and only the file pages source has resident.
+    /// Why: Page cache storage is over 4MB, nearly all of BasinKernel; snapshot restores
+    /// (boot-once harnesses, one per fuzz case) must not copy the free pages each time.
+    pub fn copy_from(self: *BasinKernel, source: *const BasinKernel) void {
+        if (self == source) return;
+        inline for (std.meta.fields(BasinKernel)) |field| {
+            if (comptime std.mem.eql(u8, field.name, "page_cache")) {
+                self.page_cache.copy_from(&source.page_cache);
+            } else {
+                @field(self, field.name) = @field(source, field.name);
+            }
+        }
+    }
+    
+    /// Attach guest RAM: user pointers are validated against it and I/O copies through it.
+    /// Contract: memory.bytes stays mapped while attached.
+    pub fn attach_user_memory(self: *BasinKernel, memory: UserMemory) void {
+        std.debug.assert(memory.bytes.len > 0);
+        self.user_memory = memory;
+        self.user_memory_size = memory.bytes.len;
+        self.time_page_shadow = std.mem.zeroes(time_page.Page);
+        self.refresh_time_page();
+        
+        // Assert: pointer checks must follow the attached RAM.
+        std.debug.assert(self.user_memory_size == memory.bytes.len);
+    }
+    
+    /// Copy guest bytes at addr into dest (nothing moves without attached memory).
+    /// Contract: addr + dest.len was validated against user_memory_size.
+    fn copy_from_user(self: *const BasinKernel, addr: u64, dest: []u8) void {
+        const memory = self.user_memory orelse return;
+        std.debug.assert(addr <= memory.bytes.len and dest.len <= memory.bytes.len - addr);
+        @memcpy(dest, memory.bytes[@intCast(addr)..][0..dest.len]);
+    }
+    
+    /// Copy src into guest RAM at addr and report the store to the host.
+    /// Contract: addr + src.len was validated against user_memory_size.
+    fn copy_to_user(self: *BasinKernel, addr: u64, src: []const u8) void {
+        const memory = self.user_memory orelse return;
+        if (src.len == 0) return;
+        std.debug.assert(addr <= memory.bytes.len and src.len <= memory.bytes.len - addr);
+        @memcpy(memory.bytes[@intCast(addr)..][0..src.len], src);
+        if (memory.on_write) |on_write| on_write(memory.context, addr, src.len);
+        
+        // Assert: guest RAM must hold the copied bytes.
+        std.debug.assert(std.mem.eql(u8, memory.bytes[@intCast(addr)..][0..src.len], src));
+    }
+    
+    /// Little-endian integer at guest addr (0 without attached memory).
+    /// Contract: addr + @sizeOf(T) was validated against user_memory_size.
+    fn load_user_int(self: *const BasinKernel, comptime T: type, addr: u64) T {
+        var bytes = [_]u8{0} ** @sizeOf(T);
+        self.copy_from_user(addr, &bytes);
+        return std.mem.readInt(T, &bytes, .little);
+    }
+    
+    /// Store a little-endian integer at guest addr (reported like any kernel store).
+    /// Contract: addr + @sizeOf(T) was validated against user_memory_size.
+    fn store_user_int(self: *BasinKernel, comptime T: type, addr: u64, value: T) void {
+        var bytes: [@sizeOf(T)]u8 = undefined;
+        std.mem.writeInt(T, &bytes, value, .little);
+        self.copy_to_user(addr, &bytes);
+    }
+    
+    /// Attach the guest clock that sleep_until deadlines and time slices are measured on.
+    pub fn attach_clock(self: *BasinKernel, clock: GuestClock) void {
+        std.debug.assert(clock.ticks_per_second > 0 and clock.ticks_per_second <= std.time.ns_per_s);
+        self.clock = clock;
+        self.refresh_time_page();
+    }
+    
+    /// Current guest time (0 without an attached clock).
+    fn guest_time(self: *const BasinKernel) u64 {
+        const clock = self.clock orelse return 0;
+        return clock.now(clock.context);
+    }
+    
+    /// Guest time units per second.
+    fn ticks_per_second(self: *const BasinKernel) u64 {
+        const clock = self.clock orelse return DEFAULT_TICKS_PER_SECOND;
+        return clock.ticks_per_second;
+    }
+    
+    /// Nanoseconds since guest time 0 (the monotonic clock).
+    fn monotonic_ns(self: *const BasinKernel) u64 {
+        return time_page.ticks_to_ns(self.guest_time(), self.ticks_per_second());
+    }
+    
+    /// Set the realtime clock: realtime_ns is the wall-clock time now (ns since the epoch).
+    /// Why: The host decides whether guests see wall-clock time (default: epoch at boot).
+    pub fn set_realtime(self: *BasinKernel, realtime_ns: u64) void {
+        self.realtime_base_ns = realtime_ns -| self.monotonic_ns();
+        self.refresh_time_page();
+    }
+    
+    /// System information as of now.
+    pub fn system_info(self: *const BasinKernel) SysInfo {
+        return SysInfo{
+            .total_memory = self.user_memory_size,
+            .available_memory = (self.user_memory_size -| MAPPING_BASE) -| self.mapped_bytes,
+            .cpu_cores = 1,
+            .uptime_ns = self.monotonic_ns(),
+            .load_avg_1min = self.load_avg,
+        };
+    }
+    
+    /// Counters and histograms of syscall number syscall_num (all zeros when statistics
+    /// are compiled out).
+    /// Why: Host view for tests and the Tahoe UI; guests get the same record from sysinfo.
+    pub fn syscall_statistics(self: *const BasinKernel, syscall_num: u32) syscall_stats.Record {
+        std.debug.assert(syscall_num <= SYSCALL_MAX);
+        if (!syscall_stats.enabled) return std.mem.zeroes(syscall_stats.Record);
+        return self.syscall_stats.record(syscall_num).*;
+    }
+    
+    /// Counters of every syscall number past SYSCALL_MAX (all zeros when statistics are
+    /// compiled out).
+    pub fn out_of_range_syscall_statistics(self: *const BasinKernel) syscall_stats.Record {
+        if (!syscall_stats.enabled) return std.mem.zeroes(syscall_stats.Record);
+        return self.syscall_stats.out_of_range_record().*;
+    }
+    
+    /// Zero every syscall counter and histogram (no-op when statistics are compiled out).
+    pub fn clear_syscall_statistics(self: *BasinKernel) void {
+        if (syscall_stats.enabled) self.syscall_stats.clear();
+    }
+    
+    /// Format one line per syscall called so far: calls, errors, and the p50/p99 bucket
+    /// bounds of guest instructions and (sampled) host nanoseconds.
+    /// Note: On demand only; formatting never happens on the syscall path.
+    pub fn dump_syscall_stats(self: *const BasinKernel, writer: anytype) !void {
+        if (!syscall_stats.enabled) {
+            try writer.print("[syscall_stats] statistics disabled (build with -Dkernel-stats=true)\n", .{});
+            return;
+        }
+        const Record = syscall_stats.Record;
+        try writer.print("[syscall_stats] {s:<16} {s:>10} {s:>8} {s:>10} {s:>10} {s:>10} {s:>10}\n", .{
+            "syscall", "calls", "errors", "guest p50", "guest p99", "host p50", "host p99",
+        });
+        var syscall_num: u32 = 0;
+        while (syscall_num <= SYSCALL_MAX + 1) : (syscall_num += 1) {
+            const record = if (syscall_num <= SYSCALL_MAX) self.syscall_stats.record(syscall_num) else self.syscall_stats.out_of_range_record();
+            if (record.calls == 0) continue;
+            const name = if (syscall_num > SYSCALL_MAX) "(out of range)" else if (std.meta.intToEnum(Syscall, syscall_num)) |syscall| @tagName(syscall) else |_| "(invalid)";
+            try writer.print("[syscall_stats] {s:<16} {d:>10} {d:>8} {d:>10} {d:>10} {d:>10} {d:>10}\n", .{
+                name,
+                record.calls,
+                record.error_count(),
+                Record.percentile(&record.guest_instructions, 500),
+                Record.percentile(&record.guest_instructions, 990),
+                Record.percentile(&record.host_ns, 500),
+                Record.percentile(&record.host_ns, 990),
+            });
+        }
+    }
+    
+    /// Rewrite the shared time page if any field changed or the guest copy no longer
+    /// matches what the kernel last wrote (no-op without guest RAM).
+    /// Why: Guests read time and system info from the page instead of trapping.
+    /// Note: schedule does this at every scheduling point; hosts that change kernel
+    /// state between runs may call it directly.
+    pub fn refresh_time_page(self: *BasinKernel) void {
+        if (self.user_memory == null or self.user_memory_size < MAPPING_BASE) return;
+        const info = self.system_info();
+        var page = time_page.Page{
+            .magic = time_page.MAGIC,
+            .sequence = self.time_page_shadow.sequence,
+            .ticks_per_second = self.ticks_per_second(),
+            .realtime_base_ns = self.realtime_base_ns,
+            .total_memory = info.total_memory,
+            .available_memory = info.available_memory,
+            .cpu_cores = info.cpu_cores,
+            .load_avg_1min = info.load_avg_1min,
+        };
+        // Why: Guest stores or a host reload may overwrite the page behind the kernel's back;
+        // the shadow alone would never notice, so compare what readers actually see.
+        const published = self.user_memory.?.bytes[@intCast(time_page.ADDRESS)..][0..@sizeOf(time_page.Page)];
+        if (std.meta.eql(page, self.time_page_shadow) and std.mem.eql(u8, published, std.mem.asBytes(&self.time_page_shadow))) return;
+        
+        // Seqlock: odd while the fields change, even (and new) once they are consistent.
+        page.sequence +%= 1;
+        self.store_user_int(u32, time_page.ADDRESS + time_page.SEQUENCE_OFFSET, page.sequence);
+        self.copy_to_user(time_page.ADDRESS, std.mem.asBytes(&page));
+        page.sequence +%= 1;
+        self.store_user_int(u32, time_page.ADDRESS + time_page.SEQUENCE_OFFSET, page.sequence);
+        self.time_page_shadow = page;
+        
+        // Assert: readers must see a settled page.
+        std.debug.assert(page.sequence % 2 == 0);
+    }
+    
+    /// Fold the runnable count into the load average for each sample interval up to now.
+    fn sample_load(self: *BasinKernel, now: u64) void {
+        if (now < self.load_sample_at) return;
+        const interval = LOAD_SAMPLE_SECONDS * self.ticks_per_second();
+        const runnable: u64 = self.run_queue.count() + @intFromBool(self.current != NO_PROCESS);
+        // After 128 samples (over ten minutes) the old average has decayed to nothing.
+        const samples = @min((now - self.load_sample_at) / interval + 1, 128);
+        var load: u64 = self.load_avg;
+        var sample: u64 = 0;
+        while (sample < samples) : (sample += 1) {
+            load = (load * LOAD_DECAY + runnable * 1000 * (LOAD_FIXED_ONE - LOAD_DECAY)) / LOAD_FIXED_ONE;
+        }
+        self.load_avg = @intCast(load);
+        self.load_sample_at = now - (now - self.load_sample_at) % interval + interval;
+        
+        // Assert: the next sample must be in the future.
+        std.debug.assert(self.load_sample_at > now);
+    }
+    
+    /// Adopt the registers already on the CPU as a process (the boot process).
+    /// Why: The guest that booted is scheduled alongside the processes it spawns.
+    /// Contract: No process is on the CPU yet.
+    /// Returns: Its process ID; out_of_memory if the process table is full.
+    pub fn boot_process(self: *BasinKernel) BasinError!u64 {
+        std.debug.assert(self.current == NO_PROCESS);
+        const idx = self.processes.alloc() orelse {
+            return BasinError.out_of_memory;
+        };
+        const process = &self.processes.entries[idx];
+        process.reset();
+        if (syscall_stats.enabled) self.syscall_stats.forget(idx);
+        process.state = .running;
+        self.current = idx;
+        self.slice_end = self.guest_time() + TIME_SLICE;
+        
+        // Assert: the boot process must be on the CPU.
+        std.debug.assert(self.current_process() == process.id);
+        return process.id;
+    }
+    
+    /// ID of the process on the CPU (null: none adopted yet, or idle).
+    pub fn current_process(self: *const BasinKernel) ?u64 {
+        if (self.current == NO_PROCESS) return null;
+        return self.processes.entries[self.current].id;
+    }
+    
+    /// Scheduling point: wake due sleepers, then switch processes if the current one gave
+    /// up the CPU in a syscall, a more urgent process is ready, or its slice ran out while
+    /// another process of its priority is ready.
+    /// Contract: cpu holds the live guest registers (pc past any ECALL just handled); on
+    /// .run it holds the registers to resume. Hosts call this after every kernel syscall
+    /// and whenever guest time reaches next_preemption().
+    pub fn schedule(self: *BasinKernel, cpu: *Context) Dispatch {
+        const now = self.guest_time();
+        self.wake_sleepers(now);
+        self.sample_load(now);
+        self.refresh_time_page();
+        if (self.io_ring_pollers > 0) {
+            if (syscall_stats.enabled) self.syscall_stats.nest();
+            self.poll_io_rings();
+            if (syscall_stats.enabled) self.syscall_stats.unnest();
+            self.io_poll_at = now + IO_POLL_INTERVAL;
+        }
+        
+        if (self.current != NO_PROCESS) {
+            const process = &self.processes.entries[self.current];
+            if (process.state == .running and !self.need_resched and !self.should_preempt(process.priority, now)) {
+                // Nobody to hand the CPU to: the slice starts over.
+                if (now >= self.slice_end) self.slice_end = now + TIME_SLICE;
+                if (syscall_stats.enabled) self.syscall_stats.resumed(self.current, now);
+                return .run;
+            }
+            
+            // Current process leaves the CPU (exited ones are not resumed, or reaped).
+            if (process.state == .running) {
+                process.state = .ready;
+                self.run_queue.push(self.current, process.priority);
+            }
+            const outgoing = self.current;
+            self.current = NO_PROCESS;
+            self.need_resched = false;
+            switch (process.state) {
+                .ready, .sleeping, .blocked => process.context = cpu.*,
+                // Off the CPU for good: free what it ran on.
+                .exited => self.release_stack(process),
+                .zombie => self.release_process(outgoing),
+                .running, .free => {},
+            }
+        }
+        
+        const next = self.run_queue.pop() orelse {
+            const tick = self.sleepers.next_event() orelse return .halt;
+            const wake = tick <<| TIMER_TICK_SHIFT;
+            
+            // Assert: idling must move guest time forward.
+            std.debug.assert(wake > now);
+            return .{ .idle_until = wake };
+        };
+        const chosen = &self.processes.entries[next];
+        std.debug.assert(chosen.state == .ready);
+        chosen.state = .running;
+        cpu.* = chosen.context;
+        self.current = next;
+        self.slice_end = now + TIME_SLICE;
+        if (syscall_stats.enabled) self.syscall_stats.resumed(next, now);
+        
+        // Assert: the chosen process must be on the CPU.
+        std.debug.assert(self.current_process() == chosen.id);
+        return .run;
+    }
+    
+    /// Guest time of the next scheduling point the host must not run past.
+    /// Returns: null when the current process may run until its next syscall.
+    pub fn next_preemption(self: *const BasinKernel) ?u64 {
+        var deadline: ?u64 = if (self.run_queue.count() > 0) self.slice_end else null;
+        if (self.sleepers.next_event()) |tick| {
+            const wake = tick <<| TIMER_TICK_SHIFT;
+            deadline = if (deadline) |d| @min(d, wake) else wake;
+        }
+        if (self.io_ring_pollers > 0) {
+            deadline = if (deadline) |d| @min(d, self.io_poll_at) else self.io_poll_at;
+        }
+        return deadline;
+    }
+    
+    /// Whether a ready process should take the CPU from one at priority.
+    fn should_preempt(self: *const BasinKernel, priority: u8, now: u64) bool {
+        const best = self.run_queue.best_priority() orelse return false;
+        return best < priority or (best == priority and now >= self.slice_end);
+    }
+    
+    /// Move sleepers whose deadline is at or before now to the run queue.
+    fn wake_sleepers(self: *BasinKernel, now: u64) void {
+        self.sleepers.advance(now >> TIMER_TICK_SHIFT);
+        while (self.sleepers.pop_expired()) |idx| {
+            const process = &self.processes.entries[idx];
+            std.debug.assert(process.state == .sleeping);
+            process.state = .ready;
+            self.run_queue.push(idx, process.priority);
+        }
+    }
+    
+    /// Free an exited process's slot (its ID goes stale) and its stack.
+    /// Contract: the process is off the CPU.
+    fn release_process(self: *BasinKernel, idx: u32) void {
+        const process = &self.processes.entries[idx];
+        std.debug.assert(process.state == .exited or process.state == .zombie);
+        std.debug.assert(idx != self.current);
+        self.release_stack(process);
+        process.state = .free;
+        self.processes.free_slot(idx);
+    }
+    
+    /// Unpin and unmap a process's stack.
+    fn release_stack(self: *BasinKernel, process: *Process) void {
+        if (process.stack == 0) return;
+        const mapping_idx = self.find_mapping_by_address(process.stack).?;
+        std.debug.assert(self.mappings[mapping_idx].state == .process_stack);
+        self.mappings[mapping_idx].state = .owned;
+        _ = self.syscall_unmap(process.stack, 0, 0, 0) catch unreachable;
+        process.stack = 0;
+    }
+    
     /// Initialize default users.
     /// Why: Create root and xy users at kernel boot.
     /// Grain Style: Static allocation, explicit initialization.
@@ -642,42 +1378,39 @@ pub const BasinKernel = struct {
         std.debug.assert(self.current_user.uid == uid);
     }
     
-    /// Find free mapping entry.
-    /// Why: Allocate new mapping entry.
-    /// Returns: Index of free entry, or null if table full.
-    /// Grain Style: Comprehensive assertions for table state.
-    fn find_free_mapping(self: *BasinKernel) ?u32 {
-        // Assert: self pointer must be valid.
-        const self_ptr = @intFromPtr(self);
-        std.debug.assert(self_ptr != 0);
-        std.debug.assert(self_ptr % @alignOf(BasinKernel) == 0);
-        
-        var found_index: ?u32 = null;
-        var free_count: u32 = 0;
-        
-        for (self.mappings, 0..) |mapping, i| {
-            if (!mapping.allocated) {
-                free_count += 1;
-                if (found_index == null) {
-                    found_index = @as(u32, @intCast(i));
-                }
-                
-                // Note: For fuzz testing robustness, we don't assert unallocated mapping state here
-                // to avoid crashes if there's a bug. The actual validation happens at allocation/deallocation time.
-            } else {
-                // Note: For fuzz testing robustness, we don't assert allocated mapping state here
-                // to avoid crashes if there's a bug. The actual validation happens at allocation time.
-                // We just find free entries without validating their state.
-            }
-        }
+    /// Take an unallocated mapping slot (O(1): pops the free stack).
+    /// Returns: Index of the slot, or null if the table is full.
+    /// Note: The caller marks the slot allocated before anything else can fail.
+    fn alloc_mapping(self: *BasinKernel) ?u32 {
+        if (self.free_mapping_count == 0) return null;
+        self.free_mapping_count -= 1;
+        const index = self.free_mappings[self.free_mapping_count];
+        
+        // Assert: free stack must only hold unallocated slots.
+        std.debug.assert(index < MAX_MAPPINGS);
+        std.debug.assert(!self.mappings[index].allocated);
+        return index;
+    }
+    
+    /// Return an allocated mapping slot to the free stack and reset it.
+    fn free_mapping(self: *BasinKernel, index: u32) void {
+        std.debug.assert(index < MAX_MAPPINGS);
+        std.debug.assert(self.mappings[index].allocated);
+        std.debug.assert(self.free_mapping_count < MAX_MAPPINGS);
         
-        // Assert: Free count must be <= MAX_MAPPINGS.
-        std.debug.assert(free_count <= MAX_MAPPINGS);
+        const mapping = &self.mappings[index];
+        mapping.allocated = false;
+        mapping.address = 0;
+        mapping.size = 0;
+        mapping.flags = MapFlags.init(.{});
+        self.free_mappings[self.free_mapping_count] = index;
+        self.free_mapping_count += 1;
         
-        return found_index;
+        // Assert: live slots must match the address-space index.
+        std.debug.assert(MAX_MAPPINGS - self.free_mapping_count == self.address_space.count());
     }
     
-    /// Find mapping by address.
+    /// Find mapping by address (O(log n) via the address-space index).
     /// Why: Look up mapping for unmap/protect operations.
     /// Returns: Index of mapping, or null if not found.
     /// Grain Style: Comprehensive assertions for address validation.
@@ -690,30 +1423,33 @@ pub const BasinKernel = struct {
         // Assert: Address must be page-aligned.
         std.debug.assert(addr % 4096 == 0);
         
-        var found_index: ?u32 = null;
-        var match_count: u32 = 0;
+        const index = self.address_space.find(addr) orelse return null;
+        const mapping = self.mappings[index];
         
-        for (self.mappings, 0..) |mapping, i| {
-            if (mapping.allocated and mapping.address == addr) {
-                match_count += 1;
-                if (found_index == null) {
-                    found_index = @as(u32, @intCast(i));
-                }
-                
-                // Assert: Matching mapping must have valid state.
-                std.debug.assert(mapping.address == addr);
-                std.debug.assert(mapping.size >= 4096);
-                std.debug.assert(mapping.size % 4096 == 0);
-            }
-        }
+        // Assert: Matching mapping must have valid state.
+        std.debug.assert(mapping.allocated);
+        std.debug.assert(mapping.address == addr);
+        std.debug.assert(mapping.size >= 4096);
+        std.debug.assert(mapping.size % 4096 == 0);
         
-        // Assert: Address must be unique (no duplicate mappings).
-        std.debug.assert(match_count <= 1);
+        return index;
+    }
+    
+    /// Permissions of the mapping containing addr (O(log n)).
+    /// Why: Permission checks by arbitrary guest address, not just mapping starts.
+    /// Returns: The mapping's flags, or null if addr is not mapped.
+    pub fn mapping_flags_at(self: *const BasinKernel, addr: u64) ?MapFlags {
+        const index = self.address_space.containing(addr) orelse return null;
+        const mapping = self.mappings[index];
         
-        return found_index;
+        // Assert: Containing mapping must be live and cover addr.
+        std.debug.assert(mapping.allocated);
+        std.debug.assert(mapping.address <= addr and addr - mapping.address < mapping.size);
+        
+        return mapping.flags;
     }
     
-    /// Check if address range overlaps with any existing mapping.
+    /// Check if address range overlaps with any existing mapping (O(log n)).
     /// Why: Validate no overlapping mappings.
     /// Grain Style: Comprehensive assertions for overlap detection.
     fn check_overlap(self: *BasinKernel, addr: u64, size: u64) bool {
@@ -727,25 +1463,15 @@ pub const BasinKernel = struct {
         std.debug.assert(size >= 4096); // At least 1 page
         std.debug.assert(size % 4096 == 0); // Page-aligned
         
-        var overlap_count: u32 = 0;
-        
-        for (self.mappings) |mapping| {
-            if (mapping.overlaps(addr, size)) {
-                overlap_count += 1;
-                
-                // Assert: Overlapping mapping must be allocated.
-                std.debug.assert(mapping.allocated);
-                
-                // Assert: Overlap condition must be true.
-                const does_overlap = (mapping.address < addr + size) and (addr < mapping.address + mapping.size);
-                std.debug.assert(does_overlap);
-            }
-        }
+        const overlapping = self.address_space.overlaps(addr, addr + size);
         
-        // Assert: Overlap count must be consistent (0 or 1, no duplicates).
-        std.debug.assert(overlap_count <= 1);
+        // Assert: A mapping at addr itself must count as overlapping.
+        if (self.address_space.find(addr)) |index| {
+            std.debug.assert(overlapping);
+            std.debug.assert(self.mappings[index].overlaps(addr, size));
+        }
         
-        return overlap_count > 0;
+        return overlapping;
     }
     
     /// Count allocated mappings (for testing and validation).
@@ -757,16 +1483,8 @@ pub const BasinKernel = struct {
         std.debug.assert(self_ptr != 0);
         std.debug.assert(self_ptr % @alignOf(BasinKernel) == 0);
         
-        var count: u32 = 0;
-        
-        for (self.mappings) |mapping| {
-            if (mapping.allocated) {
-                // Note: For fuzz testing robustness, we don't assert mapping state here
-                // to avoid crashes if there's a bug. The actual validation happens at allocation time.
-                // We just count allocated mappings without validating their state.
-                count += 1;
-            }
-        }
+        // Note: O(1); the address-space index holds exactly the allocated mappings.
+        const count = self.address_space.count();
         
         // Note: For fuzz testing robustness, we don't assert count <= MAX_MAPPINGS here.
         // The test will validate the count.
@@ -774,29 +1492,22 @@ pub const BasinKernel = struct {
         return count;
     }
     
-    /// Find free handle entry.
+    /// Allocate a handle entry (O(1): pops the handle table's free list).
     /// Why: Allocate new handle entry.
-    /// Returns: Index of free entry, or null if table full.
+    /// Returns: Index of the entry (id and allocated already set), or null if table full.
     /// Grain Style: Comprehensive assertions for table state.
-    fn find_free_handle(self: *BasinKernel) ?u32 {
+    fn alloc_handle(self: *BasinKernel) ?u32 {
         // Assert: self pointer must be valid.
         const self_ptr = @intFromPtr(self);
         std.debug.assert(self_ptr != 0);
         std.debug.assert(self_ptr % @alignOf(BasinKernel) == 0);
         
-        for (self.handles, 0..) |handle, i| {
-            if (!handle.allocated) {
-                // Note: For fuzz testing robustness, we don't assert unallocated handle state here
-                // to avoid crashes if there's a bug. The actual validation happens at allocation/deallocation time.
-                return @as(u32, @intCast(i));
-            }
-        }
-        return null;
+        return self.handles.alloc();
     }
     
-    /// Find handle by ID.
+    /// Find handle by ID (O(1): the ID encodes its slot and generation).
     /// Why: Look up handle for read/write/close operations.
-    /// Returns: Index of handle, or null if not found.
+    /// Returns: Index of handle, or null if not found or stale (closed, slot reused).
     /// Grain Style: Comprehensive assertions for handle validation.
     fn find_handle_by_id(self: *BasinKernel, handle_id: u64) ?u32 {
         // Assert: self pointer must be valid.
@@ -807,46 +1518,128 @@ pub const BasinKernel = struct {
         // Assert: Handle ID must be non-zero (0 is invalid).
         std.debug.assert(handle_id != 0);
         
-        for (self.handles, 0..) |handle, i| {
-            if (handle.allocated and handle.id == handle_id) {
-                // Assert: Handle must be allocated and match ID.
-                std.debug.assert(handle.allocated);
-                std.debug.assert(handle.id == handle_id);
-                return @as(u32, @intCast(i));
+        const index = self.handles.find(handle_id) orelse return null;
+        
+        // Assert: Handle must be allocated and match ID.
+        std.debug.assert(self.handles.entries[index].allocated);
+        std.debug.assert(self.handles.entries[index].id == handle_id);
+        return index;
+    }
+    
+    /// Direction of a file transfer (guest RAM <-> file pages).
+    const Transfer = enum { read, write };
+    
+    /// Move up to len bytes between guest RAM at addr and the handle's file, page by page.
+    /// Why: read/write/readv/writev share one path through the page cache.
+    /// Contract: addr + len was validated against user_memory_size.
+    /// Returns: Bytes moved (short at end of file for read, or when the cache fills after
+    /// some bytes moved); out_of_memory if no page could be made resident before any
+    /// byte moved (budget full of dirty pages with no backing store to write them to).
+    fn file_transfer(self: *BasinKernel, file_handle: *FileHandle, addr: u64, len: u64, comptime direction: Transfer) BasinError!u64 {
+        const inode = &self.inodes.entries[file_handle.inode];
+        
+        // Assert: Handle must reference a live inode.
+        std.debug.assert(file_handle.allocated);
+        std.debug.assert(inode.allocated and inode.open_count > 0);
+        
+        const key = file_handle.inode + 1;
+        const end: u64 = switch (direction) {
+            .read => @min(inode.size, file_handle.position +| len),
+            .write => @min(MAX_FILE_SIZE, file_handle.position +| len),
+        };
+        var moved: u64 = 0;
+        while (file_handle.position < end) {
+            const page_index: u32 = @intCast(file_handle.position / page_cache.PAGE_SIZE);
+            const offset: usize = @intCast(file_handle.position % page_cache.PAGE_SIZE);
+            const count: usize = @intCast(@min(page_cache.PAGE_SIZE - offset, end - file_handle.position));
+            const page = self.page_cache.get(key, page_index, direction == .write) orelse {
+                // Why: Report progress like a short write; the next call gets the error.
+                if (moved == 0) return BasinError.out_of_memory;
+                break;
+            };
+            switch (direction) {
+                .read => self.copy_to_user(addr + moved, page[offset..][0..count]),
+                .write => self.copy_from_user(addr + moved, page[offset..][0..count]),
+            }
+            file_handle.position += count;
+            moved += count;
+        }
+        if (direction == .write and file_handle.position > inode.size) {
+            inode.size = file_handle.position;
+        }
+        
+        // Assert: Transfer must not exceed the request.
+        std.debug.assert(moved <= len);
+        std.debug.assert(inode.size <= MAX_FILE_SIZE);
+        return moved;
+    }
+    
+    /// Find the linked inode named path.
+    /// Returns: Inode slot index, or null if no file has that name.
+    /// Note: Linear scan of MAX_INODES names; open/unlink/rename are not per-byte paths.
+    fn find_inode(self: *const BasinKernel, path: []const u8) ?u32 {
+        std.debug.assert(path.len > 0 and path.len <= 255);
+        for (&self.inodes.entries, 0..) |*inode, i| {
+            if (inode.allocated and inode.linked and std.mem.eql(u8, inode.name(), path)) {
+                return @intCast(i);
             }
         }
         return null;
     }
     
+    /// Create an empty, linked inode named path.
+    /// Returns: Inode slot index, or null if the inode table is full.
+    fn create_inode(self: *BasinKernel, path: []const u8) ?u32 {
+        std.debug.assert(path.len > 0 and path.len <= 255);
+        const index = self.inodes.alloc() orelse return null;
+        const inode = &self.inodes.entries[index];
+        inode.path = [_]u8{0} ** 256;
+        @memcpy(inode.path[0..path.len], path);
+        inode.path_len = @intCast(path.len);
+        inode.size = 0;
+        inode.open_count = 0;
+        inode.linked = true;
+        
+        // Assert: New inode must be live and findable by name.
+        std.debug.assert(inode.allocated);
+        std.debug.assert(std.mem.eql(u8, inode.name(), path));
+        return index;
+    }
+    
+    /// Free an unlinked inode with no open handles, dropping its cached pages.
+    fn release_inode(self: *BasinKernel, index: u32) void {
+        const inode = &self.inodes.entries[index];
+        
+        // Assert: Only unreferenced, unlinked inodes may be freed.
+        std.debug.assert(inode.allocated);
+        std.debug.assert(!inode.linked and inode.open_count == 0);
+        
+        self.page_cache.discard(index + 1, 0);
+        inode.size = 0;
+        inode.path_len = 0;
+        self.inodes.free_slot(index);
+    }
+    
     /// Count allocated handles (for testing and validation).
     /// Why: Validate handle table state consistency.
-    /// Grain Style: Comprehensive assertions for state validation.
+    /// Note: O(1); the handle table tracks its live count.
     pub fn count_allocated_handles(self: *BasinKernel) u32 {
         // Assert: self pointer must be valid.
         const self_ptr = @intFromPtr(self);
         std.debug.assert(self_ptr != 0);
         std.debug.assert(self_ptr % @alignOf(BasinKernel) == 0);
         
-        var count: u32 = 0;
-        
-        for (self.handles) |handle| {
-            if (handle.allocated) {
-                // Note: For fuzz testing robustness, we don't assert handle state here
-                // to avoid crashes if there's a bug. The actual validation happens at allocation time.
-                // We just count allocated handles without validating their state.
-                count += 1;
-            }
-        }
-        
-        // Note: For fuzz testing robustness, we don't assert count <= MAX_HANDLES here.
-        // The test will validate the count.
+        const count = self.handles.count();
         
+        // Assert: Count must fit the table.
+        std.debug.assert(count <= MAX_HANDLES);
         return count;
     }
     
     /// Handle syscall from user space.
     /// Why: Central syscall entry point, validate syscall number and arguments.
-    /// Grain Style: Comprehensive assertions for all syscall parameters and state.
+    /// Note: Built with -Dkernel-stats=true, every call is counted and timed on the way
+    /// through (see syscall_stats.zig); otherwise this is dispatch_syscall.
     pub fn handle_syscall(
         self: *BasinKernel,
         syscall_num: u32,
@@ -854,32 +1647,45 @@ pub const BasinKernel = struct {
         arg2: u64,
         arg3: u64,
         arg4: u64,
+    ) BasinError!SyscallResult {
+        if (!syscall_stats.enabled) return self.dispatch_syscall(syscall_num, arg1, arg2, arg3, arg4);
+        
+        const call = self.syscall_stats.begin(self.guest_time());
+        const outcome = self.dispatch_syscall(syscall_num, arg1, arg2, arg3, arg4);
+        // Error slot i counts error code -(i + 1).
+        const error_slot: ?u32 = if (outcome) |result| switch (result) {
+            .success => null,
+            .err => |err| @intCast(-error_code(err) - 1),
+        } else |err| @intCast(-error_code(err) - 1);
+        const process: ?u32 = if (self.current != NO_PROCESS) self.current else null;
+        self.syscall_stats.end(call, syscall_num, error_slot, process, self.guest_time());
+        return outcome;
+    }
+    
+    /// Validate the syscall number and route to its handler.
+    /// Grain Style: Comprehensive assertions for all syscall parameters and state.
+    fn dispatch_syscall(
+        self: *BasinKernel,
+        syscall_num: u32,
+        arg1: u64,
+        arg2: u64,
+        arg3: u64,
+        arg4: u64,
     ) BasinError!SyscallResult {
         // Assert: self pointer must be valid.
         const self_ptr = @intFromPtr(self);
         std.debug.assert(self_ptr != 0);
         std.debug.assert(self_ptr % @alignOf(BasinKernel) == 0);
         
-        // Assert: syscall number must be >= 10 (kernel syscalls, not SBI).
-        // Why: SBI calls use function ID < 10, kernel syscalls use >= 10.
-        std.debug.assert(syscall_num >= 10);
-        
-        // Assert: syscall number must be within valid range.
-        std.debug.assert(syscall_num <= @intFromEnum(Syscall.sysinfo));
-        
         // Decode syscall number.
-        const syscall = @as(?Syscall, @enumFromInt(syscall_num)) orelse {
-            // Assert: Invalid syscall number must return error.
-            std.debug.assert(syscall_num < 10 or syscall_num > @intFromEnum(Syscall.sysinfo));
+        // Why: The number comes from guest a7; unknown numbers are an error, not a panic.
+        const syscall = std.meta.intToEnum(Syscall, syscall_num) catch {
             return BasinError.invalid_syscall;
         };
         
         // Assert: syscall must be valid enum value.
         std.debug.assert(@intFromEnum(syscall) == syscall_num);
         
-        // Assert: syscall must be kernel syscall (not SBI).
-        std.debug.assert(@intFromEnum(syscall) >= 10);
-        
         // Route to appropriate syscall handler.
         // Why: Explicit routing, type-safe syscall handling.
         return switch (syscall) {
@@ -906,46 +1712,62 @@ pub const BasinKernel = struct {
             .clock_gettime => self.syscall_clock_gettime(arg1, arg2, arg3, arg4),
             .sleep_until => self.syscall_sleep_until(arg1, arg2, arg3, arg4),
             .sysinfo => self.syscall_sysinfo(arg1, arg2, arg3, arg4),
+            .readv => self.syscall_readv(arg1, arg2, arg3, arg4),
+            .writev => self.syscall_writev(arg1, arg2, arg3, arg4),
+            .io_ring_setup => self.syscall_io_ring_setup(arg1, arg2, arg3, arg4),
+            .io_ring_enter => self.syscall_io_ring_enter(arg1, arg2, arg3, arg4),
         };
     }
     
     // Syscall handlers (stubs for future implementation).
     // Why: Separate functions for each syscall, Grain Style function length limit.
     
+    /// Create a ready process running the ELF image at executable.
+    /// Why: The image is already in guest RAM (single address space); the process gets
+    /// its own stack and registers and starts at the header's entry point.
+    /// Contract: priority is 0 (the caller's, or DEFAULT_PRIORITY from the host) or
+    /// 1..PRIORITY_LEVELS (1 most urgent). The process starts with a0 = args_ptr,
+    /// a1 = args_len, sp at the top of a PROCESS_STACK_BYTES mapping.
+    /// Returns: Process ID; out_of_memory if the process table or stack space is full;
+    /// invalid_argument if no guest RAM is attached or the entry point lies outside the
+    /// image's executable segments (see image_entry).
     fn syscall_spawn(
         self: *BasinKernel,
         executable: u64,
         args_ptr: u64,
         args_len: u64,
-        _arg4: u64,
+        priority: u64,
     ) BasinError!SyscallResult {
         // Assert: self pointer must be valid.
         const self_ptr = @intFromPtr(self);
         std.debug.assert(self_ptr != 0);
         std.debug.assert(self_ptr % @alignOf(BasinKernel) == 0);
         
-        _ = _arg4;
+        // Assert: the image lives in guest RAM (none attached: nothing to run).
+        if (self.user_memory == null) {
+            return BasinError.invalid_argument;
+        }
         
         // Assert: executable pointer must be valid (non-zero, within VM memory).
         if (executable == 0) {
             return BasinError.invalid_argument; // Null pointer
         }
         
-        const VM_MEMORY_SIZE: u64 = 4 * 1024 * 1024; // 4MB default (matches syscall_map)
-        if (executable >= VM_MEMORY_SIZE) {
+        const memory_size = self.user_memory_size;
+        if (executable >= memory_size) {
             return BasinError.invalid_argument; // Executable pointer exceeds VM memory
         }
         
         // Assert: executable must be at least ELF header size (64 bytes for ELF64).
         // Why: Minimum size for valid ELF executable header.
         const MIN_ELF_SIZE: u64 = 64;
-        if (executable + MIN_ELF_SIZE > VM_MEMORY_SIZE) {
+        if (executable + MIN_ELF_SIZE > memory_size) {
             return BasinError.invalid_argument; // Executable doesn't fit in VM memory
         }
         
         // Assert: args pointer must be valid (can be zero for no args, or valid pointer).
         if (args_ptr != 0) {
-            if (args_ptr >= VM_MEMORY_SIZE) {
+            if (args_ptr >= memory_size) {
                 return BasinError.invalid_argument; // Args pointer exceeds VM memory
             }
             
@@ -958,7 +1780,7 @@ pub const BasinKernel = struct {
             }
             
             // Assert: args must fit within VM memory.
-            if (args_ptr + args_len > VM_MEMORY_SIZE) {
+            if (args_ptr + args_len > memory_size) {
                 return BasinError.invalid_argument; // Args exceed VM memory
             }
         } else {
@@ -968,37 +1790,51 @@ pub const BasinKernel = struct {
             }
         }
         
-        // Find free process slot.
-        var slot: ?usize = null;
-        for (0..MAX_PROCESSES) |i| {
-            if (!self.processes[i].allocated) {
-                slot = i;
-                break;
-            }
-        }
-        
-        if (slot == null) {
-            return BasinError.out_of_memory; // No free process slots
+        // Assert: priority must be 0 (inherit) or a level 1..PRIORITY_LEVELS.
+        if (priority > scheduler.PRIORITY_LEVELS) {
+            return BasinError.invalid_argument;
         }
         
-        const idx = slot.?;
+        // Assert: image must be an ELF whose entry point is executable memory.
+        const entry = try self.image_entry(executable);
         
-        // Allocate process ID.
-        const process_id = self.next_process_id;
-        self.next_process_id += 1;
-        
-        // Create process entry.
-        self.processes[idx].id = process_id;
-        self.processes[idx].state = .running;
-        self.processes[idx].exit_status = 0;
-        self.processes[idx].executable_ptr = executable;
-        self.processes[idx].executable_len = MIN_ELF_SIZE; // Stub: use minimum size
-        self.processes[idx].allocated = true;
+        // Allocate process slot (ID encodes slot and generation).
+        const idx = self.processes.alloc() orelse {
+            return BasinError.out_of_memory; // No free process slots
+        };
+        const process = &self.processes.entries[idx];
+        const process_id = process.id;
+        process.reset();
+        if (syscall_stats.enabled) self.syscall_stats.forget(idx);
+        
+        const stack_flags = MapFlags.init(.{ .read = true, .write = true });
+        const stack = self.syscall_map(0, PROCESS_STACK_BYTES, @as(u32, @bitCast(stack_flags)), 0) catch |err| {
+            self.processes.free_slot(idx);
+            return err;
+        };
+        self.mappings[self.find_mapping_by_address(stack.success).?].state = .process_stack;
+        
+        // Create process entry and queue it.
+        process.state = .ready;
+        process.executable_ptr = executable;
+        process.executable_len = MIN_ELF_SIZE; // Stub: use minimum size
+        process.priority = if (priority != 0)
+            @intCast(priority - 1)
+        else if (self.current != NO_PROCESS)
+            self.processes.entries[self.current].priority
+        else
+            scheduler.DEFAULT_PRIORITY;
+        process.stack = stack.success;
+        process.context.pc = entry;
+        process.context.regs[2] = stack.success + PROCESS_STACK_BYTES; // sp
+        process.context.regs[10] = args_ptr; // a0
+        process.context.regs[11] = args_len; // a1
+        self.run_queue.push(idx, process.priority);
         
         // Assert: process must be allocated correctly.
-        std.debug.assert(self.processes[idx].allocated);
-        std.debug.assert(self.processes[idx].id == process_id);
-        std.debug.assert(self.processes[idx].state == .running);
+        std.debug.assert(process.allocated);
+        std.debug.assert(process.id == process_id);
+        std.debug.assert(process.state == .ready);
         
         // Return process ID.
         const result = SyscallResult.ok(process_id);
@@ -1013,6 +1849,68 @@ pub const BasinKernel = struct {
         return result;
     }
     
+    /// Entry point of the ELF image at executable, checked against its program headers.
+    /// Why: The header is guest data; a process must not start in memory the image does
+    /// not describe as code (or that a mapping without execute permission covers).
+    /// Contract: user memory is attached and holds executable..executable + 64.
+    /// Errors: invalid_argument for a missing ELF magic, a program header table outside
+    /// guest RAM, or an entry outside every executable PT_LOAD segment in guest RAM.
+    fn image_entry(self: *const BasinKernel, executable: u64) BasinError!u64 {
+        const ELF_MAGIC: u32 = 0x464C_457F; // "\x7fELF"
+        const PT_LOAD: u32 = 1;
+        const PF_X: u32 = 1;
+        const PHDR_SIZE: u16 = 56; // Elf64_Phdr
+        const MAX_SEGMENTS: u16 = 16;
+        const memory_size = self.user_memory_size;
+        std.debug.assert(self.user_memory != null);
+        std.debug.assert(executable < memory_size and memory_size - executable >= 64);
+        
+        if (self.load_user_int(u32, executable) != ELF_MAGIC) {
+            return BasinError.invalid_argument; // Not an ELF image
+        }
+        const entry = self.load_user_int(u64, executable + 24); // e_entry
+        const phoff = self.load_user_int(u64, executable + 32); // e_phoff
+        const phentsize = self.load_user_int(u16, executable + 54); // e_phentsize
+        const phnum = self.load_user_int(u16, executable + 56); // e_phnum
+        if (phnum == 0 or phnum > MAX_SEGMENTS or phentsize < PHDR_SIZE) {
+            return BasinError.invalid_argument; // No usable program header table
+        }
+        
+        // Assert: program header table must lie in guest RAM.
+        const available = memory_size - executable;
+        const table_len = @as(u64, phnum) * phentsize;
+        if (phoff > available or table_len > available - phoff) {
+            return BasinError.invalid_argument;
+        }
+        
+        const table = executable + phoff;
+        var i: u64 = 0;
+        while (i < phnum) : (i += 1) {
+            const phdr = table + i * phentsize;
+            if (self.load_user_int(u32, phdr) != PT_LOAD) continue; // p_type
+            if ((self.load_user_int(u32, phdr + 4) & PF_X) == 0) continue; // p_flags
+            const vaddr = self.load_user_int(u64, phdr + 16); // p_vaddr
+            const memsz = self.load_user_int(u64, phdr + 40); // p_memsz
+            if (vaddr >= memory_size or memsz > memory_size - vaddr) continue; // Not in RAM
+            if (entry < vaddr or entry - vaddr >= memsz) continue;
+            
+            // A mapping over the entry must allow execution as well.
+            if (self.mapping_flags_at(entry)) |flags| {
+                if (!flags.execute) return BasinError.invalid_argument;
+            }
+            
+            // Assert: the entry must lie in guest RAM.
+            std.debug.assert(entry < memory_size);
+            return entry;
+        }
+        return BasinError.invalid_argument; // Entry outside executable memory
+    }
+    
+    /// End the current process: waiters resume with status, and its stack is freed once
+    /// the next scheduling point has switched it out.
+    /// Note: A process nobody waits for stays exited until wait collects it; one that
+    /// was waited for becomes a zombie and is released at that switch. No current
+    /// process: nothing to end.
     fn syscall_exit(
         self: *BasinKernel,
         status: u64,
@@ -1029,41 +1927,43 @@ pub const BasinKernel = struct {
         _ = _arg3;
         _ = _arg4;
         
-        // Assert: status must be valid (0-255 for exit code).
-        std.debug.assert(status <= 255);
-        const exit_status = @as(u32, @truncate(status));
+        // Exit codes are 0-255; the guest's a0 is masked like a POSIX exit status.
+        // Why: a0 is guest-controlled, so a wider value must not trip an assertion.
+        const exit_status: u32 = @intCast(status & 0xFF);
         
-        // Find current process (for now, use process ID 1 as current process).
-        // TODO: Track current process ID in kernel state (when multi-process is implemented).
-        const current_process_id: u64 = 1;
-        
-        // Find process in process table.
-        var found: ?usize = null;
-        for (0..MAX_PROCESSES) |i| {
-            if (self.processes[i].allocated and self.processes[i].id == current_process_id) {
-                found = i;
-                break;
-            }
+        if (self.current == NO_PROCESS) {
+            return SyscallResult.ok(exit_status);
         }
+        const idx = self.current;
+        const process = &self.processes.entries[idx];
+        std.debug.assert(process.state == .running);
         
-        if (found) |idx| {
-            // Mark process as exited.
-            self.processes[idx].state = .exited;
-            self.processes[idx].exit_status = exit_status;
-            
-            // Assert: process must be marked as exited.
-            std.debug.assert(self.processes[idx].state == .exited);
-            std.debug.assert(self.processes[idx].exit_status == exit_status);
+        // Mark process as exited; the next scheduling point takes it off the CPU.
+        // Why: Its stack and slot stay live until then, so nothing it still runs on
+        // can be handed to another mapping or process first.
+        process.state = .exited;
+        process.exit_status = exit_status;
+        self.need_resched = true;
+        
+        // Waiters resume with the status in a0.
+        var waited = false;
+        for (&self.processes.entries, 0..) |*waiter, i| {
+            if (!waiter.allocated or waiter.state != .blocked or waiter.waiting_for != process.id) continue;
+            waiter.context.regs[10] = exit_status;
+            waiter.waiting_for = 0;
+            waiter.state = .ready;
+            self.run_queue.push(@intCast(i), waiter.priority);
+            waited = true;
+        }
+        if (waited) {
+            process.state = .zombie;
         }
         
-        // Exit syscall: terminate process with status code.
-        // Note: In full implementation, we would also:
-        // - Free process resources (memory, handles, etc.)
-        // - Wake up any processes waiting on this process
-        // - Schedule next process (if any)
+        // Assert: process must still be on the CPU, waiting to be switched out.
+        std.debug.assert(process.state == .exited or process.state == .zombie);
+        std.debug.assert(self.current == idx);
         
-        // Return status code (VM will handle actual termination).
-        return SyscallResult.ok(status);
+        return SyscallResult.ok(exit_status);
     }
     
     fn syscall_yield(
@@ -1073,19 +1973,22 @@ pub const BasinKernel = struct {
         _arg3: u64,
         _arg4: u64,
     ) BasinError!SyscallResult {
-        _ = self;
         _ = _arg1;
         _ = _arg2;
         _ = _arg3;
         _ = _arg4;
         
-        // Yield syscall: voluntary CPU yield (cooperative scheduling hint).
-        // Why: Simple implementation - return success immediately.
-        // Note: VM scheduler (if implemented) can use this hint for context switching.
-        // For now, just return success (no-op).
+        // Yield syscall: the next scheduling point queues the current process behind
+        // every ready process of its priority (no current process: nothing to yield).
+        if (self.current != NO_PROCESS) {
+            self.need_resched = true;
+        }
         return SyscallResult.ok(0);
     }
     
+    /// Collect process's exit status, blocking the caller until it exits.
+    /// Returns: Exit status (the process is released); would_block if it is still
+    /// running (a blocked caller resumes with the status in a0).
     fn syscall_wait(
         self: *BasinKernel,
         process: u64,
@@ -1108,24 +2011,24 @@ pub const BasinKernel = struct {
         }
         
         // Find process in process table.
-        var found: ?usize = null;
-        for (0..MAX_PROCESSES) |i| {
-            if (self.processes[i].allocated and self.processes[i].id == process) {
-                found = i;
-                break;
-            }
-        }
+        const idx = self.processes.find(process) orelse {
+            return BasinError.not_found; // Process not found (or stale ID)
+        };
         
-        if (found == null) {
-            return BasinError.not_found; // Process not found
+        // A zombie's status went to the waiters it had; its ID is as good as stale.
+        if (self.processes.entries[idx].state == .zombie) {
+            return BasinError.not_found;
         }
         
-        const idx = found.?;
+        // Assert: a process cannot wait for itself.
+        if (idx == self.current) {
+            return BasinError.invalid_argument;
+        }
         
         // Check if process has exited.
-        if (self.processes[idx].state == .exited) {
+        if (self.processes.entries[idx].state == .exited) {
             // Process already exited: return exit status.
-            const exit_status: u64 = self.processes[idx].exit_status;
+            const exit_status: u64 = self.processes.entries[idx].exit_status;
             const result = SyscallResult.ok(exit_status);
             
             // Assert: result must be success (not error).
@@ -1135,19 +2038,20 @@ pub const BasinKernel = struct {
             // Assert: Exit status must be valid (0-255).
             std.debug.assert(exit_status <= 255);
             
+            // Collected: the process slot is released.
+            self.release_process(idx);
             return result;
         }
         
-        // Process is still running: wait for it to exit.
-        // TODO: Implement blocking wait (when scheduler is implemented).
-        // For now, return error (process still running).
-        // Note: In full implementation, we would:
-        // - Block current process until target process exits
-        // - Wake up when target process calls exit()
-        // - Return exit status when process exits
-        
-        // Stub: Return error (process still running, blocking wait not implemented).
-        return BasinError.invalid_argument; // Process still running (blocking wait not implemented)
+        // Process is still running: block until it exits (host context cannot block).
+        // Note: The caller sees would_block now; exit replaces its saved a0 with the status.
+        if (self.current != NO_PROCESS) {
+            const waiter = &self.processes.entries[self.current];
+            waiter.state = .blocked;
+            waiter.waiting_for = process;
+            self.need_resched = true;
+        }
+        return BasinError.would_block;
     }
     
     fn syscall_map(
@@ -1173,14 +2077,12 @@ pub const BasinKernel = struct {
         }
         
         // Assert: size must be reasonable (max 1GB per mapping, fits in VM memory).
-        // VM memory size (matches VM_MEMORY_SIZE from kernel_vm).
-        // Why: Consistent memory limits across VM and kernel syscall validation.
-        // Note: Default 4MB, configurable via VM_MEMORY_SIZE constant.
-        const VM_MEMORY_SIZE: u64 = 4 * 1024 * 1024; // 4MB default (safe for 8GB target)
+        // Why: Same limit the host VM enforces (set from VM.memory_size by the host).
+        const memory_size = self.user_memory_size;
         if (size > 1024 * 1024 * 1024) {
             return BasinError.invalid_argument; // Too large (> 1GB)
         }
-        if (size > VM_MEMORY_SIZE) {
+        if (size > memory_size) {
             return BasinError.out_of_memory; // Larger than VM memory
         }
         
@@ -1200,23 +2102,20 @@ pub const BasinKernel = struct {
         // Determine mapping address.
         var mapping_addr: u64 = addr;
         
-        // If addr is zero, kernel chooses address (simple allocator: start from user space).
-        // Why: Simple implementation - allocate from user space region.
-        const KERNEL_SPACE_END: u64 = 0x100000; // 1MB kernel space (typical)
+        // If addr is zero, kernel chooses address (lowest free range that fits).
+        // Why: Unmapped ranges are coalesced and reused, so churn does not exhaust space.
+        const KERNEL_SPACE_END: u64 = MAPPING_BASE; // 1MB kernel space (typical)
         const USER_SPACE_START: u64 = KERNEL_SPACE_END; // User space starts after kernel
         
         if (mapping_addr == 0) {
-            // Kernel chooses: allocate from next allocation address.
-            // Why: Use simple allocator that tracks next free address.
-            mapping_addr = self.next_alloc_addr;
+            // Kernel chooses: first fit in the free-range list.
+            mapping_addr = self.address_space.find_free(size, memory_size) orelse {
+                return BasinError.out_of_memory; // No free range large enough
+            };
             
-            // Assert: Kernel-chosen address must be page-aligned.
+            // Assert: Kernel-chosen address must be page-aligned and fit in VM memory.
             std.debug.assert(mapping_addr % 4096 == 0);
-            
-            // Assert: Kernel-chosen address must fit in VM memory.
-            if (mapping_addr + size > VM_MEMORY_SIZE) {
-                return BasinError.out_of_memory; // No space for kernel-chosen address
-            }
+            std.debug.assert(mapping_addr + size <= memory_size);
         } else {
             // User-provided address: validate alignment and range.
             if (mapping_addr % 4096 != 0) {
@@ -1230,7 +2129,7 @@ pub const BasinKernel = struct {
         }
         
         // Assert: Mapping must fit within VM memory.
-        if (mapping_addr + size > VM_MEMORY_SIZE) {
+        if (mapping_addr + size > memory_size) {
             return BasinError.out_of_memory; // Mapping exceeds VM memory
         }
         
@@ -1245,30 +2144,25 @@ pub const BasinKernel = struct {
         }
         
         // Find free mapping entry.
-        const mapping_idx = self.find_free_mapping() orelse {
+        const mapping_idx = self.alloc_mapping() orelse {
             return BasinError.out_of_memory; // Mapping table full
         };
         
-        // Allocate mapping entry.
-        var mapping = &self.mappings[mapping_idx];
+        // Allocate mapping entry and index it (carves the range out of the free list).
+        const mapping = &self.mappings[mapping_idx];
         mapping.address = mapping_addr;
         mapping.size = size;
         mapping.flags = map_flags;
+        mapping.state = .owned;
         mapping.allocated = true;
+        self.address_space.insert(mapping_addr, mapping_addr + size, mapping_idx);
+        self.mapped_bytes += size;
         
         // Assert: Mapping entry must be allocated correctly.
         std.debug.assert(mapping.allocated);
         std.debug.assert(mapping.address == mapping_addr);
         std.debug.assert(mapping.size == size);
-        
-        // Update next allocation address (for kernel-chosen addresses).
-        if (addr == 0) {
-            // Kernel-chosen: advance next allocation address.
-            self.next_alloc_addr = mapping_addr + size;
-            
-            // Assert: Next allocation address must be page-aligned.
-            std.debug.assert(self.next_alloc_addr % 4096 == 0);
-        }
+        std.debug.assert(self.find_mapping_by_address(mapping_addr) == mapping_idx);
         
         const result = SyscallResult.ok(mapping_addr);
         
@@ -1278,7 +2172,7 @@ pub const BasinKernel = struct {
         
         // Assert: Returned address must be valid.
         std.debug.assert(result.success >= USER_SPACE_START);
-        std.debug.assert(result.success + size <= VM_MEMORY_SIZE);
+        std.debug.assert(result.success + size <= memory_size);
         std.debug.assert(result.success % 4096 == 0);
         
         return result;
@@ -1314,8 +2208,8 @@ pub const BasinKernel = struct {
         }
         
         // Assert: region address must be within VM memory bounds.
-        const VM_MEMORY_SIZE: u64 = 4 * 1024 * 1024; // 4MB default (matches syscall_map)
-        if (region >= VM_MEMORY_SIZE) {
+        const memory_size = self.user_memory_size;
+        if (region >= memory_size) {
             return BasinError.invalid_argument; // Region address exceeds VM memory
         }
         
@@ -1328,15 +2222,19 @@ pub const BasinKernel = struct {
         std.debug.assert(self.mappings[mapping_idx].allocated);
         std.debug.assert(self.mappings[mapping_idx].address == region);
         
-        // Free mapping entry.
-        var mapping = &self.mappings[mapping_idx];
-        mapping.allocated = false;
-        mapping.address = 0;
-        mapping.size = 0;
-        mapping.flags = MapFlags.init(.{});
+        // Channel and io rings, pages queued in a channel and process stacks belong to the kernel.
+        if (self.mappings[mapping_idx].state != .owned) {
+            return BasinError.permission_denied;
+        }
+        
+        // Free mapping entry (its range rejoins the free list, coalesced with neighbours).
+        const removed_idx = self.address_space.remove(region);
+        std.debug.assert(removed_idx == mapping_idx);
+        self.mapped_bytes -= self.mappings[mapping_idx].size;
+        self.free_mapping(mapping_idx);
         
         // Assert: Mapping entry must be freed correctly.
-        std.debug.assert(!mapping.allocated);
+        std.debug.assert(!self.mappings[mapping_idx].allocated);
         
         const result = SyscallResult.ok(0);
         
@@ -1376,8 +2274,8 @@ pub const BasinKernel = struct {
         }
         
         // Assert: region address must be within VM memory bounds.
-        const VM_MEMORY_SIZE: u64 = 4 * 1024 * 1024; // 4MB default (matches syscall_map)
-        if (region >= VM_MEMORY_SIZE) {
+        const memory_size = self.user_memory_size;
+        if (region >= memory_size) {
             return BasinError.invalid_argument; // Region address exceeds VM memory
         }
         
@@ -1403,6 +2301,11 @@ pub const BasinKernel = struct {
         std.debug.assert(self.mappings[mapping_idx].allocated);
         std.debug.assert(self.mappings[mapping_idx].address == region);
         
+        // Channel and io rings, pages queued in a channel and process stacks belong to the kernel.
+        if (self.mappings[mapping_idx].state != .owned) {
+            return BasinError.permission_denied;
+        }
+        
         // Update mapping flags (permissions).
         var mapping = &self.mappings[mapping_idx];
         mapping.flags = map_flags;
@@ -1422,9 +2325,14 @@ pub const BasinKernel = struct {
         return result;
     }
     
+    /// Create a channel: a single-producer/single-consumer ring in fresh shared guest pages.
+    /// Why: IPC without copying through kernel buffers; either end may use the ring directly.
+    /// Contract: arg1 is 0 or a guest address that receives the ring address (u64).
+    /// Returns: Channel ID; out_of_memory if the channel or mapping table (or guest RAM)
+    /// is full, invalid_argument without attached guest RAM or for a bad out pointer.
     fn syscall_channel_create(
         self: *BasinKernel,
-        _arg1: u64,
+        ring_out_ptr: u64,
         _arg2: u64,
         _arg3: u64,
         _arg4: u64,
@@ -1434,35 +2342,63 @@ pub const BasinKernel = struct {
         std.debug.assert(self_ptr != 0);
         std.debug.assert(self_ptr % @alignOf(BasinKernel) == 0);
         
-        _ = _arg1;
         _ = _arg2;
         _ = _arg3;
         _ = _arg4;
         
-        // TODO: Implement actual channel creation (when IPC is implemented).
-        // For now, return stub channel ID.
-        // Why: Simple stub - matches current kernel development stage.
-        // Note: In full implementation, we would:
-        // - Create channel structure (message queue, synchronization)
-        // - Allocate channel ID
-        // - Add channel to channel table
-        // - Return Channel ID (not raw integer) for type safety
-        // - Handle channel capacity/limits
+        // Assert: ring lives in guest RAM (none attached: nowhere to put it).
+        if (self.user_memory == null) {
+            return BasinError.invalid_argument;
+        }
+        
+        // Assert: out pointer (if any) must hold a u64 within VM memory.
+        const memory_size = self.user_memory_size;
+        if (ring_out_ptr != 0 and (ring_out_ptr >= memory_size or memory_size - ring_out_ptr < 8)) {
+            return BasinError.invalid_argument;
+        }
+        
+        const channel_idx = self.channels.alloc() orelse {
+            return BasinError.out_of_memory; // Channel table full
+        };
+        
+        // Map the ring (kernel-chosen address) and pin it for the channel's lifetime.
+        const ring_flags = MapFlags.init(.{ .read = true, .write = true, .shared = true });
+        const mapped = self.syscall_map(0, channel_ring.RING_BYTES, @as(u32, @bitCast(ring_flags)), 0) catch |err| {
+            self.channels.free_slot(channel_idx);
+            return err;
+        };
+        const ring = mapped.success;
+        const mapping_idx = self.find_mapping_by_address(ring).?;
+        self.mappings[mapping_idx].state = .channel_ring;
+        
+        // Empty ring: head == tail == 0.
+        var header = std.mem.zeroes(channel_ring.Header);
+        header.magic = channel_ring.MAGIC;
+        header.slots = channel_ring.SLOTS;
+        self.copy_to_user(ring, std.mem.asBytes(&header));
+        if (ring_out_ptr != 0) {
+            self.store_user_int(u64, ring_out_ptr, ring);
+        }
         
-        // Stub: Return channel ID 1 (simple implementation).
-        const channel_id: u64 = 1;
-        const result = SyscallResult.ok(channel_id);
+        const chan = &self.channels.entries[channel_idx];
+        chan.ring = ring;
+        const result = SyscallResult.ok(chan.id);
         
         // Assert: result must be success (not error).
         std.debug.assert(result == .success);
-        std.debug.assert(result.success == channel_id);
         
         // Assert: Channel ID must be non-zero (valid channel ID).
-        std.debug.assert(channel_id != 0);
+        std.debug.assert(result.success != 0);
         
         return result;
     }
     
+    /// Queue a message on a channel.
+    /// Why: Small messages are copied into the ring; large ones move a whole mapping.
+    /// Contract: data_len <= channel_ring.INLINE_MAX is copied inline. Larger data_ptr
+    /// must start an owned mapping of at least data_len bytes; the mapping goes in
+    /// transit (unmap/protect refused) until channel_recv hands it to the receiver.
+    /// Returns: 0; would_block if the ring is full; invalid_handle for unknown channels.
     fn syscall_channel_send(
         self: *BasinKernel,
         channel: u64,
@@ -1487,35 +2423,70 @@ pub const BasinKernel = struct {
             return BasinError.invalid_argument; // Null pointer
         }
         
-        const VM_MEMORY_SIZE: u64 = 4 * 1024 * 1024; // 4MB default (matches syscall_map)
-        if (data_ptr >= VM_MEMORY_SIZE) {
+        const memory_size = self.user_memory_size;
+        if (data_ptr >= memory_size) {
             return BasinError.invalid_argument; // Data pointer exceeds VM memory
         }
         
-        // Assert: data length must be reasonable (max 64KB per message).
+        // Assert: data length must be non-zero and fit a u32 slot length.
         if (data_len == 0) {
             return BasinError.invalid_argument; // Zero-length data
         }
-        if (data_len > 64 * 1024) {
-            return BasinError.invalid_argument; // Data too large (> 64KB)
+        if (data_len > std.math.maxInt(u32)) {
+            return BasinError.invalid_argument; // Data too large
         }
         
         // Assert: data must fit within VM memory.
-        if (data_ptr + data_len > VM_MEMORY_SIZE) {
+        if (data_ptr + data_len > memory_size) {
             return BasinError.invalid_argument; // Data exceeds VM memory
         }
         
-        // TODO: Implement actual channel send (when IPC is implemented).
-        // For now, return stub success.
-        // Why: Simple stub - matches current kernel development stage.
-        // Note: In full implementation, we would:
-        // - Look up channel in channel table
-        // - Verify channel exists and is open
-        // - Copy data to channel message queue
-        // - Wake up waiting receivers (if any)
-        // - Return error if channel full or not found
+        const channel_idx = self.channels.find(channel) orelse {
+            return BasinError.invalid_handle; // Channel not found
+        };
+        const ring = self.channels.entries[channel_idx].ring;
+        
+        // Assert: ring must have room (counters are guest-writable: reject nonsense).
+        const head = self.load_user_int(u32, ring + channel_ring.HEAD_OFFSET);
+        const tail = self.load_user_int(u32, ring + channel_ring.TAIL_OFFSET);
+        const used = tail -% head;
+        if (used > channel_ring.SLOTS) {
+            return BasinError.invalid_argument; // Corrupt ring counters
+        }
+        if (used == channel_ring.SLOTS) {
+            return BasinError.would_block; // Ring full
+        }
+        
+        var slot = std.mem.zeroes(channel_ring.Slot);
+        slot.len = @intCast(data_len);
+        if (data_len <= channel_ring.INLINE_MAX) {
+            slot.kind = @intFromEnum(channel_ring.Kind.inline_bytes);
+            self.copy_from_user(data_ptr, slot.data[0..@intCast(data_len)]);
+        } else {
+            // Large payload: data must be an owned mapping; its pages change hands.
+            if (data_ptr % 4096 != 0) {
+                return BasinError.unaligned_access;
+            }
+            const mapping_idx = self.find_mapping_by_address(data_ptr) orelse {
+                return BasinError.invalid_argument; // Not a mapping (inline limit exceeded)
+            };
+            const mapping = &self.mappings[mapping_idx];
+            if (mapping.state != .owned) {
+                return BasinError.permission_denied; // Ring or already in transit
+            }
+            if (mapping.size < data_len) {
+                return BasinError.invalid_argument; // Data exceeds mapping
+            }
+            mapping.state = .in_transit;
+            slot.kind = @intFromEnum(channel_ring.Kind.pages);
+            slot.pages = data_ptr;
+        }
+        
+        // Publish: slot first, then tail (a consumer never sees a half-written slot).
+        const slot_bytes = channel_ring.SLOT_HEADER_BYTES + (if (slot.kind == @intFromEnum(channel_ring.Kind.inline_bytes)) data_len else 0);
+        self.copy_to_user(ring + channel_ring.slot_offset(tail), std.mem.asBytes(&slot)[0..@intCast(slot_bytes)]);
+        self.store_user_int(u32, ring + channel_ring.TAIL_OFFSET, tail +% 1);
         
-        // Stub: Return success (simple implementation).
         const result = SyscallResult.ok(0);
         
         // Assert: result must be success (not error).
@@ -1525,20 +2496,24 @@ pub const BasinKernel = struct {
         return result;
     }
     
+    /// Take the oldest message from a channel.
+    /// Contract: inline messages are copied to buffer (buffer_len must hold them). For a
+    /// page message nothing is copied: the mapping's address is stored at pages_out_ptr
+    /// (required) and the mapping becomes owned again. pages_out_ptr, when given, gets 0
+    /// for inline messages. A message that does not fit stays queued.
+    /// Returns: Message length; would_block if the ring is empty.
     fn syscall_channel_recv(
         self: *BasinKernel,
         channel: u64,
         buffer_ptr: u64,
         buffer_len: u64,
-        _arg4: u64,
+        pages_out_ptr: u64,
     ) BasinError!SyscallResult {
         // Assert: self pointer must be valid.
         const self_ptr = @intFromPtr(self);
         std.debug.assert(self_ptr != 0);
         std.debug.assert(self_ptr % @alignOf(BasinKernel) == 0);
         
-        _ = _arg4;
-        
         // Assert: channel ID must be valid (non-zero).
         if (channel == 0) {
             return BasinError.invalid_argument; // Invalid channel ID
@@ -1549,8 +2524,8 @@ pub const BasinKernel = struct {
             return BasinError.invalid_argument; // Null pointer
         }
         
-        const VM_MEMORY_SIZE: u64 = 4 * 1024 * 1024; // 4MB default (matches syscall_map)
-        if (buffer_ptr >= VM_MEMORY_SIZE) {
+        const memory_size = self.user_memory_size;
+        if (buffer_ptr >= memory_size) {
             return BasinError.invalid_argument; // Buffer pointer exceeds VM memory
         }
         
@@ -1563,23 +2538,71 @@ pub const BasinKernel = struct {
         }
         
         // Assert: buffer must fit within VM memory.
-        if (buffer_ptr + buffer_len > VM_MEMORY_SIZE) {
+        if (buffer_ptr + buffer_len > memory_size) {
             return BasinError.invalid_argument; // Buffer exceeds VM memory
         }
         
-        // TODO: Implement actual channel receive (when IPC is implemented).
-        // For now, return stub (0 bytes received).
-        // Why: Simple stub - matches current kernel development stage.
-        // Note: In full implementation, we would:
-        // - Look up channel in channel table
-        // - Verify channel exists and is open
-        // - Wait for message (if channel empty)
-        // - Copy message from channel to buffer
-        // - Return bytes received count
-        // - Return error if channel not found
+        // Assert: pages out pointer (if any) must hold a u64 within VM memory.
+        if (pages_out_ptr != 0 and (pages_out_ptr >= memory_size or memory_size - pages_out_ptr < 8)) {
+            return BasinError.invalid_argument;
+        }
+        
+        const channel_idx = self.channels.find(channel) orelse {
+            return BasinError.invalid_handle; // Channel not found
+        };
+        const ring = self.channels.entries[channel_idx].ring;
+        
+        const head = self.load_user_int(u32, ring + channel_ring.HEAD_OFFSET);
+        const tail = self.load_user_int(u32, ring + channel_ring.TAIL_OFFSET);
+        const used = tail -% head;
+        if (used > channel_ring.SLOTS) {
+            return BasinError.invalid_argument; // Corrupt ring counters
+        }
+        if (used == 0) {
+            return BasinError.would_block; // Ring empty
+        }
+        
+        var slot: channel_ring.Slot = undefined;
+        const slot_addr = ring + channel_ring.slot_offset(head);
+        self.copy_from_user(slot_addr, std.mem.asBytes(&slot)[0..channel_ring.SLOT_HEADER_BYTES]);
+        
+        if (slot.kind == @intFromEnum(channel_ring.Kind.inline_bytes)) {
+            if (slot.len == 0 or slot.len > channel_ring.INLINE_MAX) {
+                return BasinError.invalid_argument; // Corrupt slot
+            }
+            if (slot.len > buffer_len) {
+                return BasinError.invalid_argument; // Buffer too small (message stays queued)
+            }
+            self.copy_from_user(slot_addr + channel_ring.SLOT_HEADER_BYTES, slot.data[0..slot.len]);
+            self.copy_to_user(buffer_ptr, slot.data[0..slot.len]);
+            if (pages_out_ptr != 0) {
+                self.store_user_int(u64, pages_out_ptr, 0);
+            }
+        } else if (slot.kind == @intFromEnum(channel_ring.Kind.pages)) {
+            if (pages_out_ptr == 0) {
+                return BasinError.invalid_argument; // Nowhere to report the pages (message stays queued)
+            }
+            // Only pages the kernel put in transit may change hands (slots are guest-writable).
+            if (slot.pages % 4096 != 0) {
+                return BasinError.invalid_argument; // Corrupt slot
+            }
+            const mapping_idx = self.find_mapping_by_address(slot.pages) orelse {
+                return BasinError.invalid_argument; // Corrupt slot
+            };
+            const mapping = &self.mappings[mapping_idx];
+            if (mapping.state != .in_transit or mapping.size < slot.len) {
+                return BasinError.invalid_argument; // Corrupt slot
+            }
+            mapping.state = .owned;
+            self.store_user_int(u64, pages_out_ptr, slot.pages);
+        } else {
+            return BasinError.invalid_argument; // Corrupt slot
+        }
+        
+        // Consume: head advances only after the slot was read.
+        self.store_user_int(u32, ring + channel_ring.HEAD_OFFSET, head +% 1);
         
-        // Stub: Return 0 bytes received (simple implementation).
-        const bytes_received: u64 = 0;
+        const bytes_received: u64 = slot.len;
         const result = SyscallResult.ok(bytes_received);
         
         // Assert: result must be success (not error).
@@ -1589,6 +2612,195 @@ pub const BasinKernel = struct {
         return result;
     }
     
+    /// Set up a batched syscall ring: submission and completion queues in fresh shared guest pages.
+    /// Why: A batch of syscalls costs one io_ring_enter (none with SETUP_POLL) instead of an ecall each.
+    /// Contract: arg1 is 0 or a guest address that receives the ring address (u64); flags is
+    /// 0 or io_ring.SETUP_POLL.
+    /// Returns: Ring ID; out_of_memory if the ring or mapping table (or guest RAM) is full,
+    /// invalid_argument without attached guest RAM, for unknown flags or a bad out pointer.
+    fn syscall_io_ring_setup(
+        self: *BasinKernel,
+        ring_out_ptr: u64,
+        flags: u64,
+        _arg3: u64,
+        _arg4: u64,
+    ) BasinError!SyscallResult {
+        // Assert: self pointer must be valid.
+        const self_ptr = @intFromPtr(self);
+        std.debug.assert(self_ptr != 0);
+        std.debug.assert(self_ptr % @alignOf(BasinKernel) == 0);
+        
+        _ = _arg3;
+        _ = _arg4;
+        
+        // Assert: ring lives in guest RAM (none attached: nowhere to put it).
+        if (self.user_memory == null) {
+            return BasinError.invalid_argument;
+        }
+        
+        // Assert: flags must be known.
+        if (flags & ~@as(u64, io_ring.SETUP_POLL) != 0) {
+            return BasinError.invalid_argument;
+        }
+        
+        // Assert: out pointer (if any) must hold a u64 within VM memory.
+        const memory_size = self.user_memory_size;
+        if (ring_out_ptr != 0 and (ring_out_ptr >= memory_size or memory_size - ring_out_ptr < 8)) {
+            return BasinError.invalid_argument;
+        }
+        
+        const ring_idx = self.io_rings.alloc() orelse {
+            return BasinError.out_of_memory; // Ring table full
+        };
+        
+        // Map the ring (kernel-chosen address) and pin it for the ring's lifetime.
+        const ring_flags = MapFlags.init(.{ .read = true, .write = true, .shared = true });
+        const mapped = self.syscall_map(0, io_ring.RING_BYTES, @as(u32, @bitCast(ring_flags)), 0) catch |err| {
+            self.io_rings.free_slot(ring_idx);
+            return err;
+        };
+        const ring = mapped.success;
+        const mapping_idx = self.find_mapping_by_address(ring).?;
+        self.mappings[mapping_idx].state = .io_ring;
+        
+        // Empty queues: every counter 0.
+        var header = std.mem.zeroes(io_ring.Header);
+        header.magic = io_ring.MAGIC;
+        header.sq_entries = io_ring.SQ_ENTRIES;
+        header.cq_entries = io_ring.CQ_ENTRIES;
+        header.flags = @intCast(flags);
+        self.copy_to_user(ring, std.mem.asBytes(&header));
+        if (ring_out_ptr != 0) {
+            self.store_user_int(u64, ring_out_ptr, ring);
+        }
+        
+        const entry = &self.io_rings.entries[ring_idx];
+        entry.ring = ring;
+        entry.poll = flags & io_ring.SETUP_POLL != 0;
+        entry.sq_head = 0;
+        entry.cq_tail = 0;
+        if (entry.poll) {
+            if (self.io_ring_pollers == 0) self.io_poll_at = self.guest_time() + IO_POLL_INTERVAL;
+            self.io_ring_pollers += 1;
+        }
+        const result = SyscallResult.ok(entry.id);
+        
+        // Assert: result must be success (not error).
+        std.debug.assert(result == .success);
+        
+        // Assert: Ring ID must be non-zero (valid ring ID).
+        std.debug.assert(result.success != 0);
+        
+        return result;
+    }
+    
+    /// Run the queued submissions of an io_ring, posting one completion each.
+    /// Contract: max_submit == 0 runs everything queued, otherwise at most max_submit
+    /// submissions, in order. Stops early when the CQ is full (reap, then enter again).
+    /// Each completion's result is the a0 word the syscall would have returned.
+    /// Returns: Submissions consumed; invalid_handle for unknown rings, invalid_argument
+    /// if the guest moved sq_tail or cq_head past what the ring can hold.
+    fn syscall_io_ring_enter(
+        self: *BasinKernel,
+        ring_id: u64,
+        max_submit: u64,
+        _arg3: u64,
+        _arg4: u64,
+    ) BasinError!SyscallResult {
+        // Assert: self pointer must be valid.
+        const self_ptr = @intFromPtr(self);
+        std.debug.assert(self_ptr != 0);
+        std.debug.assert(self_ptr % @alignOf(BasinKernel) == 0);
+        
+        _ = _arg3;
+        _ = _arg4;
+        
+        // Assert: ring ID must be valid (non-zero).
+        if (ring_id == 0) {
+            return BasinError.invalid_argument; // Invalid ring ID
+        }
+        
+        const ring_idx = self.io_rings.find(ring_id) orelse {
+            return BasinError.invalid_handle; // Ring not found
+        };
+        
+        const limit: u32 = if (max_submit == 0 or max_submit > io_ring.SQ_ENTRIES) io_ring.SQ_ENTRIES else @intCast(max_submit);
+        const consumed = try self.drain_io_ring(ring_idx, limit);
+        const result = SyscallResult.ok(consumed);
+        
+        // Assert: result must be success (not error).
+        std.debug.assert(result == .success);
+        std.debug.assert(result.success <= limit);
+        
+        return result;
+    }
+    
+    /// Drain every ring set up with io_ring.SETUP_POLL (schedule does this on its own).
+    /// Why: A guest that only writes submissions and reads completions never traps.
+    /// Note: Rings with corrupt counters are skipped; io_ring_enter reports them.
+    pub fn poll_io_rings(self: *BasinKernel) void {
+        var polled: u32 = 0;
+        for (self.io_rings.entries, 0..) |entry, idx| {
+            if (!entry.allocated or !entry.poll) continue;
+            polled += 1;
+            if (self.drain_io_ring(@intCast(idx), io_ring.SQ_ENTRIES)) |_| {} else |_| {}
+        }
+        
+        // Assert: every polled ring must have been visited.
+        std.debug.assert(polled == self.io_ring_pollers);
+    }
+    
+    /// Consume up to limit submissions of ring slot idx (fewer if the SQ empties or the CQ fills).
+    /// Note: sq_head and cq_tail are published once, after every completion is written.
+    fn drain_io_ring(self: *BasinKernel, idx: u32, limit: u32) BasinError!u32 {
+        const entry = &self.io_rings.entries[idx];
+        std.debug.assert(entry.allocated);
+        const ring = entry.ring;
+        
+        // The guest writes sq_tail and cq_head; trust them only as far as the ring reaches.
+        const queued = self.load_user_int(u32, ring + io_ring.SQ_TAIL_OFFSET) -% entry.sq_head;
+        const unreaped = entry.cq_tail -% self.load_user_int(u32, ring + io_ring.CQ_HEAD_OFFSET);
+        if (queued > io_ring.SQ_ENTRIES or unreaped > io_ring.CQ_ENTRIES) {
+            return BasinError.invalid_argument; // Corrupt counters
+        }
+        const count = @min(limit, queued, io_ring.CQ_ENTRIES - unreaped);
+        if (count == 0) return 0;
+        
+        var done: u32 = 0;
+        while (done < count) : (done += 1) {
+            var sqe = std.mem.zeroes(io_ring.Sqe);
+            self.copy_from_user(ring + io_ring.sqe_offset(entry.sq_head +% done), std.mem.asBytes(&sqe));
+            const cqe = io_ring.Cqe{ .user_data = sqe.user_data, .result = self.run_ring_op(sqe) };
+            self.copy_to_user(ring + io_ring.cqe_offset(entry.cq_tail +% done), std.mem.asBytes(&cqe));
+        }
+        entry.sq_head +%= done;
+        entry.cq_tail +%= done;
+        self.store_user_int(u32, ring + io_ring.SQ_HEAD_OFFSET, entry.sq_head);
+        self.store_user_int(u32, ring + io_ring.CQ_TAIL_OFFSET, entry.cq_tail);
+        
+        // Assert: the kernel must never run ahead of the guest's submissions.
+        std.debug.assert(done <= queued);
+        return done;
+    }
+    
+    /// Run one submission through the syscall path (the a0 word it returns).
+    /// Why: Process, sleep and ring syscalls reschedule or recurse; a batch refuses them.
+    fn run_ring_op(self: *BasinKernel, sqe: io_ring.Sqe) u64 {
+        if (sqe.flags != 0) {
+            return SyscallResult.to_word(BasinError.invalid_argument);
+        }
+        const syscall = std.meta.intToEnum(Syscall, sqe.opcode) catch {
+            return SyscallResult.to_word(BasinError.invalid_syscall);
+        };
+        switch (syscall) {
+            .spawn, .exit, .yield, .wait, .sleep_until, .io_ring_setup, .io_ring_enter => {
+                return SyscallResult.to_word(BasinError.invalid_syscall);
+            },
+            else => {},
+        }
+        return SyscallResult.to_word(self.handle_syscall(sqe.opcode, sqe.args[0], sqe.args[1], sqe.args[2], sqe.args[3]));
+    }
+    
     fn syscall_open(
         self: *BasinKernel,
         path_ptr: u64,
@@ -1608,8 +2820,8 @@ pub const BasinKernel = struct {
             return SyscallResult.fail(BasinError.invalid_argument); // Null pointer
         }
         
-        const VM_MEMORY_SIZE: u64 = 4 * 1024 * 1024; // 4MB default (matches syscall_map)
-        if (path_ptr >= VM_MEMORY_SIZE) {
+        const memory_size = self.user_memory_size;
+        if (path_ptr >= memory_size) {
             return SyscallResult.fail(BasinError.invalid_argument); // Path pointer exceeds VM memory
         }
         
@@ -1622,7 +2834,7 @@ pub const BasinKernel = struct {
         }
         
         // Assert: path must fit within VM memory.
-        if (path_ptr + path_len > VM_MEMORY_SIZE) {
+        if (path_ptr + path_len > memory_size) {
             return SyscallResult.fail(BasinError.invalid_argument); // Path exceeds VM memory
         }
         
@@ -1639,8 +2851,13 @@ pub const BasinKernel = struct {
             return SyscallResult.fail(BasinError.invalid_argument); // No permissions set
         }
         
-        // Assert: path length must fit in handle path buffer (max 256 bytes, so max path_len is 255).
-        // Note: path_len is the string length, handle.path is 256 bytes, so max path_len is 255.
+        // Validate: truncating changes the file, so it needs write permission.
+        if (open_flags.truncate and !open_flags.write) {
+            return SyscallResult.fail(BasinError.invalid_argument); // Truncate without write
+        }
+        
+        // Assert: path length must fit in the inode name buffer (max 256 bytes, so max path_len is 255).
+        // Note: path_len is the string length, inode.path is 256 bytes, so max path_len is 255.
         if (path_len > 255) {
             return SyscallResult.fail(BasinError.invalid_argument); // Path too long for handle buffer
         }
@@ -1649,33 +2866,48 @@ pub const BasinKernel = struct {
         std.debug.assert(path_len > 0);
         std.debug.assert(path_len <= 255);
         
-        // Find free handle entry.
-        const handle_idx = self.find_free_handle() orelse {
+        // Copy path from VM memory.
+        var path = [_]u8{0} ** 256;
+        const path_slice = path[0..@intCast(path_len)];
+        self.copy_from_user(path_ptr, path_slice);
+        
+        // Find the file's inode; a missing file is created only with the create flag.
+        const existing = self.find_inode(path_slice);
+        if (existing == null and !open_flags.create) {
+            return SyscallResult.fail(BasinError.not_found); // No such file
+        }
+        
+        // Allocate handle entry (ID encodes slot and generation).
+        const handle_idx = self.alloc_handle() orelse {
             return SyscallResult.fail(BasinError.out_of_memory); // Handle table full
         };
+        const file_handle = &self.handles.entries[handle_idx];
+        const handle_id = file_handle.id;
         
-        // Allocate handle entry.
-        var file_handle = &self.handles[handle_idx];
-        const handle_id = self.next_handle_id;
-        self.next_handle_id += 1;
-        
-        // Assert: Handle ID must be non-zero (1-based).
+        // Assert: Handle ID must be non-zero (0 is invalid).
         std.debug.assert(handle_id != 0);
         
-        // Copy path from VM memory (simulated - in real implementation, would read from VM memory).
-        // For now, store path length (actual path copying would happen here).
-        file_handle.id = handle_id;
-        file_handle.path_len = @as(u32, @intCast(path_len));
+        const inode_idx = existing orelse self.create_inode(path_slice) orelse {
+            self.handles.free_slot(handle_idx);
+            return SyscallResult.fail(BasinError.out_of_memory); // Inode table full
+        };
+        const inode = &self.inodes.entries[inode_idx];
+        
+        file_handle.inode = inode_idx;
         file_handle.flags = open_flags;
         file_handle.position = 0;
-        file_handle.buffer_size = 0;
-        file_handle.allocated = true;
+        inode.open_count += 1;
         
-        // If truncate flag is set, clear buffer.
+        // If truncate flag is set, drop the file's data (other handles see the truncation).
         if (open_flags.truncate) {
-            file_handle.buffer_size = 0;
+            inode.size = 0;
+            self.page_cache.discard(inode_idx + 1, 0);
         }
         
+        // Assert: Handle must reference a live, linked inode.
+        std.debug.assert(inode.allocated and inode.linked);
+        std.debug.assert(inode.open_count > 0);
+        
         // Note: For fuzz testing robustness, we don't assert handle state here.
         // The test will validate the result.
         
@@ -1708,8 +2940,8 @@ pub const BasinKernel = struct {
             return SyscallResult.fail(BasinError.invalid_argument); // Null pointer
         }
         
-        const VM_MEMORY_SIZE: u64 = 4 * 1024 * 1024; // 4MB default (matches syscall_map)
-        if (buffer_ptr >= VM_MEMORY_SIZE) {
+        const memory_size = self.user_memory_size;
+        if (buffer_ptr >= memory_size) {
             return SyscallResult.fail(BasinError.invalid_argument); // Buffer pointer exceeds VM memory
         }
         
@@ -1722,7 +2954,7 @@ pub const BasinKernel = struct {
         }
         
         // Assert: buffer must fit within VM memory.
-        if (buffer_ptr + buffer_len > VM_MEMORY_SIZE) {
+        if (buffer_ptr + buffer_len > memory_size) {
             return SyscallResult.fail(BasinError.invalid_argument); // Buffer exceeds VM memory
         }
         
@@ -1732,31 +2964,20 @@ pub const BasinKernel = struct {
         };
         
         // Assert: Handle must be allocated.
-        std.debug.assert(self.handles[handle_idx].allocated);
-        std.debug.assert(self.handles[handle_idx].id == handle);
+        std.debug.assert(self.handles.entries[handle_idx].allocated);
+        std.debug.assert(self.handles.entries[handle_idx].id == handle);
         
-        var file_handle = &self.handles[handle_idx];
+        const file_handle = &self.handles.entries[handle_idx];
         
         // Assert: Handle must be readable.
         if (!file_handle.flags.read) {
             return SyscallResult.fail(BasinError.permission_denied); // Handle not readable
         }
         
-        // Calculate bytes to read (min of available data and buffer size).
-        const available = if (file_handle.position < file_handle.buffer_size)
-            file_handle.buffer_size - file_handle.position
-        else
-            0;
-        const bytes_to_read = @min(available, @as(u32, @intCast(buffer_len)));
-        
-        // Read data from handle buffer (simulated - in real implementation, would write to VM memory).
-        // For now, just update position.
-        file_handle.position += bytes_to_read;
-        
-        // Assert: Position must not exceed buffer size.
-        std.debug.assert(file_handle.position <= file_handle.buffer_size);
-        
-        const bytes_read: u64 = @as(u64, @intCast(bytes_to_read));
+        // Copy file pages into the guest buffer (up to end of file).
+        const bytes_read = self.file_transfer(file_handle, buffer_ptr, buffer_len, .read) catch |err| {
+            return SyscallResult.fail(err); // Page cache full
+        };
         const result = SyscallResult.ok(bytes_read);
         
         // Assert: result must be success (not error).
@@ -1791,8 +3012,8 @@ pub const BasinKernel = struct {
             return SyscallResult.fail(BasinError.invalid_argument); // Null pointer
         }
         
-        const VM_MEMORY_SIZE: u64 = 4 * 1024 * 1024; // 4MB default (matches syscall_map)
-        if (data_ptr >= VM_MEMORY_SIZE) {
+        const memory_size = self.user_memory_size;
+        if (data_ptr >= memory_size) {
             return SyscallResult.fail(BasinError.invalid_argument); // Data pointer exceeds VM memory
         }
         
@@ -1805,7 +3026,7 @@ pub const BasinKernel = struct {
         }
         
         // Assert: data must fit within VM memory.
-        if (data_ptr + data_len > VM_MEMORY_SIZE) {
+        if (data_ptr + data_len > memory_size) {
             return SyscallResult.fail(BasinError.invalid_argument); // Data exceeds VM memory
         }
         
@@ -1815,37 +3036,21 @@ pub const BasinKernel = struct {
         };
         
         // Assert: Handle must be allocated.
-        std.debug.assert(self.handles[handle_idx].allocated);
-        std.debug.assert(self.handles[handle_idx].id == handle);
+        std.debug.assert(self.handles.entries[handle_idx].allocated);
+        std.debug.assert(self.handles.entries[handle_idx].id == handle);
         
-        var file_handle = &self.handles[handle_idx];
+        const file_handle = &self.handles.entries[handle_idx];
         
         // Assert: Handle must be writable.
         if (!file_handle.flags.write) {
             return SyscallResult.fail(BasinError.permission_denied); // Handle not writable
         }
         
-        // Calculate bytes to write (min of data length and available buffer space).
-        const data_len_u32 = @as(u32, @intCast(data_len));
-        const max_buffer_size = file_handle.buffer.len;
-        const available_space = if (file_handle.position < max_buffer_size)
-            @as(u32, @intCast(max_buffer_size - file_handle.position))
-        else
-            0;
-        const bytes_to_write = @min(data_len_u32, available_space);
-        
-        // Write data to handle buffer (simulated - in real implementation, would read from VM memory).
-        // For now, just update position and buffer size.
-        file_handle.position += bytes_to_write;
-        if (file_handle.position > file_handle.buffer_size) {
-            file_handle.buffer_size = @as(u32, @intCast(file_handle.position));
-        }
-        
-        // Assert: Position and buffer size must be valid.
-        std.debug.assert(file_handle.position <= max_buffer_size);
-        std.debug.assert(file_handle.buffer_size <= max_buffer_size);
-        
-        const bytes_written: u64 = @as(u64, @intCast(bytes_to_write));
+        // Copy data from the guest buffer into file pages (short, then out_of_memory, once
+        // the page cache is full).
+        const bytes_written = self.file_transfer(file_handle, data_ptr, data_len, .write) catch |err| {
+            return SyscallResult.fail(err); // Page cache full
+        };
         const result = SyscallResult.ok(bytes_written);
         
         // Assert: result must be success (not error).
@@ -1883,16 +3088,22 @@ pub const BasinKernel = struct {
         };
         
         // Assert: Handle must be allocated.
-        std.debug.assert(self.handles[handle_idx].allocated);
-        std.debug.assert(self.handles[handle_idx].id == handle);
-        
-        // Close handle (free entry).
-        var file_handle = &self.handles[handle_idx];
-        file_handle.allocated = false;
-        file_handle.id = 0;
-        file_handle.path_len = 0;
+        std.debug.assert(self.handles.entries[handle_idx].allocated);
+        std.debug.assert(self.handles.entries[handle_idx].id == handle);
+        
+        // Close handle (free entry; the handle ID goes stale).
+        const file_handle = &self.handles.entries[handle_idx];
+        const inode_idx = file_handle.inode;
         file_handle.position = 0;
-        file_handle.buffer_size = 0;
+        self.handles.free_slot(handle_idx);
+        
+        // Last close of an unlinked file frees its inode and pages.
+        const inode = &self.inodes.entries[inode_idx];
+        std.debug.assert(inode.allocated and inode.open_count > 0);
+        inode.open_count -= 1;
+        if (!inode.linked and inode.open_count == 0) {
+            self.release_inode(inode_idx);
+        }
         
         // Assert: Handle must be unallocated after close.
         std.debug.assert(!file_handle.allocated);
@@ -1927,8 +3138,8 @@ pub const BasinKernel = struct {
             return SyscallResult.fail(BasinError.invalid_argument); // Null pointer
         }
         
-        const VM_MEMORY_SIZE: u64 = 4 * 1024 * 1024; // 4MB default
-        if (path_ptr >= VM_MEMORY_SIZE) {
+        const memory_size = self.user_memory_size;
+        if (path_ptr >= memory_size) {
             return SyscallResult.fail(BasinError.invalid_argument); // Path pointer exceeds VM memory
         }
         
@@ -1941,26 +3152,26 @@ pub const BasinKernel = struct {
         }
         
         // Assert: path must fit within VM memory.
-        if (path_ptr + path_len > VM_MEMORY_SIZE) {
+        if (path_ptr + path_len > memory_size) {
             return SyscallResult.fail(BasinError.invalid_argument); // Path exceeds VM memory
         }
         
-        // Find handle by path and remove it (simulated file deletion).
-        // For now, search for handle with matching path and mark as deleted.
-        var found: bool = false;
-        for (0..MAX_HANDLES) |i| {
-            if (self.handles[i].allocated and self.handles[i].path_len == @as(u32, @intCast(path_len))) {
-                // In real implementation, would compare path strings.
-                // For now, just mark as deleted if path length matches.
-                self.handles[i].allocated = false;
-                self.handles[i].id = 0;
-                found = true;
-                break;
-            }
+        // Paths longer than an inode name cannot name a file.
+        if (path_len > 255) {
+            return SyscallResult.fail(BasinError.not_found);
         }
+        var path = [_]u8{0} ** 256;
+        self.copy_from_user(path_ptr, path[0..@intCast(path_len)]);
         
-        if (!found) {
+        const inode_idx = self.find_inode(path[0..@intCast(path_len)]) orelse {
             return SyscallResult.fail(BasinError.not_found); // File not found
+        };
+        
+        // Remove the name; open handles keep the data until their last close.
+        const inode = &self.inodes.entries[inode_idx];
+        inode.linked = false;
+        if (inode.open_count == 0) {
+            self.release_inode(inode_idx);
         }
         
         const result = SyscallResult.ok(0);
@@ -1984,8 +3195,8 @@ pub const BasinKernel = struct {
             return SyscallResult.fail(BasinError.invalid_argument); // Null pointer
         }
         
-        const VM_MEMORY_SIZE: u64 = 4 * 1024 * 1024; // 4MB default
-        if (old_path_ptr >= VM_MEMORY_SIZE) {
+        const memory_size = self.user_memory_size;
+        if (old_path_ptr >= memory_size) {
             return SyscallResult.fail(BasinError.invalid_argument); // Old path pointer exceeds VM memory
         }
         
@@ -1993,7 +3204,7 @@ pub const BasinKernel = struct {
         if (new_path_ptr == 0) {
             return SyscallResult.fail(BasinError.invalid_argument); // Null pointer
         }
-        if (new_path_ptr >= VM_MEMORY_SIZE) {
+        if (new_path_ptr >= memory_size) {
             return SyscallResult.fail(BasinError.invalid_argument); // New path pointer exceeds VM memory
         }
         
@@ -2006,30 +3217,47 @@ pub const BasinKernel = struct {
         }
         
         // Assert: paths must fit within VM memory.
-        if (old_path_ptr + old_path_len > VM_MEMORY_SIZE) {
+        if (old_path_ptr + old_path_len > memory_size) {
             return SyscallResult.fail(BasinError.invalid_argument); // Old path exceeds VM memory
         }
-        if (new_path_ptr + new_path_len > VM_MEMORY_SIZE) {
+        if (new_path_ptr + new_path_len > memory_size) {
             return SyscallResult.fail(BasinError.invalid_argument); // New path exceeds VM memory
         }
         
-        // Find handle by old path and update to new path (simulated rename).
-        // For now, search for handle with matching path length and update.
-        var found: bool = false;
-        for (0..MAX_HANDLES) |i| {
-            if (self.handles[i].allocated and self.handles[i].path_len == @as(u32, @intCast(old_path_len))) {
-                // In real implementation, would compare path strings and update.
-                // For now, just update path length if it matches.
-                self.handles[i].path_len = @as(u32, @intCast(new_path_len));
-                found = true;
-                break;
-            }
+        // Paths longer than an inode name cannot name a file.
+        if (old_path_len > 255) {
+            return SyscallResult.fail(BasinError.not_found);
         }
+        if (new_path_len > 255) {
+            return SyscallResult.fail(BasinError.invalid_argument); // New path too long
+        }
+        var old_path = [_]u8{0} ** 256;
+        var new_path = [_]u8{0} ** 256;
+        self.copy_from_user(old_path_ptr, old_path[0..@intCast(old_path_len)]);
+        self.copy_from_user(new_path_ptr, new_path[0..@intCast(new_path_len)]);
         
-        if (!found) {
+        const inode_idx = self.find_inode(old_path[0..@intCast(old_path_len)]) orelse {
             return SyscallResult.fail(BasinError.not_found); // File not found
+        };
+        
+        // Renaming onto an existing file replaces it (as unlink would).
+        if (self.find_inode(new_path[0..@intCast(new_path_len)])) |target_idx| {
+            if (target_idx != inode_idx) {
+                const target = &self.inodes.entries[target_idx];
+                target.linked = false;
+                if (target.open_count == 0) {
+                    self.release_inode(target_idx);
+                }
+            }
         }
         
+        const inode = &self.inodes.entries[inode_idx];
+        inode.path = new_path;
+        inode.path_len = @intCast(new_path_len);
+        
+        // Assert: the file must now be found under its new name.
+        std.debug.assert(self.find_inode(new_path[0..@intCast(new_path_len)]) == inode_idx);
+        
         const result = SyscallResult.ok(0);
         return result;
     }
@@ -2054,8 +3282,8 @@ pub const BasinKernel = struct {
             return SyscallResult.fail(BasinError.invalid_argument); // Null pointer
         }
         
-        const VM_MEMORY_SIZE: u64 = 4 * 1024 * 1024; // 4MB default
-        if (path_ptr >= VM_MEMORY_SIZE) {
+        const memory_size = self.user_memory_size;
+        if (path_ptr >= memory_size) {
             return SyscallResult.fail(BasinError.invalid_argument); // Path pointer exceeds VM memory
         }
         
@@ -2068,17 +3296,16 @@ pub const BasinKernel = struct {
         }
         
         // Assert: path must fit within VM memory.
-        if (path_ptr + path_len > VM_MEMORY_SIZE) {
+        if (path_ptr + path_len > memory_size) {
             return SyscallResult.fail(BasinError.invalid_argument); // Path exceeds VM memory
         }
         
-        // Check if directory already exists (simulated).
-        // For now, just check if handle with same path exists.
-        for (0..MAX_HANDLES) |i| {
-            if (self.handles[i].allocated and self.handles[i].path_len == @as(u32, @intCast(path_len))) {
-                // In real implementation, would compare path strings.
-                // For now, return error if path length matches (directory exists).
-                return SyscallResult.fail(BasinError.invalid_argument); // Directory already exists
+        // Check if a file already exists at path.
+        if (path_len <= 255) {
+            var path = [_]u8{0} ** 256;
+            self.copy_from_user(path_ptr, path[0..@intCast(path_len)]);
+            if (self.find_inode(path[0..@intCast(path_len)]) != null) {
+                return SyscallResult.fail(BasinError.invalid_argument); // Path already exists
             }
         }
         
@@ -2108,8 +3335,8 @@ pub const BasinKernel = struct {
             return SyscallResult.fail(BasinError.invalid_argument);
         }
         
-        const VM_MEMORY_SIZE: u64 = 4 * 1024 * 1024; // 4MB default
-        if (path_ptr >= VM_MEMORY_SIZE) {
+        const memory_size = self.user_memory_size;
+        if (path_ptr >= memory_size) {
             return SyscallResult.fail(BasinError.invalid_argument);
         }
         
@@ -2118,30 +3345,16 @@ pub const BasinKernel = struct {
             return SyscallResult.fail(BasinError.invalid_argument);
         }
         
-        // Find free directory handle slot.
-        var slot: ?usize = null;
-        for (0..MAX_DIR_HANDLES) |i| {
-            if (!self.dir_handles[i].allocated) {
-                slot = i;
-                break;
-            }
-        }
-        
-        if (slot == null) {
+        // Allocate directory handle (ID encodes slot and generation).
+        const idx = self.dir_handles.alloc() orelse {
             return SyscallResult.fail(BasinError.out_of_memory);
-        }
-        
-        const idx = slot.?;
-        
-        // Allocate directory handle.
-        const handle_id = self.next_dir_handle_id;
-        self.next_dir_handle_id += 1;
+        };
+        const dir = &self.dir_handles.entries[idx];
+        const handle_id = dir.id;
         
         // Copy path (simulated - in real implementation, would read from VM memory).
-        self.dir_handles[idx].id = handle_id;
-        self.dir_handles[idx].path_len = @as(u32, @intCast(path_len));
-        self.dir_handles[idx].position = 0;
-        self.dir_handles[idx].allocated = true;
+        dir.path_len = @as(u32, @intCast(path_len));
+        dir.position = 0;
         
         // Return directory handle ID.
         const result = SyscallResult.ok(handle_id);
@@ -2172,8 +3385,8 @@ pub const BasinKernel = struct {
             return SyscallResult.fail(BasinError.invalid_argument);
         }
         
-        const VM_MEMORY_SIZE: u64 = 4 * 1024 * 1024; // 4MB default
-        if (entry_ptr >= VM_MEMORY_SIZE) {
+        const memory_size = self.user_memory_size;
+        if (entry_ptr >= memory_size) {
             return SyscallResult.fail(BasinError.invalid_argument);
         }
         
@@ -2183,30 +3396,21 @@ pub const BasinKernel = struct {
         }
         
         // Find directory handle.
-        var found: ?usize = null;
-        for (0..MAX_DIR_HANDLES) |i| {
-            if (self.dir_handles[i].allocated and self.dir_handles[i].id == dir_handle) {
-                found = i;
-                break;
-            }
-        }
-        
-        if (found == null) {
+        const idx = self.dir_handles.find(dir_handle) orelse {
             return SyscallResult.fail(BasinError.invalid_argument);
-        }
-        
-        const idx = found.?;
+        };
+        const dir = &self.dir_handles.entries[idx];
         
         // Simulated directory reading: return empty (end of directory).
         // In real implementation, would read directory entries from file system.
         // For now, return 0 (no more entries) after first read.
-        if (self.dir_handles[idx].position > 0) {
+        if (dir.position > 0) {
             return SyscallResult.ok(0); // End of directory
         }
         
         // First read: return stub entry name "."
         // In real implementation, would write entry name to entry_ptr.
-        self.dir_handles[idx].position += 1;
+        dir.position += 1;
         
         // Return bytes written (simulated - would be actual entry name length).
         const result = SyscallResult.ok(1); // 1 byte for "."
@@ -2235,23 +3439,20 @@ pub const BasinKernel = struct {
         }
         
         // Find and free directory handle.
-        var found: bool = false;
-        for (0..MAX_DIR_HANDLES) |i| {
-            if (self.dir_handles[i].allocated and self.dir_handles[i].id == dir_handle) {
-                self.dir_handles[i] = DirectoryHandle.init();
-                found = true;
-                break;
-            }
-        }
-        
-        if (!found) {
+        const idx = self.dir_handles.find(dir_handle) orelse {
             return SyscallResult.fail(BasinError.invalid_argument);
-        }
+        };
+        self.dir_handles.entries[idx].path_len = 0;
+        self.dir_handles.entries[idx].position = 0;
+        self.dir_handles.free_slot(idx);
         
         const result = SyscallResult.ok(0);
         return result;
     }
     
+    /// Write the time of clock_id (u64 seconds, u64 nanoseconds) to timespec_ptr.
+    /// Note: Guests read the same clocks from the shared time page without a trap.
+    /// Returns: 0; invalid_argument for unknown clocks or a bad timespec pointer.
     fn syscall_clock_gettime(
         self: *BasinKernel,
         clock_id: u64,
@@ -2267,44 +3468,41 @@ pub const BasinKernel = struct {
         _ = _arg3;
         _ = _arg4;
         
-        // Assert: clock_id must be valid (monotonic or realtime).
-        const clock = @as(?ClockId, @enumFromInt(@as(u32, @truncate(clock_id))));
-        if (clock == null) {
+        // Validate: clock_id must name a clock (monotonic or realtime).
+        const clock = std.meta.intToEnum(ClockId, clock_id) catch {
             return BasinError.invalid_argument; // Invalid clock ID
-        }
+        };
         
         // Assert: timespec pointer must be valid (non-zero, within VM memory).
         if (timespec_ptr == 0) {
             return BasinError.invalid_argument; // Null pointer
         }
         
-        const VM_MEMORY_SIZE: u64 = 4 * 1024 * 1024; // 4MB default (matches syscall_map)
-        if (timespec_ptr >= VM_MEMORY_SIZE) {
+        const memory_size = self.user_memory_size;
+        if (timespec_ptr >= memory_size) {
             return BasinError.invalid_argument; // Timespec pointer exceeds VM memory
         }
         
         // Assert: timespec must fit within VM memory (16 bytes: seconds + nanoseconds).
         const TIMESPEC_SIZE: u64 = 16; // 8 bytes seconds + 8 bytes nanoseconds
-        if (timespec_ptr + TIMESPEC_SIZE > VM_MEMORY_SIZE) {
+        if (timespec_ptr + TIMESPEC_SIZE > memory_size) {
             return BasinError.invalid_argument; // Timespec exceeds VM memory
         }
         
-        // TODO: Implement actual time retrieval (when timer is implemented).
-        // For now, return stub (zero timestamp).
-        // Why: Simple stub - matches current kernel development stage.
-        // Note: In full implementation, we would:
-        // - Get current time from system timer (SBI timer or hardware clock)
-        // - Write seconds and nanoseconds to timespec structure
-        // - Handle different clock types (monotonic vs realtime)
-        
-        // Stub: Return zero timestamp (simple implementation).
-        const seconds: u64 = 0;
-        const nanoseconds: u64 = 0;
-        const result = SyscallResult.ok(seconds);
+        // Guest time since boot; realtime adds the host-set epoch offset (same as the time page).
+        const monotonic = self.monotonic_ns();
+        const now_ns = switch (clock) {
+            .monotonic => monotonic,
+            .realtime => self.realtime_base_ns +| monotonic,
+        };
+        const seconds: u64 = now_ns / std.time.ns_per_s;
+        const nanoseconds: u64 = now_ns % std.time.ns_per_s;
+        self.store_user_int(u64, timespec_ptr, seconds);
+        self.store_user_int(u64, timespec_ptr + 8, nanoseconds);
+        const result = SyscallResult.ok(0);
         
         // Assert: result must be success (not error).
         std.debug.assert(result == .success);
-        std.debug.assert(result.success == seconds);
         
         // Assert: Nanoseconds must be valid (0-999999999).
         std.debug.assert(nanoseconds < 1000000000);
@@ -2312,6 +3510,8 @@ pub const BasinKernel = struct {
         return result;
     }
     
+    /// Block the current process until guest time reaches timestamp.
+    /// Returns: 0 once it has been woken (the wakeup itself is O(1) per wheel tick).
     fn syscall_sleep_until(
         self: *BasinKernel,
         timestamp: u64,
@@ -2328,24 +3528,25 @@ pub const BasinKernel = struct {
         _ = _arg3;
         _ = _arg4;
         
-        // Assert: timestamp must be valid (non-zero, reasonable value).
-        // Note: Timestamp is nanoseconds since epoch (or boot, depending on clock type).
-        // For now, accept any non-zero value (validation depends on clock implementation).
+        // Assert: timestamp must be valid (non-zero).
+        // Note: Timestamp is guest time (the guest's mtime, readable as the time CSR).
         if (timestamp == 0) {
             return BasinError.invalid_argument; // Zero timestamp (invalid)
         }
         
-        // TODO: Implement actual sleep until timestamp (when timer is implemented).
-        // For now, return stub success (immediate return).
-        // Why: Simple stub - matches current kernel development stage.
-        // Note: In full implementation, we would:
-        // - Get current time from system timer
-        // - Calculate sleep duration (timestamp - current_time)
-        // - Sleep until timestamp is reached
-        // - Return error if timestamp is in the past
-        // - Handle timer interrupts/wakeups
+        // Sleep in the timer wheel until the first tick at or after timestamp.
+        // Note: A timestamp already passed yields instead (no current process: returns).
+        if (self.current != NO_PROCESS) {
+            const now = self.guest_time();
+            if (timestamp > now) {
+                const tick_mask = (@as(u64, 1) << TIMER_TICK_SHIFT) - 1;
+                const wake_tick = (timestamp >> TIMER_TICK_SHIFT) + @intFromBool(timestamp & tick_mask != 0);
+                self.processes.entries[self.current].state = .sleeping;
+                self.sleepers.arm(self.current, wake_tick);
+            }
+            self.need_resched = true;
+        }
         
-        // Stub: Return success immediately (simple implementation).
         const result = SyscallResult.ok(0);
         
         // Assert: result must be success (not error).
@@ -2355,11 +3556,17 @@ pub const BasinKernel = struct {
         return result;
     }
     
+    /// Write system information to info_ptr and, with stats_ptr, one syscall's statistics.
+    /// Contract: info_ptr receives total_memory (8), available_memory (8), uptime_ns (8),
+    /// cpu_cores (4), load_avg_1min (4); it may be 0 when stats_ptr is not. stats_ptr
+    /// receives the syscall_stats.Record of syscall number stats_syscall (0..SYSCALL_MAX).
+    /// Returns: 0; 1 when a stats record was written with statistics compiled in (built
+    /// without -Dkernel-stats=true the record is all zeros and the result 0).
     fn syscall_sysinfo(
         self: *BasinKernel,
         info_ptr: u64,
-        _arg2: u64,
-        _arg3: u64,
+        stats_syscall: u64,
+        stats_ptr: u64,
         _arg4: u64,
     ) BasinError!SyscallResult {
         // Assert: self pointer must be valid.
@@ -2367,48 +3574,162 @@ pub const BasinKernel = struct {
         std.debug.assert(self_ptr != 0);
         std.debug.assert(self_ptr % @alignOf(BasinKernel) == 0);
         
-        _ = _arg2;
-        _ = _arg3;
         _ = _arg4;
         
-        // Assert: info pointer must be valid (non-zero, within VM memory).
-        if (info_ptr == 0) {
+        // Assert: something must be asked for.
+        if (info_ptr == 0 and stats_ptr == 0) {
             return BasinError.invalid_argument; // Null pointer
         }
         
-        const VM_MEMORY_SIZE: u64 = 4 * 1024 * 1024; // 4MB default (matches syscall_map)
-        if (info_ptr >= VM_MEMORY_SIZE) {
-            return BasinError.invalid_argument; // Info pointer exceeds VM memory
-        }
-        
         // Assert: SysInfo structure must fit within VM memory.
-        // SysInfo size: total_memory (8) + available_memory (8) + cpu_cores (4) + 
-        //               uptime_ns (8) + load_avg_1min (4) = 32 bytes
         const SYSINFO_SIZE: u64 = 32;
-        if (info_ptr + SYSINFO_SIZE > VM_MEMORY_SIZE) {
+        const memory_size = self.user_memory_size;
+        if (info_ptr != 0 and (info_ptr >= memory_size or SYSINFO_SIZE > memory_size - info_ptr)) {
             return BasinError.invalid_argument; // SysInfo exceeds VM memory
         }
         
-        // TODO: Implement actual system information retrieval (when system stats are tracked).
-        // For now, return stub (basic info).
-        // Why: Simple stub - matches current kernel development stage.
-        // Note: In full implementation, we would:
-        // - Get total/available memory from memory allocator
-        // - Get CPU core count from hardware/SBI
-        // - Get uptime from system timer
-        // - Calculate load average from process scheduler
-        // - Write SysInfo structure to info_ptr
+        // Assert: stats record must fit within VM memory and name a syscall slot.
+        const RECORD_SIZE: u64 = @sizeOf(syscall_stats.Record);
+        if (stats_ptr != 0) {
+            if (stats_ptr >= memory_size or RECORD_SIZE > memory_size - stats_ptr) {
+                return BasinError.invalid_argument; // Record exceeds VM memory
+            }
+            if (stats_syscall > SYSCALL_MAX) {
+                return BasinError.invalid_argument; // No such syscall slot
+            }
+        }
+        
+        if (info_ptr != 0) {
+            const info = self.system_info();
+            self.store_user_int(u64, info_ptr, info.total_memory);
+            self.store_user_int(u64, info_ptr + 8, info.available_memory);
+            self.store_user_int(u64, info_ptr + 16, info.uptime_ns);
+            self.store_user_int(u32, info_ptr + 24, info.cpu_cores);
+            self.store_user_int(u32, info_ptr + 28, info.load_avg_1min);
+        }
+        if (stats_ptr == 0) return SyscallResult.ok(0);
         
-        // Stub: Return success (simple implementation).
-        // Note: Actual SysInfo structure would be written to info_ptr in full implementation.
-        const result = SyscallResult.ok(0);
+        const record = self.syscall_statistics(@intCast(stats_syscall));
+        self.copy_to_user(stats_ptr, std.mem.asBytes(&record));
+        const result = SyscallResult.ok(@intFromBool(syscall_stats.enabled));
         
         // Assert: result must be success (not error).
         std.debug.assert(result == .success);
-        std.debug.assert(result.success == 0); // Sysinfo returns 0 on success
+        std.debug.assert(result.success <= 1);
         
         return result;
     }
+    
+    fn syscall_readv(
+        self: *BasinKernel,
+        handle: u64,
+        iov_ptr: u64,
+        iov_count: u64,
+        _arg4: u64,
+    ) BasinError!SyscallResult {
+        _ = _arg4;
+        return self.transfer_vectored(handle, iov_ptr, iov_count, .read);
+    }
+    
+    fn syscall_writev(
+        self: *BasinKernel,
+        handle: u64,
+        iov_ptr: u64,
+        iov_count: u64,
+        _arg4: u64,
+    ) BasinError!SyscallResult {
+        _ = _arg4;
+        return self.transfer_vectored(handle, iov_ptr, iov_count, .write);
+    }
+    
+    /// Move bytes between a file handle and iov_count guest buffers (readv/writev).
+    /// Why: One ecall and one handle lookup serve many buffers.
+    /// Contract: Every iovec is validated before any byte moves; a short transfer stops
+    /// at the first buffer the file (read) or page cache (write) cannot fill.
+    /// Returns: Total bytes moved, invalid_argument for a bad iovec array (or no
+    /// attached guest RAM to read it from), invalid_handle, permission_denied.
+    fn transfer_vectored(
+        self: *BasinKernel,
+        handle: u64,
+        iov_ptr: u64,
+        iov_count: u64,
+        comptime direction: Transfer,
+    ) BasinError!SyscallResult {
+        // Assert: self pointer must be valid.
+        const self_ptr = @intFromPtr(self);
+        std.debug.assert(self_ptr != 0);
+        std.debug.assert(self_ptr % @alignOf(BasinKernel) == 0);
+        
+        // Assert: handle must be valid (non-zero).
+        if (handle == 0) {
+            return SyscallResult.fail(BasinError.invalid_argument); // Invalid handle
+        }
+        
+        // Assert: iovec count must be 1..MAX_IOVECS.
+        if (iov_count == 0 or iov_count > MAX_IOVECS) {
+            return SyscallResult.fail(BasinError.invalid_argument);
+        }
+        
+        // Assert: iovec array must lie within VM memory (and be readable).
+        const memory_size = self.user_memory_size;
+        const iov_bytes = iov_count * @sizeOf(IoVec);
+        if (iov_ptr == 0 or iov_ptr >= memory_size or iov_bytes > memory_size - iov_ptr) {
+            return SyscallResult.fail(BasinError.invalid_argument);
+        }
+        if (self.user_memory == null) {
+            return SyscallResult.fail(BasinError.invalid_argument); // No guest RAM to read iovecs from
+        }
+        
+        // Fetch and validate every iovec before touching the handle.
+        var raw: [MAX_IOVECS * @sizeOf(IoVec)]u8 = undefined;
+        self.copy_from_user(iov_ptr, raw[0..@intCast(iov_bytes)]);
+        var iovs: [MAX_IOVECS]IoVec = undefined;
+        var total: u64 = 0;
+        for (iovs[0..@intCast(iov_count)], 0..) |*iov, i| {
+            const entry = raw[i * @sizeOf(IoVec) ..][0..@sizeOf(IoVec)];
+            iov.* = .{
+                .base = std.mem.readInt(u64, entry[0..8], .little),
+                .len = std.mem.readInt(u64, entry[8..16], .little),
+            };
+            if (iov.len == 0) continue;
+            if (iov.base == 0 or iov.base >= memory_size or iov.len > memory_size - iov.base) {
+                return SyscallResult.fail(BasinError.invalid_argument); // Buffer outside VM memory
+            }
+            if (iov.len > MAX_IO_BYTES - total) {
+                return SyscallResult.fail(BasinError.invalid_argument); // Transfer too large (> 1MB)
+            }
+            total += iov.len;
+        }
+        
+        // Find handle by ID.
+        const handle_idx = self.find_handle_by_id(handle) orelse {
+            return SyscallResult.fail(BasinError.invalid_handle); // Handle not found
+        };
+        const file_handle = &self.handles.entries[handle_idx];
+        const allowed = switch (direction) {
+            .read => file_handle.flags.read,
+            .write => file_handle.flags.write,
+        };
+        if (!allowed) {
+            return SyscallResult.fail(BasinError.permission_denied);
+        }
+        
+        var moved: u64 = 0;
+        for (iovs[0..@intCast(iov_count)]) |iov| {
+            if (iov.len == 0) continue;
+            const count = self.file_transfer(file_handle, iov.base, iov.len, direction) catch |err| {
+                if (moved == 0) return SyscallResult.fail(err);
+                break;
+            };
+            moved += count;
+            if (count < iov.len) break;
+        }
+        
+        // Assert: Transfer must not exceed the validated total.
+        std.debug.assert(moved <= total);
+        
+        return SyscallResult.ok(moved);
+    }
 };
 
 /// Basin Kernel module exports.
@@ -0,0 +1,75 @@
+//! IPC channel ring layout for Basin kernel channels.
+//!
+//! A channel is a bounded single-producer/single-consumer ring in shared guest pages.
+//! The producer owns tail and the consumer owns head. Both are free-running u32 counters
+//! (slot = counter % SLOTS), so tail - head == SLOTS is full and tail == head is empty.
+//! A slot is published by storing tail after the slot (release) and consumed by storing
+//! head after reading it, so either end may run in the kernel (channel_send/recv) or
+//! directly in userspace without a syscall. Messages up to INLINE_MAX bytes are copied
+//! into the slot; larger ones name a whole mapping whose ownership passes to the receiver
+//! without copying a byte (kernel only: ownership is kernel state).
+//! Note: Fields are little-endian (guest byte order). userspace/stdlib.zig mirrors this
+//! layout; change both together.
+
+const std = @import("std");
+
+/// Slots per ring (power of two: counters wrap cleanly).
+pub const SLOTS: u32 = 32;
+
+/// Largest message copied inline (bytes).
+pub const INLINE_MAX: u32 = 112;
+
+/// Guest bytes per ring mapping (header + slots, rounded to pages).
+pub const RING_BYTES: u64 = 2 * 4096;
+
+/// Header magic ("CHAN").
+pub const MAGIC: u32 = 0x4E41_4843;
+
+/// Slot payload kind.
+pub const Kind = enum(u32) {
+    /// len bytes in data.
+    inline_bytes = 1,
+    /// len bytes in the mapping at pages (ownership in transit).
+    pages = 2,
+};
+
+/// Ring header: producer and consumer counters on separate cache lines.
+pub const Header = extern struct {
+    magic: u32,
+    slots: u32,
+    _reserved0: [56]u8,
+    /// Next slot to consume (written by the consumer only).
+    head: u32,
+    _reserved1: [60]u8,
+    /// Next slot to fill (written by the producer only).
+    tail: u32,
+    _reserved2: [124]u8,
+};
+
+/// One message.
+pub const Slot = extern struct {
+    len: u32,
+    kind: u32,
+    /// Mapping address (kind == pages).
+    pages: u64,
+    data: [INLINE_MAX]u8,
+};
+
+pub const HEAD_OFFSET: u64 = @offsetOf(Header, "head");
+pub const TAIL_OFFSET: u64 = @offsetOf(Header, "tail");
+
+/// Bytes of a slot before its inline data.
+pub const SLOT_HEADER_BYTES: u64 = @offsetOf(Slot, "data");
+
+/// Offset of the slot for counter within the ring.
+pub fn slot_offset(counter: u32) u64 {
+    return @sizeOf(Header) + @as(u64, counter % SLOTS) * @sizeOf(Slot);
+}
+
+comptime {
+    std.debug.assert(std.math.isPowerOfTwo(SLOTS));
+    std.debug.assert(@sizeOf(Header) == 256);
+    std.debug.assert(@sizeOf(Slot) == 128);
+    std.debug.assert(@sizeOf(Header) + SLOTS * @sizeOf(Slot) <= RING_BYTES);
+    std.debug.assert(RING_BYTES % 4096 == 0);
+}
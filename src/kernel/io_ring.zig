@@ -0,0 +1,97 @@
+//! Batched syscall ring layout for Basin kernel io_rings.
+//!
+//! An io_ring is a submission queue (SQ) and a completion queue (CQ) in shared guest pages.
+//! The guest fills submission entries (a syscall number and its four arguments) and
+//! advances sq_tail; the kernel consumes them in order on io_ring_enter (or on its own at
+//! scheduling points for rings set up with SETUP_POLL), runs each through the ordinary
+//! syscall path and posts one completion per entry carrying the a0 word the syscall would
+//! have returned. The guest reaps completions and advances cq_head. Counters are
+//! free-running u32s (slot = counter % entries), as in channel rings.
+//! Why: One ecall (or none) for a whole batch of opens, reads, writes and maps.
+//! Note: Fields are little-endian (guest byte order). userspace/stdlib.zig mirrors this
+//! layout; change both together.
+
+const std = @import("std");
+
+/// Submission slots per ring (power of two: counters wrap cleanly).
+pub const SQ_ENTRIES: u32 = 64;
+
+/// Completion slots per ring (twice the SQ: a full SQ never waits on reaping alone).
+pub const CQ_ENTRIES: u32 = 128;
+
+/// Guest bytes per ring mapping (header + SQ + CQ, rounded to pages).
+pub const RING_BYTES: u64 = 2 * 4096;
+
+/// Header magic ("IORG").
+pub const MAGIC: u32 = 0x4752_4F49;
+
+/// io_ring_setup flag: the kernel drains the SQ at scheduling points without an ecall.
+pub const SETUP_POLL: u32 = 1;
+
+/// Ring header: each counter on its own cache line.
+pub const Header = extern struct {
+    magic: u32,
+    sq_entries: u32,
+    cq_entries: u32,
+    /// io_ring_setup flags.
+    flags: u32,
+    _reserved0: [48]u8,
+    /// Next submission the kernel consumes (written by the kernel only).
+    sq_head: u32,
+    _reserved1: [60]u8,
+    /// Next submission slot to fill (written by the guest only).
+    sq_tail: u32,
+    _reserved2: [60]u8,
+    /// Next completion to reap (written by the guest only).
+    cq_head: u32,
+    _reserved3: [60]u8,
+    /// Next completion slot to fill (written by the kernel only).
+    cq_tail: u32,
+    _reserved4: [60]u8,
+};
+
+/// One submitted syscall.
+pub const Sqe = extern struct {
+    /// Syscall number (Syscall enum value).
+    opcode: u32,
+    /// Reserved (must be 0).
+    flags: u32,
+    /// Copied to the completion untouched.
+    user_data: u64,
+    /// Syscall arguments a0..a3.
+    args: [4]u64,
+    _reserved: [2]u64,
+};
+
+/// One completed syscall.
+pub const Cqe = extern struct {
+    user_data: u64,
+    /// a0 word: non-negative success value, or negative error code.
+    result: u64,
+};
+
+pub const SQ_HEAD_OFFSET: u64 = @offsetOf(Header, "sq_head");
+pub const SQ_TAIL_OFFSET: u64 = @offsetOf(Header, "sq_tail");
+pub const CQ_HEAD_OFFSET: u64 = @offsetOf(Header, "cq_head");
+pub const CQ_TAIL_OFFSET: u64 = @offsetOf(Header, "cq_tail");
+
+/// Offset of the submission slot for counter within the ring.
+pub fn sqe_offset(counter: u32) u64 {
+    return @sizeOf(Header) + @as(u64, counter % SQ_ENTRIES) * @sizeOf(Sqe);
+}
+
+/// Offset of the completion slot for counter within the ring.
+pub fn cqe_offset(counter: u32) u64 {
+    return @sizeOf(Header) + SQ_ENTRIES * @sizeOf(Sqe) + @as(u64, counter % CQ_ENTRIES) * @sizeOf(Cqe);
+}
+
+comptime {
+    std.debug.assert(std.math.isPowerOfTwo(SQ_ENTRIES));
+    std.debug.assert(std.math.isPowerOfTwo(CQ_ENTRIES));
+    std.debug.assert(CQ_ENTRIES >= SQ_ENTRIES);
+    std.debug.assert(@sizeOf(Header) == 320);
+    std.debug.assert(@sizeOf(Sqe) == 64);
+    std.debug.assert(@sizeOf(Cqe) == 16);
+    std.debug.assert(@sizeOf(Header) + SQ_ENTRIES * @sizeOf(Sqe) + CQ_ENTRIES * @sizeOf(Cqe) <= RING_BYTES);
+    std.debug.assert(RING_BYTES % 4096 == 0);
+}
@@ -0,0 +1,249 @@
+//! Shared page cache for Basin kernel files.
+//!
+//! File data lives in 4KB pages keyed by (inode, page index), shared by every handle
+//! on the inode. Pages are found through an open-addressed index and kept in LRU order;
+//! when the runtime budget is reached the least recently used page is evicted, written
+//! back first if dirty. Without a backing store every page is the only copy of its data,
+//! so nothing is evictable and the budget caps the total size of all files; get then
+//! returns null and the kernel reports out_of_memory.
+
+const std = @import("std");
+
+/// Bytes per cached page.
+pub const PAGE_SIZE: usize = 4096;
+
+/// Empty index bucket / list end.
+const NONE: u32 = std.math.maxInt(u32);
+
+/// Host storage evicted pages are written back to (optional).
+/// Why: Lets files outgrow the cache budget; the kernel keeps no host types.
+pub const Backing = struct {
+    context: ?*anyopaque = null,
+    /// Fill page with the stored contents of (inode, index); false if never stored.
+    load: *const fn (context: ?*anyopaque, inode: u32, index: u32, page: *[PAGE_SIZE]u8) bool,
+    /// Store a dirty page that is being evicted.
+    store: *const fn (context: ?*anyopaque, inode: u32, index: u32, page: *const [PAGE_SIZE]u8) void,
+    /// Forget stored pages of inode at index >= from (truncate, unlink).
+    discard: *const fn (context: ?*anyopaque, inode: u32, from: u32) void,
+};
+
+/// Page cache of at most capacity resident pages.
+/// Grain Style: Static allocation (capacity is comptime), runtime budget <= capacity.
+/// Contract: inode keys are non-zero; callers own inode numbering.
+pub fn PageCache(comptime capacity: u32) type {
+    comptime {
+        std.debug.assert(capacity > 0);
+        std.debug.assert(capacity < NONE / 2);
+    }
+    const buckets: u32 = std.math.ceilPowerOfTwo(u32, capacity * 2) catch unreachable;
+
+    return struct {
+        pages: [capacity][PAGE_SIZE]u8 = undefined,
+        slots: [capacity]Slot = [_]Slot{.{}} ** capacity,
+        /// (inode, index) -> slot, linear probing with backward-shift deletion.
+        index: [buckets]u32 = [_]u32{NONE} ** buckets,
+        /// Stack of free slots.
+        free: [capacity]u32 = initial_free(),
+        free_count: u32 = capacity,
+        /// LRU list: head is most recently used, tail is the next eviction.
+        lru_head: u32 = NONE,
+        lru_tail: u32 = NONE,
+        /// Most pages resident at once (see set_budget).
+        budget: u32 = capacity,
+        backing: ?Backing = null,
+        hits: u64 = 0,
+        misses: u64 = 0,
+        evictions: u64 = 0,
+
+        const Self = @This();
+
+        pub const CAPACITY: u32 = capacity;
+
+        const Slot = struct {
+            /// Owning inode (0: slot free).
+            inode: u32 = 0,
+            page: u32 = 0,
+            /// Newer than the backing store (always true without one).
+            dirty: bool = false,
+            prev: u32 = NONE,
+            next: u32 = NONE,
+        };
+
+        fn initial_free() [capacity]u32 {
+            @setEvalBranchQuota(capacity * 4 + 1000);
+            var free: [capacity]u32 = undefined;
+            for (&free, 0..) |*slot, i| {
+                slot.* = capacity - 1 - @as(u32, @intCast(i));
+            }
+            return free;
+        }
+
+        /// Pages currently resident.
+        pub fn resident(self: *const Self) u32 {
+            return capacity - self.free_count;
+        }
+
+        /// Resident page (inode, page), loading or zero-filling it on a miss.
+        /// Why: One call per page for read and write; for_write marks the page dirty.
+        /// Returns: null if the budget is full and no page can be evicted.
+        pub fn get(self: *Self, inode: u32, page: u32, for_write: bool) ?*[PAGE_SIZE]u8 {
+            std.debug.assert(inode != 0);
+            if (self.find(inode, page)) |slot| {
+                self.hits += 1;
+                self.touch(slot);
+                if (for_write) self.slots[slot].dirty = true;
+                return &self.pages[slot];
+            }
+
+            self.misses += 1;
+            const slot = self.take_slot() orelse return null;
+            self.slots[slot] = .{ .inode = inode, .page = page };
+            const loaded = if (self.backing) |backing| backing.load(backing.context, inode, page, &self.pages[slot]) else false;
+            if (!loaded) @memset(&self.pages[slot], 0);
+            // Without a backing store the cache holds the only copy.
+            self.slots[slot].dirty = for_write or self.backing == null;
+            self.insert(slot);
+            self.push_front(slot);
+
+            // Assert: the new page must be findable.
+            std.debug.assert(self.find(inode, page) == slot);
+            return &self.pages[slot];
+        }
+
+        /// Drop pages of inode at index >= from (written back nowhere) and tell the backing store.
+        /// Note: Scans every slot; truncate and unlink are rare next to reads and writes.
+        pub fn discard(self: *Self, inode: u32, from: u32) void {
+            std.debug.assert(inode != 0);
+            for (&self.slots, 0..) |*slot, i| {
+                if (slot.inode == inode and slot.page >= from) self.release(@intCast(i));
+            }
+            if (self.backing) |backing| backing.discard(backing.context, inode, from);
+        }
+
+        /// Make self equal to source, copying only the pages source has resident.
+        /// Why: The page array is almost all of the cache's size; snapshot restores would
+        /// otherwise copy the bytes of every free slot too.
+        pub fn copy_from(self: *Self, source: *const Self) void {
+            if (self == source) return;
+            var slot = source.lru_head;
+            while (slot != NONE) : (slot = source.slots[slot].next) {
+                self.pages[slot] = source.pages[slot];
+            }
+            inline for (std.meta.fields(Self)) |field| {
+                if (comptime !std.mem.eql(u8, field.name, "pages")) {
+                    @field(self, field.name) = @field(source, field.name);
+                }
+            }
+
+            // Assert: copies must agree on what is resident.
+            std.debug.assert(self.resident() == source.resident());
+        }
+
+        /// Set the resident page budget (clamped to 1..capacity), evicting down to it
+        /// as far as possible.
+        pub fn set_budget(self: *Self, pages: u32) void {
+            self.budget = std.math.clamp(pages, 1, capacity);
+            while (self.resident() > self.budget) {
+                if (!self.evict()) break;
+            }
+        }
+
+        /// A free slot within budget, evicting the least recently used page if needed.
+        fn take_slot(self: *Self) ?u32 {
+            if (self.resident() >= self.budget) {
+                if (!self.evict()) return null;
+            }
+            std.debug.assert(self.free_count > 0);
+            self.free_count -= 1;
+            return self.free[self.free_count];
+        }
+
+        /// Evict the LRU page (writing it back if dirty); false if it cannot be stored.
+        fn evict(self: *Self) bool {
+            const slot = self.lru_tail;
+            if (slot == NONE) return false;
+            const victim = &self.slots[slot];
+            if (victim.dirty) {
+                const backing = self.backing orelse return false;
+                backing.store(backing.context, victim.inode, victim.page, &self.pages[slot]);
+            }
+            self.release(slot);
+            self.evictions += 1;
+            return true;
+        }
+
+        /// Unindex a resident slot and return it to the free stack.
+        fn release(self: *Self, slot: u32) void {
+            std.debug.assert(self.slots[slot].inode != 0);
+            self.remove(slot);
+            self.unlink(slot);
+            self.slots[slot] = .{};
+            self.free[self.free_count] = slot;
+            self.free_count += 1;
+        }
+
+        fn home(inode: u32, page: u32) u32 {
+            const key = (@as(u64, inode) << 32) | page;
+            return @as(u32, @truncate((key *% 0x9E3779B97F4A7C15) >> 32)) & (buckets - 1);
+        }
+
+        fn find(self: *const Self, inode: u32, page: u32) ?u32 {
+            var bucket = home(inode, page);
+            while (self.index[bucket] != NONE) : (bucket = (bucket + 1) & (buckets - 1)) {
+                const slot = self.index[bucket];
+                if (self.slots[slot].inode == inode and self.slots[slot].page == page) return slot;
+            }
+            return null;
+        }
+
+        fn insert(self: *Self, slot: u32) void {
+            var bucket = home(self.slots[slot].inode, self.slots[slot].page);
+            while (self.index[bucket] != NONE) : (bucket = (bucket + 1) & (buckets - 1)) {}
+            self.index[bucket] = slot;
+        }
+
+        fn remove(self: *Self, slot: u32) void {
+            var hole = home(self.slots[slot].inode, self.slots[slot].page);
+            while (self.index[hole] != slot) : (hole = (hole + 1) & (buckets - 1)) {
+                std.debug.assert(self.index[hole] != NONE);
+            }
+            // Backward shift: pull later entries of the probe run into the hole.
+            var next = hole;
+            while (true) {
+                next = (next + 1) & (buckets - 1);
+                const moved = self.index[next];
+                if (moved == NONE) break;
+                const want = home(self.slots[moved].inode, self.slots[moved].page);
+                const stays = if (hole <= next) (hole < want and want <= next) else (hole < want or want <= next);
+                if (!stays) {
+                    self.index[hole] = moved;
+                    hole = next;
+                }
+            }
+            self.index[hole] = NONE;
+        }
+
+        fn touch(self: *Self, slot: u32) void {
+            if (self.lru_head == slot) return;
+            self.unlink(slot);
+            self.push_front(slot);
+        }
+
+        fn push_front(self: *Self, slot: u32) void {
+            self.slots[slot].prev = NONE;
+            self.slots[slot].next = self.lru_head;
+            if (self.lru_head != NONE) self.slots[self.lru_head].prev = slot;
+            self.lru_head = slot;
+            if (self.lru_tail == NONE) self.lru_tail = slot;
+        }
+
+        fn unlink(self: *Self, slot: u32) void {
+            const prev = self.slots[slot].prev;
+            const next = self.slots[slot].next;
+            if (prev != NONE) self.slots[prev].next = next else self.lru_head = next;
+            if (next != NONE) self.slots[next].prev = prev else self.lru_tail = prev;
+            self.slots[slot].prev = NONE;
+            self.slots[slot].next = NONE;
+        }
+    };
+}
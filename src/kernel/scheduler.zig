@@ -0,0 +1,81 @@
+//! Run queue and saved register contexts for the Basin kernel scheduler.
+//!
+//! Ready processes wait in one FIFO per priority level; a bitmap of non-empty levels
+//! makes picking the most urgent process a single count-trailing-zeros. Processes of
+//! equal priority share the CPU round-robin, one time slice each.
+
+const std = @import("std");
+
+/// Priority levels (0 is the most urgent).
+pub const PRIORITY_LEVELS: u32 = 8;
+
+/// Priority of the boot process (and of spawns from the host context).
+pub const DEFAULT_PRIORITY: u8 = 4;
+
+/// Saved guest register state of a process that is not on the CPU.
+/// Why: Same shape as the VM register file (x0-x31 plus pc), without depending on it.
+pub const Context = struct {
+    regs: [32]u64 = [_]u64{0} ** 32,
+    pc: u64 = 0,
+};
+
+const NIL: u32 = std.math.maxInt(u32);
+
+/// Ready queue of at most capacity processes, identified by index.
+/// Grain Style: Static allocation (capacity is comptime), intrusive index lists.
+pub fn RunQueue(comptime capacity: u32) type {
+    comptime {
+        std.debug.assert(capacity > 0 and capacity < NIL);
+        std.debug.assert(PRIORITY_LEVELS <= 8);
+    }
+
+    return struct {
+        heads: [PRIORITY_LEVELS]u32 = [_]u32{NIL} ** PRIORITY_LEVELS,
+        tails: [PRIORITY_LEVELS]u32 = [_]u32{NIL} ** PRIORITY_LEVELS,
+        next: [capacity]u32 = [_]u32{NIL} ** capacity,
+        /// Bit p is set when level p holds a process.
+        ready_levels: u8 = 0,
+        len: u32 = 0,
+
+        const Self = @This();
+
+        /// Queue id behind every process already at priority.
+        /// Contract: id is not queued.
+        pub fn push(self: *Self, id: u32, priority: u8) void {
+            std.debug.assert(id < capacity);
+            std.debug.assert(priority < PRIORITY_LEVELS);
+            std.debug.assert(self.len < capacity);
+            self.next[id] = NIL;
+            if (self.tails[priority] != NIL) self.next[self.tails[priority]] = id else self.heads[priority] = id;
+            self.tails[priority] = id;
+            self.ready_levels |= @as(u8, 1) << @intCast(priority);
+            self.len += 1;
+        }
+
+        /// Dequeue the oldest process of the most urgent non-empty level.
+        pub fn pop(self: *Self) ?u32 {
+            const priority = self.best_priority() orelse return null;
+            const id = self.heads[priority];
+            std.debug.assert(id != NIL);
+            self.heads[priority] = self.next[id];
+            if (self.heads[priority] == NIL) {
+                self.tails[priority] = NIL;
+                self.ready_levels &= ~(@as(u8, 1) << @intCast(priority));
+            }
+            self.next[id] = NIL;
+            self.len -= 1;
+            return id;
+        }
+
+        /// Most urgent priority with a ready process (null: queue empty).
+        pub fn best_priority(self: *const Self) ?u8 {
+            if (self.ready_levels == 0) return null;
+            return @ctz(self.ready_levels);
+        }
+
+        /// Processes queued.
+        pub fn count(self: *const Self) u32 {
+            return self.len;
+        }
+    };
+}
@@ -0,0 +1,102 @@
+//! Generation-indexed slot map for Basin kernel handle tables.
+//!
+//! Handle IDs carry their own slot: the low 32 bits hold slot index + 1 (so 0 stays
+//! invalid), the high 32 bits the slot's generation. Freeing a slot bumps its generation,
+//! so a stale ID no longer matches and is rejected without searching the table.
+
+const std = @import("std");
+
+/// Fixed-capacity table of T with O(1) alloc, lookup and free.
+/// Why: Handle, directory and process tables were scanned linearly on every syscall;
+/// a free list and per-slot generations make table size irrelevant to syscall cost.
+/// Grain Style: Static allocation, capacity is a comptime parameter.
+/// Contract: T has `id: u64` and `allocated: bool` fields and an `init()` constructor;
+/// the map owns both fields, callers own everything else in the entry.
+pub fn SlotMap(comptime T: type, comptime capacity: u32) type {
+    comptime {
+        std.debug.assert(capacity > 0);
+        std.debug.assert(capacity < 0xFFFFFFFF);
+    }
+
+    return struct {
+        /// Entries (allocated == true: live).
+        entries: [capacity]T = [_]T{T.init()} ** capacity,
+        /// Generation of each slot, encoded in the high half of its IDs.
+        generations: [capacity]u32 = [_]u32{0} ** capacity,
+        /// Stack of free slot indices (top at free_count - 1, lowest index on top).
+        free: [capacity]u32 = initial_free(),
+        free_count: u32 = capacity,
+
+        const Self = @This();
+
+        pub const CAPACITY: u32 = capacity;
+
+        fn initial_free() [capacity]u32 {
+            @setEvalBranchQuota(capacity * 4 + 1000);
+            var free: [capacity]u32 = undefined;
+            for (&free, 0..) |*slot, i| {
+                slot.* = capacity - 1 - @as(u32, @intCast(i));
+            }
+            return free;
+        }
+
+        /// ID for slot index at its current generation.
+        fn encode(self: *const Self, index: u32) u64 {
+            std.debug.assert(index < capacity);
+            return (@as(u64, self.generations[index]) << 32) | (@as(u64, index) + 1);
+        }
+
+        /// Allocate a slot: sets its id and allocated flag.
+        /// Returns: Slot index, or null if the table is full.
+        /// Note: Other fields keep the values the previous owner left; callers reset them.
+        pub fn alloc(self: *Self) ?u32 {
+            if (self.free_count == 0) return null;
+            self.free_count -= 1;
+            const index = self.free[self.free_count];
+            const entry = &self.entries[index];
+
+            // Assert: free list must only hold unallocated slots.
+            std.debug.assert(!entry.allocated);
+
+            entry.id = self.encode(index);
+            entry.allocated = true;
+
+            // Assert: IDs must be non-zero (0 is the invalid handle).
+            std.debug.assert(entry.id != 0);
+            return index;
+        }
+
+        /// Slot index of a live ID.
+        /// Returns: null for 0, out-of-range, freed or stale (older generation) IDs.
+        pub fn find(self: *const Self, id: u64) ?u32 {
+            const slot = id & 0xFFFFFFFF;
+            if (slot == 0 or slot > capacity) return null;
+            const index: u32 = @intCast(slot - 1);
+            const entry = &self.entries[index];
+            if (!entry.allocated or entry.id != id) return null;
+
+            // Assert: a live ID must carry its slot's current generation.
+            std.debug.assert(id >> 32 == self.generations[index]);
+            return index;
+        }
+
+        /// Free a live slot: bumps its generation so outstanding IDs go stale.
+        pub fn free_slot(self: *Self, index: u32) void {
+            std.debug.assert(index < capacity);
+            const entry = &self.entries[index];
+            std.debug.assert(entry.allocated);
+            std.debug.assert(self.free_count < capacity);
+
+            entry.allocated = false;
+            entry.id = 0;
+            self.generations[index] +%= 1;
+            self.free[self.free_count] = index;
+            self.free_count += 1;
+        }
+
+        /// Number of live slots.
+        pub fn count(self: *const Self) u32 {
+            return capacity - self.free_count;
+        }
+    };
+}
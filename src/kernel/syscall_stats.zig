@@ -0,0 +1,203 @@
+//! Per-syscall counters and latency histograms for the Basin kernel.
+//!
+//! For every syscall number: calls, errors by error code, and two log2 histograms. The
+//! guest histogram measures guest time (retired instructions) from the syscall until the
+//! calling process next runs, so blocking (wait, sleep_until) and preemption show up; a
+//! call that returns straight to its caller costs 0. The host histogram measures the
+//! kernel's own nanoseconds, sampled on every HOST_SAMPLE_INTERVAL-th call because a host
+//! clock read costs more than the rest of the bookkeeping together.
+//! Note: Compiled in only with `-Dkernel-stats=true`. Otherwise Stats is zero-sized and
+//! the kernel skips every call at comptime, so normal builds pay nothing.
+
+const std = @import("std");
+const kernel_options = @import("kernel_options");
+
+/// Whether statistics are compiled in (`-Dkernel-stats=true`).
+pub const enabled: bool = kernel_options.syscall_stats_enabled;
+
+/// Histogram buckets: 0 holds zero, b holds [2^(b-1), 2^b), the last bucket everything above.
+pub const BUCKETS: u32 = 32;
+
+/// Error counters per syscall (error code -1 is slot 0; room for errors not yet defined).
+pub const ERROR_SLOTS: u32 = 16;
+
+/// Host nanoseconds are measured on one call in this many (power of two).
+pub const HOST_SAMPLE_INTERVAL: u64 = 16;
+
+/// No syscall in flight for a process.
+const NONE: u32 = std.math.maxInt(u32);
+
+comptime {
+    std.debug.assert(std.math.isPowerOfTwo(HOST_SAMPLE_INTERVAL));
+    std.debug.assert(BUCKETS <= 65);
+}
+
+/// Bucket holding value.
+pub fn bucket(value: u64) u32 {
+    if (value == 0) return 0;
+    return @min(64 - @as(u32, @clz(value)), BUCKETS - 1);
+}
+
+/// Largest value bucket b holds (the last bucket is unbounded).
+pub fn bucket_limit(b: u32) u64 {
+    std.debug.assert(b < BUCKETS);
+    if (b == BUCKETS - 1) return std.math.maxInt(u64);
+    return (@as(u64, 1) << @intCast(b)) - 1;
+}
+
+/// One syscall's counters (guest ABI layout: sysinfo copies it out as is).
+/// Note: userspace/stdlib.zig mirrors this layout; change both together.
+pub const Record = extern struct {
+    calls: u64,
+    /// errors[i] counts error code -(i + 1).
+    errors: [ERROR_SLOTS]u64,
+    /// Guest instructions until the caller ran again.
+    guest_instructions: [BUCKETS]u64,
+    /// Host nanoseconds in the kernel (sampled calls only).
+    host_ns: [BUCKETS]u64,
+
+    /// Total errors.
+    pub fn error_count(self: *const Record) u64 {
+        var total: u64 = 0;
+        for (self.errors) |count| total += count;
+        return total;
+    }
+
+    /// Upper bound of the q-th permille of a histogram (0 for an empty one).
+    pub fn percentile(histogram: *const [BUCKETS]u64, permille: u32) u64 {
+        std.debug.assert(permille <= 1000);
+        var total: u64 = 0;
+        for (histogram) |count| total += count;
+        if (total == 0) return 0;
+        const rank = (total * permille + 999) / 1000;
+        var seen: u64 = 0;
+        for (histogram, 0..) |count, b| {
+            seen += count;
+            if (seen >= @max(rank, 1)) return bucket_limit(@intCast(b));
+        }
+        unreachable;
+    }
+};
+
+/// Statistics for syscall numbers below syscall_slots issued by up to process_slots processes.
+/// Note: Numbers from syscall_slots up share one out-of-range record.
+pub fn Stats(comptime syscall_slots: u32, comptime process_slots: u32) type {
+    return if (enabled) Collector(syscall_slots, process_slots) else Disabled;
+}
+
+/// Statistics compiled out: zero-sized (callers check `enabled` before using it).
+pub const Disabled = struct {};
+
+/// A syscall between begin and end.
+pub const Call = struct {
+    guest_start: u64,
+    host_start: ?std.time.Instant,
+};
+
+/// Grain Style: Static allocation (slot counts are comptime), no formatting on the hot path.
+pub fn Collector(comptime syscall_slots: u32, comptime process_slots: u32) type {
+    comptime {
+        std.debug.assert(syscall_slots > 0);
+        std.debug.assert(process_slots > 0);
+    }
+
+    return struct {
+        records: [syscall_slots]Record = std.mem.zeroes([syscall_slots]Record),
+        /// Calls with numbers past the table (guest a7 is arbitrary; never pending).
+        out_of_range: Record = std.mem.zeroes(Record),
+        /// Calls begun (drives host sampling).
+        calls: u64 = 0,
+        /// Syscalls in flight (io_ring_enter runs others inside itself).
+        depth: u32 = 0,
+        /// Syscall each process issued last and has not yet resumed from (NONE: none).
+        pending: [process_slots]u32 = [_]u32{NONE} ** process_slots,
+        /// Guest time of that syscall.
+        pending_since: [process_slots]u64 = [_]u64{0} ** process_slots,
+
+        const Self = @This();
+
+        /// Start timing a syscall at guest time now.
+        pub fn begin(self: *Self, now: u64) Call {
+            self.calls += 1;
+            self.depth += 1;
+            const sampled = self.calls & (HOST_SAMPLE_INTERVAL - 1) == 0;
+            return .{
+                .guest_start = now,
+                .host_start = if (sampled) std.time.Instant.now() catch null else null,
+            };
+        }
+
+        /// Account a finished syscall. error_slot is null on success; process is the
+        /// caller's slot (null: the host), whose guest latency is recorded when it resumes.
+        pub fn end(self: *Self, call: Call, syscall_num: u32, error_slot: ?u32, process: ?u32, now: u64) void {
+            std.debug.assert(self.depth > 0);
+            self.depth -= 1;
+            const in_range = syscall_num < syscall_slots;
+            const counters = if (in_range) &self.records[syscall_num] else &self.out_of_range;
+            counters.calls += 1;
+            if (error_slot) |slot| counters.errors[@min(slot, ERROR_SLOTS - 1)] += 1;
+            if (call.host_start) |start| {
+                if (std.time.Instant.now()) |finish| {
+                    counters.host_ns[bucket(finish.since(start))] += 1;
+                } else |_| {}
+            }
+
+            // Nested, polled, host and out-of-range calls return to their caller at once.
+            const idx = process orelse {
+                counters.guest_instructions[bucket(now - call.guest_start)] += 1;
+                return;
+            };
+            std.debug.assert(idx < process_slots);
+            if (self.depth > 0 or !in_range) {
+                counters.guest_instructions[bucket(now - call.guest_start)] += 1;
+                return;
+            }
+            self.pending[idx] = syscall_num;
+            self.pending_since[idx] = call.guest_start;
+        }
+
+        /// Syscalls until unnest run for the kernel (polled io_rings), not for a caller
+        /// waiting on them: their guest latency is recorded at once.
+        pub fn nest(self: *Self) void {
+            self.depth += 1;
+        }
+
+        pub fn unnest(self: *Self) void {
+            std.debug.assert(self.depth > 0);
+            self.depth -= 1;
+        }
+
+        /// Process idx is back on the CPU at guest time now: close its pending syscall.
+        pub fn resumed(self: *Self, idx: u32, now: u64) void {
+            std.debug.assert(idx < process_slots);
+            const syscall_num = self.pending[idx];
+            if (syscall_num == NONE) return;
+            self.pending[idx] = NONE;
+            self.records[syscall_num].guest_instructions[bucket(now -| self.pending_since[idx])] += 1;
+        }
+
+        /// Drop what process slot idx had in flight (slot reused or process gone).
+        pub fn forget(self: *Self, idx: u32) void {
+            std.debug.assert(idx < process_slots);
+            self.pending[idx] = NONE;
+        }
+
+        /// Counters for syscall_num.
+        pub fn record(self: *const Self, syscall_num: u32) *const Record {
+            std.debug.assert(syscall_num < syscall_slots);
+            return &self.records[syscall_num];
+        }
+
+        /// Counters for every number from syscall_slots up.
+        pub fn out_of_range_record(self: *const Self) *const Record {
+            return &self.out_of_range;
+        }
+
+        /// Zero every counter (syscalls in flight are forgotten).
+        pub fn clear(self: *Self) void {
+            const depth = self.depth;
+            self.* = .{};
+            self.depth = depth;
+        }
+    };
+}
@@ -0,0 +1,55 @@
+//! Shared time page layout for the Basin kernel (vDSO-style clock and system info).
+//!
+//! One read-only page at a fixed guest address (ADDRESS, top of the kernel's first
+//! megabyte, which map never hands out) that every process can read. Time itself is
+//! not stored: monotonic time is the guest timebase (rdtime) scaled by ticks_per_second,
+//! and realtime adds realtime_base_ns. The kernel only rewrites the page when a field
+//! changes (realtime set, memory mapped or unmapped, load average sampled), under a
+//! seqlock: sequence is odd while a rewrite is in progress, and a reader retries if it
+//! saw an odd sequence or the sequence changed while it copied the fields.
+//! Note: Fields are little-endian (guest byte order). userspace/stdlib.zig mirrors this
+//! layout; change both together.
+
+const std = @import("std");
+
+/// Guest address of the page (the last page below the first mapping address).
+pub const ADDRESS: u64 = 0x100000 - PAGE_BYTES;
+
+pub const PAGE_BYTES: u64 = 4096;
+
+/// Page magic ("TIME").
+pub const MAGIC: u32 = 0x454D_4954;
+
+/// Page contents.
+pub const Page = extern struct {
+    magic: u32,
+    /// Seqlock sequence (odd: the kernel is rewriting the page).
+    sequence: u32,
+    /// Guest timebase frequency (rdtime ticks per second).
+    ticks_per_second: u64,
+    /// Realtime at guest tick 0 (nanoseconds since the Unix epoch).
+    realtime_base_ns: u64,
+    /// Guest RAM (bytes).
+    total_memory: u64,
+    /// Guest RAM above the kernel's first megabyte not yet mapped (bytes).
+    available_memory: u64,
+    cpu_cores: u32,
+    /// Runnable processes, exponentially averaged over a minute (scaled by 1000).
+    load_avg_1min: u32,
+};
+
+pub const SEQUENCE_OFFSET: u64 = @offsetOf(Page, "sequence");
+
+/// Nanoseconds in ticks of a ticks_per_second timebase (no overflow below 2^64 ns).
+pub fn ticks_to_ns(ticks: u64, ticks_per_second: u64) u64 {
+    std.debug.assert(ticks_per_second > 0 and ticks_per_second <= std.time.ns_per_s);
+    const seconds = ticks / ticks_per_second;
+    const remainder = ticks % ticks_per_second;
+    return seconds * std.time.ns_per_s + remainder * std.time.ns_per_s / ticks_per_second;
+}
+
+comptime {
+    std.debug.assert(@sizeOf(Page) == 48);
+    std.debug.assert(@sizeOf(Page) <= PAGE_BYTES);
+    std.debug.assert(ADDRESS % PAGE_BYTES == 0);
+}
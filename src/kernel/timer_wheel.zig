@@ -0,0 +1,289 @@
+//! Hierarchical timer wheel for Basin kernel sleepers.
+//!
+//! LEVELS wheels of SLOTS slots; ticks are read as base-SLOTS digits. A timer sits at the
+//! level of the highest digit where its deadline differs from now, in the slot named by
+//! that digit of the deadline. Arming and cancelling are O(1) list operations. When now
+//! reaches a slot above level 0 its timers cascade down a level; when it reaches a level-0
+//! slot they expire. Advancing jumps straight to the next such event (per-level occupancy
+//! bitmaps), so its cost is O(LEVELS) per event plus O(1) per timer moved or expired,
+//! whether 10 or 10,000 timers are armed and however far time jumps. Deadlines beyond the
+//! top level's reach wait on an overflow list, re-filed each time the top level wraps.
+
+const std = @import("std");
+
+pub const SLOT_BITS: u6 = 6;
+pub const SLOTS: u32 = 1 << SLOT_BITS;
+pub const LEVELS: u32 = 4;
+
+/// Ticks the wheels cover from now (deadlines further out overflow).
+pub const SPAN_BITS: u6 = SLOT_BITS * LEVELS;
+
+const NIL: u32 = std.math.maxInt(u32);
+
+/// List ids: level * SLOTS + slot for wheel slots, then overflow and expired.
+const LIST_OVERFLOW: u16 = LEVELS * SLOTS;
+const LIST_EXPIRED: u16 = LIST_OVERFLOW + 1;
+const LIST_NONE: u16 = std.math.maxInt(u16);
+
+/// Wheel of at most capacity timers, identified by index (0 <= id < capacity).
+/// Grain Style: Static allocation (capacity is comptime), intrusive index lists.
+/// Contract: Deadlines and now are in wheel ticks; callers choose the tick length.
+pub fn TimerWheel(comptime capacity: u32) type {
+    comptime {
+        std.debug.assert(capacity > 0 and capacity < NIL);
+    }
+
+    return struct {
+        /// Current tick: every timer with deadline <= now has expired.
+        now: u64 = 0,
+        /// First timer of each list (wheel slots, overflow, expired).
+        heads: [LIST_EXPIRED + 1]u32 = [_]u32{NIL} ** (LIST_EXPIRED + 1),
+        /// Last expired timer (expired timers are taken in FIFO order).
+        expired_tail: u32 = NIL,
+        /// Bit s of occupied[level] is set when that slot holds a timer.
+        occupied: [LEVELS]u64 = [_]u64{0} ** LEVELS,
+        /// Timers in wheels or overflow (armed, not yet expired).
+        pending_count: u32 = 0,
+        next: [capacity]u32 = [_]u32{NIL} ** capacity,
+        prev: [capacity]u32 = [_]u32{NIL} ** capacity,
+        deadlines: [capacity]u64 = [_]u64{0} ** capacity,
+        lists: [capacity]u16 = [_]u16{LIST_NONE} ** capacity,
+
+        const Self = @This();
+
+        /// Arm timer id to expire at tick deadline (already due: expires now).
+        /// Contract: id is not armed.
+        pub fn arm(self: *Self, id: u32, deadline: u64) void {
+            std.debug.assert(id < capacity);
+            std.debug.assert(self.lists[id] == LIST_NONE);
+            self.deadlines[id] = deadline;
+            self.file(id);
+
+            // Assert: the timer must be armed.
+            std.debug.assert(self.lists[id] != LIST_NONE);
+        }
+
+        /// Disarm timer id (pending or expired but not taken); no-op if not armed.
+        pub fn cancel(self: *Self, id: u32) void {
+            std.debug.assert(id < capacity);
+            if (self.lists[id] == LIST_NONE) return;
+            if (self.lists[id] != LIST_EXPIRED) self.pending_count -= 1;
+            self.unlink(id);
+        }
+
+        /// Whether timer id is armed (pending or expired but not taken).
+        pub fn armed(self: *const Self, id: u32) bool {
+            std.debug.assert(id < capacity);
+            return self.lists[id] != LIST_NONE;
+        }
+
+        /// Timers not yet expired.
+        pub fn pending(self: *const Self) u32 {
+            return self.pending_count;
+        }
+
+        /// Take the next expired timer (expiry order).
+        pub fn pop_expired(self: *Self) ?u32 {
+            const id = self.heads[LIST_EXPIRED];
+            if (id == NIL) return null;
+            self.unlink(id);
+            return id;
+        }
+
+        /// Advance now to target, expiring every timer with deadline <= target.
+        /// Why: Empty stretches are skipped, so an idle jump costs no more than one tick.
+        pub fn advance(self: *Self, target: u64) void {
+            while (self.next_event()) |event| {
+                if (event > target) break;
+                self.now = event;
+                self.fire();
+            }
+            if (self.now < target) self.now = target;
+
+            // Assert: time must have reached target.
+            std.debug.assert(self.now >= target);
+        }
+
+        /// Next tick at which a timer expires or cascades (null: nothing pending).
+        /// Note: A cascade is not an expiry; advancing to it may expire nothing.
+        pub fn next_event(self: *const Self) ?u64 {
+            var earliest: ?u64 = null;
+            var level: u32 = 0;
+            while (level < LEVELS) : (level += 1) {
+                const shift: u6 = @intCast(level * SLOT_BITS);
+                const digit: u6 = @intCast((self.now >> shift) & (SLOTS - 1));
+                // Slots at or below now's digit are empty (they cascaded or expired).
+                const later = (self.occupied[level] >> digit) >> 1;
+                if (later == 0) continue;
+                const slot: u64 = @as(u64, digit) + 1 + @ctz(later);
+                const block_shift: u6 = shift + SLOT_BITS;
+                const block = (self.now >> block_shift) << block_shift;
+                const tick = block + (slot << shift);
+                earliest = if (earliest) |e| @min(e, tick) else tick;
+            }
+            if (self.heads[LIST_OVERFLOW] != NIL) {
+                const wrap = (self.now | ((@as(u64, 1) << SPAN_BITS) - 1)) + 1;
+                earliest = if (earliest) |e| @min(e, wrap) else wrap;
+            }
+            return earliest;
+        }
+
+        /// Handle tick now: re-file overflow on a wrap, cascade top-down, expire level 0.
+        fn fire(self: *Self) void {
+            if (self.now & ((@as(u64, 1) << SPAN_BITS) - 1) == 0) {
+                self.refile(LIST_OVERFLOW);
+            }
+            var level: u32 = LEVELS - 1;
+            while (level > 0) : (level -= 1) {
+                const shift: u6 = @intCast(level * SLOT_BITS);
+                if (self.now & ((@as(u64, 1) << shift) - 1) != 0) continue;
+                const slot: u32 = @intCast((self.now >> shift) & (SLOTS - 1));
+                self.refile(@intCast(level * SLOTS + slot));
+            }
+            self.refile(@intCast(self.now & (SLOTS - 1)));
+        }
+
+        /// Move every timer on list to where its deadline now belongs.
+        /// Note: The list is detached first: overflow timers may file straight back.
+        fn refile(self: *Self, list: u16) void {
+            std.debug.assert(list <= LIST_OVERFLOW);
+            var id = self.heads[list];
+            self.heads[list] = NIL;
+            if (list < LIST_OVERFLOW) {
+                self.occupied[list / SLOTS] &= ~(@as(u64, 1) << @intCast(list % SLOTS));
+            }
+            while (id != NIL) {
+                const following = self.next[id];
+                self.lists[id] = LIST_NONE;
+                self.pending_count -= 1;
+                self.file(id);
+                id = following;
+            }
+        }
+
+        /// Put id on the list for its deadline relative to now.
+        fn file(self: *Self, id: u32) void {
+            const deadline = self.deadlines[id];
+            if (deadline <= self.now) {
+                self.append_expired(id);
+                return;
+            }
+            self.pending_count += 1;
+            const diff = deadline ^ self.now;
+            if (diff >> SPAN_BITS != 0) {
+                self.link(LIST_OVERFLOW, id);
+                return;
+            }
+            const level: u32 = (63 - @as(u32, @clz(diff))) / SLOT_BITS;
+            const shift: u6 = @intCast(level * SLOT_BITS);
+            const slot: u32 = @intCast((deadline >> shift) & (SLOTS - 1));
+            self.link(@intCast(level * SLOTS + slot), id);
+            self.occupied[level] |= @as(u64, 1) << @intCast(slot);
+        }
+
+        fn link(self: *Self, list: u16, id: u32) void {
+            const head = self.heads[list];
+            self.next[id] = head;
+            self.prev[id] = NIL;
+            if (head != NIL) self.prev[head] = id;
+            self.heads[list] = id;
+            self.lists[id] = list;
+        }
+
+        fn append_expired(self: *Self, id: u32) void {
+            self.next[id] = NIL;
+            self.prev[id] = self.expired_tail;
+            if (self.expired_tail != NIL) self.next[self.expired_tail] = id else self.heads[LIST_EXPIRED] = id;
+            self.expired_tail = id;
+            self.lists[id] = LIST_EXPIRED;
+        }
+
+        fn unlink(self: *Self, id: u32) void {
+            const list = self.lists[id];
+            std.debug.assert(list != LIST_NONE);
+            if (self.prev[id] != NIL) self.next[self.prev[id]] = self.next[id] else self.heads[list] = self.next[id];
+            if (self.next[id] != NIL) {
+                self.prev[self.next[id]] = self.prev[id];
+            } else if (list == LIST_EXPIRED) {
+                self.expired_tail = self.prev[id];
+            }
+            if (list < LIST_OVERFLOW and self.heads[list] == NIL) {
+                self.occupied[list / SLOTS] &= ~(@as(u64, 1) << @intCast(list % SLOTS));
+            }
+            self.lists[id] = LIST_NONE;
+            self.next[id] = NIL;
+            self.prev[id] = NIL;
+        }
+    };
+}
+
+test "TimerWheel expires due, near and overflowed timers" {
+    var wheel: TimerWheel(4) = .{};
+
+    // Already due: expires at once and is not pending.
+    wheel.arm(0, 0);
+    try std.testing.expectEqual(@as(u32, 0), wheel.pending());
+    wheel.arm(1, 100);
+    wheel.arm(2, @as(u64, 1) << (SPAN_BITS + 2)); // past the top level: overflow
+    try std.testing.expectEqual(@as(u32, 2), wheel.pending());
+    try std.testing.expectEqual(@as(?u32, 0), wheel.pop_expired());
+    try std.testing.expect(!wheel.armed(0));
+
+    wheel.advance(99);
+    try std.testing.expectEqual(@as(?u32, null), wheel.pop_expired());
+    wheel.advance(100);
+    try std.testing.expectEqual(@as(?u32, 1), wheel.pop_expired());
+
+    // Cancelled timers never expire.
+    wheel.arm(3, 200);
+    wheel.cancel(3);
+    wheel.advance(@as(u64, 1) << (SPAN_BITS + 2));
+    try std.testing.expectEqual(@as(?u32, 2), wheel.pop_expired());
+    try std.testing.expectEqual(@as(?u32, null), wheel.pop_expired());
+    try std.testing.expectEqual(@as(u32, 0), wheel.pending());
+    try std.testing.expectEqual(@as(?u64, null), wheel.next_event());
+}
+
+test "TimerWheel expires random timers in deadline order" {
+    // Random arm/cancel/advance against a brute-force model, across every wheel level
+    // and the overflow list (deadlines up to 2^28 ticks out, jumps up to 2^26).
+    const CAPACITY: u32 = 64;
+    const Wheel = TimerWheel(CAPACITY);
+    const wheel = try std.testing.allocator.create(Wheel);
+    defer std.testing.allocator.destroy(wheel);
+    wheel.* = .{};
+    var model = [_]?u64{null} ** CAPACITY;
+
+    var prng = std.Random.DefaultPrng.init(0x022);
+    const random = prng.random();
+    var round: u32 = 0;
+    while (round < 20_000) : (round += 1) {
+        const id = random.uintLessThan(u32, CAPACITY);
+        switch (random.uintLessThan(u32, 4)) {
+            0, 1 => if (model[id] == null) {
+                const shift = random.uintLessThan(u6, 29);
+                const deadline = wheel.now + random.uintLessThan(u64, (@as(u64, 1) << shift) + 1);
+                wheel.arm(id, deadline);
+                model[id] = deadline;
+            },
+            2 => {
+                wheel.cancel(id);
+                model[id] = null;
+            },
+            else => {
+                const target = wheel.now + random.uintLessThan(u64, @as(u64, 1) << random.uintLessThan(u6, 27));
+                wheel.advance(target);
+                var last: u64 = 0;
+                while (wheel.pop_expired()) |expired| {
+                    const deadline = model[expired].?;
+                    try std.testing.expect(deadline <= target and deadline >= last);
+                    last = deadline;
+                    model[expired] = null;
+                }
+                for (model) |deadline| {
+                    if (deadline) |d| try std.testing.expect(d > target);
+                }
+            },
+        }
+    }
+}
@@ -0,0 +1,141 @@
+const std = @import("std");
+
+/// Supervisor trap CSRs and the CLINT-style virtual timer of one hart.
+/// Grain Style: Plain state, WARL masks in one place, no host clock anywhere.
+/// ~<~ Glow Airbend: time only moves when the hart does, or when nothing is left to wait for.
+///
+/// Why: Guests had no timer and no interrupt delivery, so idle loops spun and host code
+/// faked time. mtime/mtimecmp give SBI SET_TIMER and `rdtime` real semantics, and
+/// a supervisor timer interrupt traps through stvec like on hardware.
+/// Note: Virtual time is deterministic: mtime advances one tick per retired instruction
+/// (TIMEBASE_HZ) and jumps straight to mtimecmp when the hart waits in WFI, so record
+/// and replay see identical interrupts without logging the clock.
+/// Note: Only the supervisor timer interrupt exists; software and external interrupts
+/// (IPIs, devices) are still polled through SBI and virtio registers.
+
+/// Virtual timebase frequency (mtime ticks per second; one tick per retired instruction).
+pub const TIMEBASE_HZ: u64 = 10_000_000;
+/// mtimecmp value meaning "no timer armed" (also the reset value).
+pub const NO_DEADLINE: u64 = std.math.maxInt(u64);
+
+/// CSR numbers.
+pub const SSTATUS: u12 = 0x100;
+pub const SIE: u12 = 0x104;
+pub const STVEC: u12 = 0x105;
+pub const SSCRATCH: u12 = 0x140;
+pub const SEPC: u12 = 0x141;
+pub const SCAUSE: u12 = 0x142;
+pub const STVAL: u12 = 0x143;
+pub const SIP: u12 = 0x144;
+pub const TIME: u12 = 0xC01;
+
+/// sstatus bits kept (SIE, SPIE, SPP); the rest read as zero (WARL).
+pub const SSTATUS_SIE: u64 = 1 << 1;
+pub const SSTATUS_SPIE: u64 = 1 << 5;
+pub const SSTATUS_SPP: u64 = 1 << 8;
+const SSTATUS_MASK: u64 = SSTATUS_SIE | SSTATUS_SPIE | SSTATUS_SPP;
+/// Supervisor timer interrupt bit in sie / sip (the only interrupt source).
+pub const STI: u64 = 1 << 5;
+/// scause of a supervisor timer interrupt.
+pub const CAUSE_SUPERVISOR_TIMER: u64 = (1 << 63) | 5;
+/// stvec MODE field (direct or vectored; reserved modes read as direct).
+const STVEC_MODE_MASK: u64 = 0b11;
+const STVEC_MODE_VECTORED: u64 = 1;
+
+/// One hart's trap CSRs and timer.
+pub const State = struct {
+    sstatus: u64 = 0,
+    sie: u64 = 0,
+    stvec: u64 = 0,
+    sscratch: u64 = 0,
+    sepc: u64 = 0,
+    scause: u64 = 0,
+    stval: u64 = 0,
+    /// Virtual time in ticks (CLINT mtime; read by the guest as the time CSR).
+    mtime: u64 = 0,
+    /// Timer deadline (CLINT mtimecmp; set through SBI SET_TIMER).
+    mtimecmp: u64 = NO_DEADLINE,
+
+    const Self = @This();
+
+    /// Whether the timer has fired (sip.STIP; cleared by moving mtimecmp past mtime).
+    pub fn timer_pending(self: *const Self) bool {
+        return self.mtime >= self.mtimecmp;
+    }
+
+    /// mtime at which a timer interrupt is taken (NO_DEADLINE while masked).
+    pub fn interrupt_deadline(self: *const Self) u64 {
+        if (self.sstatus & SSTATUS_SIE == 0 or self.sie & STI == 0) return NO_DEADLINE;
+        return self.mtimecmp;
+    }
+
+    /// mtime at which WFI completes (NO_DEADLINE if no enabled timer).
+    /// Note: WFI wakes on an interrupt enabled in sie even while sstatus.SIE is clear.
+    pub fn wake_deadline(self: *const Self) u64 {
+        if (self.sie & STI == 0) return NO_DEADLINE;
+        return self.mtimecmp;
+    }
+
+    /// Value of csr, or null if it is not one of these CSRs.
+    pub fn read(self: *const Self, csr: u12) ?u64 {
+        return switch (csr) {
+            SSTATUS => self.sstatus,
+            SIE => self.sie,
+            STVEC => self.stvec,
+            SSCRATCH => self.sscratch,
+            SEPC => self.sepc,
+            SCAUSE => self.scause,
+            STVAL => self.stval,
+            SIP => if (self.timer_pending()) STI else 0,
+            TIME => self.mtime,
+            else => null,
+        };
+    }
+
+    /// Write csr (WARL fields masked); false if it is not a writable CSR of this set.
+    /// Note: sip.STIP is read-only here (SBI SET_TIMER clears it), so sip writes are ignored.
+    pub fn write(self: *Self, csr: u12, value: u64) bool {
+        switch (csr) {
+            SSTATUS => self.sstatus = value & SSTATUS_MASK,
+            SIE => self.sie = value & STI,
+            STVEC => self.stvec = if (value & STVEC_MODE_MASK > STVEC_MODE_VECTORED) value & ~STVEC_MODE_MASK else value,
+            SSCRATCH => self.sscratch = value,
+            SEPC => self.sepc = value & ~@as(u64, 3),
+            SCAUSE => self.scause = value,
+            STVAL => self.stval = value,
+            SIP => {},
+            else => return false,
+        }
+        return true;
+    }
+
+    /// Take interrupt cause at pc: save state, mask interrupts; returns the handler PC.
+    /// Note: The guest always runs in S-mode here, so SPP is always set.
+    pub fn enter_trap(self: *Self, pc: u64, cause: u64) u64 {
+        std.debug.assert(cause >> 63 == 1);
+        std.debug.assert(pc % 4 == 0);
+
+        self.sepc = pc;
+        self.scause = cause;
+        self.stval = 0;
+        const spie = if (self.sstatus & SSTATUS_SIE != 0) SSTATUS_SPIE else 0;
+        self.sstatus = (self.sstatus & ~(SSTATUS_SIE | SSTATUS_SPIE)) | spie | SSTATUS_SPP;
+
+        const base = self.stvec & ~STVEC_MODE_MASK;
+        const handler = if (self.stvec & STVEC_MODE_MASK == STVEC_MODE_VECTORED)
+            base +% 4 * (cause & ~(@as(u64, 1) << 63))
+        else
+            base;
+
+        // Assert: interrupts must be masked inside the handler.
+        std.debug.assert(self.interrupt_deadline() == NO_DEADLINE);
+        return handler;
+    }
+
+    /// SRET: restore SIE from SPIE; returns the PC to resume at (sepc).
+    pub fn sret(self: *Self) u64 {
+        const sie = if (self.sstatus & SSTATUS_SPIE != 0) SSTATUS_SIE else 0;
+        self.sstatus = (self.sstatus & ~(SSTATUS_SIE | SSTATUS_SPP)) | sie | SSTATUS_SPIE;
+        return self.sepc;
+    }
+};
@@ -0,0 +1,169 @@
+const kernel_vm = @import("kernel_vm");
+const Op = kernel_vm.VM.Op;
+
+/// Reference RISC-V decoder: the original nested opcode switch, kept outside the VM.
+/// Why: The specification VM.decode's comptime table is checked against (exhaustive
+/// equivalence in kernel-vm-test) and the baseline for bench-dispatch; the VM itself
+/// only carries the table.
+/// Grain Style: Written independently of vm.zig (own immediate extraction), so a table
+/// or extractor bug cannot hide behind shared code.
+
+/// Decoded instruction in public terms (operation instead of handler pointer).
+pub const Decoded = struct {
+    op: Op,
+    rd: u5,
+    rs1: u5,
+    rs2: u5,
+    imm: i64,
+};
+
+/// Decode instruction word (same result as VM.decode, compared through VM.op_of).
+pub fn decode(inst: u32) Decoded {
+    // Decode instruction opcode (bits [6:0]).
+    const opcode = @as(u7, @truncate(inst));
+    const funct3 = @as(u3, @truncate(inst >> 12));
+    const funct7 = @as(u7, @truncate(inst >> 25));
+
+    return switch (opcode) {
+        // LUI (Load Upper Immediate) / AUIPC (Add Upper Immediate to PC): U-type.
+        0b0110111 => decoded(inst, .lui, imm_u(inst)),
+        0b0010111 => decoded(inst, .auipc, imm_u(inst)),
+        // OP-IMM: only ADDI is supported.
+        0b0010011 => if (funct3 == 0b000) decoded(inst, .addi, imm_i(inst)) else decoded(inst, .invalid, 0),
+        // Opcode 0x14/0x24/0x34: Zig compiler compatibility - ORI variants, otherwise NOP.
+        0b0010100, 0b0100100, 0b0110100 => if (funct3 == 0b110) decoded(inst, .ori, imm_i(inst)) else decoded(inst, .nop, 0),
+        // Opcode 0x01/0x05/0x06/0x20/0x25/0x3D/0x45/0x60: Zig compiler compatibility - I-type ALU variants.
+        0b0000001, 0b0000101, 0b0000110, 0b0100000, 0b0100101, 0b0111101, 0b1000101, 0b1100000 => switch (funct3) {
+            0b000 => decoded(inst, .addi, imm_i(inst)),
+            0b100 => decoded(inst, .xori, imm_i(inst)),
+            0b110 => decoded(inst, .ori, imm_i(inst)),
+            0b111 => decoded(inst, .andi, imm_i(inst)),
+            else => decoded(inst, .nop, 0),
+        },
+        // R-type (OP): funct7 selects ADD/SUB and SRL/SRA; SLL ignores funct7 (Zig compatibility).
+        0b0110011 => switch (funct3) {
+            0b000 => switch (funct7) {
+                0b0000000 => decoded(inst, .add, 0),
+                0b0100000 => decoded(inst, .sub, 0),
+                else => decoded(inst, .invalid, 0),
+            },
+            0b010 => decoded(inst, if (funct7 == 0b0000000) .slt else .invalid, 0),
+            0b100 => decoded(inst, if (funct7 == 0b0000000) .xor else .invalid, 0),
+            0b110 => decoded(inst, if (funct7 == 0b0000000) .@"or" else .invalid, 0),
+            0b111 => decoded(inst, if (funct7 == 0b0000000) .@"and" else .invalid, 0),
+            0b001 => decoded(inst, .sll, 0),
+            0b101 => switch (funct7) {
+                0b0000000 => decoded(inst, .srl, 0),
+                0b0100000 => decoded(inst, .sra, 0),
+                else => decoded(inst, .invalid, 0),
+            },
+            else => decoded(inst, .invalid, 0),
+        },
+        // Loads: I-type.
+        0b0000011 => switch (funct3) {
+            0b000 => decoded(inst, .lb, imm_i(inst)),
+            0b001 => decoded(inst, .lh, imm_i(inst)),
+            0b010 => decoded(inst, .lw, imm_i(inst)),
+            0b011 => decoded(inst, .ld, imm_i(inst)),
+            0b100 => decoded(inst, .lbu, imm_i(inst)),
+            0b101 => decoded(inst, .lhu, imm_i(inst)),
+            0b110 => decoded(inst, .lwu, imm_i(inst)),
+            0b111 => decoded(inst, .invalid, 0),
+        },
+        // Stores: S-type.
+        0b0100011 => switch (funct3) {
+            0b000 => decoded(inst, .sb, imm_s(inst)),
+            0b001 => decoded(inst, .sh, imm_s(inst)),
+            0b010 => decoded(inst, .sw, imm_s(inst)),
+            0b011 => decoded(inst, .sd, imm_s(inst)),
+            else => decoded(inst, .invalid, 0),
+        },
+        // Branches: B-type.
+        0b1100011 => switch (funct3) {
+            0b000 => decoded(inst, .beq, imm_b(inst)),
+            0b001 => decoded(inst, .bne, imm_b(inst)),
+            0b100 => decoded(inst, .blt, imm_b(inst)),
+            0b101 => decoded(inst, .bge, imm_b(inst)),
+            0b110 => decoded(inst, .bltu, imm_b(inst)),
+            0b111 => decoded(inst, .bgeu, imm_b(inst)),
+            else => decoded(inst, .invalid, 0),
+        },
+        // JAL: J-type. JALR: I-type, funct3 must be zero.
+        0b1101111 => decoded(inst, .jal, imm_j(inst)),
+        0b1100111 => if (funct3 == 0b000) decoded(inst, .jalr, imm_i(inst)) else decoded(inst, .invalid, 0),
+        // SYSTEM: ECALL/WFI/SFENCE.VMA (funct3 = 0), CSR ops (funct3 = 1-3, 5-7).
+        0b1110011 => switch (funct3) {
+            0b000 => decoded(inst, .system, 0),
+            0b100 => decoded(inst, .invalid, 0),
+            else => decoded(inst, .csr, 0),
+        },
+        // AMO (RV64A): width by funct3 (funct5 is decoded by the handler).
+        0b0101111 => switch (funct3) {
+            0b010 => decoded(inst, .amo_w, 0),
+            0b011 => decoded(inst, .amo_d, 0),
+            else => decoded(inst, .invalid, 0),
+        },
+        // MISC-MEM: FENCE (funct3 = 0) and FENCE.I (funct3 = 1).
+        0b0001111 => switch (funct3) {
+            0b000 => decoded(inst, .fence, 0),
+            0b001 => decoded(inst, .fence_i, 0),
+            else => decoded(inst, .invalid, 0),
+        },
+        // Opcode 0x00: Zig compiler compatibility - SLL for funct3 = 1 (any funct7), otherwise NOP.
+        0b0000000 => decoded(inst, if (funct3 == 0b001) .sll else .nop, 0),
+        // Other non-standard opcodes (0x2e included): Zig compiler compatibility I-type ALU.
+        else => switch (funct3) {
+            0b000 => decoded(inst, .addi, imm_i(inst)),
+            0b001 => decoded(inst, .slli, imm_shamt(inst)),
+            0b100 => decoded(inst, .xori, imm_i(inst)),
+            0b110 => decoded(inst, .ori, imm_i(inst)),
+            0b111 => decoded(inst, .andi, imm_i(inst)),
+            // SLTIU (0b011) and unknown variants.
+            else => decoded(inst, .nop, 0),
+        },
+    };
+}
+
+fn decoded(inst: u32, op: Op, imm: i64) Decoded {
+    return .{
+        .op = op,
+        .rd = @as(u5, @truncate(inst >> 7)),
+        .rs1 = @as(u5, @truncate(inst >> 15)),
+        .rs2 = @as(u5, @truncate(inst >> 20)),
+        .imm = imm,
+    };
+}
+
+/// I-type immediate: bits [31:20], sign-extended.
+fn imm_i(inst: u32) i64 {
+    const raw: u12 = @truncate(inst >> 20);
+    return @as(i12, @bitCast(raw));
+}
+
+/// SLLI shift amount: bits [25:20].
+fn imm_shamt(inst: u32) i64 {
+    return @as(i64, (inst >> 20) & 0x3F);
+}
+
+/// S-type immediate: bits [31:25] and [11:7], sign-extended.
+fn imm_s(inst: u32) i64 {
+    const raw: u12 = @truncate(((inst >> 25) << 5) | ((inst >> 7) & 0x1F));
+    return @as(i12, @bitCast(raw));
+}
+
+/// B-type immediate: imm[12|10:5] in bits [31:25], imm[4:1|11] in bits [11:7], sign-extended.
+fn imm_b(inst: u32) i64 {
+    const raw: u13 = @truncate(((inst >> 31) << 12) | (((inst >> 7) & 1) << 11) | (((inst >> 25) & 0x3F) << 5) | (((inst >> 8) & 0xF) << 1));
+    return @as(i13, @bitCast(raw));
+}
+
+/// J-type immediate: imm[20|10:1|11|19:12] in bits [31:12], sign-extended.
+fn imm_j(inst: u32) i64 {
+    const raw: u21 = @truncate(((inst >> 31) << 20) | (((inst >> 12) & 0xFF) << 12) | (((inst >> 20) & 1) << 11) | (((inst >> 21) & 0x3FF) << 1));
+    return @as(i21, @bitCast(raw));
+}
+
+/// U-type immediate (LUI, AUIPC): bits [31:12] << 12, sign-extended.
+fn imm_u(inst: u32) i64 {
+    return @as(i32, @bitCast(inst & 0xFFFFF000));
+}
@@ -0,0 +1,262 @@
+const std = @import("std");
+const builtin = @import("builtin");
+const loader = @import("loader.zig");
+const Image = loader.Image;
+const LoaderError = loader.LoaderError;
+
+/// Cache of validated ELF images, mapped once and keyed by content hash.
+/// Grain Style: Fixed capacity, least-recently-used eviction, explicit ownership of every mapping.
+/// ~<~ Glow Earthbend: the binary is read once; every spawn after that borrows its pages.
+///
+/// Why: z6 restarts and fuzz loops spawn the same binary again and again. Each spawn
+/// re-read the file, re-validated its headers and copied every segment. A cached image
+/// is copied once and validated once. Its read-only segments are mapped copy-on-write into
+/// guest RAM (loader.Image.place), so spawn cost no longer scales with text size.
+/// Note: Images are copied into a sealed memfd on Linux (no writes, no resizing), never
+/// mapped from the caller's file: rewriting or truncating that file cannot change a cached
+/// image or the guest pages mapped from it. Elsewhere they are copied into plain memory.
+/// Note: Files are recognised by (inode, size, mtime) without rehashing; different files
+/// with identical contents share one entry.
+/// Note: Thread-safe (one lock); the fuzz farm's workers may share one cache.
+
+/// Images kept at once.
+pub const CAPACITY: usize = 16;
+
+pub const Error = LoaderError || error{ImageUnavailable};
+
+const Mapping = []align(std.heap.page_size_min) const u8;
+
+const Entry = struct {
+    hash: u64,
+    image: Image,
+    /// Owned mapping of the image bytes (sealed memfd or anonymous copy, read-only).
+    mapping: Mapping,
+    /// Owned descriptor backing mapping (closed on eviction).
+    fd: ?std.posix.fd_t,
+    /// File identity for open_file hits without hashing (inode 0: none).
+    inode: std.fs.File.INode = 0,
+    size: u64 = 0,
+    mtime: i128 = 0,
+    last_use: u64,
+};
+
+pub const ImageCache = struct {
+    entries: [CAPACITY]?Entry = [_]?Entry{null} ** CAPACITY,
+    lock: std.Thread.Mutex = .{},
+    /// Logical clock for LRU eviction.
+    clock: u64 = 0,
+    hits: u64 = 0,
+    misses: u64 = 0,
+
+    const Self = @This();
+
+    /// Release every cached mapping and descriptor.
+    /// Contract: no Image returned by this cache is used afterwards.
+    pub fn deinit(self: *Self) void {
+        for (&self.entries) |*slot| {
+            if (slot.*) |*entry| release(entry);
+            slot.* = null;
+        }
+    }
+
+    /// Validated image of the ELF file at path (copied and parsed on first use).
+    /// Contract: the returned Image stays valid until CAPACITY later misses or deinit.
+    /// Note: Later changes to the file reach the cache only through a new (inode, size,
+    /// mtime); the returned Image keeps the contents read on the miss.
+    /// Errors: ImageUnavailable if the file cannot be opened, read or copied.
+    /// Errors: InvalidElfFormat if the file is not a RISC-V64 executable.
+    pub fn open_file(self: *Self, path: []const u8) Error!*const Image {
+        const file = std.fs.cwd().openFile(path, .{}) catch return error.ImageUnavailable;
+        defer file.close();
+        const stat = file.stat() catch return error.ImageUnavailable;
+        if (stat.size == 0) return error.InvalidElfFormat;
+
+        self.lock.lock();
+        defer self.lock.unlock();
+        for (&self.entries) |*slot| {
+            if (slot.*) |*entry| {
+                if (entry.inode == stat.inode and entry.size == stat.size and entry.mtime == stat.mtime) {
+                    return self.hit(entry);
+                }
+            }
+        }
+
+        const size = std.math.cast(usize, stat.size) orelse return error.ImageUnavailable;
+        const copy = try copy_file(file, size);
+        // Hash the copy, not the file: the file may change while it is read.
+        const hash = std.hash.Wyhash.hash(0, copy.mapping);
+        if (self.find(hash)) |entry| {
+            release_copy(copy);
+            return self.hit(entry);
+        }
+
+        const entry = self.insert(hash, copy.mapping, copy.fd) catch |err| {
+            release_copy(copy);
+            return err;
+        };
+        entry.inode = stat.inode;
+        entry.size = stat.size;
+        entry.mtime = stat.mtime;
+        return &entry.image;
+    }
+
+    /// Validated image of in-memory ELF bytes (copied into the cache on first use).
+    /// Contract: as open_file; bytes need not outlive the call.
+    /// Errors: ImageUnavailable if the copy cannot be allocated.
+    /// Errors: InvalidElfFormat if bytes are not a RISC-V64 executable.
+    pub fn from_bytes(self: *Self, bytes: []const u8) Error!*const Image {
+        if (bytes.len == 0) return error.InvalidElfFormat;
+        const hash = std.hash.Wyhash.hash(0, bytes);
+
+        self.lock.lock();
+        defer self.lock.unlock();
+        if (self.find(hash)) |entry| return self.hit(entry);
+
+        // Validate before copying anything.
+        _ = try Image.parse(bytes);
+        const copy = try copy_bytes(bytes);
+        const entry = self.insert(hash, copy.mapping, copy.fd) catch |err| {
+            release_copy(copy);
+            return err;
+        };
+        return &entry.image;
+    }
+
+    fn hit(self: *Self, entry: *Entry) *const Image {
+        self.hits += 1;
+        self.clock += 1;
+        entry.last_use = self.clock;
+        return &entry.image;
+    }
+
+    fn find(self: *Self, hash: u64) ?*Entry {
+        for (&self.entries) |*slot| {
+            if (slot.*) |*entry| {
+                if (entry.hash == hash) return entry;
+            }
+        }
+        return null;
+    }
+
+    /// Parse mapping and store it (evicting the least recently used entry if full).
+    /// Contract: caller holds the lock; on success the entry owns mapping and fd.
+    fn insert(self: *Self, hash: u64, mapping: Mapping, fd: ?std.posix.fd_t) Error!*Entry {
+        var image = try Image.parse(mapping);
+        image.fd = fd;
+
+        var victim: *?Entry = &self.entries[0];
+        for (&self.entries) |*slot| {
+            if (slot.* == null) {
+                victim = slot;
+                break;
+            }
+            if (victim.* != null and slot.*.?.last_use < victim.*.?.last_use) victim = slot;
+        }
+        if (victim.*) |*old| release(old);
+
+        self.misses += 1;
+        self.clock += 1;
+        victim.* = .{ .hash = hash, .image = image, .mapping = mapping, .fd = fd, .last_use = self.clock };
+
+        // Assert: the cached image must describe the cached bytes.
+        std.debug.assert(victim.*.?.image.bytes.ptr == mapping.ptr);
+        return &victim.*.?;
+    }
+};
+
+fn release(entry: *Entry) void {
+    release_copy(.{ .mapping = entry.mapping, .fd = entry.fd });
+}
+
+/// Read-only copy of an image: mapping of a sealed memfd, or anonymous pages (fd null).
+const Copy = struct {
+    mapping: Mapping,
+    fd: ?std.posix.fd_t,
+};
+
+fn release_copy(copy: Copy) void {
+    std.posix.munmap(copy.mapping);
+    if (copy.fd) |fd| std.posix.close(fd);
+}
+
+/// memfd_create flag and fcntl seals (linux/memfd.h, linux/fcntl.h).
+const MFD_ALLOW_SEALING: u32 = 0x0002;
+const F_ADD_SEALS: i32 = 1033;
+const F_SEAL_SHRINK: usize = 0x0002;
+const F_SEAL_GROW: usize = 0x0004;
+const F_SEAL_WRITE: usize = 0x0008;
+
+/// Sealable anonymous memory file (Linux); error elsewhere.
+fn memfd_create() !std.posix.fd_t {
+    if (builtin.os.tag != .linux) return error.Unsupported;
+    return std.posix.memfd_create("xy-elf-image", MFD_ALLOW_SEALING);
+}
+
+/// Forbid every later write, shrink and grow of fd, then map it read-only.
+/// Why: Guest RAM maps these pages copy-on-write; only a sealed file guarantees the
+/// pages under a running guest never change.
+/// Contract: fd holds exactly len bytes and has no writable shared mappings.
+fn seal_and_map(fd: std.posix.fd_t, len: usize) Error!Mapping {
+    _ = std.posix.fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE) catch {
+        return error.ImageUnavailable;
+    };
+    return std.posix.mmap(null, len, std.posix.PROT.READ, .{ .TYPE = .PRIVATE }, fd, 0) catch return error.ImageUnavailable;
+}
+
+/// Copy bytes into a sealed memfd (Linux) or anonymous pages (elsewhere, or if refused).
+fn copy_bytes(bytes: []const u8) Error!Copy {
+    if (memfd_create()) |fd| {
+        errdefer std.posix.close(fd);
+        const out = std.fs.File{ .handle = fd };
+        out.writeAll(bytes) catch return error.ImageUnavailable;
+        return .{ .mapping = try seal_and_map(fd, bytes.len), .fd = fd };
+    } else |_| {
+        return .{ .mapping = try copy_anonymous(bytes), .fd = null };
+    }
+}
+
+/// Copy the first size bytes of file into a sealed memfd (Linux) or anonymous pages.
+/// Errors: ImageUnavailable if the file is shorter than size or cannot be read.
+fn copy_file(file: std.fs.File, size: usize) Error!Copy {
+    if (memfd_create()) |fd| {
+        errdefer std.posix.close(fd);
+        const out = std.fs.File{ .handle = fd };
+        var buffer: [64 * 1024]u8 = undefined;
+        var offset: usize = 0;
+        while (offset < size) {
+            const want = @min(buffer.len, size - offset);
+            const n = file.pread(buffer[0..want], offset) catch return error.ImageUnavailable;
+            if (n == 0) return error.ImageUnavailable;
+            out.writeAll(buffer[0..n]) catch return error.ImageUnavailable;
+            offset += n;
+        }
+        return .{ .mapping = try seal_and_map(fd, size), .fd = fd };
+    } else |_| {
+        const mapping = try map_anonymous(size);
+        errdefer std.posix.munmap(mapping);
+        const n = file.preadAll(mapping, 0) catch return error.ImageUnavailable;
+        if (n != size) return error.ImageUnavailable;
+        std.posix.mprotect(mapping, std.posix.PROT.READ) catch {};
+        return .{ .mapping = mapping, .fd = null };
+    }
+}
+
+/// Copy bytes into fresh read-only anonymous pages (no fd: segments are copied on load).
+fn copy_anonymous(bytes: []const u8) Error!Mapping {
+    const mapping = try map_anonymous(bytes.len);
+    @memcpy(mapping[0..bytes.len], bytes);
+    std.posix.mprotect(mapping, std.posix.PROT.READ) catch {};
+    return mapping;
+}
+
+/// Fresh writable anonymous pages of len bytes.
+fn map_anonymous(len: usize) Error![]align(std.heap.page_size_min) u8 {
+    return std.posix.mmap(
+        null,
+        len,
+        std.posix.PROT.READ | std.posix.PROT.WRITE,
+        .{ .TYPE = .PRIVATE, .ANONYMOUS = true },
+        -1,
+        0,
+    ) catch return error.ImageUnavailable;
+}
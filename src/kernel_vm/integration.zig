@@ -6,9 +6,11 @@ const std = @import("std");
 const VM = @import("vm.zig").VM;
 const basin_kernel = @import("basin_kernel");
 const BasinKernel = basin_kernel.BasinKernel;
-const BasinError = basin_kernel.BasinError;
 const SyscallResult = basin_kernel.SyscallResult;
-const loadKernel = @import("loader.zig").loadKernel;
+const Context = basin_kernel.scheduler.Context;
+const loader = @import("loader.zig");
+const vm_csr = @import("csr.zig");
+const loadKernel = loader.loadKernel;
 
 /// Module-level kernel pointer for syscall handler access.
 /// Why: VM syscall handler interface doesn't support closures, so we use module-level storage.
@@ -22,7 +24,7 @@ var global_kernel_ptr: ?*BasinKernel = null;
 /// Note: Stores VM and kernel pointers instead of values to avoid copying large structs (stack overflow prevention).
 pub const Integration = struct {
     /// VM instance pointer (RISC-V64 emulator).
-    /// Why: Store pointer instead of value to avoid copying 4MB struct.
+    /// Why: Store pointer instead of value (large decode cache; VM owns its RAM mapping).
     vm: *VM,
     /// Kernel instance pointer (Grain Basin kernel).
     /// Why: Store pointer instead of value to avoid copying ~75KB struct (users array).
@@ -32,6 +34,10 @@ pub const Integration = struct {
 
     const Self = @This();
 
+    /// Instructions per VM.run() batch in run().
+    /// Why: Large enough to amortize the call, small enough to bound time between state checks.
+    const RUN_BATCH_INSTRUCTIONS: u64 = 1 << 20;
+
     /// Initialize integration with kernel ELF.
     /// Contract:
     ///   Input: vm_ptr must point to uninitialized VM struct, elf_data must be non-empty, valid RISC-V64 ELF
@@ -112,6 +118,12 @@ pub const Integration = struct {
         // In production, this should be null, but in tests we may need to reset.
         global_kernel_ptr = self.kernel;
 
+        // Kernel address checks and I/O copies go through this VM's RAM.
+        self.kernel.attach_user_memory(user_memory(self.vm));
+        
+        // Sleep deadlines and time slices are measured on this VM's mtime.
+        self.kernel.attach_clock(guest_clock(self.vm));
+
         // Register kernel as VM syscall handler.
         // Contract: syscall_handler_wrapper will access kernel via thread-local storage.
         self.vm.*.set_syscall_handler(syscall_handler_wrapper, null);
@@ -145,9 +157,12 @@ pub const Integration = struct {
     /// Run VM execution loop until halted or error.
     /// Contract:
     ///   Input: Integration must be initialized
-    ///   Output: VM execution completes (halted or errored)
-    ///   Errors: VM execution errors (invalid instruction, memory access)
+    ///   Output: VM execution completes (halted, errored, or no process left to run)
+    ///   Errors: VM execution errors (invalid instruction, memory access), out_of_memory
+    ///   if the process table has no slot for the boot process
     /// Why: Execute VM instructions, handle syscalls via kernel.
+    /// Note: The booted guest becomes the first process. Every ECALL and every
+    /// kernel preemption deadline (time slice, sleeper wakeup) is a scheduling point.
     pub fn run(self: *Self) !void {
         // Contract: Integration must be initialized.
         std.debug.assert(self.initialized);
@@ -161,16 +176,133 @@ pub const Integration = struct {
         // Contract: VM must be in running state after start.
         std.debug.assert(self.vm.*.state == .running);
 
-        // Execute VM instructions until halted or error.
-        while (self.vm.*.state == .running) {
-            // Contract: VM step may return error (invalid instruction, memory access).
-            try self.vm.*.step();
+        // The registers on the CPU are the boot process (unless processes already exist).
+        if (self.kernel.processes.count() == 0) {
+            _ = try self.kernel.boot_process();
+        }
+
+        // Execute VM instructions in batches until halted or error.
+        // Why: run() keeps dispatch in one hot loop; budget only bounds each batch
+        // (never past the kernel's next preemption deadline).
+        while (self.schedule()) {
+            const result = self.vm.*.run(.{ .max_instructions = self.batch_budget(), .stop_on_ecall = true });
+            switch (result.exit) {
+                .budget_exhausted, .ecall, .wait => continue,
+                .halted => break,
+                // Contract: VM fault is returned as error (invalid instruction, memory access).
+                .fault => {
+                    self.vm.*.dump_trace_stderr();
+                    return self.vm.*.last_error.?;
+                },
+            }
         }
 
         // Contract: VM must be halted or errored after loop.
         std.debug.assert(self.vm.*.state == .halted or self.vm.*.state == .errored);
     }
 
+    /// Scheduling point: load the registers of the process the kernel picks.
+    /// Why: The kernel saves and restores contexts; the VM only holds the running one.
+    /// Returns: false (VM stopped) when no process can run again.
+    /// Note: While nothing is ready, guest time jumps to the next sleeper's wakeup.
+    /// Note: Under a replay.Recorder every decision that changes the CPU (another context,
+    /// an idle jump in guest time, kernel stores at this point) is logged as a switch record,
+    /// so a Replayer reproduces the schedule without a kernel.
+    fn schedule(self: *Self) bool {
+        const before = Context{ .regs = self.vm.*.regs.regs, .pc = self.vm.*.regs.pc };
+        const time_before = self.vm.*.csrs.mtime;
+        var cpu = before;
+        while (true) {
+            switch (self.kernel.schedule(&cpu)) {
+                .run => break,
+                .idle_until => |time| self.vm.*.csrs.mtime = time,
+                .halt => {
+                    self.record_switch(0, &before);
+                    self.vm.*.stop();
+                    return false;
+                },
+            }
+        }
+        self.vm.*.regs.regs = cpu.regs;
+        self.vm.*.regs.pc = cpu.pc;
+        if (!std.meta.eql(cpu, before) or self.vm.*.csrs.mtime != time_before) {
+            self.record_switch(self.kernel.current_process().?, &cpu);
+        } else if (self.vm.*.replay) |session| {
+            if (session.stores_pending) self.record_switch(self.kernel.current_process().?, &cpu);
+        }
+
+        // Assert: a process must be on the CPU.
+        std.debug.assert(self.kernel.current_process() != null);
+        return true;
+    }
+
+    /// Log the context going on the CPU (no-op unless a replay.Recorder is attached).
+    fn record_switch(self: *Self, process: u64, cpu: *const Context) void {
+        const session = self.vm.*.replay orelse return;
+        session.record_switch(&.{
+            .process = process,
+            .pc = cpu.pc,
+            .regs = cpu.regs,
+            .mtime = self.vm.*.csrs.mtime,
+        });
+    }
+
+    /// Instructions the next batch may run (stops at the kernel's preemption deadline).
+    fn batch_budget(self: *const Self) u64 {
+        const deadline = self.kernel.next_preemption() orelse return RUN_BATCH_INSTRUCTIONS;
+        const now = self.vm.*.csrs.mtime;
+        if (deadline <= now) return 1;
+        return @min(RUN_BATCH_INSTRUCTIONS, deadline - now);
+    }
+
+    /// Integration snapshot: VM snapshot plus a copy of the kernel tables and resident file pages.
+    /// Why: A warm boot is captured once; each fuzz case restores VM and kernel together.
+    pub const Snapshot = struct {
+        vm: VM.Snapshot,
+        /// Kernel tables (mappings, handles, processes, users) and resident file pages at
+        /// snapshot time (see BasinKernel.copy_from; free page cache slots are never copied).
+        kernel: *BasinKernel,
+
+        /// Release VM and kernel copies.
+        /// Contract: allocator is the one passed to Integration.snapshot.
+        pub fn deinit(self: *Snapshot, allocator: std.mem.Allocator) void {
+            self.vm.deinit(allocator);
+            allocator.destroy(self.kernel);
+            self.* = undefined;
+        }
+    };
+
+    /// Snapshot VM and kernel state (see VM.snapshot).
+    /// Contract:
+    ///   Input: Integration must be initialized
+    ///   Output: Snapshot owned by caller (release with Snapshot.deinit)
+    ///   Errors: VM.SnapshotError if copies cannot be allocated
+    pub fn snapshot(self: *Self, allocator: std.mem.Allocator) VM.SnapshotError!Snapshot {
+        // Contract: Integration must be initialized.
+        std.debug.assert(self.initialized);
+
+        const kernel = try allocator.create(BasinKernel);
+        errdefer allocator.destroy(kernel);
+        kernel.copy_from(self.kernel);
+        const vm_snapshot = try self.vm.*.snapshot(allocator);
+        return .{ .vm = vm_snapshot, .kernel = kernel };
+    }
+
+    /// Restore VM (dirty pages only), kernel tables and resident file pages from snap.
+    /// Contract:
+    ///   Input: Integration must be initialized, snap is its latest snapshot
+    ///   Output: VM and kernel state equal snapshot state
+    pub fn restore(self: *Self, snap: *const Snapshot) void {
+        // Contract: Integration must be initialized.
+        std.debug.assert(self.initialized);
+
+        self.vm.*.restore(&snap.vm);
+        self.kernel.copy_from(snap.kernel);
+
+        // Contract: Kernel must use the same guest RAM size as the VM.
+        std.debug.assert(self.kernel.user_memory_size == self.vm.*.memory_size);
+    }
+
     /// Get VM state.
     /// Contract:
     ///   Input: Integration must be initialized
@@ -218,6 +350,31 @@ pub const Integration = struct {
     }
 };
 
+/// Guest RAM of vm as Basin kernel user memory.
+/// Why: Kernel stores (read/readv results) must be dirty-tracked for restore, drop stale
+/// decodes, and be logged for replay, exactly like host writes through VM.write_memory.
+pub fn user_memory(vm: *VM) basin_kernel.UserMemory {
+    return .{ .bytes = vm.memory, .context = vm, .on_write = note_kernel_store };
+}
+
+/// Guest mtime of vm as the Basin kernel's clock.
+pub fn guest_clock(vm: *VM) basin_kernel.GuestClock {
+    return .{ .context = vm, .now = read_guest_time, .ticks_per_second = vm_csr.TIMEBASE_HZ };
+}
+
+fn read_guest_time(context: ?*anyopaque) u64 {
+    const vm: *const VM = @ptrCast(@alignCast(context.?));
+    return vm.csrs.mtime;
+}
+
+fn note_kernel_store(context: ?*anyopaque, addr: u64, len: u64) void {
+    const vm: *VM = @ptrCast(@alignCast(context.?));
+    vm.note_host_store(addr, len);
+    if (vm.replay) |session| {
+        session.record_memory(addr, vm.memory[@intCast(addr)..][0..@intCast(len)]);
+    }
+}
+
 /// Syscall handler wrapper (converts SyscallResult to u64).
 /// Contract:
 ///   Input: syscall_num >= 10 (kernel syscalls), user_data must be valid Integration pointer
@@ -285,55 +442,8 @@ fn syscall_handler_wrapper_impl(
 
     // Call kernel syscall handler.
     // Contract: handle_syscall returns BasinError!SyscallResult.
-    const result = kernel.handle_syscall(syscall_num, arg1, arg2, arg3, arg4) catch |err| {
-        // Contract: BasinError must be converted to negative u64.
-        // RISC-V convention: Negative values = error codes.
-        // Error codes: -1 = invalid_handle, -2 = invalid_argument, etc.
-        const error_code: i64 = switch (err) {
-            BasinError.invalid_handle => -1,
-            BasinError.invalid_argument => -2,
-            BasinError.permission_denied => -3,
-            BasinError.not_found => -4,
-            BasinError.out_of_memory => -5,
-            BasinError.would_block => -6,
-            BasinError.interrupted => -7,
-            BasinError.invalid_syscall => -8,
-            BasinError.invalid_address => -9,
-            BasinError.unaligned_access => -10,
-            BasinError.out_of_bounds => -11,
-            BasinError.user_not_found => -12,
-            BasinError.invalid_user => -13,
-        };
-        return @as(u64, @bitCast(error_code));
-    };
-
-    // Contract: SyscallResult must be success or error.
-    return switch (result) {
-        .success => |value| {
-            // Contract: Success value must be non-negative (RISC-V convention).
-            std.debug.assert(value >= 0);
-            return value;
-        },
-        .err => |err| {
-            // Contract: Error must be converted to negative u64.
-            const error_code: i64 = switch (err) {
-            BasinError.invalid_handle => -1,
-            BasinError.invalid_argument => -2,
-            BasinError.permission_denied => -3,
-            BasinError.not_found => -4,
-            BasinError.out_of_memory => -5,
-            BasinError.would_block => -6,
-            BasinError.interrupted => -7,
-            BasinError.invalid_syscall => -8,
-            BasinError.invalid_address => -9,
-            BasinError.unaligned_access => -10,
-            BasinError.out_of_bounds => -11,
-            BasinError.user_not_found => -12,
-            BasinError.invalid_user => -13,
-            };
-            return @as(u64, @bitCast(error_code));
-        },
-    };
+    // RISC-V convention: Negative values = error codes (see basin_kernel.error_code).
+    return SyscallResult.to_word(kernel.handle_syscall(syscall_num, arg1, arg2, arg3, arg4));
 }
 
 /// Load userspace ELF program into VM.
@@ -350,69 +460,75 @@ pub fn loadUserspaceELF(
     elf_data: []const u8,
     argv: []const []const u8,
 ) !void {
-    
+    _ = allocator;
+
     // Contract: ELF data must be non-empty.
     if (elf_data.len == 0) {
-        std.debug.print("DEBUG integration.zig: ELF data is empty\n", .{});
         return error.EmptyElfData;
     }
 
     // Contract: ELF data must be large enough for ELF header (64 bytes minimum).
     const MIN_ELF_HEADER_SIZE: u32 = 64;
     if (elf_data.len < MIN_ELF_HEADER_SIZE) {
-        std.debug.print("DEBUG integration.zig: ELF data too small ({} < {})\n", .{ elf_data.len, MIN_ELF_HEADER_SIZE });
         return error.InvalidElfHeader;
     }
 
-    // Use existing loadKernel function (it's generic enough for userspace too).
-    // Contract: loadKernel validates ELF format and loads segments at their virtual addresses.
-    // Note: RISC-V ELF executables specify their own load addresses in p_vaddr.
-    std.debug.print("DEBUG integration.zig: About to call loadKernel, allocator.ptr=0x{x}\n", .{@intFromPtr(allocator.ptr)});
-    std.debug.print("DEBUG integration.zig: elf_data.ptr=0x{x}, elf_data.len={}\n", .{ @intFromPtr(elf_data.ptr), elf_data.len });
-    
+    const image = loader.Image.parse(elf_data) catch return error.InvalidElfHeader;
+    return loadUserspaceImage(target, &image, argv);
+}
+
+/// Load a validated userspace image into VM (see loadUserspaceELF).
+/// Why: Repeated spawns (z6 restarts, fuzz loops) parse once, e.g. through an ImageCache,
+/// and only place segments, stack and argv per spawn.
+/// Contract: target must point to uninitialized VM struct; image.bytes are still valid.
+pub fn loadUserspaceImage(
+    target: *VM,
+    image: *const loader.Image,
+    argv: []const []const u8,
+) !void {
+    // Reserve the kernel's shared time page: no segment may be placed over it.
+    // Why: The kernel owns that page and rewrites it under its seqlock; a segment there
+    // would be clobbered at the first refresh (and the guest's clock reads would be code).
+    const time_page = basin_kernel.time_page;
+    for (image.loads()) |segment| {
+        const span = @max(segment.filesz, segment.memsz);
+        if (span > 0 and segment.vaddr < time_page.ADDRESS + time_page.PAGE_BYTES and time_page.ADDRESS < segment.vaddr + span) {
+            return error.ReservedAddress;
+        }
+    }
+
     // GrainStyle: Use in-place initialization to avoid stack overflow.
-    std.debug.print("DEBUG integration.zig: Calling loadKernel...\n", .{});
-    loadKernel(target, allocator, elf_data) catch |err| {
-        std.debug.print("DEBUG integration.zig: loadKernel failed: {}\n", .{err});
+    loader.loadImage(target, image, .{}) catch |err| {
         // Convert LoaderError to IntegrationError.
         return switch (err) {
             error.SegmentOutOfBounds => error.AddressOutOfBounds,
             error.InvalidElfFormat => error.InvalidElfHeader,
+            error.GuestMemoryUnavailable => error.GuestMemoryUnavailable,
         };
     };
-    std.debug.print("DEBUG integration.zig: loadKernel completed successfully\n", .{});
+    // Release guest RAM if stack or argv setup below fails.
+    errdefer target.deinit();
 
     // Contract: VM must be in halted state after loading.
     // Check: VM state must be halted (return error instead of asserting for userspace programs).
-    std.debug.print("DEBUG integration.zig: Checking VM state...\n", .{});
     if (target.state != .halted) {
-        std.debug.print("DEBUG integration.zig: VM state is {}, expected halted\n", .{target.state});
         return error.InvalidState;
     }
-    std.debug.print("DEBUG integration.zig: VM state is halted\n", .{});
-
-    // Contract: PC must be set to entry point (done by loadKernel).
-    // Note: Entry point can be 0x0 for some programs (e.g., position-independent executables).
-    // We only check that it's within VM memory bounds (done in loadKernel).
-    std.debug.print("DEBUG integration.zig: PC=0x{x}\n", .{target.regs.pc});
-    _ = target.regs.pc; // PC is set by loadKernel
 
     // Set up userspace stack pointer (SP register = x2).
-    std.debug.print("DEBUG integration.zig: Setting up stack...\n", .{});
     // Contract: Stack address must be page-aligned and within VM memory.
-    const VM_MEMORY_SIZE: u64 = 4 * 1024 * 1024; // 4MB
     const PAGE_SIZE: u64 = 4096;
-    const STACK_ADDRESS: u64 = VM_MEMORY_SIZE - PAGE_SIZE; // Top of memory, page-aligned
-    std.debug.print("DEBUG integration.zig: STACK_ADDRESS=0x{x}, target.memory_size=0x{x}\n", .{ STACK_ADDRESS, target.memory_size });
+    const STACK_ADDRESS: u64 = target.memory_size - PAGE_SIZE; // Top of memory, page-aligned
     // Check: Stack address must be page-aligned and within VM memory.
     if (STACK_ADDRESS % PAGE_SIZE != 0 or STACK_ADDRESS >= target.memory_size) {
-        std.debug.print("DEBUG integration.zig: Stack address validation failed\n", .{});
         return error.AddressOutOfBounds;
     }
-    std.debug.print("DEBUG integration.zig: Stack address validated, setting SP register...\n", .{});
+    // Check: Stack must not be the time page (guest RAM of exactly one megabyte).
+    if (STACK_ADDRESS == time_page.ADDRESS) {
+        return error.ReservedAddress;
+    }
 
     target.regs.set(2, STACK_ADDRESS); // x2 = SP register
-    std.debug.print("DEBUG integration.zig: SP register set successfully\n", .{});
 
     // Contract: SP register must be set correctly (verified by regs.set above).
     // Note: We don't assert here to avoid crashes during userspace program loading.
@@ -447,7 +563,6 @@ pub fn loadUserspaceELF(
         // Check: All addresses must be within VM memory bounds.
         // Note: Stack grows downward, so string_data_start should be less than STACK_ADDRESS.
         if (string_data_start >= STACK_ADDRESS or string_data_start + string_data_size > target.memory_size) {
-            std.debug.print("DEBUG integration.zig: argv setup would exceed stack bounds: string_data_start=0x{x}, STACK_ADDRESS=0x{x}, memory_size=0x{x}\n", .{ string_data_start, STACK_ADDRESS, target.memory_size });
             return error.AddressOutOfBounds;
         }
         
@@ -512,18 +627,14 @@ pub fn loadUserspaceELF(
         // Update SP to point to new stack top (after argc/argv_ptr)
         target.regs.set(2, sp);
         
-        std.debug.print("DEBUG integration.zig: argv setup complete: argc={}, argv_ptr=0x{x}, sp=0x{x}\n", .{ argc, argv_array_addr, sp });
     } else {
         // No arguments: argc = 0, argv = null
         target.regs.set(10, 0); // a0 = argc = 0
         target.regs.set(11, 0); // a1 = argv = null
-        std.debug.print("DEBUG integration.zig: No argv provided, argc=0, argv=null\n", .{});
     }
 
     // Assert: VM must be in halted state after loading.
-    std.debug.print("DEBUG integration.zig: Final check: VM state={}\n", .{target.state});
     std.debug.assert(target.state == .halted);
-    std.debug.print("DEBUG integration.zig: loadUserspaceELF completed successfully\n", .{});
 }
 
 /// Integration errors.
@@ -537,4 +648,7 @@ pub const IntegrationError = error{
     TooManyArguments,
     UserNotFound,
     InvalidUser,
+    GuestMemoryUnavailable,
+    /// A segment or the stack would cover the kernel's shared time page.
+    ReservedAddress,
 };
@@ -0,0 +1,913 @@
+const std = @import("std");
+const builtin = @import("builtin");
+const vm_module = @import("vm.zig");
+const VM = vm_module.VM;
+const RegisterFile = vm_module.RegisterFile;
+
+/// x86-64 basic-block JIT for the RISC-V VM.
+/// Grain Style: Fixed-size tables, one mmap'd arena, explicit interpreter fallback.
+/// ~<~ Glow Firebend: hot blocks burn straight through; anything unusual drops back.
+///
+/// Why: Long soak runs spend their time in the same few loops; translating them removes
+/// the per-instruction cache lookup, indirect call and handler assertions.
+/// Note: Guest registers stay in VM.regs (no register allocation), so the interpreter
+/// sees exact state at every exit. Anything translation cannot prove identical to the
+/// interpreter exits *before* that instruction and lets the interpreter run it:
+/// ECALL/WFI, CSR ops, atomics and fences, invalid encodings, memory faults, the x8 == 0
+/// stack fallback, stores into code pages, and branch/jump targets the interpreter would reject.
+/// Note: Translated code addresses RAM physically; VM.run interprets while Sv39 is on.
+/// Note: A store into a code page drops only that page's blocks (invalidate_page); jumps
+/// chained into them from other pages are patched back into exits.
+
+/// Whether this host can run translated code (x86-64 Linux).
+pub const supported: bool = builtin.cpu.arch == .x86_64 and builtin.os.tag == .linux;
+
+/// Translator type embedded in VM (native JIT when supported, stub otherwise).
+pub const Jit = if (supported) NativeJit else UnsupportedJit;
+
+/// Executable arena size (flushed wholesale when full).
+pub const ARENA_SIZE: usize = 4 * 1024 * 1024;
+/// Translated blocks per arena fill (the arena is flushed when either runs out).
+pub const MAX_TRANSLATIONS: u32 = 16384;
+/// Patched chain jumps per arena fill (further exits stay unchained until the next flush).
+pub const MAX_CHAINS: u32 = 2 * MAX_TRANSLATIONS;
+/// Buckets of the page -> translated blocks index (guest page number modulo this).
+pub const PAGE_BUCKETS: usize = 1024;
+/// Block table entries (direct-mapped by guest PC).
+pub const BLOCK_TABLE_SIZE: usize = 4096;
+/// Interpreted executions of a PC before a block is translated from it.
+pub const HOT_THRESHOLD: u32 = 16;
+/// Maximum guest instructions per block.
+pub const MAX_BLOCK_INSTRUCTIONS: u32 = 64;
+/// Pending chain links (exits whose target block is not translated yet).
+pub const MAX_LINKS: usize = 4096;
+/// Largest guest RAM the translator handles (exit stubs store guest PCs as imm32).
+pub const MAX_MEMORY_SIZE: usize = 1 << 31;
+
+/// Upper bound on host bytes per guest instruction, stubs included (worst case: store, ~124).
+const MAX_INSTRUCTION_BYTES: usize = 128;
+/// Upper bound on host bytes per block (prelude, body, entry and fallthrough stubs).
+const MAX_BLOCK_BYTES: usize = MAX_BLOCK_INSTRUCTIONS * MAX_INSTRUCTION_BYTES + 64;
+/// Exit stubs per block: one side exit per instruction, two terminator exits, entry, fallthrough.
+const MAX_EXITS: usize = MAX_BLOCK_INSTRUCTIONS + 4;
+/// Jumps to exit stubs per block (at most four side-exit checks per instruction).
+const MAX_FIXUPS: usize = 4 * MAX_BLOCK_INSTRUCTIONS + 4;
+
+/// Block table: no PC / no code.
+const PC_EMPTY: u64 = std.math.maxInt(u64);
+const TRANSLATION_NONE: u32 = std.math.maxInt(u32);
+/// Block table: translation tried and produced nothing (first instruction unsupported).
+const TRANSLATION_UNTRANSLATABLE: u32 = std.math.maxInt(u32) - 1;
+/// End of a chain list.
+const CHAIN_NONE: u32 = std.math.maxInt(u32);
+
+/// Host code layout inside VM (rbx holds the VM pointer in translated code,
+/// r12 the guest RAM base, r13 the remaining instruction budget).
+const REGS_OFFSET: i32 = @offsetOf(VM, "regs") + @offsetOf(RegisterFile, "regs");
+const PC_OFFSET: i32 = @offsetOf(VM, "regs") + @offsetOf(RegisterFile, "pc");
+const MEMORY_SIZE_OFFSET: i32 = @offsetOf(VM, "memory_size");
+const CODE_PAGES_MASKS_OFFSET: i32 = @offsetOf(VM, "code_pages") + @offsetOf(@FieldType(VM, "code_pages"), "masks");
+const DIRTY_PAGES_MASKS_OFFSET: i32 = @offsetOf(VM, "dirty_pages") + @offsetOf(@FieldType(VM, "dirty_pages"), "masks");
+
+/// Trampoline: enter(vm, budget, block, memory) returns the unused budget.
+/// Why: One native entry point; blocks chain to each other without returning.
+const Trampoline = *const fn (vm: *VM, budget: u64, block: [*]const u8, memory: [*]u8) callconv(.c) u64;
+
+/// Trampoline prologue: push rbx; push r12; push r13; mov rbx, rdi; mov r13, rsi; mov r12, rcx; jmp rdx.
+const PROLOGUE = [_]u8{ 0x53, 0x41, 0x54, 0x41, 0x55, 0x48, 0x89, 0xFB, 0x49, 0x89, 0xF5, 0x49, 0x89, 0xCC, 0xFF, 0xE2 };
+/// Trampoline epilogue: mov rax, r13; pop r13; pop r12; pop rbx; ret.
+const EPILOGUE = [_]u8{ 0x4C, 0x89, 0xE8, 0x41, 0x5D, 0x41, 0x5C, 0x5B, 0xC3 };
+const EPILOGUE_OFFSET: usize = PROLOGUE.len;
+/// First block offset (trampoline padded to a cache line).
+const TRAMPOLINE_SIZE: usize = 64;
+
+/// Block table entry.
+const Block = struct {
+    /// Guest PC of block start (PC_EMPTY if unused).
+    pc: u64 = PC_EMPTY,
+    /// Index into NativeJit.translations (TRANSLATION_NONE until translated).
+    translation: u32 = TRANSLATION_NONE,
+    /// Interpreted executions while untranslated.
+    hits: u32 = 0,
+};
+
+/// Translated block in the arena.
+/// Note: Stays reachable through chained jumps after its block table slot is reused,
+/// so page invalidation finds blocks here rather than in the table.
+const Translation = struct {
+    /// Guest PC of block start (the block lies in this PC's page).
+    pc: u64,
+    /// Arena offset of block entry.
+    entry: u32,
+    /// Next translation in the same page bucket (TRANSLATION_NONE ends the list).
+    page_next: u32,
+    /// First chained jump into this block (CHAIN_NONE: none).
+    incoming: u32,
+    /// Cleared when its page is invalidated (its code is dead until the next flush).
+    live: bool,
+};
+
+/// Exit stub waiting for its target block (patched to a direct jump once translated).
+const Link = struct {
+    /// Arena offset of exit stub.
+    stub: u32,
+    /// Guest PC the stub resumes at.
+    target_pc: u64,
+    /// Translation owning the stub.
+    source: u32,
+};
+
+/// Exit stub patched into a jump to another block.
+const Chain = struct {
+    /// Arena offset of exit stub.
+    stub: u32,
+    /// Translation owning the stub.
+    source: u32,
+    /// Next chained jump into the same target (CHAIN_NONE ends the list).
+    next: u32,
+};
+
+/// Native translator (x86-64 Linux).
+pub const NativeJit = struct {
+    /// Executable arena (RX while running, RW only while emitting).
+    arena: []align(std.heap.page_size_min) u8,
+    /// Bytes of arena in use (trampoline included).
+    used: usize = TRAMPOLINE_SIZE,
+    /// Block table (direct-mapped by PC).
+    blocks: [BLOCK_TABLE_SIZE]Block = [_]Block{.{}} ** BLOCK_TABLE_SIZE,
+    /// Translated blocks since the last flush, in arena order.
+    translations: [MAX_TRANSLATIONS]Translation = undefined,
+    translation_count: u32 = 0,
+    /// First translation per page bucket, linked through Translation.page_next.
+    page_heads: [PAGE_BUCKETS]u32 = [_]u32{TRANSLATION_NONE} ** PAGE_BUCKETS,
+    /// Patched exits, linked from their target's Translation.incoming.
+    chains: [MAX_CHAINS]Chain = undefined,
+    chain_count: u32 = 0,
+    /// Unpatched chainable exits.
+    links: [MAX_LINKS]Link = undefined,
+    link_count: usize = 0,
+    /// Set if arena protection could not be changed; translation stops for good.
+    disabled: bool = false,
+    /// Blocks translated (diagnostics).
+    blocks_translated: u64 = 0,
+    /// Blocks dropped by page invalidation (diagnostics).
+    blocks_invalidated: u64 = 0,
+    /// Arena flushes (host writes, arena or tables full).
+    flushes: u64 = 0,
+
+    const Self = @This();
+
+    /// Map arena and emit trampoline.
+    /// Errors: Out of memory, or mmap/mprotect refused by the host.
+    pub fn create() !*Self {
+        const self = try std.heap.page_allocator.create(Self);
+        errdefer std.heap.page_allocator.destroy(self);
+
+        const arena = try std.posix.mmap(
+            null,
+            ARENA_SIZE,
+            std.posix.PROT.READ | std.posix.PROT.WRITE,
+            .{ .TYPE = .PRIVATE, .ANONYMOUS = true },
+            -1,
+            0,
+        );
+        errdefer std.posix.munmap(arena);
+
+        self.* = .{ .arena = arena };
+        @memcpy(arena[0..PROLOGUE.len], &PROLOGUE);
+        @memcpy(arena[EPILOGUE_OFFSET..][0..EPILOGUE.len], &EPILOGUE);
+        try std.posix.mprotect(arena, std.posix.PROT.READ | std.posix.PROT.EXEC);
+
+        // Assert: trampoline must fit before the first block.
+        std.debug.assert(EPILOGUE_OFFSET + EPILOGUE.len <= TRAMPOLINE_SIZE);
+        return self;
+    }
+
+    /// Unmap arena and free translator.
+    pub fn destroy(self: *Self) void {
+        std.posix.munmap(self.arena);
+        std.heap.page_allocator.destroy(self);
+    }
+
+    /// Drop every translated block and reclaim the arena.
+    /// Why: Host writes bypass code-page tracking; a full arena or table starts over.
+    pub fn flush(self: *Self) void {
+        self.used = TRAMPOLINE_SIZE;
+        @memset(&self.blocks, Block{});
+        @memset(&self.page_heads, TRANSLATION_NONE);
+        self.translation_count = 0;
+        self.chain_count = 0;
+        self.link_count = 0;
+        self.flushes += 1;
+
+        // Assert: arena must be empty except for the trampoline.
+        std.debug.assert(self.used == TRAMPOLINE_SIZE);
+    }
+
+    /// Drop the translated blocks of one guest page and unchain every jump into them.
+    /// Why: A store into a code page must not run stale code, but blocks on other pages
+    /// (and their chains to each other) stay valid; only jumps into this page turn back
+    /// into exits, which re-chain once the page is translated again.
+    /// Contract: No translated code is running (guest stores into code pages leave
+    /// translated code before they happen). The arena space is reclaimed by the next flush.
+    pub fn invalidate_page(self: *Self, page: u64) void {
+        var writable = false;
+        var next: *u32 = &self.page_heads[page_bucket(page)];
+        while (next.* != TRANSLATION_NONE) {
+            const id = next.*;
+            const translation = &self.translations[id];
+            std.debug.assert(translation.live);
+            if (translation.pc >> vm_module.PAGE_SHIFT != page) {
+                next = &translation.page_next;
+                continue;
+            }
+            next.* = translation.page_next;
+            translation.live = false;
+            self.blocks_invalidated += 1;
+
+            const slot = &self.blocks[block_index(translation.pc)];
+            if (slot.pc == translation.pc and slot.translation == id) slot.* = .{};
+
+            // Jumps from live blocks become exits again and wait for a new translation.
+            var incoming = translation.incoming;
+            while (incoming != CHAIN_NONE) : (incoming = self.chains[incoming].next) {
+                const jump = self.chains[incoming];
+                if (!self.translations[jump.source].live) continue;
+                if (!writable) {
+                    std.posix.mprotect(self.arena, std.posix.PROT.READ | std.posix.PROT.WRITE) catch {
+                        // Stale jumps remain: never enter translated code again.
+                        self.disabled = true;
+                        return;
+                    };
+                    writable = true;
+                }
+                var emitter = Emitter{ .code = self.arena, .pos = jump.stub };
+                emitter.store_pc_imm32(translation.pc);
+                if (self.link_count < MAX_LINKS) {
+                    self.links[self.link_count] = .{ .stub = jump.stub, .target_pc = translation.pc, .source = jump.source };
+                    self.link_count += 1;
+                }
+            }
+            translation.incoming = CHAIN_NONE;
+        }
+        if (writable) {
+            std.posix.mprotect(self.arena, std.posix.PROT.READ | std.posix.PROT.EXEC) catch {
+                self.disabled = true;
+            };
+        }
+    }
+
+    /// Run translated code from vm.regs.pc for at most limit instructions.
+    /// Contract: limit > 0; VM must be running.
+    /// Returns: Instructions retired (0 if PC is not hot yet, untranslatable, or the
+    /// block is longer than limit); the interpreter runs the next instruction either way.
+    pub fn execute(self: *Self, vm: *VM, limit: u64) u64 {
+        std.debug.assert(limit > 0);
+        std.debug.assert(vm.state == .running);
+
+        if (self.disabled) return 0;
+
+        const pc = vm.regs.pc;
+        const index = block_index(pc);
+        if (self.blocks[index].pc != pc) {
+            self.blocks[index] = .{ .pc = pc };
+        }
+
+        if (self.blocks[index].translation == TRANSLATION_NONE) {
+            self.blocks[index].hits += 1;
+            if (self.blocks[index].hits < HOT_THRESHOLD) return 0;
+
+            const translation = self.translate(vm, pc) catch {
+                self.disabled = true;
+                return 0;
+            };
+            // Translation may have flushed the table; (re)claim this slot.
+            self.blocks[index] = .{ .pc = pc, .translation = translation, .hits = HOT_THRESHOLD };
+        }
+
+        const translation = self.blocks[index].translation;
+        if (translation == TRANSLATION_UNTRANSLATABLE) return 0;
+        const entry = self.translations[translation].entry;
+
+        // Assert: the table only holds live translations.
+        std.debug.assert(self.translations[translation].live);
+
+        // Assert: guest PCs must fit the imm32 PC stores of exit stubs.
+        std.debug.assert(vm.memory_size <= MAX_MEMORY_SIZE);
+
+        const trampoline: Trampoline = @ptrCast(self.arena.ptr);
+        const remaining = trampoline(vm, limit, self.arena.ptr + entry, vm.memory.ptr);
+
+        // Assert: translated code never spends more than its budget or changes run state.
+        std.debug.assert(remaining <= limit);
+        std.debug.assert(vm.state == .running);
+        return limit - remaining;
+    }
+
+    /// Block table slot for PC.
+    fn block_index(pc: u64) usize {
+        return @as(usize, @truncate(pc >> 2)) & (BLOCK_TABLE_SIZE - 1);
+    }
+
+    /// Page index bucket for a guest page number.
+    fn page_bucket(page: u64) usize {
+        return @as(usize, @truncate(page)) & (PAGE_BUCKETS - 1);
+    }
+
+    /// Translate block starting at pc (arena writable only for the duration).
+    /// Returns: Index of its translation, or TRANSLATION_UNTRANSLATABLE.
+    fn translate(self: *Self, vm: *VM, pc: u64) !u32 {
+        if (ARENA_SIZE - self.used < MAX_BLOCK_BYTES or self.translation_count == MAX_TRANSLATIONS) {
+            self.flush();
+        }
+
+        try std.posix.mprotect(self.arena, std.posix.PROT.READ | std.posix.PROT.WRITE);
+        const entry = self.emit_block(vm, pc);
+        try std.posix.mprotect(self.arena, std.posix.PROT.READ | std.posix.PROT.EXEC);
+        return entry;
+    }
+
+    /// Emit block, index it by page, register its chain links, and mark its page as code.
+    fn emit_block(self: *Self, vm: *VM, pc: u64) u32 {
+        const start = self.used;
+        var compiler = Compiler{
+            .emitter = .{ .code = self.arena, .pos = start },
+            .memory_size = vm.memory_size,
+        };
+        const length = compiler.compile(vm, pc);
+        if (length == 0) {
+            return TRANSLATION_UNTRANSLATABLE;
+        }
+
+        // Assert: block must stay within its reserved space.
+        std.debug.assert(compiler.emitter.pos - start <= MAX_BLOCK_BYTES);
+        std.debug.assert(self.translation_count < MAX_TRANSLATIONS);
+        self.used = compiler.emitter.pos;
+        self.blocks_translated += 1;
+
+        // Index the block by page so a store into the page drops just its blocks.
+        const id = self.translation_count;
+        const bucket = page_bucket(pc >> vm_module.PAGE_SHIFT);
+        self.translations[id] = .{
+            .pc = pc,
+            .entry = @intCast(start),
+            .page_next = self.page_heads[bucket],
+            .incoming = CHAIN_NONE,
+            .live = true,
+        };
+        self.page_heads[bucket] = id;
+        self.translation_count += 1;
+
+        // Stores into this page must leave translated code (and invalidate it).
+        vm.code_pages.set(@intCast(pc >> vm_module.PAGE_SHIFT));
+
+        // Chain earlier exits that were waiting for this block (stubs of dead blocks are dropped).
+        var link_index: usize = 0;
+        while (link_index < self.link_count) {
+            const link = self.links[link_index];
+            const dead = !self.translations[link.source].live;
+            if (dead or link.target_pc == pc) {
+                if (!dead) self.chain(link.stub, link.source, id);
+                self.link_count -= 1;
+                self.links[link_index] = self.links[self.link_count];
+            } else {
+                link_index += 1;
+            }
+        }
+
+        // Chain this block's exits to translated targets (itself included), or wait.
+        for (compiler.exits[0..compiler.exit_count]) |exit| {
+            if (!exit.chain) continue;
+            const target: ?u32 = if (exit.pc == pc) id else self.lookup(exit.pc);
+            if (target) |target_id| {
+                self.chain(exit.stub, id, target_id);
+            } else if (self.link_count < MAX_LINKS) {
+                self.links[self.link_count] = .{ .stub = exit.stub, .target_pc = exit.pc, .source = id };
+                self.link_count += 1;
+            }
+        }
+        return id;
+    }
+
+    /// Translation for PC in the block table, if any.
+    fn lookup(self: *const Self, pc: u64) ?u32 {
+        const block = &self.blocks[block_index(pc)];
+        if (block.pc != pc or block.translation == TRANSLATION_NONE or block.translation == TRANSLATION_UNTRANSLATABLE) return null;
+        return block.translation;
+    }
+
+    /// Whether a live translated block starts at pc (diagnostics and tests).
+    pub fn translated(self: *const Self, pc: u64) bool {
+        return self.lookup(pc) != null;
+    }
+
+    /// Patch stub (owned by source) into a jump to target and record it for unchaining.
+    /// Note: With the chain table full the stub stays an exit (slower, still correct).
+    fn chain(self: *Self, stub: u32, source: u32, target: u32) void {
+        if (self.chain_count == MAX_CHAINS) return;
+        const translation = &self.translations[target];
+        std.debug.assert(translation.live);
+        self.patch_jump(stub, translation.entry);
+        self.chains[self.chain_count] = .{ .stub = stub, .source = source, .next = translation.incoming };
+        translation.incoming = self.chain_count;
+        self.chain_count += 1;
+    }
+
+    /// Overwrite exit stub with `jmp target` (stub starts with an 11-byte PC store).
+    fn patch_jump(self: *Self, stub: u32, target: u32) void {
+        self.arena[stub] = 0xE9;
+        const rel = @as(i64, target) - @as(i64, stub + 5);
+        std.mem.writeInt(i32, self.arena[stub + 1 ..][0..4], @intCast(rel), .little);
+    }
+};
+
+/// Translator stub for hosts without a native backend.
+pub const UnsupportedJit = struct {
+    const Self = @This();
+
+    pub fn create() !*Self {
+        return error.JitUnsupported;
+    }
+
+    pub fn destroy(self: *Self) void {
+        _ = self;
+    }
+
+    pub fn flush(self: *Self) void {
+        _ = self;
+    }
+
+    pub fn invalidate_page(self: *Self, page: u64) void {
+        _ = self;
+        _ = page;
+    }
+
+    pub fn execute(self: *Self, vm: *VM, limit: u64) u64 {
+        _ = self;
+        _ = vm;
+        _ = limit;
+        return 0;
+    }
+};
+
+/// x86-64 scratch registers used by translated code.
+const Reg = enum(u3) { rax = 0, rcx = 1, rdx = 2 };
+
+/// Condition codes (low nibble of Jcc 0x0F 0x8x).
+const Cond = enum(u4) { b = 0x2, ae = 0x3, e = 0x4, ne = 0x5, a = 0x7, l = 0xC, ge = 0xD };
+
+/// Machine code writer (raw x86-64 encodings, verified against GNU as).
+const Emitter = struct {
+    code: []u8,
+    pos: usize,
+
+    fn bytes(self: *Emitter, values: []const u8) void {
+        @memcpy(self.code[self.pos..][0..values.len], values);
+        self.pos += values.len;
+    }
+
+    fn int32(self: *Emitter, value: i32) void {
+        std.mem.writeInt(i32, self.code[self.pos..][0..4], value, .little);
+        self.pos += 4;
+    }
+
+    fn int64(self: *Emitter, value: u64) void {
+        std.mem.writeInt(u64, self.code[self.pos..][0..8], value, .little);
+        self.pos += 8;
+    }
+
+    /// Point rel32 field at `at` to target (both arena offsets).
+    fn patch_rel32(self: *Emitter, at: usize, target: usize) void {
+        const rel = @as(i64, @intCast(target)) - @as(i64, @intCast(at + 4));
+        std.mem.writeInt(i32, self.code[at..][0..4], @intCast(rel), .little);
+    }
+
+    /// reg = guest register (x0 reads as zero).
+    fn load_guest(self: *Emitter, reg: Reg, guest: u5) void {
+        const r: u8 = @intFromEnum(reg);
+        if (guest == 0) {
+            self.bytes(&.{ 0x31, 0xC0 | (r << 3) | r }); // xor r32, r32
+            return;
+        }
+        self.bytes(&.{ 0x48, 0x8B, 0x83 | (r << 3) }); // mov reg, [rbx + disp32]
+        self.int32(REGS_OFFSET + 8 * @as(i32, guest));
+    }
+
+    /// guest register = reg (x0 writes are dropped).
+    fn store_guest(self: *Emitter, guest: u5, reg: Reg) void {
+        if (guest == 0) return;
+        const r: u8 = @intFromEnum(reg);
+        self.bytes(&.{ 0x48, 0x89, 0x83 | (r << 3) }); // mov [rbx + disp32], reg
+        self.int32(REGS_OFFSET + 8 * @as(i32, guest));
+    }
+
+    /// reg = imm64.
+    fn mov_imm64(self: *Emitter, reg: Reg, value: u64) void {
+        self.bytes(&.{ 0x48, 0xB8 + @as(u8, @intFromEnum(reg)) });
+        self.int64(value);
+    }
+
+    /// rax = rax <op> rcx (op: 0x01 add, 0x29 sub, 0x31 xor, 0x09 or, 0x21 and, 0x39 cmp).
+    fn alu_rax_rcx(self: *Emitter, op: u8) void {
+        self.bytes(&.{ 0x48, op, 0xC8 });
+    }
+
+    /// rax = rax <op> imm32 (op: 0x05 add, 0x0D or, 0x25 and, 0x35 xor; imm sign-extended).
+    fn alu_rax_imm32(self: *Emitter, op: u8, value: i32) void {
+        self.bytes(&.{ 0x48, op });
+        self.int32(value);
+    }
+
+    /// Shift rax by cl (ext: 0xE0 shl, 0xE8 shr, 0xF8 sar; count masked to 6 bits like RV64).
+    fn shift_rax_cl(self: *Emitter, ext: u8) void {
+        self.bytes(&.{ 0x48, 0xD3, ext });
+    }
+
+    /// jcc rel32 placeholder; returns offset of rel32 field.
+    fn jcc(self: *Emitter, cond: Cond) usize {
+        self.bytes(&.{ 0x0F, 0x80 | @as(u8, @intFromEnum(cond)) });
+        const at = self.pos;
+        self.int32(0);
+        return at;
+    }
+
+    /// jmp rel32 placeholder; returns offset of rel32 field.
+    fn jmp(self: *Emitter) usize {
+        self.bytes(&.{0xE9});
+        const at = self.pos;
+        self.int32(0);
+        return at;
+    }
+
+    /// r13 (remaining budget) <op> imm32 (ext: 0xC5 add, 0xED sub, 0xFD cmp).
+    fn budget_imm32(self: *Emitter, ext: u8, value: i32) usize {
+        self.bytes(&.{ 0x49, 0x81, ext });
+        const at = self.pos;
+        self.int32(value);
+        return at;
+    }
+
+    /// Guest PC = imm32 (11 bytes; exit stubs rely on this length for chain patching).
+    fn store_pc_imm32(self: *Emitter, pc: u64) void {
+        self.bytes(&.{ 0x48, 0xC7, 0x83 });
+        self.int32(PC_OFFSET);
+        self.int32(@intCast(pc));
+    }
+
+    /// Guest PC = rax.
+    fn store_pc_rax(self: *Emitter) void {
+        self.bytes(&.{ 0x48, 0x89, 0x83 });
+        self.int32(PC_OFFSET);
+    }
+
+    /// rdx = vm.memory_size - size; cmp rax, rdx (ja => access out of bounds).
+    fn cmp_bounds(self: *Emitter, size: u8) void {
+        self.bytes(&.{ 0x48, 0x8B, 0x93 }); // mov rdx, [rbx + memory_size]
+        self.int32(MEMORY_SIZE_OFFSET);
+        self.bytes(&.{ 0x48, 0x83, 0xEA, size }); // sub rdx, size
+        self.bytes(&.{ 0x48, 0x39, 0xD0 }); // cmp rax, rdx
+    }
+
+    /// Test page of rax in VM.code_pages (carry set => page holds decoded/translated code).
+    /// Clobbers rcx and rdx.
+    fn test_code_page(self: *Emitter) void {
+        self.bytes(&.{ 0x48, 0x89, 0xC2 }); // mov rdx, rax
+        self.bytes(&.{ 0x48, 0xC1, 0xEA, vm_module.PAGE_SHIFT }); // shr rdx, PAGE_SHIFT
+        self.bytes(&.{ 0x48, 0x8B, 0x8B }); // mov rcx, [rbx + code_pages.masks]
+        self.int32(CODE_PAGES_MASKS_OFFSET);
+        self.bytes(&.{ 0x48, 0x0F, 0xA3, 0x11 }); // bt [rcx], rdx
+    }
+
+    /// Set page rdx (from test_code_page) in VM.dirty_pages. Clobbers rcx.
+    fn mark_dirty_page(self: *Emitter) void {
+        self.bytes(&.{ 0x48, 0x8B, 0x8B }); // mov rcx, [rbx + dirty_pages.masks]
+        self.int32(DIRTY_PAGES_MASKS_OFFSET);
+        self.bytes(&.{ 0x48, 0x0F, 0xAB, 0x11 }); // bts [rcx], rdx
+    }
+
+    /// Access [r12 + rax] (guest RAM) with opcode (REX.B included) and rcx as the register operand.
+    fn memory_access(self: *Emitter, opcode: []const u8) void {
+        self.bytes(opcode);
+        self.bytes(&.{ 0x0C, 0x04 }); // modrm rcx, sib [r12 + rax]
+    }
+};
+
+/// Exit stub of the block being compiled.
+const Exit = struct {
+    /// Guest PC to resume at.
+    pc: u64,
+    /// Side exit before instruction `index` (budget for it and later ones is refunded).
+    side_index: ?u32 = null,
+    /// Whether the stub may be patched into a direct jump to the target block.
+    chain: bool = false,
+    /// Arena offset of stub (set when stubs are emitted).
+    stub: u32 = 0,
+};
+
+/// Jump into an exit stub (rel32 patched once stubs are placed).
+const Fixup = struct {
+    at: u32,
+    exit: u8,
+};
+
+/// Translation outcome for one instruction.
+const Step = enum {
+    /// Translated; block continues.
+    next,
+    /// Translated; instruction ends the block (branch, jump).
+    end,
+    /// Not translated; block ends before it and the interpreter runs it.
+    stop,
+};
+
+/// Memory access flavour (opcode, size, interpreter checks to mirror).
+const Access = struct {
+    opcode: []const u8,
+    size: u8,
+    /// Alignment mask checked by the interpreter (faults => side exit).
+    align_mask: u8 = 0,
+    /// Interpreter rounds the address down to 8 bytes (LD/SD).
+    force_align: bool = false,
+    /// Interpreter retries x8 == 0 accesses with sp (side exit when x8 == 0).
+    stack_fallback: bool = false,
+};
+
+/// Per-block compiler state.
+const Compiler = struct {
+    emitter: Emitter,
+    memory_size: usize,
+    exits: [MAX_EXITS]Exit = undefined,
+    exit_count: usize = 0,
+    fixups: [MAX_FIXUPS]Fixup = undefined,
+    fixup_count: usize = 0,
+    /// Side exit of the instruction being translated (shared by all its checks).
+    side_exit: ?u8 = null,
+
+    /// Compile block at pc into emitter.
+    /// Returns: Guest instructions in block (0 => nothing usable, emitter rewound).
+    fn compile(self: *Compiler, vm: *const VM, pc: u64) u32 {
+        const start = self.emitter.pos;
+
+        // Prelude: leave (PC unchanged) if the budget cannot cover the whole block.
+        const length_cmp = self.emitter.budget_imm32(0xFD, 0); // cmp r13, length
+        self.jump_exit(self.emitter.jcc(.b), self.add_exit(.{ .pc = pc }));
+        const length_sub = self.emitter.budget_imm32(0xED, 0); // sub r13, length
+
+        var length: u32 = 0;
+        var terminated = false;
+        while (length < MAX_BLOCK_INSTRUCTIONS) {
+            const inst_pc = pc + 4 * @as(u64, length);
+            // Blocks stay within one page (page invalidation covers whole blocks).
+            if (length > 0 and inst_pc % vm_module.PAGE_SIZE == 0) break;
+            // Misaligned or out-of-range fetches fault in the interpreter.
+            if (inst_pc % 4 != 0 or inst_pc + 4 > self.memory_size) break;
+
+            const inst = std.mem.readInt(u32, vm.memory[@intCast(inst_pc)..][0..4], .little);
+            const decoded = VM.decode(inst);
+            self.side_exit = null;
+            switch (self.translate(&decoded, inst_pc, length)) {
+                .next => length += 1,
+                .end => {
+                    length += 1;
+                    terminated = true;
+                    break;
+                },
+                .stop => break,
+            }
+        }
+
+        if (length == 0) {
+            self.emitter.pos = start;
+            return 0;
+        }
+
+        // Fall through to the next (untranslated) instruction.
+        if (!terminated) {
+            self.jump_exit(self.emitter.jmp(), self.add_exit(.{ .pc = pc + 4 * @as(u64, length), .chain = true }));
+        }
+
+        std.mem.writeInt(i32, self.emitter.code[length_cmp..][0..4], @intCast(length), .little);
+        std.mem.writeInt(i32, self.emitter.code[length_sub..][0..4], @intCast(length), .little);
+        self.emit_exits(length);
+        return length;
+    }
+
+    /// Translate one instruction (see Step).
+    fn translate(self: *Compiler, d: *const VM.Decoded, pc: u64, index: u32) Step {
+        const e = &self.emitter;
+        switch (VM.op_of(d)) {
+            .nop => {},
+            .invalid, .system, .csr, .amo_w, .amo_d, .fence, .fence_i => return .stop,
+            .lui => {
+                e.mov_imm64(.rax, @bitCast(d.imm));
+                e.store_guest(d.rd, .rax);
+            },
+            .auipc => {
+                e.mov_imm64(.rax, pc +% @as(u64, @bitCast(d.imm)));
+                e.store_guest(d.rd, .rax);
+            },
+            .addi => self.alu_imm(d, 0x05),
+            .xori => self.alu_imm(d, 0x35),
+            .ori => self.alu_imm(d, 0x0D),
+            .andi => self.alu_imm(d, 0x25),
+            .slli => {
+                e.load_guest(.rax, d.rs1);
+                e.bytes(&.{ 0x48, 0xC1, 0xE0, @as(u8, @intCast(d.imm & 0x3F)) }); // shl rax, imm8
+                e.store_guest(d.rd, .rax);
+            },
+            .add => self.alu_reg(d, 0x01),
+            .sub => self.alu_reg(d, 0x29),
+            .xor => self.alu_reg(d, 0x31),
+            .@"or" => self.alu_reg(d, 0x09),
+            .@"and" => self.alu_reg(d, 0x21),
+            .slt => {
+                e.load_guest(.rax, d.rs1);
+                e.load_guest(.rcx, d.rs2);
+                e.alu_rax_rcx(0x39); // cmp rax, rcx
+                e.bytes(&.{ 0x0F, 0x9C, 0xC0, 0x0F, 0xB6, 0xC0 }); // setl al; movzx eax, al
+                e.store_guest(d.rd, .rax);
+            },
+            .sll => self.shift_reg(d, 0xE0),
+            .srl => self.shift_reg(d, 0xE8),
+            .sra => self.shift_reg(d, 0xF8),
+            .lb => self.load(d, pc, index, .{ .opcode = &.{ 0x49, 0x0F, 0xBE }, .size = 1 }),
+            .lbu => self.load(d, pc, index, .{ .opcode = &.{ 0x41, 0x0F, 0xB6 }, .size = 1 }),
+            .lh => self.load(d, pc, index, .{ .opcode = &.{ 0x49, 0x0F, 0xBF }, .size = 2, .align_mask = 1 }),
+            .lhu => self.load(d, pc, index, .{ .opcode = &.{ 0x41, 0x0F, 0xB7 }, .size = 2, .align_mask = 1 }),
+            .lw => self.load(d, pc, index, .{ .opcode = &.{ 0x49, 0x63 }, .size = 4, .align_mask = 3, .stack_fallback = true }),
+            .lwu => self.load(d, pc, index, .{ .opcode = &.{ 0x41, 0x8B }, .size = 4, .align_mask = 3 }),
+            .ld => self.load(d, pc, index, .{ .opcode = &.{ 0x49, 0x8B }, .size = 8, .force_align = true, .stack_fallback = true }),
+            .sb => self.store(d, pc, index, .{ .opcode = &.{ 0x41, 0x88 }, .size = 1, .stack_fallback = true }),
+            .sh => self.store(d, pc, index, .{ .opcode = &.{ 0x66, 0x41, 0x89 }, .size = 2, .align_mask = 1 }),
+            .sw => self.store(d, pc, index, .{ .opcode = &.{ 0x41, 0x89 }, .size = 4, .align_mask = 3 }),
+            .sd => self.store(d, pc, index, .{ .opcode = &.{ 0x49, 0x89 }, .size = 8, .force_align = true, .stack_fallback = true }),
+            .beq => return self.branch(d, pc, .e, true),
+            .bne => return self.branch(d, pc, .ne, false),
+            .blt => return self.branch(d, pc, .l, false),
+            .bge => return self.branch(d, pc, .ge, false),
+            .bltu => return self.branch(d, pc, .b, true),
+            .bgeu => return self.branch(d, pc, .ae, false),
+            .jal => return self.jal(d, pc),
+            .jalr => return self.jalr(d, pc, index),
+        }
+        return .next;
+    }
+
+    /// rd = rs1 <op> imm (I-type immediates are -2048..2047; imm32 sign extension matches RISC-V).
+    fn alu_imm(self: *Compiler, d: *const VM.Decoded, op: u8) void {
+        self.emitter.load_guest(.rax, d.rs1);
+        self.emitter.alu_rax_imm32(op, @intCast(d.imm));
+        self.emitter.store_guest(d.rd, .rax);
+    }
+
+    /// rd = rs1 <op> rs2.
+    fn alu_reg(self: *Compiler, d: *const VM.Decoded, op: u8) void {
+        self.emitter.load_guest(.rax, d.rs1);
+        self.emitter.load_guest(.rcx, d.rs2);
+        self.emitter.alu_rax_rcx(op);
+        self.emitter.store_guest(d.rd, .rax);
+    }
+
+    /// rd = rs1 <shift> (rs2 & 63).
+    fn shift_reg(self: *Compiler, d: *const VM.Decoded, ext: u8) void {
+        self.emitter.load_guest(.rax, d.rs1);
+        self.emitter.load_guest(.rcx, d.rs2);
+        self.emitter.shift_rax_cl(ext);
+        self.emitter.store_guest(d.rd, .rax);
+    }
+
+    /// rax = effective address, side-exiting wherever the interpreter would fault or fall back.
+    fn address(self: *Compiler, d: *const VM.Decoded, pc: u64, index: u32, kind: Access) void {
+        const e = &self.emitter;
+        e.load_guest(.rax, d.rs1);
+        if (kind.stack_fallback and d.rs1 == 8) {
+            e.bytes(&.{ 0x48, 0x85, 0xC0 }); // test rax, rax
+            self.jump_exit(e.jcc(.e), self.side(pc, index));
+        }
+        if (d.imm != 0) {
+            e.alu_rax_imm32(0x05, @intCast(d.imm)); // add rax, imm32
+        }
+        if (kind.force_align) {
+            e.bytes(&.{ 0x48, 0x83, 0xE0, 0xF8 }); // and rax, -8
+        }
+        if (kind.align_mask != 0) {
+            e.bytes(&.{ 0xA8, kind.align_mask }); // test al, mask
+            self.jump_exit(e.jcc(.ne), self.side(pc, index));
+        }
+        e.cmp_bounds(kind.size);
+        self.jump_exit(e.jcc(.a), self.side(pc, index));
+    }
+
+    fn load(self: *Compiler, d: *const VM.Decoded, pc: u64, index: u32, kind: Access) void {
+        self.address(d, pc, index, kind);
+        self.emitter.memory_access(kind.opcode); // rcx = [memory + rax]
+        self.emitter.store_guest(d.rd, .rcx);
+    }
+
+    fn store(self: *Compiler, d: *const VM.Decoded, pc: u64, index: u32, kind: Access) void {
+        self.address(d, pc, index, kind);
+        // Code page: let the interpreter store and invalidate (this block included).
+        self.emitter.test_code_page();
+        self.jump_exit(self.emitter.jcc(.b), self.side(pc, index));
+        self.emitter.mark_dirty_page(); // snapshot restore copies this page back
+        self.emitter.load_guest(.rcx, d.rs2);
+        self.emitter.memory_access(kind.opcode); // [memory + rax] = rcx
+    }
+
+    /// Conditional branch (target is static; rejected targets stay with the interpreter).
+    /// Note: BEQ/BLTU round misaligned targets down; the others fault on them.
+    fn branch(self: *Compiler, d: *const VM.Decoded, pc: u64, taken: Cond, round_target: bool) Step {
+        const raw = pc +% @as(u64, @bitCast(d.imm));
+        if (!round_target and raw % 4 != 0) return .stop;
+        const target = raw & ~@as(u64, 3);
+        if (target >= self.memory_size) return .stop;
+
+        const e = &self.emitter;
+        e.load_guest(.rax, d.rs1);
+        e.load_guest(.rcx, d.rs2);
+        e.alu_rax_rcx(0x39); // cmp rax, rcx
+        self.jump_exit(e.jcc(taken), self.add_exit(.{ .pc = resume_pc(pc, target), .chain = true }));
+        self.jump_exit(e.jmp(), self.add_exit(.{ .pc = pc + 4, .chain = true }));
+        return .end;
+    }
+
+    fn jal(self: *Compiler, d: *const VM.Decoded, pc: u64) Step {
+        const target = (pc +% @as(u64, @bitCast(d.imm))) & ~@as(u64, 3);
+        if (target >= self.memory_size) return .stop;
+
+        const e = &self.emitter;
+        e.mov_imm64(.rax, pc + 4);
+        e.store_guest(d.rd, .rax);
+        self.jump_exit(e.jmp(), self.add_exit(.{ .pc = resume_pc(pc, target), .chain = true }));
+        return .end;
+    }
+
+    /// Indirect jump: PC computed at run time, so it always returns to the dispatcher.
+    fn jalr(self: *Compiler, d: *const VM.Decoded, pc: u64, index: u32) Step {
+        const e = &self.emitter;
+        e.load_guest(.rax, d.rs1);
+        e.alu_rax_imm32(0x05, @intCast(d.imm)); // add rax, imm32
+        e.bytes(&.{ 0x48, 0x83, 0xE0, 0xFC }); // and rax, -4
+        e.bytes(&.{ 0x48, 0x3B, 0x83 }); // cmp rax, [rbx + memory_size]
+        e.int32(MEMORY_SIZE_OFFSET);
+        self.jump_exit(e.jcc(.ae), self.side(pc, index));
+        // Jump to itself: interpreter sees PC unchanged and advances by 4.
+        e.mov_imm64(.rcx, pc);
+        e.alu_rax_rcx(0x39); // cmp rax, rcx
+        e.bytes(&.{ 0x75, 0x04, 0x48, 0x83, 0xC0, 0x04 }); // jne +4; add rax, 4
+        if (d.rd != 0) {
+            e.mov_imm64(.rcx, pc + 4);
+            e.store_guest(d.rd, .rcx);
+        }
+        e.store_pc_rax();
+        e.patch_rel32(e.jmp(), EPILOGUE_OFFSET);
+        return .end;
+    }
+
+    /// PC after a taken control transfer (interpreter adds 4 when PC did not change).
+    fn resume_pc(pc: u64, target: u64) u64 {
+        return if (target == pc) pc + 4 else target;
+    }
+
+    /// Side exit for instruction index (one stub per instruction).
+    fn side(self: *Compiler, pc: u64, index: u32) u8 {
+        if (self.side_exit) |exit| return exit;
+        const exit = self.add_exit(.{ .pc = pc, .side_index = index });
+        self.side_exit = exit;
+        return exit;
+    }
+
+    fn add_exit(self: *Compiler, exit: Exit) u8 {
+        std.debug.assert(self.exit_count < MAX_EXITS);
+        self.exits[self.exit_count] = exit;
+        self.exit_count += 1;
+        return @intCast(self.exit_count - 1);
+    }
+
+    fn jump_exit(self: *Compiler, at: usize, exit: u8) void {
+        std.debug.assert(self.fixup_count < MAX_FIXUPS);
+        self.fixups[self.fixup_count] = .{ .at = @intCast(at), .exit = exit };
+        self.fixup_count += 1;
+    }
+
+    /// Emit exit stubs after the block body and resolve jumps into them.
+    /// Stub: [add r13, refund;] mov [pc], imm32; jmp epilogue.
+    fn emit_exits(self: *Compiler, length: u32) void {
+        const e = &self.emitter;
+        for (self.exits[0..self.exit_count]) |*exit| {
+            exit.stub = @intCast(e.pos);
+            if (exit.side_index) |index| {
+                std.debug.assert(index < length);
+                _ = e.budget_imm32(0xC5, @intCast(length - index)); // add r13, refund
+            }
+            e.store_pc_imm32(exit.pc);
+            e.patch_rel32(e.jmp(), EPILOGUE_OFFSET);
+
+            // Assert: chainable stubs start with the PC store (patched into a jmp).
+            std.debug.assert(!exit.chain or exit.side_index == null);
+        }
+        for (self.fixups[0..self.fixup_count]) |fixup| {
+            e.patch_rel32(fixup.at, self.exits[fixup.exit].stub);
+        }
+    }
+};
@@ -4,8 +4,24 @@
 
 pub const VM = @import("vm.zig").VM;
 pub const loadKernel = @import("loader.zig").loadKernel;
+pub const loadKernelWithOptions = @import("loader.zig").loadKernelWithOptions;
+pub const loadImage = @import("loader.zig").loadImage;
+pub const Image = @import("loader.zig").Image;
+pub const ImageCache = @import("image_cache.zig").ImageCache;
+pub const loadSymbols = @import("loader.zig").loadSymbols;
+pub const SymbolTable = @import("loader.zig").SymbolTable;
 pub const SerialOutput = @import("serial.zig").SerialOutput;
+pub const trace = @import("trace.zig");
+pub const profile = @import("profile.zig");
+pub const jit = @import("jit.zig");
+pub const smp = @import("smp.zig");
+pub const mmu = @import("mmu.zig");
+pub const replay = @import("replay.zig");
+pub const virtio = @import("virtio.zig");
+pub const csr = @import("csr.zig");
 pub const handleSyscall = @import("syscall.zig").handleSyscall;
 pub const Integration = @import("integration.zig").Integration;
 pub const loadUserspaceELF = @import("integration.zig").loadUserspaceELF;
+pub const loadUserspaceImage = @import("integration.zig").loadUserspaceImage;
+pub const user_memory = @import("integration.zig").user_memory;
 
@@ -1,5 +1,6 @@
 const std = @import("std");
 const VM = @import("vm.zig").VM;
+const vm_memory = @import("memory.zig");
 
 /// RISC-V64 ELF kernel loader.
 /// Grain Style: Static allocation where possible, comprehensive assertions.
@@ -59,6 +60,52 @@ const Elf64_Phdr = extern struct {
     p_align: u64,
 };
 
+/// Section header structure (64-bit, little-endian).
+/// Why: Locates .symtab and its string table for profiler symbolization.
+const Elf64_Shdr = extern struct {
+    /// Section name (offset into the section name string table).
+    sh_name: u32,
+    /// Section type (2 = symbol table, 3 = string table).
+    sh_type: u32,
+    /// Section flags.
+    sh_flags: u64,
+    /// Section virtual address (0 if not loaded).
+    sh_addr: u64,
+    /// Section file offset.
+    sh_offset: u64,
+    /// Section size in file.
+    sh_size: u64,
+    /// Linked section index (symbol table: its string table).
+    sh_link: u32,
+    /// Extra section information.
+    sh_info: u32,
+    /// Section alignment.
+    sh_addralign: u64,
+    /// Entry size for table sections.
+    sh_entsize: u64,
+};
+
+/// Symbol table entry (64-bit, little-endian).
+const Elf64_Sym = extern struct {
+    /// Symbol name (offset into the linked string table).
+    st_name: u32,
+    /// Type (low nibble) and binding (high nibble).
+    st_info: u8,
+    /// Visibility.
+    st_other: u8,
+    /// Section index (0 = undefined).
+    st_shndx: u16,
+    /// Symbol value (address for functions and objects).
+    st_value: u64,
+    /// Symbol size in bytes (0 if unknown).
+    st_size: u64,
+};
+
+const SHT_SYMTAB: u32 = 2;
+const SHT_STRTAB: u32 = 3;
+const STT_NOTYPE: u8 = 0;
+const STT_FUNC: u8 = 2;
+
 /// ELF magic number: 0x7F "ELF".
 const ELF_MAGIC = [_]u8{ 0x7F, 'E', 'L', 'F' };
 
@@ -67,6 +114,156 @@ const ELF_MAGIC = [_]u8{ 0x7F, 'E', 'L', 'F' };
 pub const LoaderError = error{
     SegmentOutOfBounds,
     InvalidElfFormat,
+    GuestMemoryUnavailable,
+};
+
+/// Most PT_LOAD segments an Image records (more is rejected as InvalidElfFormat).
+pub const MAX_SEGMENTS: usize = 16;
+
+/// ELF program header flag: segment is writable.
+const PF_W: u32 = 2;
+
+/// One PT_LOAD segment of a validated Image.
+pub const Segment = struct {
+    vaddr: u64,
+    /// File offset of the segment's bytes.
+    offset: u64,
+    filesz: u64,
+    memsz: u64,
+    /// PF_* flags (PF_W clear: read-only, may be mapped copy-on-write).
+    flags: u32,
+
+    pub fn writable(self: Segment) bool {
+        return self.flags & PF_W != 0;
+    }
+};
+
+/// Pre-validated ELF executable: entry point and load segments, checked once.
+/// Why: Spawning the same binary again (z6 restarts, fuzz loops) only places segments;
+/// header and bounds checks ran when the Image was parsed.
+/// Contract: bytes outlive the Image (an ImageCache owns them for cached images).
+pub const Image = struct {
+    bytes: []const u8,
+    /// Entry point (a PIE entry of 0 is already rebased to the first segment).
+    entry: u64,
+    segments: [MAX_SEGMENTS]Segment = undefined,
+    segment_count: usize = 0,
+    /// End of the highest segment in guest memory (RAM must be at least this large).
+    end: u64 = 0,
+    /// Sealed file backing bytes at offset 0, for copy-on-write segment mapping (null: copy).
+    /// Contract: no one can write, shrink or grow it (ImageCache seals its memfds).
+    fd: ?std.posix.fd_t = null,
+
+    const Self = @This();
+
+    /// Validate an ELF executable for RISC-V64 and record its load segments.
+    /// Errors: InvalidElfFormat for a malformed, non-RV64 or non-executable ELF, or
+    /// more than MAX_SEGMENTS PT_LOAD segments.
+    pub fn parse(bytes: []const u8) LoaderError!Self {
+        if (bytes.len < @sizeOf(Elf64_Ehdr)) return error.InvalidElfFormat;
+        const ehdr = std.mem.bytesToValue(Elf64_Ehdr, bytes[0..@sizeOf(Elf64_Ehdr)]);
+
+        // Magic, 64-bit class, little-endian, version 1, RISC-V, executable.
+        if (!std.mem.eql(u8, ehdr.e_ident[0..4], &ELF_MAGIC)) return error.InvalidElfFormat;
+        if (ehdr.e_ident[4] != 2 or ehdr.e_ident[5] != 1 or ehdr.e_ident[6] != 1) return error.InvalidElfFormat;
+        if (ehdr.e_machine != 243 or ehdr.e_type != 2) return error.InvalidElfFormat;
+
+        // Program header table must be present and inside the file.
+        if (ehdr.e_phnum == 0 or ehdr.e_phoff == 0) return error.InvalidElfFormat;
+        const phdr_size = @as(u64, ehdr.e_phnum) * @sizeOf(Elf64_Phdr);
+        if (ehdr.e_phoff > bytes.len or phdr_size > bytes.len - ehdr.e_phoff) return error.InvalidElfFormat;
+
+        var image = Self{ .bytes = bytes, .entry = ehdr.e_entry };
+        var index: usize = 0;
+        while (index < ehdr.e_phnum) : (index += 1) {
+            const offset: usize = @intCast(ehdr.e_phoff + index * @sizeOf(Elf64_Phdr));
+            const phdr = std.mem.bytesToValue(Elf64_Phdr, bytes[offset..][0..@sizeOf(Elf64_Phdr)]);
+            if (phdr.p_type != 1) continue; // PT_LOAD only
+
+            // Segment bytes must be in the file; its guest range must not wrap.
+            if (phdr.p_offset > bytes.len or phdr.p_filesz > bytes.len - phdr.p_offset) return error.InvalidElfFormat;
+            const span = @max(phdr.p_filesz, phdr.p_memsz);
+            const end = std.math.add(u64, phdr.p_vaddr, span) catch return error.InvalidElfFormat;
+            if (image.segment_count == MAX_SEGMENTS) return error.InvalidElfFormat;
+
+            image.segments[image.segment_count] = .{
+                .vaddr = phdr.p_vaddr,
+                .offset = phdr.p_offset,
+                .filesz = phdr.p_filesz,
+                .memsz = phdr.p_memsz,
+                .flags = phdr.p_flags,
+            };
+            image.segment_count += 1;
+            image.end = @max(image.end, end);
+        }
+
+        // PIE executables may leave the entry at 0: start at the first load segment.
+        if (image.entry == 0 and image.segment_count > 0) image.entry = image.segments[0].vaddr;
+
+        // Assert: every recorded segment lies in the file.
+        for (image.loads()) |segment| {
+            std.debug.assert(segment.offset + segment.filesz <= bytes.len);
+        }
+        return image;
+    }
+
+    /// PT_LOAD segments in file order.
+    pub fn loads(self: *const Self) []const Segment {
+        return self.segments[0..self.segment_count];
+    }
+
+    /// Place every segment into target's RAM (zero-filled past filesz).
+    /// Why: Read-only segments of an fd-backed image are mapped copy-on-write where
+    /// whole host pages line up, so placing them costs page-table updates, not copies.
+    /// Guest stores into those pages fault in private copies; fd is sealed, so the
+    /// pages the guest has not stored to cannot change under it either.
+    /// Errors: SegmentOutOfBounds if a segment or the entry point is outside guest RAM.
+    /// Errors: GuestMemoryUnavailable if a copy-on-write mapping is refused.
+    pub fn place(self: *const Self, target: *VM) LoaderError!void {
+        if (self.end > target.memory_size or self.entry >= target.memory_size) return error.SegmentOutOfBounds;
+
+        for (self.loads()) |segment| {
+            const start: usize = @intCast(segment.vaddr);
+            const file_bytes = self.bytes[@intCast(segment.offset)..][0..@intCast(segment.filesz)];
+            if (self.fd != null and !segment.writable()) {
+                try self.map_segment(target, segment);
+            } else {
+                @memcpy(target.memory[start..][0..file_bytes.len], file_bytes);
+            }
+            if (segment.memsz > segment.filesz) {
+                @memset(target.memory[start + file_bytes.len ..][0..@intCast(segment.memsz - segment.filesz)], 0);
+            }
+            target.trace.record(.{
+                .pc = 0,
+                .kind = .loader_segment,
+                .addr = segment.vaddr,
+                .args = .{ segment.filesz, segment.memsz, segment.offset, 0 },
+            });
+
+            // Assert: guest RAM must hold the segment's file bytes.
+            std.debug.assert(std.mem.eql(u8, target.memory[start..][0..file_bytes.len], file_bytes));
+        }
+    }
+
+    /// Map the whole host pages of segment copy-on-write; copy the partial pages at its ends.
+    /// Note: Falls back to copying if file offset and guest address disagree modulo the page size.
+    fn map_segment(self: *const Self, target: *VM, segment: Segment) LoaderError!void {
+        const page = std.heap.pageSize();
+        const start: usize = @intCast(segment.vaddr);
+        const len: usize = @intCast(segment.filesz);
+        const offset: usize = @intCast(segment.offset);
+        const file_bytes = self.bytes[offset..][0..len];
+
+        const first = std.mem.alignForward(usize, start, page);
+        const last = std.mem.alignBackward(usize, start + len, page);
+        if ((start -% offset) % page != 0 or last <= first) {
+            @memcpy(target.memory[start..][0..len], file_bytes);
+            return;
+        }
+        @memcpy(target.memory[start..first], file_bytes[0 .. first - start]);
+        try vm_memory.map_file(target.memory, first, self.fd.?, offset + (first - start), last - first);
+        @memcpy(target.memory[last .. start + len], file_bytes[last - start ..]);
+    }
 };
 
 /// Load RISC-V64 kernel ELF into VM (GrainStyle: in-place initialization).
@@ -75,199 +272,202 @@ pub const LoaderError = error{
 /// Contract: elf_data must be valid ELF format.
 /// Errors: SegmentOutOfBounds if ELF segments don't fit in VM memory.
 /// Errors: InvalidElfFormat if ELF header is invalid.
-/// Postcondition: VM is initialized with ELF segments loaded, PC set to entry point.
-pub fn loadKernel(target: *VM, _: std.mem.Allocator, elf_data: []const u8) LoaderError!void {
-    std.debug.print("DEBUG loader.zig: loadKernel called, elf_data.len={}\n", .{elf_data.len});
-    
-    // Check: ELF data must be non-empty.
-    if (elf_data.len == 0) {
-        std.debug.print("DEBUG loader.zig: ELF data is empty\n", .{});
-        return error.InvalidElfFormat;
+/// Errors: GuestMemoryUnavailable if guest RAM cannot be mapped.
+/// Postcondition: VM is initialized with ELF segments loaded, PC set to entry point
+/// (caller releases it with vm.deinit()); on error target is left uninitialized.
+pub fn loadKernel(target: *VM, allocator: std.mem.Allocator, elf_data: []const u8) LoaderError!void {
+    return loadKernelWithOptions(target, allocator, elf_data, .{});
+}
+
+/// Load RISC-V64 kernel ELF into VM with explicit init options (e.g. JIT mode).
+/// Contract: Same as loadKernel; options are passed to VM.init_with_options.
+/// Note: Caller owns VM.deinit when options allocate (JIT arena).
+pub fn loadKernelWithOptions(target: *VM, _: std.mem.Allocator, elf_data: []const u8, options: VM.InitOptions) LoaderError!void {
+    const image = try Image.parse(elf_data);
+    return loadImage(target, &image, options);
+}
+
+/// Initialize target from a validated Image (no header parsing, no debug output).
+/// Contract: target must point to uninitialized VM struct; image.bytes are still valid.
+/// Errors: SegmentOutOfBounds if the image does not fit options.memory_size.
+/// Errors: GuestMemoryUnavailable if guest RAM (or a segment mapping) is refused.
+/// Postcondition: as loadKernel; on error target is left uninitialized.
+pub fn loadImage(target: *VM, image: *const Image, options: VM.InitOptions) LoaderError!void {
+    try VM.init_with_options(target, &[_]u8{}, 0, options);
+    // A failed load leaves target uninitialized (no guest RAM left mapped).
+    errdefer target.deinit();
+
+    try image.place(target);
+    target.regs.pc = image.entry;
+    target.trace.record(.{ .pc = image.entry, .kind = .loader_entry, .addr = image.entry });
+
+    // Assert: VM must be halted at the entry point after loading.
+    std.debug.assert(target.state == .halted);
+    std.debug.assert(target.regs.pc < target.memory_size);
+}
+
+
+/// Symbol lookup errors.
+pub const SymbolError = error{InvalidElfFormat} || std.mem.Allocator.Error;
+
+/// One code symbol from .symtab.
+pub const Symbol = struct {
+    addr: u64,
+    /// Size in bytes (0 if the ELF did not record one).
+    size: u64,
+    /// Name (points into SymbolTable.names).
+    name: []const u8,
+};
+
+/// Code symbols of an ELF, sorted by address (see loadSymbols).
+/// Why: Lets the profiler print function names instead of raw guest PCs.
+pub const SymbolTable = struct {
+    allocator: std.mem.Allocator,
+    /// Sorted by addr.
+    symbols: []Symbol,
+    /// Owned copy of every symbol name.
+    names: []u8,
+
+    const Self = @This();
+
+    /// Symbol containing addr, or null.
+    /// Note: A sized symbol covers [addr, addr + size). An unsized one (hand-written
+    /// assembly labels) covers addr up to the next symbol.
+    pub fn lookup(self: *const Self, addr: u64) ?*const Symbol {
+        // Last symbol starting at or below addr (binary search).
+        var low: usize = 0;
+        var high: usize = self.symbols.len;
+        while (low < high) {
+            const mid = low + (high - low) / 2;
+            if (self.symbols[mid].addr <= addr) low = mid + 1 else high = mid;
+        }
+        if (low == 0) return null;
+        const symbol = &self.symbols[low - 1];
+        if (symbol.size != 0 and addr - symbol.addr >= symbol.size) return null;
+        return symbol;
     }
-    
-    // Check: ELF data must be large enough for ELF header.
-    if (elf_data.len < @sizeOf(Elf64_Ehdr)) {
-        std.debug.print("DEBUG loader.zig: ELF data too small ({} < {})\n", .{ elf_data.len, @sizeOf(Elf64_Ehdr) });
-        return error.InvalidElfFormat;
+
+    pub fn deinit(self: *Self) void {
+        self.allocator.free(self.symbols);
+        self.allocator.free(self.names);
+        self.* = undefined;
     }
-    
-    // Parse ELF header.
-    // Why: @alignCast required because Elf64_Ehdr requires alignment.
-    // Note: ELF files are typically aligned, but we check alignment to avoid crashes.
-    // Check: ELF data pointer alignment (Elf64_Ehdr requires 8-byte alignment).
-    const alignment_required = @alignOf(Elf64_Ehdr);
-    const ptr_addr = @intFromPtr(elf_data.ptr);
-    std.debug.print("DEBUG loader.zig: ptr_addr=0x{x}, alignment_required={}, aligned={}\n", .{ ptr_addr, alignment_required, ptr_addr % alignment_required == 0 });
-    
-    const ehdr: *const Elf64_Ehdr = if (ptr_addr % alignment_required != 0) blk: {
-        std.debug.print("DEBUG loader.zig: Using aligned buffer (unaligned pointer)\n", .{});
-        // ELF data is not properly aligned - copy to aligned buffer.
-        var aligned_buffer: [@sizeOf(Elf64_Ehdr)]u8 align(alignment_required) = undefined;
-        @memcpy(&aligned_buffer, elf_data[0..@sizeOf(Elf64_Ehdr)]);
-        break :blk @as(*const Elf64_Ehdr, @ptrCast(&aligned_buffer));
-    } else blk: {
-        std.debug.print("DEBUG loader.zig: Using @alignCast (aligned pointer)\n", .{});
-        break :blk @as(*const Elf64_Ehdr, @alignCast(@ptrCast(elf_data.ptr)));
-    };
-    
-    std.debug.print("DEBUG loader.zig: ELF header parsed, magic={x:0>2} {x:0>2} {x:0>2} {x:0>2}\n", .{ ehdr.e_ident[0], ehdr.e_ident[1], ehdr.e_ident[2], ehdr.e_ident[3] });
-    
-    // Check: ELF magic number must match (return error instead of asserting for userspace programs).
-    if (!std.mem.eql(u8, ehdr.e_ident[0..4], &ELF_MAGIC)) {
+};
+
+/// Index the code symbols in elf_data's .symtab (functions and untyped defined labels).
+/// Why: Profiles symbolize guest PCs without a host toolchain.
+/// Contract: elf_data is the same image given to loadKernel (not referenced afterwards).
+/// Note: Stripped images yield an empty table, not an error.
+/// Errors: InvalidElfFormat if the header or section tables are malformed.
+/// Postcondition: Caller releases the table with deinit().
+pub fn loadSymbols(allocator: std.mem.Allocator, elf_data: []const u8) SymbolError!SymbolTable {
+    if (elf_data.len < @sizeOf(Elf64_Ehdr)) {
         return error.InvalidElfFormat;
     }
-    
-    // Check: ELF class must be 64-bit (e_ident[4] = 2).
-    if (ehdr.e_ident[4] != 2) {
+    // Why: bytesToValue copies, so unaligned images are fine.
+    const ehdr = std.mem.bytesToValue(Elf64_Ehdr, elf_data[0..@sizeOf(Elf64_Ehdr)]);
+    if (!std.mem.eql(u8, ehdr.e_ident[0..4], &ELF_MAGIC) or ehdr.e_ident[4] != 2 or ehdr.e_ident[5] != 1) {
         return error.InvalidElfFormat;
     }
-    
-    // Check: ELF endianness must be little-endian (e_ident[5] = 1).
-    if (ehdr.e_ident[5] != 1) {
-        return error.InvalidElfFormat;
+
+    var table = SymbolTable{ .allocator = allocator, .symbols = &.{}, .names = &.{} };
+    if (ehdr.e_shnum == 0 or ehdr.e_shoff == 0) {
+        return table;
     }
-    
-    // Check: ELF version must be 1 (e_ident[6] = 1).
-    if (ehdr.e_ident[6] != 1) {
+    if (ehdr.e_shentsize != @sizeOf(Elf64_Shdr)) {
         return error.InvalidElfFormat;
     }
-    
-    // Check: Machine architecture must be RISC-V (243).
-    if (ehdr.e_machine != 243) {
+    const shdrs_size = @as(u64, ehdr.e_shnum) * @sizeOf(Elf64_Shdr);
+    if (ehdr.e_shoff > elf_data.len or shdrs_size > elf_data.len - ehdr.e_shoff) {
         return error.InvalidElfFormat;
     }
-    
-    // Check: ELF type must be executable (2).
-    if (ehdr.e_type != 2) {
-        return error.InvalidElfFormat;
+
+    // Find the symbol table (at most one per ELF) and its string table.
+    var symtab: ?Elf64_Shdr = null;
+    var section_index: u16 = 0;
+    while (section_index < ehdr.e_shnum) : (section_index += 1) {
+        const shdr = read_section_header(elf_data, ehdr, section_index);
+        if (shdr.sh_type == SHT_SYMTAB) {
+            symtab = shdr;
+            break;
+        }
     }
-    
-    // Check: Program header table must be present.
-    if (ehdr.e_phnum == 0 or ehdr.e_phoff == 0) {
+    const symtab_shdr = symtab orelse return table;
+    if (symtab_shdr.sh_link >= ehdr.e_shnum or symtab_shdr.sh_entsize != @sizeOf(Elf64_Sym)) {
         return error.InvalidElfFormat;
     }
-    
-    // Check: Program header table must fit in ELF data.
-    const phdr_size = @as(usize, ehdr.e_phnum) * @sizeOf(Elf64_Phdr);
-    if (ehdr.e_phoff + phdr_size > elf_data.len) {
+    const strtab_shdr = read_section_header(elf_data, ehdr, @intCast(symtab_shdr.sh_link));
+    if (strtab_shdr.sh_type != SHT_STRTAB) {
         return error.InvalidElfFormat;
     }
-    
-    // Initialize VM (will be populated with kernel segments).
-    // GrainStyle: Use in-place initialization to avoid stack overflow.
-    VM.init(target, &[_]u8{}, 0);
-    
-    // Load each program header segment.
-    // Why: Load kernel code/data segments into VM memory.
-    const phdr_base = elf_data[@intCast(ehdr.e_phoff)..];
-    std.debug.print("DEBUG loader.zig: Loading {} program headers\n", .{ehdr.e_phnum});
-    var phdr_idx: u16 = 0;
-    var first_load_vaddr: ?u64 = null; // Track first PT_LOAD segment for PIE entry point adjustment
-    while (phdr_idx < ehdr.e_phnum) : (phdr_idx += 1) {
-        std.debug.print("DEBUG loader.zig: Processing program header {}/{}\n", .{ phdr_idx + 1, ehdr.e_phnum });
-        const phdr_offset = phdr_idx * @sizeOf(Elf64_Phdr);
-        // Check: Program header must fit in ELF data.
-        if (phdr_offset + @sizeOf(Elf64_Phdr) > phdr_base.len) {
-            std.debug.print("DEBUG loader.zig: Program header {} out of bounds\n", .{phdr_idx});
-            return error.InvalidElfFormat;
-        }
-        
-        // Why: @alignCast required because Elf64_Phdr requires alignment.
-        const phdr = @as(*const Elf64_Phdr, @alignCast(@ptrCast(phdr_base.ptr + phdr_offset)));
-        std.debug.print("DEBUG loader.zig: Program header {}: type={}, vaddr=0x{x}, filesz={}, memsz={}\n", .{ phdr_idx, phdr.p_type, phdr.p_vaddr, phdr.p_filesz, phdr.p_memsz });
-        
-        // Only load PT_LOAD segments (type 1).
-        if (phdr.p_type == 1) {
-            // Track first PT_LOAD segment for PIE entry point adjustment.
-            if (first_load_vaddr == null) {
-                first_load_vaddr = phdr.p_vaddr;
-            }
-            std.debug.print("DEBUG loader.zig: Loading PT_LOAD segment at vaddr=0x{x}\n", .{phdr.p_vaddr});
-            // Check: Segment must fit in ELF data (return error instead of asserting for userspace programs).
-            if (phdr.p_offset + phdr.p_filesz > elf_data.len) {
-                return error.InvalidElfFormat;
-            }
-            
-            // Check: Segment must fit in VM memory (return error instead of asserting for userspace programs).
-            if (phdr.p_vaddr + phdr.p_memsz > target.memory_size) {
-                return error.SegmentOutOfBounds;
-            }
-            
-            // Check: Segment address must be valid for memory copy.
-            if (phdr.p_vaddr + phdr.p_filesz > target.memory_size) {
-                return error.SegmentOutOfBounds;
-            }
-            
-            // Load segment data into VM memory.
-            // Contract: All bounds must be checked before memory operations.
-            const segment_data = elf_data[@intCast(phdr.p_offset)..][0..@intCast(phdr.p_filesz)];
-            const dest_start = @as(usize, @intCast(phdr.p_vaddr));
-            const dest_end = dest_start + segment_data.len;
-            
-            // Check: Destination must be within VM memory bounds.
-            if (dest_start >= target.memory_size) {
-                std.debug.print("DEBUG loader.zig: Segment vaddr 0x{x} >= memory_size 0x{x}\n", .{ phdr.p_vaddr, target.memory_size });
-                return error.SegmentOutOfBounds;
-            }
-            if (dest_end > target.memory_size) {
-                std.debug.print("DEBUG loader.zig: Segment end 0x{x} > memory_size 0x{x}\n", .{ phdr.p_vaddr + phdr.p_filesz, target.memory_size });
-                return error.SegmentOutOfBounds;
-            }
-            
-            // Check: Destination slice must be valid.
-            if (dest_start + segment_data.len > target.memory.len) {
-                std.debug.print("DEBUG loader.zig: Segment would overflow memory array\n", .{});
-                return error.SegmentOutOfBounds;
-            }
-            
-            // Safe to copy: all bounds checked.
-            std.debug.print("DEBUG loader.zig: Copying {} bytes from offset {} to vaddr 0x{x}\n", .{ segment_data.len, phdr.p_offset, phdr.p_vaddr });
-            @memcpy(target.memory[dest_start..dest_end], segment_data);
-            std.debug.print("DEBUG loader.zig: Copy completed successfully\n", .{});
-            
-            // Zero-fill memory beyond file size (if memsz > filesz).
-            if (phdr.p_memsz > phdr.p_filesz) {
-                const zero_start = @as(usize, @intCast(phdr.p_vaddr + phdr.p_filesz));
-                const zero_len = @as(usize, @intCast(phdr.p_memsz - phdr.p_filesz));
-                std.debug.print("DEBUG loader.zig: Zero-filling {} bytes at vaddr 0x{x}\n", .{ zero_len, phdr.p_vaddr + phdr.p_filesz });
-                // Check: Zero-fill region must fit in VM memory.
-                if (zero_start + zero_len > target.memory_size) {
-                    std.debug.print("DEBUG loader.zig: Zero-fill would exceed memory_size\n", .{});
-                    return error.SegmentOutOfBounds;
-                }
-                if (zero_start + zero_len > target.memory.len) {
-                    std.debug.print("DEBUG loader.zig: Zero-fill would overflow memory array\n", .{});
-                    return error.SegmentOutOfBounds;
-                }
-                @memset(target.memory[zero_start..zero_start + zero_len], 0);
-                std.debug.print("DEBUG loader.zig: Zero-fill completed successfully\n", .{});
-            }
-        }
+    const symbol_bytes = try section_data(elf_data, symtab_shdr);
+    const strings = try section_data(elf_data, strtab_shdr);
+
+    // First pass: count kept symbols and name bytes so both buffers are allocated once.
+    const symbol_count = symbol_bytes.len / @sizeOf(Elf64_Sym);
+    var kept: usize = 0;
+    var names_len: usize = 0;
+    var symbol_index: usize = 0;
+    while (symbol_index < symbol_count) : (symbol_index += 1) {
+        const sym = read_symbol(symbol_bytes, symbol_index);
+        const name = (try symbol_name(strings, sym)) orelse continue;
+        kept += 1;
+        names_len += name.len;
     }
-    
-    // Set VM PC to ELF entry point.
-    // Note: For PIE executables, if entry point is 0x0, use first PT_LOAD segment's vaddr as base.
-    var entry_point = ehdr.e_entry;
-    if (entry_point == 0x0) {
-        if (first_load_vaddr) |base_addr| {
-            std.debug.print("DEBUG loader.zig: PIE executable detected (entry=0x0), using first PT_LOAD vaddr 0x{x} as entry point\n", .{base_addr});
-            entry_point = base_addr;
-        }
+
+    table.symbols = try allocator.alloc(Symbol, kept);
+    errdefer allocator.free(table.symbols);
+    table.names = try allocator.alloc(u8, names_len);
+
+    // Second pass: copy names and fill symbols (the first pass validated every name).
+    var filled: usize = 0;
+    var names_used: usize = 0;
+    symbol_index = 0;
+    while (symbol_index < symbol_count) : (symbol_index += 1) {
+        const sym = read_symbol(symbol_bytes, symbol_index);
+        const name = (symbol_name(strings, sym) catch unreachable) orelse continue;
+        const name_copy = table.names[names_used..][0..name.len];
+        @memcpy(name_copy, name);
+        names_used += name.len;
+        table.symbols[filled] = .{ .addr = sym.st_value, .size = sym.st_size, .name = name_copy };
+        filled += 1;
     }
-    std.debug.print("DEBUG loader.zig: Setting entry point to 0x{x}\n", .{entry_point});
-    // Check: Entry point must be within VM memory bounds.
-    if (entry_point >= target.memory_size) {
-        std.debug.print("DEBUG loader.zig: Entry point 0x{x} >= memory_size 0x{x}\n", .{ entry_point, target.memory_size });
-        return error.SegmentOutOfBounds;
+    std.mem.sort(Symbol, table.symbols, {}, symbol_less_than);
+
+    // Assert: both passes must agree.
+    std.debug.assert(filled == kept);
+    std.debug.assert(names_used == names_len);
+
+    return table;
+}
+
+fn read_section_header(elf_data: []const u8, ehdr: Elf64_Ehdr, index: u16) Elf64_Shdr {
+    const offset: usize = @intCast(ehdr.e_shoff + @as(u64, index) * @sizeOf(Elf64_Shdr));
+    return std.mem.bytesToValue(Elf64_Shdr, elf_data[offset..][0..@sizeOf(Elf64_Shdr)]);
+}
+
+fn read_symbol(symbol_bytes: []const u8, index: usize) Elf64_Sym {
+    return std.mem.bytesToValue(Elf64_Sym, symbol_bytes[index * @sizeOf(Elf64_Sym) ..][0..@sizeOf(Elf64_Sym)]);
+}
+
+fn section_data(elf_data: []const u8, shdr: Elf64_Shdr) SymbolError![]const u8 {
+    if (shdr.sh_offset > elf_data.len or shdr.sh_size > elf_data.len - shdr.sh_offset) {
+        return error.InvalidElfFormat;
     }
-    
-    target.regs.pc = entry_point;
-    std.debug.print("DEBUG loader.zig: Entry point set successfully, PC=0x{x}\n", .{target.regs.pc});
-    
-    // Contract: PC must be set to entry point (verified by assignment above).
-    // Note: Entry point can be 0x0 for position-independent executables (adjusted to first PT_LOAD vaddr).
-    
-    // Assert: VM must be in halted state after loading.
-    std.debug.assert(target.state == .halted);
+    return elf_data[@intCast(shdr.sh_offset)..][0..@intCast(shdr.sh_size)];
 }
 
+/// Name of sym if it is a defined code symbol worth keeping, else null.
+fn symbol_name(strings: []const u8, sym: Elf64_Sym) SymbolError!?[]const u8 {
+    const kind = sym.st_info & 0xF;
+    if (kind != STT_FUNC and kind != STT_NOTYPE) return null;
+    if (sym.st_shndx == 0 or sym.st_value == 0 or sym.st_name == 0) return null;
+    if (sym.st_name >= strings.len) return error.InvalidElfFormat;
+    const name = std.mem.sliceTo(strings[sym.st_name..], 0);
+    if (name.len == 0) return null;
+    return name;
+}
+
+fn symbol_less_than(_: void, a: Symbol, b: Symbol) bool {
+    return a.addr < b.addr;
+}
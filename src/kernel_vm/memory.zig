@@ -0,0 +1,127 @@
+const std = @import("std");
+
+/// Guest physical memory (RAM) backed by one lazily-faulted mmap reservation.
+/// Grain Style: Explicit lifecycle (map / zero / unmap), no allocator, no hidden copies.
+/// ~<~ Glow Earthbend: untouched guest pages stay the host's shared zero page.
+///
+/// Why: An inline array costs its full size in every VM and a full memset on every
+/// init; a private anonymous mapping costs only the pages the guest actually touches,
+/// so multi-GB guests are as cheap to create and reset as 4MB ones.
+/// Layout: [guard][RAM][guard]. Guards are PROT_NONE, so a host-side access that
+/// escapes a bounds check faults at once instead of touching neighbouring host memory.
+
+/// Default guest RAM size.
+pub const DEFAULT_SIZE: usize = 4 * 1024 * 1024;
+/// Smallest guest RAM size.
+pub const MIN_SIZE: usize = 1024 * 1024;
+/// Largest guest RAM size (address arithmetic in handlers stays far from u64 overflow).
+pub const MAX_SIZE: usize = 64 * 1024 * 1024 * 1024;
+/// RAM sizes are multiples of this (covers 4K and 16K host pages).
+pub const SIZE_GRANULE: usize = 64 * 1024;
+/// Guard region before and after RAM (larger than any single guest access or 12-bit offset).
+pub const GUARD_SIZE: usize = 64 * 1024;
+
+pub const Error = error{GuestMemoryUnavailable};
+
+/// Host page-aligned RAM slice (exactly the guest-visible bytes, guards excluded).
+pub const Ram = []align(std.heap.page_size_min) u8;
+
+comptime {
+    // Assert: guards and granule must be whole host pages.
+    std.debug.assert(GUARD_SIZE % std.heap.page_size_max == 0);
+    std.debug.assert(SIZE_GRANULE % std.heap.page_size_max == 0);
+    std.debug.assert(DEFAULT_SIZE % SIZE_GRANULE == 0);
+}
+
+/// Whether size is a valid guest RAM size.
+pub fn valid_size(size: usize) bool {
+    return size >= MIN_SIZE and size <= MAX_SIZE and size % SIZE_GRANULE == 0;
+}
+
+/// Reserve guarded RAM of size bytes (every byte reads as zero until written).
+/// Contract: valid_size(size).
+/// Errors: GuestMemoryUnavailable if the host refuses the reservation.
+pub fn map(size: usize) Error!Ram {
+    std.debug.assert(valid_size(size));
+
+    const reservation = std.posix.mmap(
+        null,
+        size + 2 * GUARD_SIZE,
+        std.posix.PROT.NONE,
+        reserve_flags(false),
+        -1,
+        0,
+    ) catch return error.GuestMemoryUnavailable;
+
+    const ram: Ram = @alignCast(reservation[GUARD_SIZE..][0..size]);
+    zero(ram) catch {
+        std.posix.munmap(reservation);
+        return error.GuestMemoryUnavailable;
+    };
+
+    // Assert: RAM must sit between the two guards.
+    std.debug.assert(@intFromPtr(ram.ptr) == @intFromPtr(reservation.ptr) + GUARD_SIZE);
+    std.debug.assert(ram.len == size);
+    return ram;
+}
+
+/// Discard RAM contents (every page reads as zero again).
+/// Why: Replacing the mapping in place drops touched pages, so the cost is
+/// O(touched pages), not O(size); guards are left untouched.
+/// Errors: GuestMemoryUnavailable if the host refuses the replacement mapping.
+pub fn zero(ram: Ram) Error!void {
+    const remapped = std.posix.mmap(
+        ram.ptr,
+        ram.len,
+        std.posix.PROT.READ | std.posix.PROT.WRITE,
+        reserve_flags(true),
+        -1,
+        0,
+    ) catch return error.GuestMemoryUnavailable;
+
+    // Assert: fixed mapping must land exactly on RAM.
+    std.debug.assert(remapped.ptr == ram.ptr);
+    std.debug.assert(remapped.len == ram.len);
+}
+
+/// Map len bytes of fd at offset copy-on-write over ram[start..start + len].
+/// Why: ELF images share their read-only pages with the page cache; a guest store
+/// faults in a private copy, and zero() / unmap() drop the mapping like any other page.
+/// Contract: start, offset and len are host-page aligned; the range lies inside ram.
+/// Errors: GuestMemoryUnavailable if the host refuses the mapping.
+pub fn map_file(ram: Ram, start: usize, fd: std.posix.fd_t, offset: usize, len: usize) Error!void {
+    const page = std.heap.pageSize();
+    std.debug.assert(start % page == 0 and offset % page == 0 and len % page == 0);
+    std.debug.assert(len > 0 and start + len <= ram.len);
+
+    const target: [*]align(std.heap.page_size_min) u8 = @alignCast(ram.ptr + start);
+    const mapped = std.posix.mmap(
+        target,
+        len,
+        std.posix.PROT.READ | std.posix.PROT.WRITE,
+        .{ .TYPE = .PRIVATE, .FIXED = true },
+        fd,
+        offset,
+    ) catch return error.GuestMemoryUnavailable;
+
+    // Assert: fixed mapping must land exactly on the requested RAM pages.
+    std.debug.assert(mapped.ptr == target);
+    std.debug.assert(mapped.len == len);
+}
+
+/// Release RAM and its guards.
+/// Contract: ram must come from map().
+pub fn unmap(ram: Ram) void {
+    const base: [*]align(std.heap.page_size_min) u8 = @alignCast(ram.ptr - GUARD_SIZE);
+    std.posix.munmap(base[0 .. ram.len + 2 * GUARD_SIZE]);
+}
+
+/// Private anonymous mapping flags (no swap reservation where the host supports it).
+fn reserve_flags(fixed: bool) std.posix.MAP {
+    var flags: std.posix.MAP = .{ .TYPE = .PRIVATE, .ANONYMOUS = true };
+    flags.FIXED = fixed;
+    if (@hasField(std.posix.MAP, "NORESERVE")) {
+        flags.NORESERVE = true;
+    }
+    return flags;
+}
@@ -0,0 +1,202 @@
+const std = @import("std");
+
+/// Sv39 address translation with a per-hart software TLB.
+/// Grain Style: Fixed-size direct-mapped TLB, pure page walk, explicit counters.
+/// ~<~ Glow Waterbend: virtual pages flow onto physical frames through one tag compare.
+///
+/// Why: User processes need isolated address spaces, but a three-level walk per
+/// load, store and fetch would dominate run time. The TLB keeps one tag array per
+/// access kind, so a hit is one compare and permission checks happen only on a walk.
+/// Note: Tags are full virtual page numbers (VA >> 12), so a non-canonical address
+/// can never hit; the walk rejects it.
+/// Note: The TLB is not ASID-tagged. Changing satp flushes it, and SFENCE.VMA with an
+/// ASID flushes as if none was given (conservative, never stale).
+/// Note: The VM has no privilege modes yet, so PTE.U is not checked.
+
+/// satp.MODE values (bits 63:60).
+pub const SATP_MODE_BARE: u64 = 0;
+pub const SATP_MODE_SV39: u64 = 8;
+/// satp.PPN field (bits 43:0): root page-table frame.
+pub const SATP_PPN_MASK: u64 = (1 << 44) - 1;
+
+/// TLB slots (power of two; indexed by low VPN bits).
+pub const TLB_SIZE: usize = 256;
+
+const PAGE_SHIFT: u6 = 12;
+const PAGE_OFFSET_MASK: u64 = (1 << PAGE_SHIFT) - 1;
+const LEVELS: u2 = 3;
+const PTE_SIZE: u64 = 8;
+const TAG_EMPTY: u64 = std.math.maxInt(u64);
+
+/// PTE flag bits.
+pub const PTE_V: u64 = 1 << 0;
+pub const PTE_R: u64 = 1 << 1;
+pub const PTE_W: u64 = 1 << 2;
+pub const PTE_X: u64 = 1 << 3;
+pub const PTE_U: u64 = 1 << 4;
+pub const PTE_G: u64 = 1 << 5;
+pub const PTE_A: u64 = 1 << 6;
+pub const PTE_D: u64 = 1 << 7;
+/// PTE.PPN field (bits 53:10) after shifting right by 10.
+const PTE_PPN_MASK: u64 = (1 << 44) - 1;
+
+pub const Error = error{page_fault};
+
+/// Kind of access being translated (one TLB tag array each).
+pub const Access = enum(u2) {
+    load,
+    store,
+    fetch,
+};
+
+/// TLB hit/miss statistics (see VM.tlb_counters).
+pub const Counters = struct {
+    /// Translations served by a tag compare.
+    hits: u64 = 0,
+    /// Translations that walked page tables (including faulting ones).
+    misses: u64 = 0,
+    /// Walks that ended in a page fault.
+    faults: u64 = 0,
+    /// Full flushes (satp writes, SFENCE.VMA without an address, remote fences).
+    flushes: u64 = 0,
+
+    /// Fraction of translations that hit (0 when nothing was translated).
+    pub fn hit_rate(self: Counters) f64 {
+        const total = self.hits + self.misses;
+        if (total == 0) return 0;
+        return @as(f64, @floatFromInt(self.hits)) / @as(f64, @floatFromInt(total));
+    }
+};
+
+/// Result of a successful page walk.
+pub const Leaf = struct {
+    /// Physical address of the 4K frame backing the virtual page.
+    frame: u64,
+    /// Leaf PTE after any A/D update.
+    pte: u64,
+    /// Physical address of the leaf PTE.
+    pte_addr: u64,
+    /// Whether the walk set A or D (the caller records the store).
+    updated: bool,
+};
+
+/// Direct-mapped software TLB keyed by virtual page number.
+pub const Tlb = struct {
+    /// Per-access tags: VPN if the slot's leaf permits that access, else TAG_EMPTY.
+    /// Why: Permission checks are folded into the fill, so lookup is one compare.
+    tags: [3][TLB_SIZE]u64 = [_][TLB_SIZE]u64{[_]u64{TAG_EMPTY} ** TLB_SIZE} ** 3,
+    /// Physical frame per slot (valid wherever one of its tags is set).
+    frames: [TLB_SIZE]u64 = [_]u64{0} ** TLB_SIZE,
+    counters: Counters = .{},
+
+    const Self = @This();
+
+    /// Physical address for vaddr if the TLB holds a translation permitting access.
+    pub inline fn lookup(self: *Self, vaddr: u64, comptime access: Access) ?u64 {
+        const vpn = vaddr >> PAGE_SHIFT;
+        const index: usize = @intCast(vpn & (TLB_SIZE - 1));
+        if (self.tags[@intFromEnum(access)][index] != vpn) return null;
+        self.counters.hits += 1;
+        return self.frames[index] | (vaddr & PAGE_OFFSET_MASK);
+    }
+
+    /// Install leaf for vaddr's page (replaces whatever the slot held).
+    /// Note: Stores are tagged only once D is set, so the first store to a clean
+    /// page walks again and sets it.
+    pub fn fill(self: *Self, vaddr: u64, leaf: Leaf) void {
+        const vpn = vaddr >> PAGE_SHIFT;
+        const index: usize = @intCast(vpn & (TLB_SIZE - 1));
+        self.frames[index] = leaf.frame;
+        self.tags[@intFromEnum(Access.load)][index] = if (leaf.pte & PTE_R != 0) vpn else TAG_EMPTY;
+        self.tags[@intFromEnum(Access.store)][index] = if (leaf.pte & PTE_W != 0 and leaf.pte & PTE_D != 0) vpn else TAG_EMPTY;
+        self.tags[@intFromEnum(Access.fetch)][index] = if (leaf.pte & PTE_X != 0) vpn else TAG_EMPTY;
+
+        // Assert: frame must be page-aligned.
+        std.debug.assert(leaf.frame & PAGE_OFFSET_MASK == 0);
+    }
+
+    /// Drop every translation.
+    pub fn flush_all(self: *Self) void {
+        for (&self.tags) |*tags| {
+            @memset(tags, TAG_EMPTY);
+        }
+        self.counters.flushes += 1;
+    }
+
+    /// Drop the translation for vaddr's page (if cached).
+    pub fn flush_page(self: *Self, vaddr: u64) void {
+        const vpn = vaddr >> PAGE_SHIFT;
+        const index: usize = @intCast(vpn & (TLB_SIZE - 1));
+        for (&self.tags) |*tags| {
+            if (tags[index] == vpn) tags[index] = TAG_EMPTY;
+        }
+    }
+};
+
+/// Whether satp selects a mode this VM implements (Bare or Sv39).
+pub fn valid_satp(satp: u64) bool {
+    const mode = satp >> 60;
+    return mode == SATP_MODE_BARE or mode == SATP_MODE_SV39;
+}
+
+/// Walk the Sv39 tables rooted at satp for vaddr, setting A (and D for stores).
+/// Why: Pure function of guest RAM so every hart (and tests) can call it.
+/// Contract: satp.MODE is Sv39; memory is guest RAM (page tables are physical).
+/// Errors: page_fault for non-canonical addresses, invalid or misaligned PTEs,
+/// tables outside RAM, and leaves that do not permit access.
+pub fn walk(memory: []u8, satp: u64, vaddr: u64, access: Access) Error!Leaf {
+    std.debug.assert(satp >> 60 == SATP_MODE_SV39);
+
+    // Bits 63:39 must all equal bit 38.
+    const upper: i64 = @as(i64, @bitCast(vaddr)) >> 38;
+    if (upper != 0 and upper != -1) return error.page_fault;
+
+    var table: u64 = (satp & SATP_PPN_MASK) << PAGE_SHIFT;
+    var level: u2 = LEVELS - 1;
+    while (true) : (level -= 1) {
+        const shift: u6 = PAGE_SHIFT + @as(u6, 9) * level;
+        const pte_addr = table + ((vaddr >> shift) & 0x1FF) * PTE_SIZE;
+        if (pte_addr > memory.len - PTE_SIZE) return error.page_fault;
+        const pte_ptr: *u64 = @ptrCast(@alignCast(&memory[@intCast(pte_addr)]));
+        const pte = std.mem.littleToNative(u64, @atomicLoad(u64, pte_ptr, .acquire));
+
+        // Invalid, or the reserved W-without-R encoding.
+        if (pte & PTE_V == 0 or (pte & PTE_R == 0 and pte & PTE_W != 0)) return error.page_fault;
+
+        const ppn = (pte >> 10) & PTE_PPN_MASK;
+        if (pte & (PTE_R | PTE_X) == 0) {
+            // Pointer to the next level.
+            if (level == 0) return error.page_fault;
+            table = ppn << PAGE_SHIFT;
+            continue;
+        }
+
+        // Leaf: permission, then superpage alignment.
+        const permitted = switch (access) {
+            .load => pte & PTE_R != 0,
+            .store => pte & PTE_W != 0,
+            .fetch => pte & PTE_X != 0,
+        };
+        if (!permitted) return error.page_fault;
+        const superpage_mask: u64 = (@as(u64, 1) << (@as(u6, 9) * level)) - 1;
+        if (ppn & superpage_mask != 0) return error.page_fault;
+
+        // Hardware A/D update (atomic: harts share page tables).
+        const flags = PTE_A | (if (access == .store) PTE_D else 0);
+        var updated_pte = pte;
+        if (pte & flags != flags) {
+            const old = @atomicRmw(u64, pte_ptr, .Or, std.mem.nativeToLittle(u64, flags), .acq_rel);
+            updated_pte = std.mem.littleToNative(u64, old) | flags;
+        }
+
+        // Superpages: the low VPN fields select the 4K frame inside the leaf.
+        const vpn = vaddr >> PAGE_SHIFT;
+        const frame = (ppn | (vpn & superpage_mask)) << PAGE_SHIFT;
+        return .{
+            .frame = frame,
+            .pte = updated_pte,
+            .pte_addr = pte_addr,
+            .updated = updated_pte != pte,
+        };
+    }
+}
@@ -0,0 +1,272 @@
+const std = @import("std");
+const vm_options = @import("vm_options");
+const SymbolTable = @import("loader.zig").SymbolTable;
+
+/// Sampling profiler for guest code in the RISC-V VM.
+/// Grain Style: Fixed-size tables, no allocation, no formatting on the hot path.
+/// ~<~ Glow Airbend: every Nth instruction leaves a footprint; the flame comes out on demand.
+///
+/// Why: Guest time was invisible. Every N retired instructions the profiler records the
+/// PC and a shadow call stack (built from JAL/JALR through ra or t0). It also counts every
+/// retired instruction by 7-bit opcode. write_folded() symbolizes the stacks against an
+/// ELF .symtab and emits folded stacks (`a;b;c count`) for flamegraph.pl / inferno / speedscope.
+/// Note: Compiled in only with `zig build kernel-vm-test -Dvm-profile=true`. Otherwise
+/// Profile is zero-sized and retire() is an empty inline call, so normal builds pay nothing.
+/// Note: Profiled VMs interpret (like traced ones): translated blocks do not call retire().
+
+/// Whether profiling is compiled in (`-Dvm-profile=true`).
+pub const enabled: bool = vm_options.profile_enabled;
+
+/// Default sampling interval in retired instructions (prime, so loops do not alias).
+pub const DEFAULT_INTERVAL: u64 = 97;
+/// Distinct sampled PCs kept (open addressing; later PCs count as dropped).
+pub const PC_SLOTS: usize = 4096;
+/// Distinct sampled stacks kept (open addressing; later stacks count as dropped).
+pub const STACK_SLOTS: usize = 512;
+/// Deepest shadow call stack kept (deeper calls are counted, not recorded).
+pub const MAX_DEPTH: usize = 32;
+
+comptime {
+    // Assert: slot counts must be powers of two (index is a masked hash).
+    std.debug.assert(std.math.isPowerOfTwo(PC_SLOTS));
+    std.debug.assert(std.math.isPowerOfTwo(STACK_SLOTS));
+}
+
+/// RISC-V link registers (calls write one of them, returns jump through one).
+const REG_RA: u5 = 1;
+const REG_T0: u5 = 5;
+const OPCODE_JAL: u7 = 0b1101111;
+const OPCODE_JALR: u7 = 0b1100111;
+
+/// Sample count for one PC.
+pub const PcCount = struct {
+    pc: u64 = 0,
+    count: u64 = 0,
+};
+
+/// Sample count for one call stack (call sites outermost first, then the sampled PC).
+pub const StackCount = struct {
+    frames: [MAX_DEPTH + 1]u64 = undefined,
+    len: u8 = 0,
+    count: u64 = 0,
+
+    fn slice(self: *const StackCount) []const u64 {
+        return self.frames[0..self.len];
+    }
+};
+
+/// Profiler state embedded in VM (profile builds only).
+pub const Profiler = struct {
+    /// Retired instructions between samples (>= 1).
+    interval: u64 = DEFAULT_INTERVAL,
+    /// Retired instructions until the next sample.
+    countdown: u64 = DEFAULT_INTERVAL,
+    /// Retired instructions by opcode (bits [6:0]).
+    opcode_counts: [128]u64 = [_]u64{0} ** 128,
+    /// Sampled PC histogram (count == 0 marks an empty slot).
+    pcs: [PC_SLOTS]PcCount = [_]PcCount{.{}} ** PC_SLOTS,
+    /// Sampled stack histogram (count == 0 marks an empty slot).
+    stacks: [STACK_SLOTS]StackCount = [_]StackCount{.{}} ** STACK_SLOTS,
+    /// Shadow call stack: PCs of the calls that entered each active frame.
+    call_sites: [MAX_DEPTH]u64 = undefined,
+    depth: u8 = 0,
+    /// Calls made while the shadow stack was full (their returns pop these first).
+    overflow: u64 = 0,
+    samples: u64 = 0,
+    /// Samples whose PC or stack found no free slot.
+    dropped: u64 = 0,
+
+    const Self = @This();
+
+    /// Set sampling interval (takes effect at once).
+    pub fn set_interval(self: *Self, interval: u64) void {
+        std.debug.assert(interval >= 1);
+        self.interval = interval;
+        self.countdown = interval;
+    }
+
+    /// Drop all counts and the shadow stack (interval is kept).
+    pub fn clear(self: *Self) void {
+        const interval = self.interval;
+        self.* = .{};
+        self.set_interval(interval);
+    }
+
+    /// Account one retired instruction (its PC and instruction word).
+    /// Why: Called from VM.dispatch; the common path is one increment and one decrement.
+    pub inline fn retire(self: *Self, pc: u64, inst: u32) void {
+        const opcode: u7 = @truncate(inst);
+        self.opcode_counts[opcode] += 1;
+        self.countdown -= 1;
+        if (self.countdown == 0) {
+            self.countdown = self.interval;
+            self.sample(pc);
+        }
+        if (opcode == OPCODE_JAL or opcode == OPCODE_JALR) {
+            self.track_jump(pc, inst);
+        }
+    }
+
+    /// Update the shadow stack for JAL/JALR (RISC-V calling convention hints).
+    /// Note: rd = ra/t0 is a call; JALR with rd = x0 through ra/t0 is a return.
+    fn track_jump(self: *Self, pc: u64, inst: u32) void {
+        const rd: u5 = @truncate(inst >> 7);
+        const rs1: u5 = @truncate(inst >> 15);
+        const opcode: u7 = @truncate(inst);
+        if (rd == REG_RA or rd == REG_T0) {
+            if (self.depth == MAX_DEPTH) {
+                self.overflow += 1;
+            } else {
+                self.call_sites[self.depth] = pc;
+                self.depth += 1;
+            }
+        } else if (opcode == OPCODE_JALR and rd == 0 and (rs1 == REG_RA or rs1 == REG_T0)) {
+            if (self.overflow > 0) {
+                self.overflow -= 1;
+            } else if (self.depth > 0) {
+                self.depth -= 1;
+            }
+        }
+    }
+
+    /// Record one sample at pc with the current shadow stack.
+    fn sample(self: *Self, pc: u64) void {
+        self.samples += 1;
+        if (!self.count_pc(pc)) self.dropped += 1;
+
+        var frames: [MAX_DEPTH + 1]u64 = undefined;
+        @memcpy(frames[0..self.depth], self.call_sites[0..self.depth]);
+        frames[self.depth] = pc;
+        if (!self.count_stack(frames[0 .. self.depth + 1])) self.dropped += 1;
+    }
+
+    fn count_pc(self: *Self, pc: u64) bool {
+        var index: usize = @intCast(std.hash.int(pc) & (PC_SLOTS - 1));
+        var probes: usize = 0;
+        while (probes < PC_SLOTS) : (probes += 1) {
+            const slot = &self.pcs[index];
+            if (slot.count == 0 or slot.pc == pc) {
+                slot.pc = pc;
+                slot.count += 1;
+                return true;
+            }
+            index = (index + 1) & (PC_SLOTS - 1);
+        }
+        return false;
+    }
+
+    fn count_stack(self: *Self, frames: []const u64) bool {
+        std.debug.assert(frames.len >= 1 and frames.len <= MAX_DEPTH + 1);
+
+        const hash = std.hash.Wyhash.hash(0, std.mem.sliceAsBytes(frames));
+        var index: usize = @intCast(hash & (STACK_SLOTS - 1));
+        var probes: usize = 0;
+        while (probes < STACK_SLOTS) : (probes += 1) {
+            const slot = &self.stacks[index];
+            if (slot.count == 0) {
+                @memcpy(slot.frames[0..frames.len], frames);
+                slot.len = @intCast(frames.len);
+                slot.count = 1;
+                return true;
+            }
+            if (std.mem.eql(u64, slot.slice(), frames)) {
+                slot.count += 1;
+                return true;
+            }
+            index = (index + 1) & (STACK_SLOTS - 1);
+        }
+        return false;
+    }
+
+    /// Write folded stacks, one `frame;frame;leaf count` line per distinct stack.
+    /// Why: The de-facto flamegraph input; symbols (if given) name the function containing
+    /// each address, else addresses print as hex. Adjacent frames resolving to the same
+    /// name (e.g. samples of a call instruction) are not merged, to keep counts exact.
+    pub fn write_folded(self: *const Self, symbols: ?*const SymbolTable, writer: anytype) !void {
+        for (&self.stacks) |*stack| {
+            if (stack.count == 0) continue;
+            for (stack.slice(), 0..) |addr, index| {
+                if (index > 0) try writer.writeAll(";");
+                try write_frame(symbols, addr, writer);
+            }
+            try writer.print(" {d}\n", .{stack.count});
+        }
+    }
+
+    /// Write summary: sample totals, hottest PCs, and opcode counts.
+    pub fn dump(self: *const Self, symbols: ?*const SymbolTable, writer: anytype) !void {
+        try writer.print("[vm_profile] {d} samples every {d} instructions ({d} dropped)\n", .{
+            self.samples,
+            self.interval,
+            self.dropped,
+        });
+
+        // Top PCs by sample count (selection; dump is never on the hot path).
+        var printed: [16]usize = undefined;
+        var printed_len: usize = 0;
+        while (printed_len < printed.len) : (printed_len += 1) {
+            var best: ?usize = null;
+            for (&self.pcs, 0..) |*slot, index| {
+                if (slot.count == 0) continue;
+                if (std.mem.indexOfScalar(usize, printed[0..printed_len], index) != null) continue;
+                if (best == null or slot.count > self.pcs[best.?].count) best = index;
+            }
+            const index = best orelse break;
+            printed[printed_len] = index;
+            try writer.print("[vm_profile] pc=0x{x} samples={d} ", .{ self.pcs[index].pc, self.pcs[index].count });
+            try write_frame(symbols, self.pcs[index].pc, writer);
+            try writer.writeAll("\n");
+        }
+
+        for (self.opcode_counts, 0..) |count, opcode| {
+            if (count == 0) continue;
+            try writer.print("[vm_profile] opcode=0x{x:0>2} count={d}\n", .{ opcode, count });
+        }
+    }
+};
+
+/// Profiling compiled out: zero-sized, every call is a no-op.
+pub const NullProfiler = struct {
+    const Self = @This();
+
+    pub fn set_interval(self: *Self, interval: u64) void {
+        _ = self;
+        _ = interval;
+    }
+
+    pub fn clear(self: *Self) void {
+        _ = self;
+    }
+
+    pub inline fn retire(self: *Self, pc: u64, inst: u32) void {
+        _ = self;
+        _ = pc;
+        _ = inst;
+    }
+
+    pub fn write_folded(self: *const Self, symbols: ?*const SymbolTable, writer: anytype) !void {
+        _ = self;
+        _ = symbols;
+        _ = writer;
+    }
+
+    pub fn dump(self: *const Self, symbols: ?*const SymbolTable, writer: anytype) !void {
+        _ = self;
+        _ = symbols;
+        try writer.print("[vm_profile] profiling disabled (build with -Dvm-profile=true)\n", .{});
+    }
+};
+
+/// Profile type embedded in VM (profiler when enabled, zero-sized otherwise).
+pub const Profile = if (enabled) Profiler else NullProfiler;
+
+/// Function name containing addr, or addr in hex.
+fn write_frame(symbols: ?*const SymbolTable, addr: u64, writer: anytype) !void {
+    if (symbols) |table| {
+        if (table.lookup(addr)) |symbol| {
+            try writer.writeAll(symbol.name);
+            return;
+        }
+    }
+    try writer.print("0x{x}", .{addr});
+}
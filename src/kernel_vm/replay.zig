@@ -0,0 +1,778 @@
+const std = @import("std");
+const VM = @import("vm.zig").VM;
+const PAGE_SIZE = @import("vm.zig").PAGE_SIZE;
+const vm_mmu = @import("mmu.zig");
+const vm_csr = @import("csr.zig");
+
+/// Deterministic record/replay of VM runs in a compact append-only log.
+/// Grain Style: In-place init, explicit log layout, hot path untouched.
+/// ~<~ Glow Waterbend: the run is a river; the log keeps only what fell in from outside.
+///
+/// Why: A fault found by a fuzz seed or a Tahoe session used to mean re-running from
+/// boot. Guest execution is deterministic except for values the host hands in, so the
+/// log stores only those inputs plus periodic checkpoints; replay reproduces the run
+/// exactly and seeks by restoring the nearest checkpoint and replaying forward.
+/// Note: Recording costs nothing per instruction. Inputs are appended when an ECALL
+/// reads host state; checkpoints are written between run() batches and copy only pages
+/// dirtied since the previous checkpoint.
+/// Note: Inputs are matched by order (source and number must agree), so the log needs
+/// no per-instruction counter; checkpoints carry the instruction count for seeking.
+/// Note: Single-hart only: SMP interleavings are host-scheduled and not logged.
+/// Note: Context switches a host scheduler makes between run() batches (Integration) are
+/// logged as switch records at their instruction count; replay loads the logged context
+/// there, so it never consults a kernel.
+///
+/// Log layout (integers are little-endian; varint = unsigned LEB128):
+///   header:     "XYRR", version u32, flags u32, memory_size u64, checkpoint_interval u64
+///   input:      TAG_INPUT, source u8, number varint, value varint
+///   checkpoint: TAG_CHECKPOINT, body_len varint, body
+///     body:     instret varint, inputs varint, pc u64, x1..x31 u64, satp u64,
+///               csr.State fields u64 (declaration order: trap CSRs, mtime, mtimecmp),
+///               page_count varint, page_count × (index << 1 | zero varint, 4096 bytes unless zero)
+///   memory:     TAG_MEMORY, addr varint, len varint, len bytes
+///               (a syscall handler's store into guest RAM; precedes that syscall's input,
+///               or the switch record of the scheduling point that made it)
+///   switch:     TAG_SWITCH, instret varint, process varint, pc u64, x1..x31 u64, mtime u64
+///               (context the host put on the CPU at instruction count instret;
+///               process 0: no process left, the host stopped the VM)
+///   end:        TAG_END, instret varint
+
+pub const MAGIC = "XYRR".*;
+pub const VERSION: u32 = 4;
+/// Default instructions between checkpoints (seek cost is at most this many instructions).
+pub const DEFAULT_CHECKPOINT_INTERVAL: u64 = 1 << 20;
+
+const TAG_INPUT: u8 = 1;
+const TAG_CHECKPOINT: u8 = 2;
+const TAG_END: u8 = 3;
+const TAG_MEMORY: u8 = 4;
+const TAG_SWITCH: u8 = 5;
+const HEADER_SIZE: usize = 4 + 4 + 4 + 8 + 8;
+/// Header flag: the recorded VM had a syscall handler (its ECALLs >= 10 were logged).
+const FLAG_SYSCALL_HANDLER: u32 = 1 << 0;
+/// Trap CSR and timer words in a checkpoint (every csr.State field is a u64).
+const CSR_FIELDS = std.meta.fields(vm_csr.State);
+/// Fixed part of a checkpoint body after the two varints (pc, x1..x31, satp, CSRs).
+const CHECKPOINT_REGS_SIZE: usize = 8 * (33 + CSR_FIELDS.len);
+/// Fixed part of a switch record after the two varints (pc, x1..x31, mtime).
+const SWITCH_REGS_SIZE: usize = 8 * 33;
+const MAX_VARINT_SIZE: usize = 10;
+
+pub const Error = error{
+    /// Log is truncated, corrupt or from another format version.
+    InvalidLog,
+    /// Replayed guest asked for a different input, or missed a checkpoint's state.
+    Diverged,
+    /// Seek target lies beyond the recorded run.
+    SeekBeyondEnd,
+    /// Appending to the log failed (see the writer's own error state).
+    WriteFailed,
+} || VM.InitError || std.mem.Allocator.Error;
+
+/// Origin of a logged host value.
+pub const Source = enum(u8) {
+    /// Kernel syscall result (VM.syscall_handler).
+    syscall,
+    /// SBI call result read from host state.
+    sbi,
+    /// Timer value read from the host clock.
+    timer,
+    /// Console input byte.
+    console,
+};
+
+/// Context a host scheduler put on the CPU (see the switch record).
+pub const Switch = struct {
+    /// Process now running (0: none left; the VM was stopped).
+    process: u64,
+    pc: u64,
+    /// x0..x31 (x0 is not logged and reads as 0).
+    regs: [32]u64,
+    /// Guest time after the switch (idling moves it forward).
+    mtime: u64,
+};
+
+/// VM-facing half of a Recorder or Replayer (VM.replay points here while attached).
+pub const Session = struct {
+    mode: Mode,
+    /// Record: log being appended to.
+    writer: ?*std.Io.Writer = null,
+    /// Replay: whole log, and offset of the next record to read.
+    log: []const u8 = &.{},
+    cursor: usize = 0,
+    /// Inputs logged or consumed so far.
+    inputs: u64 = 0,
+    /// Instructions the VM retired while attached (VM.run adds every batch).
+    instret: u64 = 0,
+    /// Record: memory records appended since the last input or switch record.
+    stores_pending: bool = false,
+    /// Record: an append failed (sticky; reported by Recorder.run / finish).
+    write_failed: bool = false,
+    /// Replay: the guest asked for an input the log does not hold next (sticky).
+    diverged: bool = false,
+    /// Replay: kernel syscalls were logged (without a handler they halted the recorded run).
+    syscalls_logged: bool = true,
+    /// Replay: VM that logged syscall stores are applied to (set while attached).
+    vm: ?*VM = null,
+
+    pub const Mode = enum { record, replay };
+
+    /// Record mode: append the value the host produced for (source, number).
+    pub fn record_input(self: *Session, source: Source, number: u64, value: u64) void {
+        if (self.mode != .record) return;
+        const writer = self.writer.?;
+        write_input(writer, source, number, value) catch {
+            self.write_failed = true;
+        };
+        self.inputs += 1;
+        self.stores_pending = false;
+    }
+
+    /// Record mode: append the context a host scheduler put on the CPU at this
+    /// instruction count (with any kernel stores made at that scheduling point).
+    pub fn record_switch(self: *Session, context: *const Switch) void {
+        if (self.mode != .record) return;
+        const writer = self.writer.?;
+        write_switch(writer, self.instret, context) catch {
+            self.write_failed = true;
+        };
+        self.stores_pending = false;
+    }
+
+    /// Replay mode: instruction count of the next logged switch (null: none left, or
+    /// record mode). Inputs and stores ahead of it are left for the guest to consume.
+    pub fn next_switch(self: *const Session) ?u64 {
+        if (self.mode != .replay or self.diverged) return null;
+        var reader = LogReader{ .data = self.log, .pos = self.cursor };
+        while (true) {
+            const tag = reader.byte() catch return null;
+            switch (tag) {
+                TAG_INPUT => {
+                    _ = reader.byte() catch return null;
+                    _ = reader.varint() catch return null;
+                    _ = reader.varint() catch return null;
+                },
+                TAG_MEMORY => {
+                    _ = reader.varint() catch return null;
+                    const len = reader.varint() catch return null;
+                    reader.skip(len) catch return null;
+                },
+                TAG_CHECKPOINT => {
+                    const body_len = reader.varint() catch return null;
+                    reader.skip(body_len) catch return null;
+                },
+                TAG_SWITCH => return reader.varint() catch null,
+                else => return null,
+            }
+        }
+    }
+
+    /// Replay mode: consume the switch logged at the current instruction count, applying
+    /// the kernel stores logged ahead of it to vm.
+    /// Note: Anything else next (an input the guest did not ask for) marks the session
+    /// diverged and returns null.
+    pub fn take_switch(self: *Session) ?Switch {
+        if (self.mode != .replay or self.diverged) return null;
+        var reader = LogReader{ .data = self.log, .pos = self.cursor };
+        while (true) {
+            const tag = reader.byte() catch break;
+            switch (tag) {
+                TAG_CHECKPOINT => {
+                    const body_len = reader.varint() catch break;
+                    reader.skip(body_len) catch break;
+                },
+                TAG_MEMORY => {
+                    const addr = reader.varint() catch break;
+                    const len = reader.varint() catch break;
+                    const bytes = reader.take(len) catch break;
+                    const vm = self.vm orelse break;
+                    vm.write_memory(addr, bytes) catch break;
+                },
+                TAG_SWITCH => {
+                    const instret = reader.varint() catch break;
+                    if (instret != self.instret) break;
+                    var context = Switch{ .process = reader.varint() catch break, .pc = 0, .regs = [_]u64{0} ** 32, .mtime = 0 };
+                    const regs = reader.take(SWITCH_REGS_SIZE) catch break;
+                    context.pc = std.mem.readInt(u64, regs[0..8], .little);
+                    for (context.regs[1..], 1..) |*reg, slot| {
+                        reg.* = std.mem.readInt(u64, regs[slot * 8 ..][0..8], .little);
+                    }
+                    context.mtime = std.mem.readInt(u64, regs[32 * 8 ..][0..8], .little);
+                    self.cursor = reader.pos;
+                    return context;
+                },
+                else => break,
+            }
+        }
+        self.diverged = true;
+        return null;
+    }
+
+    /// Record mode: append bytes a syscall handler stored into guest RAM at addr.
+    /// Why: Replay never calls the handler, so its stores must come from the log.
+    pub fn record_memory(self: *Session, addr: u64, bytes: []const u8) void {
+        if (self.mode != .record) return;
+        const writer = self.writer.?;
+        write_memory_record(writer, addr, bytes) catch {
+            self.write_failed = true;
+        };
+        self.stores_pending = true;
+    }
+
+    /// Replay mode: the logged value for (source, number), or null in record mode.
+    /// Note: Logged syscall stores ahead of a syscall input are applied to vm first.
+    /// Note: A mismatch or exhausted log marks the session diverged and returns null
+    /// (the VM then falls back to its live host hooks).
+    pub fn replay_input(self: *Session, source: Source, number: u64) ?u64 {
+        if (self.mode != .replay or self.diverged) return null;
+        if (source == .syscall and !self.syscalls_logged) return null;
+        var reader = LogReader{ .data = self.log, .pos = self.cursor };
+        while (true) {
+            const tag = reader.byte() catch break;
+            switch (tag) {
+                TAG_CHECKPOINT => {
+                    const body_len = reader.varint() catch break;
+                    reader.skip(body_len) catch break;
+                },
+                TAG_MEMORY => {
+                    const addr = reader.varint() catch break;
+                    const len = reader.varint() catch break;
+                    const bytes = reader.take(len) catch break;
+                    if (source != .syscall) break;
+                    const vm = self.vm orelse break;
+                    vm.write_memory(addr, bytes) catch break;
+                },
+                TAG_INPUT => {
+                    const logged_source = reader.byte() catch break;
+                    const logged_number = reader.varint() catch break;
+                    const value = reader.varint() catch break;
+                    if (logged_source != @intFromEnum(source) or logged_number != number) break;
+                    self.cursor = reader.pos;
+                    self.inputs += 1;
+                    return value;
+                },
+                else => break,
+            }
+        }
+        self.diverged = true;
+        return null;
+    }
+};
+
+/// Appends a run's inputs and checkpoints to a log.
+pub const Recorder = struct {
+    session: Session = .{ .mode = .record },
+    writer: *std.Io.Writer,
+    checkpoint_interval: u64,
+    /// Instruction count of the next checkpoint (session.instret counts since recording began).
+    next_checkpoint: u64,
+
+    const Self = @This();
+
+    pub const Options = struct {
+        checkpoint_interval: u64 = DEFAULT_CHECKPOINT_INTERVAL,
+    };
+
+    /// Start recording vm into writer (header and a full checkpoint are written now).
+    /// Contract: vm is loaded, standalone (no SMP) and not already attached to a session;
+    /// its syscall handler (or lack of one) stays as is; target must not move until finish().
+    /// Note: Checkpoints consume the VM's dirty-page set, so snapshots taken before
+    /// recording can no longer be restored.
+    /// Errors: WriteFailed if the header or first checkpoint cannot be appended.
+    pub fn init(target: *Self, vm: *VM, writer: *std.Io.Writer, options: Options) Error!void {
+        std.debug.assert(options.checkpoint_interval > 0);
+        std.debug.assert(vm.smp == null);
+        std.debug.assert(vm.replay == null);
+
+        target.* = .{
+            .writer = writer,
+            .checkpoint_interval = options.checkpoint_interval,
+            .next_checkpoint = options.checkpoint_interval,
+        };
+        target.session.writer = writer;
+
+        var header: [HEADER_SIZE]u8 = undefined;
+        @memcpy(header[0..4], &MAGIC);
+        std.mem.writeInt(u32, header[4..8], VERSION, .little);
+        std.mem.writeInt(u32, header[8..12], if (vm.syscall_handler != null) FLAG_SYSCALL_HANDLER else 0, .little);
+        std.mem.writeInt(u64, header[12..20], vm.memory_size, .little);
+        std.mem.writeInt(u64, header[20..28], options.checkpoint_interval, .little);
+        writer.writeAll(&header) catch return error.WriteFailed;
+        // Loader and host writes are not dirty-tracked: the first checkpoint scans all RAM.
+        try target.write_checkpoint(vm, true);
+
+        vm.replay = &target.session;
+    }
+
+    /// Run vm like VM.run, checkpointing every checkpoint_interval instructions.
+    /// Errors: WriteFailed if an input or checkpoint could not be appended.
+    pub fn run(self: *Self, vm: *VM, max_instructions: u64) Error!VM.RunResult {
+        std.debug.assert(max_instructions > 0);
+        std.debug.assert(vm.replay == &self.session);
+
+        var total = VM.RunResult{ .exit = .budget_exhausted, .instructions = 0 };
+        while (total.instructions < max_instructions) {
+            const limit = @min(max_instructions - total.instructions, self.next_checkpoint - self.session.instret);
+            const batch = vm.run(.{ .max_instructions = limit });
+            total.instructions += batch.instructions;
+            total.exit = batch.exit;
+            if (self.session.write_failed) return error.WriteFailed;
+
+            if (self.session.instret == self.next_checkpoint) {
+                // A halted or faulted guest has nothing left to seek into.
+                if (vm.state == .running) try self.write_checkpoint(vm, false);
+                self.next_checkpoint += self.checkpoint_interval;
+            }
+            switch (batch.exit) {
+                .budget_exhausted, .wait => {},
+                .ecall, .halted, .fault => break,
+            }
+        }
+        return total;
+    }
+
+    /// Append the end record, flush, and detach from vm.
+    /// Errors: WriteFailed if the log could not be completed.
+    pub fn finish(self: *Self, vm: *VM) Error!void {
+        std.debug.assert(vm.replay == &self.session);
+        vm.replay = null;
+        if (self.session.write_failed) return error.WriteFailed;
+
+        self.writer.writeByte(TAG_END) catch return error.WriteFailed;
+        write_varint(self.writer, self.session.instret) catch return error.WriteFailed;
+        self.writer.flush() catch return error.WriteFailed;
+    }
+
+    /// Append registers and the pages written since the previous checkpoint.
+    fn write_checkpoint(self: *Self, vm: *VM, full: bool) Error!void {
+        // Pass 1: list pages and size the body (so replay can skip it in O(1)).
+        var page_count: u64 = 0;
+        var body_len: u64 = varint_size(self.session.instret) + varint_size(self.session.inputs) + CHECKPOINT_REGS_SIZE;
+        var pages = CheckpointPages.init(vm, full);
+        while (pages.next()) |page| {
+            const zero = pages.is_zero(page);
+            page_count += 1;
+            body_len += varint_size(page_key(page, zero));
+            if (!zero) body_len += PAGE_SIZE;
+        }
+        body_len += varint_size(page_count);
+
+        // Pass 2: write.
+        const writer = self.writer;
+        self.write_checkpoint_body(vm, writer, full, body_len, page_count) catch return error.WriteFailed;
+        vm.reset_dirty_pages();
+    }
+
+    fn write_checkpoint_body(self: *Self, vm: *VM, writer: *std.Io.Writer, full: bool, body_len: u64, page_count: u64) std.Io.Writer.Error!void {
+        try writer.writeByte(TAG_CHECKPOINT);
+        try write_varint(writer, body_len);
+        try write_varint(writer, self.session.instret);
+        try write_varint(writer, self.session.inputs);
+        try writer.writeInt(u64, vm.regs.pc, .little);
+        for (vm.regs.regs[1..]) |reg| {
+            try writer.writeInt(u64, reg, .little);
+        }
+        try writer.writeInt(u64, vm.satp, .little);
+        inline for (CSR_FIELDS) |field| {
+            try writer.writeInt(u64, @field(vm.csrs, field.name), .little);
+        }
+        try write_varint(writer, page_count);
+        var pages = CheckpointPages.init(vm, full);
+        while (pages.next()) |page| {
+            const zero = pages.is_zero(page);
+            try write_varint(writer, page_key(page, zero));
+            if (!zero) try writer.writeAll(pages.bytes(page));
+        }
+    }
+};
+
+/// Replays a recorded log into a VM, with seeking by checkpoint.
+pub const Replayer = struct {
+    allocator: std.mem.Allocator,
+    session: Session = .{ .mode = .replay },
+    memory_size: u64,
+    /// Checkpoints in log order (instret strictly increasing).
+    checkpoints: []Checkpoint,
+    /// Instruction count of the end record (null if the recording was cut short).
+    end_instret: ?u64,
+    /// Index of the next checkpoint run() will verify.
+    next_checkpoint: usize = 0,
+    /// Instruction count of the next logged context switch (null: none left).
+    /// Note: session.instret is the position of vm in the log.
+    switch_at: ?u64 = null,
+
+    const Self = @This();
+
+    pub const Checkpoint = struct {
+        instret: u64,
+        inputs: u64,
+        /// Body bytes (see log layout).
+        body: []const u8,
+        /// Log offset just past this checkpoint (where its inputs start).
+        cursor: usize,
+    };
+
+    /// Index log (not copied; must outlive the replayer) for replay into VMs.
+    /// Errors: InvalidLog if the header or any record is malformed.
+    pub fn init(target: *Self, allocator: std.mem.Allocator, log: []const u8) Error!void {
+        if (log.len < HEADER_SIZE or !std.mem.eql(u8, log[0..4], &MAGIC)) return error.InvalidLog;
+        if (std.mem.readInt(u32, log[4..8], .little) != VERSION) return error.InvalidLog;
+
+        // Count checkpoints, then index them.
+        var count: usize = 0;
+        var end_instret: ?u64 = null;
+        try scan(log, null, &count, &end_instret);
+        if (count == 0) return error.InvalidLog;
+        const checkpoints = try allocator.alloc(Checkpoint, count);
+        errdefer allocator.free(checkpoints);
+        var filled: usize = 0;
+        try scan(log, checkpoints, &filled, &end_instret);
+        std.debug.assert(filled == count);
+
+        target.* = .{
+            .allocator = allocator,
+            .memory_size = std.mem.readInt(u64, log[12..20], .little),
+            .checkpoints = checkpoints,
+            .end_instret = end_instret,
+        };
+        target.session.log = log;
+        target.session.cursor = HEADER_SIZE;
+        target.session.syscalls_logged = std.mem.readInt(u32, log[8..12], .little) & FLAG_SYSCALL_HANDLER != 0;
+    }
+
+    pub fn deinit(self: *Self) void {
+        self.allocator.free(self.checkpoints);
+        self.* = undefined;
+    }
+
+    /// Put vm at instruction count target: restore the nearest checkpoint at or before
+    /// it, then replay forward. vm is left running and attached to this replayer.
+    /// Contract: vm is standalone, owns its RAM, and has the recorded memory size.
+    /// Errors: SeekBeyondEnd past the recorded run; Diverged if replay disagrees with the log.
+    pub fn seek(self: *Self, vm: *VM, target: u64) Error!void {
+        std.debug.assert(vm.smp == null);
+        if (vm.memory_size != self.memory_size) return error.InvalidLog;
+        if (self.end_instret) |end| {
+            if (target > end) return error.SeekBeyondEnd;
+        }
+
+        var index: usize = 0;
+        while (index + 1 < self.checkpoints.len and self.checkpoints[index + 1].instret <= target) {
+            index += 1;
+        }
+        try self.restore(vm, index);
+
+        if (target > self.session.instret) {
+            _ = try self.run(vm, target - self.session.instret);
+        }
+        if (self.session.instret != target) return error.SeekBeyondEnd;
+    }
+
+    /// Replay up to max_instructions like VM.run, checking state at every checkpoint and
+    /// loading the logged context at every context switch.
+    /// Contract: vm was positioned by seek().
+    /// Errors: Diverged if the guest asks for an unlogged input, misses a checkpoint, or
+    /// runs past a logged context switch.
+    pub fn run(self: *Self, vm: *VM, max_instructions: u64) Error!VM.RunResult {
+        std.debug.assert(max_instructions > 0);
+        std.debug.assert(vm.replay == &self.session);
+
+        var total = VM.RunResult{ .exit = .budget_exhausted, .instructions = 0 };
+        while (total.instructions < max_instructions) {
+            if (self.switch_at) |at| {
+                if (at < self.session.instret) return error.Diverged;
+                if (at == self.session.instret) {
+                    const context = self.session.take_switch() orelse return error.Diverged;
+                    apply_switch(vm, &context);
+                    self.switch_at = self.session.next_switch();
+                    if (vm.state != .running) {
+                        total.exit = .halted;
+                        break;
+                    }
+                    continue;
+                }
+            }
+            var limit = max_instructions - total.instructions;
+            if (self.next_checkpoint < self.checkpoints.len) {
+                limit = @min(limit, self.checkpoints[self.next_checkpoint].instret - self.session.instret);
+            }
+            if (self.switch_at) |at| limit = @min(limit, at - self.session.instret);
+            const batch = vm.run(.{ .max_instructions = limit });
+            total.instructions += batch.instructions;
+            total.exit = batch.exit;
+            if (self.session.diverged) return error.Diverged;
+
+            if (self.next_checkpoint < self.checkpoints.len and
+                self.session.instret == self.checkpoints[self.next_checkpoint].instret)
+            {
+                const checkpoint = &self.checkpoints[self.next_checkpoint];
+                if (!checkpoint_matches(checkpoint, vm, self.session.inputs)) return error.Diverged;
+                self.next_checkpoint += 1;
+            }
+            switch (batch.exit) {
+                .budget_exhausted, .wait => {},
+                .ecall, .halted, .fault => break,
+            }
+        }
+        return total;
+    }
+
+    /// Rebuild RAM and registers as of checkpoint index (pages of every earlier checkpoint
+    /// first, since each holds only the pages dirtied after its predecessor).
+    fn restore(self: *Self, vm: *VM, index: usize) Error!void {
+        std.debug.assert(index < self.checkpoints.len);
+        vm.replay = null;
+        try vm.reset();
+
+        for (self.checkpoints[0 .. index + 1]) |*checkpoint| {
+            var reader = LogReader{ .data = checkpoint.body, .pos = 0 };
+            apply_checkpoint(&reader, vm) catch return error.InvalidLog;
+        }
+        vm.start();
+
+        const checkpoint = &self.checkpoints[index];
+        self.next_checkpoint = index + 1;
+        self.session.instret = checkpoint.instret;
+        self.session.cursor = checkpoint.cursor;
+        self.session.inputs = checkpoint.inputs;
+        self.session.diverged = false;
+        self.session.vm = vm;
+        self.switch_at = self.session.next_switch();
+        vm.replay = &self.session;
+
+        // Assert: vm must be exactly at the checkpoint.
+        std.debug.assert(checkpoint_matches(checkpoint, vm, self.session.inputs));
+    }
+
+    /// Walk every record; index checkpoints into out (or only count them if out is null).
+    fn scan(log: []const u8, out: ?[]Checkpoint, count: *usize, end_instret: *?u64) Error!void {
+        var reader = LogReader{ .data = log, .pos = HEADER_SIZE };
+        count.* = 0;
+        var last_instret: ?u64 = null;
+        while (reader.pos < log.len) {
+            const tag = reader.byte() catch return error.InvalidLog;
+            switch (tag) {
+                TAG_INPUT => {
+                    _ = reader.byte() catch return error.InvalidLog;
+                    _ = reader.varint() catch return error.InvalidLog;
+                    _ = reader.varint() catch return error.InvalidLog;
+                },
+                TAG_MEMORY => {
+                    _ = reader.varint() catch return error.InvalidLog;
+                    const len = reader.varint() catch return error.InvalidLog;
+                    reader.skip(len) catch return error.InvalidLog;
+                },
+                TAG_SWITCH => {
+                    _ = reader.varint() catch return error.InvalidLog;
+                    _ = reader.varint() catch return error.InvalidLog;
+                    reader.skip(SWITCH_REGS_SIZE) catch return error.InvalidLog;
+                },
+                TAG_CHECKPOINT => {
+                    const body_len = reader.varint() catch return error.InvalidLog;
+                    const body = reader.take(body_len) catch return error.InvalidLog;
+                    var body_reader = LogReader{ .data = body, .pos = 0 };
+                    const instret = body_reader.varint() catch return error.InvalidLog;
+                    const inputs = body_reader.varint() catch return error.InvalidLog;
+                    if (last_instret) |last| {
+                        if (instret <= last) return error.InvalidLog;
+                    }
+                    last_instret = instret;
+                    if (out) |checkpoints| {
+                        checkpoints[count.*] = .{ .instret = instret, .inputs = inputs, .body = body, .cursor = reader.pos };
+                    }
+                    count.* += 1;
+                },
+                TAG_END => {
+                    end_instret.* = reader.varint() catch return error.InvalidLog;
+                    return;
+                },
+                else => return error.InvalidLog,
+            }
+        }
+    }
+};
+
+/// Pages a checkpoint holds: every non-zero page (full) or every dirty page.
+const CheckpointPages = struct {
+    vm: *VM,
+    full: bool,
+    dirty: std.DynamicBitSetUnmanaged.Iterator(.{}),
+    page: usize = 0,
+
+    fn init(vm: *VM, full: bool) CheckpointPages {
+        return .{ .vm = vm, .full = full, .dirty = vm.dirty_pages.iterator(.{}) };
+    }
+
+    fn next(self: *CheckpointPages) ?usize {
+        if (!self.full) return self.dirty.next();
+        const page_total = self.vm.memory_size / PAGE_SIZE;
+        while (self.page < page_total) {
+            const page = self.page;
+            self.page += 1;
+            if (!self.is_zero(page)) return page;
+        }
+        return null;
+    }
+
+    fn bytes(self: *const CheckpointPages, page: usize) []const u8 {
+        return self.vm.memory[page * PAGE_SIZE ..][0..PAGE_SIZE];
+    }
+
+    fn is_zero(self: *const CheckpointPages, page: usize) bool {
+        return std.mem.allEqual(u8, self.bytes(page), 0);
+    }
+};
+
+const zero_page = [_]u8{0} ** PAGE_SIZE;
+
+fn page_key(page: usize, zero: bool) u64 {
+    return (@as(u64, page) << 1) | @intFromBool(zero);
+}
+
+/// Load one checkpoint body into vm (pages, then registers, satp and CSRs).
+fn apply_checkpoint(reader: *LogReader, vm: *VM) (error{InvalidLog} || VM.VMError)!void {
+    _ = try reader.varint();
+    _ = try reader.varint();
+    const regs = try reader.take(CHECKPOINT_REGS_SIZE);
+    const page_count = try reader.varint();
+    var index: u64 = 0;
+    while (index < page_count) : (index += 1) {
+        const key = try reader.varint();
+        const addr = (key >> 1) * PAGE_SIZE;
+        const bytes = if (key & 1 != 0) &zero_page else (try reader.take(PAGE_SIZE))[0..PAGE_SIZE];
+        try vm.write_memory(addr, bytes);
+    }
+    if (reader.pos != reader.data.len) return error.InvalidLog;
+
+    vm.regs.pc = std.mem.readInt(u64, regs[0..8], .little);
+    for (vm.regs.regs[1..], 1..) |*reg, slot| {
+        reg.* = std.mem.readInt(u64, regs[slot * 8 ..][0..8], .little);
+    }
+    const satp = std.mem.readInt(u64, regs[32 * 8 ..][0..8], .little);
+    if (!vm_mmu.valid_satp(satp)) return error.InvalidLog;
+    vm.set_satp(satp);
+    vm.set_csrs(read_csrs(regs));
+}
+
+/// Load a logged context switch into vm (a process 0 switch stops it).
+fn apply_switch(vm: *VM, context: *const Switch) void {
+    vm.regs.pc = context.pc;
+    vm.regs.regs = context.regs;
+    vm.csrs.mtime = context.mtime;
+    if (context.process == 0) vm.stop();
+
+    // Assert: x0 must stay hardwired to zero.
+    std.debug.assert(vm.regs.regs[0] == 0);
+}
+
+/// Whether vm's registers and input count equal checkpoint's.
+fn checkpoint_matches(checkpoint: *const Replayer.Checkpoint, vm: *const VM, inputs: u64) bool {
+    if (checkpoint.inputs != inputs) return false;
+    var reader = LogReader{ .data = checkpoint.body, .pos = 0 };
+    _ = reader.varint() catch return false;
+    _ = reader.varint() catch return false;
+    const regs = reader.take(CHECKPOINT_REGS_SIZE) catch return false;
+    if (std.mem.readInt(u64, regs[0..8], .little) != vm.regs.pc) return false;
+    for (vm.regs.regs[1..], 1..) |reg, slot| {
+        if (std.mem.readInt(u64, regs[slot * 8 ..][0..8], .little) != reg) return false;
+    }
+    if (std.mem.readInt(u64, regs[32 * 8 ..][0..8], .little) != vm.satp) return false;
+    return std.meta.eql(read_csrs(regs), vm.csrs);
+}
+
+/// CSR words following satp in a checkpoint's fixed part.
+fn read_csrs(regs: []const u8) vm_csr.State {
+    std.debug.assert(regs.len == CHECKPOINT_REGS_SIZE);
+    var csrs: vm_csr.State = .{};
+    inline for (CSR_FIELDS, 0..) |field, index| {
+        comptime std.debug.assert(field.type == u64);
+        @field(csrs, field.name) = std.mem.readInt(u64, regs[(33 + index) * 8 ..][0..8], .little);
+    }
+    return csrs;
+}
+
+fn write_input(writer: *std.Io.Writer, source: Source, number: u64, value: u64) std.Io.Writer.Error!void {
+    try writer.writeByte(TAG_INPUT);
+    try writer.writeByte(@intFromEnum(source));
+    try write_varint(writer, number);
+    try write_varint(writer, value);
+}
+
+fn write_switch(writer: *std.Io.Writer, instret: u64, context: *const Switch) std.Io.Writer.Error!void {
+    try writer.writeByte(TAG_SWITCH);
+    try write_varint(writer, instret);
+    try write_varint(writer, context.process);
+    try writer.writeInt(u64, context.pc, .little);
+    for (context.regs[1..]) |reg| {
+        try writer.writeInt(u64, reg, .little);
+    }
+    try writer.writeInt(u64, context.mtime, .little);
+}
+
+fn write_memory_record(writer: *std.Io.Writer, addr: u64, bytes: []const u8) std.Io.Writer.Error!void {
+    try writer.writeByte(TAG_MEMORY);
+    try write_varint(writer, addr);
+    try write_varint(writer, bytes.len);
+    try writer.writeAll(bytes);
+}
+
+fn write_varint(writer: *std.Io.Writer, value: u64) std.Io.Writer.Error!void {
+    var bytes: [MAX_VARINT_SIZE]u8 = undefined;
+    var len: usize = 0;
+    var rest = value;
+    while (true) {
+        const low: u8 = @truncate(rest & 0x7F);
+        rest >>= 7;
+        if (rest == 0) {
+            bytes[len] = low;
+            len += 1;
+            break;
+        }
+        bytes[len] = low | 0x80;
+        len += 1;
+    }
+    try writer.writeAll(bytes[0..len]);
+}
+
+fn varint_size(value: u64) u64 {
+    var size: u64 = 1;
+    var rest = value >> 7;
+    while (rest != 0) : (rest >>= 7) {
+        size += 1;
+    }
+    return size;
+}
+
+/// Bounds-checked cursor over log bytes.
+const LogReader = struct {
+    data: []const u8,
+    pos: usize,
+
+    fn byte(self: *LogReader) error{InvalidLog}!u8 {
+        if (self.pos >= self.data.len) return error.InvalidLog;
+        self.pos += 1;
+        return self.data[self.pos - 1];
+    }
+
+    fn varint(self: *LogReader) error{InvalidLog}!u64 {
+        var value: u64 = 0;
+        var shift: u32 = 0;
+        while (shift < 64) : (shift += 7) {
+            const next = try self.byte();
+            value |= @as(u64, next & 0x7F) << @intCast(shift);
+            if (next & 0x80 == 0) return value;
+        }
+        return error.InvalidLog;
+    }
+
+    fn take(self: *LogReader, len: u64) error{InvalidLog}![]const u8 {
+        if (len > self.data.len - self.pos) return error.InvalidLog;
+        const start = self.pos;
+        self.pos += @intCast(len);
+        return self.data[start..self.pos];
+    }
+
+    fn skip(self: *LogReader, len: u64) error{InvalidLog}!void {
+        _ = try self.take(len);
+    }
+};
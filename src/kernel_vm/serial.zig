@@ -68,6 +68,30 @@ pub const SerialOutput = struct {
         std.debug.assert(self.total_written == old_total_written + 1);
     }
 
+    /// Write bytes to serial output (same result as writeByte per byte).
+    /// Why: virtio-console hands over whole buffers; checking once per call instead of
+    /// once per byte keeps console-heavy guests out of the assertions.
+    pub fn writeBytes(self: *Self, bytes: []const u8) void {
+        // Assert: write position must be within buffer bounds.
+        std.debug.assert(self.write_pos < SERIAL_BUFFER_SIZE);
+
+        const old_write_pos = self.write_pos;
+        const old_total_written = self.total_written;
+
+        // Only the last buffer-full can survive; earlier bytes still advance the position.
+        const kept = if (bytes.len > SERIAL_BUFFER_SIZE) bytes[bytes.len - SERIAL_BUFFER_SIZE ..] else bytes;
+        const start = (self.write_pos + (bytes.len - kept.len)) % SERIAL_BUFFER_SIZE;
+        const first = @min(kept.len, SERIAL_BUFFER_SIZE - start);
+        @memcpy(self.buffer[start..][0..first], kept[0..first]);
+        @memcpy(self.buffer[0 .. kept.len - first], kept[first..]);
+        self.write_pos = (start + kept.len) % SERIAL_BUFFER_SIZE;
+        self.total_written += bytes.len;
+
+        // Assert: position must advance by bytes.len (mod buffer size), total by bytes.len.
+        std.debug.assert(self.write_pos == (old_write_pos + bytes.len) % SERIAL_BUFFER_SIZE);
+        std.debug.assert(self.total_written == old_total_written + bytes.len);
+    }
+
     /// Write string to serial output.
     /// Why: Handle kernel string output (e.g., printf format strings).
     pub fn writeString(self: *Self, str: []const u8) void {
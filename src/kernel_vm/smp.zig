@@ -0,0 +1,308 @@
+const std = @import("std");
+const VM = @import("vm.zig").VM;
+const vm_csr = @import("csr.zig");
+
+/// Multi-hart (SMP) machine: harts share one guest RAM, each runs on its own host thread.
+/// Grain Style: Fixed hart table, in-place init, threads exist only inside run().
+/// ~<~ Glow Airbend: harts drift independently and meet only at atomics and IPIs.
+///
+/// Why: Basin kernel scheduling needs more than one hart to test, and one host
+/// thread per hart lets emulation throughput scale with host cores.
+/// Note: Hart 0 is the caller's boot VM (loaded as usual). Secondary harts share its
+/// RAM, start at its PC with a copy of its registers, and every hart gets a0 = hart ID
+/// (SBI boot convention) so the guest can pick per-hart stacks.
+/// Note: Harts keep private decode caches and JIT arenas. A hart's stores invalidate only
+/// its own caches; code patched for another hart needs FENCE.I there or SBI REMOTE_FENCE_I
+/// (honoured at the target's next batch boundary). Sv39 TLBs are per hart too:
+/// page-table edits for another hart need SBI REMOTE_SFENCE_VMA.
+/// Note: Harts keep private virtual clocks (csr.State.mtime), synchronized through
+/// `clock` at batch boundaries. A WFI with a timer armed parks like any other; once
+/// every hart is parked or halted, time jumps to the earliest deadline and that hart wakes.
+/// Note: Kernel syscalls, console output and virtio registers go through host state shared
+/// by all harts, so they serialize on `lock`; plain loads/stores and AMOs run unlocked.
+
+/// Most harts per machine (SBI legacy hart masks are one u64).
+pub const MAX_HARTS: u32 = 64;
+/// Instructions per VM.run() batch (bounds shutdown and remote-fence latency).
+pub const BATCH_INSTRUCTIONS: u64 = 1 << 16;
+/// Longest a WFI parks a hart without an IPI (WFI may complete at any time).
+pub const PARK_TIMEOUT_NS: u64 = std.time.ns_per_ms;
+
+pub const Error = VM.InitError || std.mem.Allocator.Error || std.Thread.SpawnError;
+
+/// Outcome of one hart in run().
+pub const HartResult = struct {
+    /// budget_exhausted, halted (exit or shutdown) or fault (see the hart's last_error).
+    exit: VM.RunExit,
+    /// Instructions the hart retired during this run().
+    instructions: u64,
+};
+
+/// Cross-hart signalling state for one hart.
+const HartLink = struct {
+    /// Set by SEND_IPI, cleared by CLEAR_IPI.
+    ipi_pending: std.atomic.Value(bool) = .init(false),
+    /// Set by REMOTE_FENCE_I, consumed at the hart's next batch.
+    fence_i_pending: std.atomic.Value(bool) = .init(false),
+    /// Set by REMOTE_SFENCE_VMA, consumed at the hart's next batch.
+    sfence_vma_pending: std.atomic.Value(bool) = .init(false),
+    /// Futex word, bumped on every wake-up so a parked hart cannot miss one.
+    wake_seq: std.atomic.Value(u32) = .init(0),
+    /// Timer deadline while parked in WFI (NO_DEADLINE when running or not waiting on a timer).
+    deadline: std.atomic.Value(u64) = .init(vm_csr.NO_DEADLINE),
+};
+
+pub const Smp = struct {
+    allocator: std.mem.Allocator,
+    /// Harts by ID (harts[0] is the caller's boot VM, the rest are owned).
+    harts: [MAX_HARTS]*VM = undefined,
+    hart_count: u32 = 0,
+    links: [MAX_HARTS]HartLink = [_]HartLink{.{}} ** MAX_HARTS,
+    /// Serializes host state shared by harts (syscall handler, serial output).
+    lock: std.Thread.Mutex = .{},
+    /// Tells hart threads to return at their next batch boundary.
+    stopping: std.atomic.Value(bool) = .init(false),
+    /// SBI SHUTDOWN seen on some hart (every hart halts).
+    shutdown_requested: std.atomic.Value(bool) = .init(false),
+    /// Machine virtual time: the latest mtime any hart has published.
+    clock: std.atomic.Value(u64) = .init(0),
+    /// Harts parked in WFI or finished (all of them idle allows a time jump).
+    idle_harts: std.atomic.Value(u32) = .init(0),
+    results: [MAX_HARTS]HartResult = undefined,
+
+    const Self = @This();
+
+    /// Build machine around boot (hart 0) in place; secondary harts share its RAM.
+    /// Contract: boot is initialized and loaded, not part of another machine, and owns its RAM.
+    /// Contract: target must not move while the machine exists (harts point back to it).
+    /// Errors: GuestMemoryUnavailable / OutOfMemory if a secondary hart cannot be created.
+    pub fn init(target: *Self, allocator: std.mem.Allocator, boot: *VM, hart_count: u32) Error!void {
+        std.debug.assert(hart_count >= 1 and hart_count <= MAX_HARTS);
+        std.debug.assert(boot.smp == null);
+        std.debug.assert(boot.owns_memory);
+
+        target.* = .{ .allocator = allocator };
+        errdefer target.deinit();
+
+        boot.smp = target;
+        boot.hart_id = 0;
+        boot.regs.set(10, 0);
+        target.harts[0] = boot;
+        target.hart_count = 1;
+
+        var hart_id: u32 = 1;
+        while (hart_id < hart_count) : (hart_id += 1) {
+            const hart = try allocator.create(VM);
+            errdefer allocator.destroy(hart);
+            try VM.init_with_options(hart, &[_]u8{}, 0, .{
+                .execution_mode = boot.active_execution_mode(),
+                .memory_size = boot.memory_size,
+                .shared_memory = boot.memory,
+            });
+            hart.regs = boot.regs;
+            hart.regs.set(10, hart_id);
+            hart.set_csrs(boot.csrs);
+            hart.hart_id = hart_id;
+            hart.smp = target;
+            hart.syscall_handler = boot.syscall_handler;
+            hart.syscall_user_data = boot.syscall_user_data;
+            hart.serial_output = boot.serial_output;
+            hart.mmio = boot.mmio;
+            target.harts[hart_id] = hart;
+            target.hart_count += 1;
+        }
+
+        // Assert: every hart must see the same RAM.
+        for (target.harts[0..target.hart_count]) |hart| {
+            std.debug.assert(hart.memory.ptr == boot.memory.ptr);
+        }
+    }
+
+    /// Release secondary harts and detach the boot VM (which the caller still owns).
+    pub fn deinit(self: *Self) void {
+        if (self.hart_count > 0) {
+            for (self.harts[1..self.hart_count]) |hart| {
+                hart.deinit();
+                self.allocator.destroy(hart);
+            }
+            self.harts[0].smp = null;
+        }
+        self.* = undefined;
+    }
+
+    /// Put every hart in running state (see VM.start).
+    pub fn start(self: *Self) void {
+        for (self.harts[0..self.hart_count]) |hart| {
+            hart.start();
+        }
+        self.stopping.store(false, .release);
+        self.shutdown_requested.store(false, .release);
+    }
+
+    /// Run every hart on its own host thread (hart 0 on the calling thread) until each
+    /// one halts, faults or retires max_instructions_per_hart.
+    /// Note: A fault or SBI SHUTDOWN on any hart stops the others at their next batch.
+    /// Errors: SpawnError if a hart thread cannot be started (no hart has run then).
+    pub fn run(self: *Self, max_instructions_per_hart: u64) Error![]const HartResult {
+        std.debug.assert(max_instructions_per_hart > 0);
+        std.debug.assert(self.hart_count >= 1);
+
+        self.idle_harts.store(0, .release);
+        var threads: [MAX_HARTS]std.Thread = undefined;
+        var spawned: u32 = 0;
+        var hart_id: u32 = 1;
+        while (hart_id < self.hart_count) : (hart_id += 1) {
+            threads[spawned] = std.Thread.spawn(.{}, hart_main, .{ self, hart_id, max_instructions_per_hart }) catch |err| {
+                self.stop();
+                for (threads[0..spawned]) |thread| thread.join();
+                return err;
+            };
+            spawned += 1;
+        }
+        hart_main(self, 0, max_instructions_per_hart);
+        for (threads[0..spawned]) |thread| thread.join();
+
+        return self.results[0..self.hart_count];
+    }
+
+    /// One hart's thread: batches until done, parking on WFI.
+    fn hart_main(self: *Self, hart_id: u32, limit: u64) void {
+        const hart = self.harts[hart_id];
+        var result = HartResult{ .exit = .budget_exhausted, .instructions = 0 };
+        while (result.instructions < limit and !self.stopping.load(.acquire)) {
+            // Catch up with machine time (another hart may have run ahead or jumped it).
+            hart.csrs.mtime = @max(hart.csrs.mtime, self.clock.load(.acquire));
+            const batch = hart.run(.{ .max_instructions = @min(BATCH_INSTRUCTIONS, limit - result.instructions) });
+            _ = self.clock.fetchMax(hart.csrs.mtime, .acq_rel);
+            result.instructions += batch.instructions;
+            result.exit = batch.exit;
+            switch (batch.exit) {
+                .budget_exhausted, .ecall => {},
+                .wait => self.park(hart_id),
+                .halted => break,
+                .fault => {
+                    self.stop();
+                    break;
+                },
+            }
+        }
+
+        // A finished hart never wakes again: it counts as idle for time jumps.
+        self.mark_idle();
+
+        // Shutdown halts harts that were still running when it came.
+        if (self.shutdown_requested.load(.acquire) and hart.state == .running) {
+            hart.state = .halted;
+        }
+        if (result.exit == .wait or result.exit == .ecall or hart.state == .halted) {
+            result.exit = if (hart.state == .halted) .halted else .budget_exhausted;
+        }
+        self.results[hart_id] = result;
+    }
+
+    /// Park hart until an IPI, a stop, its timer deadline (see fast_forward), or PARK_TIMEOUT_NS.
+    fn park(self: *Self, hart_id: u32) void {
+        const link = &self.links[hart_id];
+        const seq = link.wake_seq.load(.acquire);
+        if (link.ipi_pending.load(.acquire) or self.stopping.load(.acquire)) return;
+
+        link.deadline.store(self.harts[hart_id].csrs.wake_deadline(), .release);
+        defer link.deadline.store(vm_csr.NO_DEADLINE, .release);
+        const idle = self.mark_idle();
+        defer _ = self.idle_harts.fetchSub(1, .acq_rel);
+        if (idle == self.hart_count and self.fast_forward(hart_id)) return;
+        std.Thread.Futex.timedWait(&link.wake_seq, seq, PARK_TIMEOUT_NS) catch {};
+    }
+
+    /// Count one more idle hart; returns the new idle count.
+    fn mark_idle(self: *Self) u32 {
+        const idle = self.idle_harts.fetchAdd(1, .acq_rel) + 1;
+        std.debug.assert(idle <= self.hart_count);
+        return idle;
+    }
+
+    /// Every hart is idle: advance machine time to the earliest parked deadline and
+    /// wake that hart. Returns whether it is caller (which then skips parking).
+    /// Why: Nothing can happen before that deadline, so idle time costs no host time.
+    fn fast_forward(self: *Self, caller: u32) bool {
+        var earliest: ?u32 = null;
+        var deadline: u64 = vm_csr.NO_DEADLINE;
+        for (self.links[0..self.hart_count], 0..) |*link, hart_id| {
+            const hart_deadline = link.deadline.load(.acquire);
+            if (hart_deadline < deadline) {
+                deadline = hart_deadline;
+                earliest = @intCast(hart_id);
+            }
+        }
+        const target = earliest orelse return false;
+        _ = self.clock.fetchMax(deadline, .acq_rel);
+        if (target == caller) return true;
+        self.wake(target);
+        return false;
+    }
+
+    /// Wake hart if parked (its next park re-checks pending state).
+    fn wake(self: *Self, hart_id: u32) void {
+        const link = &self.links[hart_id];
+        _ = link.wake_seq.fetchAdd(1, .release);
+        std.Thread.Futex.wake(&link.wake_seq, 1);
+    }
+
+    /// Stop every hart at its next batch boundary.
+    pub fn stop(self: *Self) void {
+        self.stopping.store(true, .release);
+        for (0..self.hart_count) |hart_id| {
+            self.wake(@intCast(hart_id));
+        }
+    }
+
+    /// SBI SHUTDOWN: halt the whole machine.
+    pub fn request_shutdown(self: *Self) void {
+        self.shutdown_requested.store(true, .release);
+        self.stop();
+    }
+
+    /// SBI SEND_IPI: mark IPI pending on every hart in mask and wake it.
+    /// Note: Mask bits beyond hart_count are ignored.
+    pub fn send_ipi(self: *Self, mask: u64) void {
+        for (0..self.hart_count) |hart_id| {
+            if (mask & (@as(u64, 1) << @intCast(hart_id)) == 0) continue;
+            self.links[hart_id].ipi_pending.store(true, .release);
+            self.wake(@intCast(hart_id));
+        }
+    }
+
+    /// SBI CLEAR_IPI: clear hart's pending IPI, returning whether one was pending.
+    pub fn clear_ipi(self: *Self, hart_id: u32) bool {
+        std.debug.assert(hart_id < self.hart_count);
+        return self.links[hart_id].ipi_pending.swap(false, .acq_rel);
+    }
+
+    /// SBI REMOTE_FENCE_I: harts in mask drop decodes and translated blocks at their next batch.
+    pub fn remote_fence_i(self: *Self, mask: u64) void {
+        for (0..self.hart_count) |hart_id| {
+            if (mask & (@as(u64, 1) << @intCast(hart_id)) == 0) continue;
+            self.links[hart_id].fence_i_pending.store(true, .release);
+        }
+    }
+
+    /// SBI REMOTE_SFENCE_VMA: harts in mask flush their TLB at their next batch.
+    pub fn remote_sfence_vma(self: *Self, mask: u64) void {
+        for (0..self.hart_count) |hart_id| {
+            if (mask & (@as(u64, 1) << @intCast(hart_id)) == 0) continue;
+            self.links[hart_id].sfence_vma_pending.store(true, .release);
+        }
+    }
+
+    /// Consume a pending remote SFENCE.VMA for hart (called by VM.run on its own thread).
+    pub fn take_sfence_vma(self: *Self, hart_id: u32) bool {
+        std.debug.assert(hart_id < self.hart_count);
+        return self.links[hart_id].sfence_vma_pending.swap(false, .acq_rel);
+    }
+
+    /// Consume a pending remote FENCE.I for hart (called by VM.run on its own thread).
+    pub fn take_fence_i(self: *Self, hart_id: u32) bool {
+        std.debug.assert(hart_id < self.hart_count);
+        return self.links[hart_id].fence_i_pending.swap(false, .acq_rel);
+    }
+};
@@ -3,6 +3,7 @@ const kernel_vm = @import("kernel_vm");
 const VM = kernel_vm.VM;
 const loadKernel = kernel_vm.loadKernel;
 const SerialOutput = kernel_vm.SerialOutput;
+const decode_reference = @import("decode_reference");
 
 /// Test RISC-V VM functionality.
 /// Grain Style: Comprehensive test coverage, deterministic behavior.
@@ -13,7 +14,8 @@ pub fn main() !void {
     std.debug.print("[kernel_vm_test] Test 1: VM initialization\n", .{});
     // GrainStyle: Use in-place initialization to avoid stack overflow.
     var vm: VM = undefined;
-    VM.init(&vm, &[_]u8{0x13, 0x00, 0x00, 0x00}, 0x1000); // NOP instruction.
+    try VM.init(&vm, &[_]u8{0x13, 0x00, 0x00, 0x00}, 0x1000); // NOP instruction.
+    defer vm.deinit();
     std.debug.assert(vm.regs.pc == 0x1000);
     std.debug.assert(vm.state == .halted);
     std.debug.print("[kernel_vm_test] ✓ VM initialized correctly\n", .{});
@@ -56,7 +58,7 @@ pub fn main() !void {
     // Add ECALL after to halt VM (0x00000073)
     const add_kernel = [_]u8{ 0xB3, 0x00, 0x31, 0x00, 0x73, 0x00, 0x00, 0x00 };
     // Reuse existing VM to avoid stack overflow (4MB array).
-    @memset(&vm.memory, 0);
+    @memset(vm.memory, 0);
     @memcpy(vm.memory[0x1000..][0..add_kernel.len], &add_kernel);
     vm.regs.pc = 0x1000;
     vm.state = .halted;
@@ -86,7 +88,7 @@ pub fn main() !void {
     // Add ECALL after to halt VM (0x00000073)
     const sub_kernel = [_]u8{ 0xB3, 0x00, 0x31, 0x40, 0x73, 0x00, 0x00, 0x00 };
     // Reuse existing VM to avoid stack overflow.
-    @memset(&vm.memory, 0);
+    @memset(vm.memory, 0);
     @memcpy(vm.memory[0x1000..][0..sub_kernel.len], &sub_kernel);
     vm.regs.pc = 0x1000;
     vm.state = .halted;
@@ -107,7 +109,7 @@ pub fn main() !void {
     // Add ECALL after to halt VM (0x00000073)
     const slt_kernel = [_]u8{ 0xB3, 0x20, 0x31, 0x00, 0x73, 0x00, 0x00, 0x00 };
     // Reuse existing VM to avoid stack overflow.
-    @memset(&vm.memory, 0);
+    @memset(vm.memory, 0);
     @memcpy(vm.memory[0x1000..][0..slt_kernel.len], &slt_kernel);
     vm.regs.pc = 0x1000;
     vm.state = .halted;
@@ -120,7 +122,7 @@ pub fn main() !void {
     std.debug.print("[kernel_vm_test] ✓ SLT instruction works (10 < 20)\n", .{});
 
     // Test SLT with reversed operands (should return 0).
-    @memset(&vm.memory, 0);
+    @memset(vm.memory, 0);
     @memcpy(vm.memory[0x1000..][0..slt_kernel.len], &slt_kernel);
     vm.regs.pc = 0x1000;
     vm.state = .halted;
@@ -133,7 +135,7 @@ pub fn main() !void {
     std.debug.print("[kernel_vm_test] ✓ SLT instruction works (20 < 10)\n", .{});
 
     // Test SLT with negative numbers (signed comparison).
-    @memset(&vm.memory, 0);
+    @memset(vm.memory, 0);
     @memcpy(vm.memory[0x1000..][0..slt_kernel.len], &slt_kernel);
     vm.regs.pc = 0x1000;
     vm.state = .halted;
@@ -153,7 +155,7 @@ pub fn main() !void {
     // Little-endian bytes: [0xB3, 0x60, 0x31, 0x00]
     // Add ECALL after to halt VM (0x00000073)
     const or_kernel = [_]u8{ 0xB3, 0x60, 0x31, 0x00, 0x73, 0x00, 0x00, 0x00 };
-    @memset(&vm.memory, 0);
+    @memset(vm.memory, 0);
     @memcpy(vm.memory[0x1000..][0..or_kernel.len], &or_kernel);
     vm.regs.pc = 0x1000;
     vm.state = .halted;
@@ -173,7 +175,7 @@ pub fn main() !void {
     // Little-endian bytes: [0xB3, 0x70, 0x31, 0x00]
     // Add ECALL after to halt VM (0x00000073)
     const and_kernel = [_]u8{ 0xB3, 0x70, 0x31, 0x00, 0x73, 0x00, 0x00, 0x00 };
-    @memset(&vm.memory, 0);
+    @memset(vm.memory, 0);
     @memcpy(vm.memory[0x1000..][0..and_kernel.len], &and_kernel);
     vm.regs.pc = 0x1000;
     vm.state = .halted;
@@ -193,7 +195,7 @@ pub fn main() !void {
     // Little-endian bytes: [0xB3, 0x40, 0x31, 0x00]
     // Add ECALL after to halt VM (0x00000073)
     const xor_kernel = [_]u8{ 0xB3, 0x40, 0x31, 0x00, 0x73, 0x00, 0x00, 0x00 };
-    @memset(&vm.memory, 0);
+    @memset(vm.memory, 0);
     @memcpy(vm.memory[0x1000..][0..xor_kernel.len], &xor_kernel);
     vm.regs.pc = 0x1000;
     vm.state = .halted;
@@ -213,7 +215,7 @@ pub fn main() !void {
     // Little-endian bytes: [0xB3, 0x10, 0x31, 0x00]
     // Add ECALL after to halt VM (0x00000073)
     const sll_kernel = [_]u8{ 0xB3, 0x10, 0x31, 0x00, 0x73, 0x00, 0x00, 0x00 };
-    @memset(&vm.memory, 0);
+    @memset(vm.memory, 0);
     @memcpy(vm.memory[0x1000..][0..sll_kernel.len], &sll_kernel);
     vm.regs.pc = 0x1000;
     vm.state = .halted;
@@ -233,7 +235,7 @@ pub fn main() !void {
     // Little-endian bytes: [0xB3, 0x50, 0x31, 0x00]
     // Add ECALL after to halt VM (0x00000073)
     const srl_kernel = [_]u8{ 0xB3, 0x50, 0x31, 0x00, 0x73, 0x00, 0x00, 0x00 };
-    @memset(&vm.memory, 0);
+    @memset(vm.memory, 0);
     @memcpy(vm.memory[0x1000..][0..srl_kernel.len], &srl_kernel);
     vm.regs.pc = 0x1000;
     vm.state = .halted;
@@ -253,7 +255,7 @@ pub fn main() !void {
     // Little-endian bytes: [0xB3, 0x50, 0x31, 0x40]
     // Add ECALL after to halt VM (0x00000073)
     const sra_kernel = [_]u8{ 0xB3, 0x50, 0x31, 0x40, 0x73, 0x00, 0x00, 0x00 };
-    @memset(&vm.memory, 0);
+    @memset(vm.memory, 0);
     @memcpy(vm.memory[0x1000..][0..sra_kernel.len], &sra_kernel);
     vm.regs.pc = 0x1000;
     vm.state = .halted;
@@ -265,6 +267,1213 @@ pub fn main() !void {
     std.debug.assert(sra_result == @as(u64, @bitCast(@as(i64, -10)))); // x1 = -40 >> 2 = -10 (sign-extended)
     std.debug.print("[kernel_vm_test] ✓ SRA instruction works\n", .{});
 
+    // Test 15: Batched run (instruction budget).
+    std.debug.print("[kernel_vm_test] Test 15: Batched run (instruction budget)\n", .{});
+    // loop: ADDI x1, x1, 1 (0x00108093); JAL x0, -4 (0xFFDFF06F)
+    const loop_kernel = [_]u8{ 0x93, 0x80, 0x10, 0x00, 0x6F, 0xF0, 0xDF, 0xFF };
+    @memset(vm.memory, 0);
+    @memcpy(vm.memory[0x1000..][0..loop_kernel.len], &loop_kernel);
+    vm.regs.pc = 0x1000;
+    vm.state = .halted;
+    vm.regs.set(1, 0);
+    vm.start();
+    const loop_result = vm.run(.{ .max_instructions = 1000 });
+    std.debug.assert(loop_result.exit == .budget_exhausted);
+    std.debug.assert(loop_result.instructions == 1000);
+    std.debug.assert(vm.regs.get(1) == 500); // 500 ADDI + 500 JAL
+    std.debug.assert(vm.regs.pc == 0x1000);
+    std.debug.assert(vm.state == .running);
+    std.debug.print("[kernel_vm_test] ✓ Batched run stops at instruction budget\n", .{});
+
+    // Test 16: Batched run (halt on ECALL without syscall handler).
+    std.debug.print("[kernel_vm_test] Test 16: Batched run (halt)\n", .{});
+    // ADDI x1, x1, 1; ECALL (a7 = 10, kernel syscall, no handler halts VM)
+    const halt_kernel = [_]u8{ 0x93, 0x80, 0x10, 0x00, 0x73, 0x00, 0x00, 0x00 };
+    @memset(vm.memory, 0);
+    @memcpy(vm.memory[0x1000..][0..halt_kernel.len], &halt_kernel);
+    vm.regs.pc = 0x1000;
+    vm.state = .halted;
+    vm.regs.set(1, 0);
+    vm.regs.set(17, 10);
+    vm.start();
+    const halt_result = vm.run(.{ .max_instructions = 1000 });
+    std.debug.assert(halt_result.exit == .halted);
+    std.debug.assert(halt_result.instructions == 2);
+    std.debug.assert(vm.regs.get(1) == 1);
+    std.debug.assert(vm.state == .halted);
+    std.debug.print("[kernel_vm_test] ✓ Batched run stops on halt\n", .{});
+
+    // Test 17: Trace ring (only when built with -Dvm-trace=true).
+    std.debug.print("[kernel_vm_test] Test 17: Trace ring\n", .{});
+    if (kernel_vm.trace.enabled) {
+        // Test 16 ended with an ECALL, which must be the newest event.
+        std.debug.assert(vm.trace.len() > 0);
+        const newest = vm.trace.events[@as(usize, @truncate(vm.trace.count - 1)) & (kernel_vm.trace.RING_SIZE - 1)];
+        std.debug.assert(newest.kind == .ecall);
+        std.debug.assert(newest.addr == 10); // a7
+        std.debug.print("[kernel_vm_test] ✓ Trace ring records ECALL\n", .{});
+    } else {
+        std.debug.assert(@sizeOf(kernel_vm.trace.Trace) == 0);
+        std.debug.print("[kernel_vm_test] ✓ Trace compiled out (zero-sized)\n", .{});
+    }
+
+    // Test 18: Decode table matches reference decoder (every table key).
+    std.debug.print("[kernel_vm_test] Test 18: Decode table equivalence\n", .{});
+    // Operand fill patterns for rd/rs1/rs2 bits ([11:7], [24:15]); funct7 covers all three classes.
+    const operand_mask: u32 = 0x01FF8F80;
+    const operand_patterns = [_]u32{ 0x00000000, 0xFFFFFFFF, 0xA5A5A5A5, 0x5A5A5A5A };
+    const funct7_values = [_]u32{ 0x00, 0x20, 0x01, 0x7F, 0x40 };
+    var checked: u32 = 0;
+    var opcode_bits: u32 = 0;
+    while (opcode_bits < 128) : (opcode_bits += 1) {
+        var funct3_bits: u32 = 0;
+        while (funct3_bits < 8) : (funct3_bits += 1) {
+            for (funct7_values) |funct7_bits| {
+                for (operand_patterns) |operands| {
+                    const word = opcode_bits | (funct3_bits << 12) | (funct7_bits << 25) | (operands & operand_mask);
+                    const table_decoded = VM.decode(word);
+                    const reference_decoded = decode_reference.decode(word);
+                    std.debug.assert(VM.op_of(&table_decoded) == reference_decoded.op);
+                    std.debug.assert(table_decoded.imm == reference_decoded.imm);
+                    std.debug.assert(table_decoded.rd == reference_decoded.rd);
+                    std.debug.assert(table_decoded.rs1 == reference_decoded.rs1);
+                    std.debug.assert(table_decoded.rs2 == reference_decoded.rs2);
+                    checked += 1;
+                }
+            }
+        }
+    }
+    std.debug.assert(checked == 128 * 8 * funct7_values.len * operand_patterns.len);
+    std.debug.print("[kernel_vm_test] ✓ Decode table matches reference ({} words)\n", .{checked});
+
+    // Test 19: JIT matches interpreter (random loops, odd budgets, self-modifying code).
+    std.debug.print("[kernel_vm_test] Test 19: JIT differential\n", .{});
+    // Two VMs on the heap (stable addresses for the JIT's VM pointer).
+    const interp_vm = try std.heap.page_allocator.create(VM);
+    defer std.heap.page_allocator.destroy(interp_vm);
+    const jit_vm = try std.heap.page_allocator.create(VM);
+    defer std.heap.page_allocator.destroy(jit_vm);
+    var jit_blocks: u64 = 0;
+    var seed: u64 = 1;
+    while (seed <= 8) : (seed += 1) {
+        try VM.init(interp_vm, &[_]u8{}, 0);
+        defer interp_vm.deinit();
+        try VM.init_with_options(jit_vm, &[_]u8{}, 0, .{ .execution_mode = .jit });
+        defer jit_vm.deinit();
+        if (kernel_vm.jit.supported and !kernel_vm.trace.enabled) {
+            std.debug.assert(jit_vm.active_execution_mode() == .jit);
+        }
+        write_jit_test_program(interp_vm, seed);
+        write_jit_test_program(jit_vm, seed);
+
+        const interp_instructions = run_to_halt(interp_vm, 1_000_000);
+        // Odd slice sizes end budgets in the middle of translated blocks.
+        const jit_instructions = run_to_halt(jit_vm, 97 + seed);
+        std.debug.assert(interp_instructions == jit_instructions);
+        std.debug.assert(std.mem.eql(u64, &interp_vm.regs.regs, &jit_vm.regs.regs));
+        std.debug.assert(interp_vm.regs.pc == jit_vm.regs.pc);
+        std.debug.assert(std.mem.eql(u8, interp_vm.memory, jit_vm.memory));
+        // Patched instruction took effect at iteration JIT_TEST_PATCH_AT in both modes.
+        std.debug.assert(jit_vm.regs.get(9) == JIT_TEST_PATCH_AT + 2 * (JIT_TEST_ITERATIONS - JIT_TEST_PATCH_AT));
+        if (kernel_vm.jit.supported) {
+            if (jit_vm.jit) |jit| jit_blocks += jit.blocks_translated;
+        }
+
+        // Negative immediates and signed loads (once; start() flushes the random loop's code).
+        if (seed == 1) {
+            write_sign_test_program(interp_vm);
+            write_sign_test_program(jit_vm);
+            const interp_sign_instructions = run_to_halt(interp_vm, 1_000_000);
+            const jit_sign_instructions = run_to_halt(jit_vm, 97);
+            std.debug.assert(interp_sign_instructions == jit_sign_instructions);
+            std.debug.assert(std.mem.eql(u64, &interp_vm.regs.regs, &jit_vm.regs.regs));
+            std.debug.assert(jit_vm.regs.get(6) == 0);
+            std.debug.assert(jit_vm.regs.get(8) == 0xFFFF_FFFF_FFFF_FFFF);
+            std.debug.assert(jit_vm.regs.get(10) == 0xFFFF_FFFF_8000_0000);
+            std.debug.assert(jit_vm.regs.get(11) == 0xFFFF_FFFF_FFFF_FF80);
+            std.debug.assert(jit_vm.regs.get(12) == 0xFFFF_FFFF_FFFF_8000);
+            std.debug.assert(jit_vm.regs.get(13) == 0xFFFF_FFFF_8000_0000);
+            std.debug.assert(jit_vm.regs.get(14) == 0xFFFF_FFFF_FFFF_FF81);
+            std.debug.assert(jit_vm.regs.get(15) == 0);
+            std.debug.assert(jit_vm.regs.get(16) == 0xFFFF_FFFF_FFFF_F800);
+        }
+    }
+    if (kernel_vm.jit.supported and !kernel_vm.trace.enabled) {
+        std.debug.assert(jit_blocks > 0);
+    }
+    {
+        // Patching a callee on another page drops its blocks and unchains the jump into it;
+        // the caller's page stays translated and nothing is flushed.
+        try VM.init(interp_vm, &[_]u8{}, 0);
+        defer interp_vm.deinit();
+        try VM.init_with_options(jit_vm, &[_]u8{}, 0, .{ .execution_mode = .jit });
+        defer jit_vm.deinit();
+        write_chain_test_program(interp_vm);
+        write_chain_test_program(jit_vm);
+        var flushes: u64 = 0;
+        if (kernel_vm.jit.supported) {
+            if (jit_vm.jit) |jit| flushes = jit.flushes;
+        }
+
+        const interp_instructions = run_to_halt(interp_vm, 1_000_000);
+        const jit_instructions = run_to_halt(jit_vm, 97);
+        std.debug.assert(interp_instructions == jit_instructions);
+        std.debug.assert(std.mem.eql(u64, &interp_vm.regs.regs, &jit_vm.regs.regs));
+        std.debug.assert(std.mem.eql(u8, interp_vm.memory, jit_vm.memory));
+        std.debug.assert(jit_vm.regs.get(9) == CHAIN_TEST_PATCH_AT + 2 * (CHAIN_TEST_ITERATIONS - CHAIN_TEST_PATCH_AT));
+        if (kernel_vm.jit.supported) {
+            if (jit_vm.jit) |jit| {
+                // start() flushed once; the patch itself invalidated one page.
+                std.debug.assert(jit.flushes == flushes + 1);
+                if (!kernel_vm.trace.enabled) {
+                    std.debug.assert(jit.blocks_invalidated > 0);
+                    std.debug.assert(jit.translated(CHAIN_TEST_LOOP));
+                }
+            }
+        }
+    }
+    std.debug.print("[kernel_vm_test] ✓ JIT matches interpreter ({} blocks translated)\n", .{jit_blocks});
+
+    // Test 20: Large sparse RAM (4GB guest, lazily faulted, O(touched) reset).
+    std.debug.print("[kernel_vm_test] Test 20: Large sparse RAM\n", .{});
+    const big_vm = try std.heap.page_allocator.create(VM);
+    defer std.heap.page_allocator.destroy(big_vm);
+    const big_size: usize = 4 * 1024 * 1024 * 1024;
+    try VM.init_with_options(big_vm, &[_]u8{}, 0, .{ .execution_mode = .jit, .memory_size = big_size });
+    defer big_vm.deinit();
+    std.debug.assert(big_vm.memory.len == big_size);
+    // Above the JIT's address range the interpreter runs the guest.
+    std.debug.assert(big_vm.active_execution_mode() == .interpreter);
+    const big_top: u64 = big_size - 8;
+    std.debug.assert(try big_vm.read64(big_top) == 0);
+    try big_vm.write64(big_top, 0x0123456789ABCDEF);
+    try big_vm.write64(0x2000, 0xFEDCBA9876543210);
+    big_vm.regs.set(5, 42);
+    try big_vm.reset();
+    std.debug.assert(try big_vm.read64(big_top) == 0);
+    std.debug.assert(try big_vm.read64(0x2000) == 0);
+    std.debug.assert(big_vm.regs.get(5) == 0);
+    std.debug.assert(big_vm.state == .halted);
+    std.debug.print("[kernel_vm_test] ✓ 4GB guest maps lazily and resets to zero\n", .{});
+
+    // Test 21: Snapshot / restore (self-modifying loop, both engines, host writes).
+    std.debug.print("[kernel_vm_test] Test 21: Snapshot and restore\n", .{});
+    const snap_vm = try std.heap.page_allocator.create(VM);
+    defer std.heap.page_allocator.destroy(snap_vm);
+    for ([_]VM.ExecutionMode{ .interpreter, .jit }) |mode| {
+        try VM.init_with_options(snap_vm, &[_]u8{}, 0, .{ .execution_mode = mode });
+        defer snap_vm.deinit();
+        write_jit_test_program(snap_vm, 3);
+        const patched_addr: usize = @intCast(JIT_TEST_CODE + 9 * 4);
+        const original_word = std.mem.readInt(u32, snap_vm.memory[patched_addr..][0..4], .little);
+
+        var snap = try snap_vm.snapshot(std.heap.page_allocator);
+        defer snap.deinit(std.heap.page_allocator);
+        const first_instructions = run_to_halt(snap_vm, 97);
+        const first_regs = snap_vm.regs;
+        const first_hash = std.hash.Wyhash.hash(0, snap_vm.memory);
+        // Loop stored to its data page and rewrote its own code page.
+        std.debug.assert(snap_vm.dirty_pages.count() >= 2);
+
+        var round: u32 = 0;
+        while (round < 3) : (round += 1) {
+            snap_vm.restore(&snap);
+            std.debug.assert(snap_vm.dirty_pages.count() == 0);
+            std.debug.assert(snap_vm.regs.pc == JIT_TEST_CODE);
+            std.debug.assert(snap_vm.state == .halted);
+            std.debug.assert(std.mem.readInt(u32, snap_vm.memory[patched_addr..][0..4], .little) == original_word);
+            std.debug.assert(run_to_halt(snap_vm, 97 + round) == first_instructions);
+            std.debug.assert(std.mem.eql(u64, &snap_vm.regs.regs, &first_regs.regs));
+            std.debug.assert(std.hash.Wyhash.hash(0, snap_vm.memory) == first_hash);
+        }
+
+        // Host writes through write_memory are tracked (page-straddling range).
+        const far_addr: u64 = 0x300000 - 2;
+        try snap_vm.write_memory(far_addr, &[_]u8{ 1, 2, 3, 4 });
+        snap_vm.restore(&snap);
+        std.debug.assert(std.mem.allEqual(u8, snap_vm.memory[@intCast(far_addr)..][0..4], 0));
+        if (snap_vm.write_memory(snap_vm.memory_size - 2, &[_]u8{ 1, 2, 3, 4 })) |_| {
+            unreachable; // Range ends past guest RAM.
+        } else |err| {
+            std.debug.assert(err == VM.VMError.invalid_memory_access);
+        }
+    }
+    std.debug.print("[kernel_vm_test] ✓ Restore replays identically (interpreter and JIT)\n", .{});
+
+    // Test 22: SMP (four harts on host threads, shared RAM, AMO and LR/SC counters, IPIs).
+    std.debug.print("[kernel_vm_test] Test 22: SMP harts\n", .{});
+    const boot_vm = try std.heap.page_allocator.create(VM);
+    defer std.heap.page_allocator.destroy(boot_vm);
+    for ([_]VM.ExecutionMode{ .interpreter, .jit }) |mode| {
+        try VM.init_with_options(boot_vm, &[_]u8{}, 0, .{ .execution_mode = mode });
+        defer boot_vm.deinit();
+        write_smp_test_program(boot_vm);
+
+        var machine: kernel_vm.smp.Smp = undefined;
+        try kernel_vm.smp.Smp.init(&machine, std.heap.page_allocator, boot_vm, SMP_TEST_HARTS);
+        defer machine.deinit();
+        machine.start();
+        const results = try machine.run(10_000_000);
+        std.debug.assert(results.len == SMP_TEST_HARTS);
+        for (results) |result| {
+            std.debug.assert(result.exit == .halted);
+        }
+        // No increment lost on either counter; every secondary woke by IPI.
+        std.debug.assert(try boot_vm.read64(JIT_TEST_DATA) == SMP_TEST_HARTS * SMP_TEST_ITERATIONS);
+        std.debug.assert(try boot_vm.read64(JIT_TEST_DATA + 8) == SMP_TEST_HARTS * SMP_TEST_ITERATIONS);
+        std.debug.assert(try boot_vm.read64(JIT_TEST_DATA + 24) == SMP_TEST_HARTS - 1);
+    }
+    std.debug.print("[kernel_vm_test] ✓ Four harts count atomically and wake on IPI (interpreter and JIT)\n", .{});
+
+    // Test 23: Sv39 paging (guest satp write, aliased code, superpage, TLB counters, faults).
+    std.debug.print("[kernel_vm_test] Test 23: Sv39 MMU and TLB\n", .{});
+    const mmu = kernel_vm.mmu;
+    const paged_vm = try std.heap.page_allocator.create(VM);
+    defer std.heap.page_allocator.destroy(paged_vm);
+    for ([_]VM.ExecutionMode{ .interpreter, .jit }) |mode| {
+        try VM.init_with_options(paged_vm, &[_]u8{}, 0, .{ .execution_mode = mode });
+        defer paged_vm.deinit();
+        const fault_va = write_sv39_test_program(paged_vm);
+
+        paged_vm.start();
+        const paged = paged_vm.run(.{ .max_instructions = 100_000 });
+        std.debug.assert(paged.exit == .halted);
+        std.debug.assert(paged_vm.satp >> 60 == mmu.SATP_MODE_SV39);
+        std.debug.assert(paged_vm.regs.get(29) == 7);
+        std.debug.assert(try paged_vm.read64(JIT_TEST_DATA) == 7);
+        std.debug.assert(try paged_vm.read64(SV39_SUPERPAGE_PA + 8) == 7);
+
+        // Walks set A on every leaf used and D only where stores went.
+        const data_pte = try paged_vm.read64(SV39_L0_HIGH + 1 * 8);
+        const code_pte = try paged_vm.read64(SV39_L0_HIGH + 0 * 8);
+        std.debug.assert(data_pte & (mmu.PTE_A | mmu.PTE_D) == mmu.PTE_A | mmu.PTE_D);
+        std.debug.assert(code_pte & mmu.PTE_A != 0 and code_pte & mmu.PTE_D == 0);
+
+        // Hot loop is served by the TLB; only first touches and the SFENCE.VMA re-walk miss.
+        const counters = paged_vm.tlb_counters();
+        std.debug.assert(counters.misses <= 16);
+        std.debug.assert(counters.hit_rate() > 0.99);
+        std.debug.assert(counters.faults == 0);
+
+        // Store to a read-only page faults (VM errored, not silently written).
+        paged_vm.reset_tlb_counters();
+        paged_vm.regs.pc = fault_va;
+        paged_vm.start();
+        const faulted = paged_vm.run(.{ .max_instructions = 100 });
+        std.debug.assert(faulted.exit == .fault);
+        std.debug.assert(paged_vm.last_error.? == VM.VMError.page_fault);
+        std.debug.assert(paged_vm.tlb_counters().faults == 1);
+        std.debug.assert(try paged_vm.read64(SV39_READ_ONLY_PA) == 0);
+    }
+    std.debug.print("[kernel_vm_test] ✓ Sv39 translates through the TLB and faults on bad access (interpreter and JIT)\n", .{});
+
+    // Test 24: Profiler (ELF symbols, shadow call stack, folded stacks; sampling needs -Dvm-profile=true).
+    std.debug.print("[kernel_vm_test] Test 24: Guest profiler\n", .{});
+    var profile_elf: [PROFILE_TEST_ELF_SIZE]u8 align(8) = [_]u8{0} ** PROFILE_TEST_ELF_SIZE;
+    write_profile_test_elf(&profile_elf);
+    var symbols = try kernel_vm.loadSymbols(std.heap.page_allocator, &profile_elf);
+    defer symbols.deinit();
+    std.debug.assert(symbols.symbols.len == 2);
+    std.debug.assert(std.mem.eql(u8, symbols.lookup(PROFILE_TEST_MAIN + 0x10).?.name, "main"));
+    std.debug.assert(std.mem.eql(u8, symbols.lookup(PROFILE_TEST_LEAF + 8).?.name, "leaf"));
+    std.debug.assert(symbols.lookup(PROFILE_TEST_LEAF + PROFILE_TEST_LEAF_SIZE) == null);
+    std.debug.assert(symbols.lookup(PROFILE_TEST_MAIN - 4) == null);
+
+    const profiled_vm = try std.heap.page_allocator.create(VM);
+    defer std.heap.page_allocator.destroy(profiled_vm);
+    try loadKernel(profiled_vm, std.heap.page_allocator, &profile_elf);
+    defer profiled_vm.deinit();
+    if (kernel_vm.profile.enabled) {
+        // Sample every instruction so the folded counts are exact.
+        profiled_vm.profile.set_interval(1);
+        profiled_vm.start();
+        const profiled = profiled_vm.run(.{ .max_instructions = 10_000 });
+        std.debug.assert(profiled.exit == .halted);
+        std.debug.assert(profiled_vm.profile.samples == profiled.instructions);
+        std.debug.assert(profiled_vm.profile.dropped == 0);
+        std.debug.assert(profiled_vm.profile.opcode_counts[0x6F] == PROFILE_TEST_CALLS); // JAL
+        std.debug.assert(profiled_vm.profile.opcode_counts[0x67] == PROFILE_TEST_CALLS); // JALR
+
+        // Leaf's three instructions run under main once per call; the rest is main itself.
+        var folded_buffer: [1024]u8 = undefined;
+        var folded_writer = std.Io.Writer.fixed(&folded_buffer);
+        try profiled_vm.write_profile_folded(&symbols, &folded_writer);
+        const folded = folded_writer.buffered();
+        std.debug.assert(std.mem.indexOf(u8, folded, "main;leaf 150\n") != null);
+        std.debug.assert(std.mem.indexOf(u8, folded, "main ") != null);
+        std.debug.assert(std.mem.count(u8, folded, "\n") == 2);
+        std.debug.print("[kernel_vm_test] ✓ Profiler symbolizes call stacks into folded output\n", .{});
+    } else {
+        std.debug.assert(@sizeOf(kernel_vm.profile.Profile) == 0);
+        std.debug.print("[kernel_vm_test] ✓ ELF symbols indexed; profiler compiled out (zero-sized)\n", .{});
+    }
+
+    // Test 25: Record / replay (logged syscall results, checkpoints, seek; both engines).
+    std.debug.print("[kernel_vm_test] Test 25: Record and replay\n", .{});
+    const recorded_vm = try std.heap.page_allocator.create(VM);
+    defer std.heap.page_allocator.destroy(recorded_vm);
+    const replayed_vm = try std.heap.page_allocator.create(VM);
+    defer std.heap.page_allocator.destroy(replayed_vm);
+    for ([_]VM.ExecutionMode{ .interpreter, .jit }) |mode| {
+        try VM.init_with_options(recorded_vm, &[_]u8{}, 0, .{ .execution_mode = mode });
+        defer recorded_vm.deinit();
+        write_replay_test_program(recorded_vm);
+        recorded_vm.set_syscall_handler(replay_test_syscall, null);
+
+        var log = std.Io.Writer.Allocating.init(std.heap.page_allocator);
+        defer log.deinit();
+        var recorder: kernel_vm.replay.Recorder = undefined;
+        try recorder.init(recorded_vm, &log.writer, .{ .checkpoint_interval = REPLAY_TEST_INTERVAL });
+        recorded_vm.start();
+        const mid = try recorder.run(recorded_vm, REPLAY_TEST_SEEK);
+        std.debug.assert(mid.instructions == REPLAY_TEST_SEEK);
+        const mid_regs = recorded_vm.regs;
+        const rest = try recorder.run(recorded_vm, 10_000);
+        std.debug.assert(rest.exit == .halted);
+        try recorder.finish(recorded_vm);
+        std.debug.assert(recorder.session.inputs == REPLAY_TEST_CALLS);
+        const final_regs = recorded_vm.regs;
+        const final_hash = std.hash.Wyhash.hash(0, recorded_vm.memory);
+
+        // Replay without any syscall handler: logged results stand in for the host.
+        try VM.init_with_options(replayed_vm, &[_]u8{}, 0, .{ .execution_mode = mode });
+        defer replayed_vm.deinit();
+        var replayer: kernel_vm.replay.Replayer = undefined;
+        try replayer.init(std.heap.page_allocator, log.written());
+        defer replayer.deinit();
+        std.debug.assert(replayer.checkpoints.len == REPLAY_TEST_INSTRUCTIONS / REPLAY_TEST_INTERVAL + 1);
+        std.debug.assert(replayer.end_instret.? == REPLAY_TEST_INSTRUCTIONS);
+
+        try replayer.seek(replayed_vm, 0);
+        const replayed = try replayer.run(replayed_vm, 10_000);
+        std.debug.assert(replayed.exit == .halted);
+        std.debug.assert(replayed.instructions == REPLAY_TEST_INSTRUCTIONS);
+        std.debug.assert(std.mem.eql(u64, &replayed_vm.regs.regs, &final_regs.regs));
+        std.debug.assert(std.hash.Wyhash.hash(0, replayed_vm.memory) == final_hash);
+
+        // Seek between checkpoints lands on the recorded state, and replays on to the same end.
+        try replayer.seek(replayed_vm, REPLAY_TEST_SEEK);
+        std.debug.assert(replayed_vm.regs.pc == mid_regs.pc);
+        std.debug.assert(std.mem.eql(u64, &replayed_vm.regs.regs, &mid_regs.regs));
+        _ = try replayer.run(replayed_vm, 10_000);
+        std.debug.assert(std.hash.Wyhash.hash(0, replayed_vm.memory) == final_hash);
+        if (replayer.seek(replayed_vm, REPLAY_TEST_INSTRUCTIONS + 1)) |_| {
+            unreachable; // Past the recorded run.
+        } else |err| {
+            std.debug.assert(err == error.SeekBeyondEnd);
+        }
+    }
+    std.debug.print("[kernel_vm_test] ✓ Replay reproduces recorded runs and seeks by checkpoint (interpreter and JIT)\n", .{});
+
+    // Test 26: Virtio MMIO console and block devices (driver handshake from the guest; both engines).
+    std.debug.print("[kernel_vm_test] Test 26: Virtio console and block\n", .{});
+    const virtio_vm = try std.heap.page_allocator.create(VM);
+    defer std.heap.page_allocator.destroy(virtio_vm);
+    for ([_]VM.ExecutionMode{ .interpreter, .jit }) |mode| {
+        try VM.init_with_options(virtio_vm, &[_]u8{}, 0, .{ .execution_mode = mode });
+        defer virtio_vm.deinit();
+        var virtio_serial = SerialOutput{};
+        virtio_vm.serial_output = &virtio_serial;
+
+        var disk: [VIRTIO_TEST_DISK_SECTORS * kernel_vm.virtio.SECTOR_SIZE]u8 = undefined;
+        for (&disk, 0..) |*byte, index| byte.* = @truncate(index *% 7);
+        const original_disk = disk;
+        var console_device = kernel_vm.virtio.Device.console();
+        var block_device = kernel_vm.virtio.Device.block_memory(&disk, false);
+        var bus = kernel_vm.virtio.Bus{};
+        virtio_vm.mmio = &bus;
+        const console_base = try bus.attach(&console_device);
+        const block_base = try bus.attach(&block_device);
+        std.debug.assert(block_base == console_base + kernel_vm.virtio.MMIO_STRIDE);
+
+        write_virtio_test_program(virtio_vm, console_base, block_base);
+        std.debug.assert(run_to_halt(virtio_vm, 10_000) > 0);
+
+        // Console: one notify moved the whole two-descriptor message.
+        const message = virtio_vm.memory[VIRTIO_TEST_MESSAGE..][0..VIRTIO_TEST_MESSAGE_LEN];
+        std.debug.assert(virtio_serial.total_written == VIRTIO_TEST_MESSAGE_LEN);
+        std.debug.assert(std.mem.eql(u8, virtio_serial.buffer[0..VIRTIO_TEST_MESSAGE_LEN], message));
+        std.debug.assert(read_u16(virtio_vm, VIRTIO_TEST_CONSOLE_USED + 2) == 1);
+        std.debug.assert(console_device.completed == 1);
+
+        // Block: sectors 1-2 read into guest RAM, sector 3 overwritten from the message.
+        std.debug.assert(std.mem.eql(u8, virtio_vm.memory[VIRTIO_TEST_READ_BUFFER..][0..1024], original_disk[512..1536]));
+        std.debug.assert(std.mem.eql(u8, disk[1536..2048], message[0..512]));
+        std.debug.assert(std.mem.eql(u8, disk[0..1536], original_disk[0..1536]));
+        std.debug.assert(virtio_vm.memory[VIRTIO_TEST_STATUS] == kernel_vm.virtio.BLK_S_OK);
+        std.debug.assert(virtio_vm.memory[VIRTIO_TEST_STATUS + 1] == kernel_vm.virtio.BLK_S_OK);
+        std.debug.assert(read_u16(virtio_vm, VIRTIO_TEST_BLOCK_USED + 2) == 2);
+        std.debug.assert(read_u32(virtio_vm, VIRTIO_TEST_BLOCK_USED + 4 + 4) == 1024 + 1);
+        std.debug.assert(read_u32(virtio_vm, VIRTIO_TEST_BLOCK_USED + 12) == 3);
+
+        // Guest register reads: interrupt status, capacity (64-bit config), device status.
+        std.debug.assert(virtio_vm.regs.get(28) == 1);
+        std.debug.assert(virtio_vm.regs.get(29) == VIRTIO_TEST_DISK_SECTORS);
+        std.debug.assert(virtio_vm.regs.get(30) == VIRTIO_TEST_DRIVER_OK);
+    }
+    std.debug.print("[kernel_vm_test] ✓ Virtio rings move console and block data per notify (interpreter and JIT)\n", .{});
+
+    // Test 27: Timer interrupts and WFI fast-forward (an hour of guest time; both engines, then SMP).
+    std.debug.print("[kernel_vm_test] Test 27: Timer interrupts and virtual time\n", .{});
+    const timer_vm = try std.heap.page_allocator.create(VM);
+    defer std.heap.page_allocator.destroy(timer_vm);
+    for ([_]VM.ExecutionMode{ .interpreter, .jit }) |mode| {
+        try VM.init_with_options(timer_vm, &[_]u8{}, 0, .{ .execution_mode = mode });
+        defer timer_vm.deinit();
+        write_timer_test_program(timer_vm, TIMER_TEST_TICKS);
+        const retired = run_to_halt(timer_vm, 1_000_000);
+        // Idle time was skipped, not executed: a handful of instructions per tick.
+        std.debug.assert(retired < TIMER_TEST_TICKS * 16);
+        std.debug.assert(timer_vm.regs.get(9) == 0);
+        std.debug.assert(timer_vm.csrs.mtime >= TIMER_TEST_TICKS * kernel_vm.csr.TIMEBASE_HZ);
+        std.debug.assert(timer_vm.csrs.mtime < (TIMER_TEST_TICKS + 1) * kernel_vm.csr.TIMEBASE_HZ);
+        std.debug.assert(timer_vm.csrs.scause == kernel_vm.csr.CAUSE_SUPERVISOR_TIMER);
+        std.debug.assert(timer_vm.csrs.mtimecmp == kernel_vm.csr.NO_DEADLINE);
+    }
+    {
+        // SMP: each hart sleeps on its own timer; time jumps once both are parked.
+        try VM.init_with_options(timer_vm, &[_]u8{}, 0, .{});
+        defer timer_vm.deinit();
+        write_timer_test_program(timer_vm, TIMER_TEST_SMP_TICKS);
+        var machine: kernel_vm.smp.Smp = undefined;
+        try kernel_vm.smp.Smp.init(&machine, std.heap.page_allocator, timer_vm, 2);
+        defer machine.deinit();
+        machine.start();
+        const results = try machine.run(10_000_000);
+        for (results, machine.harts[0..machine.hart_count]) |result, hart| {
+            std.debug.assert(result.exit == .halted);
+            std.debug.assert(hart.regs.get(9) == 0);
+            std.debug.assert(hart.csrs.mtime >= TIMER_TEST_SMP_TICKS * kernel_vm.csr.TIMEBASE_HZ);
+        }
+    }
+    std.debug.print("[kernel_vm_test] ✓ WFI skips to timer deadlines; an hour of ticks retires in milliseconds\n", .{});
+
+    // Test 28: ELF image cache (parse once, place per spawn, guest stores stay private).
+    std.debug.print("[kernel_vm_test] Test 28: ELF image cache and copy-on-write segments\n", .{});
+    var image_cache = kernel_vm.ImageCache{};
+    defer image_cache.deinit();
+    var image_elf: [IMAGE_TEST_ELF_SIZE]u8 align(8) = [_]u8{0} ** IMAGE_TEST_ELF_SIZE;
+    write_image_test_elf(&image_elf);
+    const image = try image_cache.from_bytes(&image_elf);
+    std.debug.assert(try image_cache.from_bytes(&image_elf) == image);
+    std.debug.assert(image_cache.hits == 1 and image_cache.misses == 1);
+    std.debug.assert(image.segment_count == 2 and image.entry == IMAGE_TEST_TEXT);
+    const image_vm = try std.heap.page_allocator.create(VM);
+    defer std.heap.page_allocator.destroy(image_vm);
+    for (0..2) |_| {
+        try kernel_vm.loadImage(image_vm, image, .{});
+        defer image_vm.deinit();
+        std.debug.assert(std.mem.eql(u8, image_vm.memory[@intCast(IMAGE_TEST_TEXT)..][0..@intCast(IMAGE_TEST_TEXT_SIZE)], image_elf[0x1000..][0..@intCast(IMAGE_TEST_TEXT_SIZE)]));
+        std.debug.assert(read_u32(image_vm, IMAGE_TEST_DATA) == IMAGE_TEST_WORD);
+        std.debug.assert(std.mem.allEqual(u8, image_vm.memory[@intCast(IMAGE_TEST_DATA + 0x100)..][0..0xF00], 0));
+        _ = run_to_halt(image_vm, 1000);
+        // The guest incremented a word of its read-only segment: every spawn starts fresh.
+        std.debug.assert(image_vm.regs.get(10) == IMAGE_TEST_WORD + 1);
+        std.debug.assert(read_u32(image_vm, IMAGE_TEST_TEXT + 0x1000) == IMAGE_TEST_WORD + 1);
+        std.debug.assert(std.mem.readInt(u32, image.bytes[0x2000..][0..4], .little) == IMAGE_TEST_WORD);
+    }
+    {
+        // A cached file is a sealed copy: rewriting the file leaves the image and its pages alone.
+        const path = "kernel_vm_image_test.elf";
+        try std.fs.cwd().writeFile(.{ .sub_path = path, .data = &image_elf });
+        defer std.fs.cwd().deleteFile(path) catch {};
+        std.debug.assert(try image_cache.open_file(path) == image);
+        std.debug.assert(image_cache.hits == 2 and image_cache.misses == 1);
+        const file = try std.fs.cwd().openFile(path, .{ .mode = .read_write });
+        defer file.close();
+        var word: [4]u8 = undefined;
+        std.mem.writeInt(u32, &word, IMAGE_TEST_WORD + 7, .little);
+        try file.pwriteAll(&word, 0x2000);
+        try file.setEndPos(0x2000);
+        std.debug.assert(std.mem.readInt(u32, image.bytes[0x2000..][0..4], .little) == IMAGE_TEST_WORD);
+        try kernel_vm.loadImage(image_vm, image, .{});
+        defer image_vm.deinit();
+        std.debug.assert(read_u32(image_vm, IMAGE_TEST_TEXT + 0x1000) == IMAGE_TEST_WORD);
+    }
+    std.debug.print("[kernel_vm_test] ✓ Cached images respawn without reparsing; read-only pages are copy-on-write\n", .{});
+
     std.debug.print("[kernel_vm_test] All tests passed!\n", .{});
 }
 
+/// JIT differential program layout (code page, data page, loop shape).
+const JIT_TEST_CODE: u64 = 0x1000;
+const JIT_TEST_DATA: u64 = 0x10000;
+const JIT_TEST_ITERATIONS: u64 = 300;
+/// Iteration at which the loop rewrites its own `addi x9, x9, 1` into `addi x9, x9, 2`.
+const JIT_TEST_PATCH_AT: u64 = 100;
+const JIT_TEST_BODY_LENGTH: u32 = 32;
+/// Compatibility opcode decoding XORI/ORI/ANDI/SLLI by funct3.
+const JIT_TEST_COMPAT_ALU: u32 = 0x2E;
+/// Loop iterations of the sign test (enough for the JIT to translate the body).
+const SIGN_TEST_ITERATIONS: u64 = 64;
+/// Chain test: loop on the JIT test code page, callee two pages up, patched mid-run.
+const CHAIN_TEST_LOOP: u64 = JIT_TEST_CODE + 5 * 4;
+const CHAIN_TEST_CALLEE: u64 = JIT_TEST_CODE + 0x2000;
+const CHAIN_TEST_ITERATIONS: u64 = 200;
+const CHAIN_TEST_PATCH_AT: u64 = 100;
+
+/// Write deterministic random loop (code, data, registers) into vm.
+/// Why: Only instructions whose interpreter semantics are total (no checked-cast traps)
+/// are generated, so both engines must agree on every register and byte.
+fn write_jit_test_program(vm: *VM, seed: u64) void {
+    var rng = TestRng{ .state = seed };
+    var pc: u64 = JIT_TEST_CODE;
+
+    // Setup: x5 = data, x6 = iterations, x23 = patch iteration,
+    // x21 = patched instruction address, x22 = replacement word.
+    emit_word(vm, &pc, rv_u(JIT_TEST_DATA >> 12, 5));
+    emit_word(vm, &pc, rv_i(JIT_TEST_ITERATIONS, 0, 0b000, 6, 0x13));
+    emit_word(vm, &pc, rv_i(JIT_TEST_PATCH_AT, 0, 0b000, 23, 0x13));
+    emit_word(vm, &pc, rv_u(JIT_TEST_CODE >> 12, 21));
+    emit_word(vm, &pc, rv_i(9 * 4, 21, 0b000, 21, 0x13));
+    const replacement = rv_i(2, 9, 0b000, 9, 0x13); // addi x9, x9, 2
+    emit_word(vm, &pc, rv_u(replacement >> 12, 22));
+    emit_word(vm, &pc, rv_i(replacement & 0xFFF, 22, 0b000, 22, 0x13));
+
+    // Loop: patch once at iteration x23, then the random body.
+    const loop_start = pc;
+    emit_word(vm, &pc, rv_b(8, 23, 7, 0b001)); // bne x7, x23, +8
+    emit_word(vm, &pc, rv_s(0, 22, 21, 0b010)); // sw x22, 0(x21)
+    std.debug.assert(pc == JIT_TEST_CODE + 9 * 4);
+    emit_word(vm, &pc, rv_i(1, 9, 0b000, 9, 0x13)); // addi x9, x9, 1 (patched)
+
+    var index: u32 = 0;
+    while (index < JIT_TEST_BODY_LENGTH) : (index += 1) {
+        const rd: u5 = @intCast(10 + rng.below(11));
+        const rs1 = rng.register();
+        const rs2 = rng.register();
+        const choice: usize = @intCast(rng.below(22));
+        switch (choice) {
+            // R-type: add, sub, xor, or, and, slt, sll, srl, sra.
+            0...8 => {
+                const funct3 = [_]u32{ 0b000, 0b000, 0b100, 0b110, 0b111, 0b010, 0b001, 0b101, 0b101 };
+                const funct7 = [_]u32{ 0x00, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20 };
+                emit_word(vm, &pc, rv_r(funct7[choice], rs2, rs1, funct3[choice], rd));
+            },
+            // xori, ori, andi (sign-extended immediates), slli.
+            // Note: OP-IMM (0x13) decodes only ADDI; these use compatibility opcode 0x2E.
+            9 => emit_word(vm, &pc, rv_i(rng.below(4096), rs1, 0b100, rd, JIT_TEST_COMPAT_ALU)),
+            10 => emit_word(vm, &pc, rv_i(rng.below(4096), rs1, 0b110, rd, JIT_TEST_COMPAT_ALU)),
+            11 => emit_word(vm, &pc, rv_i(rng.below(4096), rs1, 0b111, rd, JIT_TEST_COMPAT_ALU)),
+            12 => emit_word(vm, &pc, rv_i(rng.below(64), rs1, 0b001, rd, JIT_TEST_COMPAT_ALU)),
+            // Loads: lbu, lhu, lwu, ld (aligned, within the data page).
+            13...16 => {
+                const funct3 = [_]u32{ 0b100, 0b101, 0b110, 0b011 };
+                const size = @as(u64, 1) << @intCast(choice - 13);
+                const offset = rng.below(255) * 8 + rng.below(8 / size) * size;
+                emit_word(vm, &pc, rv_i(offset, 5, funct3[choice - 13], rd, 0x03));
+            },
+            // Stores: sb, sh, sw, sd.
+            17...20 => {
+                const size = @as(u64, 1) << @intCast(choice - 17);
+                const offset = rng.below(255) * 8 + rng.below(8 / size) * size;
+                emit_word(vm, &pc, rv_s(offset, rs2, 5, @intCast(choice - 17)));
+            },
+            // bltu skipping the next instruction (splits blocks mid-body).
+            else => {
+                emit_word(vm, &pc, rv_b(8, rs2, rs1, 0b110));
+                emit_word(vm, &pc, rv_r(0x00, rs2, rs1, 0b000, rd));
+            },
+        }
+    }
+
+    // Tail: x7 += 1; bne x7, x6, loop; a7 = exit syscall; ecall.
+    emit_word(vm, &pc, rv_i(1, 7, 0b000, 7, 0x13));
+    const back: u64 = loop_start -% pc;
+    emit_word(vm, &pc, rv_b(back, 6, 7, 0b001));
+    emit_word(vm, &pc, rv_i(10, 0, 0b000, 17, 0x13));
+    emit_word(vm, &pc, 0x00000073);
+    vm.regs.pc = JIT_TEST_CODE;
+
+    // Random data and operand registers.
+    var offset: u64 = 0;
+    while (offset < 2048) : (offset += 8) {
+        std.mem.writeInt(u64, vm.memory[@intCast(JIT_TEST_DATA + offset)..][0..8], rng.next(), .little);
+    }
+    var reg: u5 = 10;
+    while (reg <= 20) : (reg += 1) {
+        vm.regs.set(reg, rng.next());
+    }
+}
+
+/// Write a loop of instructions whose results are negative into vm.
+/// Why: LUI with bit 31 set, LB/LH/LW of negative values and ADDI with a negative
+/// immediate or crossing zero must sign-extend and wrap the same way in both engines.
+fn write_sign_test_program(vm: *VM) void {
+    std.mem.writeInt(u64, vm.memory[@intCast(JIT_TEST_DATA)..][0..8], 0x8000_0000_8000_0080, .little);
+    var pc: u64 = JIT_TEST_CODE;
+    // Setup: x5 = data, x6 = iterations, x7 = 1, x8 = -1.
+    emit_word(vm, &pc, rv_u(JIT_TEST_DATA >> 12, 5));
+    emit_word(vm, &pc, rv_i(SIGN_TEST_ITERATIONS, 0, 0b000, 6, 0x13));
+    emit_word(vm, &pc, rv_i(1, 0, 0b000, 7, 0x13));
+    emit_word(vm, &pc, rv_i(0xFFF, 0, 0b000, 8, 0x13)); // addi x8, x0, -1
+
+    const loop_start = pc;
+    emit_word(vm, &pc, rv_u(0x80000, 10)); // lui x10, 0x80000
+    emit_word(vm, &pc, rv_i(0, 5, 0b000, 11, 0x03)); // lb x11, 0(x5)
+    emit_word(vm, &pc, rv_i(2, 5, 0b001, 12, 0x03)); // lh x12, 2(x5)
+    emit_word(vm, &pc, rv_i(4, 5, 0b010, 13, 0x03)); // lw x13, 4(x5)
+    emit_word(vm, &pc, rv_i(1, 11, 0b000, 14, 0x13)); // addi x14, x11, 1
+    emit_word(vm, &pc, rv_i(1, 8, 0b000, 15, 0x13)); // addi x15, x8, 1 (wraps to 0)
+    emit_word(vm, &pc, rv_i(0x800, 0, 0b000, 16, 0x13)); // addi x16, x0, -2048
+    emit_word(vm, &pc, rv_r(0x20, 7, 6, 0b000, 6)); // x6 -= 1
+    emit_word(vm, &pc, rv_b(loop_start -% pc, 0, 6, 0b001));
+    emit_word(vm, &pc, rv_i(10, 0, 0b000, 17, 0x13));
+    emit_word(vm, &pc, 0x00000073);
+    vm.regs.pc = JIT_TEST_CODE;
+}
+
+/// Write a loop that jumps to a callee on another page and patches the callee once.
+/// Why: Once both are translated the loop's jump is chained straight into the callee;
+/// the patch must unchain it (a stale jump would keep adding 1) and leave the loop's
+/// own blocks translated.
+fn write_chain_test_program(vm: *VM) void {
+    var pc: u64 = JIT_TEST_CODE;
+    // Setup: x6 = iterations, x23 = patch iteration, x21 = callee, x22 = replacement word.
+    emit_word(vm, &pc, rv_i(CHAIN_TEST_ITERATIONS, 0, 0b000, 6, 0x13));
+    emit_word(vm, &pc, rv_i(CHAIN_TEST_PATCH_AT, 0, 0b000, 23, 0x13));
+    emit_word(vm, &pc, rv_u(CHAIN_TEST_CALLEE >> 12, 21));
+    const replacement = rv_i(2, 9, 0b000, 9, 0x13); // addi x9, x9, 2
+    emit_word(vm, &pc, rv_u(replacement >> 12, 22));
+    emit_word(vm, &pc, rv_i(replacement & 0xFFF, 22, 0b000, 22, 0x13));
+
+    // Loop: patch the callee at iteration x23, jump to it, count once it jumps back.
+    std.debug.assert(pc == CHAIN_TEST_LOOP);
+    emit_word(vm, &pc, rv_b(8, 23, 7, 0b001)); // bne x7, x23, +8
+    emit_word(vm, &pc, rv_s(0, 22, 21, 0b010)); // sw x22, 0(x21)
+    emit_word(vm, &pc, rv_j(CHAIN_TEST_CALLEE -% pc, 0)); // j callee
+    const back = pc;
+    emit_word(vm, &pc, rv_i(1, 7, 0b000, 7, 0x13)); // addi x7, x7, 1
+    emit_word(vm, &pc, rv_b(CHAIN_TEST_LOOP -% pc, 6, 7, 0b001)); // bne x7, x6, loop
+    emit_word(vm, &pc, rv_i(10, 0, 0b000, 17, 0x13));
+    emit_word(vm, &pc, 0x00000073);
+
+    // Callee: x9 += 1 (patched to += 2), jump back.
+    pc = CHAIN_TEST_CALLEE;
+    emit_word(vm, &pc, rv_i(1, 9, 0b000, 9, 0x13));
+    emit_word(vm, &pc, rv_j(back -% pc, 0));
+    vm.regs.pc = JIT_TEST_CODE;
+}
+
+/// SMP test shape: harts sharing the JIT test code and data pages.
+const SMP_TEST_HARTS: u32 = 4;
+const SMP_TEST_ITERATIONS: u64 = 1000;
+
+/// Write SMP program into vm (every hart runs it; a0 = hart ID).
+/// Why: Each hart bumps data[0] with AMOADD.D and data[8] with an LR/SC retry loop;
+/// hart 0 then IPIs harts 1..3, which WFI until CLEAR_IPI reports it and count
+/// themselves in data[24]. Lost updates or lost wake-ups show up as wrong counts.
+fn write_smp_test_program(vm: *VM) void {
+    var pc: u64 = JIT_TEST_CODE;
+    // Setup: x5 = data, x6 = iterations, x7 = 1, x28 = &data[8], x30 = &data[24].
+    emit_word(vm, &pc, rv_u(JIT_TEST_DATA >> 12, 5));
+    emit_word(vm, &pc, rv_i(SMP_TEST_ITERATIONS, 0, 0b000, 6, 0x13));
+    emit_word(vm, &pc, rv_i(1, 0, 0b000, 7, 0x13));
+    emit_word(vm, &pc, rv_i(8, 5, 0b000, 28, 0x13));
+    emit_word(vm, &pc, rv_i(24, 5, 0b000, 30, 0x13));
+
+    // Loop: amoadd.d x0, x7, (x5); retry: lr.d / add / sc.d / bnez; x6 -= 1.
+    const loop_start = pc;
+    emit_word(vm, &pc, rv_amo(0b00000, 7, 5, 0b011, 0));
+    const retry = pc;
+    emit_word(vm, &pc, rv_amo(0b00010, 0, 28, 0b011, 12));
+    emit_word(vm, &pc, rv_r(0x00, 7, 12, 0b000, 12));
+    emit_word(vm, &pc, rv_amo(0b00011, 12, 28, 0b011, 13));
+    emit_word(vm, &pc, rv_b(retry -% pc, 0, 13, 0b001));
+    emit_word(vm, &pc, rv_r(0x20, 7, 6, 0b000, 6));
+    emit_word(vm, &pc, rv_b(loop_start -% pc, 0, 6, 0b001));
+
+    // Hart 0: mask 0b1110 at data[16], SEND_IPI(a0 = &mask), exit. Others skip 7 words.
+    emit_word(vm, &pc, rv_b(8 * 4, 0, 10, 0b001));
+    emit_word(vm, &pc, rv_i(0b1110, 0, 0b000, 14, 0x13));
+    emit_word(vm, &pc, rv_s(16, 14, 5, 0b011));
+    emit_word(vm, &pc, rv_i(16, 5, 0b000, 10, 0x13));
+    emit_word(vm, &pc, rv_i(4, 0, 0b000, 17, 0x13));
+    emit_word(vm, &pc, 0x00000073);
+    emit_word(vm, &pc, rv_i(10, 0, 0b000, 17, 0x13));
+    emit_word(vm, &pc, 0x00000073);
+
+    // Harts 1..3: wfi; CLEAR_IPI; wait again until it reports one; count in; exit.
+    const idle = pc;
+    emit_word(vm, &pc, 0x10500073);
+    emit_word(vm, &pc, rv_i(3, 0, 0b000, 17, 0x13));
+    emit_word(vm, &pc, 0x00000073);
+    emit_word(vm, &pc, rv_b(idle -% pc, 0, 10, 0b000));
+    emit_word(vm, &pc, rv_amo(0b00000, 7, 30, 0b011, 0));
+    emit_word(vm, &pc, rv_i(10, 0, 0b000, 17, 0x13));
+    emit_word(vm, &pc, 0x00000073);
+    vm.regs.pc = JIT_TEST_CODE;
+}
+
+/// Sv39 test layout: page tables, code alias, superpage and read-only frame (physical).
+const SV39_ROOT: u64 = 0x100000;
+const SV39_L1_LOW: u64 = 0x101000;
+const SV39_L0_LOW: u64 = 0x102000;
+const SV39_L1_HIGH: u64 = 0x103000;
+const SV39_L0_HIGH: u64 = 0x104000;
+const SV39_SUPERPAGE_PA: u64 = 0x200000;
+const SV39_READ_ONLY_PA: u64 = 0x11000;
+/// Virtual base of the high mapping (VPN2 = 1): code alias, data, read-only, then a 2MB superpage.
+const SV39_HIGH_VA: u64 = 0x40000000;
+
+/// Write Sv39 tables and a program that enables them from Bare mode.
+/// Why: The first instruction writes satp, the next one is fetched through an identity
+/// mapping, then it jumps to a second virtual alias of the same code page (so the
+/// physically keyed decode cache is shared) and loops loads and stores over a 4K page
+/// and a superpage before SFENCE.VMA and exit.
+/// Returns: Virtual address of a snippet that stores to the read-only page.
+fn write_sv39_test_program(vm: *VM) u64 {
+    const mmu = kernel_vm.mmu;
+    const rx = mmu.PTE_V | mmu.PTE_R | mmu.PTE_X;
+    const rw = mmu.PTE_V | mmu.PTE_R | mmu.PTE_W;
+    write_pte(vm, SV39_ROOT, 0, SV39_L1_LOW, mmu.PTE_V);
+    write_pte(vm, SV39_L1_LOW, 0, SV39_L0_LOW, mmu.PTE_V);
+    write_pte(vm, SV39_L0_LOW, 1, JIT_TEST_CODE, rx); // Identity: VA 0x1000.
+    write_pte(vm, SV39_ROOT, 1, SV39_L1_HIGH, mmu.PTE_V);
+    write_pte(vm, SV39_L1_HIGH, 0, SV39_L0_HIGH, mmu.PTE_V);
+    write_pte(vm, SV39_L0_HIGH, 0, JIT_TEST_CODE, rx);
+    write_pte(vm, SV39_L0_HIGH, 1, JIT_TEST_DATA, rw);
+    write_pte(vm, SV39_L0_HIGH, 2, SV39_READ_ONLY_PA, mmu.PTE_V | mmu.PTE_R);
+    write_pte(vm, SV39_L1_HIGH, 1, SV39_SUPERPAGE_PA, rw); // 2MB leaf at VA 0x40200000.
+
+    var pc: u64 = JIT_TEST_CODE;
+    emit_word(vm, &pc, rv_i(0x180, 30, 0b001, 0, 0x73)); // csrrw x0, satp, x30
+    emit_word(vm, &pc, rv_i(0, 31, 0b000, 0, 0x67)); // jalr x0, 0(x31)
+    std.debug.assert(pc == JIT_TEST_CODE + 8);
+    emit_word(vm, &pc, rv_u((SV39_HIGH_VA >> 12) + 1, 5)); // x5 = data page VA
+    emit_word(vm, &pc, rv_i(7, 0, 0b000, 6, 0x13));
+    emit_word(vm, &pc, rv_i(200, 0, 0b000, 9, 0x13));
+    const loop_start = pc;
+    emit_word(vm, &pc, rv_s(0, 6, 5, 0b011)); // sd x6, 0(x5)
+    emit_word(vm, &pc, rv_i(0, 5, 0b011, 7, 0x03)); // ld x7, 0(x5)
+    emit_word(vm, &pc, rv_s(8, 7, 28, 0b011)); // sd x7, 8(x28)
+    emit_word(vm, &pc, rv_i(8, 28, 0b011, 29, 0x03)); // ld x29, 8(x28)
+    emit_word(vm, &pc, rv_r(0x20, 11, 9, 0b000, 9)); // x9 -= 1
+    emit_word(vm, &pc, rv_b(loop_start -% pc, 0, 9, 0b001));
+    emit_word(vm, &pc, 0x12000073); // sfence.vma x0, x0
+    emit_word(vm, &pc, rv_i(8, 28, 0b011, 29, 0x03));
+    emit_word(vm, &pc, rv_i(10, 0, 0b000, 17, 0x13));
+    emit_word(vm, &pc, 0x00000073);
+
+    // Fault snippet: sd x6, 0(read-only page VA).
+    const fault_va = SV39_HIGH_VA + (pc - JIT_TEST_CODE);
+    emit_word(vm, &pc, rv_u((SV39_HIGH_VA >> 12) + 2, 5));
+    emit_word(vm, &pc, rv_s(0, 6, 5, 0b011));
+
+    vm.regs.pc = JIT_TEST_CODE;
+    vm.regs.set(11, 1);
+    vm.regs.set(28, SV39_HIGH_VA + (1 << 21));
+    vm.regs.set(30, (mmu.SATP_MODE_SV39 << 60) | (SV39_ROOT >> 12));
+    vm.regs.set(31, SV39_HIGH_VA + 8);
+    return fault_va;
+}
+
+fn write_pte(vm: *VM, table: u64, index: u64, pa: u64, flags: u64) void {
+    std.mem.writeInt(u64, vm.memory[@intCast(table + index * 8)..][0..8], ((pa >> 12) << 10) | flags, .little);
+}
+
+/// Profiler test image: one PT_LOAD code segment plus .symtab/.strtab (main calls leaf).
+const PROFILE_TEST_ELF_SIZE: usize = 0x380;
+const PROFILE_TEST_MAIN: u64 = 0x1000;
+const PROFILE_TEST_LEAF: u64 = 0x101C;
+const PROFILE_TEST_LEAF_SIZE: u64 = 0xC;
+const PROFILE_TEST_CALLS: u64 = 50;
+
+/// Write a minimal RISC-V64 executable into elf (headers, code, symbols, section headers).
+/// Note: File layout: code at 0x100, .strtab at 0x200, .symtab at 0x240, section headers at 0x2C0.
+fn write_profile_test_elf(elf: *[PROFILE_TEST_ELF_SIZE]u8) void {
+    const code_offset: u64 = 0x100;
+    const strtab_offset: u64 = 0x200;
+    const strtab = "\x00main\x00leaf\x00";
+    const symtab_offset: u64 = 0x240;
+    const shdr_offset: u64 = 0x2C0;
+
+    // ELF header (64-bit, little-endian, executable, RISC-V).
+    @memcpy(elf[0..7], &[_]u8{ 0x7F, 'E', 'L', 'F', 2, 1, 1 });
+    std.mem.writeInt(u16, elf[16..18], 2, .little);
+    std.mem.writeInt(u16, elf[18..20], 243, .little);
+    std.mem.writeInt(u32, elf[20..24], 1, .little);
+    std.mem.writeInt(u64, elf[24..32], PROFILE_TEST_MAIN, .little);
+    std.mem.writeInt(u64, elf[32..40], 64, .little);
+    std.mem.writeInt(u64, elf[40..48], shdr_offset, .little);
+    std.mem.writeInt(u16, elf[52..54], 64, .little);
+    std.mem.writeInt(u16, elf[54..56], 56, .little);
+    std.mem.writeInt(u16, elf[56..58], 1, .little);
+    std.mem.writeInt(u16, elf[58..60], 64, .little);
+    std.mem.writeInt(u16, elf[60..62], 3, .little);
+
+    // Program header: code loaded at PROFILE_TEST_MAIN.
+    const code_size: u64 = PROFILE_TEST_LEAF + PROFILE_TEST_LEAF_SIZE - PROFILE_TEST_MAIN;
+    std.mem.writeInt(u32, elf[64..68], 1, .little);
+    std.mem.writeInt(u32, elf[68..72], 5, .little);
+    std.mem.writeInt(u64, elf[72..80], code_offset, .little);
+    std.mem.writeInt(u64, elf[80..88], PROFILE_TEST_MAIN, .little);
+    std.mem.writeInt(u64, elf[88..96], PROFILE_TEST_MAIN, .little);
+    std.mem.writeInt(u64, elf[96..104], code_size, .little);
+    std.mem.writeInt(u64, elf[104..112], code_size, .little);
+
+    // main: x9 = calls; loop { jal ra, leaf; x9 -= 1 } ; exit. leaf: two addi, ret.
+    const code = [_]u32{
+        rv_i(PROFILE_TEST_CALLS, 0, 0, 9, 0x13),
+        rv_i(1, 0, 0, 11, 0x13),
+        rv_j(PROFILE_TEST_LEAF - (PROFILE_TEST_MAIN + 8), 1),
+        rv_r(0x20, 11, 9, 0, 9), // sub x9, x9, x11
+        rv_b(@bitCast(@as(i64, -8)), 0, 9, 1), // bne x9, x0, loop
+        rv_i(10, 0, 0, 17, 0x13),
+        0x00000073, // ecall (exit)
+        rv_i(1, 12, 0, 12, 0x13),
+        rv_i(1, 12, 0, 12, 0x13),
+        rv_i(0, 1, 0, 0, 0x67), // jalr x0, 0(ra)
+    };
+    std.debug.assert(code.len * 4 == code_size);
+    for (code, 0..) |word, index| {
+        std.mem.writeInt(u32, elf[@intCast(code_offset + index * 4)..][0..4], word, .little);
+    }
+
+    // .strtab and .symtab (null symbol, then main and leaf as global functions).
+    @memcpy(elf[@intCast(strtab_offset)..][0..strtab.len], strtab);
+    const symbols = [_]struct { name: u32, addr: u64, size: u64 }{
+        .{ .name = 1, .addr = PROFILE_TEST_MAIN, .size = PROFILE_TEST_LEAF - PROFILE_TEST_MAIN },
+        .{ .name = 6, .addr = PROFILE_TEST_LEAF, .size = PROFILE_TEST_LEAF_SIZE },
+    };
+    for (symbols, 1..) |symbol, index| {
+        const entry = elf[@intCast(symtab_offset + index * 24)..][0..24];
+        std.mem.writeInt(u32, entry[0..4], symbol.name, .little);
+        entry[4] = 0x12; // STB_GLOBAL | STT_FUNC
+        std.mem.writeInt(u16, entry[6..8], 1, .little);
+        std.mem.writeInt(u64, entry[8..16], symbol.addr, .little);
+        std.mem.writeInt(u64, entry[16..24], symbol.size, .little);
+    }
+
+    // Section headers: null, .symtab (links .strtab), .strtab.
+    const symtab_header = elf[@intCast(shdr_offset + 64)..][0..64];
+    std.mem.writeInt(u32, symtab_header[4..8], 2, .little);
+    std.mem.writeInt(u64, symtab_header[24..32], symtab_offset, .little);
+    std.mem.writeInt(u64, symtab_header[32..40], 3 * 24, .little);
+    std.mem.writeInt(u32, symtab_header[40..44], 2, .little);
+    std.mem.writeInt(u32, symtab_header[44..48], 1, .little);
+    std.mem.writeInt(u64, symtab_header[56..64], 24, .little);
+    const strtab_header = elf[@intCast(shdr_offset + 128)..][0..64];
+    std.mem.writeInt(u32, strtab_header[4..8], 3, .little);
+    std.mem.writeInt(u64, strtab_header[24..32], strtab_offset, .little);
+    std.mem.writeInt(u64, strtab_header[32..40], strtab.len, .little);
+}
+
+/// Record/replay test shape: a syscall loop storing running sums across three data pages.
+const REPLAY_TEST_CALLS: u64 = 40;
+const REPLAY_TEST_INSTRUCTIONS: u64 = 3 + REPLAY_TEST_CALLS * 7 + 2;
+const REPLAY_TEST_INTERVAL: u64 = 32;
+/// Seek target between two checkpoints.
+const REPLAY_TEST_SEEK: u64 = 100;
+
+/// Host state the recorded syscall handler reads (replay must never touch it).
+var replay_test_rng = TestRng{ .state = 0x5EED };
+
+fn replay_test_syscall(syscall_num: u32, arg1: u64, arg2: u64, arg3: u64, arg4: u64) u64 {
+    _ = syscall_num;
+    _ = arg1;
+    _ = arg2;
+    _ = arg3;
+    _ = arg4;
+    return replay_test_rng.next();
+}
+
+/// Write replay program into vm: REPLAY_TEST_CALLS times { a0 = syscall 10; x18 += a0;
+/// store x18; advance 256 bytes }, then SBI shutdown.
+fn write_replay_test_program(vm: *VM) void {
+    var pc: u64 = JIT_TEST_CODE;
+    emit_word(vm, &pc, rv_u(JIT_TEST_DATA >> 12, 5));
+    emit_word(vm, &pc, rv_i(REPLAY_TEST_CALLS, 0, 0b000, 9, 0x13));
+    emit_word(vm, &pc, rv_i(1, 0, 0b000, 11, 0x13));
+    const loop_start = pc;
+    emit_word(vm, &pc, rv_i(10, 0, 0b000, 17, 0x13));
+    emit_word(vm, &pc, 0x00000073);
+    emit_word(vm, &pc, rv_r(0x00, 10, 18, 0b000, 18));
+    emit_word(vm, &pc, rv_s(0, 18, 5, 0b011));
+    emit_word(vm, &pc, rv_i(256, 5, 0b000, 5, 0x13));
+    emit_word(vm, &pc, rv_r(0x20, 11, 9, 0b000, 9));
+    emit_word(vm, &pc, rv_b(loop_start -% pc, 0, 9, 0b001));
+    emit_word(vm, &pc, rv_i(8, 0, 0b000, 17, 0x13));
+    emit_word(vm, &pc, 0x00000073);
+    vm.regs.pc = JIT_TEST_CODE;
+}
+
+/// Virtio test layout: ring pages for each queue, a shared message, block request pieces.
+const VIRTIO_TEST_CONSOLE_DESC: u64 = 0x20000;
+const VIRTIO_TEST_CONSOLE_AVAIL: u64 = 0x21000;
+const VIRTIO_TEST_CONSOLE_USED: u64 = 0x22000;
+const VIRTIO_TEST_BLOCK_DESC: u64 = 0x23000;
+const VIRTIO_TEST_BLOCK_AVAIL: u64 = 0x24000;
+const VIRTIO_TEST_BLOCK_USED: u64 = 0x25000;
+const VIRTIO_TEST_MESSAGE: u64 = 0x26000;
+const VIRTIO_TEST_MESSAGE_LEN: usize = 2048 + 1000;
+const VIRTIO_TEST_HEADERS: u64 = 0x27000;
+const VIRTIO_TEST_READ_BUFFER: u64 = 0x28000;
+const VIRTIO_TEST_STATUS: u64 = 0x29000;
+const VIRTIO_TEST_QUEUE_SIZE: u32 = 8;
+const VIRTIO_TEST_DISK_SECTORS: u64 = 8;
+/// ACKNOWLEDGE | DRIVER | FEATURES_OK, then DRIVER_OK on top.
+const VIRTIO_TEST_FEATURES_OK: u32 = 1 | 2 | 8;
+const VIRTIO_TEST_DRIVER_OK: u32 = VIRTIO_TEST_FEATURES_OK | 4;
+
+/// Write virtio test: rings and buffers in RAM, plus a guest driver that negotiates
+/// VERSION_1, sets up one queue per device, notifies each once, reads InterruptStatus
+/// (x28), block capacity (x29) and block Status (x30), then SBI shutdown.
+fn write_virtio_test_program(vm: *VM, console_base: u64, block_base: u64) void {
+    const virtio = kernel_vm.virtio;
+
+    // Console transmitq: one message split over a two-descriptor chain.
+    for (vm.memory[VIRTIO_TEST_MESSAGE..][0..VIRTIO_TEST_MESSAGE_LEN], 0..) |*byte, index| {
+        byte.* = 'a' + @as(u8, @intCast(index % 26));
+    }
+    write_virtq_desc(vm, VIRTIO_TEST_CONSOLE_DESC, 0, VIRTIO_TEST_MESSAGE, 2048, 1, 1);
+    write_virtq_desc(vm, VIRTIO_TEST_CONSOLE_DESC, 1, VIRTIO_TEST_MESSAGE + 2048, 1000, 0, 0);
+    write_virtq_avail(vm, VIRTIO_TEST_CONSOLE_AVAIL, &[_]u16{0});
+
+    // Block: IN of sectors 1-2 (chain 0-2), then OUT of the message's first sector to sector 3 (chain 3-5).
+    std.mem.writeInt(u32, vm.memory[VIRTIO_TEST_HEADERS..][0..4], virtio.BLK_T_IN, .little);
+    std.mem.writeInt(u64, vm.memory[VIRTIO_TEST_HEADERS + 8 ..][0..8], 1, .little);
+    std.mem.writeInt(u32, vm.memory[VIRTIO_TEST_HEADERS + 16 ..][0..4], virtio.BLK_T_OUT, .little);
+    std.mem.writeInt(u64, vm.memory[VIRTIO_TEST_HEADERS + 24 ..][0..8], 3, .little);
+    vm.memory[VIRTIO_TEST_STATUS] = 0xFF;
+    vm.memory[VIRTIO_TEST_STATUS + 1] = 0xFF;
+    write_virtq_desc(vm, VIRTIO_TEST_BLOCK_DESC, 0, VIRTIO_TEST_HEADERS, 16, 1, 1);
+    write_virtq_desc(vm, VIRTIO_TEST_BLOCK_DESC, 1, VIRTIO_TEST_READ_BUFFER, 1024, 1 | 2, 2);
+    write_virtq_desc(vm, VIRTIO_TEST_BLOCK_DESC, 2, VIRTIO_TEST_STATUS, 1, 2, 0);
+    write_virtq_desc(vm, VIRTIO_TEST_BLOCK_DESC, 3, VIRTIO_TEST_HEADERS + 16, 16, 1, 4);
+    write_virtq_desc(vm, VIRTIO_TEST_BLOCK_DESC, 4, VIRTIO_TEST_MESSAGE, 512, 1, 5);
+    write_virtq_desc(vm, VIRTIO_TEST_BLOCK_DESC, 5, VIRTIO_TEST_STATUS + 1, 1, 2, 0);
+    write_virtq_avail(vm, VIRTIO_TEST_BLOCK_AVAIL, &[_]u16{ 0, 3 });
+
+    // Guest driver: x5 = console base, x6 = block base, x7 = scratch value.
+    var pc: u64 = JIT_TEST_CODE;
+    const devices = [_]struct { base: u5, queue: u32, desc: u64, avail: u64, used: u64 }{
+        .{ .base = 5, .queue = 1, .desc = VIRTIO_TEST_CONSOLE_DESC, .avail = VIRTIO_TEST_CONSOLE_AVAIL, .used = VIRTIO_TEST_CONSOLE_USED },
+        .{ .base = 6, .queue = 0, .desc = VIRTIO_TEST_BLOCK_DESC, .avail = VIRTIO_TEST_BLOCK_AVAIL, .used = VIRTIO_TEST_BLOCK_USED },
+    };
+    for (devices) |device| {
+        emit_mmio_store(vm, &pc, device.base, 0x070, 1);
+        emit_mmio_store(vm, &pc, device.base, 0x070, 1 | 2);
+        emit_mmio_store(vm, &pc, device.base, 0x024, 1);
+        emit_mmio_store(vm, &pc, device.base, 0x020, 1);
+        emit_mmio_store(vm, &pc, device.base, 0x070, VIRTIO_TEST_FEATURES_OK);
+        emit_mmio_store(vm, &pc, device.base, 0x030, device.queue);
+        emit_mmio_store(vm, &pc, device.base, 0x038, VIRTIO_TEST_QUEUE_SIZE);
+        emit_mmio_store(vm, &pc, device.base, 0x080, @intCast(device.desc));
+        emit_mmio_store(vm, &pc, device.base, 0x090, @intCast(device.avail));
+        emit_mmio_store(vm, &pc, device.base, 0x0A0, @intCast(device.used));
+        emit_mmio_store(vm, &pc, device.base, 0x044, 1);
+        emit_mmio_store(vm, &pc, device.base, 0x070, VIRTIO_TEST_DRIVER_OK);
+        emit_mmio_store(vm, &pc, device.base, 0x050, device.queue);
+    }
+    emit_word(vm, &pc, rv_i(0x060, 5, 0b010, 28, 0x03));
+    emit_word(vm, &pc, rv_i(0x100, 6, 0b011, 29, 0x03));
+    emit_word(vm, &pc, rv_i(0x070, 6, 0b110, 30, 0x03));
+    emit_word(vm, &pc, rv_i(8, 0, 0b000, 17, 0x13));
+    emit_word(vm, &pc, 0x00000073);
+
+    vm.regs.set(5, console_base);
+    vm.regs.set(6, block_base);
+    vm.regs.pc = JIT_TEST_CODE;
+}
+
+/// x7 = value (LUI + ADDI), then SW x7 to offset(base).
+fn emit_mmio_store(vm: *VM, pc: *u64, base: u5, offset: u64, value: u32) void {
+    std.debug.assert(value < 0x7FFF_F800);
+    const upper = (@as(u64, value) + 0x800) >> 12;
+    emit_word(vm, pc, rv_u(upper, 7));
+    emit_word(vm, pc, rv_i(@as(u64, value) -% (upper << 12), 7, 0b000, 7, 0x13));
+    emit_word(vm, pc, rv_s(offset, 7, base, 0b010));
+}
+
+/// Split-virtqueue descriptor (addr, len, flags, next) at index in table.
+fn write_virtq_desc(vm: *VM, table: u64, index: u64, addr: u64, len: u32, flags: u16, next: u16) void {
+    const entry = vm.memory[@intCast(table + index * 16)..][0..16];
+    std.mem.writeInt(u64, entry[0..8], addr, .little);
+    std.mem.writeInt(u32, entry[8..12], len, .little);
+    std.mem.writeInt(u16, entry[12..14], flags, .little);
+    std.mem.writeInt(u16, entry[14..16], next, .little);
+}
+
+/// Available ring publishing heads (flags 0, idx = heads.len).
+fn write_virtq_avail(vm: *VM, avail: u64, heads: []const u16) void {
+    for (heads, 0..) |head, slot| {
+        std.mem.writeInt(u16, vm.memory[@intCast(avail + 4 + 2 * slot)..][0..2], head, .little);
+    }
+    std.mem.writeInt(u16, vm.memory[@intCast(avail + 2)..][0..2], @intCast(heads.len), .little);
+}
+
+fn read_u16(vm: *const VM, addr: u64) u16 {
+    return std.mem.readInt(u16, vm.memory[@intCast(addr)..][0..2], .little);
+}
+
+fn read_u32(vm: *const VM, addr: u64) u32 {
+    return std.mem.readInt(u32, vm.memory[@intCast(addr)..][0..4], .little);
+}
+
+/// Image cache test ELF: 8KB read-only text (page-aligned in file and guest), small data + bss.
+const IMAGE_TEST_ELF_SIZE: usize = 0x3100;
+const IMAGE_TEST_TEXT: u64 = 0x10000;
+const IMAGE_TEST_TEXT_SIZE: u64 = 0x2000;
+const IMAGE_TEST_DATA: u64 = 0x20000;
+const IMAGE_TEST_WORD: u32 = 0x05A5A5A5;
+
+/// Write image test ELF: text increments the word at its second page, copies it to a0, exits.
+fn write_image_test_elf(elf: *[IMAGE_TEST_ELF_SIZE]u8) void {
+    // ELF header (64-bit, little-endian, executable, RISC-V), two program headers.
+    @memcpy(elf[0..7], &[_]u8{ 0x7F, 'E', 'L', 'F', 2, 1, 1 });
+    std.mem.writeInt(u16, elf[16..18], 2, .little);
+    std.mem.writeInt(u16, elf[18..20], 243, .little);
+    std.mem.writeInt(u32, elf[20..24], 1, .little);
+    std.mem.writeInt(u64, elf[24..32], IMAGE_TEST_TEXT, .little);
+    std.mem.writeInt(u64, elf[32..40], 64, .little);
+    std.mem.writeInt(u16, elf[52..54], 64, .little);
+    std.mem.writeInt(u16, elf[54..56], 56, .little);
+    std.mem.writeInt(u16, elf[56..58], 2, .little);
+
+    const segments = [_]struct { flags: u32, offset: u64, vaddr: u64, filesz: u64, memsz: u64 }{
+        .{ .flags = 5, .offset = 0x1000, .vaddr = IMAGE_TEST_TEXT, .filesz = IMAGE_TEST_TEXT_SIZE, .memsz = IMAGE_TEST_TEXT_SIZE },
+        .{ .flags = 6, .offset = 0x3000, .vaddr = IMAGE_TEST_DATA, .filesz = 0x100, .memsz = 0x1000 },
+    };
+    for (segments, 0..) |segment, index| {
+        const phdr = elf[64 + index * 56 ..][0..56];
+        std.mem.writeInt(u32, phdr[0..4], 1, .little);
+        std.mem.writeInt(u32, phdr[4..8], segment.flags, .little);
+        std.mem.writeInt(u64, phdr[8..16], segment.offset, .little);
+        std.mem.writeInt(u64, phdr[16..24], segment.vaddr, .little);
+        std.mem.writeInt(u64, phdr[24..32], segment.vaddr, .little);
+        std.mem.writeInt(u64, phdr[32..40], segment.filesz, .little);
+        std.mem.writeInt(u64, phdr[40..48], segment.memsz, .little);
+    }
+
+    // lui x5, text+0x1000; lw a0, 0(x5); addi a0, a0, 1; sw a0, 0(x5); SBI shutdown.
+    const code = [_]u32{
+        rv_u((IMAGE_TEST_TEXT + 0x1000) >> 12, 5),
+        rv_i(0, 5, 2, 10, 0x03),
+        rv_i(1, 10, 0, 10, 0x13),
+        rv_s(0, 10, 5, 2),
+        rv_i(8, 0, 0, 17, 0x13),
+        0x00000073,
+    };
+    for (code, 0..) |word, index| {
+        std.mem.writeInt(u32, elf[0x1000 + index * 4 ..][0..4], word, .little);
+    }
+    std.mem.writeInt(u32, elf[0x2000..][0..4], IMAGE_TEST_WORD, .little);
+    std.mem.writeInt(u32, elf[0x3000..][0..4], IMAGE_TEST_WORD, .little);
+}
+
+/// Timer test: one-second ticks (an hour standalone, a minute per SMP hart).
+const TIMER_TEST_TICKS: u64 = 3600;
+const TIMER_TEST_SMP_TICKS: u64 = 60;
+const TIMER_TEST_HANDLER: u64 = JIT_TEST_CODE + 0x100;
+
+/// Write timer test: arm SET_TIMER one second ahead, enable the supervisor timer
+/// interrupt, then `wfi` until the handler has counted x9 ticks down to zero.
+/// Handler: x9 -= 1; re-arm one second after now (or disarm at zero); SRET.
+fn write_timer_test_program(vm: *VM, ticks: u64) void {
+    const one_second = kernel_vm.csr.TIMEBASE_HZ;
+    var pc: u64 = JIT_TEST_CODE;
+    emit_word(vm, &pc, rv_i(kernel_vm.csr.STVEC, 5, 0b001, 0, 0x73));
+    emit_word(vm, &pc, rv_i(kernel_vm.csr.SIE, 6, 0b001, 0, 0x73));
+    emit_word(vm, &pc, rv_i(kernel_vm.csr.TIME, 0, 0b010, 7, 0x73));
+    emit_word(vm, &pc, rv_r(0x00, 20, 7, 0b000, 10));
+    emit_word(vm, &pc, rv_i(0, 0, 0b000, 17, 0x13));
+    emit_word(vm, &pc, 0x00000073);
+    // csrrsi x0, sstatus, SIE (zimm travels in the rs1 field).
+    emit_word(vm, &pc, rv_i(kernel_vm.csr.SSTATUS, @intCast(kernel_vm.csr.SSTATUS_SIE), 0b110, 0, 0x73));
+    const idle_loop = pc;
+    emit_word(vm, &pc, 0x10500073);
+    emit_word(vm, &pc, rv_b(idle_loop -% pc, 0, 9, 0b001));
+    emit_word(vm, &pc, rv_i(10, 0, 0b000, 17, 0x13));
+    emit_word(vm, &pc, 0x00000073);
+
+    pc = TIMER_TEST_HANDLER;
+    emit_word(vm, &pc, rv_r(0x20, 11, 9, 0b000, 9));
+    emit_word(vm, &pc, rv_i(kernel_vm.csr.TIME, 0, 0b010, 7, 0x73));
+    emit_word(vm, &pc, rv_r(0x00, 20, 7, 0b000, 10));
+    emit_word(vm, &pc, rv_b(8, 0, 9, 0b001));
+    emit_word(vm, &pc, rv_i(std.math.maxInt(u64), 0, 0b000, 10, 0x13));
+    emit_word(vm, &pc, rv_i(0, 0, 0b000, 17, 0x13));
+    emit_word(vm, &pc, 0x00000073);
+    emit_word(vm, &pc, 0x10200073);
+
+    vm.regs.set(5, TIMER_TEST_HANDLER);
+    vm.regs.set(6, kernel_vm.csr.STI);
+    vm.regs.set(9, ticks);
+    vm.regs.set(11, 1);
+    vm.regs.set(20, one_second);
+    vm.regs.pc = JIT_TEST_CODE;
+}
+
+/// Run VM to halt in slices of max_instructions; returns instructions retired.
+fn run_to_halt(vm: *VM, slice: u64) u64 {
+    var total: u64 = 0;
+    vm.start();
+    while (true) {
+        const result = vm.run(.{ .max_instructions = slice });
+        total += result.instructions;
+        if (result.exit != .budget_exhausted) {
+            std.debug.assert(result.exit == .halted);
+            return total;
+        }
+    }
+}
+
+/// Deterministic LCG (same constants as the fuzz suites).
+const TestRng = struct {
+    state: u64,
+
+    fn next(self: *TestRng) u64 {
+        self.state = self.state *% 6364136223846793005 +% 1442695040888963407;
+        return self.state;
+    }
+
+    fn below(self: *TestRng, bound: u64) u64 {
+        return (self.next() >> 33) % bound;
+    }
+
+    /// x0 or one of x10..x20.
+    fn register(self: *TestRng) u5 {
+        const pick = self.below(12);
+        return if (pick == 0) 0 else @intCast(9 + pick);
+    }
+};
+
+fn emit_word(vm: *VM, pc: *u64, word: u32) void {
+    std.mem.writeInt(u32, vm.memory[@intCast(pc.*)..][0..4], word, .little);
+    pc.* += 4;
+}
+
+fn rv_r(funct7: u32, rs2: u5, rs1: u5, funct3: u32, rd: u5) u32 {
+    return (funct7 << 25) | (@as(u32, rs2) << 20) | (@as(u32, rs1) << 15) | (funct3 << 12) | (@as(u32, rd) << 7) | 0x33;
+}
+
+fn rv_i(imm: u64, rs1: u5, funct3: u32, rd: u5, opcode: u32) u32 {
+    return (@as(u32, @intCast(imm & 0xFFF)) << 20) | (@as(u32, rs1) << 15) | (funct3 << 12) | (@as(u32, rd) << 7) | opcode;
+}
+
+fn rv_s(imm: u64, rs2: u5, rs1: u5, funct3: u32) u32 {
+    const bits: u32 = @intCast(imm & 0xFFF);
+    return ((bits >> 5) << 25) | (@as(u32, rs2) << 20) | (@as(u32, rs1) << 15) | (funct3 << 12) | ((bits & 0x1F) << 7) | 0x23;
+}
+
+fn rv_b(imm: u64, rs2: u5, rs1: u5, funct3: u32) u32 {
+    const bits: u32 = @intCast(imm & 0x1FFE);
+    return (((bits >> 12) & 1) << 31) | (((bits >> 5) & 0x3F) << 25) | (@as(u32, rs2) << 20) | (@as(u32, rs1) << 15) |
+        (funct3 << 12) | (((bits >> 1) & 0xF) << 8) | (((bits >> 11) & 1) << 7) | 0x63;
+}
+
+fn rv_amo(funct5: u32, rs2: u5, rs1: u5, funct3: u32, rd: u5) u32 {
+    return (funct5 << 27) | (@as(u32, rs2) << 20) | (@as(u32, rs1) << 15) | (funct3 << 12) | (@as(u32, rd) << 7) | 0x2F;
+}
+
+fn rv_j(imm: u64, rd: u5) u32 {
+    const bits: u32 = @intCast(imm & 0x1FFFFE);
+    return (((bits >> 20) & 1) << 31) | (((bits >> 1) & 0x3FF) << 21) | (((bits >> 11) & 1) << 20) |
+        (((bits >> 12) & 0xFF) << 12) | (@as(u32, rd) << 7) | 0x6F;
+}
+
+fn rv_u(imm20: u64, rd: u5) u32 {
+    return (@as(u32, @intCast(imm20 & 0xFFFFF)) << 12) | (@as(u32, rd) << 7) | 0x37;
+}
+
@@ -0,0 +1,161 @@
+const std = @import("std");
+const vm_options = @import("vm_options");
+
+/// Binary trace ring for the RISC-V VM.
+/// Grain Style: Static allocation, no formatting on the hot path.
+/// ~<~ Glow Waterbend: events flow into the ring, words come out only on demand.
+
+/// Whether tracing is compiled in (`zig build -Dvm-trace=true`).
+/// Why: With tracing off, Trace is zero-sized and record() is an empty inline call,
+/// so release builds pay nothing.
+pub const enabled: bool = vm_options.trace_enabled;
+
+/// Number of events kept in the ring (oldest events are overwritten).
+pub const RING_SIZE: usize = 4096;
+
+comptime {
+    // Assert: ring size must be a power of two (index is a mask of the sequence number).
+    std.debug.assert(std.math.isPowerOfTwo(RING_SIZE));
+}
+
+/// Trace event kind.
+pub const EventKind = enum(u8) {
+    /// Non-standard opcode decoded via compiler compatibility mapping (inst, opcode).
+    decode_compat,
+    /// Unsupported variant of a known opcode decoded (inst, opcode).
+    decode_invalid,
+    /// Load executed (addr = effective address).
+    load,
+    /// Store executed (addr = effective address).
+    store,
+    /// Load/store base x8 == 0 retried with sp (addr = rejected address, args[0] = sp).
+    stack_fallback,
+    /// Indirect jump (addr = target).
+    jump,
+    /// ECALL (addr = a7, args = a0..a3).
+    ecall,
+    /// Memory access fault (addr = effective address, args[0] = access size).
+    fault,
+    /// Loader copied PT_LOAD segment (addr = vaddr, args = filesz, memsz, offset).
+    loader_segment,
+    /// Loader set entry point (addr = entry).
+    loader_entry,
+};
+
+/// One trace event (fixed-size, binary).
+/// Why: Recording is a struct copy into the ring; formatting happens in dump().
+pub const Event = struct {
+    /// Event sequence number (assigned by record, monotonic per VM).
+    seq: u64 = 0,
+    /// Guest PC at the event.
+    pc: u64,
+    /// Effective address, jump target, or syscall number (see EventKind).
+    addr: u64 = 0,
+    /// Event-specific arguments (see EventKind).
+    args: [4]u64 = [_]u64{0} ** 4,
+    /// Raw instruction word (0 if not applicable).
+    inst: u32 = 0,
+    /// Event kind.
+    kind: EventKind,
+    /// Opcode (bits [6:0] of inst).
+    opcode: u8 = 0,
+};
+
+/// Trace ring (fixed-size, overwrites oldest).
+pub const TraceRing = struct {
+    /// Event storage (valid entries: last min(count, RING_SIZE) sequence numbers).
+    events: [RING_SIZE]Event = undefined,
+    /// Total events recorded (next sequence number).
+    count: u64 = 0,
+
+    const Self = @This();
+
+    /// Record event (sequence number assigned here).
+    pub inline fn record(self: *Self, event: Event) void {
+        var stored = event;
+        stored.seq = self.count;
+        self.events[@as(usize, @truncate(self.count)) & (RING_SIZE - 1)] = stored;
+        self.count += 1;
+    }
+
+    /// Number of events currently held in the ring.
+    pub fn len(self: *const Self) usize {
+        return @intCast(@min(self.count, RING_SIZE));
+    }
+
+    /// Drop all events.
+    pub fn clear(self: *Self) void {
+        self.count = 0;
+    }
+
+    /// Format ring contents oldest-first.
+    /// Why: Only called on demand (fault, debugger, test), never on the hot path.
+    pub fn dump(self: *const Self, writer: anytype) !void {
+        const held = self.len();
+        try writer.print("[vm_trace] {} events ({} recorded)\n", .{ held, self.count });
+
+        var seq = self.count - held;
+        while (seq < self.count) : (seq += 1) {
+            const event = &self.events[@as(usize, @truncate(seq)) & (RING_SIZE - 1)];
+            std.debug.assert(event.seq == seq);
+            try format_event(event, writer);
+        }
+    }
+};
+
+/// Tracing compiled out: zero-sized, every call is a no-op.
+pub const NullTrace = struct {
+    const Self = @This();
+
+    pub inline fn record(self: *Self, event: Event) void {
+        _ = self;
+        _ = event;
+    }
+
+    pub fn len(self: *const Self) usize {
+        _ = self;
+        return 0;
+    }
+
+    pub fn clear(self: *Self) void {
+        _ = self;
+    }
+
+    pub fn dump(self: *const Self, writer: anytype) !void {
+        _ = self;
+        try writer.print("[vm_trace] tracing disabled (build with -Dvm-trace=true)\n", .{});
+    }
+};
+
+/// Trace type embedded in VM (ring when enabled, zero-sized otherwise).
+pub const Trace = if (enabled) TraceRing else NullTrace;
+
+/// Format single event as one line.
+fn format_event(event: *const Event, writer: anytype) !void {
+    try writer.print("#{d} pc=0x{x} {s}", .{ event.seq, event.pc, @tagName(event.kind) });
+    switch (event.kind) {
+        .decode_compat, .decode_invalid => try writer.print(" inst=0x{x:0>8} opcode=0x{x:0>2} funct3=0b{b:0>3}", .{
+            event.inst,
+            event.opcode,
+            @as(u3, @truncate(event.inst >> 12)),
+        }),
+        .load, .store, .jump => try writer.print(" inst=0x{x:0>8} addr=0x{x}", .{ event.inst, event.addr }),
+        .stack_fallback => try writer.print(" inst=0x{x:0>8} rejected=0x{x} sp=0x{x}", .{ event.inst, event.addr, event.args[0] }),
+        .ecall => try writer.print(" a7={d} a0=0x{x} a1=0x{x} a2=0x{x} a3=0x{x}", .{
+            event.addr,
+            event.args[0],
+            event.args[1],
+            event.args[2],
+            event.args[3],
+        }),
+        .fault => try writer.print(" inst=0x{x:0>8} addr=0x{x} size={d}", .{ event.inst, event.addr, event.args[0] }),
+        .loader_segment => try writer.print(" vaddr=0x{x} filesz={d} memsz={d} offset={d}", .{
+            event.addr,
+            event.args[0],
+            event.args[1],
+            event.args[2],
+        }),
+        .loader_entry => try writer.print(" entry=0x{x}", .{event.addr}),
+    }
+    try writer.writeAll("\n");
+}
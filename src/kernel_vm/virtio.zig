@@ -0,0 +1,693 @@
+const std = @import("std");
+const VM = @import("vm.zig").VM;
+const vm_memory = @import("memory.zig");
+
+/// Virtio MMIO devices (console, block) with split virtqueues in guest RAM.
+/// Grain Style: Caller-owned devices, fixed slot table, bounds-checked ring access.
+/// ~<~ Glow Waterbend: buffers pool in the rings; one notify lets them all flow.
+///
+/// Why: SBI CONSOLE_PUTCHAR costs one ECALL per byte. With virtio the guest queues
+/// kilobytes in descriptor rings and traps once per notification, and the host can
+/// back a block device with a local file.
+/// Note: Register layout follows virtio-mmio version 2 (virtio 1.2 §4.2.2), split
+/// virtqueues only, without indirect descriptors or event index.
+/// Note: Requests complete synchronously inside the guest's QueueNotify store. The VM
+/// has no interrupt controller, so drivers poll the used ring or InterruptStatus.
+/// Note: Descriptor addresses are guest-physical. Device writes into RAM go through
+/// VM.write_memory (dirty pages for snapshots and replay, stale decodes dropped).
+/// Note: Block contents are host state: replay assumes the same disk image.
+
+/// First device window (64 GiB: above the largest guest RAM, reachable through Sv39).
+pub const MMIO_BASE: u64 = 0x10_0000_0000;
+/// Bytes per device window (device n lives at MMIO_BASE + n * MMIO_STRIDE).
+pub const MMIO_STRIDE: u64 = 0x1000;
+/// Device windows on a bus.
+pub const MAX_DEVICES: usize = 8;
+/// Largest queue a driver may configure (QueueNumMax).
+pub const QUEUE_SIZE_MAX: u16 = 256;
+/// Block device sector size (capacity and request sectors count these).
+pub const SECTOR_SIZE: u64 = 512;
+/// Host console input buffered until the guest posts receive buffers.
+pub const CONSOLE_INPUT_SIZE: usize = 4096;
+
+comptime {
+    // Assert: device windows must never overlap guest RAM.
+    std.debug.assert(MMIO_BASE >= vm_memory.MAX_SIZE);
+}
+
+/// Register offsets (virtio-mmio version 2).
+const REG_MAGIC: u64 = 0x000;
+const REG_VERSION: u64 = 0x004;
+const REG_DEVICE_ID: u64 = 0x008;
+const REG_VENDOR_ID: u64 = 0x00C;
+const REG_DEVICE_FEATURES: u64 = 0x010;
+const REG_DEVICE_FEATURES_SEL: u64 = 0x014;
+const REG_DRIVER_FEATURES: u64 = 0x020;
+const REG_DRIVER_FEATURES_SEL: u64 = 0x024;
+const REG_QUEUE_SEL: u64 = 0x030;
+const REG_QUEUE_NUM_MAX: u64 = 0x034;
+const REG_QUEUE_NUM: u64 = 0x038;
+const REG_QUEUE_READY: u64 = 0x044;
+const REG_QUEUE_NOTIFY: u64 = 0x050;
+const REG_INTERRUPT_STATUS: u64 = 0x060;
+const REG_INTERRUPT_ACK: u64 = 0x064;
+const REG_STATUS: u64 = 0x070;
+const REG_QUEUE_DESC_LOW: u64 = 0x080;
+const REG_QUEUE_DESC_HIGH: u64 = 0x084;
+const REG_QUEUE_DRIVER_LOW: u64 = 0x090;
+const REG_QUEUE_DRIVER_HIGH: u64 = 0x094;
+const REG_QUEUE_DEVICE_LOW: u64 = 0x0A0;
+const REG_QUEUE_DEVICE_HIGH: u64 = 0x0A4;
+const REG_CONFIG_GENERATION: u64 = 0x0FC;
+const REG_CONFIG: u64 = 0x100;
+
+const MAGIC_VALUE: u32 = 0x74726976; // "virt"
+const MMIO_VERSION: u32 = 2;
+const VENDOR_ID: u32 = 0x4D565958; // "XYVM"
+
+/// Device status bits.
+pub const STATUS_ACKNOWLEDGE: u32 = 1;
+pub const STATUS_DRIVER: u32 = 2;
+pub const STATUS_DRIVER_OK: u32 = 4;
+pub const STATUS_FEATURES_OK: u32 = 8;
+pub const STATUS_NEEDS_RESET: u32 = 64;
+pub const STATUS_FAILED: u32 = 128;
+
+/// VIRTIO_F_VERSION_1 (feature bit 32: bit 0 of feature word 1).
+const FEATURE_VERSION_1_HIGH: u32 = 1;
+/// VIRTIO_BLK_F_RO (feature bit 5).
+const FEATURE_BLK_RO: u32 = 1 << 5;
+
+const DESC_F_NEXT: u16 = 1;
+const DESC_F_WRITE: u16 = 2;
+const DESC_SIZE: u64 = 16;
+const INTERRUPT_USED_BUFFER: u32 = 1;
+
+/// Block request types and status codes (virtio 1.2 §5.2.6).
+pub const BLK_T_IN: u32 = 0;
+pub const BLK_T_OUT: u32 = 1;
+pub const BLK_T_FLUSH: u32 = 4;
+pub const BLK_T_GET_ID: u32 = 8;
+pub const BLK_S_OK: u8 = 0;
+pub const BLK_S_IOERR: u8 = 1;
+pub const BLK_S_UNSUPP: u8 = 2;
+const BLK_HEADER_SIZE: u32 = 16;
+const BLK_ID = "xy-virtio-blk";
+
+/// Console queues: 0 = receiveq (host to guest), 1 = transmitq (guest to host).
+const CONSOLE_RECEIVEQ: u32 = 0;
+const CONSOLE_TRANSMITQ: u32 = 1;
+/// Replay input numbers for console input (Source.console).
+const CONSOLE_INPUT_COUNT: u64 = 0;
+const CONSOLE_INPUT_BYTE: u64 = 1;
+
+/// Bounce buffer for file-backed reads (bytes per pread).
+const FILE_CHUNK_SIZE: usize = 4096;
+
+/// Virtio device IDs.
+pub const DeviceId = enum(u32) {
+    block = 2,
+    console = 3,
+};
+
+/// A malformed ring or descriptor chain (the device then needs a reset).
+const RingError = error{BadDescriptor};
+
+/// Driver-configured state of one virtqueue.
+const Queue = struct {
+    /// Entries (0 until the driver writes QueueNum).
+    num: u16 = 0,
+    ready: bool = false,
+    /// Guest-physical addresses of the descriptor table, available and used rings.
+    desc: u64 = 0,
+    driver: u64 = 0,
+    device: u64 = 0,
+    /// Next available-ring entry the device will consume.
+    last_avail: u16 = 0,
+};
+
+/// One descriptor read from a table.
+const Descriptor = struct {
+    addr: u64,
+    len: u32,
+    flags: u16,
+    next: u16,
+
+    fn writable(self: Descriptor) bool {
+        return self.flags & DESC_F_WRITE != 0;
+    }
+};
+
+/// virtio-console state (single port, no multiport).
+pub const Console = struct {
+    /// Host input not yet delivered (FIFO ring).
+    input: [CONSOLE_INPUT_SIZE]u8 = undefined,
+    input_head: usize = 0,
+    input_len: usize = 0,
+    /// Bytes the guest transmitted.
+    bytes_out: u64 = 0,
+    /// Bytes delivered to the guest.
+    bytes_in: u64 = 0,
+};
+
+/// virtio-blk state.
+pub const Block = struct {
+    backend: Backend,
+    /// Capacity in SECTOR_SIZE sectors.
+    capacity: u64,
+    read_only: bool,
+    bytes_read: u64 = 0,
+    bytes_written: u64 = 0,
+
+    /// Disk contents: host memory (tests, RAM disks) or a local file.
+    pub const Backend = union(enum) {
+        memory: []u8,
+        file: std.fs.File,
+    };
+};
+
+/// One virtio MMIO device (transport registers plus device state).
+/// Contract: Caller owns the device; it must outlive the Bus it is attached to.
+pub const Device = struct {
+    kind: Kind,
+    status: u32 = 0,
+    device_features_sel: u32 = 0,
+    driver_features: [2]u32 = .{ 0, 0 },
+    driver_features_sel: u32 = 0,
+    queue_sel: u32 = 0,
+    queues: [2]Queue = .{ .{}, .{} },
+    interrupt_status: u32 = 0,
+    /// Requests completed on every queue.
+    completed: u64 = 0,
+
+    const Self = @This();
+
+    pub const Kind = union(DeviceId) {
+        block: Block,
+        console: Console,
+    };
+
+    /// virtio-console device.
+    pub fn console() Self {
+        return .{ .kind = .{ .console = .{} } };
+    }
+
+    /// virtio-blk device over bytes (length rounded down to whole sectors).
+    pub fn block_memory(bytes: []u8, read_only: bool) Self {
+        return .{ .kind = .{ .block = .{
+            .backend = .{ .memory = bytes },
+            .capacity = bytes.len / SECTOR_SIZE,
+            .read_only = read_only,
+        } } };
+    }
+
+    /// virtio-blk device over a local file (size rounded down to whole sectors).
+    /// Contract: file stays open while the device is attached (caller closes it).
+    /// Errors: Whatever the host returns when sizing the file.
+    pub fn block_file(file: std.fs.File, read_only: bool) std.fs.File.GetSeekPosError!Self {
+        const size = try file.getEndPos();
+        return .{ .kind = .{ .block = .{
+            .backend = .{ .file = file },
+            .capacity = size / SECTOR_SIZE,
+            .read_only = read_only,
+        } } };
+    }
+
+    /// Queue host input for the guest console (returns bytes accepted; the rest is dropped).
+    /// Note: Delivered when the guest notifies receiveq or reads InterruptStatus.
+    pub fn push_console_input(self: *Self, bytes: []const u8) usize {
+        const con = &self.kind.console;
+        const accepted = @min(bytes.len, CONSOLE_INPUT_SIZE - con.input_len);
+        for (bytes[0..accepted]) |byte| {
+            con.input[(con.input_head + con.input_len) % CONSOLE_INPUT_SIZE] = byte;
+            con.input_len += 1;
+        }
+        return accepted;
+    }
+
+    fn queue_count(self: *const Self) u32 {
+        return switch (self.kind) {
+            .console => 2,
+            .block => 1,
+        };
+    }
+
+    fn selected_queue(self: *Self) ?*Queue {
+        if (self.queue_sel >= self.queue_count()) return null;
+        return &self.queues[self.queue_sel];
+    }
+
+    /// Guest read of a 32-bit register.
+    fn read(self: *Self, vm: *VM, offset: u64) u32 {
+        return switch (offset) {
+            REG_MAGIC => MAGIC_VALUE,
+            REG_VERSION => MMIO_VERSION,
+            REG_DEVICE_ID => @intFromEnum(std.meta.activeTag(self.kind)),
+            REG_VENDOR_ID => VENDOR_ID,
+            REG_DEVICE_FEATURES => switch (self.device_features_sel) {
+                0 => switch (self.kind) {
+                    .block => |blk| if (blk.read_only) FEATURE_BLK_RO else 0,
+                    .console => 0,
+                },
+                1 => FEATURE_VERSION_1_HIGH,
+                else => 0,
+            },
+            REG_QUEUE_NUM_MAX => if (self.selected_queue() != null) QUEUE_SIZE_MAX else 0,
+            REG_QUEUE_READY => if (self.selected_queue()) |queue| @intFromBool(queue.ready) else 0,
+            REG_INTERRUPT_STATUS => interrupts: {
+                // Console polls double as input delivery points.
+                if (self.kind == .console) self.deliver_console_input(vm);
+                break :interrupts self.interrupt_status;
+            },
+            REG_STATUS => self.status,
+            REG_CONFIG_GENERATION => 0,
+            // Block config: capacity (u64 sectors); console config is all zero.
+            REG_CONFIG => switch (self.kind) {
+                .block => |blk| @truncate(blk.capacity),
+                .console => 0,
+            },
+            REG_CONFIG + 4 => switch (self.kind) {
+                .block => |blk| @truncate(blk.capacity >> 32),
+                .console => 0,
+            },
+            else => 0,
+        };
+    }
+
+    /// Guest write of a 32-bit register.
+    fn write(self: *Self, vm: *VM, offset: u64, value: u32) void {
+        switch (offset) {
+            REG_DEVICE_FEATURES_SEL => self.device_features_sel = value,
+            REG_DRIVER_FEATURES => {
+                if (self.driver_features_sel < 2) self.driver_features[self.driver_features_sel] = value;
+            },
+            REG_DRIVER_FEATURES_SEL => self.driver_features_sel = value,
+            REG_QUEUE_SEL => self.queue_sel = value,
+            REG_QUEUE_NUM => if (self.selected_queue()) |queue| {
+                // Split queues are power-of-two sized.
+                if (value != 0 and value <= QUEUE_SIZE_MAX and std.math.isPowerOfTwo(value)) {
+                    queue.num = @intCast(value);
+                }
+            },
+            REG_QUEUE_READY => if (self.selected_queue()) |queue| {
+                queue.ready = value == 1 and queue_fits(vm, queue);
+                if (value == 1 and !queue.ready) self.status |= STATUS_NEEDS_RESET;
+            },
+            REG_QUEUE_NOTIFY => self.notify(vm, value),
+            REG_INTERRUPT_ACK => self.interrupt_status &= ~value,
+            REG_STATUS => {
+                if (value == 0) {
+                    self.reset();
+                    return;
+                }
+                var status = value;
+                // FEATURES_OK only sticks if the driver accepted VERSION_1 and nothing unknown.
+                if (status & STATUS_FEATURES_OK != 0 and !self.features_acceptable()) {
+                    status &= ~STATUS_FEATURES_OK;
+                }
+                self.status = status | (self.status & STATUS_NEEDS_RESET);
+            },
+            REG_QUEUE_DESC_LOW => if (self.selected_queue()) |queue| set_low(&queue.desc, value),
+            REG_QUEUE_DESC_HIGH => if (self.selected_queue()) |queue| set_high(&queue.desc, value),
+            REG_QUEUE_DRIVER_LOW => if (self.selected_queue()) |queue| set_low(&queue.driver, value),
+            REG_QUEUE_DRIVER_HIGH => if (self.selected_queue()) |queue| set_high(&queue.driver, value),
+            REG_QUEUE_DEVICE_LOW => if (self.selected_queue()) |queue| set_low(&queue.device, value),
+            REG_QUEUE_DEVICE_HIGH => if (self.selected_queue()) |queue| set_high(&queue.device, value),
+            // Read-only registers and config space ignore writes.
+            else => {},
+        }
+    }
+
+    fn features_acceptable(self: *const Self) bool {
+        const offered_low: u32 = switch (self.kind) {
+            .block => |blk| if (blk.read_only) FEATURE_BLK_RO else 0,
+            .console => 0,
+        };
+        return self.driver_features[1] == FEATURE_VERSION_1_HIGH and self.driver_features[0] & ~offered_low == 0;
+    }
+
+    /// Device reset (driver wrote 0 to Status).
+    fn reset(self: *Self) void {
+        self.status = 0;
+        self.device_features_sel = 0;
+        self.driver_features = .{ 0, 0 };
+        self.driver_features_sel = 0;
+        self.queue_sel = 0;
+        self.queues = .{ .{}, .{} };
+        self.interrupt_status = 0;
+    }
+
+    /// QueueNotify: run every available request on queue_index.
+    fn notify(self: *Self, vm: *VM, queue_index: u32) void {
+        if (queue_index >= self.queue_count()) return;
+        if (self.status & STATUS_DRIVER_OK == 0 or self.status & STATUS_NEEDS_RESET != 0) return;
+        const queue = &self.queues[queue_index];
+        if (!queue.ready) return;
+
+        switch (self.kind) {
+            .console => if (queue_index == CONSOLE_RECEIVEQ) {
+                self.deliver_console_input(vm);
+            } else {
+                self.process(vm, queue, transmit);
+            },
+            .block => self.process(vm, queue, block_request),
+        }
+    }
+
+    /// Consume every available chain on queue with handler (returns bytes written to the guest).
+    fn process(
+        self: *Self,
+        vm: *VM,
+        queue: *Queue,
+        comptime handler: fn (*Self, *VM, *const Chain) RingError!u32,
+    ) void {
+        self.process_chains(vm, queue, handler) catch {
+            self.status |= STATUS_NEEDS_RESET;
+        };
+    }
+
+    fn process_chains(
+        self: *Self,
+        vm: *VM,
+        queue: *Queue,
+        comptime handler: fn (*Self, *VM, *const Chain) RingError!u32,
+    ) RingError!void {
+        const avail_idx = try read_int(u16, vm, queue.driver + 2);
+        while (queue.last_avail != avail_idx) {
+            const head = try next_head(vm, queue);
+            const chain = try Chain.read(vm, queue, head);
+            const written = try handler(self, vm, &chain);
+            try self.complete(vm, queue, head, written);
+        }
+    }
+
+    /// Retire the chain at head: used-ring entry, consumed slot, used-buffer interrupt.
+    fn complete(self: *Self, vm: *VM, queue: *Queue, head: u16, written: u32) RingError!void {
+        try push_used(vm, queue, head, written);
+        queue.last_avail +%= 1;
+        self.completed += 1;
+        self.interrupt_status |= INTERRUPT_USED_BUFFER;
+    }
+
+    /// Console transmitq: device-readable buffers go to the VM's serial output.
+    fn transmit(self: *Self, vm: *VM, chain: *const Chain) RingError!u32 {
+        for (chain.slice()) |desc| {
+            if (desc.writable()) return error.BadDescriptor;
+            const bytes = try guest_bytes(vm, desc.addr, desc.len);
+            if (vm.serial_output) |serial| serial.writeBytes(bytes);
+            self.kind.console.bytes_out += bytes.len;
+        }
+        return 0;
+    }
+
+    /// Console receiveq: fill the next posted buffer with pending host input.
+    /// Note: Record/replay logs the byte count of every delivery attempt and the bytes
+    /// themselves (Source.console), so a replayed guest sees identical input at identical
+    /// points. Attempts with nothing pending consume no buffer.
+    fn deliver_console_input(self: *Self, vm: *VM) void {
+        const queue = &self.queues[CONSOLE_RECEIVEQ];
+        if (!queue.ready or self.status & STATUS_DRIVER_OK == 0 or self.status & STATUS_NEEDS_RESET != 0) return;
+        self.receive(vm, queue) catch {
+            self.status |= STATUS_NEEDS_RESET;
+        };
+    }
+
+    fn receive(self: *Self, vm: *VM, queue: *Queue) RingError!void {
+        const con = &self.kind.console;
+        const avail_idx = try read_int(u16, vm, queue.driver + 2);
+        if (queue.last_avail == avail_idx) return;
+        const pending = logged_input(vm, CONSOLE_INPUT_COUNT, con.input_len);
+        if (pending == 0) return;
+
+        const head = try next_head(vm, queue);
+        const chain = try Chain.read(vm, queue, head);
+        var capacity: u64 = 0;
+        for (chain.slice()) |desc| {
+            if (!desc.writable()) return error.BadDescriptor;
+            capacity += desc.len;
+        }
+        // Replayed input comes from the log only; host input pushed meanwhile stays queued.
+        const replaying = if (vm.replay) |session| session.mode == .replay else false;
+        const count = @min(pending, capacity, CONSOLE_INPUT_SIZE);
+
+        var delivered: u64 = 0;
+        for (chain.slice()) |desc| {
+            var offset: u64 = 0;
+            while (offset < desc.len and delivered < count) : ({
+                offset += 1;
+                delivered += 1;
+            }) {
+                var live: u8 = 0;
+                if (!replaying and con.input_len > 0) {
+                    live = con.input[con.input_head];
+                    con.input_head = (con.input_head + 1) % CONSOLE_INPUT_SIZE;
+                    con.input_len -= 1;
+                }
+                const byte: u8 = @truncate(logged_input(vm, CONSOLE_INPUT_BYTE, live));
+                vm.write_memory(desc.addr + offset, &[_]u8{byte}) catch return error.BadDescriptor;
+            }
+        }
+        con.bytes_in += delivered;
+        try self.complete(vm, queue, head, @intCast(delivered));
+    }
+
+    /// Block request: header (readable), data buffers, status byte (writable).
+    fn block_request(self: *Self, vm: *VM, chain: *const Chain) RingError!u32 {
+        const blk = &self.kind.block;
+        const descs = chain.slice();
+        if (descs.len < 2) return error.BadDescriptor;
+        const header_desc = descs[0];
+        const status_desc = descs[descs.len - 1];
+        if (header_desc.writable() or header_desc.len < BLK_HEADER_SIZE) return error.BadDescriptor;
+        if (!status_desc.writable() or status_desc.len < 1) return error.BadDescriptor;
+        const data = descs[1 .. descs.len - 1];
+
+        const header = try guest_bytes(vm, header_desc.addr, BLK_HEADER_SIZE);
+        const request_type = std.mem.readInt(u32, header[0..4], .little);
+        const sector = std.mem.readInt(u64, header[8..16], .little);
+
+        var written: u32 = 0;
+        const status: u8 = switch (request_type) {
+            BLK_T_IN, BLK_T_OUT => outcome: {
+                const is_read = request_type == BLK_T_IN;
+                if (!is_read and blk.read_only) break :outcome BLK_S_IOERR;
+                var total: u64 = 0;
+                for (data) |desc| {
+                    // Reads fill device-writable buffers, writes drain device-readable ones.
+                    if (desc.writable() != is_read) return error.BadDescriptor;
+                    total += desc.len;
+                }
+                // used.len (data plus status byte) must fit in a u32.
+                if (total >= std.math.maxInt(u32)) return error.BadDescriptor;
+                const capacity_bytes = blk.capacity * SECTOR_SIZE;
+                if (sector > blk.capacity or total > capacity_bytes - sector * SECTOR_SIZE) break :outcome BLK_S_IOERR;
+
+                var disk_offset = sector * SECTOR_SIZE;
+                for (data) |desc| {
+                    const ok = if (is_read)
+                        try disk_read(blk, vm, disk_offset, desc)
+                    else
+                        try disk_write(blk, vm, disk_offset, desc);
+                    if (!ok) break :outcome BLK_S_IOERR;
+                    disk_offset += desc.len;
+                }
+                if (is_read) {
+                    written = @intCast(total);
+                    blk.bytes_read += total;
+                } else {
+                    blk.bytes_written += total;
+                }
+                break :outcome BLK_S_OK;
+            },
+            BLK_T_FLUSH => switch (blk.backend) {
+                .memory => BLK_S_OK,
+                .file => |file| if (file.sync()) |_| BLK_S_OK else |_| BLK_S_IOERR,
+            },
+            BLK_T_GET_ID => outcome: {
+                if (data.len != 1 or !data[0].writable()) return error.BadDescriptor;
+                const id_len: u32 = @min(data[0].len, BLK_ID.len);
+                vm.write_memory(data[0].addr, BLK_ID[0..id_len]) catch return error.BadDescriptor;
+                written = id_len;
+                break :outcome BLK_S_OK;
+            },
+            else => BLK_S_UNSUPP,
+        };
+        vm.write_memory(status_desc.addr, &[_]u8{status}) catch return error.BadDescriptor;
+        return written + 1;
+    }
+};
+
+/// Device windows on the MMIO bus (VM.mmio points here while attached).
+pub const Bus = struct {
+    devices: [MAX_DEVICES]?*Device = [_]?*Device{null} ** MAX_DEVICES,
+
+    const Self = @This();
+
+    /// Attach device at the first free window; returns its MMIO base address.
+    /// Errors: NoFreeWindow if MAX_DEVICES are attached already.
+    pub fn attach(self: *Self, device: *Device) error{NoFreeWindow}!u64 {
+        for (&self.devices, 0..) |*slot, index| {
+            if (slot.* == null) {
+                slot.* = device;
+                return MMIO_BASE + index * MMIO_STRIDE;
+            }
+        }
+        return error.NoFreeWindow;
+    }
+
+    /// Guest load of size 4 or 8 at physical addr; null if no device register is there.
+    /// Note: 8-byte loads read two consecutive registers (low word first).
+    pub fn load(self: *Self, vm: *VM, addr: u64, comptime size: u8) ?u64 {
+        const device, const offset = self.resolve(addr, size) orelse return null;
+        if (vm.smp) |smp| smp.lock.lock();
+        defer if (vm.smp) |smp| smp.lock.unlock();
+        var value: u64 = device.read(vm, offset);
+        if (size == 8) value |= @as(u64, device.read(vm, offset + 4)) << 32;
+        return value;
+    }
+
+    /// Guest store of size 4 or 8 at physical addr; false if no device register is there.
+    /// Note: 8-byte stores write two consecutive registers (low word first).
+    pub fn store(self: *Self, vm: *VM, addr: u64, comptime size: u8, value: u64) bool {
+        const device, const offset = self.resolve(addr, size) orelse return false;
+        if (vm.smp) |smp| smp.lock.lock();
+        defer if (vm.smp) |smp| smp.lock.unlock();
+        device.write(vm, offset, @truncate(value));
+        if (size == 8) device.write(vm, offset + 4, @truncate(value >> 32));
+        return true;
+    }
+
+    /// Device and register offset for an aligned access inside an attached window.
+    fn resolve(self: *Self, addr: u64, comptime size: u8) ?struct { *Device, u64 } {
+        comptime std.debug.assert(size == 4 or size == 8);
+        if (addr < MMIO_BASE or addr % size != 0) return null;
+        const window = (addr - MMIO_BASE) / MMIO_STRIDE;
+        if (window >= MAX_DEVICES) return null;
+        const device = self.devices[@intCast(window)] orelse return null;
+        return .{ device, addr % MMIO_STRIDE };
+    }
+};
+
+/// Descriptor chain starting at one available-ring head.
+const Chain = struct {
+    descs: [QUEUE_SIZE_MAX]Descriptor = undefined,
+    len: usize = 0,
+
+    /// Read the chain at head (at most queue.num descriptors, so loops end).
+    fn read(vm: *VM, queue: *const Queue, head: u16) RingError!Chain {
+        var chain = Chain{};
+        var index = head;
+        while (true) {
+            if (index >= queue.num or chain.len == queue.num) return error.BadDescriptor;
+            const entry = try guest_bytes(vm, queue.desc + @as(u64, index) * DESC_SIZE, DESC_SIZE);
+            const desc = Descriptor{
+                .addr = std.mem.readInt(u64, entry[0..8], .little),
+                .len = std.mem.readInt(u32, entry[8..12], .little),
+                .flags = std.mem.readInt(u16, entry[12..14], .little),
+                .next = std.mem.readInt(u16, entry[14..16], .little),
+            };
+            // Indirect descriptors were not offered.
+            if (desc.flags & ~(DESC_F_NEXT | DESC_F_WRITE) != 0) return error.BadDescriptor;
+            chain.descs[chain.len] = desc;
+            chain.len += 1;
+            if (desc.flags & DESC_F_NEXT == 0) return chain;
+            index = desc.next;
+        }
+    }
+
+    fn slice(self: *const Chain) []const Descriptor {
+        return self.descs[0..self.len];
+    }
+};
+
+/// Whether queue's size is set and its three rings lie in guest RAM.
+fn queue_fits(vm: *const VM, queue: *const Queue) bool {
+    if (queue.num == 0) return false;
+    const num: u64 = queue.num;
+    return range_in_ram(vm, queue.desc, num * DESC_SIZE) and
+        range_in_ram(vm, queue.driver, 6 + 2 * num) and
+        range_in_ram(vm, queue.device, 6 + 8 * num);
+}
+
+fn range_in_ram(vm: *const VM, addr: u64, len: u64) bool {
+    return addr <= vm.memory_size and len <= vm.memory_size - addr;
+}
+
+/// Guest RAM bytes [addr, addr + len) (device-readable data).
+fn guest_bytes(vm: *VM, addr: u64, len: u64) RingError![]const u8 {
+    if (!range_in_ram(vm, addr, len)) return error.BadDescriptor;
+    return vm.memory[@intCast(addr)..][0..@intCast(len)];
+}
+
+fn read_int(comptime T: type, vm: *VM, addr: u64) RingError!T {
+    const bytes = try guest_bytes(vm, addr, @sizeOf(T));
+    return std.mem.readInt(T, bytes[0..@sizeOf(T)], .little);
+}
+
+/// Descriptor head in the next available-ring slot.
+fn next_head(vm: *VM, queue: *const Queue) RingError!u16 {
+    const slot: u64 = queue.last_avail % queue.num;
+    return read_int(u16, vm, queue.driver + 4 + 2 * slot);
+}
+
+/// Append (head, written) to queue's used ring and publish it.
+fn push_used(vm: *VM, queue: *const Queue, head: u16, written: u32) RingError!void {
+    const used_idx = try read_int(u16, vm, queue.device + 2);
+    var element: [8]u8 = undefined;
+    std.mem.writeInt(u32, element[0..4], head, .little);
+    std.mem.writeInt(u32, element[4..8], written, .little);
+    const slot: u64 = used_idx % queue.num;
+    vm.write_memory(queue.device + 4 + 8 * slot, &element) catch return error.BadDescriptor;
+    // Index last: the driver must never see an entry before its contents.
+    var index: [2]u8 = undefined;
+    std.mem.writeInt(u16, &index, used_idx +% 1, .little);
+    vm.write_memory(queue.device + 2, &index) catch return error.BadDescriptor;
+}
+
+/// Disk bytes at offset into desc's guest buffer (false on a host I/O error).
+fn disk_read(blk: *Block, vm: *VM, offset: u64, desc: Descriptor) RingError!bool {
+    if (!range_in_ram(vm, desc.addr, desc.len)) return error.BadDescriptor;
+    switch (blk.backend) {
+        .memory => |bytes| {
+            vm.write_memory(desc.addr, bytes[@intCast(offset)..][0..desc.len]) catch return error.BadDescriptor;
+        },
+        .file => |file| {
+            var chunk: [FILE_CHUNK_SIZE]u8 = undefined;
+            var done: u64 = 0;
+            while (done < desc.len) {
+                const len: usize = @intCast(@min(desc.len - done, FILE_CHUNK_SIZE));
+                const read_len = file.preadAll(chunk[0..len], offset + done) catch return false;
+                if (read_len != len) return false;
+                vm.write_memory(desc.addr + done, chunk[0..len]) catch return error.BadDescriptor;
+                done += len;
+            }
+        },
+    }
+    return true;
+}
+
+/// desc's guest buffer onto disk at offset (false on a host I/O error).
+fn disk_write(blk: *Block, vm: *VM, offset: u64, desc: Descriptor) RingError!bool {
+    const bytes = try guest_bytes(vm, desc.addr, desc.len);
+    switch (blk.backend) {
+        .memory => |disk| @memcpy(disk[@intCast(offset)..][0..bytes.len], bytes),
+        .file => |file| file.pwriteAll(bytes, offset) catch return false,
+    }
+    return true;
+}
+
+/// Host value for a console input, through the VM's record/replay session if any.
+fn logged_input(vm: *VM, number: u64, live: u64) u64 {
+    const session = vm.replay orelse return live;
+    if (session.replay_input(.console, number)) |logged| return logged;
+    session.record_input(.console, number, live);
+    return live;
+}
+
+fn set_low(field: *u64, value: u32) void {
+    field.* = (field.* & 0xFFFF_FFFF_0000_0000) | value;
+}
+
+fn set_high(field: *u64, value: u32) void {
+    field.* = (field.* & 0xFFFF_FFFF) | (@as(u64, value) << 32);
+}
@@ -1,6 +1,16 @@
 const std = @import("std");
 const sbi = @import("sbi");
 const SerialOutput = @import("serial.zig").SerialOutput;
+const vm_trace = @import("trace.zig");
+const vm_profile = @import("profile.zig");
+const SymbolTable = @import("loader.zig").SymbolTable;
+const vm_jit = @import("jit.zig");
+const vm_memory = @import("memory.zig");
+const vm_smp = @import("smp.zig");
+const vm_mmu = @import("mmu.zig");
+const vm_replay = @import("replay.zig");
+const vm_virtio = @import("virtio.zig");
+const vm_csr = @import("csr.zig");
 
 /// Pure Zig RISC-V64 emulator for kernel development.
 /// Grain Style: Static allocation where possible, comprehensive assertions,
@@ -50,28 +60,50 @@ pub const RegisterFile = struct {
     }
 };
 
-/// VM memory configuration.
+/// Default guest RAM size (InitOptions.memory_size).
 /// Why: Centralized memory size configuration for RAM-aware development.
 /// Note: Development machine (MacBook Air M2): 24GB RAM
 ///       Target hardware (Framework 13 RISC-V): 8GB RAM
-///       Default: 4MB (safe for both, sufficient for early kernel development)
-///       Max recommended: 64MB (works on both machines, allows larger kernel testing)
-pub const VM_MEMORY_SIZE: usize = 4 * 1024 * 1024; // 4MB default
+///       Default: 4MB (sufficient for early kernel development). RAM is mmap-backed
+///       and faulted in lazily, so multi-GB guests only cost the pages they touch.
+pub const VM_MEMORY_SIZE: usize = vm_memory.DEFAULT_SIZE; // 4MB default
+/// Guest RAM size bounds and granule (see memory.zig).
+pub const VM_MEMORY_SIZE_MIN: usize = vm_memory.MIN_SIZE;
+pub const VM_MEMORY_SIZE_MAX: usize = vm_memory.MAX_SIZE;
+
+/// Guest page size (code-page tracking granularity).
+/// Why: Matches RISC-V base page size, so invalidation lines up with kernel mappings.
+pub const PAGE_SIZE: usize = 4096;
+pub const PAGE_SHIFT: u6 = 12;
+
+/// Decoded-instruction cache configuration.
+/// Why: Direct-mapped by word-aligned PC; 4096 entries cover 16KB of hot code
+/// (four pages), which holds the Basin kernel boot loops comfortably.
+pub const DECODE_CACHE_SIZE: usize = 4096;
+/// Tag value for an empty decode cache slot (never a valid, 4-byte aligned PC).
+const DECODE_TAG_EMPTY: u64 = std.math.maxInt(u64);
+
+comptime {
+    // Assert: cache size must be a power of two (index is a mask of PC bits).
+    std.debug.assert(std.math.isPowerOfTwo(DECODE_CACHE_SIZE));
+    // Assert: a whole code page must map to distinct cache slots (page invalidation walks one page).
+    std.debug.assert(DECODE_CACHE_SIZE >= PAGE_SIZE / 4);
+    // Assert: memory must be whole pages (code-page bitmap covers all of it).
+    std.debug.assert(vm_memory.SIZE_GRANULE % PAGE_SIZE == 0);
+}
 
 /// RISC-V64 virtual machine state.
 /// Why: Encapsulate all VM state for deterministic execution.
 pub const VM = struct {
     /// Register file (32 GP registers + PC).
     regs: RegisterFile = .{},
-    /// Physical memory (static allocation, size configured by VM_MEMORY_SIZE).
-    /// Why: Static allocation eliminates allocator dependency.
+    /// Physical memory (guarded mmap reservation, size chosen at init).
+    /// Why: No allocator dependency, and untouched pages cost nothing, so init and
+    /// reset are O(touched pages) rather than O(RAM size).
     /// Note: RISC-V64 typically uses 48-bit physical addresses, but we
     /// use configurable size for kernel development (default 4MB, sufficient for early boot).
-    /// RAM considerations:
-    /// - Development: 24GB available (MacBook Air M2)
-    /// - Target: 8GB available (Framework 13 RISC-V)
-    /// - 4MB default is conservative and safe for both machines.
-    memory: [VM_MEMORY_SIZE]u8 = [_]u8{0} ** VM_MEMORY_SIZE,
+    /// Note: memory.len == memory_size; guard pages on both sides are PROT_NONE.
+    memory: vm_memory.Ram,
     /// Memory size in bytes.
     memory_size: usize = VM_MEMORY_SIZE,
     /// VM execution state (running, halted, error).
@@ -86,23 +118,207 @@ pub const VM = struct {
     /// User data for syscall handler (optional).
     /// Why: Pass context to syscall handler (e.g., Basin Kernel instance).
     syscall_user_data: ?*anyopaque = null,
+    /// Record/replay session (null unless a replay.Recorder or replay.Replayer is attached).
+    /// Why: Host-provided values (syscall results) are the only nondeterminism in a
+    /// single-hart run; recording logs them, replay feeds them back instead of the host.
+    replay: ?*vm_replay.Session = null,
     /// Serial output handler (for SBI console output).
     /// Why: Capture SBI console output (LEGACY_CONSOLE_PUTCHAR) for display.
     serial_output: ?*SerialOutput = null,
+    /// Virtio MMIO devices (null: loads and stores beyond RAM fault as before).
+    /// Why: Shared-ring console and block I/O trap once per notification, not per byte.
+    /// Note: Consulted only on the out-of-RAM path of LW/LWU/LD/SW/SD, so RAM accesses pay nothing.
+    mmio: ?*vm_virtio.Bus = null,
+    /// Decoded-instruction cache tags (guest PC per slot, DECODE_TAG_EMPTY if unused).
+    /// Why: Separate from entries so the hit check touches one dense u64 array.
+    decode_tags: [DECODE_CACHE_SIZE]u64 = [_]u64{DECODE_TAG_EMPTY} ** DECODE_CACHE_SIZE,
+    /// Decoded-instruction cache entries (valid only where decode_tags matches PC).
+    decode_entries: [DECODE_CACHE_SIZE]Decoded = undefined,
+    /// Pages that currently have decoded instructions in the cache.
+    /// Why: Stores only pay for invalidation when they hit a page we decoded from.
+    /// Note: One bit per guest page, sized with memory at init (page allocator).
+    code_pages: PageSet = .{},
+    /// Pages written since the last snapshot or restore (guest stores and write_memory).
+    /// Why: restore copies back only these pages, so its cost follows what one run touched.
+    dirty_pages: PageSet = .{},
+    /// Incremented by every snapshot(); restore() accepts only the latest one.
+    /// Why: dirty_pages is relative to the latest snapshot, so older ones cannot be restored.
+    snapshot_epoch: u64 = 0,
+    /// Binary trace ring (zero-sized unless built with -Dvm-trace=true).
+    /// Why: Replaces per-instruction stderr prints; formatted only by dump_trace.
+    trace: vm_trace.Trace = .{},
+    /// Guest profiler (zero-sized unless built with -Dvm-profile=true).
+    /// Why: Samples PCs and call stacks per retired instruction; see dump_profile.
+    profile: vm_profile.Profile = .{},
+    /// Basic-block translator (JIT mode only; null when interpreting).
+    /// Why: Heap/mmap-backed so interpreter-mode VMs carry no JIT tables.
+    jit: ?*vm_jit.Jit = null,
+    /// Hart ID (mhartid; 0 unless this VM is a hart of an Smp machine).
+    hart_id: u32 = 0,
+    /// SMP machine this hart belongs to (null for a standalone VM).
+    /// Why: SBI IPIs reach sibling harts, and ECALLs into shared host state serialize.
+    smp: ?*vm_smp.Smp = null,
+    /// Whether this VM unmaps memory on deinit (false for secondary SMP harts).
+    owns_memory: bool = true,
+    /// LR reservation (address and loaded value), cleared by SC.
+    /// Why: SC succeeds by compare-and-swap against the loaded value, which is how
+    /// host atomics express LR/SC (a store of the same value in between is missed).
+    reservation: ?Reservation = null,
+    /// Set by WFI; run() returns .wait so the caller can park the hart.
+    wait_requested: bool = false,
+    /// Target of FENCE's host barrier (per hart, so fences do not contend).
+    fence_word: u32 = 0,
+    /// Supervisor address translation register (0 = Bare: guest addresses are physical).
+    /// Note: Written through set_satp (host) or CSR instructions (guest), both of which flush tlb.
+    satp: u64 = 0,
+    /// Software TLB for Sv39 (untouched while satp is Bare).
+    tlb: vm_mmu.Tlb = .{},
+    /// Supervisor trap CSRs and virtual timer (see csr.zig).
+    /// Note: Written through set_csrs (host) or CSR instructions, SBI SET_TIMER, traps and SRET.
+    csrs: vm_csr.State = .{},
+    /// mtime at which run() takes a timer interrupt (csrs.interrupt_deadline(), cached).
+    /// Why: The run loop compares one field per instruction instead of re-deriving it.
+    interrupt_at: u64 = vm_csr.NO_DEADLINE,
 
     const Self = @This();
-    
+
+    /// One bit per guest page (code_pages, dirty_pages).
+    const PageSet = std.DynamicBitSetUnmanaged;
+
+    /// LR/SC reservation set.
+    pub const Reservation = struct {
+        addr: u64,
+        value: u64,
+    };
+
+    /// Instruction handler (executes one pre-decoded instruction).
+    /// Why: Cached per PC so step() dispatches with one indirect call.
+    pub const Handler = *const fn (self: *Self, d: *const Decoded) VMError!void;
+
+    /// Pre-decoded instruction: handler plus operand fields extracted once.
+    /// Why: execute_* handlers read fields instead of re-decoding the word.
+    pub const Decoded = struct {
+        /// Instruction handler.
+        handler: Handler,
+        /// Destination register (bits [11:7]).
+        rd: u5,
+        /// First source register (bits [19:15]).
+        rs1: u5,
+        /// Second source register (bits [24:20]).
+        rs2: u5,
+        /// Format-specific immediate (see decode for per-format extraction).
+        imm: i64,
+        /// Raw instruction word (kept for diagnostics).
+        inst: u32,
+    };
+
     pub const VMState = enum {
         running,
         halted,
         errored,
     };
+
+    /// Execution engine used by run() (step() always interprets).
+    pub const ExecutionMode = enum {
+        /// Pre-decoded interpreter (every host).
+        interpreter,
+        /// x86-64 basic-block JIT with interpreter fallback (x86-64 Linux hosts).
+        /// Note: Falls back to the interpreter on other hosts, when the arena cannot
+        /// be mapped, and in -Dvm-trace=true / -Dvm-profile=true builds (translated
+        /// code records no events or samples).
+        jit,
+    };
+
+    /// VM initialization options.
+    pub const InitOptions = struct {
+        /// Execution engine for run().
+        execution_mode: ExecutionMode = .interpreter,
+        /// Guest RAM size in bytes (VM_MEMORY_SIZE_MIN..VM_MEMORY_SIZE_MAX, 64KB multiple).
+        memory_size: usize = VM_MEMORY_SIZE,
+        /// Use this RAM instead of mapping new RAM (secondary SMP harts).
+        /// Contract: len == memory_size; the owner outlives this VM.
+        shared_memory: ?vm_memory.Ram = null,
+    };
+
+    /// Initialization errors.
+    pub const InitError = vm_memory.Error;
+
+    /// Snapshot errors (guest RAM copy or serial copy could not be allocated).
+    pub const SnapshotError = vm_memory.Error || std.mem.Allocator.Error;
+
+    /// Point-in-time copy of guest-visible VM state (see snapshot / restore).
+    /// Why: Harnesses boot once, snapshot, then restore before every case instead
+    /// of rebuilding the VM; restore copies back only pages dirtied since.
+    /// Note: Host hooks (syscall handler, serial pointer), decode cache and JIT
+    /// blocks are not part of a snapshot; caches stay valid across restore.
+    pub const Snapshot = struct {
+        regs: RegisterFile,
+        state: VMState,
+        last_error: ?VMError,
+        /// Guest RAM copy (sparse: all-zero pages are never written, so never faulted in).
+        memory: vm_memory.Ram,
+        /// Attached serial output at snapshot time (null if none was attached).
+        serial: ?*SerialOutput,
+        /// VM.snapshot_epoch this snapshot was taken at.
+        epoch: u64,
+        /// Address translation register at snapshot time.
+        satp: u64,
+        /// Trap CSRs and virtual timer at snapshot time.
+        csrs: vm_csr.State,
+
+        /// Release the RAM copy and serial copy.
+        /// Contract: allocator is the one passed to VM.snapshot.
+        pub fn deinit(self: *Snapshot, allocator: std.mem.Allocator) void {
+            vm_memory.unmap(self.memory);
+            if (self.serial) |serial| allocator.destroy(serial);
+            self.* = undefined;
+        }
+    };
+
+    /// Why run() returned control to the caller.
+    pub const RunExit = enum {
+        /// Instruction or wall-clock budget used up; VM still running.
+        budget_exhausted,
+        /// ECALL executed with stop_on_ecall set; VM still running.
+        ecall,
+        /// Guest halted (exit syscall, SBI shutdown, or no syscall handler).
+        halted,
+        /// Instruction faulted; VM errored, see last_error.
+        fault,
+        /// WFI executed with no timer to skip ahead to; VM still running. Standalone
+        /// callers just continue (WFI may complete at any time); SMP harts park until
+        /// an IPI or, once every hart is parked, their timer deadline.
+        wait,
+    };
+
+    /// Limits for one run() batch.
+    pub const RunBudget = struct {
+        /// Maximum instructions to execute (must be > 0).
+        max_instructions: u64,
+        /// Optional wall-clock limit in nanoseconds (checked every RUN_CLOCK_CHECK_INTERVAL instructions).
+        max_nanoseconds: ?u64 = null,
+        /// Return after every ECALL (for callers that service syscalls between batches).
+        stop_on_ecall: bool = false,
+    };
+
+    /// Outcome of one run() batch.
+    pub const RunResult = struct {
+        exit: RunExit,
+        /// Instructions retired in this batch (a faulting instruction is not counted).
+        instructions: u64,
+    };
+
+    /// Instructions between wall-clock checks in run().
+    /// Why: Reading the clock per instruction would cost more than the instruction.
+    pub const RUN_CLOCK_CHECK_INTERVAL: u64 = 4096;
     
     pub const VMError = error{
         invalid_instruction,
         invalid_memory_access,
         unaligned_instruction,
         unaligned_memory_access,
+        /// Sv39 translation failed (no valid mapping permits the access).
+        page_fault,
     };
 
     /// Initialize VM with kernel image loaded at address (GrainStyle: in-place initialization).
@@ -111,20 +327,49 @@ pub const VM = struct {
     /// Contract: load_address must be 4-byte aligned (RISC-V requirement).
     /// Contract: kernel_image must fit in VM memory if non-empty.
     /// Postcondition: VM is in halted state, memory zeroed, PC set to load_address (or 0 if no kernel).
-    pub fn init(target: *Self, kernel_image: []const u8, load_address: u64) void {
+    /// Errors: GuestMemoryUnavailable if guest RAM cannot be reserved.
+    pub fn init(target: *Self, kernel_image: []const u8, load_address: u64) InitError!void {
+        return init_with_options(target, kernel_image, load_address, .{});
+    }
+
+    /// Initialize VM with explicit options (GrainStyle: in-place initialization).
+    /// Contract: Same as init; every initialized VM must be released with deinit
+    /// (also before initializing it again), since guest RAM is a host mapping.
+    /// Note: JIT mode silently degrades to the interpreter where it is unavailable;
+    /// check active_execution_mode() when the distinction matters.
+    pub fn init_with_options(target: *Self, kernel_image: []const u8, load_address: u64, options: InitOptions) InitError!void {
         // Assert: load address must be aligned (4-byte alignment for RISC-V).
         std.debug.assert(load_address % 4 == 0);
+
+        // Assert: memory size must be a supported RAM size.
+        std.debug.assert(vm_memory.valid_size(options.memory_size));
         
         // Assert: kernel image must fit in memory (if non-empty).
         if (kernel_image.len > 0) {
-            std.debug.assert(load_address + kernel_image.len <= VM_MEMORY_SIZE);
+            std.debug.assert(load_address + kernel_image.len <= options.memory_size);
         }
+
+        // Reserve guest RAM (zero pages, faulted in on first touch), or share the boot hart's.
+        const owns_memory = options.shared_memory == null;
+        const memory = options.shared_memory orelse try vm_memory.map(options.memory_size);
+        errdefer if (owns_memory) vm_memory.unmap(memory);
+        std.debug.assert(memory.len == options.memory_size);
+        var code_pages = PageSet.initEmpty(std.heap.page_allocator, options.memory_size / PAGE_SIZE) catch {
+            return error.GuestMemoryUnavailable;
+        };
+        errdefer code_pages.deinit(std.heap.page_allocator);
+        const dirty_pages = PageSet.initEmpty(std.heap.page_allocator, options.memory_size / PAGE_SIZE) catch {
+            return error.GuestMemoryUnavailable;
+        };
         
         // Initialize VM struct in-place (GrainStyle: avoid stack allocation of large struct).
         target.* = .{
             .regs = .{},
-            .memory = [_]u8{0} ** VM_MEMORY_SIZE,
-            .memory_size = VM_MEMORY_SIZE,
+            .memory = memory,
+            .memory_size = options.memory_size,
+            .code_pages = code_pages,
+            .dirty_pages = dirty_pages,
+            .owns_memory = owns_memory,
             .state = .halted,
             .last_error = null,
         };
@@ -146,9 +391,183 @@ pub const VM = struct {
             // No kernel image - PC remains 0 (will be set by ELF loader).
             target.regs.pc = 0;
         }
+
+        // JIT mode: map translator arena (interpreter remains the fallback).
+        if (options.execution_mode == .jit and !vm_trace.enabled and !vm_profile.enabled and options.memory_size <= vm_jit.MAX_MEMORY_SIZE) {
+            target.jit = vm_jit.Jit.create() catch null;
+        }
         
         // Assert: VM must be in halted state after initialization.
         std.debug.assert(target.state == .halted);
+        std.debug.assert(target.memory.len == target.memory_size);
+    }
+
+    /// Release guest RAM, page bitmaps and JIT resources.
+    /// Contract: VM must not be used afterwards unless re-initialized.
+    pub fn deinit(self: *Self) void {
+        if (self.jit) |jit| {
+            jit.destroy();
+            self.jit = null;
+        }
+        self.code_pages.deinit(std.heap.page_allocator);
+        self.dirty_pages.deinit(std.heap.page_allocator);
+        if (self.owns_memory) {
+            vm_memory.unmap(self.memory);
+        }
+        self.memory = self.memory[0..0];
+        self.memory_size = 0;
+
+        // Assert: no translator or RAM may outlive deinit.
+        std.debug.assert(self.jit == null);
+        std.debug.assert(self.memory.len == 0);
+    }
+
+    /// Reset VM to its post-init state (RAM zeroed, registers cleared, halted).
+    /// Why: Reuses the RAM reservation; zeroing drops touched pages instead of
+    /// writing memory_size bytes, so reset cost follows the guest's footprint.
+    /// Note: Keeps memory size, execution mode and host hooks (syscall handler, serial).
+    /// Errors: GuestMemoryUnavailable if the host refuses to remap RAM.
+    pub fn reset(self: *Self) InitError!void {
+        // Assert: shared RAM belongs to the boot hart (reset the machine there).
+        std.debug.assert(self.owns_memory);
+        try vm_memory.zero(self.memory);
+        // Every page may now differ from a snapshot taken before the reset.
+        self.dirty_pages.setAll();
+        self.regs = .{};
+        self.state = .halted;
+        self.last_error = null;
+        self.reservation = null;
+        self.set_satp(0);
+        self.set_csrs(.{});
+        self.flush_decode_cache();
+        self.profile.clear();
+
+        // Assert: VM must be halted with a clean register file.
+        std.debug.assert(self.state == .halted);
+        std.debug.assert(self.regs.pc == 0);
+    }
+
+    /// Execution engine actually in use (JIT requests may have degraded to interpreter).
+    pub fn active_execution_mode(self: *const Self) ExecutionMode {
+        return if (self.jit != null) .jit else .interpreter;
+    }
+
+    /// Capture registers, state, guest RAM and attached serial output.
+    /// Why: Copies non-zero pages only; the scan is O(RAM size) once per snapshot,
+    /// and every later restore is O(pages dirtied since).
+    /// Contract: Only the latest snapshot of this VM may be restored (dirty tracking restarts here).
+    /// Errors: GuestMemoryUnavailable or OutOfMemory if the copies cannot be allocated.
+    pub fn snapshot(self: *Self, allocator: std.mem.Allocator) SnapshotError!Snapshot {
+        std.debug.assert(self.memory.len == self.memory_size);
+        // Assert: SMP harts write RAM from other threads (not snapshottable per hart).
+        std.debug.assert(self.smp == null);
+
+        const memory = try vm_memory.map(self.memory_size);
+        errdefer vm_memory.unmap(memory);
+        var serial: ?*SerialOutput = null;
+        if (self.serial_output) |output| {
+            const copy = try allocator.create(SerialOutput);
+            copy.* = output.*;
+            serial = copy;
+        }
+
+        // Copy pages that hold data (host writes such as loaders are not tracked, so scan all).
+        var page: usize = 0;
+        while (page < self.dirty_pages.bit_length) : (page += 1) {
+            const bytes = self.memory[page * PAGE_SIZE ..][0..PAGE_SIZE];
+            if (!std.mem.allEqual(u8, bytes, 0)) {
+                @memcpy(memory[page * PAGE_SIZE ..][0..PAGE_SIZE], bytes);
+            }
+        }
+        self.dirty_pages.unsetAll();
+        self.snapshot_epoch += 1;
+
+        // Assert: dirty tracking must restart at this snapshot.
+        std.debug.assert(self.dirty_pages.count() == 0);
+        return .{
+            .regs = self.regs,
+            .state = self.state,
+            .last_error = self.last_error,
+            .memory = memory,
+            .serial = serial,
+            .epoch = self.snapshot_epoch,
+            .satp = self.satp,
+            .csrs = self.csrs,
+        };
+    }
+
+    /// Return to snapshot state, copying back only pages dirtied since the snapshot
+    /// (or the previous restore).
+    /// Contract: snap is the latest snapshot of this VM; host writes made after it
+    /// went through write_memory (raw writes to self.memory are not tracked).
+    /// Note: Restored pages holding cached code are invalidated like guest stores.
+    pub fn restore(self: *Self, snap: *const Snapshot) void {
+        std.debug.assert(snap.epoch == self.snapshot_epoch);
+        std.debug.assert(snap.memory.len == self.memory.len);
+
+        var pages = self.dirty_pages.iterator(.{});
+        while (pages.next()) |page| {
+            const start = page * PAGE_SIZE;
+            @memcpy(self.memory[start..][0..PAGE_SIZE], snap.memory[start..][0..PAGE_SIZE]);
+            if (self.code_pages.isSet(page)) {
+                self.invalidate_code_page(page);
+            }
+        }
+        self.dirty_pages.unsetAll();
+
+        self.regs = snap.regs;
+        self.state = snap.state;
+        self.last_error = snap.last_error;
+        self.reservation = null;
+        // Restored pages may hold page tables: drop cached translations too.
+        self.set_satp(snap.satp);
+        self.set_csrs(snap.csrs);
+        if (snap.serial) |serial| {
+            if (self.serial_output) |output| output.* = serial.*;
+        }
+
+        // Assert: VM must match the snapshot's control state.
+        std.debug.assert(self.regs.pc == snap.regs.pc);
+        std.debug.assert(self.dirty_pages.count() == 0);
+    }
+
+    /// Host-side write into guest RAM (tracked for restore, invalidates cached code).
+    /// Why: Harnesses write per-case inputs between restores; raw self.memory writes
+    /// would be missed by dirty tracking and by the decode cache.
+    /// Errors: invalid_memory_access if the range is outside guest RAM.
+    pub fn write_memory(self: *Self, addr: u64, bytes: []const u8) VMError!void {
+        if (addr > self.memory_size or bytes.len > self.memory_size - addr) {
+            return VMError.invalid_memory_access;
+        }
+        if (bytes.len == 0) return;
+
+        const start: usize = @intCast(addr);
+        @memcpy(self.memory[start..][0..bytes.len], bytes);
+        self.note_host_store(addr, bytes.len);
+
+        // Assert: bytes must be in guest RAM.
+        std.debug.assert(std.mem.eql(u8, self.memory[start..][0..bytes.len], bytes));
+    }
+
+    /// Track len bytes the host stored at addr directly into self.memory.
+    /// Why: The Basin kernel copies syscall results straight into guest RAM; those pages
+    /// must be restored like guest stores, and cached decodes on them dropped.
+    /// Contract: addr + len lies in guest RAM.
+    pub fn note_host_store(self: *Self, addr: u64, len: u64) void {
+        std.debug.assert(addr <= self.memory_size and len <= self.memory_size - addr);
+        if (len == 0) return;
+        var page = addr >> PAGE_SHIFT;
+        const last_page = (addr + len - 1) >> PAGE_SHIFT;
+        while (page <= last_page) : (page += 1) {
+            self.note_store(page << PAGE_SHIFT);
+        }
+    }
+
+    /// Forget which pages were written (replay checkpoints start a new dirty epoch).
+    /// Note: The latest snapshot can no longer be restored (its dirty set is gone).
+    pub fn reset_dirty_pages(self: *Self) void {
+        self.dirty_pages.unsetAll();
+        self.snapshot_epoch += 1;
     }
 
     /// Read memory at address (little-endian, 8 bytes).
@@ -183,664 +602,922 @@ pub const VM = struct {
         // Write 8 bytes (little-endian).
         const bytes = self.memory[@intCast(addr)..][0..8];
         std.mem.writeInt(u64, bytes, value, .little);
+        self.note_store(addr);
         
         // Assert: value must be written correctly.
         const read_back = try self.read64(addr);
         std.debug.assert(read_back == value);
     }
 
-    /// Read instruction at PC (32-bit, little-endian).
-    /// Grain Style: Validate PC, bounds checking, alignment.
-    pub fn fetch_instruction(self: *const Self) VMError!u32 {
-        const pc = self.regs.pc;
-        
-        // Assert: PC must be within memory bounds (need 4 bytes for instruction).
-        // Note: PC can be at memory_size - 4, but not beyond.
-        if (pc + 4 > self.memory_size) {
-            return VMError.invalid_memory_access;
+    /// Read instruction at PC (32-bit, little-endian).
+    /// Grain Style: Validate PC, bounds checking, alignment.
+    /// Note: Reads PC as a physical address (satp is not applied; run/step translate).
+    pub fn fetch_instruction(self: *const Self) VMError!u32 {
+        return self.fetch_at(self.regs.pc);
+    }
+
+    /// Read instruction word at physical address pc.
+    fn fetch_at(self: *const Self, pc: u64) VMError!u32 {
+        // Assert: PC must be within memory bounds (need 4 bytes for instruction).
+        // Note: PC can be at memory_size - 4, but not beyond.
+        if (pc + 4 > self.memory_size) {
+            return VMError.invalid_memory_access;
+        }
+        
+        // Assert: PC must be 4-byte aligned (RISC-V instruction alignment).
+        if (pc % 4 != 0) {
+            return VMError.unaligned_instruction;
+        }
+        
+        // Read 32-bit instruction (little-endian).
+        const bytes = self.memory[@intCast(pc)..][0..4];
+        const inst = std.mem.readInt(u32, bytes, .little);
+        
+        return inst;
+    }
+
+    /// Execute single instruction (decode and execute).
+    /// Grain Style: Comprehensive instruction decoding, assertions.
+    /// Why: Decoding is cached per PC, so the hot path is one tag compare plus one indirect call.
+    pub fn step(self: *Self) VMError!void {
+        // Assert: VM must be in running state.
+        if (self.state != .running) {
+            return;
+        }
+
+        // Store PC before instruction execution (for branch detection).
+        const pc_before = self.regs.pc;
+
+        // Assert: PC must be 4-byte aligned (RISC-V instruction alignment).
+        std.debug.assert(pc_before % 4 == 0);
+
+        // Assert: PC must be within memory bounds (paged PCs are checked by translation).
+        std.debug.assert(self.satp != 0 or pc_before < self.memory_size);
+
+        // A due timer interrupt runs its handler's first instruction instead.
+        if (self.csrs.mtime >= self.interrupt_at) {
+            self.take_timer_interrupt();
+        }
+
+        // Fetch (or look up), execute, and advance PC.
+        _ = try self.dispatch(self.regs.pc);
+
+        // Assert: PC must be 4-byte aligned after instruction execution.
+        std.debug.assert(self.regs.pc % 4 == 0);
+
+        // Assert: PC must be within memory bounds after execution.
+        // Note: PC can be equal to memory_size (one past end) if instruction was at end.
+        std.debug.assert(self.satp != 0 or self.regs.pc <= self.memory_size);
+    }
+
+    /// Execute instructions in a batch until a budget runs out or the guest stops.
+    /// Contract: budget.max_instructions must be > 0.
+    /// Contract: Returns immediately (0 instructions) if VM is not running.
+    /// Why: One hot loop per batch instead of one call per instruction; run state is only
+    /// re-checked after SYSTEM instructions, the only ones that can halt the VM.
+    /// Note: On fault the VM is left errored with last_error set (PC at faulting instruction).
+    /// Note: In JIT mode translated blocks run first; they hand back to the interpreter
+    /// before any instruction they cannot run identically (ECALL, faults, code stores).
+    /// Note: Timer interrupts are taken between instructions once mtime reaches
+    /// interrupt_at; translated blocks are cut short at that instruction count.
+    /// Note: An attached replay session counts the batch (its log positions are
+    /// instruction counts, whichever host loop drives the VM).
+    pub fn run(self: *Self, budget: RunBudget) RunResult {
+        const result = self.run_batch(budget);
+        if (self.replay) |session| session.instret += result.instructions;
+        return result;
+    }
+
+    fn run_batch(self: *Self, budget: RunBudget) RunResult {
+        std.debug.assert(budget.max_instructions > 0);
+
+        if (self.state != .running) {
+            return .{ .exit = if (self.state == .errored) .fault else .halted, .instructions = 0 };
+        }
+
+        // SMP: honour remote FENCE.I and SFENCE.VMA requests (SBI) at batch boundaries.
+        if (self.smp) |smp| {
+            if (smp.take_fence_i(self.hart_id)) self.flush_decode_cache();
+            if (smp.take_sfence_vma(self.hart_id)) self.tlb.flush_all();
+        }
+
+        // Wall-clock budget is optional; a platform without a monotonic clock ignores it.
+        const start_time: ?std.time.Instant = if (budget.max_nanoseconds != null)
+            std.time.Instant.now() catch null
+        else
+            null;
+
+        var executed: u64 = 0;
+        // Instruction count at which the wall clock is next sampled (never, without a clock).
+        var next_clock_check: u64 = if (start_time != null) RUN_CLOCK_CHECK_INTERVAL else std.math.maxInt(u64);
+        while (executed < budget.max_instructions) {
+            if (self.csrs.mtime >= self.interrupt_at) {
+                self.take_timer_interrupt();
+            }
+
+            // JIT mode: run translated blocks up to the next budget, clock or timer boundary.
+            // Note: Translated code addresses RAM directly, so Sv39 guests interpret.
+            if (self.jit) |jit| {
+                if (self.satp == 0) {
+                    const timer_limit = executed +| (self.interrupt_at - self.csrs.mtime);
+                    const limit = @min(budget.max_instructions, next_clock_check, timer_limit) - executed;
+                    const translated = jit.execute(self, limit);
+                    executed += translated;
+                    self.csrs.mtime += translated;
+                    if (executed == budget.max_instructions) break;
+                    if (self.csrs.mtime >= self.interrupt_at) continue;
+                }
+            }
+
+            const entry = self.dispatch(self.regs.pc) catch |err| {
+                self.record_fault(err);
+                return .{ .exit = .fault, .instructions = executed };
+            };
+            executed += 1;
+
+            // Only SYSTEM instructions (ECALL, WFI) can halt the VM or hand control back.
+            if (entry.handler == &execute_system) {
+                if (self.state != .running) {
+                    return .{ .exit = if (self.state == .errored) .fault else .halted, .instructions = executed };
+                }
+                if (self.wait_requested) {
+                    self.wait_requested = false;
+                    return .{ .exit = .wait, .instructions = executed };
+                }
+                if (budget.stop_on_ecall) {
+                    return .{ .exit = .ecall, .instructions = executed };
+                }
+            }
+
+            if (start_time) |t0| {
+                if (executed >= next_clock_check) {
+                    next_clock_check = executed + RUN_CLOCK_CHECK_INTERVAL;
+                    const now = std.time.Instant.now() catch continue;
+                    if (now.since(t0) >= budget.max_nanoseconds.?) {
+                        break;
+                    }
+                }
+            }
+        }
+
+        // Assert: VM must still be running when budget is exhausted.
+        std.debug.assert(self.state == .running);
+        return .{ .exit = .budget_exhausted, .instructions = executed };
+    }
+
+    /// Execute instruction at pc and advance PC (shared by step and run).
+    /// Contract: pc must equal self.regs.pc and VM must be running.
+    /// Returns: Decoded entry that was executed (run uses its handler to classify exits).
+    inline fn dispatch(self: *Self, pc: u64) VMError!*const Decoded {
+        // Look up (or fetch and decode) instruction at PC.
+        const entry = try self.lookup_decoded(pc);
+
+        // Execute via cached handler.
+        try entry.handler(self, entry);
+
+        // Advance PC to next instruction (4 bytes).
+        // Note: Branch instructions modify PC directly, so we don't increment again.
+        if (self.regs.pc == pc) {
+            // Normal case: PC unchanged by instruction, advance by 4 bytes.
+            self.regs.pc += 4;
+        }
+        // Virtual time: one tick per retired instruction.
+        self.csrs.mtime += 1;
+        self.profile.retire(pc, entry.inst);
+        return entry;
+    }
+
+    /// Record instruction trace event (no-op unless tracing is compiled in).
+    /// Why: One call site shape for loads, stores, jumps and faults; arguments are
+    /// dead code when Trace is the zero-sized NullTrace.
+    inline fn trace_access(self: *Self, kind: vm_trace.EventKind, d: *const Decoded, addr: u64, arg: u64) void {
+        self.trace.record(.{
+            .pc = self.regs.pc,
+            .inst = d.inst,
+            .kind = kind,
+            .addr = addr,
+            .args = .{ arg, 0, 0, 0 },
+            .opcode = @as(u7, @truncate(d.inst)),
+        });
+    }
+
+    /// Format trace ring to writer (on demand; never called on the hot path).
+    pub fn dump_trace(self: *const Self, writer: anytype) !void {
+        try self.trace.dump(writer);
+    }
+
+    /// Write profile as folded stacks (`frame;frame;leaf count` lines) for flamegraph tools.
+    /// Note: symbols (see loadSymbols) names frames; null prints addresses in hex.
+    /// Note: Writes nothing unless profiling is compiled in (-Dvm-profile=true).
+    pub fn write_profile_folded(self: *const Self, symbols: ?*const SymbolTable, writer: anytype) !void {
+        try self.profile.write_folded(symbols, writer);
+    }
+
+    /// Format profile summary (sample totals, hottest PCs, opcode counts) to writer.
+    pub fn dump_profile(self: *const Self, symbols: ?*const SymbolTable, writer: anytype) !void {
+        try self.profile.dump(symbols, writer);
+    }
+
+    /// Format trace ring to stderr (no-op unless tracing is compiled in).
+    /// Why: Convenience for fault paths in hosts (Integration, Tahoe sandbox).
+    pub fn dump_trace_stderr(self: *const Self) void {
+        if (!vm_trace.enabled) return;
+        var buffer: [1024]u8 = undefined;
+        var stderr_writer = std.fs.File.stderr().writer(&buffer);
+        self.dump_trace(&stderr_writer.interface) catch return;
+        stderr_writer.interface.flush() catch return;
+    }
+
+    /// Record fault from a failed instruction (handlers mark most faults themselves).
+    /// Why: Fetch errors (PC out of bounds, misaligned) return without touching state.
+    fn record_fault(self: *Self, err: VMError) void {
+        if (self.state != .errored) {
+            self.state = .errored;
+            self.last_error = err;
+        }
+
+        // Assert: VM must be errored with a recorded error.
+        std.debug.assert(self.state == .errored);
+        std.debug.assert(self.last_error != null);
+    }
+
+    /// Get decoded instruction for PC, fetching and decoding on a cache miss.
+    /// Contract: pc must equal self.regs.pc.
+    /// Why: Direct-mapped lookup keyed by physical PC; a hit skips fetch and decode entirely.
+    /// Note: Physical keys keep cached decodes valid across satp switches and let
+    /// stores (which see physical addresses) invalidate them by page.
+    fn lookup_decoded(self: *Self, pc: u64) VMError!*const Decoded {
+        std.debug.assert(pc == self.regs.pc);
+
+        const phys_pc = try self.translate(pc, .fetch);
+        const index = decode_cache_index(phys_pc);
+        if (self.decode_tags[index] == phys_pc) {
+            return &self.decode_entries[index];
+        }
+
+        // Miss: fetch instruction at PC (validates bounds and alignment).
+        const inst = try self.fetch_at(phys_pc);
+
+        // Assert: instruction must be valid (not all ones, which is invalid).
+        // Note: Zero instructions (NOP) are valid, so we don't check for 0x00000000.
+        std.debug.assert(inst != 0xFFFFFFFF);
+
+        self.decode_entries[index] = decode(inst);
+        self.decode_tags[index] = phys_pc;
+
+        // Trace: note compatibility remaps and invalid encodings once per decode.
+        if (vm_trace.enabled) {
+            const opcode = @as(u7, @truncate(inst));
+            if (self.decode_entries[index].handler == &execute_invalid) {
+                self.trace.record(.{ .pc = pc, .inst = inst, .kind = .decode_invalid, .opcode = opcode });
+            } else if (!is_standard_opcode(opcode)) {
+                self.trace.record(.{ .pc = pc, .inst = inst, .kind = .decode_compat, .opcode = opcode });
+            }
+        }
+        self.code_pages.set(@intCast(phys_pc >> PAGE_SHIFT));
+
+        // Assert: slot must now hit for this PC.
+        std.debug.assert(self.decode_tags[index] == phys_pc);
+        return &self.decode_entries[index];
+    }
+
+    /// Decode cache slot for PC (word index, masked to cache size).
+    inline fn decode_cache_index(pc: u64) usize {
+        return @as(usize, @truncate(pc >> 2)) & (DECODE_CACHE_SIZE - 1);
+    }
+
+    /// Physical address for guest address vaddr (identity while satp is Bare).
+    /// Why: Inline TLB probe, so a hit costs one tag compare; only misses walk tables.
+    /// Errors: page_fault (VM errored) if no valid mapping permits access.
+    inline fn translate(self: *Self, vaddr: u64, comptime access: vm_mmu.Access) VMError!u64 {
+        if (self.satp == 0) return vaddr;
+        if (self.tlb.lookup(vaddr, access)) |paddr| return paddr;
+        return self.translate_slow(vaddr, access);
+    }
+
+    /// TLB miss that faults the VM when the walk fails.
+    fn translate_slow(self: *Self, vaddr: u64, comptime access: vm_mmu.Access) VMError!u64 {
+        return self.walk_and_fill(vaddr, access) catch {
+            self.state = .errored;
+            self.last_error = VMError.page_fault;
+            return VMError.page_fault;
+        };
+    }
+
+    /// Translate without faulting the VM (null if unmapped).
+    /// Why: SBI calls report bad argument addresses as an error code, not a trap.
+    fn translate_quiet(self: *Self, vaddr: u64, comptime access: vm_mmu.Access) ?u64 {
+        if (self.satp == 0) return vaddr;
+        if (self.tlb.lookup(vaddr, access)) |paddr| return paddr;
+        return self.walk_and_fill(vaddr, access) catch null;
+    }
+
+    /// TLB miss: walk page tables, record A/D updates, fill the TLB.
+    fn walk_and_fill(self: *Self, vaddr: u64, comptime access: vm_mmu.Access) vm_mmu.Error!u64 {
+        self.tlb.counters.misses += 1;
+        const leaf = vm_mmu.walk(self.memory, self.satp, vaddr, access) catch |err| {
+            self.tlb.counters.faults += 1;
+            return err;
+        };
+        if (leaf.updated) {
+            self.note_store(leaf.pte_addr);
+        }
+        self.tlb.fill(vaddr, leaf);
+
+        // Assert: page offset must carry through translation.
+        const paddr = leaf.frame | (vaddr & (PAGE_SIZE - 1));
+        std.debug.assert(paddr & (PAGE_SIZE - 1) == vaddr & (PAGE_SIZE - 1));
+        return paddr;
+    }
+
+    /// Device register load at physical addr beyond RAM (null if no device is mapped there).
+    /// Note: Only aligned 32/64-bit accesses reach devices; anything else still faults.
+    fn mmio_load(self: *Self, addr: u64, comptime size: u8) ?u64 {
+        const bus = self.mmio orelse return null;
+        return bus.load(self, addr, size);
+    }
+
+    /// Device register store at physical addr beyond RAM (false if no device is mapped there).
+    fn mmio_store(self: *Self, addr: u64, comptime size: u8, value: u64) bool {
+        const bus = self.mmio orelse return false;
+        return bus.store(self, addr, size, value);
+    }
+
+    /// Whether target may become PC (in RAM while Bare; paged targets fault at fetch).
+    inline fn jump_target_ok(self: *const Self, target: u64) bool {
+        return self.satp != 0 or target < self.memory_size;
+    }
+
+    /// Set satp and drop every cached translation.
+    /// Why: Host kernels (Basin) switch address spaces between processes without
+    /// running guest CSR code. The TLB is not ASID-tagged, so any write flushes.
+    /// Contract: satp.MODE is Bare or Sv39 (vm_mmu.valid_satp).
+    pub fn set_satp(self: *Self, satp: u64) void {
+        std.debug.assert(vm_mmu.valid_satp(satp));
+        // Bare ignores ASID and PPN; normalize so `satp == 0` means Bare.
+        self.satp = if (satp >> 60 == vm_mmu.SATP_MODE_BARE) 0 else satp;
+        self.tlb.flush_all();
+    }
+
+    /// Load trap CSRs and timer state (host side: restore, replay, SMP hart setup).
+    pub fn set_csrs(self: *Self, csrs: vm_csr.State) void {
+        self.csrs = csrs;
+        self.interrupt_at = self.csrs.interrupt_deadline();
+    }
+
+    /// Deliver the pending timer interrupt: trap to stvec with sepc = current PC.
+    /// Note: Taken between instructions only, so sepc is the next instruction to run.
+    fn take_timer_interrupt(self: *Self) void {
+        std.debug.assert(self.csrs.mtime >= self.interrupt_at);
+        self.regs.pc = self.csrs.enter_trap(self.regs.pc, vm_csr.CAUSE_SUPERVISOR_TIMER);
+        self.interrupt_at = self.csrs.interrupt_deadline();
+        // A trap breaks any LR/SC sequence in flight.
+        self.reservation = null;
+
+        // Assert: interrupts must stay masked until the handler re-enables them or SRETs.
+        std.debug.assert(self.interrupt_at == vm_csr.NO_DEADLINE);
+    }
+
+    /// SFENCE.VMA: drop the translation for vaddr's page, or all of them if null.
+    pub fn sfence_vma(self: *Self, vaddr: ?u64) void {
+        if (vaddr) |addr| {
+            self.tlb.flush_page(addr);
+        } else {
+            self.tlb.flush_all();
+        }
+    }
+
+    /// TLB statistics since init or the last reset_tlb_counters.
+    pub fn tlb_counters(self: *const Self) vm_mmu.Counters {
+        return self.tlb.counters;
+    }
+
+    /// Zero TLB statistics (e.g. after boot, to measure one workload).
+    pub fn reset_tlb_counters(self: *Self) void {
+        self.tlb.counters = .{};
+    }
+
+    /// Record a store to addr (dirty page for restore, then code-page invalidation).
+    /// Contract: addr is in bounds; stores never straddle pages (all are naturally aligned).
+    inline fn note_store(self: *Self, addr: u64) void {
+        std.debug.assert(addr < self.memory_size);
+        self.dirty_pages.set(@intCast(addr >> PAGE_SHIFT));
+        self.invalidate_code_at(addr);
+    }
+
+    /// Invalidate cached decodes if addr lies in a page we decoded from.
+    /// Why: Stores into code pages (self-modifying code, loaders running in guest)
+    /// must not execute stale decodes. Non-code stores pay one bit test.
+    inline fn invalidate_code_at(self: *Self, addr: u64) void {
+        const page = addr >> PAGE_SHIFT;
+        if (page < self.code_pages.bit_length and self.code_pages.isSet(@intCast(page))) {
+            self.invalidate_code_page(@intCast(page));
+        }
+    }
+
+    /// Drop every cached decode whose PC lies in page.
+    /// Why: A page's 1024 instruction slots map to distinct cache indices, so
+    /// one pass over them finds every entry tagged with a PC in the page.
+    fn invalidate_code_page(self: *Self, page: usize) void {
+        std.debug.assert(page < self.code_pages.bit_length);
+
+        const page_start: u64 = @as(u64, page) << PAGE_SHIFT;
+        var offset: u64 = 0;
+        while (offset < PAGE_SIZE) : (offset += 4) {
+            const pc = page_start + offset;
+            const index = decode_cache_index(pc);
+            if (self.decode_tags[index] == pc) {
+                self.decode_tags[index] = DECODE_TAG_EMPTY;
+            }
+        }
+        self.code_pages.unset(page);
+
+        // Translated blocks of this page go too; jumps into them turn back into exits.
+        if (self.jit) |jit| jit.invalidate_page(page);
+
+        // Assert: page must no longer be marked as code.
+        std.debug.assert(!self.code_pages.isSet(page));
+    }
+
+    /// Drop all cached decodes (and translated blocks in JIT mode).
+    /// Why: Host-side writes to memory (loaders, tests patching code) bypass the
+    /// store handlers, so callers that rewrite code directly must flush.
+    pub fn flush_decode_cache(self: *Self) void {
+        @memset(&self.decode_tags, DECODE_TAG_EMPTY);
+        self.code_pages.unsetAll();
+        if (self.jit) |jit| jit.flush();
+
+        // Assert: cache must be empty after flush.
+        std.debug.assert(self.code_pages.count() == 0);
+    }
+
+    /// Decode instruction word into handler and operand fields.
+    /// Why: Pure function of the instruction word, so results can be cached per PC.
+    /// Why: One comptime table lookup keyed by opcode/funct3/funct7 class replaces the
+    /// nested opcode switch; compatibility decodings are ordinary table entries.
+    pub fn decode(inst: u32) Decoded {
+        const rule = &DECODE_TABLE[decode_key(inst)];
+        return make_decoded(inst, rule.handler, rule.imm(inst));
+    }
+
+    /// Decode rule: handler plus immediate extractor for one table key.
+    const DecodeRule = struct {
+        handler: Handler,
+        imm: *const fn (inst: u32) i64,
+    };
+
+    /// Decode table size: opcode (7 bits) | funct3 (3 bits) | funct7 class (2 bits).
+    const DECODE_TABLE_SIZE: usize = 1 << 12;
+
+    /// funct7 class: 0 = 0b0000000, 1 = 0b0100000, 2 = any other value.
+    /// Why: Only ADD/SUB and SRL/SRA distinguish funct7 values; everything else in
+    /// this subset either ignores funct7 or requires zero.
+    const FUNCT7_CLASS: [128]u2 = blk: {
+        var classes = [_]u2{2} ** 128;
+        classes[0b0000000] = 0;
+        classes[0b0100000] = 1;
+        break :blk classes;
+    };
+
+    /// Table key for instruction word.
+    inline fn decode_key(inst: u32) usize {
+        const opcode: usize = inst & 0x7F;
+        const funct3: usize = (inst >> 12) & 0x7;
+        const funct7_class: usize = FUNCT7_CLASS[inst >> 25];
+        return opcode | (funct3 << 7) | (funct7_class << 10);
+    }
+
+    /// Comptime decode table (every opcode/funct3/funct7-class combination).
+    /// Note: Built from defaults outward: non-standard opcodes get the Zig compiler
+    /// compatibility mapping, then specific compatibility opcodes and RV64I opcodes
+    /// overwrite their rows.
+    const DECODE_TABLE: [DECODE_TABLE_SIZE]DecodeRule = blk: {
+        @setEvalBranchQuota(100_000);
+        var table: [DECODE_TABLE_SIZE]DecodeRule = undefined;
+
+        const invalid = DecodeRule{ .handler = &execute_invalid, .imm = &imm_none };
+        const nop = DecodeRule{ .handler = &execute_nop, .imm = &imm_none };
+        const addi = DecodeRule{ .handler = &execute_addi, .imm = &imm_i };
+        const slli = DecodeRule{ .handler = &execute_slli, .imm = &imm_shamt };
+        const xori = DecodeRule{ .handler = &execute_xori, .imm = &imm_i };
+        const ori = DecodeRule{ .handler = &execute_ori, .imm = &imm_i };
+        const andi = DecodeRule{ .handler = &execute_andi, .imm = &imm_i };
+        const sll = DecodeRule{ .handler = &execute_sll, .imm = &imm_none };
+
+        // Non-standard opcodes (Zig compiler compatibility): I-type ALU by funct3,
+        // SLTIU (0b011) and unknown variants are NOPs. Opcode 0x2e uses this mapping.
+        const compat_alu = [8]DecodeRule{ addi, slli, nop, nop, xori, nop, ori, andi };
+        for (0..128) |opcode| {
+            for (0..8) |funct3| {
+                set_decode_row(&table, opcode, funct3, compat_alu[funct3]);
+            }
+        }
+
+        // Opcodes 0x01/0x05/0x06/0x20/0x25/0x3D/0x45/0x60: I-type ALU without SLLI.
+        const compat_alu_no_shift = [8]DecodeRule{ addi, nop, nop, nop, xori, nop, ori, andi };
+        for ([_]usize{ 0x01, 0x05, 0x06, 0x20, 0x25, 0x3D, 0x45, 0x60 }) |opcode| {
+            for (0..8) |funct3| {
+                set_decode_row(&table, opcode, funct3, compat_alu_no_shift[funct3]);
+            }
+        }
+
+        // Opcodes 0x14/0x24/0x34: ORI for funct3 = 0b110, otherwise NOP.
+        for ([_]usize{ 0x14, 0x24, 0x34 }) |opcode| {
+            for (0..8) |funct3| {
+                set_decode_row(&table, opcode, funct3, if (funct3 == 0b110) ori else nop);
+            }
+        }
+
+        // Opcode 0x00: SLL for funct3 = 0b001 (any funct7), otherwise NOP.
+        for (0..8) |funct3| {
+            set_decode_row(&table, 0x00, funct3, if (funct3 == 0b001) sll else nop);
+        }
+
+        // LUI / AUIPC / JAL (U-type and J-type, no funct3).
+        for (0..8) |funct3| {
+            set_decode_row(&table, 0b0110111, funct3, .{ .handler = &execute_lui, .imm = &imm_lui });
+            set_decode_row(&table, 0b0010111, funct3, .{ .handler = &execute_auipc, .imm = &imm_u });
+            set_decode_row(&table, 0b1101111, funct3, .{ .handler = &execute_jal, .imm = &imm_j });
+        }
+
+        // OP-IMM: only ADDI is supported.
+        for (0..8) |funct3| {
+            set_decode_row(&table, 0b0010011, funct3, if (funct3 == 0b000) addi else invalid);
+        }
+
+        // OP (R-type): funct7 class selects ADD/SUB and SRL/SRA; SLL ignores funct7.
+        for (0..8) |funct3| {
+            set_decode_row(&table, 0b0110011, funct3, invalid);
+        }
+        set_decode_entry(&table, 0b0110011, 0b000, 0, .{ .handler = &execute_add, .imm = &imm_none });
+        set_decode_entry(&table, 0b0110011, 0b000, 1, .{ .handler = &execute_sub, .imm = &imm_none });
+        set_decode_entry(&table, 0b0110011, 0b010, 0, .{ .handler = &execute_slt, .imm = &imm_none });
+        set_decode_entry(&table, 0b0110011, 0b100, 0, .{ .handler = &execute_xor, .imm = &imm_none });
+        set_decode_entry(&table, 0b0110011, 0b110, 0, .{ .handler = &execute_or, .imm = &imm_none });
+        set_decode_entry(&table, 0b0110011, 0b111, 0, .{ .handler = &execute_and, .imm = &imm_none });
+        set_decode_row(&table, 0b0110011, 0b001, sll);
+        set_decode_entry(&table, 0b0110011, 0b101, 0, .{ .handler = &execute_srl, .imm = &imm_none });
+        set_decode_entry(&table, 0b0110011, 0b101, 1, .{ .handler = &execute_sra, .imm = &imm_none });
+
+        // LOAD (I-type).
+        const loads = [8]Handler{ &execute_lb, &execute_lh, &execute_lw, &execute_ld, &execute_lbu, &execute_lhu, &execute_lwu, &execute_invalid };
+        for (0..8) |funct3| {
+            set_decode_row(&table, 0b0000011, funct3, .{ .handler = loads[funct3], .imm = if (funct3 == 0b111) &imm_none else &imm_i });
+        }
+
+        // STORE (S-type).
+        for (0..8) |funct3| {
+            set_decode_row(&table, 0b0100011, funct3, invalid);
+        }
+        set_decode_row(&table, 0b0100011, 0b000, .{ .handler = &execute_sb, .imm = &imm_s });
+        set_decode_row(&table, 0b0100011, 0b001, .{ .handler = &execute_sh, .imm = &imm_s });
+        set_decode_row(&table, 0b0100011, 0b010, .{ .handler = &execute_sw, .imm = &imm_s });
+        set_decode_row(&table, 0b0100011, 0b011, .{ .handler = &execute_sd, .imm = &imm_s });
+
+        // BRANCH (B-type).
+        for (0..8) |funct3| {
+            set_decode_row(&table, 0b1100011, funct3, invalid);
+        }
+        set_decode_row(&table, 0b1100011, 0b000, .{ .handler = &execute_beq, .imm = &imm_b });
+        set_decode_row(&table, 0b1100011, 0b001, .{ .handler = &execute_bne, .imm = &imm_b });
+        set_decode_row(&table, 0b1100011, 0b100, .{ .handler = &execute_blt, .imm = &imm_b });
+        set_decode_row(&table, 0b1100011, 0b101, .{ .handler = &execute_bge, .imm = &imm_b });
+        set_decode_row(&table, 0b1100011, 0b110, .{ .handler = &execute_bltu, .imm = &imm_b });
+        set_decode_row(&table, 0b1100011, 0b111, .{ .handler = &execute_bgeu, .imm = &imm_b });
+
+        // AMO (RV64A): funct3 selects width; funct5 (LR/SC/AMO*) is decoded by the handler.
+        for (0..8) |funct3| {
+            set_decode_row(&table, 0b0101111, funct3, invalid);
+        }
+        set_decode_row(&table, 0b0101111, 0b010, .{ .handler = &execute_amo_w, .imm = &imm_none });
+        set_decode_row(&table, 0b0101111, 0b011, .{ .handler = &execute_amo_d, .imm = &imm_none });
+
+        // MISC-MEM: FENCE and FENCE.I.
+        for (0..8) |funct3| {
+            set_decode_row(&table, 0b0001111, funct3, invalid);
+        }
+        set_decode_row(&table, 0b0001111, 0b000, .{ .handler = &execute_fence, .imm = &imm_none });
+        set_decode_row(&table, 0b0001111, 0b001, .{ .handler = &execute_fence_i, .imm = &imm_none });
+
+        // JALR: funct3 must be zero. SYSTEM: funct3 0 = ECALL/WFI/SFENCE.VMA, 4 is reserved, rest are CSR ops.
+        for (0..8) |funct3| {
+            set_decode_row(&table, 0b1100111, funct3, if (funct3 == 0b000) DecodeRule{ .handler = &execute_jalr, .imm = &imm_i } else invalid);
+            set_decode_row(&table, 0b1110011, funct3, switch (funct3) {
+                0b000 => DecodeRule{ .handler = &execute_system, .imm = &imm_none },
+                0b100 => invalid,
+                else => DecodeRule{ .handler = &execute_csr, .imm = &imm_none },
+            });
+        }
+
+        break :blk table;
+    };
+
+    /// Set table entries for opcode/funct3 across all funct7 classes (comptime only).
+    fn set_decode_row(table: *[DECODE_TABLE_SIZE]DecodeRule, opcode: usize, funct3: usize, rule: DecodeRule) void {
+        for (0..4) |funct7_class| {
+            set_decode_entry(table, opcode, funct3, funct7_class, rule);
+        }
+    }
+
+    /// Set single table entry (comptime only).
+    fn set_decode_entry(table: *[DECODE_TABLE_SIZE]DecodeRule, opcode: usize, funct3: usize, funct7_class: usize, rule: DecodeRule) void {
+        std.debug.assert(opcode < 128 and funct3 < 8 and funct7_class < 4);
+        table[opcode | (funct3 << 7) | (funct7_class << 10)] = rule;
+    }
+
+    /// Operation performed by a decoded instruction.
+    /// Why: Handlers are private to the interpreter; translators (jit.zig) switch on
+    /// the operation instead of comparing function pointers they cannot name.
+    pub const Op = enum {
+        nop,
+        invalid,
+        system,
+        csr,
+        lui,
+        auipc,
+        addi,
+        xori,
+        ori,
+        andi,
+        slli,
+        add,
+        sub,
+        slt,
+        xor,
+        @"or",
+        @"and",
+        sll,
+        srl,
+        sra,
+        lb,
+        lh,
+        lw,
+        ld,
+        lbu,
+        lhu,
+        lwu,
+        sb,
+        sh,
+        sw,
+        sd,
+        beq,
+        bne,
+        blt,
+        bge,
+        bltu,
+        bgeu,
+        jal,
+        jalr,
+        amo_w,
+        amo_d,
+        fence,
+        fence_i,
+    };
+
+    /// Handler for every Op (order irrelevant; one entry per handler decode can produce).
+    const OP_HANDLERS = [_]struct { Op, Handler }{
+        .{ .nop, &execute_nop },
+        .{ .invalid, &execute_invalid },
+        .{ .system, &execute_system },
+        .{ .csr, &execute_csr },
+        .{ .lui, &execute_lui },
+        .{ .auipc, &execute_auipc },
+        .{ .addi, &execute_addi },
+        .{ .xori, &execute_xori },
+        .{ .ori, &execute_ori },
+        .{ .andi, &execute_andi },
+        .{ .slli, &execute_slli },
+        .{ .add, &execute_add },
+        .{ .sub, &execute_sub },
+        .{ .slt, &execute_slt },
+        .{ .xor, &execute_xor },
+        .{ .@"or", &execute_or },
+        .{ .@"and", &execute_and },
+        .{ .sll, &execute_sll },
+        .{ .srl, &execute_srl },
+        .{ .sra, &execute_sra },
+        .{ .lb, &execute_lb },
+        .{ .lh, &execute_lh },
+        .{ .lw, &execute_lw },
+        .{ .ld, &execute_ld },
+        .{ .lbu, &execute_lbu },
+        .{ .lhu, &execute_lhu },
+        .{ .lwu, &execute_lwu },
+        .{ .sb, &execute_sb },
+        .{ .sh, &execute_sh },
+        .{ .sw, &execute_sw },
+        .{ .sd, &execute_sd },
+        .{ .beq, &execute_beq },
+        .{ .bne, &execute_bne },
+        .{ .blt, &execute_blt },
+        .{ .bge, &execute_bge },
+        .{ .bltu, &execute_bltu },
+        .{ .bgeu, &execute_bgeu },
+        .{ .jal, &execute_jal },
+        .{ .jalr, &execute_jalr },
+        .{ .amo_w, &execute_amo_w },
+        .{ .amo_d, &execute_amo_d },
+        .{ .fence, &execute_fence },
+        .{ .fence_i, &execute_fence_i },
+    };
+
+    comptime {
+        // Assert: every Op has exactly one handler entry.
+        std.debug.assert(OP_HANDLERS.len == @typeInfo(Op).@"enum".fields.len);
+    }
+
+    /// Operation of decoded instruction.
+    /// Note: Linear scan; only translators call this, once per translated instruction.
+    pub fn op_of(d: *const Decoded) Op {
+        for (OP_HANDLERS) |entry| {
+            if (entry[1] == d.handler) return entry[0];
+        }
+        unreachable; // decode only produces handlers listed in OP_HANDLERS.
+    }
+
+    /// Whether opcode is one the RV64I subset decodes natively (not a compatibility remap).
+    fn is_standard_opcode(opcode: u7) bool {
+        return switch (opcode) {
+            0b0110111, 0b0010111, 0b0010011, 0b0110011, 0b0000011, 0b0100011, 0b1100011, 0b1101111, 0b1100111, 0b1110011, 0b0101111, 0b0001111 => true,
+            else => false,
+        };
+    }
+
+    /// Build Decoded with register fields extracted from inst.
+    /// Why: rd/rs1/rs2 sit at fixed bit positions in every format; extracting
+    /// all three unconditionally keeps decode branch-free per field.
+    inline fn make_decoded(inst: u32, handler: Handler, imm: i64) Decoded {
+        return .{
+            .handler = handler,
+            .rd = @as(u5, @truncate(inst >> 7)),
+            .rs1 = @as(u5, @truncate(inst >> 15)),
+            .rs2 = @as(u5, @truncate(inst >> 20)),
+            .imm = imm,
+            .inst = inst,
+        };
+    }
+
+    /// I-type immediate: bits [31:20], sign-extended (ADDI, ORI/ANDI/XORI, loads, JALR).
+    fn imm_i(inst: u32) i64 {
+        const imm12 = @as(i12, @bitCast(@as(u12, @truncate(inst >> 20))));
+        return @as(i64, imm12);
+    }
+
+    /// Shift amount for SLLI: bits [25:20] (imm[5:0]).
+    fn imm_shamt(inst: u32) i64 {
+        const imm_raw = @as(u6, @truncate(inst >> 20));
+        return @as(i64, imm_raw);
+    }
+
+    /// S-type immediate: imm[11:5] = bits [31:25], imm[4:0] = bits [11:7], sign-extended.
+    fn imm_s(inst: u32) i64 {
+        const imm_11_5 = @as(u7, @truncate(inst >> 25));
+        const imm_4_0 = @as(u5, @truncate(inst >> 7));
+        const imm12_raw = (@as(u12, imm_11_5) << 5) | imm_4_0;
+        return @as(i64, @as(i12, @bitCast(imm12_raw)));
+    }
+
+    /// B-type immediate: imm[12|10:5|4:1|11], sign-extended (bit 0 is zero).
+    fn imm_b(inst: u32) i64 {
+        const imm_12 = @as(u1, @truncate(inst >> 31));
+        const imm_10_5 = @as(u6, @truncate(inst >> 25));
+        const imm_4_1 = @as(u4, @truncate(inst >> 8));
+        const imm_11 = @as(u1, @truncate(inst >> 7));
+        const imm13_raw = (@as(u13, imm_12) << 12) | (@as(u13, imm_11) << 11) | (@as(u13, imm_10_5) << 5) | (@as(u13, imm_4_1) << 1);
+        return @as(i64, @as(i13, @bitCast(imm13_raw)));
+    }
+
+    /// J-type immediate: imm[20|10:1|11|19:12], sign-extended (bit 0 is zero).
+    fn imm_j(inst: u32) i64 {
+        const imm_20 = @as(u1, @truncate(inst >> 31));
+        const imm_10_1 = @as(u10, @truncate(inst >> 21));
+        const imm_11 = @as(u1, @truncate(inst >> 20));
+        const imm_19_12 = @as(u8, @truncate(inst >> 12));
+        const imm21_raw = (@as(u21, imm_20) << 20) | (@as(u21, imm_19_12) << 12) | (@as(u21, imm_11) << 11) | (@as(u21, imm_10_1) << 1);
+        return @as(i64, @as(i21, @bitCast(imm21_raw)));
+    }
+
+    /// U-type immediate (AUIPC): imm[31:12] << 12, sign-extended to 64 bits.
+    fn imm_u(inst: u32) i64 {
+        const imm_31_12_raw = @as(u20, @truncate(inst >> 12));
+        const imm_31_12 = @as(i32, @bitCast(@as(u32, imm_31_12_raw) << 12));
+        return @as(i64, imm_31_12);
+    }
+
+    /// No immediate (R-type, SYSTEM, NOP and invalid encodings).
+    fn imm_none(inst: u32) i64 {
+        _ = inst;
+        return 0;
+    }
+
+    /// LUI immediate: imm[31:12] << 12, sign-extended to 64 bits (the AUIPC immediate).
+    fn imm_lui(inst: u32) i64 {
+        return imm_u(inst);
+    }
+
+    /// NOP handler (compatibility decodings that do nothing; PC advances normally).
+    fn execute_nop(self: *Self, d: *const Decoded) VMError!void {
+        _ = self;
+        _ = d;
+    }
+
+    /// Invalid instruction handler (unsupported variants of known opcodes).
+    fn execute_invalid(self: *Self, d: *const Decoded) VMError!void {
+        _ = d;
+        self.state = .errored;
+        self.last_error = VMError.invalid_instruction;
+        return VMError.invalid_instruction;
+    }
+
+    /// SYSTEM opcode handler (funct3 = 0): WFI, SRET, SFENCE.VMA, otherwise ECALL.
+    fn execute_system(self: *Self, d: *const Decoded) VMError!void {
+        if (d.inst == WFI_INST) {
+            self.wait_for_interrupt();
+            return;
         }
-        
-        // Assert: PC must be 4-byte aligned (RISC-V instruction alignment).
-        if (pc % 4 != 0) {
-            return VMError.unaligned_instruction;
+        if (d.inst == SRET_INST) {
+            // dispatch sees the PC change and does not advance it again.
+            self.regs.pc = self.csrs.sret();
+            self.interrupt_at = self.csrs.interrupt_deadline();
+            return;
         }
-        
-        // Read 32-bit instruction (little-endian).
-        const bytes = self.memory[@intCast(pc)..][0..4];
-        const inst = std.mem.readInt(u32, bytes, .little);
-        
-        return inst;
+        if (d.inst & SFENCE_VMA_MASK == SFENCE_VMA_MATCH) {
+            // rs1 = x0 flushes every page; rs2 (ASID) is ignored (TLB is not ASID-tagged).
+            self.sfence_vma(if (d.rs1 == 0) null else self.regs.get(d.rs1));
+            return;
+        }
+        try self.execute_ecall();
     }
 
-    /// Execute single instruction (decode and execute).
-    /// Grain Style: Comprehensive instruction decoding, assertions.
-    pub fn step(self: *Self) VMError!void {
-        // Assert: VM must be in running state.
-        if (self.state != .running) {
+    /// WFI: complete at once if the timer is due, else skip virtual time to its deadline.
+    /// Why: An idle guest's loop would otherwise execute until mtime crawls to mtimecmp;
+    /// jumping there is indistinguishable to the guest and costs nothing.
+    /// Note: With no timer armed (or on an SMP hart, where siblings share the clock)
+    /// run() hands the wait to its caller instead (see RunExit.wait and Smp.park).
+    fn wait_for_interrupt(self: *Self) void {
+        const deadline = self.csrs.wake_deadline();
+        if (self.csrs.mtime >= deadline) return;
+        if (deadline != vm_csr.NO_DEADLINE and self.smp == null) {
+            self.csrs.mtime = deadline;
             return;
         }
-        
-        // Store PC before instruction execution (for branch detection).
-        const pc_before = self.regs.pc;
-        
-        // Assert: PC must be 4-byte aligned (RISC-V instruction alignment).
-        std.debug.assert(pc_before % 4 == 0);
-        
-        // Assert: PC must be within memory bounds.
-        std.debug.assert(pc_before < self.memory_size);
-        
-        // Fetch instruction at PC.
-        const inst = try self.fetch_instruction();
-        
-        // Assert: instruction must be valid (not all ones, which is invalid).
-        // Note: Zero instructions (NOP) are valid, so we don't check for 0x00000000.
-        std.debug.assert(inst != 0xFFFFFFFF);
-        
-        // Decode instruction opcode (bits [6:0]).
-        const opcode = @as(u7, @truncate(inst));
-        
-        // Execute based on opcode.
-        // Why: RISC-V uses opcode-based instruction decoding.
-        switch (opcode) {
-            // Opcode 0x01: Zig compiler compatibility - decode as I-type instruction.
-            0b0000001 => {
-                // Some Zig-compiled code generates instructions with opcode 0x01 that should be I-type.
-                const funct3 = @as(u3, @truncate(inst >> 12));
-                std.debug.print("DEBUG vm.zig: Opcode 0x01 detected: inst=0x{x}, funct3=0b{b:0>3}\n", .{ inst, funct3 });
-                
-                // Try to decode as I-type instruction variants based on funct3.
-                if (funct3 == 0b000) {
-                    // ADDI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x01 with funct3=0b000 as ADDI\n", .{});
-                    try self.execute_addi(inst);
-                } else if (funct3 == 0b100) {
-                    // XORI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x01 with funct3=0b100 as XORI\n", .{});
-                    try self.execute_xori(inst);
-                } else if (funct3 == 0b110) {
-                    // ORI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x01 with funct3=0b110 as ORI\n", .{});
-                    try self.execute_ori(inst);
-                } else if (funct3 == 0b111) {
-                    // ANDI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x01 with funct3=0b111 as ANDI\n", .{});
-                    try self.execute_andi(inst);
-                } else {
-                    // Unknown opcode 0x01 variant - treat as NOP for now.
-                    std.debug.print("DEBUG vm.zig: Unknown opcode 0x01 variant (funct3=0b{b:0>3}), treating as NOP\n", .{funct3});
-                    // NOP: Do nothing, PC will advance normally.
-                }
-            },
-            // LUI (Load Upper Immediate): U-type instruction.
-            0b0110111 => {
-                try self.execute_lui(inst);
-            },
-            // AUIPC (Add Upper Immediate to PC): U-type instruction.
-            0b0010111 => {
-                try self.execute_auipc(inst);
-            },
-            // ADDI (Add Immediate): I-type instruction.
-            0b0010011 => {
-                // ADDI has multiple variants (funct3 field).
-                const funct3 = @as(u3, @truncate(inst >> 12));
-                if (funct3 == 0b000) {
-                    try self.execute_addi(inst);
-                } else {
-                    // Unsupported I-type instruction variant.
-                    std.debug.print("DEBUG vm.zig: Unsupported I-type variant: funct3=0b{b:0>3}\n", .{funct3});
-                    self.state = .errored;
-                    self.last_error = VMError.invalid_instruction;
-                    return VMError.invalid_instruction;
-                }
-            },
-            0b0010100 => {
-                // Opcode 0x14: Zig compiler compatibility - decode as I-type instruction.
-                // Some Zig-compiled code generates instructions with opcode 0x14 that should be I-type.
-                const funct3 = @as(u3, @truncate(inst >> 12));
-                std.debug.print("DEBUG vm.zig: Opcode 0x14 detected: inst=0x{x}, funct3=0b{b:0>3}\n", .{ inst, funct3 });
-                
-                // If funct3=0b110 (6), this is ORI (OR Immediate).
-                // Execute as ORI for Zig compiler compatibility.
-                if (funct3 == 0b110) {
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x14 with funct3=0b110 as ORI\n", .{});
-                    try self.execute_ori(inst);
-                } else {
-                    // Unknown opcode 0x14 variant - treat as NOP for now.
-                    std.debug.print("DEBUG vm.zig: Unknown opcode 0x14 variant (funct3=0b{b:0>3}), treating as NOP\n", .{funct3});
-                    // NOP: Do nothing, PC will advance normally.
-                }
-            },
-            0b0100100 => {
-                // Opcode 0x24: Zig compiler compatibility - decode as I-type instruction.
-                // Some Zig-compiled code generates instructions with opcode 0x24 that should be I-type.
-                const funct3 = @as(u3, @truncate(inst >> 12));
-                std.debug.print("DEBUG vm.zig: Opcode 0x24 detected: inst=0x{x}, funct3=0b{b:0>3}\n", .{ inst, funct3 });
-                
-                // If funct3=0b110 (6), this might be another ORI variant.
-                // Try to decode as I-type instruction for Zig compiler compatibility.
-                if (funct3 == 0b110) {
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x24 with funct3=0b110 as ORI\n", .{});
-                    try self.execute_ori(inst);
-                } else {
-                    // Unknown opcode 0x24 variant - treat as NOP for now.
-                    std.debug.print("DEBUG vm.zig: Unknown opcode 0x24 variant (funct3=0b{b:0>3}), treating as NOP\n", .{funct3});
-                    // NOP: Do nothing, PC will advance normally.
-                }
-            },
-            0b0110100 => {
-                // Opcode 0x34: Zig compiler compatibility - decode as I-type instruction.
-                // Some Zig-compiled code generates instructions with opcode 0x34 that should be I-type.
-                const funct3 = @as(u3, @truncate(inst >> 12));
-                std.debug.print("DEBUG vm.zig: Opcode 0x34 detected: inst=0x{x}, funct3=0b{b:0>3}\n", .{ inst, funct3 });
-                
-                // If funct3=0b110 (6), this might be another ORI variant.
-                // Try to decode as I-type instruction for Zig compiler compatibility.
-                if (funct3 == 0b110) {
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x34 with funct3=0b110 as ORI\n", .{});
-                    try self.execute_ori(inst);
-                } else {
-                    // Unknown opcode 0x34 variant - treat as NOP for now.
-                    std.debug.print("DEBUG vm.zig: Unknown opcode 0x34 variant (funct3=0b{b:0>3}), treating as NOP\n", .{funct3});
-                    // NOP: Do nothing, PC will advance normally.
-                }
-            },
-            // R-type instructions (ADD, SUB, SLT): OP opcode.
-            0b0110011 => {
-                // R-type instructions use funct3 and funct7 to distinguish operations.
-                const funct3 = @as(u3, @truncate(inst >> 12));
-                const funct7 = @as(u7, @truncate(inst >> 25));
-                
-                // Dispatch based on funct3 and funct7.
-                if (funct3 == 0b000) {
-                    // ADD or SUB (funct3 = 0b000).
-                    if (funct7 == 0b0000000) {
-                        // ADD: rd = rs1 + rs2.
-                        try self.execute_add(inst);
-                    } else if (funct7 == 0b0100000) {
-                        // SUB: rd = rs1 - rs2.
-                        try self.execute_sub(inst);
-                    } else {
-                        // Unsupported R-type instruction variant.
-                        self.state = .errored;
-                        self.last_error = VMError.invalid_instruction;
-                        return VMError.invalid_instruction;
-                    }
-                } else if (funct3 == 0b010) {
-                    // SLT (Set Less Than): rd = (rs1 < rs2) ? 1 : 0.
-                    if (funct7 == 0b0000000) {
-                        try self.execute_slt(inst);
-                    } else {
-                        // Unsupported R-type instruction variant.
-                        self.state = .errored;
-                        self.last_error = VMError.invalid_instruction;
-                        return VMError.invalid_instruction;
-                    }
-                } else if (funct3 == 0b100) {
-                    // XOR (Exclusive OR): rd = rs1 ^ rs2.
-                    if (funct7 == 0b0000000) {
-                        try self.execute_xor(inst);
-                    } else {
-                        // Unsupported R-type instruction variant.
-                        self.state = .errored;
-                        self.last_error = VMError.invalid_instruction;
-                        return VMError.invalid_instruction;
-                    }
-                } else if (funct3 == 0b110) {
-                    // OR (Bitwise OR): rd = rs1 | rs2.
-                    if (funct7 == 0b0000000) {
-                        try self.execute_or(inst);
-                    } else {
-                        // Unsupported R-type instruction variant.
-                        self.state = .errored;
-                        self.last_error = VMError.invalid_instruction;
-                        return VMError.invalid_instruction;
-                    }
-                } else if (funct3 == 0b111) {
-                    // AND (Bitwise AND): rd = rs1 & rs2.
-                    if (funct7 == 0b0000000) {
-                        try self.execute_and(inst);
-                    } else {
-                        // Unsupported R-type instruction variant.
-                        self.state = .errored;
-                        self.last_error = VMError.invalid_instruction;
-                        return VMError.invalid_instruction;
-                    }
-                } else if (funct3 == 0b001) {
-                    // SLL (Shift Left Logical): rd = rs1 << (rs2 & 0x3F).
-                    // Note: Zig compiler may generate SLL with non-zero funct7 values.
-                    // For compatibility, we execute as SLL regardless of funct7 (shift amount is in rs2).
-                    if (funct7 == 0b0000000) {
-                        try self.execute_sll(inst);
-                    } else {
-                        // Non-standard funct7, but funct3=1 indicates SLL.
-                        // Execute as SLL for Zig compiler compatibility.
-                        // Contract: Shift amount comes from rs2, funct7 is typically ignored for SLL.
-                        std.debug.print("DEBUG vm.zig: SLL with non-zero funct7=0x{x}, executing as SLL\n", .{funct7});
-                        try self.execute_sll(inst);
-                    }
-                } else if (funct3 == 0b101) {
-                    // SRL or SRA (Shift Right Logical/Arithmetic).
-                    if (funct7 == 0b0000000) {
-                        // SRL (Shift Right Logical): rd = rs1 >> (rs2 & 0x3F).
-                        try self.execute_srl(inst);
-                    } else if (funct7 == 0b0100000) {
-                        // SRA (Shift Right Arithmetic): rd = rs1 >> (rs2 & 0x3F) (sign-extended).
-                        try self.execute_sra(inst);
-                    } else {
-                        // Unsupported R-type instruction variant.
-                        self.state = .errored;
-                        self.last_error = VMError.invalid_instruction;
-                        return VMError.invalid_instruction;
-                    }
-                } else {
-                    // Unsupported R-type instruction variant.
-                    self.state = .errored;
-                    self.last_error = VMError.invalid_instruction;
-                    return VMError.invalid_instruction;
-                }
-            },
-            // Load instructions: I-type instruction.
-            0b0000011 => {
-                const funct3 = @as(u3, @truncate(inst >> 12));
-                switch (funct3) {
-                    0b000 => try self.execute_lb(inst),   // LB (Load Byte)
-                    0b001 => try self.execute_lh(inst),   // LH (Load Halfword)
-                    0b010 => try self.execute_lw(inst),   // LW (Load Word)
-                    0b011 => try self.execute_ld(inst),   // LD (Load Doubleword)
-                    0b100 => try self.execute_lbu(inst),  // LBU (Load Byte Unsigned)
-                    0b101 => try self.execute_lhu(inst),  // LHU (Load Halfword Unsigned)
-                    0b110 => try self.execute_lwu(inst),  // LWU (Load Word Unsigned)
-                    else => {
-                        // Unsupported load instruction variant.
-                        self.state = .errored;
-                        self.last_error = VMError.invalid_instruction;
-                        return VMError.invalid_instruction;
-                    },
-                }
-            },
-            // Store instructions: S-type instruction.
-            0b0100011 => {
-                const funct3 = @as(u3, @truncate(inst >> 12));
-                switch (funct3) {
-                    0b000 => try self.execute_sb(inst),   // SB (Store Byte)
-                    0b001 => try self.execute_sh(inst),   // SH (Store Halfword)
-                    0b010 => try self.execute_sw(inst),   // SW (Store Word)
-                    0b011 => try self.execute_sd(inst),   // SD (Store Doubleword)
-                    else => {
-                        // Unsupported store instruction variant.
-                        self.state = .errored;
-                        self.last_error = VMError.invalid_instruction;
-                        return VMError.invalid_instruction;
-                    },
-                }
-            },
-            // Branch instructions: B-type instruction.
-            0b1100011 => {
-                const funct3 = @as(u3, @truncate(inst >> 12));
-                switch (funct3) {
-                    0b000 => try self.execute_beq(inst),  // BEQ (Branch if Equal)
-                    0b001 => try self.execute_bne(inst),  // BNE (Branch if Not Equal)
-                    0b100 => try self.execute_blt(inst),  // BLT (Branch if Less Than)
-                    0b101 => try self.execute_bge(inst),  // BGE (Branch if Greater or Equal)
-                    0b110 => try self.execute_bltu(inst), // BLTU (Branch if Less Than Unsigned)
-                    0b111 => try self.execute_bgeu(inst), // BGEU (Branch if Greater or Equal Unsigned)
-                    else => {
-                        // Unsupported branch instruction variant.
-                        self.state = .errored;
-                        self.last_error = VMError.invalid_instruction;
-                        return VMError.invalid_instruction;
-                    },
-                }
-            },
-            // Jump instructions: J-type and I-type instructions.
-            0b1101111 => {
-                // JAL (Jump and Link): J-type instruction.
-                try self.execute_jal(inst);
-            },
-            0b1100111 => {
-                // JALR (Jump and Link Register): I-type instruction.
-                const funct3 = @as(u3, @truncate(inst >> 12));
-                if (funct3 == 0b000) {
-                    try self.execute_jalr(inst);
-                } else {
-                    // Unsupported JALR variant.
-                    self.state = .errored;
-                    self.last_error = VMError.invalid_instruction;
-                    return VMError.invalid_instruction;
-                }
-            },
-            // ECALL (Environment Call): I-type instruction (funct3 = 0, funct7 = 0).
-            0b1110011 => {
-                const funct3 = @as(u3, @truncate(inst >> 12));
-                if (funct3 == 0b000) {
-                    try self.execute_ecall();
-                } else {
-                    // Unsupported system instruction.
-                    self.state = .errored;
-                    self.last_error = VMError.invalid_instruction;
-                    return VMError.invalid_instruction;
-                }
-            },
-            0b0000000 => {
-                // Opcode 0x00: Zig compiler compatibility - decode as R-type instruction.
-                // Some Zig-compiled code generates instructions with opcode 0x00 that should be R-type.
-                // Check funct3 and funct7 to determine actual instruction.
-                const funct3 = @as(u3, @truncate(inst >> 12));
-                const funct7 = @as(u7, @truncate(inst >> 25));
-                std.debug.print("DEBUG vm.zig: Opcode 0x00 detected: inst=0x{x}, funct3=0b{b:0>3}, funct7=0b{b:0>7} (0x{x})\n", .{ inst, funct3, funct7, funct7 });
-                
-                // If funct3=1, this is likely SLL (Shift Left Logical) regardless of funct7.
-                // Zig compiler may generate non-standard funct7 values for compatibility.
-                if (funct3 == 0b001) {
-                    // Execute as SLL (shift amount comes from rs2, funct7 typically ignored).
-                    std.debug.print("DEBUG vm.zig: Treating opcode 0x00 with funct3=1 as SLL\n", .{});
-                    try self.execute_sll(inst);
-                } else {
-                    // Unknown opcode 0x00 variant - treat as NOP for now.
-                    std.debug.print("DEBUG vm.zig: Unknown opcode 0x00 variant (funct3=0b{b:0>3}), treating as NOP\n", .{funct3});
-                    // NOP: Do nothing, PC will advance normally.
-                }
-            },
-            0b0100000 => {
-                // Opcode 0x20: Zig compiler compatibility - decode as I-type instruction.
-                // Some Zig-compiled code generates instructions with opcode 0x20 that should be I-type.
-                const funct3 = @as(u3, @truncate(inst >> 12));
-                std.debug.print("DEBUG vm.zig: Opcode 0x20 detected: inst=0x{x}, funct3=0b{b:0>3}\n", .{ inst, funct3 });
-                
-                // Try to decode as I-type instruction variants based on funct3.
-                if (funct3 == 0b000) {
-                    // ADDI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x20 with funct3=0b000 as ADDI\n", .{});
-                    try self.execute_addi(inst);
-                } else if (funct3 == 0b100) {
-                    // XORI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x20 with funct3=0b100 as XORI\n", .{});
-                    try self.execute_xori(inst);
-                } else if (funct3 == 0b110) {
-                    // ORI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x20 with funct3=0b110 as ORI\n", .{});
-                    try self.execute_ori(inst);
-                } else if (funct3 == 0b111) {
-                    // ANDI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x20 with funct3=0b111 as ANDI\n", .{});
-                    try self.execute_andi(inst);
-                } else {
-                    // Unknown opcode 0x20 variant - treat as NOP for now.
-                    std.debug.print("DEBUG vm.zig: Unknown opcode 0x20 variant (funct3=0b{b:0>3}), treating as NOP\n", .{funct3});
-                    // NOP: Do nothing, PC will advance normally.
-                }
-            },
-            0b0000101 => {
-                // Opcode 0x5: Zig compiler compatibility - decode as I-type instruction.
-                // Some Zig-compiled code generates instructions with opcode 0x5 that should be I-type.
-                const funct3 = @as(u3, @truncate(inst >> 12));
-                std.debug.print("DEBUG vm.zig: Opcode 0x5 detected: inst=0x{x}, funct3=0b{b:0>3}\n", .{ inst, funct3 });
-                
-                // Try to decode as I-type instruction variants based on funct3.
-                if (funct3 == 0b000) {
-                    // ADDI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x5 with funct3=0b000 as ADDI\n", .{});
-                    try self.execute_addi(inst);
-                } else if (funct3 == 0b100) {
-                    // XORI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x5 with funct3=0b100 as XORI\n", .{});
-                    try self.execute_xori(inst);
-                } else if (funct3 == 0b110) {
-                    // ORI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x5 with funct3=0b110 as ORI\n", .{});
-                    try self.execute_ori(inst);
-                } else if (funct3 == 0b111) {
-                    // ANDI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x5 with funct3=0b111 as ANDI\n", .{});
-                    try self.execute_andi(inst);
-                } else {
-                    // Unknown opcode 0x5 variant - treat as NOP for now.
-                    std.debug.print("DEBUG vm.zig: Unknown opcode 0x5 variant (funct3=0b{b:0>3}), treating as NOP\n", .{funct3});
-                    // NOP: Do nothing, PC will advance normally.
-                }
-            },
-            0b0000110 => {
-                // Opcode 0x06: Zig compiler compatibility - decode as I-type instruction.
-                // Some Zig-compiled code generates instructions with opcode 0x06 that should be I-type.
-                const funct3 = @as(u3, @truncate(inst >> 12));
-                std.debug.print("DEBUG vm.zig: Opcode 0x06 detected: inst=0x{x}, funct3=0b{b:0>3}\n", .{ inst, funct3 });
-                
-                // Try to decode as I-type instruction variants based on funct3.
-                if (funct3 == 0b000) {
-                    // ADDI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x06 with funct3=0b000 as ADDI\n", .{});
-                    try self.execute_addi(inst);
-                } else if (funct3 == 0b100) {
-                    // XORI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x06 with funct3=0b100 as XORI\n", .{});
-                    try self.execute_xori(inst);
-                } else if (funct3 == 0b110) {
-                    // ORI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x06 with funct3=0b110 as ORI\n", .{});
-                    try self.execute_ori(inst);
-                } else if (funct3 == 0b111) {
-                    // ANDI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x06 with funct3=0b111 as ANDI\n", .{});
-                    try self.execute_andi(inst);
-                } else {
-                    // Unknown opcode 0x06 variant - treat as NOP for now.
-                    std.debug.print("DEBUG vm.zig: Unknown opcode 0x06 variant (funct3=0b{b:0>3}), treating as NOP\n", .{funct3});
-                    // NOP: Do nothing, PC will advance normally.
-                }
-            },
-            0b1000101 => {
-                // Opcode 0x45: Zig compiler compatibility - decode as I-type instruction.
-                // Some Zig-compiled code generates instructions with opcode 0x45 that should be I-type.
-                const funct3 = @as(u3, @truncate(inst >> 12));
-                std.debug.print("DEBUG vm.zig: Opcode 0x45 detected: inst=0x{x}, funct3=0b{b:0>3}\n", .{ inst, funct3 });
-                
-                // Try to decode as I-type instruction variants based on funct3.
-                if (funct3 == 0b000) {
-                    // ADDI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x45 with funct3=0b000 as ADDI\n", .{});
-                    try self.execute_addi(inst);
-                } else if (funct3 == 0b100) {
-                    // XORI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x45 with funct3=0b100 as XORI\n", .{});
-                    try self.execute_xori(inst);
-                } else if (funct3 == 0b110) {
-                    // ORI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x45 with funct3=0b110 as ORI\n", .{});
-                    try self.execute_ori(inst);
-                } else if (funct3 == 0b111) {
-                    // ANDI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x45 with funct3=0b111 as ANDI\n", .{});
-                    try self.execute_andi(inst);
-                } else {
-                    // Unknown opcode 0x45 variant - treat as NOP for now.
-                    std.debug.print("DEBUG vm.zig: Unknown opcode 0x45 variant (funct3=0b{b:0>3}), treating as NOP\n", .{funct3});
-                    // NOP: Do nothing, PC will advance normally.
-                }
-            },
-            0b0100101 => {
-                // Opcode 0x25: Zig compiler compatibility - decode as I-type instruction.
-                // Some Zig-compiled code generates instructions with opcode 0x25 that should be I-type.
-                const funct3 = @as(u3, @truncate(inst >> 12));
-                std.debug.print("DEBUG vm.zig: Opcode 0x25 detected: inst=0x{x}, funct3=0b{b:0>3}\n", .{ inst, funct3 });
-                
-                // Try to decode as I-type instruction variants based on funct3.
-                if (funct3 == 0b000) {
-                    // ADDI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x25 with funct3=0b000 as ADDI\n", .{});
-                    try self.execute_addi(inst);
-                } else if (funct3 == 0b100) {
-                    // XORI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x25 with funct3=0b100 as XORI\n", .{});
-                    try self.execute_xori(inst);
-                } else if (funct3 == 0b110) {
-                    // ORI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x25 with funct3=0b110 as ORI\n", .{});
-                    try self.execute_ori(inst);
-                } else if (funct3 == 0b111) {
-                    // ANDI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x25 with funct3=0b111 as ANDI\n", .{});
-                    try self.execute_andi(inst);
-                } else {
-                    // Unknown opcode 0x25 variant - treat as NOP for now.
-                    std.debug.print("DEBUG vm.zig: Unknown opcode 0x25 variant (funct3=0b{b:0>3}), treating as NOP\n", .{funct3});
-                    // NOP: Do nothing, PC will advance normally.
-                }
-            },
-            0b0111101 => {
-                // Opcode 0x3D: Zig compiler compatibility - decode as I-type instruction.
-                // Some Zig-compiled code generates instructions with opcode 0x3D that should be I-type.
-                const funct3 = @as(u3, @truncate(inst >> 12));
-                std.debug.print("DEBUG vm.zig: Opcode 0x3D detected: inst=0x{x}, funct3=0b{b:0>3}\n", .{ inst, funct3 });
-                
-                // Try to decode as I-type instruction variants based on funct3.
-                if (funct3 == 0b000) {
-                    // ADDI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x3D with funct3=0b000 as ADDI\n", .{});
-                    try self.execute_addi(inst);
-                } else if (funct3 == 0b100) {
-                    // XORI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x3D with funct3=0b100 as XORI\n", .{});
-                    try self.execute_xori(inst);
-                } else if (funct3 == 0b110) {
-                    // ORI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x3D with funct3=0b110 as ORI\n", .{});
-                    try self.execute_ori(inst);
-                } else if (funct3 == 0b111) {
-                    // ANDI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x3D with funct3=0b111 as ANDI\n", .{});
-                    try self.execute_andi(inst);
-                } else {
-                    // Unknown opcode 0x3D variant - treat as NOP for now.
-                    std.debug.print("DEBUG vm.zig: Unknown opcode 0x3D variant (funct3=0b{b:0>3}), treating as NOP\n", .{funct3});
-                    // NOP: Do nothing, PC will advance normally.
-                }
-            },
-            0b1100000 => {
-                // Opcode 0x60: Zig compiler compatibility - decode as I-type instruction.
-                // Some Zig-compiled code generates instructions with opcode 0x60 that should be I-type.
-                const funct3 = @as(u3, @truncate(inst >> 12));
-                std.debug.print("DEBUG vm.zig: Opcode 0x60 detected: inst=0x{x}, funct3=0b{b:0>3}\n", .{ inst, funct3 });
-                
-                // Try to decode as I-type instruction variants based on funct3.
-                if (funct3 == 0b000) {
-                    // ADDI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x60 with funct3=0b000 as ADDI\n", .{});
-                    try self.execute_addi(inst);
-                } else if (funct3 == 0b100) {
-                    // XORI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x60 with funct3=0b100 as XORI\n", .{});
-                    try self.execute_xori(inst);
-                } else if (funct3 == 0b110) {
-                    // ORI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x60 with funct3=0b110 as ORI\n", .{});
-                    try self.execute_ori(inst);
-                } else if (funct3 == 0b111) {
-                    // ANDI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x60 with funct3=0b111 as ANDI\n", .{});
-                    try self.execute_andi(inst);
-                } else {
-                    // Unknown opcode 0x60 variant - treat as NOP for now.
-                    std.debug.print("DEBUG vm.zig: Unknown opcode 0x60 variant (funct3=0b{b:0>3}), treating as NOP\n", .{funct3});
-                    // NOP: Do nothing, PC will advance normally.
-                }
-            },
-            0b0101110 => {
-                // Opcode 0x2e: Zig compiler compatibility - decode as I-type instruction.
-                // Some Zig-compiled code generates instructions with opcode 0x2e that should be I-type.
-                const funct3 = @as(u3, @truncate(inst >> 12));
-                std.debug.print("DEBUG vm.zig: Opcode 0x2e detected: inst=0x{x}, funct3=0b{b:0>3}\n", .{ inst, funct3 });
-                
-                // Try to decode as I-type instruction variants based on funct3.
-                if (funct3 == 0b001) {
-                    // SLLI variant (Shift Left Logical Immediate)
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x2e with funct3=0b001 as SLLI\n", .{});
-                    try self.execute_slli(inst);
-                } else if (funct3 == 0b000) {
-                    // ADDI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x2e with funct3=0b000 as ADDI\n", .{});
-                    try self.execute_addi(inst);
-                } else if (funct3 == 0b100) {
-                    // XORI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x2e with funct3=0b100 as XORI\n", .{});
-                    try self.execute_xori(inst);
-                } else if (funct3 == 0b110) {
-                    // ORI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x2e with funct3=0b110 as ORI\n", .{});
-                    try self.execute_ori(inst);
-                } else if (funct3 == 0b111) {
-                    // ANDI variant
-                    std.debug.print("DEBUG vm.zig: Executing opcode 0x2e with funct3=0b111 as ANDI\n", .{});
-                    try self.execute_andi(inst);
-                } else {
-                    // Unknown opcode 0x2e variant - treat as NOP for now.
-                    std.debug.print("DEBUG vm.zig: Unknown opcode 0x2e variant (funct3=0b{b:0>3}), treating as NOP\n", .{funct3});
-                    // NOP: Do nothing, PC will advance normally.
-                }
-            },
-            else => {
-                // Check if this is a Zig-specific non-standard opcode that should be decoded as I-type.
-                // Pattern: Many Zig-compiled instructions use non-standard opcodes with various funct3 values.
-                const funct3 = @as(u3, @truncate(inst >> 12));
-                if (funct3 == 0b000) {
-                    // ADDI variant
-                    std.debug.print("DEBUG vm.zig: Non-standard opcode 0b{b:0>7} (0x{x}) with funct3=0b000, treating as ADDI\n", .{ opcode, opcode });
-                    try self.execute_addi(inst);
-                } else if (funct3 == 0b001) {
-                    // SLLI variant (Shift Left Logical Immediate)
-                    std.debug.print("DEBUG vm.zig: Non-standard opcode 0b{b:0>7} (0x{x}) with funct3=0b001, treating as SLLI\n", .{ opcode, opcode });
-                    try self.execute_slli(inst);
-                } else if (funct3 == 0b011) {
-                    // SLTIU variant (Set Less Than Immediate Unsigned) - treat as NOP for now
-                    std.debug.print("DEBUG vm.zig: Non-standard opcode 0b{b:0>7} (0x{x}) with funct3=0b011, treating as NOP\n", .{ opcode, opcode });
-                    // NOP: Do nothing, PC will advance normally.
-                } else if (funct3 == 0b100) {
-                    // XORI variant
-                    std.debug.print("DEBUG vm.zig: Non-standard opcode 0b{b:0>7} (0x{x}) with funct3=0b100, treating as XORI\n", .{ opcode, opcode });
-                    try self.execute_xori(inst);
-                } else if (funct3 == 0b110) {
-                    // ORI variant
-                    std.debug.print("DEBUG vm.zig: Non-standard opcode 0b{b:0>7} (0x{x}) with funct3=0b110, treating as ORI\n", .{ opcode, opcode });
-                    try self.execute_ori(inst);
-                } else if (funct3 == 0b111) {
-                    // ANDI variant
-                    std.debug.print("DEBUG vm.zig: Non-standard opcode 0b{b:0>7} (0x{x}) with funct3=0b111, treating as ANDI\n", .{ opcode, opcode });
-                    try self.execute_andi(inst);
-                } else {
-                    // Unsupported opcode - treat as NOP for now to allow execution to continue
-                    std.debug.print("DEBUG vm.zig: Unknown non-standard opcode 0b{b:0>7} (0x{x}) with funct3=0b{b:0>3}, treating as NOP\n", .{ opcode, opcode, funct3 });
-                    // NOP: Do nothing, PC will advance normally.
+        self.wait_requested = true;
+    }
+
+    /// WFI encoding (SYSTEM, funct12 = 0x105, all register fields zero).
+    const WFI_INST: u32 = 0x10500073;
+    /// SRET encoding (SYSTEM, funct12 = 0x102, all register fields zero).
+    const SRET_INST: u32 = 0x10200073;
+    /// SFENCE.VMA: funct7 = 0b0001001, rd = 0, funct3 = 0 (rs1/rs2 free).
+    const SFENCE_VMA_MASK: u32 = 0xFE007FFF;
+    const SFENCE_VMA_MATCH: u32 = 0x12000073;
+
+    /// Execute CSRRW/CSRRS/CSRRC (and immediate forms) on satp and the csr.zig set.
+    /// Why: Guest kernels switch address spaces through satp and take timer interrupts
+    /// through sstatus/sie/stvec/sepc/scause; `rdtime` reads the virtual clock.
+    /// Note: Writes of an unsupported satp MODE are ignored (WARL), as the spec allows.
+    /// Note: CSRRS/CSRRC with rs1 = x0 (or zimm = 0) read without writing; writing the
+    /// read-only time CSR or any unknown CSR is an illegal instruction.
+    fn execute_csr(self: *Self, d: *const Decoded) VMError!void {
+        const csr: u12 = @truncate(d.inst >> 20);
+        const old = if (csr == CSR_SATP) self.satp else (self.csrs.read(csr) orelse return self.execute_invalid(d));
+
+        const funct3: u3 = @truncate(d.inst >> 12);
+        const src: u64 = if (funct3 & 0b100 != 0) d.rs1 else self.regs.get(d.rs1);
+        const writes = (funct3 & 0b011) == 0b01 or d.rs1 != 0;
+        if (writes) {
+            const new = switch (funct3 & 0b011) {
+                0b01 => src,
+                0b10 => old | src,
+                else => old & ~src,
+            };
+            if (csr == CSR_SATP) {
+                if (vm_mmu.valid_satp(new)) {
+                    self.set_satp(new);
                 }
-            },
-        }
-        
-        // Advance PC to next instruction (4 bytes).
-        // Note: BEQ may have already updated PC for branch, so check if PC was modified.
-        // Branch instructions modify PC directly, so we don't increment again.
-        if (self.regs.pc == pc_before) {
-            // Normal case: PC unchanged by instruction, advance by 4 bytes.
-            self.regs.pc += 4;
+            } else if (self.csrs.write(csr, new)) {
+                // Enabling interrupts may make a pending timer due before the next instruction.
+                self.interrupt_at = self.csrs.interrupt_deadline();
+            } else {
+                return self.execute_invalid(d);
+            }
         }
-        // Else: PC was modified by branch instruction (BEQ), don't increment again.
-        
-        // Assert: PC must be 4-byte aligned after instruction execution.
-        std.debug.assert(self.regs.pc % 4 == 0);
-        
-        // Assert: PC must be within memory bounds after execution.
-        // Note: PC can be equal to memory_size (one past end) if instruction was at end.
-        std.debug.assert(self.regs.pc <= self.memory_size);
+        self.regs.set(d.rd, old);
     }
 
+    /// satp CSR number.
+    const CSR_SATP: u12 = 0x180;
+
     /// Execute LUI (Load Upper Immediate) instruction.
     /// Format: LUI rd, imm[31:12]
     /// Why: Separate function for clarity and Grain Style function length.
-    fn execute_lui(self: *Self, inst: u32) !void {
+    fn execute_lui(self: *Self, d: *const Decoded) VMError!void {
         // Decode: rd = bits [11:7], imm[31:12] = bits [31:12].
-        const rd = @as(u5, @truncate(inst >> 7));
-        const imm = @as(u32, inst) & 0xFFFFF000; // Extract bits [31:12].
+        const rd = d.rd;
         
-        // Sign-extend imm[31:12] to 64 bits.
-        const imm64 = @as(i32, @bitCast(imm)) << 12;
-        const imm64_unsigned = @as(u64, @intCast(imm64));
+        // Sign-extend imm[31:12] to 64 bits (shifted value pre-decoded).
+        const imm64 = @as(i32, @intCast(d.imm));
+        const imm64_unsigned: u64 = @bitCast(@as(i64, imm64));
         
         // Write result to rd.
         self.regs.set(rd, imm64_unsigned);
@@ -850,24 +1527,18 @@ pub const VM = struct {
     /// Format: AUIPC rd, imm[31:12]
     /// Why: PC-relative addressing for position-independent code.
     /// Grain Style: Comprehensive assertions for register indices and result validation.
-    fn execute_auipc(self: *Self, inst: u32) !void {
+    fn execute_auipc(self: *Self, d: *const Decoded) VMError!void {
         // Decode: rd = bits [11:7], imm[31:12] = bits [31:12].
-        const rd = @as(u5, @truncate(inst >> 7));
-        // Extract imm[31:12] as a 20-bit value, then sign-extend to 32 bits, then shift left by 12.
-        const imm_31_12_raw = @as(u20, @truncate(inst >> 12));
-        const imm_31_12 = @as(i32, @bitCast(@as(u32, imm_31_12_raw) << 12));
-        const imm64_unsigned: u64 = @bitCast(@as(i64, imm_31_12));
+        const rd = d.rd;
+        // imm[31:12] << 12, sign-extended to 64 bits (pre-decoded).
+        const imm64_unsigned: u64 = @bitCast(d.imm);
         
         // Get current PC (before instruction execution).
         const pc = self.regs.pc;
         
         // AUIPC: rd = PC + imm[31:12] << 12
         const result = pc +% imm64_unsigned;
-        
-        // Debug: Print AUIPC execution for troubleshooting.
-        if (rd == 1 or rd == 18) {
-            std.debug.print("DEBUG vm.zig: AUIPC x{}: PC=0x{x}, imm_31_12_raw=0x{x}, imm64_unsigned=0x{x}, result=0x{x}\n", .{ rd, pc, imm_31_12_raw, imm64_unsigned, result });
-        }
+
         
         // Write result to rd.
         self.regs.set(rd, result);
@@ -876,11 +1547,11 @@ pub const VM = struct {
     /// Execute ADDI (Add Immediate) instruction.
     /// Format: ADDI rd, rs1, imm[11:0]
     /// Why: Separate function for clarity and Grain Style function length.
-    fn execute_addi(self: *Self, inst: u32) !void {
+    fn execute_addi(self: *Self, d: *const Decoded) VMError!void {
         // Decode: rd = bits [11:7], rs1 = bits [19:15], imm[11:0] = bits [31:20].
-        const rd = @as(u5, @truncate(inst >> 7));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const imm12 = @as(i32, @truncate(@as(i64, inst >> 20)));
+        const rd = d.rd;
+        const rs1 = d.rs1;
+        const imm12 = @as(i32, @intCast(d.imm));
         
         // Sign-extend imm[11:0] to 64 bits.
         const imm64 = @as(i64, imm12);
@@ -889,7 +1560,7 @@ pub const VM = struct {
         const rs1_value = self.regs.get(rs1);
         
         // Add: rd = rs1 + imm (wrapping addition).
-        const result = @as(u64, @intCast(@as(i64, @bitCast(rs1_value)) + imm64));
+        const result = rs1_value +% @as(u64, @bitCast(imm64));
         
         // Write result to rd.
         self.regs.set(rd, result);
@@ -899,14 +1570,14 @@ pub const VM = struct {
     /// Format: ORI rd, rs1, imm[11:0]
     /// Why: Bitwise OR with immediate value for Zig compiler compatibility.
     /// Grain Style: Comprehensive assertions for register indices and result validation.
-    fn execute_ori(self: *Self, inst: u32) !void {
+    fn execute_ori(self: *Self, d: *const Decoded) VMError!void {
         // Decode: rd = bits [11:7], rs1 = bits [19:15], imm[11:0] = bits [31:20].
-        const rd = @as(u5, @truncate(inst >> 7));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const imm12 = @as(i32, @truncate(@as(i64, inst >> 20)));
+        const rd = d.rd;
+        const rs1 = d.rs1;
+        const imm12 = @as(i32, @intCast(d.imm));
         
         // Sign-extend imm[11:0] to 64 bits.
-        const imm64 = @as(u64, @intCast(@as(i64, imm12)));
+        const imm64: u64 = @bitCast(@as(i64, imm12));
         
         // Read rs1 value.
         const rs1_value = self.regs.get(rs1);
@@ -922,14 +1593,14 @@ pub const VM = struct {
     /// Format: ANDI rd, rs1, imm[11:0]
     /// Why: Bitwise AND with immediate value for Zig compiler compatibility.
     /// Grain Style: Comprehensive assertions for register indices and result validation.
-    fn execute_andi(self: *Self, inst: u32) !void {
+    fn execute_andi(self: *Self, d: *const Decoded) VMError!void {
         // Decode: rd = bits [11:7], rs1 = bits [19:15], imm[11:0] = bits [31:20].
-        const rd = @as(u5, @truncate(inst >> 7));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const imm12 = @as(i32, @truncate(@as(i64, inst >> 20)));
+        const rd = d.rd;
+        const rs1 = d.rs1;
+        const imm12 = @as(i32, @intCast(d.imm));
         
         // Sign-extend imm[11:0] to 64 bits.
-        const imm64 = @as(u64, @intCast(@as(i64, imm12)));
+        const imm64: u64 = @bitCast(@as(i64, imm12));
         
         // Read rs1 value.
         const rs1_value = self.regs.get(rs1);
@@ -945,14 +1616,14 @@ pub const VM = struct {
     /// Format: XORI rd, rs1, imm[11:0]
     /// Why: Bitwise XOR with immediate value for Zig compiler compatibility.
     /// Grain Style: Comprehensive assertions for register indices and result validation.
-    fn execute_xori(self: *Self, inst: u32) !void {
+    fn execute_xori(self: *Self, d: *const Decoded) VMError!void {
         // Decode: rd = bits [11:7], rs1 = bits [19:15], imm[11:0] = bits [31:20].
-        const rd = @as(u5, @truncate(inst >> 7));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const imm12 = @as(i32, @truncate(@as(i64, inst >> 20)));
+        const rd = d.rd;
+        const rs1 = d.rs1;
+        const imm12 = @as(i32, @intCast(d.imm));
         
         // Sign-extend imm[11:0] to 64 bits.
-        const imm64 = @as(u64, @intCast(@as(i64, imm12)));
+        const imm64: u64 = @bitCast(@as(i64, imm12));
         
         // Read rs1 value.
         const rs1_value = self.regs.get(rs1);
@@ -969,11 +1640,11 @@ pub const VM = struct {
     /// Encoding: funct7 | rs2 | rs1 | 000 | rd | 0110011
     /// Why: Register-register addition for kernel arithmetic operations.
     /// Grain Style: Comprehensive assertions for register indices and result validation.
-    fn execute_add(self: *Self, inst: u32) !void {
+    fn execute_add(self: *Self, d: *const Decoded) VMError!void {
         // Decode: rd = bits [11:7], rs1 = bits [19:15], rs2 = bits [24:20].
-        const rd = @as(u5, @truncate(inst >> 7));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const rs2 = @as(u5, @truncate(inst >> 20));
+        const rd = d.rd;
+        const rs1 = d.rs1;
+        const rs2 = d.rs2;
         
         // Assert: registers must be valid (0-31).
         std.debug.assert(rd < 32);
@@ -1002,11 +1673,11 @@ pub const VM = struct {
     /// Encoding: funct7 | rs2 | rs1 | 000 | rd | 0110011
     /// Why: Register-register subtraction for kernel arithmetic operations.
     /// Grain Style: Comprehensive assertions for register indices and result validation.
-    fn execute_sub(self: *Self, inst: u32) !void {
+    fn execute_sub(self: *Self, d: *const Decoded) VMError!void {
         // Decode: rd = bits [11:7], rs1 = bits [19:15], rs2 = bits [24:20].
-        const rd = @as(u5, @truncate(inst >> 7));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const rs2 = @as(u5, @truncate(inst >> 20));
+        const rd = d.rd;
+        const rs1 = d.rs1;
+        const rs2 = d.rs2;
         
         // Assert: registers must be valid (0-31).
         std.debug.assert(rd < 32);
@@ -1035,11 +1706,11 @@ pub const VM = struct {
     /// Encoding: funct7 | rs2 | rs1 | 010 | rd | 0110011
     /// Why: Signed comparison for kernel control flow and conditionals.
     /// Grain Style: Comprehensive assertions for register indices and comparison result.
-    fn execute_slt(self: *Self, inst: u32) !void {
+    fn execute_slt(self: *Self, d: *const Decoded) VMError!void {
         // Decode: rd = bits [11:7], rs1 = bits [19:15], rs2 = bits [24:20].
-        const rd = @as(u5, @truncate(inst >> 7));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const rs2 = @as(u5, @truncate(inst >> 20));
+        const rd = d.rd;
+        const rs1 = d.rs1;
+        const rs2 = d.rs2;
         
         // Assert: registers must be valid (0-31).
         std.debug.assert(rd < 32);
@@ -1073,11 +1744,11 @@ pub const VM = struct {
     /// Encoding: funct7 | rs2 | rs1 | 110 | rd | 0110011
     /// Why: Bitwise OR for kernel bit manipulation operations.
     /// Grain Style: Comprehensive assertions for register indices and result validation.
-    fn execute_or(self: *Self, inst: u32) !void {
+    fn execute_or(self: *Self, d: *const Decoded) VMError!void {
         // Decode: rd = bits [11:7], rs1 = bits [19:15], rs2 = bits [24:20].
-        const rd = @as(u5, @truncate(inst >> 7));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const rs2 = @as(u5, @truncate(inst >> 20));
+        const rd = d.rd;
+        const rs1 = d.rs1;
+        const rs2 = d.rs2;
         
         // Assert: registers must be valid (0-31).
         std.debug.assert(rd < 32);
@@ -1106,11 +1777,11 @@ pub const VM = struct {
     /// Encoding: funct7 | rs2 | rs1 | 111 | rd | 0110011
     /// Why: Bitwise AND for kernel bit manipulation operations.
     /// Grain Style: Comprehensive assertions for register indices and result validation.
-    fn execute_and(self: *Self, inst: u32) !void {
+    fn execute_and(self: *Self, d: *const Decoded) VMError!void {
         // Decode: rd = bits [11:7], rs1 = bits [19:15], rs2 = bits [24:20].
-        const rd = @as(u5, @truncate(inst >> 7));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const rs2 = @as(u5, @truncate(inst >> 20));
+        const rd = d.rd;
+        const rs1 = d.rs1;
+        const rs2 = d.rs2;
         
         // Assert: registers must be valid (0-31).
         std.debug.assert(rd < 32);
@@ -1139,11 +1810,11 @@ pub const VM = struct {
     /// Encoding: funct7 | rs2 | rs1 | 100 | rd | 0110011
     /// Why: Bitwise XOR for kernel bit manipulation operations.
     /// Grain Style: Comprehensive assertions for register indices and result validation.
-    fn execute_xor(self: *Self, inst: u32) !void {
+    fn execute_xor(self: *Self, d: *const Decoded) VMError!void {
         // Decode: rd = bits [11:7], rs1 = bits [19:15], rs2 = bits [24:20].
-        const rd = @as(u5, @truncate(inst >> 7));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const rs2 = @as(u5, @truncate(inst >> 20));
+        const rd = d.rd;
+        const rs1 = d.rs1;
+        const rs2 = d.rs2;
         
         // Assert: registers must be valid (0-31).
         std.debug.assert(rd < 32);
@@ -1172,11 +1843,11 @@ pub const VM = struct {
     /// Encoding: funct7 | rs2 | rs1 | 001 | rd | 0110011
     /// Why: Logical left shift for kernel bit manipulation operations.
     /// Grain Style: Comprehensive assertions for register indices and result validation.
-    fn execute_sll(self: *Self, inst: u32) !void {
+    fn execute_sll(self: *Self, d: *const Decoded) VMError!void {
         // Decode: rd = bits [11:7], rs1 = bits [19:15], rs2 = bits [24:20].
-        const rd = @as(u5, @truncate(inst >> 7));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const rs2 = @as(u5, @truncate(inst >> 20));
+        const rd = d.rd;
+        const rs1 = d.rs1;
+        const rs2 = d.rs2;
         
         // Assert: registers must be valid (0-31).
         std.debug.assert(rd < 32);
@@ -1191,11 +1862,7 @@ pub const VM = struct {
         // Why: RISC-V shift amount is masked to 6 bits (0-63) for 64-bit values.
         const shift_amount = @as(u6, @truncate(rs2_value & 0x3F));
         const result = rs1_value << shift_amount;
-        
-        // Debug: Print SLL execution for troubleshooting.
-        if (rd == 8) {
-            std.debug.print("DEBUG vm.zig: SLL x8: rs1=x{} (0x{x}), rs2=x{} (0x{x}), shift_amount={}, result=0x{x}\n", .{ rs1, rs1_value, rs2, rs2_value, shift_amount, result });
-        }
+
         
         // Write result to rd.
         self.regs.set(rd, result);
@@ -1203,9 +1870,6 @@ pub const VM = struct {
         // Assert: result must be written correctly (unless x0).
         if (rd != 0) {
             std.debug.assert(self.regs.get(rd) == result);
-            if (rd == 8) {
-                std.debug.print("DEBUG vm.zig: SLL x8: Verified x8 = 0x{x}\n", .{self.regs.get(8)});
-            }
         }
     }
 
@@ -1214,11 +1878,11 @@ pub const VM = struct {
     /// Encoding: funct7 | rs2 | rs1 | 101 | rd | 0110011
     /// Why: Logical right shift for kernel bit manipulation operations.
     /// Grain Style: Comprehensive assertions for register indices and result validation.
-    fn execute_srl(self: *Self, inst: u32) !void {
+    fn execute_srl(self: *Self, d: *const Decoded) VMError!void {
         // Decode: rd = bits [11:7], rs1 = bits [19:15], rs2 = bits [24:20].
-        const rd = @as(u5, @truncate(inst >> 7));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const rs2 = @as(u5, @truncate(inst >> 20));
+        const rd = d.rd;
+        const rs1 = d.rs1;
+        const rs2 = d.rs2;
         
         // Assert: registers must be valid (0-31).
         std.debug.assert(rd < 32);
@@ -1249,11 +1913,11 @@ pub const VM = struct {
     /// Encoding: imm[5:0] | rs1 | 001 | rd | 0010011
     /// Why: Logical left shift by immediate for kernel bit manipulation operations.
     /// Grain Style: Comprehensive assertions for register indices and result validation.
-    fn execute_slli(self: *Self, inst: u32) !void {
+    fn execute_slli(self: *Self, d: *const Decoded) VMError!void {
         // Decode: rd = bits [11:7], rs1 = bits [19:15], imm[5:0] = bits [24:20].
-        const rd = @as(u5, @truncate(inst >> 7));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const imm_raw = @as(u6, @truncate(inst >> 20)); // imm[5:0]
+        const rd = d.rd;
+        const rs1 = d.rs1;
+        const imm_raw = @as(u6, @intCast(d.imm)); // imm[5:0]
         
         // Assert: registers must be valid (0-31).
         std.debug.assert(rd < 32);
@@ -1281,11 +1945,11 @@ pub const VM = struct {
     /// Encoding: funct7(0x20) | rs2 | rs1 | 101 | rd | 0110011
     /// Why: Arithmetic right shift for kernel bit manipulation operations (sign-extended).
     /// Grain Style: Comprehensive assertions for register indices and result validation.
-    fn execute_sra(self: *Self, inst: u32) !void {
+    fn execute_sra(self: *Self, d: *const Decoded) VMError!void {
         // Decode: rd = bits [11:7], rs1 = bits [19:15], rs2 = bits [24:20].
-        const rd = @as(u5, @truncate(inst >> 7));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const rs2 = @as(u5, @truncate(inst >> 20));
+        const rd = d.rd;
+        const rs1 = d.rs1;
+        const rs2 = d.rs2;
         
         // Assert: registers must be valid (0-31).
         std.debug.assert(rd < 32);
@@ -1317,11 +1981,11 @@ pub const VM = struct {
     /// Format: LW rd, offset(rs1)
     /// Encoding: imm[11:0] | rs1 | 010 | rd | 0000011
     /// Why: Load 32-bit word from memory for kernel data access.
-    fn execute_lw(self: *Self, inst: u32) !void {
+    fn execute_lw(self: *Self, d: *const Decoded) VMError!void {
         // Decode: rd = bits [11:7], rs1 = bits [19:15], imm[11:0] = bits [31:20].
-        const rd = @as(u5, @truncate(inst >> 7));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const imm12 = @as(i32, @truncate(@as(i64, inst >> 20)));
+        const rd = d.rd;
+        const rs1 = d.rs1;
+        const imm12 = @as(i32, @intCast(d.imm));
         
         // Assert: registers must be valid (0-31).
         std.debug.assert(rd < 32);
@@ -1342,7 +2006,7 @@ pub const VM = struct {
             if (eff_addr + 4 > self.memory_size) {
                 const sp = self.regs.get(2);
                 if (sp != 0x0 and sp < self.memory_size) {
-                    std.debug.print("DEBUG vm.zig: LW: x8=0x0 gives out-of-bounds addr 0x{x}, trying sp (x2=0x{x})\n", .{ eff_addr, sp });
+                    self.trace_access(.stack_fallback, d, eff_addr, sp);
                     base_addr = sp;
                     eff_addr = base_addr +% offset;
                 }
@@ -1351,20 +2015,26 @@ pub const VM = struct {
             eff_addr = base_addr +% offset;
         }
         
-        // Debug: Print address calculation for troubleshooting.
-        std.debug.print("DEBUG vm.zig: LW instruction: rs1={} (x{}), base_addr=0x{x}, imm12={} (0x{x}), offset=0x{x}, eff_addr=0x{x}, memory_size=0x{x}\n", .{ rs1, rs1, base_addr, imm12, imm12, offset, eff_addr, self.memory_size });
-        
         // Assert: effective address must be 4-byte aligned for word load.
         if (eff_addr % 4 != 0) {
-            std.debug.print("DEBUG vm.zig: LW unaligned address: 0x{x} (not 4-byte aligned)\n", .{eff_addr});
+            self.trace_access(.fault, d, eff_addr, 4);
             self.state = .errored;
             self.last_error = VMError.unaligned_memory_access;
             return VMError.unaligned_memory_access;
         }
         
+        // Virtual to physical (identity while satp is Bare).
+        eff_addr = try self.translate(eff_addr, .load);
+        
         // Assert: effective address must be within memory bounds.
         if (eff_addr + 4 > self.memory_size) {
-            std.debug.print("DEBUG vm.zig: LW out of bounds: eff_addr=0x{x}, eff_addr+4=0x{x}, memory_size=0x{x}\n", .{ eff_addr, eff_addr + 4, self.memory_size });
+            if (self.mmio_load(eff_addr, 4)) |word| {
+                self.trace_access(.load, d, eff_addr, 0);
+                const device_word: i32 = @bitCast(@as(u32, @truncate(word)));
+                self.regs.set(rd, @bitCast(@as(i64, device_word)));
+                return;
+            }
+            self.trace_access(.fault, d, eff_addr, 4);
             self.state = .errored;
             self.last_error = VMError.invalid_memory_access;
             return VMError.invalid_memory_access;
@@ -1374,10 +2044,11 @@ pub const VM = struct {
         // Assert: memory access must be within bounds (already checked above).
         std.debug.assert(eff_addr + 4 <= self.memory_size);
         
+        self.trace_access(.load, d, eff_addr, 0);
         const mem_slice = self.memory[@as(usize, @intCast(eff_addr))..][0..4];
         const word = std.mem.readInt(u32, mem_slice, .little);
         const word_signed = @as(i32, @bitCast(word));
-        const word64 = @as(u64, @intCast(word_signed));
+        const word64: u64 = @bitCast(@as(i64, word_signed));
         
         // Write to destination register.
         self.regs.set(rd, word64);
@@ -1387,20 +2058,17 @@ pub const VM = struct {
     /// Format: SW rs2, offset(rs1)
     /// Encoding: imm[11:5] | rs2 | rs1 | 010 | imm[4:0] | 0100011
     /// Why: Store 32-bit word to memory for kernel data writes.
-    fn execute_sw(self: *Self, inst: u32) !void {
+    fn execute_sw(self: *Self, d: *const Decoded) VMError!void {
         // Decode S-type: rs2 = bits [24:20], rs1 = bits [19:15], imm[11:5] = bits [31:25], imm[4:0] = bits [11:7].
-        const rs2 = @as(u5, @truncate(inst >> 20));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const imm_11_5 = @as(u7, @truncate(inst >> 25));
-        const imm_4_0 = @as(u5, @truncate(inst >> 7));
+        const rs2 = d.rs2;
+        const rs1 = d.rs1;
         
         // Assert: registers must be valid (0-31).
         std.debug.assert(rs2 < 32);
         std.debug.assert(rs1 < 32);
         
-        // Reconstruct 12-bit immediate: imm[11:5] | imm[4:0].
-        const imm12_raw = (@as(u12, imm_11_5) << 5) | imm_4_0;
-        const imm12 = @as(i32, @truncate(@as(i64, @as(i12, @bitCast(imm12_raw)))));
+        // Immediate pre-decoded from imm[11:5] | imm[4:0] (sign-extended).
+        const imm12 = @as(i32, @intCast(d.imm));
         
         // Read base address from rs1.
         const base_addr = self.regs.get(rs1);
@@ -1410,7 +2078,7 @@ pub const VM = struct {
         const offset: u64 = @bitCast(imm64);
         
         // Calculate effective address: base_addr + offset.
-        const eff_addr = base_addr +% offset;
+        var eff_addr = base_addr +% offset;
         
         // Assert: effective address must be 4-byte aligned for word store.
         if (eff_addr % 4 != 0) {
@@ -1419,8 +2087,15 @@ pub const VM = struct {
             return VMError.unaligned_memory_access;
         }
         
+        // Virtual to physical (identity while satp is Bare).
+        eff_addr = try self.translate(eff_addr, .store);
+        
         // Assert: effective address must be within memory bounds.
         if (eff_addr + 4 > self.memory_size) {
+            if (self.mmio_store(eff_addr, 4, self.regs.get(rs2))) {
+                self.trace_access(.store, d, eff_addr, 0);
+                return;
+            }
             self.state = .errored;
             self.last_error = VMError.invalid_memory_access;
             return VMError.invalid_memory_access;
@@ -1438,7 +2113,9 @@ pub const VM = struct {
         const word = @as(u32, @truncate(rs2_value));
         
         // Write 32-bit word to memory.
+        self.trace_access(.store, d, eff_addr, 0);
         @memcpy(self.memory[@as(usize, @intCast(eff_addr))..][0..4], &std.mem.toBytes(word));
+        self.note_store(eff_addr);
     }
 
     /// Execute LB (Load Byte) instruction.
@@ -1446,10 +2123,10 @@ pub const VM = struct {
     /// Encoding: imm[11:0] | rs1 | 000 | rd | 0000011
     /// Contract: Loads 8-bit byte, sign-extends to 64 bits
     /// Why: Load byte from memory for kernel data access.
-    fn execute_lb(self: *Self, inst: u32) !void {
-        const rd = @as(u5, @truncate(inst >> 7));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const imm12 = @as(i32, @truncate(@as(i64, inst >> 20)));
+    fn execute_lb(self: *Self, d: *const Decoded) VMError!void {
+        const rd = d.rd;
+        const rs1 = d.rs1;
+        const imm12 = @as(i32, @intCast(d.imm));
         
         std.debug.assert(rd < 32);
         std.debug.assert(rs1 < 32);
@@ -1457,7 +2134,10 @@ pub const VM = struct {
         const base_addr = self.regs.get(rs1);
         const imm64 = @as(i64, imm12);
         const offset: u64 = @bitCast(imm64); // Use @bitCast to handle negative immediates correctly
-        const eff_addr = base_addr +% offset;
+        var eff_addr = base_addr +% offset;
+        
+        // Virtual to physical (identity while satp is Bare).
+        eff_addr = try self.translate(eff_addr, .load);
         
         if (eff_addr >= self.memory_size) {
             self.state = .errored;
@@ -1465,9 +2145,10 @@ pub const VM = struct {
             return VMError.invalid_memory_access;
         }
         
+        self.trace_access(.load, d, eff_addr, 0);
         const byte = self.memory[@as(usize, @intCast(eff_addr))];
         const byte_signed = @as(i8, @bitCast(byte));
-        const byte64 = @as(u64, @intCast(byte_signed));
+        const byte64: u64 = @bitCast(@as(i64, byte_signed));
         
         self.regs.set(rd, byte64);
     }
@@ -1477,10 +2158,10 @@ pub const VM = struct {
     /// Encoding: imm[11:0] | rs1 | 001 | rd | 0000011
     /// Contract: Loads 16-bit halfword, sign-extends to 64 bits, must be 2-byte aligned
     /// Why: Load halfword from memory for kernel data access.
-    fn execute_lh(self: *Self, inst: u32) !void {
-        const rd = @as(u5, @truncate(inst >> 7));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const imm12 = @as(i32, @truncate(@as(i64, inst >> 20)));
+    fn execute_lh(self: *Self, d: *const Decoded) VMError!void {
+        const rd = d.rd;
+        const rs1 = d.rs1;
+        const imm12 = @as(i32, @intCast(d.imm));
         
         std.debug.assert(rd < 32);
         std.debug.assert(rs1 < 32);
@@ -1488,7 +2169,7 @@ pub const VM = struct {
         const base_addr = self.regs.get(rs1);
         const imm64 = @as(i64, imm12);
         const offset: u64 = @bitCast(imm64); // Use @bitCast to handle negative immediates correctly
-        const eff_addr = base_addr +% offset;
+        var eff_addr = base_addr +% offset;
         
         if (eff_addr % 2 != 0) {
             self.state = .errored;
@@ -1496,16 +2177,20 @@ pub const VM = struct {
             return VMError.unaligned_memory_access;
         }
         
+        // Virtual to physical (identity while satp is Bare).
+        eff_addr = try self.translate(eff_addr, .load);
+        
         if (eff_addr + 2 > self.memory_size) {
             self.state = .errored;
             self.last_error = VMError.invalid_memory_access;
             return VMError.invalid_memory_access;
         }
         
+        self.trace_access(.load, d, eff_addr, 0);
         const mem_slice = self.memory[@as(usize, @intCast(eff_addr))..][0..2];
         const halfword = std.mem.readInt(u16, mem_slice, .little);
         const halfword_signed = @as(i16, @bitCast(halfword));
-        const halfword64 = @as(u64, @intCast(halfword_signed));
+        const halfword64: u64 = @bitCast(@as(i64, halfword_signed));
         
         self.regs.set(rd, halfword64);
     }
@@ -1515,10 +2200,10 @@ pub const VM = struct {
     /// Encoding: imm[11:0] | rs1 | 011 | rd | 0000011
     /// Contract: Loads 64-bit doubleword, must be 8-byte aligned
     /// Why: Load doubleword from memory for kernel data access.
-    fn execute_ld(self: *Self, inst: u32) !void {
-        const rd = @as(u5, @truncate(inst >> 7));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const imm12 = @as(i32, @truncate(@as(i64, inst >> 20)));
+    fn execute_ld(self: *Self, d: *const Decoded) VMError!void {
+        const rd = d.rd;
+        const rs1 = d.rs1;
+        const imm12 = @as(i32, @intCast(d.imm));
         
         std.debug.assert(rd < 32);
         std.debug.assert(rs1 < 32);
@@ -1535,7 +2220,7 @@ pub const VM = struct {
             if (eff_addr + 8 > self.memory_size) {
                 const sp = self.regs.get(2);
                 if (sp != 0x0 and sp < self.memory_size) {
-                    std.debug.print("DEBUG vm.zig: LD: x8=0x0 gives out-of-bounds addr 0x{x}, trying sp (x2=0x{x})\n", .{ eff_addr, sp });
+                    self.trace_access(.stack_fallback, d, eff_addr, sp);
                     base_addr = sp;
                     eff_addr = base_addr +% offset;
                 }
@@ -1544,24 +2229,29 @@ pub const VM = struct {
             eff_addr = base_addr +% offset;
         }
         
-        // Debug: Print address calculation for troubleshooting.
-        std.debug.print("DEBUG vm.zig: LD instruction: rs1={} (x{}), base_addr=0x{x}, imm12={} (0x{x}), offset=0x{x}, eff_addr=0x{x}, memory_size=0x{x}\n", .{ rs1, rs1, base_addr, imm12, imm12, offset, eff_addr, self.memory_size });
-        
         // Align address to 8-byte boundary for doubleword load (clear bottom 3 bits).
         // Why: RISC-V requires 8-byte alignment for LD/SD, but programs may calculate misaligned addresses.
         // Note: This changes semantics slightly but allows execution to continue.
         if (eff_addr % 8 != 0) {
-            std.debug.print("DEBUG vm.zig: LD unaligned address: 0x{x} (not 8-byte aligned), aligning to 0x{x}\n", .{ eff_addr, eff_addr & ~@as(u64, 7) });
             eff_addr = eff_addr & ~@as(u64, 7);
         }
         
+        // Virtual to physical (identity while satp is Bare).
+        eff_addr = try self.translate(eff_addr, .load);
+        
         if (eff_addr + 8 > self.memory_size) {
-            std.debug.print("DEBUG vm.zig: LD out of bounds: eff_addr=0x{x}, eff_addr+8=0x{x}, memory_size=0x{x}\n", .{ eff_addr, eff_addr + 8, self.memory_size });
+            if (self.mmio_load(eff_addr, 8)) |doubleword| {
+                self.trace_access(.load, d, eff_addr, 0);
+                self.regs.set(rd, doubleword);
+                return;
+            }
+            self.trace_access(.fault, d, eff_addr, 8);
             self.state = .errored;
             self.last_error = VMError.invalid_memory_access;
             return VMError.invalid_memory_access;
         }
         
+        self.trace_access(.load, d, eff_addr, 0);
         const mem_slice = self.memory[@as(usize, @intCast(eff_addr))..][0..8];
         const doubleword = std.mem.readInt(u64, mem_slice, .little);
         
@@ -1573,10 +2263,10 @@ pub const VM = struct {
     /// Encoding: imm[11:0] | rs1 | 100 | rd | 0000011
     /// Contract: Loads 8-bit byte, zero-extends to 64 bits
     /// Why: Load unsigned byte from memory for kernel data access.
-    fn execute_lbu(self: *Self, inst: u32) !void {
-        const rd = @as(u5, @truncate(inst >> 7));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const imm12 = @as(i32, @truncate(@as(i64, inst >> 20)));
+    fn execute_lbu(self: *Self, d: *const Decoded) VMError!void {
+        const rd = d.rd;
+        const rs1 = d.rs1;
+        const imm12 = @as(i32, @intCast(d.imm));
         
         std.debug.assert(rd < 32);
         std.debug.assert(rs1 < 32);
@@ -1584,7 +2274,10 @@ pub const VM = struct {
         const base_addr = self.regs.get(rs1);
         const imm64 = @as(i64, imm12);
         const offset: u64 = @bitCast(imm64); // Use @bitCast to handle negative immediates correctly
-        const eff_addr = base_addr +% offset;
+        var eff_addr = base_addr +% offset;
+        
+        // Virtual to physical (identity while satp is Bare).
+        eff_addr = try self.translate(eff_addr, .load);
         
         if (eff_addr >= self.memory_size) {
             self.state = .errored;
@@ -1592,6 +2285,7 @@ pub const VM = struct {
             return VMError.invalid_memory_access;
         }
         
+        self.trace_access(.load, d, eff_addr, 0);
         const byte = self.memory[@as(usize, @intCast(eff_addr))];
         const byte64: u64 = byte;
         
@@ -1603,10 +2297,10 @@ pub const VM = struct {
     /// Encoding: imm[11:0] | rs1 | 101 | rd | 0000011
     /// Contract: Loads 16-bit halfword, zero-extends to 64 bits, must be 2-byte aligned
     /// Why: Load unsigned halfword from memory for kernel data access.
-    fn execute_lhu(self: *Self, inst: u32) !void {
-        const rd = @as(u5, @truncate(inst >> 7));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const imm12 = @as(i32, @truncate(@as(i64, inst >> 20)));
+    fn execute_lhu(self: *Self, d: *const Decoded) VMError!void {
+        const rd = d.rd;
+        const rs1 = d.rs1;
+        const imm12 = @as(i32, @intCast(d.imm));
         
         std.debug.assert(rd < 32);
         std.debug.assert(rs1 < 32);
@@ -1614,7 +2308,7 @@ pub const VM = struct {
         const base_addr = self.regs.get(rs1);
         const imm64 = @as(i64, imm12);
         const offset: u64 = @bitCast(imm64); // Use @bitCast to handle negative immediates correctly
-        const eff_addr = base_addr +% offset;
+        var eff_addr = base_addr +% offset;
         
         if (eff_addr % 2 != 0) {
             self.state = .errored;
@@ -1622,12 +2316,16 @@ pub const VM = struct {
             return VMError.unaligned_memory_access;
         }
         
+        // Virtual to physical (identity while satp is Bare).
+        eff_addr = try self.translate(eff_addr, .load);
+        
         if (eff_addr + 2 > self.memory_size) {
             self.state = .errored;
             self.last_error = VMError.invalid_memory_access;
             return VMError.invalid_memory_access;
         }
         
+        self.trace_access(.load, d, eff_addr, 0);
         const mem_slice = self.memory[@as(usize, @intCast(eff_addr))..][0..2];
         const halfword = std.mem.readInt(u16, mem_slice, .little);
         const halfword64: u64 = halfword;
@@ -1640,10 +2338,10 @@ pub const VM = struct {
     /// Encoding: imm[11:0] | rs1 | 110 | rd | 0000011
     /// Contract: Loads 32-bit word, zero-extends to 64 bits, must be 4-byte aligned
     /// Why: Load unsigned word from memory for kernel data access.
-    fn execute_lwu(self: *Self, inst: u32) !void {
-        const rd = @as(u5, @truncate(inst >> 7));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const imm12 = @as(i32, @truncate(@as(i64, inst >> 20)));
+    fn execute_lwu(self: *Self, d: *const Decoded) VMError!void {
+        const rd = d.rd;
+        const rs1 = d.rs1;
+        const imm12 = @as(i32, @intCast(d.imm));
         
         std.debug.assert(rd < 32);
         std.debug.assert(rs1 < 32);
@@ -1651,7 +2349,7 @@ pub const VM = struct {
         const base_addr = self.regs.get(rs1);
         const imm64 = @as(i64, imm12);
         const offset: u64 = @bitCast(imm64); // Use @bitCast to handle negative immediates correctly
-        const eff_addr = base_addr +% offset;
+        var eff_addr = base_addr +% offset;
         
         if (eff_addr % 4 != 0) {
             self.state = .errored;
@@ -1659,12 +2357,21 @@ pub const VM = struct {
             return VMError.unaligned_memory_access;
         }
         
+        // Virtual to physical (identity while satp is Bare).
+        eff_addr = try self.translate(eff_addr, .load);
+        
         if (eff_addr + 4 > self.memory_size) {
+            if (self.mmio_load(eff_addr, 4)) |word| {
+                self.trace_access(.load, d, eff_addr, 0);
+                self.regs.set(rd, word);
+                return;
+            }
             self.state = .errored;
             self.last_error = VMError.invalid_memory_access;
             return VMError.invalid_memory_access;
         }
         
+        self.trace_access(.load, d, eff_addr, 0);
         const mem_slice = self.memory[@as(usize, @intCast(eff_addr))..][0..4];
         const word = std.mem.readInt(u32, mem_slice, .little);
         const word64: u64 = word;
@@ -1677,17 +2384,14 @@ pub const VM = struct {
     /// Encoding: imm[11:5] | rs2 | rs1 | 000 | imm[4:0] | 0100011
     /// Contract: Stores low 8 bits of rs2 to memory
     /// Why: Store byte to memory for kernel data writes.
-    fn execute_sb(self: *Self, inst: u32) !void {
-        const rs2 = @as(u5, @truncate(inst >> 20));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const imm_11_5 = @as(u7, @truncate(inst >> 25));
-        const imm_4_0 = @as(u5, @truncate(inst >> 7));
+    fn execute_sb(self: *Self, d: *const Decoded) VMError!void {
+        const rs2 = d.rs2;
+        const rs1 = d.rs1;
         
         std.debug.assert(rs2 < 32);
         std.debug.assert(rs1 < 32);
         
-        const imm12_raw = (@as(u12, imm_11_5) << 5) | imm_4_0;
-        const imm12 = @as(i32, @truncate(@as(i64, @as(i12, @bitCast(imm12_raw)))));
+        const imm12 = @as(i32, @intCast(d.imm));
         
         var base_addr = self.regs.get(rs1);
         const imm64 = @as(i64, imm12);
@@ -1701,13 +2405,16 @@ pub const VM = struct {
             if (eff_addr >= self.memory_size) {
                 const sp = self.regs.get(2);
                 if (sp != 0x0 and sp < self.memory_size) {
-                    std.debug.print("DEBUG vm.zig: SB: x8=0x0 gives out-of-bounds addr 0x{x}, trying sp (x2=0x{x})\n", .{ eff_addr, sp });
+                    self.trace_access(.stack_fallback, d, eff_addr, sp);
                     base_addr = sp;
                     eff_addr = base_addr +% offset;
                 }
             }
         }
         
+        // Virtual to physical (identity while satp is Bare).
+        eff_addr = try self.translate(eff_addr, .store);
+        
         if (eff_addr >= self.memory_size) {
             self.state = .errored;
             self.last_error = VMError.invalid_memory_access;
@@ -1717,7 +2424,9 @@ pub const VM = struct {
         const rs2_value = self.regs.get(rs2);
         const byte = @as(u8, @truncate(rs2_value));
         
+        self.trace_access(.store, d, eff_addr, 0);
         self.memory[@as(usize, @intCast(eff_addr))] = byte;
+        self.note_store(eff_addr);
     }
 
     /// Execute SH (Store Halfword) instruction.
@@ -1725,22 +2434,19 @@ pub const VM = struct {
     /// Encoding: imm[11:5] | rs2 | rs1 | 001 | imm[4:0] | 0100011
     /// Contract: Stores low 16 bits of rs2 to memory, must be 2-byte aligned
     /// Why: Store halfword to memory for kernel data writes.
-    fn execute_sh(self: *Self, inst: u32) !void {
-        const rs2 = @as(u5, @truncate(inst >> 20));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const imm_11_5 = @as(u7, @truncate(inst >> 25));
-        const imm_4_0 = @as(u5, @truncate(inst >> 7));
+    fn execute_sh(self: *Self, d: *const Decoded) VMError!void {
+        const rs2 = d.rs2;
+        const rs1 = d.rs1;
         
         std.debug.assert(rs2 < 32);
         std.debug.assert(rs1 < 32);
         
-        const imm12_raw = (@as(u12, imm_11_5) << 5) | imm_4_0;
-        const imm12 = @as(i32, @truncate(@as(i64, @as(i12, @bitCast(imm12_raw)))));
+        const imm12 = @as(i32, @intCast(d.imm));
         
         const base_addr = self.regs.get(rs1);
         const imm64 = @as(i64, imm12);
         const offset: u64 = @bitCast(imm64); // Use @bitCast to handle negative immediates correctly
-        const eff_addr = base_addr +% offset;
+        var eff_addr = base_addr +% offset;
         
         if (eff_addr % 2 != 0) {
             self.state = .errored;
@@ -1748,6 +2454,9 @@ pub const VM = struct {
             return VMError.unaligned_memory_access;
         }
         
+        // Virtual to physical (identity while satp is Bare).
+        eff_addr = try self.translate(eff_addr, .store);
+        
         if (eff_addr + 2 > self.memory_size) {
             self.state = .errored;
             self.last_error = VMError.invalid_memory_access;
@@ -1757,7 +2466,9 @@ pub const VM = struct {
         const rs2_value = self.regs.get(rs2);
         const halfword = @as(u16, @truncate(rs2_value));
         
+        self.trace_access(.store, d, eff_addr, 0);
         @memcpy(self.memory[@as(usize, @intCast(eff_addr))..][0..2], &std.mem.toBytes(halfword));
+        self.note_store(eff_addr);
     }
 
     /// Execute SD (Store Doubleword) instruction.
@@ -1765,17 +2476,14 @@ pub const VM = struct {
     /// Encoding: imm[11:5] | rs2 | rs1 | 011 | imm[4:0] | 0100011
     /// Contract: Stores 64-bit value from rs2 to memory, must be 8-byte aligned
     /// Why: Store doubleword to memory for kernel data writes.
-    fn execute_sd(self: *Self, inst: u32) !void {
-        const rs2 = @as(u5, @truncate(inst >> 20));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const imm_11_5 = @as(u7, @truncate(inst >> 25));
-        const imm_4_0 = @as(u5, @truncate(inst >> 7));
+    fn execute_sd(self: *Self, d: *const Decoded) VMError!void {
+        const rs2 = d.rs2;
+        const rs1 = d.rs1;
         
         std.debug.assert(rs2 < 32);
         std.debug.assert(rs1 < 32);
         
-        const imm12_raw = (@as(u12, imm_11_5) << 5) | imm_4_0;
-        const imm12 = @as(i32, @truncate(@as(i64, @as(i12, @bitCast(imm12_raw)))));
+        const imm12 = @as(i32, @intCast(d.imm));
         
         var base_addr = self.regs.get(rs1);
         const imm64 = @as(i64, imm12);
@@ -1790,7 +2498,7 @@ pub const VM = struct {
             if (eff_addr + 8 > self.memory_size) {
                 const sp = self.regs.get(2);
                 if (sp != 0x0 and sp < self.memory_size) {
-                    std.debug.print("DEBUG vm.zig: SD: x8=0x0 gives out-of-bounds addr 0x{x}, trying sp (x2=0x{x})\n", .{ eff_addr, sp });
+                    self.trace_access(.stack_fallback, d, eff_addr, sp);
                     base_addr = sp;
                     eff_addr = base_addr +% offset;
                 }
@@ -1799,19 +2507,11 @@ pub const VM = struct {
             eff_addr = base_addr +% offset;
         }
         
-        // Debug: Print address calculation for troubleshooting.
-        std.debug.print("DEBUG vm.zig: SD instruction: rs1={} (x{}), base_addr=0x{x}, imm12={} (0x{x}), offset=0x{x}, eff_addr=0x{x}, memory_size=0x{x}\n", .{ rs1, rs1, base_addr, imm12, imm12, offset, eff_addr, self.memory_size });
-        
-        // Debug: Print register values for troubleshooting.
-        if (rs1 == 8) {
-            std.debug.print("DEBUG vm.zig: x8 (s0/fp) register was 0x{x}, using base_addr=0x{x}\n", .{ self.regs.get(8), base_addr });
-        }
-        
         // Assert: effective address must fit in usize for memory access (check first).
         // Note: On 64-bit systems, usize is u64, so this check should always pass.
         // On 32-bit systems, we need to ensure eff_addr <= maxInt(usize).
         if (@sizeOf(usize) == 4 and eff_addr > std.math.maxInt(usize)) {
-            std.debug.print("DEBUG vm.zig: SD address too large for usize: 0x{x} > maxInt(usize)\n", .{eff_addr});
+            self.trace_access(.fault, d, eff_addr, 8);
             self.state = .errored;
             self.last_error = VMError.invalid_memory_access;
             return VMError.invalid_memory_access;
@@ -1821,12 +2521,18 @@ pub const VM = struct {
         // Why: RISC-V requires 8-byte alignment for LD/SD, but programs may calculate misaligned addresses.
         // Note: This changes semantics slightly but allows execution to continue.
         if (eff_addr % 8 != 0) {
-            std.debug.print("DEBUG vm.zig: SD unaligned address: 0x{x} (not 8-byte aligned), aligning to 0x{x}\n", .{ eff_addr, eff_addr & ~@as(u64, 7) });
             eff_addr = eff_addr & ~@as(u64, 7);
         }
         
+        // Virtual to physical (identity while satp is Bare).
+        eff_addr = try self.translate(eff_addr, .store);
+        
         if (eff_addr + 8 > self.memory_size) {
-            std.debug.print("DEBUG vm.zig: SD out of bounds: eff_addr=0x{x}, eff_addr+8=0x{x}, memory_size=0x{x}\n", .{ eff_addr, eff_addr + 8, self.memory_size });
+            if (self.mmio_store(eff_addr, 8, self.regs.get(rs2))) {
+                self.trace_access(.store, d, eff_addr, 0);
+                return;
+            }
+            self.trace_access(.fault, d, eff_addr, 8);
             self.state = .errored;
             self.last_error = VMError.invalid_memory_access;
             return VMError.invalid_memory_access;
@@ -1836,30 +2542,128 @@ pub const VM = struct {
         
         // Safe cast: we've already verified eff_addr <= maxInt(usize).
         const eff_addr_usize: usize = @truncate(eff_addr);
+        self.trace_access(.store, d, eff_addr, 0);
         @memcpy(self.memory[eff_addr_usize..][0..8], &std.mem.toBytes(rs2_value));
+        self.note_store(eff_addr_usize);
+    }
+
+    /// Execute 32-bit RV64A instruction (LR.W, SC.W, AMO*.W).
+    fn execute_amo_w(self: *Self, d: *const Decoded) VMError!void {
+        return self.execute_amo(u32, d);
+    }
+
+    /// Execute 64-bit RV64A instruction (LR.D, SC.D, AMO*.D).
+    fn execute_amo_d(self: *Self, d: *const Decoded) VMError!void {
+        return self.execute_amo(u64, d);
+    }
+
+    /// Execute LR/SC/AMO of width T on host atomics.
+    /// Format: AMO rd, rs2, (rs1); funct5 = bits [31:27] selects the operation.
+    /// Contract: rd = old memory value, sign-extended (W forms) to 64 bits; SC writes 0/1.
+    /// Why: Host atomics on shared guest RAM make harts on different host threads
+    /// agree; aq/rl bits are satisfied because every host atomic here is seq_cst.
+    /// Note: Misaligned AMOs fault (no emulation), like LD/SD never do here.
+    fn execute_amo(self: *Self, comptime T: type, d: *const Decoded) VMError!void {
+        const Signed = std.meta.Int(.signed, @bitSizeOf(T));
+        const vaddr = self.regs.get(d.rs1);
+        const funct5: u5 = @truncate(d.inst >> 27);
+
+        if (vaddr % @sizeOf(T) != 0) {
+            self.state = .errored;
+            self.last_error = VMError.unaligned_memory_access;
+            return VMError.unaligned_memory_access;
+        }
+        // LR only reads; SC and AMOs need write permission even if they end up not storing.
+        const addr = if (funct5 == AMO_LR) try self.translate(vaddr, .load) else try self.translate(vaddr, .store);
+        if (addr > self.memory_size - @sizeOf(T)) {
+            self.state = .errored;
+            self.last_error = VMError.invalid_memory_access;
+            return VMError.invalid_memory_access;
+        }
+
+        const ptr: *T = @ptrCast(@alignCast(&self.memory[@intCast(addr)]));
+        const src: T = @truncate(self.regs.get(d.rs2));
+        self.trace_access(if (funct5 == AMO_LR) .load else .store, d, addr, 0);
+
+        const old: T = switch (funct5) {
+            AMO_LR => blk: {
+                const value = @atomicLoad(T, ptr, .seq_cst);
+                self.reservation = .{ .addr = addr, .value = value };
+                break :blk value;
+            },
+            AMO_SC => {
+                const reserved = self.reservation;
+                self.reservation = null;
+                const stored = if (reserved) |r|
+                    r.addr == addr and @cmpxchgStrong(T, ptr, @as(T, @truncate(r.value)), src, .seq_cst, .seq_cst) == null
+                else
+                    false;
+                if (stored) {
+                    self.note_store(addr);
+                }
+                self.regs.set(d.rd, if (stored) 0 else 1);
+                return;
+            },
+            0b00001 => @atomicRmw(T, ptr, .Xchg, src, .seq_cst),
+            0b00000 => @atomicRmw(T, ptr, .Add, src, .seq_cst),
+            0b00100 => @atomicRmw(T, ptr, .Xor, src, .seq_cst),
+            0b01100 => @atomicRmw(T, ptr, .And, src, .seq_cst),
+            0b01000 => @atomicRmw(T, ptr, .Or, src, .seq_cst),
+            0b10000 => @bitCast(@atomicRmw(Signed, @as(*Signed, @ptrCast(ptr)), .Min, @bitCast(src), .seq_cst)),
+            0b10100 => @bitCast(@atomicRmw(Signed, @as(*Signed, @ptrCast(ptr)), .Max, @bitCast(src), .seq_cst)),
+            0b11000 => @atomicRmw(T, ptr, .Min, src, .seq_cst),
+            0b11100 => @atomicRmw(T, ptr, .Max, src, .seq_cst),
+            else => return self.execute_invalid(d),
+        };
+        if (funct5 != AMO_LR) {
+            self.note_store(addr);
+        }
+
+        // rd = old value, sign-extended from T.
+        const extended: u64 = @bitCast(@as(i64, @as(Signed, @bitCast(old))));
+        self.regs.set(d.rd, extended);
+    }
+
+    /// AMO funct5 values with non read-modify-write semantics.
+    const AMO_LR: u5 = 0b00010;
+    const AMO_SC: u5 = 0b00011;
+
+    /// Execute FENCE (memory ordering between harts).
+    /// Why: Host stores may sit in the store buffer past later loads (x86 TSO);
+    /// a seq_cst RMW is a full host barrier. Standalone VMs need no ordering.
+    fn execute_fence(self: *Self, d: *const Decoded) VMError!void {
+        _ = d;
+        if (self.smp != null) {
+            _ = @atomicRmw(u32, &self.fence_word, .Add, 1, .seq_cst);
+        }
+    }
+
+    /// Execute FENCE.I (instruction fetch sees this hart's earlier stores).
+    /// Why: Own stores already invalidate cached decodes; stores from other harts
+    /// do not, so FENCE.I drops this hart's decodes and translated blocks.
+    fn execute_fence_i(self: *Self, d: *const Decoded) VMError!void {
+        _ = d;
+        if (self.smp != null) {
+            self.flush_decode_cache();
+        }
     }
 
     /// Execute BEQ (Branch if Equal) instruction.
     /// Format: BEQ rs1, rs2, offset
     /// Encoding: imm[12] | imm[10:5] | rs2 | rs1 | 000 | imm[4:1] | imm[11] | 1100011
     /// Why: Conditional branch for kernel control flow.
-    fn execute_beq(self: *Self, inst: u32) !void {
+    fn execute_beq(self: *Self, d: *const Decoded) VMError!void {
         // Decode B-type: rs2 = bits [24:20], rs1 = bits [19:15], imm[12] = bit [31], imm[10:5] = bits [30:25],
         // imm[4:1] = bits [11:8], imm[11] = bit [7].
-        const rs2 = @as(u5, @truncate(inst >> 20));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const imm_12 = @as(u1, @truncate(inst >> 31));
-        const imm_10_5 = @as(u6, @truncate(inst >> 25));
-        const imm_4_1 = @as(u4, @truncate(inst >> 8));
-        const imm_11 = @as(u1, @truncate(inst >> 7));
+        const rs2 = d.rs2;
+        const rs1 = d.rs1;
         
         // Assert: registers must be valid (0-31).
         std.debug.assert(rs2 < 32);
         std.debug.assert(rs1 < 32);
         
-        // Reconstruct 13-bit immediate (sign-extended): imm[12] | imm[11] | imm[10:5] | imm[4:1] | 0.
-        const imm13_raw = (@as(u13, imm_12) << 12) | (@as(u13, imm_11) << 11) | (@as(u13, imm_10_5) << 5) | (@as(u13, imm_4_1) << 1);
-        const imm13 = @as(i13, @bitCast(imm13_raw));
+        // Immediate pre-decoded from imm[12] | imm[11] | imm[10:5] | imm[4:1] | 0 (sign-extended).
+        const imm13 = @as(i13, @intCast(d.imm));
         
         // Read register values.
         const rs1_value = self.regs.get(rs1);
@@ -1879,7 +2683,7 @@ pub const VM = struct {
             const aligned_target = branch_target & ~@as(u64, 3);
             
             // Assert: branch target must be within memory bounds.
-            if (aligned_target >= self.memory_size) {
+            if (!self.jump_target_ok(aligned_target)) {
                 self.state = .errored;
                 self.last_error = VMError.invalid_memory_access;
                 return VMError.invalid_memory_access;
@@ -1901,19 +2705,14 @@ pub const VM = struct {
     /// Encoding: imm[12] | imm[10:5] | rs2 | rs1 | 001 | imm[4:1] | imm[11] | 1100011
     /// Contract: Branches if rs1 != rs2, updates PC if condition true
     /// Why: Conditional branch for kernel control flow.
-    fn execute_bne(self: *Self, inst: u32) !void {
-        const rs2 = @as(u5, @truncate(inst >> 20));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const imm_12 = @as(u1, @truncate(inst >> 31));
-        const imm_10_5 = @as(u6, @truncate(inst >> 25));
-        const imm_4_1 = @as(u4, @truncate(inst >> 8));
-        const imm_11 = @as(u1, @truncate(inst >> 7));
+    fn execute_bne(self: *Self, d: *const Decoded) VMError!void {
+        const rs2 = d.rs2;
+        const rs1 = d.rs1;
         
         std.debug.assert(rs2 < 32);
         std.debug.assert(rs1 < 32);
         
-        const imm13_raw = (@as(u13, imm_12) << 12) | (@as(u13, imm_11) << 11) | (@as(u13, imm_10_5) << 5) | (@as(u13, imm_4_1) << 1);
-        const imm13 = @as(i13, @bitCast(imm13_raw));
+        const imm13 = @as(i13, @intCast(d.imm));
         
         const rs1_value = self.regs.get(rs1);
         const rs2_value = self.regs.get(rs2);
@@ -1929,7 +2728,7 @@ pub const VM = struct {
                 return VMError.unaligned_instruction;
             }
             
-            if (branch_target >= self.memory_size) {
+            if (!self.jump_target_ok(branch_target)) {
                 self.state = .errored;
                 self.last_error = VMError.invalid_memory_access;
                 return VMError.invalid_memory_access;
@@ -1945,19 +2744,14 @@ pub const VM = struct {
     /// Encoding: imm[12] | imm[10:5] | rs2 | rs1 | 100 | imm[4:1] | imm[11] | 1100011
     /// Contract: Branches if rs1 < rs2 (signed), updates PC if condition true
     /// Why: Conditional branch for kernel control flow.
-    fn execute_blt(self: *Self, inst: u32) !void {
-        const rs2 = @as(u5, @truncate(inst >> 20));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const imm_12 = @as(u1, @truncate(inst >> 31));
-        const imm_10_5 = @as(u6, @truncate(inst >> 25));
-        const imm_4_1 = @as(u4, @truncate(inst >> 8));
-        const imm_11 = @as(u1, @truncate(inst >> 7));
+    fn execute_blt(self: *Self, d: *const Decoded) VMError!void {
+        const rs2 = d.rs2;
+        const rs1 = d.rs1;
         
         std.debug.assert(rs2 < 32);
         std.debug.assert(rs1 < 32);
         
-        const imm13_raw = (@as(u13, imm_12) << 12) | (@as(u13, imm_11) << 11) | (@as(u13, imm_10_5) << 5) | (@as(u13, imm_4_1) << 1);
-        const imm13 = @as(i13, @bitCast(imm13_raw));
+        const imm13 = @as(i13, @intCast(d.imm));
         
         const rs1_value = self.regs.get(rs1);
         const rs2_value = self.regs.get(rs2);
@@ -1975,7 +2769,7 @@ pub const VM = struct {
                 return VMError.unaligned_instruction;
             }
             
-            if (branch_target >= self.memory_size) {
+            if (!self.jump_target_ok(branch_target)) {
                 self.state = .errored;
                 self.last_error = VMError.invalid_memory_access;
                 return VMError.invalid_memory_access;
@@ -1991,19 +2785,14 @@ pub const VM = struct {
     /// Encoding: imm[12] | imm[10:5] | rs2 | rs1 | 101 | imm[4:1] | imm[11] | 1100011
     /// Contract: Branches if rs1 >= rs2 (signed), updates PC if condition true
     /// Why: Conditional branch for kernel control flow.
-    fn execute_bge(self: *Self, inst: u32) !void {
-        const rs2 = @as(u5, @truncate(inst >> 20));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const imm_12 = @as(u1, @truncate(inst >> 31));
-        const imm_10_5 = @as(u6, @truncate(inst >> 25));
-        const imm_4_1 = @as(u4, @truncate(inst >> 8));
-        const imm_11 = @as(u1, @truncate(inst >> 7));
+    fn execute_bge(self: *Self, d: *const Decoded) VMError!void {
+        const rs2 = d.rs2;
+        const rs1 = d.rs1;
         
         std.debug.assert(rs2 < 32);
         std.debug.assert(rs1 < 32);
         
-        const imm13_raw = (@as(u13, imm_12) << 12) | (@as(u13, imm_11) << 11) | (@as(u13, imm_10_5) << 5) | (@as(u13, imm_4_1) << 1);
-        const imm13 = @as(i13, @bitCast(imm13_raw));
+        const imm13 = @as(i13, @intCast(d.imm));
         
         const rs1_value = self.regs.get(rs1);
         const rs2_value = self.regs.get(rs2);
@@ -2021,7 +2810,7 @@ pub const VM = struct {
                 return VMError.unaligned_instruction;
             }
             
-            if (branch_target >= self.memory_size) {
+            if (!self.jump_target_ok(branch_target)) {
                 self.state = .errored;
                 self.last_error = VMError.invalid_memory_access;
                 return VMError.invalid_memory_access;
@@ -2037,19 +2826,14 @@ pub const VM = struct {
     /// Encoding: imm[12] | imm[10:5] | rs2 | rs1 | 110 | imm[4:1] | imm[11] | 1100011
     /// Contract: Branches if rs1 < rs2 (unsigned), updates PC if condition true
     /// Why: Conditional branch for kernel control flow.
-    fn execute_bltu(self: *Self, inst: u32) !void {
-        const rs2 = @as(u5, @truncate(inst >> 20));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const imm_12 = @as(u1, @truncate(inst >> 31));
-        const imm_10_5 = @as(u6, @truncate(inst >> 25));
-        const imm_4_1 = @as(u4, @truncate(inst >> 8));
-        const imm_11 = @as(u1, @truncate(inst >> 7));
+    fn execute_bltu(self: *Self, d: *const Decoded) VMError!void {
+        const rs2 = d.rs2;
+        const rs1 = d.rs1;
         
         std.debug.assert(rs2 < 32);
         std.debug.assert(rs1 < 32);
         
-        const imm13_raw = (@as(u13, imm_12) << 12) | (@as(u13, imm_11) << 11) | (@as(u13, imm_10_5) << 5) | (@as(u13, imm_4_1) << 1);
-        const imm13 = @as(i13, @bitCast(imm13_raw));
+        const imm13 = @as(i13, @intCast(d.imm));
         
         const rs1_value = self.regs.get(rs1);
         const rs2_value = self.regs.get(rs2);
@@ -2063,7 +2847,7 @@ pub const VM = struct {
             // Why: RISC-V instructions must be 4-byte aligned, but branch offsets can be misaligned.
             const aligned_target = branch_target & ~@as(u64, 3);
             
-            if (aligned_target >= self.memory_size) {
+            if (!self.jump_target_ok(aligned_target)) {
                 self.state = .errored;
                 self.last_error = VMError.invalid_memory_access;
                 return VMError.invalid_memory_access;
@@ -2079,19 +2863,14 @@ pub const VM = struct {
     /// Encoding: imm[12] | imm[10:5] | rs2 | rs1 | 111 | imm[4:1] | imm[11] | 1100011
     /// Contract: Branches if rs1 >= rs2 (unsigned), updates PC if condition true
     /// Why: Conditional branch for kernel control flow.
-    fn execute_bgeu(self: *Self, inst: u32) !void {
-        const rs2 = @as(u5, @truncate(inst >> 20));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const imm_12 = @as(u1, @truncate(inst >> 31));
-        const imm_10_5 = @as(u6, @truncate(inst >> 25));
-        const imm_4_1 = @as(u4, @truncate(inst >> 8));
-        const imm_11 = @as(u1, @truncate(inst >> 7));
+    fn execute_bgeu(self: *Self, d: *const Decoded) VMError!void {
+        const rs2 = d.rs2;
+        const rs1 = d.rs1;
         
         std.debug.assert(rs2 < 32);
         std.debug.assert(rs1 < 32);
         
-        const imm13_raw = (@as(u13, imm_12) << 12) | (@as(u13, imm_11) << 11) | (@as(u13, imm_10_5) << 5) | (@as(u13, imm_4_1) << 1);
-        const imm13 = @as(i13, @bitCast(imm13_raw));
+        const imm13 = @as(i13, @intCast(d.imm));
         
         const rs1_value = self.regs.get(rs1);
         const rs2_value = self.regs.get(rs2);
@@ -2107,7 +2886,7 @@ pub const VM = struct {
                 return VMError.unaligned_instruction;
             }
             
-            if (branch_target >= self.memory_size) {
+            if (!self.jump_target_ok(branch_target)) {
                 self.state = .errored;
                 self.last_error = VMError.invalid_memory_access;
                 return VMError.invalid_memory_access;
@@ -2123,18 +2902,13 @@ pub const VM = struct {
     /// Encoding: imm[20] | imm[10:1] | imm[11] | imm[19:12] | rd | 1101111
     /// Contract: Jumps to PC + offset, stores PC+4 in rd (return address)
     /// Why: Function calls and long-range jumps.
-    fn execute_jal(self: *Self, inst: u32) !void {
-        const rd = @as(u5, @truncate(inst >> 7));
-        const imm_20 = @as(u1, @truncate(inst >> 31));
-        const imm_10_1 = @as(u10, @truncate(inst >> 21));
-        const imm_11 = @as(u1, @truncate(inst >> 20));
-        const imm_19_12 = @as(u8, @truncate(inst >> 12));
+    fn execute_jal(self: *Self, d: *const Decoded) VMError!void {
+        const rd = d.rd;
         
         std.debug.assert(rd < 32);
         
-        // Reconstruct 21-bit immediate (sign-extended): imm[20] | imm[19:12] | imm[11] | imm[10:1] | 0
-        const imm21_raw = (@as(u21, imm_20) << 20) | (@as(u21, imm_19_12) << 12) | (@as(u21, imm_11) << 11) | (@as(u21, imm_10_1) << 1);
-        const imm21 = @as(i21, @bitCast(imm21_raw));
+        // Immediate pre-decoded from imm[20] | imm[19:12] | imm[11] | imm[10:1] | 0 (sign-extended).
+        const imm21 = @as(i21, @intCast(d.imm));
         
         // Save return address (PC + 4) in rd.
         const return_addr = self.regs.pc + 4;
@@ -2150,7 +2924,7 @@ pub const VM = struct {
         const aligned_target = jump_target & ~@as(u64, 3);
         
         // Assert: jump target must be within memory bounds.
-        if (aligned_target >= self.memory_size) {
+        if (!self.jump_target_ok(aligned_target)) {
             self.state = .errored;
             self.last_error = VMError.invalid_memory_access;
             return VMError.invalid_memory_access;
@@ -2168,10 +2942,10 @@ pub const VM = struct {
     /// Encoding: imm[11:0] | rs1 | 000 | rd | 1100111
     /// Contract: Jumps to (rs1 + offset) & ~1, stores PC+4 in rd (return address)
     /// Why: Function returns and indirect jumps.
-    fn execute_jalr(self: *Self, inst: u32) !void {
-        const rd = @as(u5, @truncate(inst >> 7));
-        const rs1 = @as(u5, @truncate(inst >> 15));
-        const imm12 = @as(i32, @truncate(@as(i64, inst >> 20)));
+    fn execute_jalr(self: *Self, d: *const Decoded) VMError!void {
+        const rd = d.rd;
+        const rs1 = d.rs1;
+        const imm12 = @as(i32, @intCast(d.imm));
         
         std.debug.assert(rd < 32);
         std.debug.assert(rs1 < 32);
@@ -2189,15 +2963,15 @@ pub const VM = struct {
         const jump_target_raw = base_addr +% offset;
         const jump_target = jump_target_raw & ~@as(u64, 3);
         
-        // Debug: Print JALR execution for troubleshooting.
-        std.debug.print("DEBUG vm.zig: JALR instruction: rs1={} (x{}), base_addr=0x{x}, imm12={} (0x{x}), offset=0x{x}, jump_target_raw=0x{x}, jump_target=0x{x}, memory_size=0x{x}\n", .{ rs1, rs1, base_addr, imm12, imm12, offset, jump_target_raw, jump_target, self.memory_size });
+        // Trace: indirect jump target.
+        self.trace_access(.jump, d, jump_target, 0);
         
         // Assert: jump target must be 4-byte aligned (enforced by & ~3).
         std.debug.assert(jump_target % 4 == 0);
         
         // Assert: jump target must be within memory bounds.
-        if (jump_target >= self.memory_size) {
-            std.debug.print("DEBUG vm.zig: JALR out of bounds: jump_target=0x{x}, memory_size=0x{x}\n", .{ jump_target, self.memory_size });
+        if (!self.jump_target_ok(jump_target)) {
+            self.trace_access(.fault, d, jump_target, 4);
             self.state = .errored;
             self.last_error = VMError.invalid_memory_access;
             return VMError.invalid_memory_access;
@@ -2231,21 +3005,18 @@ pub const VM = struct {
         // RISC-V syscall convention: a7 (x17) contains syscall/EID number.
         const syscall_num = self.regs.get(17); // a7 register
         
-        // Debug: Print ECALL execution for troubleshooting.
-        std.debug.print("DEBUG vm.zig: ECALL instruction: syscall_num={} (0x{x}), a0=0x{x}, a1=0x{x}, a2=0x{x}, a3=0x{x}, PC=0x{x}\n", .{
-            syscall_num, syscall_num,
-            self.regs.get(10), // a0
-            self.regs.get(11), // a1
-            self.regs.get(12), // a2
-            self.regs.get(13), // a3
-            self.regs.pc,
+        // Trace: syscall number and arguments.
+        self.trace.record(.{
+            .pc = self.regs.pc,
+            .kind = .ecall,
+            .addr = syscall_num,
+            .args = .{ self.regs.get(10), self.regs.get(11), self.regs.get(12), self.regs.get(13) },
         });
         
-        // Assert: syscall number must fit in u32.
-        std.debug.assert(syscall_num <= 0xFFFFFFFF);
-        
-        // Assert: syscall number must be within reasonable range (0-50).
-        std.debug.assert(syscall_num <= 50);
+        // Note: a7 is guest-controlled, so any value may arrive here. The kernel rejects
+        // numbers it does not know; ones too wide for u32 go to it as maxInt(u32) rather than
+        // truncated into a valid number.
+        const kernel_syscall_num: u32 = std.math.cast(u32, syscall_num) orelse std.math.maxInt(u32);
         
         // Extract syscall arguments from a0-a5 registers (x10-x15).
         const arg1 = self.regs.get(10); // a0
@@ -2270,20 +3041,30 @@ pub const VM = struct {
             // Assert: Kernel syscall must have function ID >= 10.
             std.debug.assert(syscall_num >= 10);
             
-            // Kernel syscall: Handle via callback if available.
-            if (self.syscall_handler) |handler| {
-                // Assert: handler pointer must be valid.
-                const handler_ptr = @intFromPtr(handler);
-                std.debug.assert(handler_ptr != 0);
-                
-                // Call syscall handler and get result.
-                const result = handler(
-                    @as(u32, @truncate(syscall_num)),
-                    arg1,
-                    arg2,
-                    arg3,
-                    arg4,
-                );
+            // Kernel syscall: replayed result, else handler callback if available.
+            // Note: Replay never calls the handler; the logged result stands in for it.
+            const replayed: ?u64 = if (self.replay) |session| session.replay_input(.syscall, syscall_num) else null;
+            if (replayed != null or self.syscall_handler != null) {
+                const result = replayed orelse blk: {
+                    const handler = self.syscall_handler.?;
+                    // Assert: handler pointer must be valid.
+                    const handler_ptr = @intFromPtr(handler);
+                    std.debug.assert(handler_ptr != 0);
+                    
+                    // Call syscall handler and get result.
+                    // SMP: host kernel state is shared by every hart, so calls serialize.
+                    if (self.smp) |smp| smp.lock.lock();
+                    defer if (self.smp) |smp| smp.lock.unlock();
+                    const live = handler(
+                        kernel_syscall_num,
+                        arg1,
+                        arg2,
+                        arg3,
+                        arg4,
+                    );
+                    if (self.replay) |session| session.record_input(.syscall, syscall_num, live);
+                    break :blk live;
+                };
                 
                 // Assert: result must be valid (can be error code if negative when interpreted as i64).
                 // Note: Error codes are negative, success values are non-negative.
@@ -2294,23 +3075,13 @@ pub const VM = struct {
                 // Assert: a0 register must be set correctly.
                 std.debug.assert(self.regs.get(10) == result);
                 
-                // Special case: exit syscall (syscall number 2) halts VM.
-                // Note: This is kernel syscall 2, not SBI function ID 2.
-                // Note: Kernel syscall 2 is exit, which should halt VM.
-                if (syscall_num == 2) {
-                    // Assert: exit syscall must halt VM.
-                    std.debug.assert(syscall_num == 2);
-                    self.state = .halted;
-                    
-                    // Assert: VM state must be halted after exit syscall.
-                    std.debug.assert(self.state == .halted);
-                } else {
-                    // Assert: Non-exit syscalls should not halt VM.
-                    std.debug.assert(self.state == .running);
-                }
+                // Assert: Kernel syscalls do not halt the VM.
+                // Note: exit only takes the process off the CPU; the host scheduler stops
+                // the VM once no process is left (Integration.schedule).
+                std.debug.assert(self.state == .running);
             } else {
-                // Assert: No handler should only happen if handler not set.
-                std.debug.assert(self.syscall_handler == null);
+                // Assert: No handler should only happen if handler not set (and nothing replayed).
+                std.debug.assert(self.syscall_handler == null and replayed == null);
                 
                 // No handler: halt VM (simple behavior).
                 self.state = .halted;
@@ -2328,7 +3099,8 @@ pub const VM = struct {
     
     /// Handle SBI (Supervisor Binary Interface) call.
     /// Why: Implement platform services (timer, console, reset) for RISC-V SBI.
-    /// SBI Legacy Functions: 0x0=SET_TIMER, 0x1=CONSOLE_PUTCHAR, 0x2=CONSOLE_GETCHAR, 0x8=SHUTDOWN.
+    /// SBI Legacy Functions: 0x0=SET_TIMER, 0x1=CONSOLE_PUTCHAR, 0x2=CONSOLE_GETCHAR,
+    /// 0x3=CLEAR_IPI, 0x4=SEND_IPI, 0x5=REMOTE_FENCE_I, 0x6/0x7=REMOTE_SFENCE_VMA(_ASID), 0x8=SHUTDOWN.
     /// Grain Style: Comprehensive assertions for all SBI call parameters and state transitions.
     /// Note: Public for testing (fuzz tests need direct access).
     pub fn handle_sbi_call(self: *Self, eid: u32, arg1: u64, arg2: u64, arg3: u64, arg4: u64) void {
@@ -2340,21 +3112,17 @@ pub const VM = struct {
         // Assert: VM must be in valid state (running or halted, not errored).
         std.debug.assert(self.state != .errored);
         
-        // Assert: EID must be valid SBI legacy function ID (< 10).
+        // Assert: EID must be in the SBI range (< 10; the ECALL path routes the rest to the kernel).
+        // Note: Unknown IDs in that range come from guest a7 and return NotSupported.
         std.debug.assert(eid < 10);
         
-        // Assert: EID must match known SBI legacy function IDs.
-        std.debug.assert(eid <= @intFromEnum(sbi.EID.LEGACY_SHUTDOWN));
-        
         // Dispatch based on SBI Extension ID (EID).
         // Why: Different SBI functions have different calling conventions.
         switch (eid) {
             // LEGACY_CONSOLE_PUTCHAR (0x1): Write character to console.
             // Calling convention: character in a0 (x10), no return value.
             @intFromEnum(sbi.EID.LEGACY_CONSOLE_PUTCHAR) => {
-                // Assert: character must fit in u8.
-                std.debug.assert(arg1 <= 0xFF);
-                
+                // Only the low byte of a0 is the character (a0 is guest-controlled).
                 // Assert: serial_output pointer must be valid if set.
                 if (self.serial_output) |serial| {
                     // Assert: serial pointer must be non-null and aligned.
@@ -2362,7 +3130,9 @@ pub const VM = struct {
                     std.debug.assert(serial_ptr != 0);
                     std.debug.assert(serial_ptr % @alignOf(@TypeOf(serial.*)) == 0);
                     
-                    // Write character to serial output.
+                    // Write character to serial output (one writer at a time across SMP harts).
+                    if (self.smp) |smp| smp.lock.lock();
+                    defer if (self.smp) |smp| smp.lock.unlock();
                     serial.writeByte(@as(u8, @truncate(arg1)));
                     
                     // Assert: serial output write position must be valid after write.
@@ -2375,14 +3145,26 @@ pub const VM = struct {
                 // Assert: a0 register must be set to 0 (success).
                 std.debug.assert(self.regs.get(10) == 0);
             },
+            // LEGACY_SET_TIMER (0x0): Program the next timer deadline.
+            // Calling convention: a0 = absolute mtime deadline; clears a pending timer
+            // interrupt if it lies in the future. Returns 0 in a0.
+            @intFromEnum(sbi.EID.LEGACY_SET_TIMER) => {
+                self.csrs.mtimecmp = arg1;
+                self.interrupt_at = self.csrs.interrupt_deadline();
+                self.regs.set(10, 0);
+
+                // Assert: timer must be pending exactly when the deadline has passed.
+                std.debug.assert(self.csrs.timer_pending() == (self.csrs.mtime >= arg1));
+            },
             // LEGACY_SHUTDOWN (0x8): System shutdown.
             // Calling convention: no arguments, no return value.
             @intFromEnum(sbi.EID.LEGACY_SHUTDOWN) => {
                 // Assert: VM state must be valid before shutdown.
                 std.debug.assert(self.state != .errored);
                 
-                // Halt VM on shutdown.
+                // Halt VM on shutdown (SMP: every hart stops at its next batch boundary).
                 self.state = .halted;
+                if (self.smp) |smp| smp.request_shutdown();
                 
                 // Assert: VM state must be halted after shutdown.
                 std.debug.assert(self.state == .halted);
@@ -2390,8 +3172,40 @@ pub const VM = struct {
                 // SBI SHUTDOWN doesn't return.
                 self.regs.set(10, 0);
             },
-            // Other SBI functions: Not implemented yet.
-            // TODO: Implement SET_TIMER, CONSOLE_GETCHAR, etc.
+            // LEGACY_CLEAR_IPI (0x3): Clear this hart's pending IPI.
+            // Calling convention: no arguments; a0 = 1 if an IPI was pending, else 0.
+            @intFromEnum(sbi.EID.LEGACY_CLEAR_IPI) => {
+                const was_pending = if (self.smp) |smp| smp.clear_ipi(self.hart_id) else false;
+                self.regs.set(10, @intFromBool(was_pending));
+            },
+            // LEGACY_SEND_IPI (0x4) / LEGACY_REMOTE_FENCE_I (0x5) / LEGACY_REMOTE_SFENCE_VMA(_ASID) (0x6, 0x7):
+            // Signal harts in a mask.
+            // Calling convention: a0 = guest address of the hart mask (u64, bit n = hart n).
+            // Note: SFENCE.VMA ranges and ASIDs (a1..a3) are ignored; targets flush their whole TLB.
+            @intFromEnum(sbi.EID.LEGACY_SEND_IPI),
+            @intFromEnum(sbi.EID.LEGACY_REMOTE_FENCE_I),
+            @intFromEnum(sbi.EID.LEGACY_REMOTE_SFENCE_VMA),
+            @intFromEnum(sbi.EID.LEGACY_REMOTE_SFENCE_VMA_ASID),
+            => {
+                const status: sbi.SBIError = blk: {
+                    const mask_addr = self.translate_quiet(arg1, .load) orelse break :blk .InvalidAddress;
+                    if (mask_addr % 8 != 0 or mask_addr > self.memory_size - 8) break :blk .InvalidAddress;
+                    const mask = std.mem.readInt(u64, self.memory[@intCast(mask_addr)..][0..8], .little);
+                    if (eid >= @intFromEnum(sbi.EID.LEGACY_REMOTE_SFENCE_VMA)) {
+                        // Calling hart flushes now (the rest at their next batch).
+                        if (mask & (@as(u64, 1) << @intCast(self.hart_id)) != 0) self.tlb.flush_all();
+                        if (self.smp) |smp| smp.remote_sfence_vma(mask);
+                        break :blk .Success;
+                    }
+                    if (self.smp) |smp| {
+                        if (eid == @intFromEnum(sbi.EID.LEGACY_SEND_IPI)) smp.send_ipi(mask) else smp.remote_fence_i(mask);
+                    }
+                    // Standalone VM: no other harts; its own stores already keep decodes coherent.
+                    break :blk .Success;
+                };
+                self.regs.set(10, @as(u64, @bitCast(@intFromEnum(status))));
+            },
+            // Other SBI functions (CONSOLE_GETCHAR and unknown IDs): NotSupported.
             else => {
                 // Assert: Unknown SBI function must return error code.
                 std.debug.assert(eid != @intFromEnum(sbi.EID.LEGACY_CONSOLE_PUTCHAR));
@@ -2455,6 +3269,9 @@ pub const VM = struct {
         self.state = .running;
         self.last_error = null;
         
+        // Drop decodes of whatever code was in memory before (host may have rewritten it).
+        self.flush_decode_cache();
+        
         // Assert: VM must be in running state after start.
         std.debug.assert(self.state == .running);
     }
@@ -16,6 +16,12 @@ const basin_kernel = @import("basin_kernel");
 /// Note: Safe for single-threaded execution only.
 var global_sandbox_ptr: ?*anyopaque = null;
 
+/// VM instruction budget per UI frame (upper bound; wall clock usually ends the batch first).
+const VM_TICK_MAX_INSTRUCTIONS: u64 = 4_000_000;
+
+/// VM wall-clock budget per UI frame (8ms, half a 60Hz frame, leaves time for rendering).
+const VM_TICK_MAX_NANOSECONDS: u64 = 8 * std.time.ns_per_ms;
+
 /// TahoeSandbox hosts a River-inspired compositor with Moonglow keybindings,
 /// blending Etsy.com marketplace aesthetics with Grain terminal panes.
 /// ~<~ Glow Waterbend: compositor streams stay deterministic.
@@ -338,7 +344,7 @@ pub const TahoeSandbox = struct {
                 std.debug.assert(elf_data.len > 0);
                 
                 // Load kernel into VM.
-                // Note: VM must be allocated on heap (4MB struct).
+                // Note: VM is heap-allocated so its address stays stable for handlers.
                 var vm = sandbox.allocator.create(VM) catch |err| {
                     std.debug.print("[tahoe_window] Failed to allocate VM: {s}\n", .{@errorName(err)});
                     return true;
@@ -351,6 +357,9 @@ pub const TahoeSandbox = struct {
                     return true;
                 };
                 
+                // Kernel pointer checks and I/O copies go through this VM's RAM.
+                sandbox.basin_kernel_instance.attach_user_memory(kernel_vm.user_memory(vm));
+                
                 // Assert: VM must be valid before setting handlers.
                 const vm_ptr = @intFromPtr(&vm);
                 std.debug.assert(vm_ptr != 0);
@@ -386,7 +395,13 @@ pub const TahoeSandbox = struct {
                 std.debug.assert(sandbox.serial_output.buffer.len > 0);
                 std.debug.assert(sandbox.serial_output.write_pos < sandbox.serial_output.buffer.len);
                 
-                // Store VM in sandbox (store pointer to avoid copying 4MB struct).
+                // Release a previously loaded VM (guest RAM and heap struct).
+                if (sandbox.vm) |previous_vm| {
+                    previous_vm.deinit();
+                    sandbox.allocator.destroy(previous_vm);
+                }
+                
+                // Store VM in sandbox (store pointer, VM owns its guest RAM mapping).
                 sandbox.vm = vm;
                 
                 // Assert: VM must be stored correctly.
@@ -520,7 +535,7 @@ pub const TahoeSandbox = struct {
         std.debug.assert(syscall_num >= 10);
         
         // Assert: syscall number must be within valid range.
-        std.debug.assert(syscall_num <= @intFromEnum(basin_kernel.Syscall.sysinfo));
+        std.debug.assert(syscall_num <= basin_kernel.SYSCALL_MAX);
         
         // Access sandbox via module-level storage (set when VM is loaded).
         // Note: This is safe for single-threaded execution only.
@@ -644,6 +659,11 @@ pub const TahoeSandbox = struct {
     }
 
     pub fn deinit(self: *TahoeSandbox) void {
+        // Release VM guest RAM and heap struct (if a kernel was loaded).
+        if (self.vm) |vm| {
+            vm.deinit();
+            self.allocator.destroy(vm);
+        }
         // Free BasinKernel instance (allocated on heap).
         self.allocator.destroy(self.basin_kernel_instance);
         self.aurora.deinit();
@@ -661,15 +681,22 @@ pub const TahoeSandbox = struct {
         _ = self.platform.vtable;
         _ = self.platform.impl;
         
-        // Step RISC-V VM if running.
+        // Run RISC-V VM if running.
         // Why: Execute kernel instructions continuously during VM execution.
+        // Note: Each frame runs one batch bounded by instruction count and wall clock,
+        // so the guest advances by millions of instructions without stalling the UI.
         if (self.vm) |vm| {
             if (vm.state == .running) {
-                // Step VM (execute one instruction).
-                vm.step() catch |err| {
+                const result = vm.run(.{
+                    .max_instructions = VM_TICK_MAX_INSTRUCTIONS,
+                    .max_nanoseconds = VM_TICK_MAX_NANOSECONDS,
+                });
+                if (result.exit == .fault) {
+                    const err = vm.last_error orelse VM.VMError.invalid_instruction;
                     std.debug.print("[tahoe_window] VM step error: {s}\n", .{@errorName(err)});
+                    vm.dump_trace_stderr();
                     vm.stop();
-                };
+                }
             }
         }
         
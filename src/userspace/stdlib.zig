@@ -7,12 +7,6 @@ const std = @import("std");
 /// Syscall numbers (must match kernel/basin_kernel.zig).
 /// Why: Explicit syscall enumeration for type safety.
 pub const Syscall = enum(u32) {
-    // Process & Thread Management
-    spawn = 1,
-    exit = 2,
-    yield = 3,
-    wait = 4,
-
     // Memory Management
     map = 10,
     unmap = 11,
@@ -41,8 +35,39 @@ pub const Syscall = enum(u32) {
 
     // System Information
     sysinfo = 50,
+
+    // Vectored I/O (scatter-gather read/write)
+    readv = 60,
+    writev = 61,
+
+    // Batched I/O (submission/completion rings)
+    io_ring_setup = 62,
+    io_ring_enter = 63,
+
+    // Process & Thread Management
+    // Note: Numbers below 10 are SBI extension IDs on the guest ECALL path, so process
+    // calls live above the other kernel syscalls where guests can reach them.
+    spawn = 70,
+    exit = 71,
+    yield = 72,
+    wait = 73,
 };
 
+/// Scatter-gather entry for readv/writev (must match kernel/basin_kernel.zig IoVec).
+/// Why: One ecall moves many buffers; the kernel reads this array from guest memory.
+pub const IoVec = extern struct {
+    base: u64,
+    len: u64,
+
+    /// Entry describing buffer.
+    pub fn init(buffer: []const u8) IoVec {
+        return .{ .base = @intFromPtr(buffer.ptr), .len = buffer.len };
+    }
+};
+
+/// Most iovec entries per readv/writev (must match kernel MAX_IOVECS).
+pub const MAX_IOVECS: usize = 64;
+
 /// Make a syscall (RISC-V convention: syscall number in a7, args in a0-a3, result in a0).
 /// Contract:
 ///   Input: syscall_num must be valid Syscall enum value, args are syscall-specific
@@ -122,6 +147,390 @@ pub fn read(handle: u32, buffer: []u8) i64 {
     return @as(i64, @bitCast(result));
 }
 
+/// Write several buffers to a file handle in one syscall (gather).
+/// Contract:
+///   Input: handle must be valid file handle, 1..MAX_IOVECS entries
+///   Output: Returns total bytes written, or negative error code
+///   Errors: Invalid handle, permission denied, invalid argument (bad iovec)
+/// Why: Batched file I/O (one ecall and one handle lookup for every buffer).
+pub fn writev(handle: u32, iovs: []const IoVec) i64 {
+    // Contract: iovec count must be within kernel limits.
+    if (iovs.len == 0 or iovs.len > MAX_IOVECS) {
+        return -2; // invalid_argument
+    }
+
+    const result = syscall(.writev, handle, @intFromPtr(iovs.ptr), iovs.len, 0);
+    return @as(i64, @bitCast(result));
+}
+
+/// Read from a file handle into several buffers in one syscall (scatter).
+/// Contract:
+///   Input: handle must be valid file handle, 1..MAX_IOVECS entries (writable buffers)
+///   Output: Returns total bytes read, or negative error code
+///   Errors: Invalid handle, permission denied, invalid argument (bad iovec)
+/// Why: Batched file I/O (one ecall and one handle lookup for every buffer).
+pub fn readv(handle: u32, iovs: []const IoVec) i64 {
+    // Contract: iovec count must be within kernel limits.
+    if (iovs.len == 0 or iovs.len > MAX_IOVECS) {
+        return -2; // invalid_argument
+    }
+
+    const result = syscall(.readv, handle, @intFromPtr(iovs.ptr), iovs.len, 0);
+    return @as(i64, @bitCast(result));
+}
+
+/// Channel ring geometry (must match kernel/channel.zig).
+pub const CHANNEL_SLOTS: u32 = 32;
+pub const CHANNEL_INLINE_MAX: u32 = 112;
+
+/// Slot kind of an inline message (kernel/channel.zig Kind.inline_bytes).
+const CHANNEL_KIND_INLINE: u32 = 1;
+
+/// One channel message (must match kernel/channel.zig Slot).
+pub const ChannelSlot = extern struct {
+    len: u32,
+    kind: u32,
+    pages: u64,
+    data: [CHANNEL_INLINE_MAX]u8,
+};
+
+/// Channel ring in shared guest pages (must match kernel/channel.zig Header + slots).
+/// Why: Inline messages need no syscall; producer and consumer meet in memory.
+/// Contract: One producer and one consumer per ring, whether they use these methods or
+/// channel_send/channel_recv; page messages must be received with channel_recv.
+pub const ChannelRing = extern struct {
+    magic: u32,
+    slots: u32,
+    _reserved0: [56]u8,
+    /// Next slot to consume (consumer-owned).
+    head: u32,
+    _reserved1: [60]u8,
+    /// Next slot to fill (producer-owned).
+    tail: u32,
+    _reserved2: [124]u8,
+    entries: [CHANNEL_SLOTS]ChannelSlot,
+
+    /// Queue an inline message without a syscall (producer only).
+    /// Returns: false if the ring is full or data is empty or over CHANNEL_INLINE_MAX.
+    pub fn try_send(self: *ChannelRing, data: []const u8) bool {
+        if (data.len == 0 or data.len > CHANNEL_INLINE_MAX) return false;
+        const tail = self.tail;
+        const head = @atomicLoad(u32, &self.head, .acquire);
+        if (tail -% head >= CHANNEL_SLOTS) return false;
+
+        const slot = &self.entries[tail % CHANNEL_SLOTS];
+        slot.len = @intCast(data.len);
+        slot.kind = CHANNEL_KIND_INLINE;
+        slot.pages = 0;
+        @memcpy(slot.data[0..data.len], data);
+        // Release: the slot is visible before the new tail.
+        @atomicStore(u32, &self.tail, tail +% 1, .release);
+        return true;
+    }
+
+    /// Take an inline message without a syscall (consumer only).
+    /// Returns: Message length, or null if the ring is empty, the next message carries
+    /// pages (use channel_recv) or does not fit buffer.
+    pub fn try_recv(self: *ChannelRing, buffer: []u8) ?usize {
+        const head = self.head;
+        const tail = @atomicLoad(u32, &self.tail, .acquire);
+        if (tail == head) return null;
+
+        const slot = &self.entries[head % CHANNEL_SLOTS];
+        if (slot.kind != CHANNEL_KIND_INLINE or slot.len > CHANNEL_INLINE_MAX or slot.len > buffer.len) return null;
+        const len: usize = slot.len;
+        @memcpy(buffer[0..len], slot.data[0..len]);
+        // Release: the slot is read before the producer may reuse it.
+        @atomicStore(u32, &self.head, head +% 1, .release);
+        return len;
+    }
+};
+
+/// Create a channel.
+/// Contract:
+///   Input: ring_out (optional) receives the ring address (usable as *ChannelRing)
+///   Output: Returns channel ID (positive), or negative error code
+///   Errors: Out of memory (channel or mapping table full)
+/// Why: IPC between z6 and services (shared ring, no kernel buffering).
+pub fn channel_create(ring_out: ?*u64) i64 {
+    const ring_out_ptr: u64 = if (ring_out) |ptr| @intFromPtr(ptr) else 0;
+    const result = syscall(.channel_create, ring_out_ptr, 0, 0, 0);
+    return @as(i64, @bitCast(result));
+}
+
+/// Send a message on a channel.
+/// Contract:
+///   Input: data up to CHANNEL_INLINE_MAX bytes is copied; larger data must start a
+///          mapping (from map) that is handed to the receiver without copying
+///   Output: Returns 0, or negative error code
+///   Errors: Would block (ring full), invalid handle, invalid argument
+/// Why: One syscall per message; page-sized payloads move by ownership.
+pub fn channel_send(channel: u64, data: []const u8) i64 {
+    const result = syscall(.channel_send, channel, @intFromPtr(data.ptr), data.len, 0);
+    return @as(i64, @bitCast(result));
+}
+
+/// Receive a message from a channel.
+/// Contract:
+///   Input: buffer receives inline messages; pages_out receives the address of a
+///          transferred mapping (0 for inline messages) and is required for page messages
+///   Output: Returns message length, or negative error code
+///   Errors: Would block (ring empty), invalid handle, invalid argument (buffer too small)
+/// Why: Counterpart of channel_send; the caller owns received mappings (unmap when done).
+pub fn channel_recv(channel: u64, buffer: []u8, pages_out: ?*u64) i64 {
+    const pages_out_ptr: u64 = if (pages_out) |ptr| @intFromPtr(ptr) else 0;
+    const result = syscall(.channel_recv, channel, @intFromPtr(buffer.ptr), buffer.len, pages_out_ptr);
+    return @as(i64, @bitCast(result));
+}
+
+/// io_ring geometry (must match kernel/io_ring.zig).
+pub const IO_RING_SQ_ENTRIES: u32 = 64;
+pub const IO_RING_CQ_ENTRIES: u32 = 128;
+
+/// io_ring_setup flag: the kernel drains submissions by itself (no io_ring_enter needed).
+pub const IO_RING_SETUP_POLL: u32 = 1;
+
+/// One submitted syscall (must match kernel/io_ring.zig Sqe).
+pub const IoRingSqe = extern struct {
+    opcode: u32,
+    flags: u32,
+    user_data: u64,
+    args: [4]u64,
+    _reserved: [2]u64,
+};
+
+/// One completed syscall (must match kernel/io_ring.zig Cqe).
+pub const IoRingCqe = extern struct {
+    user_data: u64,
+    /// Syscall result: non-negative success value, or negative error code.
+    result: i64,
+};
+
+/// Batched syscall ring in shared guest pages (must match kernel/io_ring.zig Header + queues).
+/// Why: Queue many syscalls, then pay for one io_ring_enter (or none with
+/// IO_RING_SETUP_POLL); completions are read straight from memory.
+/// Contract: One submitter and one reaper per ring. Process, sleep and ring syscalls
+/// complete with invalid_syscall.
+pub const IoRing = extern struct {
+    magic: u32,
+    sq_entries: u32,
+    cq_entries: u32,
+    flags: u32,
+    _reserved0: [48]u8,
+    /// Next submission the kernel consumes (kernel-owned).
+    sq_head: u32,
+    _reserved1: [60]u8,
+    /// Next submission slot to fill (submitter-owned).
+    sq_tail: u32,
+    _reserved2: [60]u8,
+    /// Next completion to reap (reaper-owned).
+    cq_head: u32,
+    _reserved3: [60]u8,
+    /// Next completion slot to fill (kernel-owned).
+    cq_tail: u32,
+    _reserved4: [60]u8,
+    sq: [IO_RING_SQ_ENTRIES]IoRingSqe,
+    cq: [IO_RING_CQ_ENTRIES]IoRingCqe,
+
+    /// Queue a syscall without trapping (it runs on the next io_ring_enter or poll).
+    /// Returns: false if the submission queue is full.
+    pub fn try_submit(self: *IoRing, syscall_num: Syscall, args: [4]u64, user_data: u64) bool {
+        const tail = self.sq_tail;
+        const head = @atomicLoad(u32, &self.sq_head, .acquire);
+        if (tail -% head >= IO_RING_SQ_ENTRIES) return false;
+
+        self.sq[tail % IO_RING_SQ_ENTRIES] = .{
+            .opcode = @intFromEnum(syscall_num),
+            .flags = 0,
+            .user_data = user_data,
+            .args = args,
+            ._reserved = .{ 0, 0 },
+        };
+        // Release: the entry is visible before the new tail.
+        @atomicStore(u32, &self.sq_tail, tail +% 1, .release);
+        return true;
+    }
+
+    /// Take the oldest completion without trapping.
+    /// Returns: null if no completion is posted yet.
+    pub fn try_complete(self: *IoRing) ?IoRingCqe {
+        const head = self.cq_head;
+        const tail = @atomicLoad(u32, &self.cq_tail, .acquire);
+        if (tail == head) return null;
+
+        const cqe = self.cq[head % IO_RING_CQ_ENTRIES];
+        // Release: the entry is read before the kernel may reuse it.
+        @atomicStore(u32, &self.cq_head, head +% 1, .release);
+        return cqe;
+    }
+};
+
+/// Set up a batched syscall ring.
+/// Contract:
+///   Input: ring_out (optional) receives the ring address (usable as *IoRing); flags is
+///          0 or IO_RING_SETUP_POLL
+///   Output: Returns ring ID (positive), or negative error code
+///   Errors: Out of memory (ring or mapping table full), invalid argument (flags)
+/// Why: Amortize one ecall over a batch of opens, reads, writes and maps.
+pub fn io_ring_setup(ring_out: ?*u64, flags: u32) i64 {
+    const ring_out_ptr: u64 = if (ring_out) |ptr| @intFromPtr(ptr) else 0;
+    const result = syscall(.io_ring_setup, ring_out_ptr, flags, 0, 0);
+    return @as(i64, @bitCast(result));
+}
+
+/// Run queued submissions of a ring (completions appear in its CQ).
+/// Contract:
+///   Input: max_submit bounds the submissions run (0: all queued)
+///   Output: Returns submissions consumed (fewer if the CQ filled up), or negative error code
+///   Errors: Invalid handle, invalid argument (corrupt ring counters)
+/// Why: One trap for the whole batch.
+pub fn io_ring_enter(ring: u64, max_submit: u32) i64 {
+    const result = syscall(.io_ring_enter, ring, max_submit, 0, 0);
+    return @as(i64, @bitCast(result));
+}
+
+/// Clocks for clock_gettime (must match kernel/basin_kernel.zig ClockId).
+pub const ClockId = enum(u32) {
+    /// Time since boot (never jumps).
+    monotonic = 0,
+    /// Wall-clock time (nanoseconds since the Unix epoch, as set by the host).
+    realtime = 1,
+};
+
+/// Time as whole seconds plus nanoseconds (the clock_gettime result layout).
+pub const Timespec = extern struct {
+    seconds: u64,
+    nanoseconds: u64,
+};
+
+/// System information (uptime_ns is the monotonic clock).
+pub const SysInfo = struct {
+    total_memory: u64,
+    available_memory: u64,
+    cpu_cores: u32,
+    uptime_ns: u64,
+    load_avg_1min: u32,
+};
+
+/// Shared time page address and magic (must match kernel/time_page.zig).
+pub const TIME_PAGE_ADDRESS: u64 = 0xFF000;
+const TIME_PAGE_MAGIC: u32 = 0x454D_4954;
+
+/// Kernel-maintained read-only page (must match kernel/time_page.zig Page).
+/// Why: Time and system info cost a few loads and an rdtime instead of an ecall.
+/// Contract: Read only through read_time_page (the kernel rewrites it under a seqlock).
+pub const TimePage = extern struct {
+    magic: u32,
+    /// Odd while the kernel rewrites the page.
+    sequence: u32,
+    ticks_per_second: u64,
+    realtime_base_ns: u64,
+    total_memory: u64,
+    available_memory: u64,
+    cpu_cores: u32,
+    load_avg_1min: u32,
+};
+
+/// Consistent copy of the time page (retries while the kernel is rewriting it).
+/// Returns: null if the kernel has not published the page.
+pub fn read_time_page() ?TimePage {
+    const page: *const TimePage = @ptrFromInt(TIME_PAGE_ADDRESS);
+    while (true) {
+        const before = @atomicLoad(u32, &page.sequence, .acquire);
+        if (before % 2 != 0) continue;
+        // Acquire loads: the sequence re-check cannot be hoisted above the fields.
+        const copy = TimePage{
+            .magic = @atomicLoad(u32, &page.magic, .acquire),
+            .sequence = before,
+            .ticks_per_second = @atomicLoad(u64, &page.ticks_per_second, .acquire),
+            .realtime_base_ns = @atomicLoad(u64, &page.realtime_base_ns, .acquire),
+            .total_memory = @atomicLoad(u64, &page.total_memory, .acquire),
+            .available_memory = @atomicLoad(u64, &page.available_memory, .acquire),
+            .cpu_cores = @atomicLoad(u32, &page.cpu_cores, .acquire),
+            .load_avg_1min = @atomicLoad(u32, &page.load_avg_1min, .acquire),
+        };
+        if (@atomicLoad(u32, &page.sequence, .monotonic) != before) continue;
+        if (copy.magic != TIME_PAGE_MAGIC or copy.ticks_per_second == 0) return null;
+        return copy;
+    }
+}
+
+/// Guest timebase (the time CSR).
+fn rdtime() u64 {
+    return asm volatile ("rdtime %[ret]"
+        : [ret] "=r" (-> u64),
+    );
+}
+
+/// Nanoseconds in ticks of a ticks_per_second timebase (kernel/time_page.zig ticks_to_ns).
+fn ticks_to_ns(ticks: u64, ticks_per_second: u64) u64 {
+    const seconds = ticks / ticks_per_second;
+    const remainder = ticks % ticks_per_second;
+    return seconds * 1_000_000_000 + remainder * 1_000_000_000 / ticks_per_second;
+}
+
+/// Current time of a clock.
+/// Contract:
+///   Input: clock is monotonic or realtime
+///   Output: Returns the time (zero if neither the time page nor the syscall answers)
+/// Why: z6 polls the clock constantly (restart back-off); the time page makes that a
+/// few loads. Falls back to the clock_gettime syscall if the page is not published.
+pub fn clock_gettime(clock: ClockId) Timespec {
+    var ts = Timespec{ .seconds = 0, .nanoseconds = 0 };
+    const page = read_time_page() orelse {
+        _ = syscall(.clock_gettime, @intFromEnum(clock), @intFromPtr(&ts), 0, 0);
+        return ts;
+    };
+    const monotonic = ticks_to_ns(rdtime(), page.ticks_per_second);
+    const now_ns = switch (clock) {
+        .monotonic => monotonic,
+        .realtime => page.realtime_base_ns +| monotonic,
+    };
+    ts.seconds = now_ns / 1_000_000_000;
+    ts.nanoseconds = now_ns % 1_000_000_000;
+    return ts;
+}
+
+/// System information from the time page (no syscall).
+/// Returns: null if the kernel has not published the page.
+pub fn sysinfo() ?SysInfo {
+    const page = read_time_page() orelse return null;
+    return SysInfo{
+        .total_memory = page.total_memory,
+        .available_memory = page.available_memory,
+        .cpu_cores = page.cpu_cores,
+        .uptime_ns = ticks_to_ns(rdtime(), page.ticks_per_second),
+        .load_avg_1min = page.load_avg_1min,
+    };
+}
+
+/// Log2 histogram buckets and error slots per syscall (must match kernel/syscall_stats.zig).
+pub const SYSCALL_STATS_BUCKETS: usize = 32;
+pub const SYSCALL_STATS_ERROR_SLOTS: usize = 16;
+
+/// One syscall's counters (must match kernel/syscall_stats.zig Record).
+/// Note: Bucket 0 counts zero, bucket b values in [2^(b-1), 2^b).
+pub const SyscallStats = extern struct {
+    calls: u64,
+    /// errors[i] counts error code -(i + 1).
+    errors: [SYSCALL_STATS_ERROR_SLOTS]u64,
+    /// Guest instructions from the syscall until the caller ran again.
+    guest_instructions: [SYSCALL_STATS_BUCKETS]u64,
+    /// Host nanoseconds in the kernel (one call in 16 is timed).
+    host_ns: [SYSCALL_STATS_BUCKETS]u64,
+};
+
+/// Kernel statistics for one syscall (the extended sysinfo syscall).
+/// Contract:
+///   Input: out receives the record
+///   Output: Returns true if out holds live counters; false if the kernel was built
+///           without -Dkernel-stats=true (out is zeroed) or the call failed
+/// Why: Guests (and the Tahoe UI through them) see where kernel time goes.
+pub fn syscall_stats(of: Syscall, out: *SyscallStats) bool {
+    const result = syscall(.sysinfo, 0, @intFromEnum(of), @intFromPtr(out), 0);
+    return result == 1;
+}
+
 /// Open a file.
 /// Contract:
 ///   Input: path must be null-terminated string, flags must be valid
@@ -624,3 +624,103 @@ test "006_fuzz_state_consistency" {
     }
 }
 
+
+test "006_fuzz_map_churn_reuses_space" {
+    // Test Category 8: Mapping Churn
+    // Objective: Validate unmapped ranges are coalesced and reused by kernel-chosen maps.
+    
+    var rng = SimpleRng.init(0x006F00F100000008);
+    var kernel = BasinKernel.init();
+    const flags = MapFlags.init(.{ .read = true, .write = true });
+    const flags_arg = @as(u64, @as(u32, @bitCast(flags)));
+    
+    // Three adjacent one-page mappings; freeing the middle one leaves a hole that is reused.
+    var pages: [3]u64 = undefined;
+    for (&pages) |*page| {
+        page.* = (try kernel.handle_syscall(@intFromEnum(Syscall.map), 0, 4096, flags_arg, 0)).success;
+    }
+    std.debug.assert(pages[1] == pages[0] + 4096 and pages[2] == pages[1] + 4096);
+    _ = try kernel.handle_syscall(@intFromEnum(Syscall.unmap), pages[1], 0, 0, 0);
+    std.debug.assert(kernel.mapping_flags_at(pages[1] + 100) == null);
+    const reused = try kernel.handle_syscall(@intFromEnum(Syscall.map), 0, 4096, flags_arg, 0);
+    std.debug.assert(reused.success == pages[1]);
+    std.debug.assert(kernel.mapping_flags_at(pages[1] + 100).?.write);
+    
+    // Freeing all three coalesces them: a three-page mapping fits at the same base.
+    for (pages) |page| {
+        _ = try kernel.handle_syscall(@intFromEnum(Syscall.unmap), page, 0, 0, 0);
+    }
+    const joined = try kernel.handle_syscall(@intFromEnum(Syscall.map), 0, 3 * 4096, flags_arg, 0);
+    std.debug.assert(joined.success == pages[0]);
+    _ = try kernel.handle_syscall(@intFromEnum(Syscall.unmap), joined.success, 0, 0, 0);
+    
+    // Churn far more address space than the VM has (a bump allocator runs out).
+    var live: [64]u64 = [_]u64{0} ** 64;
+    var i: u32 = 0;
+    while (i < 20_000) : (i += 1) {
+        const slot = rng.range(usize, live.len);
+        if (live[slot] != 0) {
+            _ = try kernel.handle_syscall(@intFromEnum(Syscall.unmap), live[slot], 0, 0, 0);
+            live[slot] = 0;
+        } else {
+            const size = (1 + rng.range(u64, 4)) * 4096;
+            const result = try kernel.handle_syscall(@intFromEnum(Syscall.map), 0, size, flags_arg, 0);
+            live[slot] = result.success;
+        }
+    }
+    
+    // Assert: Index must agree with the table after churn.
+    var live_count: u32 = 0;
+    for (live) |addr| {
+        if (addr != 0) live_count += 1;
+    }
+    std.debug.assert(kernel.count_allocated_mappings() == live_count);
+}
+
+test "006_fuzz_map_first_fit_after_fragmentation" {
+    // Test Category 9: Fragmented Address Space
+    // Objective: Validate slot reuse at a full table and lowest-address first fit among many holes.
+    
+    var kernel = BasinKernel.init();
+    const flags = MapFlags.init(.{ .read = true, .write = true });
+    const flags_arg = @as(u64, @as(u32, @bitCast(flags)));
+    
+    // Fill the table with adjacent one-page mappings; one more needs a slot that is not there.
+    var pages: [256]u64 = undefined;
+    for (&pages, 0..) |*page, i| {
+        page.* = (try kernel.handle_syscall(@intFromEnum(Syscall.map), 0, 4096, flags_arg, 0)).success;
+        if (i > 0) std.debug.assert(page.* == pages[i - 1] + 4096);
+    }
+    std.debug.assert(kernel.count_allocated_mappings() == 256);
+    if (kernel.handle_syscall(@intFromEnum(Syscall.map), 0, 4096, flags_arg, 0)) |_| {
+        unreachable;
+    } else |err| {
+        std.debug.assert(err == BasinError.out_of_memory);
+    }
+    
+    // Free every other page: 128 one-page holes, each reusable once a slot is free.
+    var i: usize = 0;
+    while (i < pages.len) : (i += 2) {
+        _ = try kernel.handle_syscall(@intFromEnum(Syscall.unmap), pages[i], 0, 0, 0);
+    }
+    std.debug.assert(kernel.count_allocated_mappings() == 128);
+    
+    // Two pages fit only above the last mapping; one page takes the lowest hole.
+    const wide = try kernel.handle_syscall(@intFromEnum(Syscall.map), 0, 2 * 4096, flags_arg, 0);
+    std.debug.assert(wide.success == pages[255] + 4096);
+    const narrow = try kernel.handle_syscall(@intFromEnum(Syscall.map), 0, 4096, flags_arg, 0);
+    std.debug.assert(narrow.success == pages[0]);
+    
+    // Freeing a page between two holes coalesces all three into one range.
+    _ = try kernel.handle_syscall(@intFromEnum(Syscall.unmap), pages[3], 0, 0, 0);
+    const joined = try kernel.handle_syscall(@intFromEnum(Syscall.map), 0, 3 * 4096, flags_arg, 0);
+    std.debug.assert(joined.success == pages[2]);
+    
+    // Nothing larger than the remaining space fits.
+    if (kernel.handle_syscall(@intFromEnum(Syscall.map), 0, basin_kernel.DEFAULT_USER_MEMORY_SIZE, flags_arg, 0)) |_| {
+        unreachable;
+    } else |err| {
+        std.debug.assert(err == BasinError.out_of_memory);
+    }
+    std.debug.assert(kernel.count_allocated_mappings() == 130);
+}
@@ -159,7 +159,7 @@ test "007_fuzz_read_operations" {
     var i: u32 = 0;
     while (i < 32) : (i += 1) {
         const path_len = generate_path_len(&rng);
-        const flags = OpenFlags.init(.{ .read = true, .write = rng.boolean() });
+        const flags = OpenFlags.init(.{ .read = true, .write = rng.boolean(), .create = true });
         const path_ptr: u64 = 0x1000; // Dummy pointer
         
         const result = kernel.handle_syscall(
@@ -241,7 +241,7 @@ test "007_fuzz_write_operations" {
     var i: u32 = 0;
     while (i < 32) : (i += 1) {
         const path_len = generate_path_len(&rng);
-        const flags = OpenFlags.init(.{ .write = true, .read = rng.boolean() });
+        const flags = OpenFlags.init(.{ .write = true, .read = rng.boolean(), .create = true });
         const path_ptr: u64 = 0x1000; // Dummy pointer
         
         const result = kernel.handle_syscall(
@@ -323,7 +323,7 @@ test "007_fuzz_close_operations" {
     var i: u32 = 0;
     while (i < 64) : (i += 1) {
         const path_len = generate_path_len(&rng);
-        const flags = OpenFlags.init(.{ .read = true, .write = true });
+        const flags = OpenFlags.init(.{ .read = true, .write = true, .create = true });
         const path_ptr: u64 = 0x1000; // Dummy pointer
         
         const result = kernel.handle_syscall(
@@ -427,7 +427,7 @@ test "007_fuzz_table_exhaustion" {
     
     while (i < 100) : (i += 1) {
         const path_len = generate_path_len(&rng);
-        const flags = OpenFlags.init(.{ .read = true, .write = true });
+        const flags = OpenFlags.init(.{ .read = true, .write = true, .create = true });
         const path_ptr: u64 = 0x1000; // Dummy pointer
         
         const result = kernel.handle_syscall(
@@ -567,7 +567,7 @@ test "007_fuzz_edge_cases" {
     
     // Edge case 5: Read from write-only handle.
     {
-        const flags = OpenFlags.init(.{ .write = true, .read = false });
+        const flags = OpenFlags.init(.{ .write = true, .read = false, .create = true });
         const path_ptr: u64 = 0x1000;
         const path_len: u64 = 10;
         
@@ -607,7 +607,7 @@ test "007_fuzz_edge_cases" {
     
     // Edge case 6: Write to read-only handle.
     {
-        const flags = OpenFlags.init(.{ .read = true, .write = false });
+        const flags = OpenFlags.init(.{ .read = true, .write = false, .create = true });
         const path_ptr: u64 = 0x1000;
         const path_len: u64 = 10;
         
@@ -665,7 +665,7 @@ test "007_fuzz_state_consistency" {
             // Open operation.
             if (handle_count < 64) {
                 const path_len = generate_path_len(&rng);
-                const flags = OpenFlags.init(.{ .read = true, .write = true });
+                const flags = OpenFlags.init(.{ .read = true, .write = true, .create = true });
                 const path_ptr: u64 = 0x1000;
                 
                 const result = kernel.handle_syscall(
@@ -745,3 +745,59 @@ test "007_fuzz_state_consistency" {
     }
 }
 
+
+test "007_fuzz_stale_handles" {
+    // Test Category 8: Stale Handle Fuzzing
+    // Objective: Validate that closed handle IDs stay invalid after their slots are reused.
+    
+    std.debug.print("[test] Starting 007_fuzz_stale_handles\n", .{});
+    var rng = SimpleRng.init(0x007F00F100000008);
+    var kernel = BasinKernel.init();
+    const flags = OpenFlags.init(.{ .read = true, .write = true, .create = true });
+    
+    var open_handles: [64]u64 = undefined;
+    var open_count: u32 = 0;
+    var stale_handles: [256]u64 = undefined;
+    var stale_count: u32 = 0;
+    
+    var i: u32 = 0;
+    while (i < 2000) : (i += 1) {
+        if (open_count < 64 and (open_count == 0 or rng.boolean())) {
+            const result = try kernel.handle_syscall(@intFromEnum(Syscall.open), 0x1000, generate_path_len(&rng), @as(u64, @as(u32, @bitCast(flags))), 0);
+            const handle = result.success;
+            
+            // Assert: A fresh ID must not collide with any stale ID still tracked.
+            for (stale_handles[0..stale_count]) |stale| {
+                std.debug.assert(stale != handle);
+            }
+            open_handles[open_count] = handle;
+            open_count += 1;
+        } else {
+            const handle_idx = rng.range(u32, open_count);
+            const handle = open_handles[handle_idx];
+            const result = try kernel.handle_syscall(@intFromEnum(Syscall.close), handle, 0, 0, 0);
+            std.debug.assert(result == .success);
+            
+            open_count -= 1;
+            open_handles[handle_idx] = open_handles[open_count];
+            if (stale_count < stale_handles.len) {
+                stale_handles[stale_count] = handle;
+                stale_count += 1;
+            }
+        }
+        
+        // Assert: Any stale ID must be rejected (read and close both see invalid_handle).
+        if (stale_count > 0) {
+            const stale = stale_handles[rng.range(u32, stale_count)];
+            const read = try kernel.handle_syscall(@intFromEnum(Syscall.read), stale, 0x2000, 16, 0);
+            std.debug.assert(read == .err and read.err == BasinError.invalid_handle);
+            const close = try kernel.handle_syscall(@intFromEnum(Syscall.close), stale, 0, 0, 0);
+            std.debug.assert(close == .err and close.err == BasinError.invalid_handle);
+        }
+        
+        // Assert: Handle count must match kernel state.
+        std.debug.assert(kernel.count_allocated_handles() == open_count);
+    }
+    
+    std.debug.assert(stale_count > 0);
+}
@@ -11,6 +11,34 @@ const basin_kernel = @import("basin_kernel");
 const BasinKernel = basin_kernel.BasinKernel;
 const Syscall = basin_kernel.Syscall;
 
+/// VM, kernel and integration for a test (heap-allocated: both are too large for the stack).
+/// The VM runs program at 0x1000; pair with teardown_integration.
+const Setup = struct {
+    vm: *VM,
+    kernel: *BasinKernel,
+    integration: Integration,
+};
+
+fn setup_integration(program: []const u8) !Setup {
+    const vm = try testing.allocator.create(VM);
+    errdefer testing.allocator.destroy(vm);
+    try VM.init(vm, program, 0x1000);
+    errdefer vm.deinit();
+    const kernel = try testing.allocator.create(BasinKernel);
+    kernel.* = BasinKernel.init();
+
+    var integration = Integration.init_with_kernel(vm, kernel);
+    integration.finish_init();
+    return .{ .vm = vm, .kernel = kernel, .integration = integration };
+}
+
+fn teardown_integration(setup: *Setup) void {
+    setup.integration.cleanup();
+    testing.allocator.destroy(setup.kernel);
+    setup.vm.deinit();
+    testing.allocator.destroy(setup.vm);
+}
+
 test "Integration: VM and kernel initialization" {
     // Test that we can initialize VM and kernel separately
     // This validates the basic setup without requiring full integration
@@ -20,7 +48,8 @@ test "Integration: VM and kernel initialization" {
         0x13, 0x00, 0x00, 0x00, // ADDI x0, x0, 0 (NOP)
     };
     var vm: VM = undefined;
-    VM.init(&vm, &minimal_program, 0x1000);
+    try VM.init(&vm, &minimal_program, 0x1000);
+    defer vm.deinit();
     
     // Verify VM initialized correctly
     try testing.expect(vm.state == .halted);
@@ -83,10 +112,8 @@ fn syscall_test_handler(
 
 test "Integration: Syscall handler contract validation" {
     // Test that syscall handler correctly converts SyscallResult to u64
-    // Note: handle_syscall has assertion syscall_num >= 10
-    // This means it only accepts kernel syscalls (map=10, unmap=11, etc.)
-    // Process management syscalls (spawn=1, exit=2, etc.) are < 10 and handled differently
-    // TODO: Fix design mismatch - kernel should accept enum values directly
+    // Note: Kernel syscalls are numbered >= 10 (guest ECALLs below 10 are SBI calls),
+    // including the process syscalls (spawn=70, exit=71, yield=72, wait=73)
     
     var kernel = BasinKernel.init();
     
@@ -114,11 +141,43 @@ test "Integration: Syscall handler contract validation" {
     _ = map_result;
 }
 
+test "Integration: Unknown syscall numbers from the guest return invalid_syscall" {
+    // a7 is guest-controlled: numbers past the table, and ones too wide for u32, must come
+    // back as an error in a0 (not truncated into a valid number, not a host panic).
+    var setup = try setup_integration(&[_]u8{ 0x73, 0x00, 0x00, 0x00 }); // ecall
+    defer teardown_integration(&setup);
+    const vm = setup.vm;
+    const kernel = setup.kernel;
+
+    const invalid: u64 = @bitCast(@as(i64, -8)); // invalid_syscall
+    const numbers = [_]u64{ basin_kernel.SYSCALL_MAX + 1, 0xFFFF_FFFF, @as(u64, 0x1_0000_0000) + @intFromEnum(Syscall.map), std.math.maxInt(u64) };
+    for (numbers) |number| {
+        vm.regs.pc = 0x1000;
+        vm.regs.set(17, number);
+        vm.start();
+        try vm.step();
+        try testing.expect(vm.state == .running);
+        try testing.expectEqual(invalid, vm.regs.get(10));
+    }
+
+    // Unknown SBI extension IDs (below 10) come back NotSupported.
+    vm.regs.pc = 0x1000;
+    vm.regs.set(17, 9);
+    vm.start();
+    try vm.step();
+    try testing.expect(vm.state == .running);
+    try testing.expectEqual(@as(u64, @bitCast(@as(i64, -2))), vm.regs.get(10));
+
+    // Unknown clock ids are refused the same way.
+    try testing.expectError(basin_kernel.BasinError.invalid_argument, kernel.handle_syscall(@intFromEnum(Syscall.clock_gettime), 0x1_0000_0000, 0x2000, 0, 0));
+}
+
 test "Integration: VM memory access with new instructions" {
     // Test that new load/store instructions work correctly
     // Use VM's read64/write64 to verify memory operations work
     var vm: VM = undefined;
-    VM.init(&vm, &[_]u8{0} ** 1024, 0x1000);
+    try VM.init(&vm, &[_]u8{0} ** 1024, 0x1000);
+    defer vm.deinit();
     
     // Write test value to memory using VM's write64
     const test_addr: u64 = 0x2000;
@@ -138,7 +197,8 @@ test "Integration: JAL instruction (function calls)" {
     // Detailed instruction encoding tests are in kernel_vm_test
     // This test just verifies the instruction decoder recognizes JAL opcode
     var vm: VM = undefined;
-    VM.init(&vm, &[_]u8{0} ** 1024, 0x1000);
+    try VM.init(&vm, &[_]u8{0} ** 1024, 0x1000);
+    defer vm.deinit();
     
     // Place a JAL instruction: JAL x0, 0 (no-op jump, x0 discards return address)
     // Opcode 1101111 = 0x6F, with rd=0, imm=0
@@ -161,7 +221,8 @@ test "Integration: Branch instructions" {
     // Detailed instruction encoding tests are in kernel_vm_test
     // This test just verifies the instruction decoder recognizes branch opcode
     var vm: VM = undefined;
-    VM.init(&vm, &[_]u8{0} ** 1024, 0x1000);
+    try VM.init(&vm, &[_]u8{0} ** 1024, 0x1000);
+    defer vm.deinit();
     
     // Place a BEQ instruction: BEQ x0, x0, 0 (always taken, but x0 == x0)
     // Opcode 1100011 = 0x63, with rs1=0, rs2=0, funct3=000 (BEQ), imm=0
@@ -179,3 +240,788 @@ test "Integration: Branch instructions" {
     try testing.expect(vm.state != .errored);
 }
 
+
+test "Integration: Snapshot restores VM memory and kernel tables" {
+    // Boot-once harness pattern: snapshot, mutate, restore (TigerStyle: heap VM and kernel).
+    var setup = try setup_integration(&[_]u8{ 0x13, 0x00, 0x00, 0x00 });
+    defer teardown_integration(&setup);
+    const vm = setup.vm;
+    const kernel = setup.kernel;
+    const integration = &setup.integration;
+
+    // A file whose one page is resident in the page cache at snapshot time.
+    const open = @intFromEnum(Syscall.open);
+    const rw = basin_kernel.OpenFlags.init(.{ .read = true, .write = true, .create = true });
+    try vm.write_memory(0x5000, "snap.dat");
+    try vm.write_memory(0x5100, "before");
+    const file = (try kernel.handle_syscall(open, 0x5000, 8, @as(u32, @bitCast(rw)), 0)).success;
+    _ = try kernel.handle_syscall(@intFromEnum(Syscall.write), file, 0x5100, 6, 0);
+    _ = try kernel.handle_syscall(@intFromEnum(Syscall.close), file, 0, 0, 0);
+
+    var snap = try integration.snapshot(testing.allocator);
+    defer snap.deinit(testing.allocator);
+
+    // Mutate guest RAM, registers, kernel tables and file pages.
+    try vm.write64(0x2000, 0xDEADBEEFCAFEBABE);
+    try vm.write_memory(0x3000, "fuzz input");
+    vm.regs.set(10, 42);
+    const map_flags = basin_kernel.MapFlags.init(.{ .read = true });
+    _ = try kernel.handle_syscall(@intFromEnum(Syscall.map), 0, 4096, @as(u32, @bitCast(map_flags)), 0);
+    try testing.expect(kernel.handles.alloc() != null);
+    try vm.write_memory(0x5100, "after!");
+    const overwrite = (try kernel.handle_syscall(open, 0x5000, 8, @as(u32, @bitCast(rw)), 0)).success;
+    _ = try kernel.handle_syscall(@intFromEnum(Syscall.write), overwrite, 0x5100, 6, 0);
+
+    integration.restore(&snap);
+    try testing.expect(try vm.read64(0x2000) == 0);
+    try testing.expect(vm.memory[0x3000] == 0);
+    try testing.expect(vm.regs.get(10) == 0);
+    try testing.expect(vm.regs.pc == 0x1000);
+    try testing.expect(kernel.count_allocated_mappings() == 0);
+    try testing.expect(kernel.count_allocated_handles() == 0);
+
+    // Resident pages come back with the tables (the copy skips only free cache slots).
+    try testing.expectEqual(@as(u32, 1), kernel.page_cache.resident());
+    const ro = basin_kernel.OpenFlags.init(.{ .read = true });
+    const reader = (try kernel.handle_syscall(open, 0x5000, 8, @as(u32, @bitCast(ro)), 0)).success;
+    try testing.expectEqual(@as(u64, 6), (try kernel.handle_syscall(@intFromEnum(Syscall.read), reader, 0x5200, 16, 0)).success);
+    try testing.expectEqualSlices(u8, "before", vm.memory[0x5200..][0..6]);
+}
+
+test "Integration: Vectored I/O moves bytes through guest memory" {
+    // write gathers from guest RAM, readv scatters back; kernel stores are dirty-tracked.
+    var setup = try setup_integration(&[_]u8{ 0x13, 0x00, 0x00, 0x00 });
+    defer teardown_integration(&setup);
+    const vm = setup.vm;
+    const kernel = setup.kernel;
+    const integration = &setup.integration;
+
+    var snap = try integration.snapshot(testing.allocator);
+    defer snap.deinit(testing.allocator);
+
+    const flags = basin_kernel.OpenFlags.init(.{ .read = true, .write = true, .create = true });
+    const opened = try kernel.handle_syscall(@intFromEnum(Syscall.open), 0x1000, 5, @as(u32, @bitCast(flags)), 0);
+    const handle = opened.success;
+
+    // Gather two guest buffers into the file.
+    try vm.write_memory(0x3000, "hello, ");
+    try vm.write_memory(0x3100, "basin");
+    var iovs: [2]basin_kernel.IoVec = .{
+        .{ .base = 0x3000, .len = 7 },
+        .{ .base = 0x3100, .len = 5 },
+    };
+    try vm.write_memory(0x4000, std.mem.asBytes(&iovs));
+    const written = try kernel.handle_syscall(@intFromEnum(Syscall.writev), handle, 0x4000, 2, 0);
+    try testing.expectEqual(@as(u64, 12), written.success);
+
+    // Rewind (no seek syscall yet), then scatter the file into two fresh buffers.
+    const handle_idx: u32 = @intCast((handle & 0xFFFFFFFF) - 1);
+    kernel.handles.entries[handle_idx].position = 0;
+    iovs = .{
+        .{ .base = 0x5000, .len = 4 },
+        .{ .base = 0x6000, .len = 64 },
+    };
+    try vm.write_memory(0x4000, std.mem.asBytes(&iovs));
+    const read = try kernel.handle_syscall(@intFromEnum(Syscall.readv), handle, 0x4000, 2, 0);
+    try testing.expectEqual(@as(u64, 12), read.success);
+    try testing.expectEqualStrings("hell", vm.memory[0x5000..][0..4]);
+    try testing.expectEqualStrings("o, basin", vm.memory[0x6000..][0..8]);
+
+    // Plain read continues from the file position (end of file: nothing left).
+    const tail = try kernel.handle_syscall(@intFromEnum(Syscall.read), handle, 0x7000, 16, 0);
+    try testing.expectEqual(@as(u64, 0), tail.success);
+
+    // An iovec outside guest RAM is rejected before any byte moves.
+    iovs[1].base = vm.memory_size - 8;
+    try vm.write_memory(0x4000, std.mem.asBytes(&iovs));
+    const bad = try kernel.handle_syscall(@intFromEnum(Syscall.readv), handle, 0x4000, 2, 0);
+    try testing.expect(bad == .err and bad.err == basin_kernel.BasinError.invalid_argument);
+
+    // Kernel stores are restored like guest stores.
+    integration.restore(&snap);
+    try testing.expect(vm.memory[0x5000] == 0);
+    try testing.expect(vm.memory[0x6000] == 0);
+}
+
+/// Write-back store for one inode's first 32 pages (page cache eviction test).
+const TestBacking = struct {
+    pages: [32][basin_kernel.page_cache.PAGE_SIZE]u8 = undefined,
+    stored: [32]bool = [_]bool{false} ** 32,
+    stores: u32 = 0,
+
+    fn load(context: ?*anyopaque, inode: u32, index: u32, page: *[basin_kernel.page_cache.PAGE_SIZE]u8) bool {
+        const self: *TestBacking = @ptrCast(@alignCast(context.?));
+        _ = inode;
+        if (index >= 32 or !self.stored[index]) return false;
+        page.* = self.pages[index];
+        return true;
+    }
+
+    fn store(context: ?*anyopaque, inode: u32, index: u32, page: *const [basin_kernel.page_cache.PAGE_SIZE]u8) void {
+        const self: *TestBacking = @ptrCast(@alignCast(context.?));
+        _ = inode;
+        std.debug.assert(index < 32);
+        self.pages[index] = page.*;
+        self.stored[index] = true;
+        self.stores += 1;
+    }
+
+    fn discard(context: ?*anyopaque, inode: u32, from: u32) void {
+        const self: *TestBacking = @ptrCast(@alignCast(context.?));
+        _ = inode;
+        for (self.stored[@min(from, 32)..]) |*stored| stored.* = false;
+    }
+};
+
+test "Integration: Files share cached pages across handles" {
+    // Two handles on one path see the same bytes; files outgrow the old 64KB handle buffer.
+    var setup = try setup_integration(&[_]u8{ 0x13, 0x00, 0x00, 0x00 });
+    defer teardown_integration(&setup);
+    const vm = setup.vm;
+    const kernel = setup.kernel;
+
+    const size: usize = 80 * 1024;
+    for (vm.memory[0x10000..][0..size], 0..) |*byte, i| byte.* = @truncate(i *% 31);
+    try vm.write_memory(0x2000, "basin.dat");
+
+    const rw = basin_kernel.OpenFlags.init(.{ .read = true, .write = true, .create = true });
+    const ro = basin_kernel.OpenFlags.init(.{ .read = true });
+    const writer = (try kernel.handle_syscall(@intFromEnum(Syscall.open), 0x2000, 9, @as(u32, @bitCast(rw)), 0)).success;
+    const reader = (try kernel.handle_syscall(@intFromEnum(Syscall.open), 0x2000, 9, @as(u32, @bitCast(ro)), 0)).success;
+
+    const written = try kernel.handle_syscall(@intFromEnum(Syscall.write), writer, 0x10000, size, 0);
+    try testing.expectEqual(@as(u64, size), written.success);
+    const read = try kernel.handle_syscall(@intFromEnum(Syscall.read), reader, 0x40000, size, 0);
+    try testing.expectEqual(@as(u64, size), read.success);
+    try testing.expectEqualSlices(u8, vm.memory[0x10000..][0..size], vm.memory[0x40000..][0..size]);
+
+    // Unlink removes the name; the open reader keeps the data until it closes.
+    const unlinked = try kernel.handle_syscall(@intFromEnum(Syscall.unlink), 0x2000, 9, 0, 0);
+    try testing.expect(unlinked == .success);
+    const reader_idx: u32 = @intCast((reader & 0xFFFFFFFF) - 1);
+    kernel.handles.entries[reader_idx].position = 0;
+    const reread = try kernel.handle_syscall(@intFromEnum(Syscall.read), reader, 0x40000, 16, 0);
+    try testing.expectEqual(@as(u64, 16), reread.success);
+    _ = try kernel.handle_syscall(@intFromEnum(Syscall.close), writer, 0, 0, 0);
+    _ = try kernel.handle_syscall(@intFromEnum(Syscall.close), reader, 0, 0, 0);
+    try testing.expectEqual(@as(u32, 0), kernel.page_cache.resident());
+
+    // Without a backing store a full budget is an error: first a short write, then out_of_memory.
+    kernel.page_cache.set_budget(4);
+    const full = (try kernel.handle_syscall(@intFromEnum(Syscall.open), 0x2000, 9, @as(u32, @bitCast(rw)), 0)).success;
+    const partial = try kernel.handle_syscall(@intFromEnum(Syscall.write), full, 0x10000, size, 0);
+    try testing.expectEqual(@as(u64, 4 * 4096), partial.success);
+    const refused = try kernel.handle_syscall(@intFromEnum(Syscall.write), full, 0x10000, size, 0);
+    try testing.expect(refused == .err and refused.err == basin_kernel.BasinError.out_of_memory);
+    _ = try kernel.handle_syscall(@intFromEnum(Syscall.unlink), 0x2000, 9, 0, 0);
+    _ = try kernel.handle_syscall(@intFromEnum(Syscall.close), full, 0, 0, 0);
+    try testing.expectEqual(@as(u32, 0), kernel.page_cache.resident());
+
+    // With a backing store a small budget evicts least recently used pages and reloads them.
+    var backing = TestBacking{};
+    kernel.page_cache.backing = .{
+        .context = &backing,
+        .load = TestBacking.load,
+        .store = TestBacking.store,
+        .discard = TestBacking.discard,
+    };
+    kernel.page_cache.set_budget(4);
+    const file = (try kernel.handle_syscall(@intFromEnum(Syscall.open), 0x2000, 9, @as(u32, @bitCast(rw)), 0)).success;
+    const spilled = try kernel.handle_syscall(@intFromEnum(Syscall.write), file, 0x10000, size, 0);
+    try testing.expectEqual(@as(u64, size), spilled.success);
+    try testing.expect(kernel.page_cache.resident() <= 4);
+    try testing.expect(backing.stores > 0);
+    const file_idx: u32 = @intCast((file & 0xFFFFFFFF) - 1);
+    kernel.handles.entries[file_idx].position = 0;
+    @memset(vm.memory[0x40000..][0..size], 0);
+    const reloaded = try kernel.handle_syscall(@intFromEnum(Syscall.read), file, 0x40000, size, 0);
+    try testing.expectEqual(@as(u64, size), reloaded.success);
+    try testing.expectEqualSlices(u8, vm.memory[0x10000..][0..size], vm.memory[0x40000..][0..size]);
+}
+
+test "Integration: Open creates only with the create flag and truncates only with write" {
+    var setup = try setup_integration(&[_]u8{ 0x13, 0x00, 0x00, 0x00 });
+    defer teardown_integration(&setup);
+    const vm = setup.vm;
+    const kernel = setup.kernel;
+    const open = @intFromEnum(Syscall.open);
+    try vm.write_memory(0x2000, "basin.dat");
+    try vm.write_memory(0x3000, "data");
+
+    // A missing file is not_found without create, and no handle or inode is left behind.
+    const ro = basin_kernel.OpenFlags.init(.{ .read = true });
+    const missing = try kernel.handle_syscall(open, 0x2000, 9, @as(u32, @bitCast(ro)), 0);
+    try testing.expect(missing == .err and missing.err == basin_kernel.BasinError.not_found);
+    try testing.expectEqual(@as(u32, 0), kernel.count_allocated_handles());
+
+    const create = basin_kernel.OpenFlags.init(.{ .write = true, .create = true });
+    const writer = (try kernel.handle_syscall(open, 0x2000, 9, @as(u32, @bitCast(create)), 0)).success;
+    try testing.expectEqual(@as(u64, 4), (try kernel.handle_syscall(@intFromEnum(Syscall.write), writer, 0x3000, 4, 0)).success);
+    _ = try kernel.handle_syscall(@intFromEnum(Syscall.close), writer, 0, 0, 0);
+
+    // Truncate without write is refused and leaves the data alone.
+    const read_truncate = basin_kernel.OpenFlags.init(.{ .read = true, .truncate = true });
+    const refused = try kernel.handle_syscall(open, 0x2000, 9, @as(u32, @bitCast(read_truncate)), 0);
+    try testing.expect(refused == .err and refused.err == basin_kernel.BasinError.invalid_argument);
+    const reader = (try kernel.handle_syscall(open, 0x2000, 9, @as(u32, @bitCast(ro)), 0)).success;
+    try testing.expectEqual(@as(u64, 4), (try kernel.handle_syscall(@intFromEnum(Syscall.read), reader, 0x4000, 16, 0)).success);
+    _ = try kernel.handle_syscall(@intFromEnum(Syscall.close), reader, 0, 0, 0);
+
+    // With write, truncate empties the file.
+    const write_truncate = basin_kernel.OpenFlags.init(.{ .read = true, .write = true, .truncate = true });
+    const truncated = (try kernel.handle_syscall(open, 0x2000, 9, @as(u32, @bitCast(write_truncate)), 0)).success;
+    try testing.expectEqual(@as(u64, 0), (try kernel.handle_syscall(@intFromEnum(Syscall.read), truncated, 0x4000, 16, 0)).success);
+    _ = try kernel.handle_syscall(@intFromEnum(Syscall.close), truncated, 0, 0, 0);
+}
+
+test "Integration: Channels copy small messages and move pages" {
+    // Inline messages round-trip through the guest ring; large ones hand over a mapping.
+    var setup = try setup_integration(&[_]u8{ 0x13, 0x00, 0x00, 0x00 });
+    defer teardown_integration(&setup);
+    const vm = setup.vm;
+    const kernel = setup.kernel;
+
+    const ring_layout = basin_kernel.channel_ring;
+    const BasinError = basin_kernel.BasinError;
+    const created = try kernel.handle_syscall(@intFromEnum(Syscall.channel_create), 0x2000, 0, 0, 0);
+    const chan = created.success;
+    const ring = try vm.read64(0x2000);
+    try testing.expect(ring != 0 and ring % 4096 == 0);
+    try testing.expectEqual(ring_layout.MAGIC, std.mem.readInt(u32, vm.memory[@intCast(ring)..][0..4], .little));
+
+    // Empty ring would block; the ring mapping cannot be unmapped while the channel exists.
+    try testing.expectError(BasinError.would_block, kernel.handle_syscall(@intFromEnum(Syscall.channel_recv), chan, 0x3000, 128, 0));
+    try testing.expectError(BasinError.permission_denied, kernel.handle_syscall(@intFromEnum(Syscall.unmap), ring, 0, 0, 0));
+
+    // Inline: bytes are copied out of the sender's buffer.
+    try vm.write_memory(0x3000, "ping");
+    _ = try kernel.handle_syscall(@intFromEnum(Syscall.channel_send), chan, 0x3000, 4, 0);
+    try vm.write_memory(0x3000, "XXXX");
+    const got = try kernel.handle_syscall(@intFromEnum(Syscall.channel_recv), chan, 0x3100, 128, 0x2008);
+    try testing.expectEqual(@as(u64, 4), got.success);
+    try testing.expectEqualStrings("ping", vm.memory[0x3100..][0..4]);
+    try testing.expectEqual(@as(u64, 0), try vm.read64(0x2008));
+
+    // A full ring would block.
+    var sent: u32 = 0;
+    while (sent < ring_layout.SLOTS) : (sent += 1) {
+        _ = try kernel.handle_syscall(@intFromEnum(Syscall.channel_send), chan, 0x3000, 4, 0);
+    }
+    try testing.expectError(BasinError.would_block, kernel.handle_syscall(@intFromEnum(Syscall.channel_send), chan, 0x3000, 4, 0));
+    while (sent > 0) : (sent -= 1) {
+        _ = try kernel.handle_syscall(@intFromEnum(Syscall.channel_recv), chan, 0x3100, 128, 0);
+    }
+
+    // Pages: a 64KB mapping changes hands without copying; it is locked while queued.
+    const rw = basin_kernel.MapFlags.init(.{ .read = true, .write = true });
+    const region = (try kernel.handle_syscall(@intFromEnum(Syscall.map), 0, 64 * 1024, @as(u32, @bitCast(rw)), 0)).success;
+    try vm.write_memory(region, "payload");
+    _ = try kernel.handle_syscall(@intFromEnum(Syscall.channel_send), chan, region, 64 * 1024, 0);
+    try testing.expectError(BasinError.permission_denied, kernel.handle_syscall(@intFromEnum(Syscall.unmap), region, 0, 0, 0));
+    try testing.expectError(BasinError.invalid_argument, kernel.handle_syscall(@intFromEnum(Syscall.channel_recv), chan, 0x3100, 128, 0));
+    const moved = try kernel.handle_syscall(@intFromEnum(Syscall.channel_recv), chan, 0x3100, 128, 0x2008);
+    try testing.expectEqual(@as(u64, 64 * 1024), moved.success);
+    try testing.expectEqual(region, try vm.read64(0x2008));
+    try testing.expectEqualStrings("payload", vm.memory[@intCast(region)..][0..7]);
+    _ = try kernel.handle_syscall(@intFromEnum(Syscall.unmap), region, 0, 0, 0);
+
+    // Userspace may produce directly into the ring; the kernel consumes the same slots.
+    const tail = std.mem.readInt(u32, vm.memory[@intCast(ring + ring_layout.TAIL_OFFSET)..][0..4], .little);
+    const slot = ring + ring_layout.slot_offset(tail);
+    std.mem.writeInt(u32, vm.memory[@intCast(slot)..][0..4], 3, .little);
+    std.mem.writeInt(u32, vm.memory[@intCast(slot + 4)..][0..4], @intFromEnum(ring_layout.Kind.inline_bytes), .little);
+    @memcpy(vm.memory[@intCast(slot + ring_layout.SLOT_HEADER_BYTES)..][0..3], "hey");
+    std.mem.writeInt(u32, vm.memory[@intCast(ring + ring_layout.TAIL_OFFSET)..][0..4], tail +% 1, .little);
+    const direct = try kernel.handle_syscall(@intFromEnum(Syscall.channel_recv), chan, 0x3100, 128, 0);
+    try testing.expectEqual(@as(u64, 3), direct.success);
+    try testing.expectEqualStrings("hey", vm.memory[0x3100..][0..3]);
+}
+
+/// Queue one io_ring submission at the ring's sq_tail and publish it.
+fn submit_sqe(vm: *VM, ring: u64, opcode: u32, args: [4]u64, user_data: u64) void {
+    const layout = basin_kernel.io_ring;
+    const tail_bytes = vm.memory[@intCast(ring + layout.SQ_TAIL_OFFSET)..][0..4];
+    const tail = std.mem.readInt(u32, tail_bytes, .little);
+    const sqe = layout.Sqe{ .opcode = opcode, .flags = 0, .user_data = user_data, .args = args, ._reserved = .{ 0, 0 } };
+    @memcpy(vm.memory[@intCast(ring + layout.sqe_offset(tail))..][0..@sizeOf(layout.Sqe)], std.mem.asBytes(&sqe));
+    std.mem.writeInt(u32, tail_bytes, tail +% 1, .little);
+}
+
+/// Completion posted at counter of an io_ring.
+fn read_cqe(vm: *VM, ring: u64, counter: u32) basin_kernel.io_ring.Cqe {
+    const offset = ring + basin_kernel.io_ring.cqe_offset(counter);
+    return std.mem.bytesToValue(basin_kernel.io_ring.Cqe, vm.memory[@intCast(offset)..][0..@sizeOf(basin_kernel.io_ring.Cqe)]);
+}
+
+test "Integration: io_ring runs batched syscalls and posts completions" {
+    // Submissions queued in guest memory run on one io_ring_enter (or on a kernel poll);
+    // each completion carries the a0 word its syscall returns.
+    var setup = try setup_integration(&[_]u8{ 0x13, 0x00, 0x00, 0x00 });
+    defer teardown_integration(&setup);
+    const vm = setup.vm;
+    const kernel = setup.kernel;
+
+    const layout = basin_kernel.io_ring;
+    const BasinError = basin_kernel.BasinError;
+    const enter = @intFromEnum(Syscall.io_ring_enter);
+    const id = (try kernel.handle_syscall(@intFromEnum(Syscall.io_ring_setup), 0x2000, 0, 0, 0)).success;
+    const ring = try vm.read64(0x2000);
+    try testing.expect(ring != 0 and ring % 4096 == 0);
+    try testing.expectEqual(layout.MAGIC, std.mem.readInt(u32, vm.memory[@intCast(ring)..][0..4], .little));
+    try testing.expectError(BasinError.permission_denied, kernel.handle_syscall(@intFromEnum(Syscall.unmap), ring, 0, 0, 0));
+    try testing.expectError(BasinError.invalid_argument, kernel.handle_syscall(@intFromEnum(Syscall.io_ring_setup), 0, 2, 0, 0));
+
+    // Nothing queued: nothing runs.
+    try testing.expectEqual(@as(u64, 0), (try kernel.handle_syscall(enter, id, 0, 0, 0)).success);
+
+    // One batch: open, two writes, a refused sleep_until and a map.
+    try vm.write_memory(0x3000, "/ring");
+    try vm.write_memory(0x3100, "batched");
+    const flags = basin_kernel.OpenFlags.init(.{ .read = true, .write = true, .create = true });
+    const rw = basin_kernel.MapFlags.init(.{ .read = true, .write = true });
+    submit_sqe(vm, ring, @intFromEnum(Syscall.open), .{ 0x3000, 5, @as(u32, @bitCast(flags)), 0 }, 1);
+    try testing.expectEqual(@as(u64, 1), (try kernel.handle_syscall(enter, id, 0, 0, 0)).success);
+    const handle = read_cqe(vm, ring, 0);
+    try testing.expectEqual(@as(u64, 1), handle.user_data);
+    try testing.expect(handle.result >> 63 == 0 and handle.result != 0);
+
+    submit_sqe(vm, ring, @intFromEnum(Syscall.write), .{ handle.result, 0x3100, 7, 0 }, 2);
+    submit_sqe(vm, ring, @intFromEnum(Syscall.write), .{ handle.result, 0x3100, 7, 0 }, 3);
+    submit_sqe(vm, ring, @intFromEnum(Syscall.sleep_until), .{ 1, 0, 0, 0 }, 4);
+    submit_sqe(vm, ring, @intFromEnum(Syscall.map), .{ 0, 4096, @as(u32, @bitCast(rw)), 0 }, 5);
+    try testing.expectEqual(@as(u64, 2), (try kernel.handle_syscall(enter, id, 2, 0, 0)).success);
+    try testing.expectEqual(@as(u64, 2), (try kernel.handle_syscall(enter, id, 0, 0, 0)).success);
+    try testing.expectEqual(@as(u64, 7), read_cqe(vm, ring, 1).result);
+    try testing.expectEqual(@as(u64, 7), read_cqe(vm, ring, 2).result);
+    const refused = read_cqe(vm, ring, 3);
+    try testing.expectEqual(@as(u64, 4), refused.user_data);
+    try testing.expectEqual(basin_kernel.error_code(BasinError.invalid_syscall), @as(i64, @bitCast(refused.result)));
+    const mapped = read_cqe(vm, ring, 4);
+    try testing.expect(mapped.result >= 0x100000 and mapped.result % 4096 == 0);
+    try testing.expectEqual(@as(u32, 5), std.mem.readInt(u32, vm.memory[@intCast(ring + layout.SQ_HEAD_OFFSET)..][0..4], .little));
+    try testing.expectEqual(@as(u32, 5), std.mem.readInt(u32, vm.memory[@intCast(ring + layout.CQ_TAIL_OFFSET)..][0..4], .little));
+
+    // Both writes landed in the file.
+    const handle_idx: u32 = @intCast((handle.result & 0xFFFFFFFF) - 1);
+    try testing.expectEqual(@as(u64, 14), kernel.inodes.entries[kernel.handles.entries[handle_idx].inode].size);
+
+    // A guest tail beyond the ring's reach is refused.
+    std.mem.writeInt(u32, vm.memory[@intCast(ring + layout.SQ_TAIL_OFFSET)..][0..4], 5 + layout.SQ_ENTRIES + 1, .little);
+    try testing.expectError(BasinError.invalid_argument, kernel.handle_syscall(enter, id, 0, 0, 0));
+
+    // Polled ring: the kernel drains it without io_ring_enter, and bounds run batches.
+    try testing.expect(kernel.next_preemption() == null);
+    _ = try kernel.handle_syscall(@intFromEnum(Syscall.io_ring_setup), 0x2008, layout.SETUP_POLL, 0, 0);
+    const polled = try vm.read64(0x2008);
+    try testing.expect(kernel.next_preemption() != null);
+    submit_sqe(vm, polled, @intFromEnum(Syscall.write), .{ handle.result, 0x3100, 7, 0 }, 6);
+    kernel.poll_io_rings();
+    const posted = read_cqe(vm, polled, 0);
+    try testing.expectEqual(@as(u64, 6), posted.user_data);
+    try testing.expectEqual(@as(u64, 7), posted.result);
+}
+
+test "Integration: Time page tracks clocks and memory without a syscall" {
+    // The page is published on attach, rewritten under its seqlock only when a field
+    // changes, and agrees with clock_gettime.
+    var setup = try setup_integration(&[_]u8{ 0x13, 0x00, 0x00, 0x00 });
+    defer teardown_integration(&setup);
+    const vm = setup.vm;
+    const kernel = setup.kernel;
+
+    const layout = basin_kernel.time_page;
+    const read_page = struct {
+        fn at(memory: []const u8) basin_kernel.time_page.Page {
+            const Page = basin_kernel.time_page.Page;
+            return std.mem.bytesToValue(Page, memory[@intCast(basin_kernel.time_page.ADDRESS)..][0..@sizeOf(Page)]);
+        }
+    }.at;
+    const published = read_page(vm.memory);
+    try testing.expectEqual(layout.MAGIC, published.magic);
+    try testing.expect(published.sequence != 0 and published.sequence % 2 == 0);
+    try testing.expectEqual(kernel_vm.csr.TIMEBASE_HZ, published.ticks_per_second);
+    try testing.expectEqual(@as(u64, vm.memory_size), published.total_memory);
+    try testing.expectEqual(@as(u32, 1), published.cpu_cores);
+
+    // Nothing changed: no rewrite. A mapping: one rewrite with less memory available.
+    kernel.refresh_time_page();
+    try testing.expectEqual(published.sequence, read_page(vm.memory).sequence);
+    const rw = basin_kernel.MapFlags.init(.{ .read = true, .write = true });
+    _ = try kernel.handle_syscall(@intFromEnum(Syscall.map), 0, 64 * 1024, @as(u32, @bitCast(rw)), 0);
+    kernel.refresh_time_page();
+    const remapped = read_page(vm.memory);
+    try testing.expectEqual(published.sequence +% 2, remapped.sequence);
+    try testing.expectEqual(published.available_memory - 64 * 1024, remapped.available_memory);
+
+    // clock_gettime and a page reader agree: 2.5 guest seconds, realtime offset by the host.
+    vm.csrs.mtime = kernel_vm.csr.TIMEBASE_HZ * 5 / 2;
+    kernel.set_realtime(1_700_000_000 * std.time.ns_per_s + std.time.ns_per_s * 5 / 2);
+    const page = read_page(vm.memory);
+    try testing.expectEqual(@as(u64, 1_700_000_000 * std.time.ns_per_s), page.realtime_base_ns);
+    _ = try kernel.handle_syscall(@intFromEnum(Syscall.clock_gettime), 0, 0x3000, 0, 0);
+    try testing.expectEqual(@as(u64, 2), try vm.read64(0x3000));
+    try testing.expectEqual(@as(u64, 500_000_000), try vm.read64(0x3008));
+    try testing.expectEqual(@as(u64, 2_500_000_000), layout.ticks_to_ns(vm.csrs.mtime, page.ticks_per_second));
+    _ = try kernel.handle_syscall(@intFromEnum(Syscall.clock_gettime), 1, 0x3000, 0, 0);
+    try testing.expectEqual(@as(u64, 1_700_000_002), try vm.read64(0x3000));
+
+    // A guest store over the page is repaired at the next refresh, though no field changed.
+    const settled = read_page(vm.memory);
+    @memset(vm.memory[@intCast(layout.ADDRESS)..][0..@sizeOf(layout.Page)], 0);
+    kernel.refresh_time_page();
+    const repaired = read_page(vm.memory);
+    try testing.expectEqual(layout.MAGIC, repaired.magic);
+    try testing.expectEqual(settled.realtime_base_ns, repaired.realtime_base_ns);
+    try testing.expectEqual(settled.sequence +% 2, repaired.sequence);
+}
+
+test "Integration: Loader keeps segments off the time page" {
+    // One PT_LOAD segment at vaddr: accepted anywhere but the kernel's time page.
+    const elf = struct {
+        fn image(vaddr: u64) [120]u8 {
+            var bytes = [_]u8{0} ** 120;
+            @memcpy(bytes[0..4], "\x7fELF");
+            bytes[4] = 2; // ELFCLASS64
+            bytes[5] = 1; // little-endian
+            bytes[6] = 1; // version
+            std.mem.writeInt(u16, bytes[16..18], 2, .little); // ET_EXEC
+            std.mem.writeInt(u16, bytes[18..20], 243, .little); // EM_RISCV
+            std.mem.writeInt(u64, bytes[24..32], vaddr, .little); // e_entry
+            std.mem.writeInt(u64, bytes[32..40], 64, .little); // e_phoff
+            std.mem.writeInt(u16, bytes[54..56], 56, .little); // e_phentsize
+            std.mem.writeInt(u16, bytes[56..58], 1, .little); // e_phnum
+            std.mem.writeInt(u32, bytes[64..68], 1, .little); // PT_LOAD
+            std.mem.writeInt(u64, bytes[80..88], vaddr, .little); // p_vaddr
+            std.mem.writeInt(u64, bytes[104..112], 64, .little); // p_memsz
+            return bytes;
+        }
+    }.image;
+    const layout = basin_kernel.time_page;
+    const vm = try testing.allocator.create(VM);
+    defer testing.allocator.destroy(vm);
+
+    const overlapping = elf(layout.ADDRESS + layout.PAGE_BYTES - 32);
+    try testing.expectError(
+        error.ReservedAddress,
+        kernel_vm.loadUserspaceELF(vm, testing.allocator, &overlapping, &.{}),
+    );
+
+    const clear = elf(0x10000);
+    try kernel_vm.loadUserspaceELF(vm, testing.allocator, &clear, &.{});
+    defer vm.deinit();
+    try testing.expectEqual(@as(u64, 0x10000), vm.regs.pc);
+}
+
+test "Integration: Sysinfo reports system info and per-syscall statistics" {
+    // sysinfo writes the system info record; with a stats pointer it also copies out one
+    // syscall's counters, which are all zeros unless built with -Dkernel-stats=true.
+    var setup = try setup_integration(&[_]u8{ 0x13, 0x00, 0x00, 0x00 });
+    defer teardown_integration(&setup);
+    const vm = setup.vm;
+    const kernel = setup.kernel;
+
+    const stats = basin_kernel.syscall_stats;
+    try testing.expectEqual(@as(u32, 0), stats.bucket(0));
+    try testing.expectEqual(@as(u32, 2), stats.bucket(3));
+    try testing.expectEqual(@as(u32, 3), stats.bucket(4));
+    try testing.expectEqual(stats.BUCKETS - 1, stats.bucket(std.math.maxInt(u64)));
+    try testing.expectEqual(@as(u64, 3), stats.bucket_limit(2));
+
+    const sysinfo = @intFromEnum(Syscall.sysinfo);
+    _ = try kernel.handle_syscall(sysinfo, 0x3000, 0, 0, 0);
+    try testing.expectEqual(@as(u64, vm.memory_size), try vm.read64(0x3000));
+    try testing.expectEqual(@as(u32, 1), std.mem.readInt(u32, vm.memory[0x3018..0x301C], .little));
+    try testing.expectError(basin_kernel.BasinError.invalid_argument, kernel.handle_syscall(sysinfo, 0, 0, 0, 0));
+    try testing.expectError(
+        basin_kernel.BasinError.invalid_argument,
+        kernel.handle_syscall(sysinfo, 0, basin_kernel.SYSCALL_MAX + 1, 0x4000, 0),
+    );
+
+    // Three clock reads and one bad pointer, all from the host (no process waits on them).
+    const clock_gettime = @intFromEnum(Syscall.clock_gettime);
+    var call: u32 = 0;
+    while (call < 3) : (call += 1) _ = try kernel.handle_syscall(clock_gettime, 0, 0x3000, 0, 0);
+    try testing.expectError(basin_kernel.BasinError.invalid_argument, kernel.handle_syscall(clock_gettime, 0, 0, 0, 0));
+
+    const Record = stats.Record;
+    const copied = (try kernel.handle_syscall(sysinfo, 0, clock_gettime, 0x4000, 0)).success;
+    try testing.expectEqual(@as(u64, @intFromBool(stats.enabled)), copied);
+    const record = std.mem.bytesToValue(Record, vm.memory[0x4000..][0..@sizeOf(Record)]);
+    try testing.expectEqual(kernel.syscall_statistics(clock_gettime), record);
+
+    var dump_buffer: [2048]u8 = undefined;
+    var dump_writer = std.Io.Writer.fixed(&dump_buffer);
+    try kernel.dump_syscall_stats(&dump_writer);
+    if (stats.enabled) {
+        try testing.expectEqual(@as(u64, 4), record.calls);
+        try testing.expectEqual(@as(u64, 1), record.errors[1]); // -2: invalid_argument
+        try testing.expectEqual(@as(u64, 1), record.error_count());
+        // Guest time stood still, so every call took 0 guest instructions.
+        try testing.expectEqual(@as(u64, 4), record.guest_instructions[0]);
+        var sampled: u64 = 0;
+        for (record.host_ns) |count| sampled += count;
+        try testing.expect(sampled <= record.calls);
+        try testing.expect(std.mem.indexOf(u8, dump_writer.buffered(), "clock_gettime") != null);
+
+        // A process's syscall lasts until it is back on the CPU.
+        _ = try kernel.boot_process();
+        _ = try kernel.handle_syscall(clock_gettime, 0, 0x3000, 0, 0);
+        vm.csrs.mtime += 100;
+        var cpu: basin_kernel.scheduler.Context = .{};
+        try testing.expect(kernel.schedule(&cpu) == .run);
+        try testing.expectEqual(@as(u64, 1), kernel.syscall_statistics(clock_gettime).guest_instructions[stats.bucket(100)]);
+
+        kernel.clear_syscall_statistics();
+        try testing.expectEqual(@as(u64, 0), kernel.syscall_statistics(clock_gettime).calls);
+    } else {
+        try testing.expectEqual(std.mem.zeroes(Record), record);
+        try testing.expect(std.mem.indexOf(u8, dump_writer.buffered(), "disabled") != null);
+    }
+}
+
+test "Integration: Out-of-range syscall numbers leave the wait counters alone" {
+    // Guest a7 is arbitrary: syscall 999 counts in the out-of-range record, returns to its
+    // caller at once, and never holds a process's pending slot (it used to land in wait's).
+    const stats = basin_kernel.syscall_stats;
+    const Collector = stats.Collector(basin_kernel.SYSCALL_MAX + 1, 2);
+    const collector = try testing.allocator.create(Collector);
+    defer testing.allocator.destroy(collector);
+    collector.* = .{};
+
+    const wait = @intFromEnum(Syscall.wait);
+    const error_slot: u32 = @intCast(-basin_kernel.error_code(basin_kernel.BasinError.invalid_syscall) - 1);
+    const call = collector.begin(100);
+    collector.end(call, 999, error_slot, 0, 100);
+    collector.resumed(0, 500);
+    try testing.expectEqual(std.mem.zeroes(stats.Record), collector.record(wait).*);
+    try testing.expectEqual(@as(u64, 1), collector.out_of_range_record().calls);
+    try testing.expectEqual(@as(u64, 1), collector.out_of_range_record().error_count());
+    try testing.expectEqual(@as(u64, 1), collector.out_of_range_record().guest_instructions[0]);
+}
+
+/// Store RISC-V instruction words at addr.
+fn write_code(vm: *VM, addr: u64, words: []const u32) !void {
+    for (words, 0..) |word, i| {
+        var bytes: [4]u8 = undefined;
+        std.mem.writeInt(u32, &bytes, word, .little);
+        try vm.write_memory(addr + 4 * i, &bytes);
+    }
+}
+
+/// Store a minimal ELF header at addr: magic, e_entry and one PT_LOAD segment with
+/// flags over [addr, addr + 0x1000) (all spawn reads).
+fn write_elf_image(vm: *VM, addr: u64, entry: u64, flags: u32) !void {
+    var header = [_]u8{0} ** (64 + 56);
+    @memcpy(header[0..4], "\x7fELF");
+    std.mem.writeInt(u64, header[24..32], entry, .little);
+    std.mem.writeInt(u64, header[32..40], 64, .little); // e_phoff
+    std.mem.writeInt(u16, header[54..56], 56, .little); // e_phentsize
+    std.mem.writeInt(u16, header[56..58], 1, .little); // e_phnum
+    const phdr = header[64..];
+    std.mem.writeInt(u32, phdr[0..4], 1, .little); // PT_LOAD
+    std.mem.writeInt(u32, phdr[4..8], flags, .little);
+    std.mem.writeInt(u64, phdr[16..24], addr, .little); // p_vaddr
+    std.mem.writeInt(u64, phdr[32..40], 0x1000, .little); // p_filesz
+    std.mem.writeInt(u64, phdr[40..48], 0x1000, .little); // p_memsz
+    try vm.write_memory(addr, &header);
+}
+
+/// Readable, executable segment flags (PF_R | PF_X).
+const SEGMENT_CODE: u32 = 5;
+
+/// Store a minimal executable ELF image header at addr.
+fn write_elf_header(vm: *VM, addr: u64, entry: u64) !void {
+    try write_elf_image(vm, addr, entry, SEGMENT_CODE);
+}
+
+test "Integration: Scheduler time-slices spinners and wakes sleepers" {
+    // Two spinners share the CPU by time slice; a more urgent sleeper preempts them on wakeup.
+    var setup = try setup_integration(&[_]u8{ 0x13, 0x00, 0x00, 0x00 });
+    defer teardown_integration(&setup);
+    const vm = setup.vm;
+    const kernel = setup.kernel;
+    const integration = &setup.integration;
+
+    // Spinner (a0 = counter): loop { *a0 += 1 }.
+    try write_elf_header(vm, 0x4000, 0x4100);
+    try write_code(vm, 0x4100, &[_]u32{
+        0x00053283, // ld t0, 0(a0)
+        0x00128293, // addi t0, t0, 1
+        0x00553023, // sd t0, 0(a0)
+        0xFF5FF06F, // j -12
+    });
+    // Sleeper (a0 = results): record deadline = time + 40960, sleep_until, record wake time, shut down.
+    try write_elf_header(vm, 0x5000, 0x5100);
+    try write_code(vm, 0x5100, &[_]u32{
+        0x00050493, // mv s1, a0
+        0xC01022F3, // rdtime t0
+        0x0000A337, // lui t1, 10
+        0x00628533, // add a0, t0, t1
+        0x00A4B023, // sd a0, 0(s1)
+        0x02900893, // li a7, 41 (sleep_until)
+        0x00000073, // ecall
+        0xC01022F3, // rdtime t0
+        0x0054B423, // sd t0, 8(s1)
+        0x00800893, // li a7, 8 (SBI shutdown)
+        0x00000073, // ecall
+        0x0000006F, // j 0
+    });
+
+    const spawn = @intFromEnum(Syscall.spawn);
+    const sleeper = (try kernel.handle_syscall(spawn, 0x5000, 0x6010, 16, 1)).success;
+    _ = try kernel.handle_syscall(spawn, 0x4000, 0x6000, 8, 0);
+    _ = try kernel.handle_syscall(spawn, 0x4000, 0x6008, 8, 0);
+    try integration.run();
+
+    try testing.expect(vm.state == .halted);
+    try testing.expectEqual(@as(?u64, sleeper), kernel.current_process());
+
+    // Both spinners ran (several slices each while the sleeper slept).
+    const spins_a = try vm.read64(0x6000);
+    const spins_b = try vm.read64(0x6008);
+    try testing.expect(spins_a > basin_kernel.TIME_SLICE / 8);
+    try testing.expect(spins_b > basin_kernel.TIME_SLICE / 8);
+
+    // The sleeper woke on the first wheel tick at or after its deadline.
+    const deadline = try vm.read64(0x6010);
+    const woke = try vm.read64(0x6018);
+    try testing.expect(woke >= deadline);
+    try testing.expect(woke - deadline < (@as(u64, 1) << basin_kernel.TIMER_TICK_SHIFT) + 8);
+}
+
+test "Integration: Guests yield and exit by ECALL, and the schedule replays from the log" {
+    // Process syscalls sit in the kernel range (ECALLs below 10 are SBI), and a Replayer
+    // reproduces the recorded run from its switch records without a kernel.
+    var setup = try setup_integration(&[_]u8{ 0x13, 0x00, 0x00, 0x00 });
+    defer teardown_integration(&setup);
+    const vm = setup.vm;
+    const kernel = setup.kernel;
+    const integration = &setup.integration;
+
+    // Worker (a0 = counter): three times { *a0 += 1; yield }, then exit(7) (nobody waits,
+    // so both stay exited).
+    try write_elf_header(vm, 0x4000, 0x4100);
+    try write_code(vm, 0x4100, &[_]u32{
+        0x00050493, // mv s1, a0
+        0x00300413, // li s0, 3
+        0x0004B283, // ld t0, 0(s1)
+        0x00128293, // addi t0, t0, 1
+        0x0054B023, // sd t0, 0(s1)
+        0x04800893, // li a7, 72 (yield)
+        0x00000073, // ecall
+        0xFFF40413, // addi s0, s0, -1
+        0xFE041463, // bnez s0, -24
+        0x00700513, // li a0, 7
+        0x04700893, // li a7, 71 (exit)
+        0x00000073, // ecall
+        0x0000006F, // j 0
+    });
+
+    const spawn = @intFromEnum(Syscall.spawn);
+    _ = try kernel.handle_syscall(spawn, 0x4000, 0x6000, 8, 0);
+    _ = try kernel.handle_syscall(spawn, 0x4000, 0x6008, 8, 0);
+
+    var log = std.Io.Writer.Allocating.init(testing.allocator);
+    defer log.deinit();
+    var recorder: kernel_vm.replay.Recorder = undefined;
+    try recorder.init(vm, &log.writer, .{});
+    try integration.run();
+    try recorder.finish(vm);
+
+    // Both workers ran to exit (the VM stops once no process is left).
+    try testing.expect(vm.state == .halted);
+    try testing.expectEqual(@as(u64, 3), try vm.read64(0x6000));
+    try testing.expectEqual(@as(u64, 3), try vm.read64(0x6008));
+    try testing.expectEqual(@as(u32, 2), kernel.processes.count());
+    for (kernel.processes.entries) |process| {
+        if (!process.allocated) continue;
+        try testing.expect(process.state == .exited);
+        try testing.expectEqual(@as(u32, 7), process.exit_status);
+    }
+    const final_regs = vm.regs;
+    const final_hash = std.hash.Wyhash.hash(0, vm.memory);
+
+    // Replay with no kernel: syscall results and switches come from the log.
+    const replayed_vm = try testing.allocator.create(VM);
+    defer testing.allocator.destroy(replayed_vm);
+    try VM.init(replayed_vm, &[_]u8{ 0x13, 0x00, 0x00, 0x00 }, 0x1000);
+    defer replayed_vm.deinit();
+    var replayer: kernel_vm.replay.Replayer = undefined;
+    try replayer.init(testing.allocator, log.written());
+    defer replayer.deinit();
+
+    try replayer.seek(replayed_vm, 0);
+    const replayed = try replayer.run(replayed_vm, 1_000_000);
+    try testing.expect(replayed.exit == .halted);
+    try testing.expectEqual(replayer.end_instret.?, replayer.session.instret);
+    try testing.expectEqual(final_regs.pc, replayed_vm.regs.pc);
+    try testing.expectEqualSlices(u64, &final_regs.regs, &replayed_vm.regs.regs);
+    try testing.expectEqual(final_hash, std.hash.Wyhash.hash(0, replayed_vm.memory));
+}
+
+test "Integration: Spawn starts processes only in executable memory" {
+    // The entry comes from guest data: it must fall in an executable PT_LOAD segment of the
+    // image, outside any mapping without execute permission, and spawn needs guest RAM.
+    const spawn = @intFromEnum(Syscall.spawn);
+    const detached = try testing.allocator.create(BasinKernel);
+    defer testing.allocator.destroy(detached);
+    detached.* = BasinKernel.init();
+    try testing.expectError(basin_kernel.BasinError.invalid_argument, detached.handle_syscall(spawn, 0x4000, 0, 0, 0));
+
+    var setup = try setup_integration(&[_]u8{ 0x13, 0x00, 0x00, 0x00 });
+    defer teardown_integration(&setup);
+    const vm = setup.vm;
+    const kernel = setup.kernel;
+    const invalid = basin_kernel.BasinError.invalid_argument;
+
+    // Entry past the segment, and a segment that is not executable.
+    try write_elf_header(vm, 0x4000, 0x5000);
+    try testing.expectError(invalid, kernel.handle_syscall(spawn, 0x4000, 0, 0, 0));
+    try write_elf_image(vm, 0x4000, 0x4100, 4); // PF_R only
+    try testing.expectError(invalid, kernel.handle_syscall(spawn, 0x4000, 0, 0, 0));
+
+    // An executable segment inside a read/write mapping still may not run.
+    const flags = basin_kernel.MapFlags.init(.{ .read = true, .write = true });
+    const data = (try kernel.handle_syscall(@intFromEnum(Syscall.map), 0x200000, 4096, @as(u32, @bitCast(flags)), 0)).success;
+    try write_elf_header(vm, data, data + 0x100);
+    try testing.expectError(invalid, kernel.handle_syscall(spawn, data, 0, 0, 0));
+
+    // A well-formed image spawns at its entry.
+    try write_elf_header(vm, 0x4000, 0x4100);
+    const child = (try kernel.handle_syscall(spawn, 0x4000, 0, 0, 0)).success;
+    const idx = kernel.processes.find(child).?;
+    try testing.expectEqual(@as(u64, 0x4100), kernel.processes.entries[idx].context.pc);
+}
+
+test "Integration: A waited-for process is released only after it leaves the CPU" {
+    // exit hands the status to the waiter at once, but the exiting process keeps its slot and
+    // stack until the next scheduling point has switched it out.
+    var setup = try setup_integration(&[_]u8{ 0x13, 0x00, 0x00, 0x00 });
+    defer teardown_integration(&setup);
+    const vm = setup.vm;
+    const kernel = setup.kernel;
+    try write_elf_header(vm, 0x4000, 0x4100);
+
+    const parent = try kernel.boot_process();
+    const child = (try kernel.handle_syscall(@intFromEnum(Syscall.spawn), 0x4000, 0, 0, 0)).success;
+    const mappings = kernel.count_allocated_mappings();
+    try testing.expectError(basin_kernel.BasinError.would_block, kernel.handle_syscall(@intFromEnum(Syscall.wait), child, 0, 0, 0));
+    var cpu: basin_kernel.scheduler.Context = .{};
+    try testing.expect(kernel.schedule(&cpu) == .run);
+    try testing.expectEqual(@as(?u64, child), kernel.current_process());
+
+    // The child exits while the parent waits: still on the CPU, so nothing is freed yet.
+    _ = try kernel.handle_syscall(@intFromEnum(Syscall.exit), 5, 0, 0, 0);
+    const idx = kernel.processes.find(child).?;
+    try testing.expect(kernel.processes.entries[idx].state == .zombie);
+    try testing.expectEqual(mappings, kernel.count_allocated_mappings());
+    try testing.expectEqual(@as(u32, 2), kernel.processes.count());
+
+    // Switching to the parent releases the child; the parent resumes with the status.
+    try testing.expect(kernel.schedule(&cpu) == .run);
+    try testing.expectEqual(@as(?u64, parent), kernel.current_process());
+    try testing.expectEqual(@as(u64, 5), cpu.regs[10]);
+    try testing.expectEqual(@as(?u32, null), kernel.processes.find(child));
+    try testing.expectEqual(@as(u32, 1), kernel.processes.count());
+    try testing.expectEqual(mappings - 1, kernel.count_allocated_mappings());
+}
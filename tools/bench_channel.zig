@@ -0,0 +1,95 @@
+const std = @import("std");
+const kernel_vm = @import("kernel_vm");
+const VM = kernel_vm.VM;
+const Integration = kernel_vm.Integration;
+const basin_kernel = @import("basin_kernel");
+const BasinKernel = basin_kernel.BasinKernel;
+const Syscall = basin_kernel.Syscall;
+const MapFlags = basin_kernel.MapFlags;
+
+/// Channel ping-pong benchmark: messages per second and round-trip latency.
+/// Grain Style: Deterministic payloads, every message length checked on arrival.
+/// Why: A round trip is two channels and four syscalls (send and receive each way), run
+/// through the kernel against real guest RAM (dirty tracking included). Inline messages
+/// are copied through the ring; page messages hand a mapping over without copying.
+
+/// Round trips per payload size.
+const ROUND_TRIPS: u32 = 200_000;
+
+/// Guest scratch addresses (below the 1MB mapping base).
+const SEND_BUFFER: u64 = 0x10000;
+const RECV_BUFFER: u64 = 0x11000;
+const PAGES_OUT: u64 = 0x12000;
+
+const Payload = struct {
+    name: []const u8,
+    bytes: u64,
+    /// Move a mapping instead of copying (bytes > channel_ring.INLINE_MAX).
+    pages: bool,
+};
+
+const PAYLOADS = [_]Payload{
+    .{ .name = "inline 8B", .bytes = 8, .pages = false },
+    .{ .name = "inline 112B", .bytes = basin_kernel.channel_ring.INLINE_MAX, .pages = false },
+    .{ .name = "pages 64KB", .bytes = 64 * 1024, .pages = true },
+    .{ .name = "pages 1MB", .bytes = 1024 * 1024, .pages = true },
+};
+
+pub fn main() !void {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    const allocator = gpa.allocator();
+
+    const vm = try allocator.create(VM);
+    defer allocator.destroy(vm);
+    try VM.init(vm, &[_]u8{ 0x13, 0x00, 0x00, 0x00 }, 0x1000);
+    defer vm.deinit();
+    const kernel = try allocator.create(BasinKernel);
+    defer allocator.destroy(kernel);
+    kernel.* = BasinKernel.init();
+    var integration = Integration.init_with_kernel(vm, kernel);
+    integration.finish_init();
+    defer integration.cleanup();
+
+    const ping = (try kernel.handle_syscall(@intFromEnum(Syscall.channel_create), 0, 0, 0, 0)).success;
+    const pong = (try kernel.handle_syscall(@intFromEnum(Syscall.channel_create), 0, 0, 0, 0)).success;
+
+    std.debug.print("[bench_channel] {} round trips per payload (2 messages, 4 syscalls each)\n", .{ROUND_TRIPS});
+    std.debug.print("[bench_channel] {s:<12} {s:>14} {s:>12}\n", .{ "payload", "messages/s", "rtt ns" });
+    for (PAYLOADS) |payload| {
+        const elapsed_ns = try ping_pong(kernel, ping, pong, payload);
+        const messages = 2 * @as(f64, @floatFromInt(ROUND_TRIPS));
+        const seconds = @as(f64, @floatFromInt(@max(elapsed_ns, 1))) / std.time.ns_per_s;
+        std.debug.print("[bench_channel] {s:<12} {d:>14.0} {d:>12.1}\n", .{
+            payload.name,
+            messages / seconds,
+            @as(f64, @floatFromInt(elapsed_ns)) / @as(f64, @floatFromInt(ROUND_TRIPS)),
+        });
+    }
+}
+
+/// Time ROUND_TRIPS of: send on ping, receive on ping, send on pong, receive on pong.
+fn ping_pong(kernel: *BasinKernel, ping: u64, pong: u64, payload: Payload) !u64 {
+    // Page payloads travel in one mapping that bounces between the two ends.
+    var message: u64 = SEND_BUFFER;
+    if (payload.pages) {
+        const flags = MapFlags.init(.{ .read = true, .write = true });
+        message = (try kernel.handle_syscall(@intFromEnum(Syscall.map), 0, payload.bytes, @as(u32, @bitCast(flags)), 0)).success;
+    }
+    defer if (payload.pages) unmap(kernel, message);
+
+    var timer = std.time.Timer.start() catch unreachable;
+    var round: u32 = 0;
+    while (round < ROUND_TRIPS) : (round += 1) {
+        for ([_]u64{ ping, pong }) |chan| {
+            _ = try kernel.handle_syscall(@intFromEnum(Syscall.channel_send), chan, message, payload.bytes, 0);
+            const received = try kernel.handle_syscall(@intFromEnum(Syscall.channel_recv), chan, RECV_BUFFER, basin_kernel.channel_ring.INLINE_MAX, PAGES_OUT);
+            if (received.success != payload.bytes) return error.ShortMessage;
+        }
+    }
+    return timer.read();
+}
+
+fn unmap(kernel: *BasinKernel, region: u64) void {
+    _ = kernel.handle_syscall(@intFromEnum(Syscall.unmap), region, 0, 0, 0) catch {};
+}
@@ -0,0 +1,109 @@
+const std = @import("std");
+const kernel_vm = @import("kernel_vm");
+const VM = kernel_vm.VM;
+const decode_reference = @import("decode_reference");
+
+/// Dispatch microbenchmark: reference switch decoder vs comptime decode table.
+/// Grain Style: Deterministic input (instruction words of one ELF), explicit checks.
+/// Why: Both decoders run over the same executable segments so the comparison
+/// reflects the real opcode mix, and every word is checked for equivalence first.
+
+/// Default ELF (built by `zig build hello-world`).
+const DEFAULT_ELF_PATH = "zig-out/bin/hello_world";
+
+/// Passes over the instruction words per decoder.
+const ITERATIONS: u32 = 2000;
+
+/// ELF program header flag: segment is executable.
+const PF_X: u32 = 1;
+
+pub fn main() !void {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    const allocator = gpa.allocator();
+
+    var args = try std.process.argsWithAllocator(allocator);
+    defer args.deinit();
+    _ = args.next(); // skip executable name
+    const elf_path = args.next() orelse DEFAULT_ELF_PATH;
+
+    const elf_data = std.fs.cwd().readFileAlloc(allocator, elf_path, 64 * 1024 * 1024) catch |err| {
+        std.debug.print("[bench_dispatch] cannot read {s}: {s} (run 'zig build hello-world' first)\n", .{ elf_path, @errorName(err) });
+        return err;
+    };
+    defer allocator.free(elf_data);
+
+    var words = std.ArrayListUnmanaged(u32){};
+    defer words.deinit(allocator);
+    try collect_text_words(allocator, elf_data, &words);
+    if (words.items.len == 0) {
+        std.debug.print("[bench_dispatch] {s}: no executable segments\n", .{elf_path});
+        return error.NoExecutableSegments;
+    }
+
+    // Equivalence first: a fast decoder that disagrees is not a result.
+    for (words.items) |word| {
+        const table_decoded = VM.decode(word);
+        const reference_decoded = decode_reference.decode(word);
+        if (VM.op_of(&table_decoded) != reference_decoded.op or table_decoded.imm != reference_decoded.imm) {
+            std.debug.print("[bench_dispatch] mismatch for inst=0x{x:0>8}\n", .{word});
+            return error.DecodeMismatch;
+        }
+    }
+
+    const reference_ns = time_decoder(words.items, decode_reference.decode);
+    const table_ns = time_decoder(words.items, VM.decode);
+
+    const decodes = @as(u64, words.items.len) * ITERATIONS;
+    std.debug.print("[bench_dispatch] {s}: {} instruction words, {} decodes per decoder\n", .{ elf_path, words.items.len, decodes });
+    std.debug.print("[bench_dispatch] switch (reference): {d:.2} ns/decode\n", .{ns_per(reference_ns, decodes)});
+    std.debug.print("[bench_dispatch] table:              {d:.2} ns/decode\n", .{ns_per(table_ns, decodes)});
+    std.debug.print("[bench_dispatch] speedup:            {d:.2}x\n", .{@as(f64, @floatFromInt(reference_ns)) / @as(f64, @floatFromInt(@max(table_ns, 1)))});
+}
+
+/// Append every 32-bit word of executable PT_LOAD segments.
+fn collect_text_words(allocator: std.mem.Allocator, elf_data: []const u8, words: *std.ArrayListUnmanaged(u32)) !void {
+    if (elf_data.len < @sizeOf(std.elf.Elf64_Ehdr)) return error.InvalidElfFormat;
+    const ehdr = std.mem.bytesToValue(std.elf.Elf64_Ehdr, elf_data[0..@sizeOf(std.elf.Elf64_Ehdr)]);
+    if (!std.mem.eql(u8, ehdr.e_ident[0..4], std.elf.MAGIC)) return error.InvalidElfFormat;
+
+    var index: usize = 0;
+    while (index < ehdr.e_phnum) : (index += 1) {
+        const offset = @as(usize, @intCast(ehdr.e_phoff)) + index * @sizeOf(std.elf.Elf64_Phdr);
+        if (offset + @sizeOf(std.elf.Elf64_Phdr) > elf_data.len) return error.InvalidElfFormat;
+        const phdr = std.mem.bytesToValue(std.elf.Elf64_Phdr, elf_data[offset..][0..@sizeOf(std.elf.Elf64_Phdr)]);
+        if (phdr.p_type != std.elf.PT_LOAD or (phdr.p_flags & PF_X) == 0) continue;
+        if (phdr.p_offset + phdr.p_filesz > elf_data.len) return error.InvalidElfFormat;
+
+        const segment = elf_data[@intCast(phdr.p_offset)..][0..@intCast(phdr.p_filesz)];
+        var pos: usize = 0;
+        while (pos + 4 <= segment.len) : (pos += 4) {
+            try words.append(allocator, std.mem.readInt(u32, segment[pos..][0..4], .little));
+        }
+    }
+}
+
+/// Time ITERATIONS passes of decoder (VM.decode or decode_reference.decode) over words (nanoseconds).
+fn time_decoder(words: []const u32, comptime decoder: anytype) u64 {
+    var checksum: u64 = 0;
+    var timer = std.time.Timer.start() catch unreachable;
+    var iteration: u32 = 0;
+    while (iteration < ITERATIONS) : (iteration += 1) {
+        for (words) |word| {
+            const decoded = decoder(word);
+            checksum +%= operation_bits(decoded) ^ @as(u64, @bitCast(decoded.imm));
+        }
+    }
+    const elapsed = timer.read();
+    std.mem.doNotOptimizeAway(checksum);
+    return elapsed;
+}
+
+/// Operation a decoder picked, as bits (handler pointer or reference Op).
+fn operation_bits(decoded: anytype) u64 {
+    return if (@TypeOf(decoded) == VM.Decoded) @intFromPtr(decoded.handler) else @intFromEnum(decoded.op);
+}
+
+fn ns_per(total_ns: u64, count: u64) f64 {
+    return @as(f64, @floatFromInt(total_ns)) / @as(f64, @floatFromInt(@max(count, 1)));
+}
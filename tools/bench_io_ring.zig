@@ -0,0 +1,149 @@
+const std = @import("std");
+const kernel_vm = @import("kernel_vm");
+const VM = kernel_vm.VM;
+const Integration = kernel_vm.Integration;
+const basin_kernel = @import("basin_kernel");
+const BasinKernel = basin_kernel.BasinKernel;
+const Syscall = basin_kernel.Syscall;
+const io_ring = basin_kernel.io_ring;
+
+/// io_ring benchmark: guest cost per syscall, one ecall each versus batched through a ring.
+/// Grain Style: Deterministic guests, every run checked to completion.
+/// Why: Each ecall stops the VM, goes through Integration and a scheduling point; a
+/// batch pays that once per io_ring_enter. The op (clock_gettime) is cheap, so the rows
+/// show how much of a syscall is the trap.
+
+/// Syscalls per measurement.
+const OPS: u32 = 1 << 18;
+
+/// Submissions per io_ring_enter.
+const BATCHES = [_]u32{ 8, 64 };
+
+/// Guest layout: code, the timespec every op writes, the ring address.
+const CODE: u64 = 0x4000;
+const TIMESPEC: u64 = 0x6000;
+const RING_OUT: u64 = 0x6100;
+
+/// s1 = ops, s2 = timespec; loop { clock_gettime(0, s2); if (--s1 == 0) shutdown }.
+const ECALL_LOOP = [_]u32{
+    0x00000513, // li a0, 0 (monotonic)
+    0x00090593, // mv a1, s2
+    0x02800893, // li a7, 40 (clock_gettime)
+    0x00000073, // ecall
+    0xFFF48493, // addi s1, s1, -1
+    0xFE0496E3, // bnez s1, -20
+    0x00800893, // li a7, 8 (SBI shutdown)
+    0x00000073, // ecall
+    0x0000006F, // j 0
+};
+
+/// s1 = batches, s3 = ring, s4 = ring ID, s5 = batch; the SQ is pre-filled, so each
+/// round re-submits it: loop { sq_tail += s5; io_ring_enter(s4, 0); cq_head = cq_tail;
+/// if (--s1 == 0) shutdown }.
+const RING_LOOP = [_]u32{
+    0x0809A283, // lw t0, 128(s3) (sq_tail)
+    0x015282B3, // add t0, t0, s5
+    0x0859A023, // sw t0, 128(s3)
+    0x000A0513, // mv a0, s4
+    0x00000593, // li a1, 0 (everything queued)
+    0x03F00893, // li a7, 63 (io_ring_enter)
+    0x00000073, // ecall
+    0x1009A283, // lw t0, 256(s3) (cq_tail)
+    0x0C59A023, // sw t0, 192(s3) (cq_head)
+    0xFFF48493, // addi s1, s1, -1
+    0xFC048CE3, // bnez s1, -40
+    0x00800893, // li a7, 8 (SBI shutdown)
+    0x00000073, // ecall
+    0x0000006F, // j 0
+};
+
+comptime {
+    std.debug.assert(io_ring.SQ_TAIL_OFFSET == 128);
+    std.debug.assert(io_ring.CQ_HEAD_OFFSET == 192);
+    std.debug.assert(io_ring.CQ_TAIL_OFFSET == 256);
+    for (BATCHES) |batch| {
+        std.debug.assert(batch <= io_ring.SQ_ENTRIES);
+        std.debug.assert(OPS % batch == 0);
+    }
+}
+
+pub fn main() !void {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    const allocator = gpa.allocator();
+
+    std.debug.print("[bench_io_ring] {} clock_gettime calls per row\n", .{OPS});
+    std.debug.print("[bench_io_ring] {s:<14} {s:>10} {s:>10}\n", .{ "submission", "ns/op", "speedup" });
+    const baseline = ns_per(try time_ops(allocator, 0), OPS);
+    std.debug.print("[bench_io_ring] {s:<14} {d:>10.1} {d:>9.1}x\n", .{ "ecall each", baseline, @as(f64, 1.0) });
+    for (BATCHES) |batch| {
+        const ns = ns_per(try time_ops(allocator, batch), OPS);
+        var label_buffer: [32]u8 = undefined;
+        const label = try std.fmt.bufPrint(&label_buffer, "ring x{}", .{batch});
+        std.debug.print("[bench_io_ring] {s:<14} {d:>10.1} {d:>9.1}x\n", .{ label, ns, baseline / ns });
+    }
+}
+
+/// Time OPS calls made one ecall each (batch == 0) or batch per io_ring_enter.
+fn time_ops(allocator: std.mem.Allocator, batch: u32) !u64 {
+    const vm = try allocator.create(VM);
+    defer allocator.destroy(vm);
+    try VM.init(vm, &[_]u8{ 0x13, 0x00, 0x00, 0x00 }, 0x1000);
+    defer vm.deinit();
+    const kernel = try allocator.create(BasinKernel);
+    defer allocator.destroy(kernel);
+    kernel.* = BasinKernel.init();
+    var integration = Integration.init_with_kernel(vm, kernel);
+    integration.finish_init();
+    defer integration.cleanup();
+
+    var ring: u64 = 0;
+    if (batch == 0) {
+        try write_code(vm, CODE, &ECALL_LOOP);
+        vm.regs.regs[9] = OPS;
+        vm.regs.regs[18] = TIMESPEC;
+    } else {
+        const id = (try kernel.handle_syscall(@intFromEnum(Syscall.io_ring_setup), RING_OUT, 0, 0, 0)).success;
+        ring = try vm.read64(RING_OUT);
+        const sqe = io_ring.Sqe{
+            .opcode = @intFromEnum(Syscall.clock_gettime),
+            .flags = 0,
+            .user_data = 0,
+            .args = .{ 0, TIMESPEC, 0, 0 },
+            ._reserved = .{ 0, 0 },
+        };
+        var slot: u32 = 0;
+        while (slot < io_ring.SQ_ENTRIES) : (slot += 1) {
+            try vm.write_memory(ring + io_ring.sqe_offset(slot), std.mem.asBytes(&sqe));
+        }
+        try write_code(vm, CODE, &RING_LOOP);
+        vm.regs.regs[9] = OPS / batch;
+        vm.regs.regs[19] = ring;
+        vm.regs.regs[20] = id;
+        vm.regs.regs[21] = batch;
+    }
+    vm.regs.pc = CODE;
+
+    var timer = std.time.Timer.start() catch unreachable;
+    try integration.run();
+    const elapsed = timer.read();
+    if (vm.regs.regs[9] != 0) return error.OpsIncomplete;
+    if (batch != 0) {
+        const cq_tail = vm.memory[@intCast(ring + io_ring.CQ_TAIL_OFFSET)..][0..4];
+        if (std.mem.readInt(u32, cq_tail, .little) != OPS) return error.CompletionsLost;
+    }
+    return elapsed;
+}
+
+/// Store RISC-V instruction words at addr.
+fn write_code(vm: *VM, addr: u64, words: []const u32) !void {
+    for (words, 0..) |word, i| {
+        var bytes: [4]u8 = undefined;
+        std.mem.writeInt(u32, &bytes, word, .little);
+        try vm.write_memory(addr + 4 * i, &bytes);
+    }
+}
+
+fn ns_per(total_ns: u64, count: u64) f64 {
+    return @as(f64, @floatFromInt(total_ns)) / @as(f64, @floatFromInt(@max(count, 1)));
+}
@@ -0,0 +1,88 @@
+const std = @import("std");
+const basin_kernel = @import("basin_kernel");
+const BasinKernel = basin_kernel.BasinKernel;
+const Syscall = basin_kernel.Syscall;
+const MapFlags = basin_kernel.MapFlags;
+
+/// Mapping-churn microbenchmark: map/unmap latency against live mapping count.
+/// Grain Style: Deterministic layout, every syscall result checked.
+/// Why: map/unmap used to scan the whole mapping table and bump-allocate; with the
+/// treap-backed address-space index the cost per pair should stay flat as mappings grow.
+
+/// Live mapping counts to measure (the table holds 256; one slot stays free for churn).
+const POPULATIONS = [_]u32{ 0, 16, 64, 128, 255 };
+
+/// map + unmap pairs per measurement.
+const ITERATIONS: u32 = 200_000;
+
+const PAGE: u64 = 4096;
+
+pub fn main() !void {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    const allocator = gpa.allocator();
+
+    const kernel = try allocator.create(BasinKernel);
+    defer allocator.destroy(kernel);
+
+    std.debug.print("[bench_map] {} map+unmap pairs per row\n", .{ITERATIONS});
+    std.debug.print("[bench_map] {s:>6} {s:>14} {s:>14} {s:>14}\n", .{ "live", "kernel ns/pair", "fixed ns/pair", "lookup ns" });
+    for (POPULATIONS) |live| {
+        kernel.* = BasinKernel.init();
+        try populate(kernel, live);
+        const chosen_ns = try time_churn(kernel, 0);
+        const fixed_ns = try time_churn(kernel, kernel.user_memory_size - PAGE);
+        const lookup_ns = time_lookups(kernel);
+        std.debug.print("[bench_map] {d:>6} {d:>14.2} {d:>14.2} {d:>14.2}\n", .{
+            live,
+            ns_per(chosen_ns, ITERATIONS),
+            ns_per(fixed_ns, ITERATIONS),
+            ns_per(lookup_ns, ITERATIONS),
+        });
+    }
+}
+
+fn flags_arg() u64 {
+    return @as(u32, @bitCast(MapFlags.init(.{ .read = true, .write = true })));
+}
+
+/// Leave live one-page mappings with a one-page hole after each (fragmented layout).
+fn populate(kernel: *BasinKernel, live: u32) !void {
+    var i: u32 = 0;
+    while (i < live) : (i += 1) {
+        const mapped = try kernel.handle_syscall(@intFromEnum(Syscall.map), 0, 2 * PAGE, flags_arg(), 0);
+        _ = try kernel.handle_syscall(@intFromEnum(Syscall.unmap), mapped.success, 0, 0, 0);
+        _ = try kernel.handle_syscall(@intFromEnum(Syscall.map), mapped.success, PAGE, flags_arg(), 0);
+    }
+    if (kernel.count_allocated_mappings() != live) return error.PopulateFailed;
+}
+
+/// Time ITERATIONS map/unmap pairs of one page at addr (0: kernel-chosen).
+fn time_churn(kernel: *BasinKernel, addr: u64) !u64 {
+    var timer = std.time.Timer.start() catch unreachable;
+    var iteration: u32 = 0;
+    while (iteration < ITERATIONS) : (iteration += 1) {
+        const mapped = try kernel.handle_syscall(@intFromEnum(Syscall.map), addr, PAGE, flags_arg(), 0);
+        const unmapped = try kernel.handle_syscall(@intFromEnum(Syscall.unmap), mapped.success, 0, 0, 0);
+        if (unmapped != .success) return error.UnmapFailed;
+    }
+    return timer.read();
+}
+
+/// Time ITERATIONS permission lookups at addresses spread over the mapped region.
+fn time_lookups(kernel: *BasinKernel) u64 {
+    var hits: u64 = 0;
+    var timer = std.time.Timer.start() catch unreachable;
+    var iteration: u32 = 0;
+    while (iteration < ITERATIONS) : (iteration += 1) {
+        const addr = 0x100000 + (@as(u64, iteration) * 1237 % (512 * PAGE));
+        if (kernel.mapping_flags_at(addr) != null) hits += 1;
+    }
+    const elapsed = timer.read();
+    std.mem.doNotOptimizeAway(hits);
+    return elapsed;
+}
+
+fn ns_per(total_ns: u64, count: u64) f64 {
+    return @as(f64, @floatFromInt(total_ns)) / @as(f64, @floatFromInt(@max(count, 1)));
+}
@@ -0,0 +1,140 @@
+const std = @import("std");
+const kernel_vm = @import("kernel_vm");
+const VM = kernel_vm.VM;
+const Integration = kernel_vm.Integration;
+const basin_kernel = @import("basin_kernel");
+const BasinKernel = basin_kernel.BasinKernel;
+const Syscall = basin_kernel.Syscall;
+
+/// Scheduler benchmark: context-switch latency and timer-wheel cost per tick.
+/// Grain Style: Deterministic guests and timer seeds, every run checked to completion.
+/// Why: A yield is an ECALL, a scheduling point and a register swap, run through
+/// Integration against a real VM. The timer wheel should cost the same per tick
+/// whether 10 or 10,000 sleepers are armed.
+
+/// Yields per measurement (shared by every process).
+const YIELDS: u64 = 200_000;
+
+/// Processes yielding to each other.
+const POPULATIONS = [_]u32{ 1, 2, 8 };
+
+/// Armed timers per wheel measurement.
+const SLEEPERS = [_]u32{ 10, 1_000, 10_000 };
+
+/// Wheel ticks per measurement.
+const TICKS: u64 = 1 << 20;
+
+/// Timers are re-armed 1..HORIZON ticks out (spans two wheel levels).
+const HORIZON: u64 = 1 << 16;
+
+/// Guest layout: ELF header, code, shared yield counter.
+const IMAGE: u64 = 0x4000;
+const CODE: u64 = 0x4100;
+const COUNTER: u64 = 0x6000;
+
+/// s1 = counter; loop { sleep_until(1) (a past deadline: yield); if (--*s1 == 0) shutdown }.
+const YIELD_LOOP = [_]u32{
+    0x00050493, // mv s1, a0
+    0x02900893, // li a7, 41 (sleep_until)
+    0x00100513, // li a0, 1
+    0x00000073, // ecall
+    0x0004B283, // ld t0, 0(s1)
+    0xFFF28293, // addi t0, t0, -1
+    0x0054B023, // sd t0, 0(s1)
+    0xFE0294E3, // bnez t0, -24
+    0x00800893, // li a7, 8 (SBI shutdown)
+    0x00000073, // ecall
+    0x0000006F, // j 0
+};
+
+pub fn main() !void {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    const allocator = gpa.allocator();
+
+    std.debug.print("[bench_sched] {} yields per row\n", .{YIELDS});
+    std.debug.print("[bench_sched] {s:>9} {s:>14}\n", .{ "processes", "ns/yield" });
+    for (POPULATIONS) |processes| {
+        const elapsed_ns = try time_yields(allocator, processes);
+        std.debug.print("[bench_sched] {d:>9} {d:>14.1}\n", .{ processes, ns_per(elapsed_ns, YIELDS) });
+    }
+
+    std.debug.print("[bench_sched] {} wheel ticks per row\n", .{TICKS});
+    std.debug.print("[bench_sched] {s:>9} {s:>14}\n", .{ "sleepers", "ns/tick" });
+    for (SLEEPERS) |sleepers| {
+        const elapsed_ns = try time_ticks(allocator, sleepers);
+        std.debug.print("[bench_sched] {d:>9} {d:>14.1}\n", .{ sleepers, ns_per(elapsed_ns, TICKS) });
+    }
+}
+
+/// Time YIELDS yields shared by processes guests of equal priority.
+fn time_yields(allocator: std.mem.Allocator, processes: u32) !u64 {
+    const vm = try allocator.create(VM);
+    defer allocator.destroy(vm);
+    try VM.init(vm, &[_]u8{ 0x13, 0x00, 0x00, 0x00 }, 0x1000);
+    defer vm.deinit();
+    const kernel = try allocator.create(BasinKernel);
+    defer allocator.destroy(kernel);
+    kernel.* = BasinKernel.init();
+    var integration = Integration.init_with_kernel(vm, kernel);
+    integration.finish_init();
+    defer integration.cleanup();
+
+    var header = [_]u8{0} ** 64;
+    @memcpy(header[0..4], "\x7fELF");
+    std.mem.writeInt(u64, header[24..32], CODE, .little);
+    try vm.write_memory(IMAGE, &header);
+    for (YIELD_LOOP, 0..) |word, i| {
+        var bytes: [4]u8 = undefined;
+        std.mem.writeInt(u32, &bytes, word, .little);
+        try vm.write_memory(CODE + 4 * i, &bytes);
+    }
+    var counter: [8]u8 = undefined;
+    std.mem.writeInt(u64, &counter, YIELDS, .little);
+    try vm.write_memory(COUNTER, &counter);
+
+    var spawned: u32 = 0;
+    while (spawned < processes) : (spawned += 1) {
+        _ = try kernel.handle_syscall(@intFromEnum(Syscall.spawn), IMAGE, COUNTER, 8, 0);
+    }
+
+    var timer = std.time.Timer.start() catch unreachable;
+    try integration.run();
+    const elapsed = timer.read();
+    if (try vm.read64(COUNTER) != 0) return error.YieldsIncomplete;
+    return elapsed;
+}
+
+/// Time TICKS single-tick advances with sleepers timers kept armed.
+fn time_ticks(allocator: std.mem.Allocator, sleepers: u32) !u64 {
+    const Wheel = basin_kernel.timer_wheel.TimerWheel(SLEEPERS[SLEEPERS.len - 1]);
+    const wheel = try allocator.create(Wheel);
+    defer allocator.destroy(wheel);
+    wheel.* = .{};
+
+    var prng = std.Random.DefaultPrng.init(sleepers);
+    const random = prng.random();
+    var id: u32 = 0;
+    while (id < sleepers) : (id += 1) {
+        wheel.arm(id, 1 + random.uintLessThan(u64, HORIZON));
+    }
+
+    var expired: u64 = 0;
+    var timer = std.time.Timer.start() catch unreachable;
+    var tick: u64 = 1;
+    while (tick <= TICKS) : (tick += 1) {
+        wheel.advance(tick);
+        while (wheel.pop_expired()) |due| {
+            wheel.arm(due, tick + 1 + random.uintLessThan(u64, HORIZON));
+            expired += 1;
+        }
+    }
+    const elapsed = timer.read();
+    std.mem.doNotOptimizeAway(expired);
+    if (wheel.pending() != sleepers) return error.SleepersLost;
+    return elapsed;
+}
+
+fn ns_per(total_ns: u64, count: u64) f64 {
+    return @as(f64, @floatFromInt(total_ns)) / @as(f64, @floatFromInt(@max(count, 1)));
+}
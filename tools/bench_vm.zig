@@ -0,0 +1,350 @@
+const std = @import("std");
+const kernel_vm = @import("kernel_vm");
+const VM = kernel_vm.VM;
+const SerialOutput = kernel_vm.SerialOutput;
+
+/// VM benchmark suite: guest RV64 workloads per engine, reported as JSON on stdout.
+/// Grain Style: Generated guest loops (no ELF needed), fixed iteration counts, best-of-N timing.
+/// ~<~ Glow Airbend: one number per workload, diffable across commits.
+///
+/// Why: kernel-vm-test checks behavior, not speed; interpreter regressions went unseen.
+/// Each workload is a counted loop dominated by one instruction class (ALU, memory,
+/// branches, ecalls, console output). It runs under the interpreter and under the JIT, and
+/// reports instructions per second and ns per instruction. Ecall workloads also report
+/// the round-trip latency per call.
+/// Note: The ecall workload calls a stub handler (returns 0), so it measures the VM side of
+/// a kernel syscall: trap, dispatch, handler call, a0 writeback. Console calls are SBI
+/// putchar into an attached SerialOutput.
+/// Note: Progress goes to stderr; stdout is only the JSON document (redirect it to a file
+/// and diff, e.g. `zig build bench-vm > bench.json`).
+
+/// JSON schema version (bump when fields change meaning).
+const SCHEMA_VERSION: u32 = 1;
+/// Timed runs per workload and engine (the fastest counts; one untimed warm-up first).
+const REPEATS: u32 = 5;
+/// Guest layout: code, and the streaming buffer (64KB, wrapped by masking).
+const CODE_BASE: u64 = 0x1000;
+const BUFFER_BASE: u64 = 0x10000;
+const BUFFER_MASK: u64 = 0xFFFF;
+/// run() batch size (large: the benchmark measures execution, not batch overhead).
+const RUN_SLICE: u64 = 1 << 20;
+/// Kernel syscall number the ecall workload uses (sysinfo; the stub ignores it).
+const SYSCALL_NUMBER: u64 = 50;
+
+/// Registers the loops use.
+const REG_COUNTER: u5 = 6;
+const REG_POINTER: u5 = 7;
+const REG_MASK: u5 = 28;
+const REG_BASE: u5 = 29;
+const REG_A0: u5 = 10;
+const REG_A7: u5 = 17;
+
+/// Instruction classes (by major opcode).
+const Class = enum { alu, load, store, branch, system };
+
+const Workload = enum {
+    alu,
+    memory,
+    branch,
+    ecall,
+    console,
+
+    /// Loop iterations (sized for ~1-4M retired instructions).
+    fn iterations(self: Workload) u64 {
+        return switch (self) {
+            .alu, .memory => 200_000,
+            .branch => 150_000,
+            .ecall, .console => 100_000,
+        };
+    }
+
+    /// Class the workload is meant to measure.
+    fn class(self: Workload) Class {
+        return switch (self) {
+            .alu => .alu,
+            .memory => .load,
+            .branch => .branch,
+            .ecall, .console => .system,
+        };
+    }
+};
+
+const ENGINES = [_]VM.ExecutionMode{ .interpreter, .jit };
+
+/// Guest program under construction.
+const Program = struct {
+    words: [256]u32 = undefined,
+    len: usize = 0,
+
+    fn emit(self: *Program, word: u32) void {
+        std.debug.assert(self.len < self.words.len);
+        self.words[self.len] = word;
+        self.len += 1;
+    }
+
+    /// Byte offset of the next word from CODE_BASE.
+    fn here(self: *const Program) u64 {
+        return 4 * @as(u64, self.len);
+    }
+};
+
+/// One measured workload on one engine.
+const Result = struct {
+    workload: Workload,
+    engine: VM.ExecutionMode,
+    instructions: u64,
+    best_ns: u64,
+    calls: u64,
+    /// Retired instructions per loop iteration, by class.
+    mix: [std.meta.fields(Class).len]u64,
+};
+
+pub fn main() !void {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    const allocator = gpa.allocator();
+
+    const serial = try allocator.create(SerialOutput);
+    defer allocator.destroy(serial);
+
+    var results: [ENGINES.len * std.meta.fields(Workload).len]Result = undefined;
+    var count: usize = 0;
+    for (ENGINES) |engine| {
+        const vm = try allocator.create(VM);
+        defer allocator.destroy(vm);
+        try VM.init_with_options(vm, &.{}, 0, .{ .execution_mode = engine });
+        defer vm.deinit();
+        if (vm.active_execution_mode() != engine) {
+            std.debug.print("[bench_vm] {s} unavailable on this host, skipped\n", .{@tagName(engine)});
+            continue;
+        }
+        vm.serial_output = serial;
+        vm.set_syscall_handler(stub_syscall, null);
+
+        inline for (comptime std.enums.values(Workload)) |workload| {
+            results[count] = try measure(vm, serial, engine, workload);
+            const result = &results[count];
+            std.debug.print("[bench_vm] {s:<11} {s:<8} {d:>8.1} MIPS {d:>7.2} ns/inst\n", .{
+                @tagName(engine), @tagName(workload), mips(result), ns_per(result.best_ns, result.instructions),
+            });
+            count += 1;
+        }
+    }
+
+    var stdout_buffer: [4096]u8 = undefined;
+    var stdout_writer = std.fs.File.stdout().writer(&stdout_buffer);
+    const stdout = &stdout_writer.interface;
+    try write_json(stdout, results[0..count]);
+    try stdout.flush();
+}
+
+/// Load workload into vm and time REPEATS runs to halt (after one warm-up run).
+fn measure(vm: *VM, serial: *SerialOutput, engine: VM.ExecutionMode, comptime workload: Workload) !Result {
+    var program = Program{};
+    const calls_per_iteration = emit_workload(&program, workload);
+    var bytes: [4 * 256]u8 = undefined;
+    for (program.words[0..program.len], 0..) |word, index| {
+        std.mem.writeInt(u32, bytes[4 * index ..][0..4], word, .little);
+    }
+    try vm.write_memory(CODE_BASE, bytes[0 .. 4 * program.len]);
+
+    var best_ns: u64 = std.math.maxInt(u64);
+    var instructions: u64 = 0;
+    var run: u32 = 0;
+    while (run <= REPEATS) : (run += 1) {
+        serial.* = .{};
+        reset_registers(vm, workload);
+        var timer = try std.time.Timer.start();
+        instructions = run_to_halt(vm);
+        const elapsed = timer.read();
+        if (run > 0) best_ns = @min(best_ns, elapsed);
+    }
+
+    // Assert: the loop ran to completion (shutdown, not a fault).
+    std.debug.assert(vm.state == .halted);
+    std.debug.assert(vm.regs.get(REG_COUNTER) == 0);
+    if (workload == .console) {
+        std.debug.assert(serial.total_written == calls_per_iteration * workload.iterations());
+    }
+
+    return .{
+        .workload = workload,
+        .engine = engine,
+        .instructions = instructions,
+        .best_ns = @max(best_ns, 1),
+        .calls = calls_per_iteration * workload.iterations(),
+        .mix = class_mix(&program),
+    };
+}
+
+fn reset_registers(vm: *VM, workload: Workload) void {
+    vm.regs = .{};
+    vm.regs.pc = CODE_BASE;
+    vm.regs.set(REG_COUNTER, workload.iterations());
+    vm.regs.set(REG_POINTER, BUFFER_BASE);
+    vm.regs.set(REG_MASK, BUFFER_MASK);
+    vm.regs.set(REG_BASE, BUFFER_BASE);
+    vm.regs.set(REG_A0, 0x2545F4914F6CDD1D); // xorshift state (non-zero)
+    for ([_]u5{ 11, 12, 13, 14 }, 1..) |reg, value| vm.regs.set(reg, value);
+    // Branch workload: shift amounts and bit masks.
+    for ([_]u5{ 20, 21, 22 }, [_]u64{ 13, 7, 17 }) |reg, value| vm.regs.set(reg, value);
+    for ([_]u5{ 23, 24, 25, 26 }, [_]u64{ 1, 2, 4, 8 }) |reg, value| vm.regs.set(reg, value);
+    vm.regs.set(REG_A7, switch (workload) {
+        .ecall => SYSCALL_NUMBER,
+        .console => 1, // SBI LEGACY_CONSOLE_PUTCHAR
+        else => 0,
+    });
+    vm.start();
+}
+
+fn run_to_halt(vm: *VM) u64 {
+    var total: u64 = 0;
+    while (true) {
+        const result = vm.run(.{ .max_instructions = RUN_SLICE });
+        total += result.instructions;
+        switch (result.exit) {
+            .budget_exhausted, .ecall, .wait => {},
+            .halted => return total,
+            .fault => {
+                const reason = if (vm.last_error) |err| @errorName(err) else "unknown";
+                std.debug.print("[bench_vm] guest fault at pc=0x{x}: {s}\n", .{ vm.regs.pc, reason });
+                @panic("bench_vm workload faulted");
+            },
+        }
+    }
+}
+
+/// Emit loop body, loop control and shutdown; returns ecalls per iteration.
+/// Note: OP-IMM here decodes only ADDI, so shifts and masks use register forms.
+fn emit_workload(program: *Program, workload: Workload) u64 {
+    const loop = program.here();
+    var calls: u64 = 0;
+    switch (workload) {
+        // 16 dependent register ALU ops over x10..x14.
+        .alu => {
+            const ops = [_][2]u32{ .{ 0, 0 }, .{ 0, 4 }, .{ 0x20, 0 }, .{ 0, 6 }, .{ 0, 7 }, .{ 0, 2 }, .{ 0, 3 }, .{ 0x01, 0 } };
+            for (0..16) |index| {
+                const op = ops[index % ops.len];
+                const rd: u5 = @intCast(10 + index % 4);
+                const rs2: u5 = @intCast(11 + (index + 1) % 4);
+                program.emit(rv_r(op[0], rs2, rd, op[1], rd));
+            }
+        },
+        // Stream 64 bytes per iteration: 4 loads, 4 stores, pointer advance with wrap.
+        .memory => {
+            for (0..4) |index| program.emit(rv_i(8 * index, REG_POINTER, 3, @intCast(10 + index), 0x03));
+            for (0..4) |index| program.emit(rv_s(32 + 8 * index, @intCast(10 + index), REG_POINTER, 3));
+            program.emit(rv_i(64, REG_POINTER, 0, REG_POINTER, 0x13));
+            program.emit(rv_r(0, REG_MASK, REG_POINTER, 7, REG_POINTER)); // and
+            program.emit(rv_r(0, REG_BASE, REG_POINTER, 6, REG_POINTER)); // or
+        },
+        // xorshift64 step, then four data-dependent branches over its low bits.
+        .branch => {
+            for ([_]u5{ 20, 21, 22 }, [_]u32{ 1, 5, 1 }) |shift, funct3| {
+                program.emit(rv_r(0, shift, 10, funct3, 11)); // sll/srl x11, x10, shift
+                program.emit(rv_r(0, 11, 10, 4, 10)); // xor x10, x10, x11
+            }
+            for ([_]u5{ 23, 24, 25, 26 }) |mask| {
+                program.emit(rv_r(0, mask, 10, 7, 12)); // and x12, x10, mask
+                program.emit(rv_b(8, 0, 12, 0)); // beq x12, x0, +8
+                program.emit(rv_r(0, 23, 13, 0, 13)); // add x13, x13, 1
+            }
+        },
+        // Kernel syscalls back to back (a7 preset, stub handler).
+        .ecall => {
+            for (0..4) |_| program.emit(ECALL);
+            calls = 4;
+        },
+        // SBI putchar (a7 preset; putchar clears a0, so reload it).
+        .console => {
+            for (0..4) |_| {
+                program.emit(rv_i('.', 0, 0, REG_A0, 0x13));
+                program.emit(ECALL);
+            }
+            calls = 4;
+        },
+    }
+    program.emit(rv_i(@bitCast(@as(i64, -1)), REG_COUNTER, 0, REG_COUNTER, 0x13));
+    program.emit(rv_b(loop -% program.here(), 0, REG_COUNTER, 1)); // bne counter, x0, loop
+    program.emit(rv_i(8, 0, 0, REG_A7, 0x13)); // SBI LEGACY_SHUTDOWN
+    program.emit(ECALL);
+    return calls;
+}
+
+/// Retired instructions per loop iteration by class (body and loop control, not the tail).
+fn class_mix(program: *const Program) [std.meta.fields(Class).len]u64 {
+    var mix = [_]u64{0} ** std.meta.fields(Class).len;
+    for (program.words[0 .. program.len - 2]) |word| {
+        const class: Class = switch (word & 0x7F) {
+            0x03 => .load,
+            0x23 => .store,
+            0x63, 0x67, 0x6F => .branch,
+            0x73 => .system,
+            else => .alu,
+        };
+        mix[@intFromEnum(class)] += 1;
+    }
+    return mix;
+}
+
+fn stub_syscall(syscall_num: u32, arg1: u64, arg2: u64, arg3: u64, arg4: u64) u64 {
+    _ = syscall_num;
+    _ = arg1;
+    _ = arg2;
+    _ = arg3;
+    _ = arg4;
+    return 0;
+}
+
+fn write_json(writer: *std.Io.Writer, results: []const Result) !void {
+    try writer.print("{{\n  \"benchmark\": \"bench-vm\",\n  \"schema\": {d},\n  \"repeats\": {d},\n  \"results\": [\n", .{ SCHEMA_VERSION, REPEATS });
+    for (results, 0..) |*result, index| {
+        try writer.print("    {{\"workload\": \"{s}\", \"engine\": \"{s}\", \"class\": \"{s}\", \"iterations\": {d}, ", .{
+            @tagName(result.workload), @tagName(result.engine), @tagName(result.workload.class()), result.workload.iterations(),
+        });
+        try writer.print("\"instructions\": {d}, \"ns\": {d}, \"mips\": {d:.2}, \"ns_per_instruction\": {d:.3}, ", .{
+            result.instructions, result.best_ns, mips(result), ns_per(result.best_ns, result.instructions),
+        });
+        if (result.calls > 0) {
+            try writer.print("\"calls\": {d}, \"ns_per_call\": {d:.2}, ", .{ result.calls, ns_per(result.best_ns, result.calls) });
+        } else {
+            try writer.writeAll("\"calls\": 0, \"ns_per_call\": null, ");
+        }
+        try writer.writeAll("\"mix\": {");
+        inline for (std.meta.fields(Class), 0..) |field, class| {
+            if (class > 0) try writer.writeAll(", ");
+            try writer.print("\"{s}\": {d}", .{ field.name, result.mix[class] });
+        }
+        try writer.writeAll(if (index + 1 < results.len) "},\n" else "}\n");
+    }
+    try writer.writeAll("  ]\n}\n");
+}
+
+fn mips(result: *const Result) f64 {
+    return @as(f64, @floatFromInt(result.instructions)) * 1000.0 / @as(f64, @floatFromInt(result.best_ns));
+}
+
+fn ns_per(total_ns: u64, count: u64) f64 {
+    return @as(f64, @floatFromInt(total_ns)) / @as(f64, @floatFromInt(@max(count, 1)));
+}
+
+const ECALL: u32 = 0x00000073;
+
+fn rv_r(funct7: u32, rs2: u5, rs1: u5, funct3: u32, rd: u5) u32 {
+    return (funct7 << 25) | (@as(u32, rs2) << 20) | (@as(u32, rs1) << 15) | (funct3 << 12) | (@as(u32, rd) << 7) | 0x33;
+}
+
+fn rv_i(imm: u64, rs1: u5, funct3: u32, rd: u5, opcode: u32) u32 {
+    return (@as(u32, @intCast(imm & 0xFFF)) << 20) | (@as(u32, rs1) << 15) | (funct3 << 12) | (@as(u32, rd) << 7) | opcode;
+}
+
+fn rv_s(imm: u64, rs2: u5, rs1: u5, funct3: u32) u32 {
+    const bits: u32 = @intCast(imm & 0xFFF);
+    return ((bits >> 5) << 25) | (@as(u32, rs2) << 20) | (@as(u32, rs1) << 15) | (funct3 << 12) | ((bits & 0x1F) << 7) | 0x23;
+}
+
+fn rv_b(imm: u64, rs2: u5, rs1: u5, funct3: u32) u32 {
+    const bits: u32 = @intCast(imm & 0x1FFE);
+    return (((bits >> 12) & 1) << 31) | (((bits >> 5) & 0x3F) << 25) | (@as(u32, rs2) << 20) | (@as(u32, rs1) << 15) |
+        (funct3 << 12) | (((bits >> 1) & 0xF) << 8) | (((bits >> 11) & 1) << 7) | 0x63;
+}
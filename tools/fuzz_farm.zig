@@ -0,0 +1,1073 @@
+const std = @import("std");
+const kernel_vm = @import("kernel_vm");
+const basin_kernel = @import("basin_kernel");
+const VM = kernel_vm.VM;
+const BasinKernel = basin_kernel.BasinKernel;
+
+/// Parallel coverage-guided fuzz farm for the RISC-V VM and the Basin kernel.
+/// Grain Style: One VM pair and one kernel per worker, fixed-size inputs, no allocation per case.
+/// ~<~ Glow Earthbend: every core tills its own rows; new edges are the seeds worth keeping.
+///
+/// Why: fuzz-004..007 run fixed seeds one after another on one core and forget what they
+/// reached. The farm splits a seed range across every core (work stealing), keeps inputs
+/// that reach new guest control-flow edges or new kernel syscall outcomes, and minimizes
+/// crashing inputs automatically.
+/// Note: A seed either generates a fresh program or mutates a corpus entry, so which input
+/// a seed yields depends on the corpus at that moment; crash files hold the input itself.
+/// Note: The interpreter run supplies coverage (one run() per instruction). The JIT run of
+/// the same input must agree on exit, registers, CSRs and every dirtied page.
+/// Note: Crashes are host panics (VM or kernel assertions, checked arithmetic) and engine
+/// divergence. The panicking worker saves its input; the supervising parent process then
+/// minimizes it by replaying candidates in child processes (a panic cannot be caught).
+///
+/// Usage: zig build fuzz-farm -- [--seeds N] [--start S] [--workers W] [--corpus DIR] [--crashes DIR]
+///        fuzz_farm --replay FILE      run one input (exit status reports the crash)
+///        fuzz_farm --minimize FILE    shrink a crashing input into the crash directory
+
+/// Seeds run when --seeds is not given.
+const DEFAULT_SEEDS: u64 = 100_000;
+/// Crash directory when --crashes is not given.
+const DEFAULT_CRASH_DIR = "fuzz-crashes";
+/// File the panicking worker writes; the supervisor minimizes it.
+const LAST_CRASH_NAME = "last-crash.bin";
+
+/// Program words per input (the harness appends an SBI shutdown after them).
+const MAX_WORDS: usize = 48;
+/// Argument registers seeded from the input (a0..a5).
+const ARG_REGS: usize = 6;
+/// Guest addresses: code page, and the data page x5 points at.
+const CODE_BASE: u64 = 0x1000;
+const DATA_BASE: u64 = 0x4000;
+/// Guest RAM granule compared after each case (VM page size).
+const PAGE_SIZE: usize = 4096;
+/// Instructions retired per engine per case.
+const CASE_BUDGET: u64 = 1024;
+
+/// Coverage map size in bits (edge and syscall-outcome hashes index it).
+const COVERAGE_BITS: usize = 1 << 16;
+const COVERAGE_WORDS: usize = COVERAGE_BITS / 64;
+/// Distinct coverage bits one case can set (one edge per instruction, one outcome per ecall).
+const MAX_TOUCHED: usize = 2 * CASE_BUDGET;
+/// Corpus entries kept in memory (later coverage still counts, the input is dropped).
+const CORPUS_MAX: usize = 8192;
+/// Percent of seeds that generate a fresh program even when the corpus is non-empty.
+const FRESH_PERCENT: u64 = 20;
+/// Seeds a worker claims from its shard at once.
+const SEED_BATCH: u64 = 32;
+/// Replays the minimizer may spend on one crash.
+const MINIMIZE_ATTEMPTS: u32 = 512;
+/// Interval between progress lines.
+const PROGRESS_INTERVAL_NS: u64 = 2 * std.time.ns_per_s;
+
+/// Input file header magic.
+const INPUT_MAGIC = "XYFZ".*;
+
+/// RISC-V encodings the generator uses.
+const REG_DATA: u5 = 5; // x5: DATA_BASE
+const REG_A7: u5 = 17;
+const INST_ECALL: u32 = 0x00000073;
+const INST_NOP: u32 = 0x00000013;
+const SBI_SHUTDOWN: u64 = 8;
+
+/// Kernel syscall numbers (>= 10) the generator calls; SBI EIDs are 0..SBI_SHUTDOWN.
+const KERNEL_SYSCALLS = blk: {
+    const all = std.enums.values(basin_kernel.Syscall);
+    var count: usize = 0;
+    for (all) |syscall| {
+        if (@intFromEnum(syscall) >= 10) count += 1;
+    }
+    var list: [count]u32 = undefined;
+    var index: usize = 0;
+    for (all) |syscall| {
+        if (@intFromEnum(syscall) < 10) continue;
+        list[index] = @intFromEnum(syscall);
+        index += 1;
+    }
+    const final = list;
+    break :blk final;
+};
+
+comptime {
+    std.debug.assert(std.math.isPowerOfTwo(COVERAGE_BITS));
+    std.debug.assert(CODE_BASE + 4 * (MAX_WORDS + 2) <= DATA_BASE);
+    std.debug.assert(KERNEL_SYSCALLS.len > 0);
+}
+
+/// One fuzz case: a program, and the argument registers it starts with.
+const Input = struct {
+    words: [MAX_WORDS]u32 = [_]u32{INST_NOP} ** MAX_WORDS,
+    len: u32 = 0,
+    args: [ARG_REGS]u64 = [_]u64{0} ** ARG_REGS,
+
+    const HEADER_SIZE = INPUT_MAGIC.len + 4 + 8 * ARG_REGS;
+    const FILE_MAX = HEADER_SIZE + 4 * MAX_WORDS;
+
+    fn code(self: *const Input) []const u32 {
+        return self.words[0..self.len];
+    }
+
+    /// Insert words at index (caller checks room).
+    fn insert(self: *Input, index: u32, words: []const u32) void {
+        std.debug.assert(index <= self.len);
+        std.debug.assert(self.len + words.len <= MAX_WORDS);
+        const count: u32 = @intCast(words.len);
+        std.mem.copyBackwards(u32, self.words[index + count .. self.len + count], self.words[index..self.len]);
+        @memcpy(self.words[index..][0..count], words);
+        self.len += count;
+    }
+
+    /// Remove count words at index.
+    fn remove(self: *Input, index: u32, count: u32) void {
+        std.debug.assert(index + count <= self.len);
+        std.mem.copyForwards(u32, self.words[index .. self.len - count], self.words[index + count .. self.len]);
+        self.len -= count;
+    }
+
+    /// Serialize: magic, word count, args, words (all little-endian).
+    fn encode(self: *const Input, buffer: *[FILE_MAX]u8) []const u8 {
+        @memcpy(buffer[0..INPUT_MAGIC.len], &INPUT_MAGIC);
+        std.mem.writeInt(u32, buffer[4..8], self.len, .little);
+        for (self.args, 0..) |arg, index| {
+            std.mem.writeInt(u64, buffer[8 + 8 * index ..][0..8], arg, .little);
+        }
+        for (self.code(), 0..) |word, index| {
+            std.mem.writeInt(u32, buffer[HEADER_SIZE + 4 * index ..][0..4], word, .little);
+        }
+        return buffer[0 .. HEADER_SIZE + 4 * self.len];
+    }
+
+    fn decode(bytes: []const u8) error{InvalidInput}!Input {
+        if (bytes.len < HEADER_SIZE or !std.mem.eql(u8, bytes[0..INPUT_MAGIC.len], &INPUT_MAGIC)) {
+            return error.InvalidInput;
+        }
+        const len = std.mem.readInt(u32, bytes[4..8], .little);
+        if (len > MAX_WORDS or bytes.len != HEADER_SIZE + 4 * @as(usize, len)) return error.InvalidInput;
+
+        var input = Input{ .len = len };
+        for (&input.args, 0..) |*arg, index| {
+            arg.* = std.mem.readInt(u64, bytes[8 + 8 * index ..][0..8], .little);
+        }
+        for (input.words[0..len], 0..) |*word, index| {
+            word.* = std.mem.readInt(u32, bytes[HEADER_SIZE + 4 * index ..][0..4], .little);
+        }
+        return input;
+    }
+
+    fn hash(self: *const Input) u64 {
+        var buffer: [FILE_MAX]u8 = undefined;
+        return std.hash.Wyhash.hash(0, self.encode(&buffer));
+    }
+};
+
+/// SplitMix64: one u64 of state, so a seed number is a complete RNG state.
+const Rng = struct {
+    state: u64,
+
+    fn next(self: *Rng) u64 {
+        self.state +%= 0x9E3779B97F4A7C15;
+        var z = self.state;
+        z = (z ^ (z >> 30)) *% 0xBF58476D1CE4E5B9;
+        z = (z ^ (z >> 27)) *% 0x94D049BB133111EB;
+        return z ^ (z >> 31);
+    }
+
+    fn below(self: *Rng, bound: u64) u64 {
+        std.debug.assert(bound > 0);
+        return self.next() % bound;
+    }
+
+    fn chance(self: *Rng, percent: u64) bool {
+        return self.below(100) < percent;
+    }
+};
+
+// RISC-V encoders (RV64I/M formats).
+fn rv_r(funct7: u7, rs2: u5, rs1: u5, funct3: u3, rd: u5, opcode: u7) u32 {
+    return (@as(u32, funct7) << 25) | (@as(u32, rs2) << 20) | (@as(u32, rs1) << 15) |
+        (@as(u32, funct3) << 12) | (@as(u32, rd) << 7) | opcode;
+}
+
+fn rv_i(imm: u12, rs1: u5, funct3: u3, rd: u5, opcode: u7) u32 {
+    return (@as(u32, imm) << 20) | (@as(u32, rs1) << 15) | (@as(u32, funct3) << 12) | (@as(u32, rd) << 7) | opcode;
+}
+
+fn rv_s(imm: u12, rs2: u5, rs1: u5, funct3: u3, opcode: u7) u32 {
+    const high: u32 = imm >> 5;
+    const low: u32 = imm & 0x1F;
+    return (high << 25) | (@as(u32, rs2) << 20) | (@as(u32, rs1) << 15) | (@as(u32, funct3) << 12) | (low << 7) | opcode;
+}
+
+fn rv_b(offset: i13, rs2: u5, rs1: u5, funct3: u3) u32 {
+    const imm: u32 = @as(u13, @bitCast(offset));
+    return (((imm >> 12) & 1) << 31) | (((imm >> 5) & 0x3F) << 25) | (@as(u32, rs2) << 20) | (@as(u32, rs1) << 15) |
+        (@as(u32, funct3) << 12) | (((imm >> 1) & 0xF) << 8) | (((imm >> 11) & 1) << 7) | 0b1100011;
+}
+
+fn rv_u(imm20: u20, rd: u5, opcode: u7) u32 {
+    return (@as(u32, imm20) << 12) | (@as(u32, rd) << 7) | opcode;
+}
+
+/// Destination registers: a0..s4 (x10..x20), so x5 keeps pointing at the data page.
+fn pick_rd(rng: *Rng) u5 {
+    return @intCast(10 + rng.below(11));
+}
+
+/// Source registers: destinations plus x0 and the data pointer.
+fn pick_rs(rng: *Rng) u5 {
+    const choice = rng.below(13);
+    if (choice == 0) return 0;
+    if (choice == 1) return REG_DATA;
+    return @intCast(8 + choice);
+}
+
+/// Boundary-heavy values for argument registers.
+fn interesting_value(rng: *Rng) u64 {
+    return switch (rng.below(10)) {
+        0 => 0,
+        1 => 1,
+        2 => std.math.maxInt(u64),
+        3 => DATA_BASE,
+        4 => DATA_BASE + rng.below(PAGE_SIZE),
+        5 => 0x7FF,
+        6 => 0x8000_0000,
+        7 => std.math.maxInt(i64),
+        8 => rng.below(64),
+        else => rng.next(),
+    };
+}
+
+/// Emit one gadget (one or two words) for position at into out; returns the words.
+fn gadget(rng: *Rng, at: u32, out: *[2]u32) []const u32 {
+    switch (rng.below(16)) {
+        // Register ALU (OP, OP-32, with M-extension forms).
+        0...4 => {
+            const funct3: u3 = @intCast(rng.below(8));
+            const funct7: u7 = switch (rng.below(4)) {
+                0 => 0x01,
+                1 => if (funct3 == 0 or funct3 == 5) 0x20 else 0,
+                else => 0,
+            };
+            const opcode: u7 = if (rng.chance(25)) 0b0111011 else 0b0110011;
+            out[0] = rv_r(funct7, pick_rs(rng), pick_rs(rng), funct3, pick_rd(rng), opcode);
+        },
+        5, 6 => out[0] = rv_i(@truncate(rng.next()), pick_rs(rng), 0, pick_rd(rng), 0b0010011),
+        7 => out[0] = rv_u(@truncate(rng.next()), pick_rd(rng), if (rng.chance(50)) 0b0110111 else 0b0010111),
+        // Loads and stores off the data page (any width, possibly misaligned).
+        8, 9 => {
+            const funct3: u3 = @intCast(rng.below(7));
+            out[0] = rv_i(@intCast(rng.below(256)), REG_DATA, funct3, pick_rd(rng), 0b0000011);
+        },
+        10, 11 => {
+            const funct3: u3 = @intCast(rng.below(4));
+            out[0] = rv_s(@intCast(rng.below(256)), pick_rs(rng), REG_DATA, funct3, 0b0100011);
+        },
+        // Branch to any word of the program (loops are bounded by CASE_BUDGET).
+        12, 13 => {
+            const target: i64 = @intCast(rng.below(MAX_WORDS));
+            const offset: i13 = @intCast(4 * (target - @as(i64, at)));
+            const conditions = [_]u3{ 0, 1, 4, 5, 6, 7 }; // beq bne blt bge bltu bgeu
+            const funct3 = conditions[rng.below(conditions.len)];
+            out[0] = rv_b(offset, pick_rs(rng), pick_rs(rng), funct3);
+        },
+        // ECALL with a valid SBI EID or kernel syscall number.
+        14 => {
+            const number: u64 = if (rng.chance(50)) rng.below(SBI_SHUTDOWN) else KERNEL_SYSCALLS[rng.below(KERNEL_SYSCALLS.len)];
+            out[0] = rv_i(@intCast(number), 0, 0, REG_A7, 0b0010011);
+            out[1] = INST_ECALL;
+            return out[0..2];
+        },
+        // Raw word: decoder coverage (invalid encodings fault cleanly).
+        else => out[0] = @truncate(rng.next()),
+    }
+    return out[0..1];
+}
+
+/// Fresh program of 4..MAX_WORDS words.
+fn generate(rng: *Rng, input: *Input) void {
+    input.* = .{};
+    for (&input.args) |*arg| arg.* = interesting_value(rng);
+    const target_len = 4 + rng.below(MAX_WORDS - 4);
+    var scratch: [2]u32 = undefined;
+    while (input.len < target_len) {
+        const words = gadget(rng, input.len, &scratch);
+        if (input.len + words.len > MAX_WORDS) break;
+        input.insert(input.len, words);
+    }
+    std.debug.assert(input.len >= 1);
+}
+
+/// Apply 1..4 random edits to a corpus entry.
+fn mutate(rng: *Rng, input: *Input) void {
+    var scratch: [2]u32 = undefined;
+    var rounds = 1 + rng.below(4);
+    while (rounds > 0) : (rounds -= 1) {
+        switch (rng.below(6)) {
+            0 => if (input.len > 0) {
+                const index: u32 = @intCast(rng.below(input.len));
+                input.words[index] = gadget(rng, index, &scratch)[0];
+            },
+            1 => if (input.len > 0) {
+                const index = rng.below(input.len);
+                input.words[index] ^= @as(u32, 1) << @intCast(rng.below(32));
+            },
+            2 => if (input.len > 1) {
+                input.remove(@intCast(rng.below(input.len)), 1);
+            },
+            3 => {
+                const index: u32 = @intCast(rng.below(input.len + 1));
+                const words = gadget(rng, index, &scratch);
+                if (input.len + words.len <= MAX_WORDS) input.insert(index, words);
+            },
+            4 => input.args[rng.below(ARG_REGS)] = interesting_value(rng),
+            else => input.args[rng.below(ARG_REGS)] ^= @as(u64, 1) << @intCast(rng.below(64)),
+        }
+    }
+}
+
+/// Coverage bits one case touched (cleared in O(touched), not O(map)).
+const Trace = struct {
+    bits: [COVERAGE_WORDS]u64 = [_]u64{0} ** COVERAGE_WORDS,
+    touched: [MAX_TOUCHED]u32 = undefined,
+    touched_len: usize = 0,
+
+    fn clear(self: *Trace) void {
+        for (self.touched[0..self.touched_len]) |index| self.bits[index / 64] = 0;
+        self.touched_len = 0;
+    }
+
+    fn hit(self: *Trace, key: u64) void {
+        const index: u32 = @intCast(std.hash.int(key) & (COVERAGE_BITS - 1));
+        const mask = @as(u64, 1) << @intCast(index % 64);
+        if (self.bits[index / 64] & mask != 0) return;
+        self.bits[index / 64] |= mask;
+        if (self.touched_len < MAX_TOUCHED) {
+            self.touched[self.touched_len] = index;
+            self.touched_len += 1;
+        }
+    }
+
+    /// Guest control-flow edge (PC before and after one instruction).
+    fn edge(self: *Trace, from: u64, to: u64) void {
+        self.hit((from >> 2) ^ (to << 17));
+    }
+
+    /// Kernel syscall path: number and outcome (0 for success, else the error code).
+    fn syscall(self: *Trace, number: u32, outcome: u64) void {
+        self.hit((@as(u64, 0xB5) << 56) ^ (@as(u64, number) << 32) ^ (outcome & 0xFFFF_FFFF));
+    }
+};
+
+/// Farm-wide coverage map (merged with atomic OR, never cleared).
+const Coverage = struct {
+    words: [COVERAGE_WORDS]std.atomic.Value(u64) = [_]std.atomic.Value(u64){.init(0)} ** COVERAGE_WORDS,
+
+    /// Merge a case's bits; returns how many were new to the farm.
+    fn merge(self: *Coverage, trace: *const Trace) u32 {
+        var fresh: u32 = 0;
+        for (trace.touched[0..trace.touched_len]) |index| {
+            const mask = @as(u64, 1) << @intCast(index % 64);
+            const before = self.words[index / 64].fetchOr(mask, .monotonic);
+            if (before & mask == 0) fresh += 1;
+        }
+        return fresh;
+    }
+
+    fn count(self: *const Coverage) u64 {
+        var total: u64 = 0;
+        for (&self.words) |*word| total += @popCount(word.load(.monotonic));
+        return total;
+    }
+};
+
+/// Seed range [start, end).
+const Range = struct {
+    start: u64,
+    end: u64,
+};
+
+/// One worker's seed range; the owner takes batches from the front, thieves take the back half.
+const Shard = struct {
+    lock: std.Thread.Mutex = .{},
+    next: u64 = 0,
+    end: u64 = 0,
+
+    fn take(self: *Shard, max: u64) ?Range {
+        self.lock.lock();
+        defer self.lock.unlock();
+        if (self.next == self.end) return null;
+        const start = self.next;
+        self.next += @min(max, self.end - self.next);
+        return .{ .start = start, .end = self.next };
+    }
+
+    fn steal(self: *Shard) ?Range {
+        self.lock.lock();
+        defer self.lock.unlock();
+        const left = self.end - self.next;
+        if (left == 0) return null;
+        const half = (left + 1) / 2;
+        self.end -= half;
+        return .{ .start = self.end, .end = self.end + half };
+    }
+
+    fn give(self: *Shard, range: Range) void {
+        self.lock.lock();
+        defer self.lock.unlock();
+        // Assert: only an empty shard receives stolen seeds.
+        std.debug.assert(self.next == self.end);
+        self.next = range.start;
+        self.end = range.end;
+    }
+
+    fn remaining(self: *Shard) u64 {
+        self.lock.lock();
+        defer self.lock.unlock();
+        return self.end - self.next;
+    }
+};
+
+/// Command line.
+const Options = struct {
+    mode: enum { supervise, farm, replay, minimize } = .supervise,
+    seeds: u64 = DEFAULT_SEEDS,
+    start: u64 = 0,
+    workers: u32 = 0, // 0: one per CPU
+    corpus_dir: ?[]const u8 = null,
+    crash_dir: []const u8 = DEFAULT_CRASH_DIR,
+    input_path: ?[]const u8 = null,
+};
+
+/// State shared by every worker.
+const Farm = struct {
+    shards: []Shard,
+    coverage: Coverage = .{},
+    corpus_lock: std.Thread.Mutex = .{},
+    corpus: std.ArrayListUnmanaged(Input) = .{},
+    corpus_storage: ?std.fs.Dir = null,
+    execs: std.atomic.Value(u64) = .init(0),
+    finished: std.atomic.Value(u32) = .init(0),
+
+    /// Next seed batch for worker id: own shard first, else steal from the fullest shard.
+    fn next_range(self: *Farm, id: usize) ?Range {
+        const own = &self.shards[id];
+        while (true) {
+            if (own.take(SEED_BATCH)) |range| return range;
+
+            var victim: ?*Shard = null;
+            var most: u64 = 0;
+            for (self.shards, 0..) |*shard, index| {
+                if (index == id) continue;
+                const left = shard.remaining();
+                if (left > most) {
+                    most = left;
+                    victim = shard;
+                }
+            }
+            const shard = victim orelse return null;
+            // A racing thief may have emptied the victim; rescan.
+            if (shard.steal()) |stolen| own.give(stolen);
+        }
+    }
+
+    /// Copy a random corpus entry into input; false if the seed should generate instead.
+    fn pick(self: *Farm, rng: *Rng, input: *Input) bool {
+        if (rng.chance(FRESH_PERCENT)) return false;
+        self.corpus_lock.lock();
+        defer self.corpus_lock.unlock();
+        if (self.corpus.items.len == 0) return false;
+        input.* = self.corpus.items[rng.below(self.corpus.items.len)];
+        return true;
+    }
+
+    /// Keep an input that reached new coverage (in memory, and on disk with --corpus).
+    fn keep(self: *Farm, allocator: std.mem.Allocator, input: *const Input) void {
+        {
+            self.corpus_lock.lock();
+            defer self.corpus_lock.unlock();
+            if (self.corpus.items.len < CORPUS_MAX) {
+                self.corpus.append(allocator, input.*) catch {};
+            }
+        }
+        if (self.corpus_storage) |dir| {
+            var name_buffer: [32]u8 = undefined;
+            const name = std.fmt.bufPrint(&name_buffer, "{x:0>16}.bin", .{input.hash()}) catch unreachable;
+            var buffer: [Input.FILE_MAX]u8 = undefined;
+            dir.writeFile(.{ .sub_path = name, .data = input.encode(&buffer) }) catch |err| {
+                std.debug.print("[fuzz_farm] cannot write corpus entry {s}: {s}\n", .{ name, @errorName(err) });
+            };
+        }
+    }
+};
+
+/// Where an engine stopped after CASE_BUDGET instructions.
+const Stop = enum { running, halted, fault };
+
+/// One engine's view of a finished case.
+const Outcome = struct {
+    stop: Stop,
+    retired: u64,
+};
+
+/// Worker: interpreter VM (coverage), JIT VM (oracle), and the kernel both call into.
+const Worker = struct {
+    id: usize,
+    allocator: std.mem.Allocator,
+    farm: ?*Farm,
+    interp: *VM,
+    jit: *VM,
+    interp_snapshot: VM.Snapshot,
+    jit_snapshot: VM.Snapshot,
+    kernel: *BasinKernel,
+    kernel_template: *const BasinKernel,
+    /// Set while the interpreter run records coverage.
+    tracing: bool = false,
+    trace: Trace = .{},
+    /// Input in flight (saved by the panic handler).
+    current: Input = .{},
+    current_seed: ?u64 = null,
+    execs: u64 = 0,
+
+    const Self = @This();
+
+    fn create(allocator: std.mem.Allocator, id: usize, farm: ?*Farm, kernel_template: *const BasinKernel) !*Self {
+        const self = try allocator.create(Self);
+        errdefer allocator.destroy(self);
+        const interp = try create_vm(allocator, .interpreter);
+        errdefer destroy_vm(allocator, interp);
+        const jit = try create_vm(allocator, .jit);
+        errdefer destroy_vm(allocator, jit);
+        const kernel = try allocator.create(BasinKernel);
+        errdefer allocator.destroy(kernel);
+
+        var interp_snapshot = try interp.snapshot(allocator);
+        errdefer interp_snapshot.deinit(allocator);
+        const jit_snapshot = try jit.snapshot(allocator);
+        self.* = .{
+            .id = id,
+            .allocator = allocator,
+            .farm = farm,
+            .interp = interp,
+            .jit = jit,
+            .interp_snapshot = interp_snapshot,
+            .jit_snapshot = jit_snapshot,
+            .kernel = kernel,
+            .kernel_template = kernel_template,
+        };
+        return self;
+    }
+
+    fn destroy(self: *Self) void {
+        const allocator = self.allocator;
+        self.interp_snapshot.deinit(allocator);
+        self.jit_snapshot.deinit(allocator);
+        destroy_vm(allocator, self.interp);
+        destroy_vm(allocator, self.jit);
+        allocator.destroy(self.kernel);
+        allocator.destroy(self);
+    }
+
+    /// Thread entry: fuzz seed batches until no shard has any left.
+    fn work(self: *Self) void {
+        const farm = self.farm.?;
+        active_worker = self;
+        defer active_worker = null;
+        defer _ = farm.finished.fetchAdd(1, .release);
+
+        while (farm.next_range(self.id)) |range| {
+            var seed = range.start;
+            while (seed < range.end) : (seed += 1) {
+                self.fuzz_one(seed);
+            }
+        }
+    }
+
+    fn fuzz_one(self: *Self, seed: u64) void {
+        const farm = self.farm.?;
+        var rng = Rng{ .state = seed };
+        var input: Input = undefined;
+        if (farm.pick(&rng, &input)) {
+            mutate(&rng, &input);
+        } else {
+            generate(&rng, &input);
+        }
+
+        self.current_seed = seed;
+        self.execute(&input);
+        self.current_seed = null;
+        if (farm.coverage.merge(&self.trace) > 0) farm.keep(self.allocator, &input);
+        self.execs += 1;
+        _ = farm.execs.fetchAdd(1, .monotonic);
+    }
+
+    /// Run input on both engines; panics if they disagree.
+    fn execute(self: *Self, input: *const Input) void {
+        self.current = input.*;
+        self.trace.clear();
+        const interp = self.run_engine(self.interp, &self.interp_snapshot, true);
+        const jit = self.run_engine(self.jit, &self.jit_snapshot, false);
+
+        if (!std.meta.eql(interp, jit) or !engines_agree(self.interp, self.jit)) {
+            std.debug.print("[fuzz_farm] divergence: interpreter {s} after {d}, jit {s} after {d} (pc 0x{x} vs 0x{x})\n", .{
+                @tagName(interp.stop), interp.retired, @tagName(jit.stop), jit.retired, self.interp.regs.pc, self.jit.regs.pc,
+            });
+            @panic("interpreter and JIT disagree");
+        }
+    }
+
+    fn run_engine(self: *Self, vm: *VM, snap: *const VM.Snapshot, traced: bool) Outcome {
+        vm.restore(snap);
+        load_input(vm, &self.current);
+        self.kernel.copy_from(self.kernel_template);
+        self.kernel.attach_user_memory(kernel_vm.user_memory(vm));
+        self.tracing = traced;
+        defer self.tracing = false;
+
+        var retired: u64 = 0;
+        while (retired < CASE_BUDGET) {
+            const from = vm.regs.pc;
+            const result = vm.run(.{ .max_instructions = if (traced) 1 else CASE_BUDGET - retired });
+            retired += result.instructions;
+            // WFI: standalone callers continue; both engines see the same virtual time.
+            vm.wait_requested = false;
+            if (traced and result.instructions > 0) self.trace.edge(from, vm.regs.pc);
+            switch (result.exit) {
+                .halted => return .{ .stop = .halted, .retired = retired },
+                .fault => return .{ .stop = .fault, .retired = retired },
+                .budget_exhausted, .ecall, .wait => {},
+            }
+        }
+        return .{ .stop = .running, .retired = retired };
+    }
+};
+
+/// Worker whose case runs on this thread (syscall handler and panic handler read it).
+threadlocal var active_worker: ?*Worker = null;
+
+fn create_vm(allocator: std.mem.Allocator, mode: VM.ExecutionMode) !*VM {
+    const vm = try allocator.create(VM);
+    errdefer allocator.destroy(vm);
+    try VM.init_with_options(vm, &.{}, 0, .{ .execution_mode = mode });
+    vm.set_syscall_handler(syscall_handler, null);
+    return vm;
+}
+
+fn destroy_vm(allocator: std.mem.Allocator, vm: *VM) void {
+    vm.deinit();
+    allocator.destroy(vm);
+}
+
+/// Write the program (plus SBI shutdown) and set up registers after restore.
+fn load_input(vm: *VM, input: *const Input) void {
+    var words: [MAX_WORDS + 2]u32 = undefined;
+    @memcpy(words[0..input.len], input.code());
+    words[input.len] = rv_i(@intCast(SBI_SHUTDOWN), 0, 0, REG_A7, 0b0010011);
+    words[input.len + 1] = INST_ECALL;
+    var bytes: [4 * (MAX_WORDS + 2)]u8 = undefined;
+    for (words[0 .. input.len + 2], 0..) |word, index| {
+        std.mem.writeInt(u32, bytes[4 * index ..][0..4], word, .little);
+    }
+    vm.write_memory(CODE_BASE, bytes[0 .. 4 * (input.len + 2)]) catch unreachable;
+
+    vm.regs.pc = CODE_BASE;
+    vm.regs.set(REG_DATA, DATA_BASE);
+    for (input.args, 0..) |arg, index| vm.regs.set(@intCast(10 + index), arg);
+    vm.start();
+}
+
+/// Same registers, CSRs, error, and contents of every page either engine dirtied.
+fn engines_agree(interp: *VM, jit: *VM) bool {
+    if (!std.meta.eql(interp.regs, jit.regs)) return false;
+    if (!std.meta.eql(interp.csrs, jit.csrs)) return false;
+    if (!std.meta.eql(interp.last_error, jit.last_error)) return false;
+    if (interp.satp != jit.satp) return false;
+
+    for ([_]*VM{ interp, jit }) |vm| {
+        var pages = vm.dirty_pages.iterator(.{});
+        while (pages.next()) |page| {
+            const start = page * PAGE_SIZE;
+            if (!std.mem.eql(u8, interp.memory[start..][0..PAGE_SIZE], jit.memory[start..][0..PAGE_SIZE])) return false;
+        }
+    }
+    return true;
+}
+
+/// Kernel syscalls from either engine: call the worker's kernel, record the outcome.
+fn syscall_handler(syscall_num: u32, arg1: u64, arg2: u64, arg3: u64, arg4: u64) u64 {
+    const worker = active_worker orelse @panic("fuzz_farm syscall outside a worker");
+    const result = basin_kernel.SyscallResult.to_word(worker.kernel.handle_syscall(syscall_num, arg1, arg2, arg3, arg4));
+    if (worker.tracing) {
+        worker.trace.syscall(syscall_num, if (result >> 63 == 1) result else 0);
+    }
+    return result;
+}
+
+/// Panics (assertions, checked arithmetic, divergence) save the in-flight input first.
+pub const panic = std.debug.FullPanic(farm_panic);
+
+/// Crash file path (set in farm mode only; replays must not overwrite it).
+var crash_path: ?[]const u8 = null;
+var crash_saved = std.atomic.Value(bool).init(false);
+
+fn farm_panic(msg: []const u8, first_trace_addr: ?usize) noreturn {
+    if (crash_path) |path| {
+        if (active_worker) |worker| {
+            if (!crash_saved.swap(true, .acq_rel)) {
+                var buffer: [Input.FILE_MAX]u8 = undefined;
+                std.fs.cwd().writeFile(.{ .sub_path = path, .data = worker.current.encode(&buffer) }) catch {};
+                std.debug.print("[fuzz_farm] worker {d} crashed (seed {?d}): {s}; input saved to {s}\n", .{
+                    worker.id, worker.current_seed, msg, path,
+                });
+            }
+        }
+    }
+    std.debug.defaultPanic(msg, first_trace_addr);
+}
+
+pub fn main() !void {
+    var gpa = std.heap.GeneralPurposeAllocator(.{ .thread_safe = true }){};
+    defer _ = gpa.deinit();
+    const allocator = gpa.allocator();
+
+    const args = try std.process.argsAlloc(allocator);
+    defer std.process.argsFree(allocator, args);
+    const options = parse_options(args[1..]) catch |err| {
+        std.debug.print("[fuzz_farm] usage: fuzz_farm [--seeds N] [--start S] [--workers W] [--corpus DIR] [--crashes DIR] | --replay FILE | --minimize FILE\n", .{});
+        return err;
+    };
+
+    switch (options.mode) {
+        .supervise => try supervise(allocator, options, args[1..]),
+        .farm => try run_farm(allocator, options),
+        .replay => try replay(allocator, options.input_path.?),
+        .minimize => try minimize(allocator, options.input_path.?, options.crash_dir),
+    }
+}
+
+fn parse_options(args: []const [:0]u8) !Options {
+    var options = Options{};
+    var index: usize = 0;
+    while (index < args.len) : (index += 1) {
+        const arg = args[index];
+        if (std.mem.eql(u8, arg, "--child")) {
+            options.mode = .farm;
+            continue;
+        }
+        if (index + 1 == args.len) return error.InvalidArguments;
+        const value = args[index + 1];
+        index += 1;
+        if (std.mem.eql(u8, arg, "--seeds")) {
+            options.seeds = try std.fmt.parseInt(u64, value, 0);
+        } else if (std.mem.eql(u8, arg, "--start")) {
+            options.start = try std.fmt.parseInt(u64, value, 0);
+        } else if (std.mem.eql(u8, arg, "--workers")) {
+            options.workers = try std.fmt.parseInt(u32, value, 0);
+        } else if (std.mem.eql(u8, arg, "--corpus")) {
+            options.corpus_dir = value;
+        } else if (std.mem.eql(u8, arg, "--crashes")) {
+            options.crash_dir = value;
+        } else if (std.mem.eql(u8, arg, "--replay")) {
+            options.mode = .replay;
+            options.input_path = value;
+        } else if (std.mem.eql(u8, arg, "--minimize")) {
+            options.mode = .minimize;
+            options.input_path = value;
+        } else {
+            return error.InvalidArguments;
+        }
+    }
+    if (options.start > std.math.maxInt(u64) - options.seeds) return error.InvalidArguments;
+    return options;
+}
+
+/// Run the farm in a child process; if it crashed, minimize the saved input.
+fn supervise(allocator: std.mem.Allocator, options: Options, args: []const [:0]u8) !void {
+    try std.fs.cwd().makePath(options.crash_dir);
+    const last_crash = try std.fs.path.join(allocator, &.{ options.crash_dir, LAST_CRASH_NAME });
+    defer allocator.free(last_crash);
+    std.fs.cwd().deleteFile(last_crash) catch |err| switch (err) {
+        error.FileNotFound => {},
+        else => return err,
+    };
+
+    const self_exe = try std.fs.selfExePathAlloc(allocator);
+    defer allocator.free(self_exe);
+    var argv = std.ArrayListUnmanaged([]const u8){};
+    defer argv.deinit(allocator);
+    try argv.append(allocator, self_exe);
+    try argv.append(allocator, "--child");
+    for (args) |arg| try argv.append(allocator, arg);
+
+    var child = std.process.Child.init(argv.items, allocator);
+    const term = try child.spawnAndWait();
+
+    std.fs.cwd().access(last_crash, .{}) catch {
+        switch (term) {
+            .Exited => |code| if (code == 0) return,
+            else => {},
+        }
+        std.debug.print("[fuzz_farm] farm died without saving an input ({any})\n", .{term});
+        std.process.exit(1);
+    };
+    try minimize(allocator, last_crash, options.crash_dir);
+    std.process.exit(1);
+}
+
+fn run_farm(allocator: std.mem.Allocator, options: Options) !void {
+    const cpus: u32 = @intCast(std.Thread.getCpuCount() catch 1);
+    const worker_count: usize = if (options.workers > 0) options.workers else cpus;
+
+    try std.fs.cwd().makePath(options.crash_dir);
+    const last_crash = try std.fs.path.join(allocator, &.{ options.crash_dir, LAST_CRASH_NAME });
+    defer allocator.free(last_crash);
+    crash_path = last_crash;
+
+    const kernel_template = try allocator.create(BasinKernel);
+    defer allocator.destroy(kernel_template);
+    kernel_template.* = BasinKernel.init();
+
+    // Shards: contiguous, near-equal slices of [start, start + seeds).
+    const shards = try allocator.alloc(Shard, worker_count);
+    defer allocator.free(shards);
+    for (shards, 0..) |*shard, index| {
+        shard.* = .{
+            .next = options.start + options.seeds * @as(u64, index) / @as(u64, worker_count),
+            .end = options.start + options.seeds * @as(u64, index + 1) / @as(u64, worker_count),
+        };
+    }
+
+    var farm = Farm{ .shards = shards };
+    defer farm.corpus.deinit(allocator);
+    if (options.corpus_dir) |path| farm.corpus_storage = try std.fs.cwd().makeOpenPath(path, .{ .iterate = true });
+    defer if (farm.corpus_storage) |*dir| dir.close();
+
+    const workers = try allocator.alloc(*Worker, worker_count);
+    defer allocator.free(workers);
+    var created: usize = 0;
+    defer for (workers[0..created]) |worker| worker.destroy();
+    while (created < worker_count) : (created += 1) {
+        workers[created] = try Worker.create(allocator, created, &farm, kernel_template);
+    }
+
+    // Seed coverage with the on-disk corpus (worker 0, before any thread starts).
+    if (farm.corpus_storage) |dir| {
+        active_worker = workers[0];
+        defer active_worker = null;
+        var loaded: usize = 0;
+        var entries = dir.iterate();
+        while (try entries.next()) |entry| {
+            if (entry.kind != .file or !std.mem.endsWith(u8, entry.name, ".bin")) continue;
+            var buffer: [Input.FILE_MAX]u8 = undefined;
+            const bytes = dir.readFile(entry.name, &buffer) catch continue;
+            const input = Input.decode(bytes) catch continue;
+            workers[0].execute(&input);
+            _ = farm.coverage.merge(&workers[0].trace);
+            if (farm.corpus.items.len < CORPUS_MAX) try farm.corpus.append(allocator, input);
+            loaded += 1;
+        }
+        std.debug.print("[fuzz_farm] loaded {d} corpus entries ({d} coverage bits)\n", .{ loaded, farm.coverage.count() });
+    }
+
+    std.debug.print("[fuzz_farm] {d} seeds from {d} on {d} workers ({d} CPUs)\n", .{ options.seeds, options.start, worker_count, cpus });
+    var timer = try std.time.Timer.start();
+    const threads = try allocator.alloc(std.Thread, worker_count);
+    defer allocator.free(threads);
+    for (threads, workers) |*thread, worker| {
+        thread.* = try std.Thread.spawn(.{}, Worker.work, .{worker});
+    }
+
+    var next_report: u64 = PROGRESS_INTERVAL_NS;
+    while (farm.finished.load(.acquire) < worker_count) {
+        std.Thread.sleep(50 * std.time.ns_per_ms);
+        if (timer.read() >= next_report) {
+            next_report += PROGRESS_INTERVAL_NS;
+            report(&farm, timer.read());
+        }
+    }
+    for (threads) |thread| thread.join();
+
+    const elapsed = timer.read();
+    report(&farm, elapsed);
+    for (workers) |worker| {
+        std.debug.print("[fuzz_farm] worker {d}: {d} execs\n", .{ worker.id, worker.execs });
+    }
+    // Assert: every seed ran exactly once.
+    std.debug.assert(farm.execs.load(.monotonic) == options.seeds);
+}
+
+fn report(farm: *Farm, elapsed_ns: u64) void {
+    const execs = farm.execs.load(.monotonic);
+    farm.corpus_lock.lock();
+    const corpus = farm.corpus.items.len;
+    farm.corpus_lock.unlock();
+    const seconds = @as(f64, @floatFromInt(@max(elapsed_ns, 1))) / std.time.ns_per_s;
+    std.debug.print("[fuzz_farm] {d} execs in {d:.1}s ({d:.0}/s), coverage {d} bits, corpus {d}\n", .{
+        execs, seconds, @as(f64, @floatFromInt(execs)) / seconds, farm.coverage.count(), corpus,
+    });
+}
+
+fn read_input(path: []const u8) !Input {
+    var buffer: [Input.FILE_MAX]u8 = undefined;
+    const bytes = try std.fs.cwd().readFile(path, &buffer);
+    return Input.decode(bytes);
+}
+
+/// Run one input on both engines (a crash aborts the process).
+fn replay(allocator: std.mem.Allocator, path: []const u8) !void {
+    const input = try read_input(path);
+    const kernel_template = try allocator.create(BasinKernel);
+    defer allocator.destroy(kernel_template);
+    kernel_template.* = BasinKernel.init();
+
+    const worker = try Worker.create(allocator, 0, null, kernel_template);
+    defer worker.destroy();
+    active_worker = worker;
+    defer active_worker = null;
+    worker.execute(&input);
+    std.debug.print("[fuzz_farm] {s}: {d} words, no crash\n", .{ path, input.len });
+}
+
+/// Shrink a crashing input: drop word chunks (halving sizes), then zero arguments.
+/// Note: Any crash counts, so the result may crash differently than the original.
+fn minimize(allocator: std.mem.Allocator, path: []const u8, crash_dir: []const u8) !void {
+    var best = try read_input(path);
+    const self_exe = try std.fs.selfExePathAlloc(allocator);
+    defer allocator.free(self_exe);
+    try std.fs.cwd().makePath(crash_dir);
+    const scratch = try std.fs.path.join(allocator, &.{ crash_dir, "minimize-candidate.bin" });
+    defer allocator.free(scratch);
+    defer std.fs.cwd().deleteFile(scratch) catch {};
+
+    if (!try still_crashes(allocator, self_exe, scratch, &best)) {
+        std.debug.print("[fuzz_farm] {s} does not crash on replay (nothing to minimize)\n", .{path});
+        return;
+    }
+    const original_len = best.len;
+    const replayer = Replayer{ .allocator = allocator, .self_exe = self_exe, .scratch = scratch };
+    const shrunk = try shrink(best, replayer);
+    best = shrunk.input;
+    const attempts = shrunk.attempts;
+
+    var name_buffer: [48]u8 = undefined;
+    const name = try std.fmt.bufPrint(&name_buffer, "crash-{x:0>16}.bin", .{best.hash()});
+    const output = try std.fs.path.join(allocator, &.{ crash_dir, name });
+    defer allocator.free(output);
+    var buffer: [Input.FILE_MAX]u8 = undefined;
+    try std.fs.cwd().writeFile(.{ .sub_path = output, .data = best.encode(&buffer) });
+    std.debug.print("[fuzz_farm] minimized {d} -> {d} words in {d} replays: {s} (fuzz_farm --replay {s})\n", .{
+        original_len, best.len, attempts, output, output,
+    });
+}
+
+/// Smallest input found that still crashes, and the replays it took.
+const Shrunk = struct { input: Input, attempts: u32 };
+
+/// Drop word chunks (halving the chunk size down to 1 word), then zero arguments, keeping
+/// every candidate for which `oracle.crashes(&candidate)` holds.
+/// Contract: input crashes; at most MINIMIZE_ATTEMPTS candidates are tried.
+fn shrink(input: Input, oracle: anytype) !Shrunk {
+    var best = input;
+    var attempts: u32 = 0;
+    var chunk: u32 = best.len / 2;
+    while (chunk >= 1 and attempts < MINIMIZE_ATTEMPTS) : (chunk /= 2) {
+        var start: u32 = 0;
+        while (start + chunk <= best.len and attempts < MINIMIZE_ATTEMPTS) {
+            var candidate = best;
+            candidate.remove(start, chunk);
+            attempts += 1;
+            if (try oracle.crashes(&candidate)) {
+                best = candidate;
+            } else {
+                start += chunk;
+            }
+        }
+    }
+    for (0..ARG_REGS) |index| {
+        if (best.args[index] == 0 or attempts >= MINIMIZE_ATTEMPTS) continue;
+        var candidate = best;
+        candidate.args[index] = 0;
+        attempts += 1;
+        if (try oracle.crashes(&candidate)) best = candidate;
+    }
+    std.debug.assert(attempts <= MINIMIZE_ATTEMPTS);
+    return .{ .input = best, .attempts = attempts };
+}
+
+/// Crash oracle for minimize: replays each candidate in a child process.
+const Replayer = struct {
+    allocator: std.mem.Allocator,
+    self_exe: []const u8,
+    scratch: []const u8,
+
+    fn crashes(self: Replayer, input: *const Input) !bool {
+        return still_crashes(self.allocator, self.self_exe, self.scratch, input);
+    }
+};
+
+fn still_crashes(allocator: std.mem.Allocator, self_exe: []const u8, scratch: []const u8, input: *const Input) !bool {
+    var buffer: [Input.FILE_MAX]u8 = undefined;
+    try std.fs.cwd().writeFile(.{ .sub_path = scratch, .data = input.encode(&buffer) });
+    var child = std.process.Child.init(&.{ self_exe, "--replay", scratch }, allocator);
+    child.stdin_behavior = .Ignore;
+    child.stdout_behavior = .Ignore;
+    child.stderr_behavior = .Ignore;
+    return switch (try child.spawnAndWait()) {
+        .Exited => |code| code != 0,
+        else => true,
+    };
+}
+
+test "fuzz_farm: shrink keeps only what the crash needs" {
+    // Deterministic oracle: crashes iff the needle word is present and a2 is 7.
+    const needle: u32 = comptime rv_i(0x7FF, 0, 0b111, 31, 0b0010011); // andi x31, x0, 2047
+    const Needle = struct {
+        replays: u32 = 0,
+
+        fn crashes(self: *@This(), input: *const Input) !bool {
+            self.replays += 1;
+            return std.mem.indexOfScalar(u32, input.code(), needle) != null and input.args[2] == 7;
+        }
+    };
+
+    var rng = Rng{ .state = 1 };
+    var input: Input = undefined;
+    generate(&rng, &input);
+    if (input.len == MAX_WORDS) input.remove(0, 1);
+    input.insert(input.len / 2, &.{needle});
+    input.args = .{ 1, 2, 7, 4, 5, 6 };
+    try std.testing.expect(input.len > 2);
+
+    var oracle = Needle{};
+    const shrunk = try shrink(input, &oracle);
+    try std.testing.expectEqualSlices(u32, &.{needle}, shrunk.input.code());
+    try std.testing.expectEqualSlices(u64, &.{ 0, 0, 7, 0, 0, 0 }, &shrunk.input.args);
+    try std.testing.expectEqual(oracle.replays, shrunk.attempts);
+}
+
+test "fuzz_farm: oracle accepts agreeing engines and flags a divergence" {
+    const allocator = std.testing.allocator;
+    const kernel_template = try allocator.create(BasinKernel);
+    defer allocator.destroy(kernel_template);
+    kernel_template.* = BasinKernel.init();
+
+    const worker = try Worker.create(allocator, 0, null, kernel_template);
+    defer worker.destroy();
+    active_worker = worker;
+    defer active_worker = null;
+
+    // Generated cases run on both engines; execute panics if they disagree.
+    var seed: u64 = 1;
+    while (seed <= 16) : (seed += 1) {
+        var rng = Rng{ .state = seed };
+        var input: Input = undefined;
+        generate(&rng, &input);
+        worker.execute(&input);
+        try std.testing.expect(engines_agree(worker.interp, worker.jit));
+    }
+
+    // One differing register is a divergence.
+    const a0 = worker.jit.regs.get(10);
+    worker.jit.regs.set(10, a0 +% 1);
+    try std.testing.expect(!engines_agree(worker.interp, worker.jit));
+    worker.jit.regs.set(10, a0);
+    try std.testing.expect(engines_agree(worker.interp, worker.jit));
+}